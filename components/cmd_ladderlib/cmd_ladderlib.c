@@ -28,6 +28,7 @@
  */
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_console.h"
@@ -37,9 +38,22 @@
 #include "hal_fs.h"
 
 #include "ladder.h"
+#include "ladder_adc.h"
+#include "ladder_aout.h"
+#include "ladder_boot.h"
+#include "ladder_datalogger.h"
+#include "ladder_hsc.h"
+#include "ladder_io_modules.h"
 #include "ladder_program_check.h"
 #include "ladder_program_json.h"
+#include "ladder_program_store.h"
+#include "ladder_registers.h"
+#include "ladder_retentive.h"
+#include "ladder_warm.h"
 #include "ladderlib_esp32_gpio.h"
+#include "modbus_master.h"
+#include "modbus_server.h"
+#include "mqtt_publisher.h"
 
 // registers quantity
 #define QTY_M 8
@@ -236,6 +250,286 @@ static int port_test(int argc, char **argv) {
     return 0;
 }
 
+static int datalogger(int argc, char **argv) {
+    ladder_datalogger_stats_t stats;
+
+    if (argc < 2) {
+        printf(">> Error: start [file], stop or status\n");
+        return 1;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        if (!ladder_datalogger_load(&ladder_ctx, argc > 2 ? argv[2] : LADDER_DATALOGGER_CONFIG)) {
+            printf(">> Error: invalid configuration\n");
+            return 1;
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        ladder_datalogger_stop();
+    } else if (strcmp(argv[1], "status") == 0) {
+        ladder_datalogger_stats(&stats);
+        printf("%s, samples: %" PRIu32 ", dropped: %" PRIu32 ", chunks: %" PRIu32 ", raw: %" PRIu64 " bytes, written: %" PRIu64 " bytes\n",
+               stats.running ? "running" : "stopped", stats.samples, stats.dropped, stats.chunks, stats.raw_bytes, stats.written);
+    } else {
+        printf(">> Error: start [file], stop or status\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int retentive(int argc, char **argv) {
+    ladder_retentive_stats_t stats;
+
+    if (argc < 2) {
+        printf(">> Error: flush or status\n");
+        return 1;
+    }
+
+    if (strcmp(argv[1], "flush") == 0) {
+        ladder_retentive_flush(&ladder_ctx);
+    } else if (strcmp(argv[1], "status") == 0) {
+        ladder_retentive_stats(&stats);
+        printf("ranges: %" PRIu32 ", size: %" PRIu32 " bytes, restored: %s, changes: %" PRIu32 ", flushes: %" PRIu32 ", errors: %" PRIu32
+               " (%" PRIu32 " in a row), written: %" PRIu64 " bytes\n",
+               stats.ranges, stats.size, stats.restored, stats.changes, stats.flushes, stats.errors, stats.failing, stats.written);
+        // wear estimate at the rate seen since boot
+        if (stats.uptime_s > 0)
+            printf("per day: %" PRIu64 " flushes, %" PRIu64 " bytes\n", (uint64_t)stats.flushes * 86400 / stats.uptime_s,
+                   stats.written * 86400 / stats.uptime_s);
+    } else {
+        printf(">> Error: flush or status\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int boot_times(int argc, char **argv) {
+    ladder_boot_phase_t phase[LADDER_BOOT_PHASES_MAX];
+    ladder_warm_stats_t warm;
+
+    uint32_t qty = ladder_boot_phases(phase, LADDER_BOOT_PHASES_MAX);
+    printf("phase            start ms   end ms  time ms\n");
+    for (uint32_t n = 0; n < qty; n++) {
+        if (phase[n].end_us == 0) {
+            printf("%-15s %9.1f      ...\n", phase[n].name, phase[n].start_us / 1000.0);
+            continue;
+        }
+        printf("%-15s %9.1f %8.1f %8.1f\n", phase[n].name, phase[n].start_us / 1000.0, phase[n].end_us / 1000.0,
+               (phase[n].end_us - phase[n].start_us) / 1000.0);
+    }
+
+    ladder_warm_stats(&warm);
+    printf("%s start", warm.resumed ? "warm" : "cold");
+    if (warm.boot_loop)
+        printf(" after %" PRIu32 " warm resumes in a row, ladder stopped", warm.attempts);
+    else if (warm.attempts != 0)
+        printf(", warm resume %" PRIu32 " of %d in a row", warm.attempts, LADDER_WARM_ATTEMPTS);
+    if (warm.first_write_us != 0)
+        printf(", first scan (outputs written) at %.1f ms", warm.first_write_us / 1000.0);
+    printf("\n");
+
+    return 0;
+}
+
+static int io_modules(int argc, char **argv) {
+    ladder_io_module_info_t info[LADDER_IO_MODULES_MAX];
+
+    uint32_t qty = ladder_io_modules_info(info, LADDER_IO_MODULES_MAX);
+    if (qty == 0) {
+        printf("No I/O modules\n");
+        return 0;
+    }
+
+    printf("module           I   Q  period   age ms  stale    polls   errors   faults  poll us   max us\n");
+    for (uint32_t n = 0; n < qty; n++) {
+        printf("%-15s %2" PRIu32 "  %2" PRIu32 " %7" PRIu32 " ", info[n].name, info[n].in_id, info[n].out_id, info[n].period_ms);
+        if (info[n].age_ms == UINT32_MAX)
+            printf("%8s", "-");
+        else
+            printf("%8" PRIu32, info[n].age_ms);
+        printf("  %5s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", info[n].stale ? "yes" : "no", info[n].polls, info[n].errors,
+               info[n].faults, info[n].poll_us, info[n].poll_max_us);
+    }
+
+    return 0;
+}
+
+static int modbus(int argc, char **argv) {
+    modbus_server_stats_t stats;
+    modbus_master_info_t info[MODBUS_MASTER_MODULES_MAX];
+
+    if (argc > 2 && strcmp(argv[1], "points") == 0) {
+        modbus_master_point_info_t points[MODBUS_MASTER_POINTS_MAX];
+        uint32_t qty = modbus_master_points_info(atoi(argv[2]), points, MODBUS_MASTER_POINTS_MAX);
+
+        printf("slave  fc   addr count  point  req   age ms  stale   errors  exception\n");
+        for (uint32_t n = 0; n < qty; n++) {
+            printf("%5u %3u %6u %5u  %-2s%3u %4u ", points[n].point.slave, points[n].point.function, points[n].point.addr, points[n].point.count,
+                   ladder_registers_type_name(points[n].point.type), points[n].point.index, points[n].request);
+            if (points[n].age_ms == UINT32_MAX)
+                printf("%8s", "-");
+            else
+                printf("%8" PRIu32, points[n].age_ms);
+            printf("  %5s %8" PRIu32 " %10u\n", points[n].stale ? "yes" : "no", points[n].errors, points[n].exception);
+        }
+        return 0;
+    }
+
+    modbus_server_stats(&stats);
+    printf("server clients: %" PRIu32 "\n", stats.clients);
+    printf("server requests: %" PRIu32 " (exceptions: %" PRIu32 ")\n", stats.requests, stats.exceptions);
+    printf("server batches: %" PRIu32 "\n", stats.batches);
+    printf("server scan job: %" PRIu32 " us (max: %" PRIu32 " us)\n", stats.job_us, stats.job_max_us);
+
+    uint32_t qty = modbus_master_info(info, MODBUS_MASTER_MODULES_MAX);
+    if (qty == 0)
+        return 0;
+
+    printf("\nmodule           I  requests  transactions  timeouts  exceptions  connects  cycle us   max us\n");
+    for (uint32_t n = 0; n < qty; n++)
+        printf("%-15s %2d %9" PRIu32 " %13" PRIu32 " %9" PRIu32 " %11" PRIu32 " %9" PRIu32 " %9" PRIu32 " %8" PRIu32 "\n", info[n].name, info[n].in_id,
+               info[n].requests, info[n].transactions, info[n].timeouts, info[n].exceptions, info[n].connects, info[n].cycle_us, info[n].cycle_max_us);
+
+    return 0;
+}
+
+static int mqtt(int argc, char **argv) {
+    mqtt_publisher_stats_t stats;
+
+    mqtt_publisher_stats(&stats);
+    printf("connected: %s\n", stats.connected ? "yes" : "no");
+    printf("snapshots: %" PRIu32 " (coalesced: %" PRIu32 ", dropped: %" PRIu32 ")\n", stats.snapshots, stats.coalesced, stats.dropped);
+    printf("published: %" PRIu32 " (failed: %" PRIu32 ")\n", stats.published, stats.failed);
+    printf("writes: %" PRIu32 " (errors: %" PRIu32 ")\n", stats.writes, stats.write_errors);
+    printf("scan hook: %" PRIu32 " us (max: %" PRIu32 " us)\n", stats.scan_us, stats.scan_max_us);
+
+    return 0;
+}
+
+static int hsc(int argc, char **argv) {
+    static const char *modes[] = {
+        "pcnt", //
+        "isr",  //
+        "sim",  //
+    };
+    ladder_hsc_info_t info[LADDER_HSC_MAX];
+
+    if (argc > 2 && strcmp(argv[1], "preset") == 0) {
+        ladder_hsc_preset(atoi(argv[2]));
+        return 0;
+    }
+
+    uint32_t qty = ladder_hsc_info(info, LADDER_HSC_MAX);
+    if (qty == 0) {
+        printf("No counters\n");
+        return 0;
+    }
+
+    printf("counter  mode   IW        count     freq    fires  output\n");
+    for (uint32_t n = 0; n < qty; n++)
+        printf("%7" PRIu32 "  %-5s %3" PRIu32 " %12" PRId32 " %8" PRId32 " %8" PRIu32 "  %s\n", n, modes[info[n].mode], LADDER_HSC_IW_FIRST + 2 * n,
+               info[n].count, info[n].freq, info[n].fires, info[n].latched ? "on" : "off");
+
+    return 0;
+}
+
+static int adc(int argc, char **argv) {
+    ladder_adc_stats_t stats;
+
+    ladder_adc_stats(&stats);
+    if (!stats.running) {
+        printf("Not sampling\n");
+        return 0;
+    }
+
+    printf("samples: %" PRIu32 "  frames: %" PRIu32 "  overruns: %" PRIu32 "  cycles/sample: %" PRIu32 "\n", stats.samples, stats.frames, stats.overruns,
+           stats.cycles_per_sample);
+    printf("IW         raw     value\n");
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS; n++)
+        printf("%2" PRIu32 " %11" PRId32 " %9" PRId32 "\n", n, stats.raw[n], stats.value[n]);
+
+    return 0;
+}
+
+static int aout(int argc, char **argv) {
+    static const char *modes[] = {
+        "none", //
+        "pwm",  //
+        "dac",  //
+        "mock", //
+    };
+    ladder_aout_info_t info[LADDER_AOUT_MAX];
+    ladder_aout_log_t log[LADDER_AOUT_LOG];
+
+    if (argc > 1 && strcmp(argv[1], "log") == 0) {
+        uint32_t qty = ladder_aout_log(log, LADDER_AOUT_LOG);
+        printf("      scan  QW        duty\n");
+        for (uint32_t n = 0; n < qty; n++)
+            printf("%10" PRIu32 " %3u %11" PRIu32 "\n", log[n].scan, log[n].qw, log[n].duty);
+        return 0;
+    }
+
+    uint32_t qty = ladder_aout_info(info, LADDER_AOUT_MAX);
+    printf("QW  mode  port          QW        duty   updates  last scan\n");
+    for (uint32_t n = 0; n < qty; n++) {
+        if (info[n].config.mode == LADDER_AOUT_NONE)
+            continue;
+        printf("%2" PRIu32 "  %-5s %4d %11" PRId32 " %11" PRIu32 " %9" PRIu32 " %10" PRIu32 "\n", n, modes[info[n].config.mode], info[n].config.output,
+               info[n].qw, info[n].duty, info[n].updates, info[n].scan_updates);
+    }
+
+    return 0;
+}
+
+static int program_store(int argc, char **argv) {
+    static const char *results[] = {
+        "OK",        //
+        "QUEUED",    //
+        "BUSY",      //
+        "NOT_FOUND", //
+        "INVALID",   //
+        "ERROR",     //
+    };
+    ladder_store_result_t result;
+
+    if (argc < 2) {
+        printf(">> Error: save, list, activate <version> or rollback\n");
+        return 1;
+    }
+
+    if (strcmp(argv[1], "save") == 0) {
+        uint32_t version = ladder_program_store_save(&ladder_ctx);
+        if (version == 0) {
+            printf(">> ERROR: No program or storage error\n");
+            return 1;
+        }
+        printf("Version %" PRIu32 "\n", version);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "list") == 0) {
+        char *list = ladder_program_store_list();
+        if (list == NULL)
+            return 1;
+        printf("%s\n", list);
+        free(list);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "activate") == 0 && argc > 2) {
+        result = ladder_program_store_activate(&ladder_ctx, strtoul(argv[2], NULL, 10));
+    } else if (strcmp(argv[1], "rollback") == 0) {
+        result = ladder_program_store_rollback(&ladder_ctx);
+    } else {
+        printf(">> Error: save, list, activate <version> or rollback\n");
+        return 1;
+    }
+
+    printf("%s\n", results[result]);
+    return result == LADDER_STORE_OK || result == LADDER_STORE_QUEUED ? 0 : 1;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void register_ladder_status(void) {
@@ -317,3 +611,103 @@ void register_port_test(void) {
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
 }
+
+void register_datalogger(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "datalogger",
+        .help = "Data logger (start [file], stop, status)",
+        .hint = NULL,
+        .func = &datalogger,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_program_store(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "store",
+        .help = "Program store (save, list, activate <version>, rollback)",
+        .hint = NULL,
+        .func = &program_store,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_retentive(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "retentive",
+        .help = "Retentive registers (flush, status)",
+        .hint = NULL,
+        .func = &retentive,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_boot_times(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "boot_times",
+        .help = "Boot phases timings",
+        .hint = NULL,
+        .func = &boot_times,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_io_modules(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "io",
+        .help = "I/O modules status",
+        .hint = NULL,
+        .func = &io_modules,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_modbus(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "modbus",
+        .help = "Modbus status (points <module>: remote module poll table)",
+        .hint = NULL,
+        .func = &modbus,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_mqtt(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "mqtt",
+        .help = "MQTT publisher status",
+        .hint = NULL,
+        .func = &mqtt,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_hsc(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "hsc",
+        .help = "High-speed counters (preset <counter>)",
+        .hint = NULL,
+        .func = &hsc,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_adc(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "adc",
+        .help = "Analog inputs sampling",
+        .hint = NULL,
+        .func = &adc,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+void register_aout(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "aout",
+        .help = "Analog outputs (log: last hardware updates)",
+        .hint = NULL,
+        .func = &aout,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
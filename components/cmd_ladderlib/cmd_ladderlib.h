@@ -39,5 +39,15 @@ void register_ladder_start(void);
 void register_ladder_stop(void);
 void register_ftpserver(void);
 void register_port_test(void);
+void register_datalogger(void);
+void register_program_store(void);
+void register_retentive(void);
+void register_boot_times(void);
+void register_io_modules(void);
+void register_modbus(void);
+void register_mqtt(void);
+void register_hsc(void);
+void register_adc(void);
+void register_aout(void);
 
 #endif /* CMD_LADDERLIB_H_ */
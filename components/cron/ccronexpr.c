@@ -109,23 +109,22 @@ time_t cron_mktime_gm(struct tm *tm) {
     /* https://www.nongnu.org/avr-libc/user-manual/group__avr__time.html */
     return mk_gmtime(tm);
 #elif defined(ESP8266) || defined(ESP_PLATFORM) || defined(TARGET_LIKE_MBED)
-    /* https://linux.die.net/man/3/timegm */
-    /* http://www.catb.org/esr/time-programming/ */
-    /* portable version of timegm() */
-    time_t ret;
-    char *tz;
-    tz = getenv("TZ");
-    if (tz)
-        tz = strdup(tz);
-    setenv("TZ", "UTC+0", 1);
-    tzset();
-    ret = mktime(tm);
-    if (tz) {
-        setenv("TZ", tz, 1);
-        free(tz);
-    } else
-        unsetenv("TZ");
-    tzset();
+    /* timegm() without touching TZ: days from civil (http://howardhinnant.github.io/date_algorithms.html),
+       gmtime_r() normalizes the fields as mktime() would */
+    int64_t year = tm->tm_year + 1900LL + tm->tm_mon / 12;
+    int mon = tm->tm_mon % 12;
+    if (mon < 0) {
+        mon += 12;
+        year--;
+    }
+    year -= mon < 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * ((mon + 10) % 12) + 2) / 5 + tm->tm_mday - 1;
+    int64_t days = era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+    time_t ret = days * 86400 + tm->tm_hour * 3600LL + tm->tm_min * 60LL + tm->tm_sec;
+    if (!gmtime_r(&ret, tm))
+        return CRON_INVALID_INSTANT;
     return ret;
 #elif defined(ANDROID)
     /* https://github.com/adobe/chromium/blob/cfe5bf0b51b1f6b9fe239c2a3c2f2364da9967d7/base/os_compat_android.cc#L20 */
@@ -199,29 +198,16 @@ struct tm *cron_time(time_t *date, struct tm *out) {
  * Functions.
  */
 
-void cron_set_bit(uint8_t *rbyte, int idx) {
-    uint8_t j = (uint8_t)(idx / 8);
-    uint8_t k = (uint8_t)(idx % 8);
-
-    rbyte[j] |= (1 << k);
+void cron_set_bit(uint64_t *bits, int idx) {
+    *bits |= (uint64_t)1 << idx;
 }
 
-void cron_del_bit(uint8_t *rbyte, int idx) {
-    uint8_t j = (uint8_t)(idx / 8);
-    uint8_t k = (uint8_t)(idx % 8);
-
-    rbyte[j] &= ~(1 << k);
+void cron_del_bit(uint64_t *bits, int idx) {
+    *bits &= ~((uint64_t)1 << idx);
 }
 
-uint8_t cron_get_bit(uint8_t *rbyte, int idx) {
-    uint8_t j = (uint8_t)(idx / 8);
-    uint8_t k = (uint8_t)(idx % 8);
-
-    if (rbyte[j] & (1 << k)) {
-        return 1;
-    } else {
-        return 0;
-    }
+uint8_t cron_get_bit(uint64_t *bits, int idx) {
+    return (*bits >> idx) & 1;
 }
 
 static void free_splitted(char **splitted, size_t len) {
@@ -247,18 +233,20 @@ static char *strdupl(const char *str, size_t len) {
     return res;
 }
 
-static unsigned int next_set_bit(uint8_t *bits, unsigned int max, unsigned int from_index, int *notfound) {
-    unsigned int i;
-    if (!bits) {
+/* lowest set bit in [from_index, max) */
+static unsigned int next_set_bit(uint64_t *bits, unsigned int max, unsigned int from_index, int *notfound) {
+    if (!bits || from_index >= max) {
         *notfound = 1;
         return 0;
     }
-    for (i = from_index; i < max; i++) {
-        if (cron_get_bit(bits, i))
-            return i;
+    uint64_t mask = *bits & (~(uint64_t)0 << from_index);
+    if (max < 64)
+        mask &= ((uint64_t)1 << max) - 1;
+    if (!mask) {
+        *notfound = 1;
+        return 0;
     }
-    *notfound = 1;
-    return 0;
+    return __builtin_ctzll(mask);
 }
 
 static void push_to_fields_arr(int *arr, int fi) {
@@ -407,7 +395,7 @@ static int set_field(struct tm *calendar, int field, int val) {
  * Search the bits provided for the next set bit after the value provided,
  * and reset the calendar.
  */
-static unsigned int find_next(uint8_t *bits, unsigned int max, unsigned int value, struct tm *calendar, unsigned int field, unsigned int nextField,
+static unsigned int find_next(uint64_t *bits, unsigned int max, unsigned int value, struct tm *calendar, unsigned int field, unsigned int nextField,
                               int *lower_orders, int *res_out) {
     int notfound = 0;
     int err = 0;
@@ -438,7 +426,7 @@ return_error:
     return 0;
 }
 
-static unsigned int find_next_day(struct tm *calendar, uint8_t *days_of_month, unsigned int day_of_month, uint8_t *days_of_week, unsigned int day_of_week,
+static unsigned int find_next_day(struct tm *calendar, uint64_t *days_of_month, unsigned int day_of_month, uint64_t *days_of_week, unsigned int day_of_week,
                                   int *resets, int *res_out) {
     int err;
     unsigned int count = 0;
@@ -488,7 +476,7 @@ static int do_next(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     second = calendar->tm_sec;
-    update_second = find_next(expr->seconds, CRON_MAX_SECONDS, second, calendar, CRON_CF_SECOND, CRON_CF_MINUTE, empty_list, &res);
+    update_second = find_next(&expr->seconds, CRON_MAX_SECONDS, second, calendar, CRON_CF_SECOND, CRON_CF_MINUTE, empty_list, &res);
     if (0 != res)
         goto return_result;
     if (second == update_second) {
@@ -496,7 +484,7 @@ static int do_next(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     minute = calendar->tm_min;
-    update_minute = find_next(expr->minutes, CRON_MAX_MINUTES, minute, calendar, CRON_CF_MINUTE, CRON_CF_HOUR_OF_DAY, resets, &res);
+    update_minute = find_next(&expr->minutes, CRON_MAX_MINUTES, minute, calendar, CRON_CF_MINUTE, CRON_CF_HOUR_OF_DAY, resets, &res);
     if (0 != res)
         goto return_result;
     if (minute == update_minute) {
@@ -508,7 +496,7 @@ static int do_next(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     hour = calendar->tm_hour;
-    update_hour = find_next(expr->hours, CRON_MAX_HOURS, hour, calendar, CRON_CF_HOUR_OF_DAY, CRON_CF_DAY_OF_WEEK, resets, &res);
+    update_hour = find_next(&expr->hours, CRON_MAX_HOURS, hour, calendar, CRON_CF_HOUR_OF_DAY, CRON_CF_DAY_OF_WEEK, resets, &res);
     if (0 != res)
         goto return_result;
     if (hour == update_hour) {
@@ -521,7 +509,7 @@ static int do_next(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
 
     day_of_week = calendar->tm_wday;
     day_of_month = calendar->tm_mday;
-    update_day_of_month = find_next_day(calendar, expr->days_of_month, day_of_month, expr->days_of_week, day_of_week, resets, &res);
+    update_day_of_month = find_next_day(calendar, &expr->days_of_month, day_of_month, &expr->days_of_week, day_of_week, resets, &res);
     if (0 != res)
         goto return_result;
     if (day_of_month == update_day_of_month) {
@@ -533,7 +521,7 @@ static int do_next(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     month = calendar->tm_mon; /*day already adds one if no day in same month is found*/
-    update_month = find_next(expr->months, CRON_MAX_MONTHS, month, calendar, CRON_CF_MONTH, CRON_CF_YEAR, resets, &res);
+    update_month = find_next(&expr->months, CRON_MAX_MONTHS, month, calendar, CRON_CF_MONTH, CRON_CF_YEAR, resets, &res);
     if (0 != res)
         goto return_result;
     if (month != update_month) {
@@ -831,7 +819,7 @@ return_error:
     return NULL;
 }
 
-static void set_number_hits(const char *value, uint8_t *target, unsigned int min, unsigned int max, const char **error) {
+static void set_number_hits(const char *value, uint64_t *target, unsigned int min, unsigned int max, const char **error) {
     size_t i;
     unsigned int i1;
     size_t len = 0;
@@ -906,7 +894,7 @@ return_result:
     free_splitted(fields, len);
 }
 
-static void set_months(char *value, uint8_t *targ, const char **error) {
+static void set_months(char *value, uint64_t *targ, const char **error) {
     unsigned int i;
     unsigned int max = 12;
 
@@ -930,7 +918,7 @@ static void set_months(char *value, uint8_t *targ, const char **error) {
     }
 }
 
-static void set_days_of_week(char *field, uint8_t *targ, const char **error) {
+static void set_days_of_week(char *field, uint64_t *targ, const char **error) {
     unsigned int max = 7;
     char *replaced = NULL;
 
@@ -952,7 +940,7 @@ static void set_days_of_week(char *field, uint8_t *targ, const char **error) {
     }
 }
 
-static void set_days_of_month(char *field, uint8_t *targ, const char **error) {
+static void set_days_of_month(char *field, uint64_t *targ, const char **error) {
     /* Days of month start with 1 (in Cron and Calendar) so add one */
     if (1 == strlen(field) && '?' == field[0]) {
         field[0] = '*';
@@ -983,22 +971,22 @@ void cron_parse_expr(const char *expression, cron_expr_t *target, const char **e
         goto return_res;
     }
     memset(target, 0, sizeof(*target));
-    set_number_hits(fields[0], target->seconds, 0, 60, error);
+    set_number_hits(fields[0], &target->seconds, 0, 60, error);
     if (*error)
         goto return_res;
-    set_number_hits(fields[1], target->minutes, 0, 60, error);
+    set_number_hits(fields[1], &target->minutes, 0, 60, error);
     if (*error)
         goto return_res;
-    set_number_hits(fields[2], target->hours, 0, 24, error);
+    set_number_hits(fields[2], &target->hours, 0, 24, error);
     if (*error)
         goto return_res;
-    set_days_of_month(fields[3], target->days_of_month, error);
+    set_days_of_month(fields[3], &target->days_of_month, error);
     if (*error)
         goto return_res;
-    set_months(fields[4], target->months, error);
+    set_months(fields[4], &target->months, error);
     if (*error)
         goto return_res;
-    set_days_of_week(fields[5], target->days_of_week, error);
+    set_days_of_week(fields[5], &target->days_of_week, error);
     if (*error)
         goto return_res;
 
@@ -1060,18 +1048,20 @@ time_t cron_next(cron_expr_t *expr, time_t date) {
 
 /* https://github.com/staticlibs/ccronexpr/pull/8 */
 
-static unsigned int prev_set_bit(uint8_t *bits, int from_index, int to_index, int *notfound) {
-    int i;
-    if (!bits) {
+/* highest set bit in [to_index, from_index] */
+static unsigned int prev_set_bit(uint64_t *bits, int from_index, int to_index, int *notfound) {
+    if (!bits || from_index < to_index || to_index < 0) {
         *notfound = 1;
         return 0;
     }
-    for (i = from_index; i >= to_index; i--) {
-        if (cron_get_bit(bits, i))
-            return i;
+    uint64_t mask = *bits & (~(uint64_t)0 << to_index);
+    if (from_index < 63)
+        mask &= ((uint64_t)2 << from_index) - 1;
+    if (!mask) {
+        *notfound = 1;
+        return 0;
     }
-    *notfound = 1;
-    return 0;
+    return 63 - __builtin_clzll(mask);
 }
 
 static int last_day_of_month(int month, int year) {
@@ -1148,7 +1138,7 @@ static int reset_all_max(struct tm *calendar, int *fields) {
  * Search the bits provided for the next set bit after the value provided,
  * and reset the calendar.
  */
-static unsigned int find_prev(uint8_t *bits, unsigned int max, unsigned int value, struct tm *calendar, unsigned int field, unsigned int nextField,
+static unsigned int find_prev(uint64_t *bits, unsigned int max, unsigned int value, struct tm *calendar, unsigned int field, unsigned int nextField,
                               int *lower_orders, int *res_out) {
     int notfound = 0;
     int err = 0;
@@ -1179,7 +1169,7 @@ return_error:
     return 0;
 }
 
-static unsigned int find_prev_day(struct tm *calendar, uint8_t *days_of_month, unsigned int day_of_month, uint8_t *days_of_week, unsigned int day_of_week,
+static unsigned int find_prev_day(struct tm *calendar, uint64_t *days_of_month, unsigned int day_of_month, uint64_t *days_of_week, unsigned int day_of_week,
                                   int *resets, int *res_out) {
     int err;
     unsigned int count = 0;
@@ -1229,7 +1219,7 @@ static int do_prev(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     second = calendar->tm_sec;
-    update_second = find_prev(expr->seconds, CRON_MAX_SECONDS, second, calendar, CRON_CF_SECOND, CRON_CF_MINUTE, empty_list, &res);
+    update_second = find_prev(&expr->seconds, CRON_MAX_SECONDS, second, calendar, CRON_CF_SECOND, CRON_CF_MINUTE, empty_list, &res);
     if (0 != res)
         goto return_result;
     if (second == update_second) {
@@ -1237,7 +1227,7 @@ static int do_prev(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     minute = calendar->tm_min;
-    update_minute = find_prev(expr->minutes, CRON_MAX_MINUTES, minute, calendar, CRON_CF_MINUTE, CRON_CF_HOUR_OF_DAY, resets, &res);
+    update_minute = find_prev(&expr->minutes, CRON_MAX_MINUTES, minute, calendar, CRON_CF_MINUTE, CRON_CF_HOUR_OF_DAY, resets, &res);
     if (0 != res)
         goto return_result;
     if (minute == update_minute) {
@@ -1249,7 +1239,7 @@ static int do_prev(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     hour = calendar->tm_hour;
-    update_hour = find_prev(expr->hours, CRON_MAX_HOURS, hour, calendar, CRON_CF_HOUR_OF_DAY, CRON_CF_DAY_OF_WEEK, resets, &res);
+    update_hour = find_prev(&expr->hours, CRON_MAX_HOURS, hour, calendar, CRON_CF_HOUR_OF_DAY, CRON_CF_DAY_OF_WEEK, resets, &res);
     if (0 != res)
         goto return_result;
     if (hour == update_hour) {
@@ -1262,7 +1252,7 @@ static int do_prev(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
 
     day_of_week = calendar->tm_wday;
     day_of_month = calendar->tm_mday;
-    update_day_of_month = find_prev_day(calendar, expr->days_of_month, day_of_month, expr->days_of_week, day_of_week, resets, &res);
+    update_day_of_month = find_prev_day(calendar, &expr->days_of_month, day_of_month, &expr->days_of_week, day_of_week, resets, &res);
     if (0 != res)
         goto return_result;
     if (day_of_month == update_day_of_month) {
@@ -1274,7 +1264,7 @@ static int do_prev(cron_expr_t *expr, struct tm *calendar, unsigned int dot) {
     }
 
     month = calendar->tm_mon; /*day already adds one if no day in same month is found*/
-    update_month = find_prev(expr->months, CRON_MAX_MONTHS, month, calendar, CRON_CF_MONTH, CRON_CF_YEAR, resets, &res);
+    update_month = find_prev(&expr->months, CRON_MAX_MONTHS, month, calendar, CRON_CF_MONTH, CRON_CF_YEAR, resets, &res);
     if (0 != res)
         goto return_result;
     if (month != update_month) {
@@ -31,12 +31,12 @@
  * Parsed cron expression
  */
 typedef struct cron_expr_s {
-    uint8_t seconds[8];
-    uint8_t minutes[8];
-    uint8_t hours[3];
-    uint8_t days_of_week[1];
-    uint8_t days_of_month[4];
-    uint8_t months[2];
+    uint64_t seconds;       /* bits 0..59 */
+    uint64_t minutes;       /* bits 0..59 */
+    uint64_t hours;         /* bits 0..23 */
+    uint64_t days_of_week;  /* bits 0..6, sunday is 0 */
+    uint64_t days_of_month; /* bits 1..31 */
+    uint64_t months;        /* bits 0..11 */
 } cron_expr_t;
 
 /**
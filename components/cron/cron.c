@@ -27,79 +27,297 @@
  *
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
 
 #include "ccronexpr.h"
-#include "ll.h"
 
 #include "cron.h"
 
 static const char *TAG = "cron";
 
-#define CRON_TIMER_MS  500
-#define CRON_QUEUE_LEN 5
+#define CRON_REARM_MAX_MS 60000 // longest wait, the clock may be set (SNTP) meanwhile
+#define CRON_HEAP_INIT    16    // initial heap and pass capacity, doubled when full
+
+#ifndef CRON_NEXT_CACHE
+#define CRON_NEXT_CACHE 4 // fire times computed ahead per job, 0: none
+#endif
 
 typedef struct cron_s {
     uint32_t id;
     cron_expr_t expr;
     time_t next;
     bool enabled;
-    void *fn_ptr;
+    cron_fn_t fn;
+    cron_batch_fn_t batch_fn;
     uint32_t fn_value;
+    uint32_t heap_index;
+#if CRON_NEXT_CACHE > 0
+    time_t ahead[CRON_NEXT_CACHE]; // consecutive fire times after ahead_base
+    time_t ahead_base;
+    uint8_t ahead_qty;
+#endif
 } cron_t;
 
+typedef struct cron_msg_s {
+    cron_fn_t fn;             // single job
+    cron_batch_fn_t batch_fn; // or batched job
+    uint32_t value;           //
+} cron_msg_t;
+
+// jobs fired by the timer passes and not executed yet, sized on demand: any number of jobs may be due at once
+typedef struct cron_pass_s {
+    cron_msg_t *msg;  //
+    uint32_t *values; // batch function values, same size
+    uint32_t qty;     //
+    uint32_t size;    //
+} cron_pass_t;
+
 static int8_t cron_tz = 0;
 static uint32_t next_id;
-static cron_t *_list_cron;
+static cron_t **cron_heap = NULL; // min-heap on next, disabled jobs sink to the bottom
+static uint32_t cron_qty = 0;
+static uint32_t cron_size = 0;
+static uint32_t cron_late_max = 0; // seconds
+static uint32_t cron_dropped = 0; // jobs lost, out of memory
+static SemaphoreHandle_t cron_mutex;
+static SemaphoreHandle_t cron_pass; // given by the timer once a pass has queued all its jobs
+static cron_pass_t cron_due;        // filled by the timer, with cron_mutex
+static cron_pass_t cron_run;        // owned by the execute task
 static TimerHandle_t cron_timer_hndl;
-static QueueHandle_t cron_queue;
 static TaskHandle_t cron_task_hndl;
 
+static int64_t cron_now_ms(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return ((int64_t)tv.tv_sec + 3600 * cron_tz) * 1000 + tv.tv_usec / 1000;
+}
+
+static time_t cron_job_next(cron_t *job, time_t now) {
+#if CRON_NEXT_CACHE > 0
+    // valid while the clock doesn't go back past the time the cache was filled at
+    if (job->ahead_qty > 0 && now >= job->ahead_base) {
+        uint8_t past = 0;
+        while (past < job->ahead_qty && job->ahead[past] <= now)
+            past++;
+        if (past < job->ahead_qty) {
+            job->ahead_qty -= past;
+            memmove(job->ahead, &job->ahead[past], job->ahead_qty * sizeof(time_t));
+            return job->ahead[0];
+        }
+    }
+
+    time_t next = now;
+    job->ahead_base = now;
+    for (job->ahead_qty = 0; job->ahead_qty < CRON_NEXT_CACHE; job->ahead_qty++) {
+        if ((next = cron_next(&job->expr, next)) == (time_t)-1)
+            break;
+        job->ahead[job->ahead_qty] = next;
+    }
+
+    return job->ahead_qty > 0 ? job->ahead[0] : (time_t)-1;
+#else
+    return cron_next(&job->expr, now);
+#endif
+}
+
+static bool cron_idle(const cron_t *job) {
+    return !job->enabled || job->next == (time_t)-1;
+}
+
+static bool cron_before(const cron_t *a, const cron_t *b) {
+    if (cron_idle(a))
+        return false;
+    if (cron_idle(b))
+        return true;
+
+    return a->next < b->next;
+}
+
+static void heap_set(uint32_t i, cron_t *job) {
+    cron_heap[i] = job;
+    job->heap_index = i;
+}
+
+static void heap_up(uint32_t i) {
+    cron_t *job = cron_heap[i];
+
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!cron_before(job, cron_heap[parent]))
+            break;
+        heap_set(i, cron_heap[parent]);
+        i = parent;
+    }
+    heap_set(i, job);
+}
+
+static void heap_down(uint32_t i) {
+    cron_t *job = cron_heap[i];
+
+    while (2 * i + 1 < cron_qty) {
+        uint32_t child = 2 * i + 1;
+        if (child + 1 < cron_qty && cron_before(cron_heap[child + 1], cron_heap[child]))
+            child++;
+        if (!cron_before(cron_heap[child], job))
+            break;
+        heap_set(i, cron_heap[child]);
+        i = child;
+    }
+    heap_set(i, job);
+}
+
+static void heap_fix(cron_t *job) {
+    heap_up(job->heap_index);
+    heap_down(job->heap_index);
+}
+
+static cron_t *heap_find(uint32_t id) {
+    for (uint32_t i = 0; i < cron_qty; i++)
+        if (cron_heap[i]->id == id)
+            return cron_heap[i];
+
+    return NULL;
+}
+
+// one shot timer to the earliest deadline, with cron_mutex
+static void cron_rearm(TickType_t wait) {
+    int64_t ms = CRON_REARM_MAX_MS;
+
+    if (cron_qty > 0 && !cron_idle(cron_heap[0])) {
+        ms = (int64_t)cron_heap[0]->next * 1000 - cron_now_ms();
+        if (ms > CRON_REARM_MAX_MS)
+            ms = CRON_REARM_MAX_MS;
+    }
+
+    TickType_t ticks = ms > 0 ? pdMS_TO_TICKS(ms) : 0;
+    xTimerChangePeriod(cron_timer_hndl, ticks > 0 ? ticks : 1, wait);
+}
+
+static bool cron_due_add(const cron_msg_t *msg) {
+    if (cron_due.qty == cron_due.size) {
+        uint32_t size = cron_due.size > 0 ? cron_due.size * 2 : CRON_HEAP_INIT;
+        cron_msg_t *msgs = realloc(cron_due.msg, size * sizeof(cron_msg_t));
+        if (msgs == NULL)
+            return false;
+        cron_due.msg = msgs;
+        uint32_t *values = realloc(cron_due.values, size * sizeof(uint32_t));
+        if (values == NULL)
+            return false;
+        cron_due.values = values;
+        cron_due.size = size;
+    }
+
+    cron_due.msg[cron_due.qty++] = *msg;
+    return true;
+}
+
+static void cron_pass_free(cron_pass_t *pass) {
+    free(pass->msg);
+    free(pass->values);
+    memset(pass, 0, sizeof(cron_pass_t));
+}
+
 static void cron_execute_task(void *pvParameters) {
-    void (*cron_fn)(uint32_t value);
-    uint32_t value;
+    cron_pass_t pass;
+
     while (1) {
-        if (cron_queue) {
-            if (xQueueReceive(cron_queue, &cron_fn, (TickType_t)portMAX_DELAY)) {
-                if (xQueueReceive(cron_queue, &value, (TickType_t)portMAX_DELAY)) {
-                    cron_fn(value);
+        // woken after the timer pass, not by the first message: this task has the higher priority and would
+        // otherwise run each job as soon as it is queued, splitting the batches
+        if (xSemaphoreTake(cron_pass, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        // everything fired since the last wake is handled together, the buffers are swapped, not copied
+        xSemaphoreTake(cron_mutex, portMAX_DELAY);
+        pass = cron_run;
+        cron_run = cron_due;
+        cron_due = pass;
+        cron_due.qty = 0;
+        xSemaphoreGive(cron_mutex);
+
+        cron_msg_t *msg = cron_run.msg;
+        uint32_t qty = cron_run.qty;
+        for (uint32_t n = 0; n < qty; n++) {
+            if (msg[n].fn != NULL) {
+                msg[n].fn(msg[n].value);
+                continue;
+            }
+
+            if (msg[n].batch_fn == NULL)
+                continue;
+
+            // one call for all values of the same batch function
+            uint32_t values_qty = 0;
+            cron_batch_fn_t batch_fn = msg[n].batch_fn;
+            for (uint32_t m = n; m < qty; m++) {
+                if (msg[m].fn == NULL && msg[m].batch_fn == batch_fn) {
+                    cron_run.values[values_qty++] = msg[m].value;
+                    msg[m].batch_fn = NULL;
                 }
             }
+            batch_fn(cron_run.values, values_qty);
         }
+        cron_run.qty = 0;
     }
 }
 
 static void cron_timer(TimerHandle_t xTimer) {
-    time_t now = 0;
-
-    time(&now);
-    now += 3600 * cron_tz;
-
-    ll_foreach(_list_cron, item) {
-        if (item != NULL && item->enabled) {
-            if (difftime(item->next, now) <= 0) {
-                item->next = cron_next(&item->expr, now);
-                xQueueSend(cron_queue, &(item->fn_ptr), (TickType_t)10);
-                xQueueSend(cron_queue, &(item->fn_value), (TickType_t)10);
-                break;
-            }
+    time_t now = cron_now_ms() / 1000;
+    bool queued = false;
+
+    xSemaphoreTake(cron_mutex, portMAX_DELAY);
+
+    // every job due now fires in this pass
+    while (cron_qty > 0 && !cron_idle(cron_heap[0]) && cron_heap[0]->next <= now) {
+        cron_t *job = cron_heap[0];
+
+        if (now - job->next > cron_late_max)
+            cron_late_max = now - job->next;
+
+        cron_msg_t msg = {
+            .fn = job->fn,             //
+            .batch_fn = job->batch_fn, //
+            .value = job->fn_value,    //
+        };
+        if (cron_due_add(&msg)) {
+            queued = true;
+        } else {
+            cron_dropped++;
+            ESP_LOGW(TAG, "out of memory, id=%u skipped", (unsigned)job->id);
         }
+
+        job->next = cron_job_next(job, now);
+        heap_down(0);
     }
+
+    // no blocking on the timer queue from its own task
+    cron_rearm(0);
+    xSemaphoreGive(cron_mutex);
+
+    if (queued)
+        xSemaphoreGive(cron_pass);
 }
 
 esp_err_t cron_start(int8_t tz) {
     ESP_LOGI(TAG, "cron_start");
     next_id = 0;
-    _list_cron = NULL;
+    cron_qty = 0;
     cron_tz = tz;
-    cron_queue = xQueueCreate(CRON_QUEUE_LEN, sizeof(uint32_t));
+    cron_mutex = xSemaphoreCreateMutex();
+    cron_pass = xSemaphoreCreateBinary();
+    if (cron_mutex == NULL || cron_pass == NULL)
+        return ESP_FAIL;
 
     ESP_LOGI(TAG, "start cron timer");
-    cron_timer_hndl = xTimerCreate("cron_timer", pdMS_TO_TICKS(CRON_TIMER_MS), pdTRUE, (void *)0, cron_timer);
+    cron_timer_hndl = xTimerCreate("cron_timer", pdMS_TO_TICKS(CRON_REARM_MAX_MS), pdFALSE, (void *)0, cron_timer);
 
     if (xTimerStart(cron_timer_hndl, 0) != pdPASS) {
         ESP_LOGI(TAG, "error starting timer");
@@ -114,67 +332,119 @@ esp_err_t cron_start(int8_t tz) {
 
 void cron_stop(void) {
     xTimerStop(cron_timer_hndl, 0);
+
+    // not while the execute task swaps the pass buffers
+    xSemaphoreTake(cron_mutex, portMAX_DELAY);
     vTaskDelete(cron_task_hndl);
-    vQueueDelete(cron_queue);
-    ll_free(_list_cron);
+    vSemaphoreDelete(cron_pass);
+    cron_pass_free(&cron_due);
+    cron_pass_free(&cron_run);
+    for (uint32_t i = 0; i < cron_qty; i++)
+        free(cron_heap[i]);
+    free(cron_heap);
+    cron_heap = NULL;
+    cron_qty = 0;
+    cron_size = 0;
+    xSemaphoreGive(cron_mutex);
 }
 
-int32_t cron_add(char *expr, void *cron_cb_ptr, uint32_t fn_value) {
+static int32_t cron_add_job(const char *expr, cron_fn_t fn, cron_batch_fn_t batch_fn, uint32_t fn_value) {
     const char *err = NULL;
     cron_expr_t parsed;
-    time_t now = 0;
-
-    time(&now);
-    now += 3600 * cron_tz;
 
     cron_parse_expr(expr, &parsed, &err);
     if (err != NULL)
         return ESP_FAIL;
 
-    _list_cron = ll_new(_list_cron);
-    memcpy(&(_list_cron->expr), &parsed, sizeof(cron_expr_t));
-    _list_cron->enabled = true;
-    _list_cron->id = next_id++;
-    _list_cron->next = cron_next(&parsed, now);
-    _list_cron->fn_ptr = cron_cb_ptr;
-    _list_cron->fn_value = fn_value;
-    return _list_cron->id;
+    cron_t *job = malloc(sizeof(cron_t));
+    if (job == NULL)
+        return ESP_FAIL;
+
+    memset(job, 0, sizeof(cron_t));
+    memcpy(&(job->expr), &parsed, sizeof(cron_expr_t));
+    job->enabled = true;
+    job->next = cron_job_next(job, cron_now_ms() / 1000);
+    job->fn = fn;
+    job->batch_fn = batch_fn;
+    job->fn_value = fn_value;
+
+    xSemaphoreTake(cron_mutex, portMAX_DELAY);
+
+    if (cron_qty == cron_size) {
+        uint32_t size = cron_size > 0 ? cron_size * 2 : CRON_HEAP_INIT;
+        cron_t **heap = realloc(cron_heap, size * sizeof(cron_t *));
+        if (heap == NULL) {
+            xSemaphoreGive(cron_mutex);
+            free(job);
+            return ESP_FAIL;
+        }
+        cron_heap = heap;
+        cron_size = size;
+    }
+
+    job->id = next_id++;
+    heap_set(cron_qty++, job);
+    heap_up(job->heap_index);
+    cron_rearm(pdMS_TO_TICKS(10));
+
+    xSemaphoreGive(cron_mutex);
+
+    return job->id;
+}
+
+int32_t cron_add(const char *expr, cron_fn_t fn, uint32_t fn_value) {
+    return fn != NULL ? cron_add_job(expr, fn, NULL, fn_value) : ESP_FAIL;
+}
+
+int32_t cron_add_batch(const char *expr, cron_batch_fn_t fn, uint32_t fn_value) {
+    return fn != NULL ? cron_add_job(expr, NULL, fn, fn_value) : ESP_FAIL;
 }
 
 esp_err_t cron_enable(uint32_t id, bool enable) {
-    bool found = false;
+    xSemaphoreTake(cron_mutex, portMAX_DELAY);
 
-    ll_foreach(_list_cron, item) {
-        if (item != NULL && item->id == id) {
-            item->enabled = enable;
-            found = true;
-            break;
-        }
+    cron_t *job = heap_find(id);
+    if (job != NULL) {
+        if (enable && !job->enabled)
+            job->next = cron_job_next(job, cron_now_ms() / 1000);
+        job->enabled = enable;
+        heap_fix(job);
+        cron_rearm(pdMS_TO_TICKS(10));
     }
 
-    return found ? ESP_OK : ESP_FAIL;
+    xSemaphoreGive(cron_mutex);
+
+    return job != NULL ? ESP_OK : ESP_FAIL;
 }
 
 esp_err_t cron_delete(uint32_t id) {
-    bool found = false;
+    xSemaphoreTake(cron_mutex, portMAX_DELAY);
 
-    ll_foreach(_list_cron, item) {
-        if (item != NULL && item->id == id) {
-            ESP_LOGI(TAG, "delete id=%u", (uint)id);
-            ll_pop(item);
-            found = true;
-            break;
+    cron_t *job = heap_find(id);
+    if (job != NULL) {
+        ESP_LOGI(TAG, "delete id=%u", (uint)id);
+        cron_t *last = cron_heap[--cron_qty];
+        if (job != last) {
+            heap_set(job->heap_index, last);
+            heap_fix(last);
         }
+        free(job);
+        cron_rearm(pdMS_TO_TICKS(10));
     }
 
-    return found ? ESP_OK : ESP_FAIL;
+    xSemaphoreGive(cron_mutex);
+
+    return job != NULL ? ESP_OK : ESP_FAIL;
 }
 
 void cron_list(void) {
-    ESP_LOGI(TAG, "cron list");
+    ESP_LOGI(TAG, "cron list (%u jobs, max lateness %u s, dropped %u)", (unsigned)cron_qty, (unsigned)cron_late_max, (unsigned)cron_dropped);
 
-    ll_foreach(_list_cron, item) {
-        if (item != NULL)
-            ESP_LOGI(TAG, "id=%d enabled=%d value %u cb=%p", (int)item->id, (int)item->enabled, (unsigned)item->fn_value, item->fn_ptr);
+    xSemaphoreTake(cron_mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < cron_qty; i++) {
+        cron_t *item = cron_heap[i];
+        ESP_LOGI(TAG, "id=%d enabled=%d next=%lld value %u cb=%p%s", (int)item->id, (int)item->enabled, (long long)item->next, (unsigned)item->fn_value,
+                 item->fn != NULL ? (void *)item->fn : (void *)item->batch_fn, item->fn != NULL ? "" : " (batch)");
     }
+    xSemaphoreGive(cron_mutex);
 }
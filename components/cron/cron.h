@@ -35,9 +35,22 @@
 
 #include <esp_err.h>
 
+/**
+ * @brief Job function, called from the cron task
+ *
+ */
+typedef void (*cron_fn_t)(uint32_t value);
+
+/**
+ * @brief Batched job function: one call with the values of all its jobs fired at the same time
+ *
+ */
+typedef void (*cron_batch_fn_t)(const uint32_t *values, uint32_t qty);
+
 esp_err_t cron_start(int8_t tz);
 void cron_stop(void);
-int32_t cron_add(char *expr, void *isc_cron_cb_ptr, uint32_t fn_value);
+int32_t cron_add(const char *expr, cron_fn_t fn, uint32_t fn_value);
+int32_t cron_add_batch(const char *expr, cron_batch_fn_t fn, uint32_t fn_value);
 esp_err_t cron_enable(uint32_t id, bool enable);
 esp_err_t cron_delete(uint32_t id);
 void cron_list(void);
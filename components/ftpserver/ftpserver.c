@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
@@ -47,17 +48,16 @@
 #include "esp_netif_types.h"
 #include "lwip/sockets.h"
 #include "ftpserver.h"
+#include "metrics.h"
 
 const char *FTP_TAG = "ftp";
 
 #define CONFIG_FTP_USER     "test"
 #define CONFIG_FTP_PASSWORD "test"
 
-#define FTPSERVER_CMD_PORT                 21
 #define FTPSERVER_ACTIVE_DATA_PORT         20
-#define FTPSERVER_PASIVE_DATA_PORT         2024
 #define FTPSERVER_CMD_SIZE_MAX             6
-#define FTPSERVER_CMD_CLIENTS_MAX          1
+#define FTPSERVER_CMD_CLIENTS_MAX          3
 #define FTPSERVER_DATA_CLIENTS_MAX         1
 #define FTPSERVER_MAX_PARAM_SIZE           (FTPSERVER_ALLOC_PATH_MAX + 1)
 #define FTPSERVER_UNIX_SECONDS_180_DAYS    15552000
@@ -65,10 +65,33 @@ const char *FTP_TAG = "ftp";
 #define FTPSERVER_SOCKETFIFO_ELEMENTS_MAX  4
 #define FTPSERVER_USER_PASS_LEN_MAX        32
 #define FTPSERVER_CMD_TIMEOUT_MS           (FTPSERVER_TIMEOUT*1000)
-#define FTPSERVER_BUFFER_SIZE              1024
+#define FTPSERVER_LIST_LINE_MAX            320
 #define FTPSERVER_TIMEOUT                  300
+#define FTPSERVER_SELECT_TIMEOUT_MS        100
 #define FTPSERVER_ALLOC_PATH_MAX           (512)
 #define FTPSEREVR_MAX_ACTIVE_INTERFACES    3
+#define FTPSERVER_BURST_MAX                (32 * 1024) // bytes moved by one session before the others are served
+
+// ports and transfer buffers, can be overridden from the component compile definitions
+#ifndef FTPSERVER_CMD_PORT
+#define FTPSERVER_CMD_PORT                 21
+#endif
+#ifndef FTPSERVER_PASIVE_DATA_PORT
+#define FTPSERVER_PASIVE_DATA_PORT         2024 // session n listens on FTPSERVER_PASIVE_DATA_PORT + n
+#endif
+#ifndef FTPSERVER_BUFFER_SIZE
+#define FTPSERVER_BUFFER_SIZE              4096
+#endif
+#ifndef FTPSERVER_BUFFER_POOL
+#define FTPSERVER_BUFFER_POOL              4 // buffers shared by all sessions
+#endif
+#ifndef FTPSERVER_DOUBLE_BUFFER
+#define FTPSERVER_DOUBLE_BUFFER            0 // 1: RETR reads the next block from flash while the current one is sent
+#endif
+
+#if FTPSERVER_DOUBLE_BUFFER
+#include "esp_vfs_eventfd.h"
+#endif
 
 static char ftpserver_mount_point[128];
 
@@ -80,17 +103,22 @@ static char ftp_user[FTPSERVER_USER_PASS_LEN_MAX + 1];
 static char ftp_pass[FTPSERVER_USER_PASS_LEN_MAX + 1];
 static esp_netif_t *net_if[FTPSEREVR_MAX_ACTIVE_INTERFACES];
 
-static ftp_data_t ftp_data = { 0 };
-static char *ftp_path = NULL;
-static char *ftp_scratch_buffer = NULL;
-static char *ftp_cmd_buffer = NULL;
-static uint8_t ftp_nlist = 0;
+static ftp_server_t ftp_server = { .lc_sd = -1 };
+static ftpserver_upload_cb_t ftp_upload_cb = NULL;
+static uint8_t *ftp_pool[FTPSERVER_BUFFER_POOL] = { 0 };
+static bool ftp_pool_used[FTPSERVER_BUFFER_POOL] = { 0 };
+#if FTPSERVER_DOUBLE_BUFFER
+static QueueHandle_t ftp_prefetch_queue = NULL;
+static int ftp_wake_fd = -1;
+#endif
+static ftp_data_t ftp_sessions[FTPSERVER_CMD_CLIENTS_MAX] = { 0 };
 static const ftp_cmd_t ftp_cmd_table[] = {
         { "FEAT" }, { "SYST" }, { "CDUP" }, { "CWD" },  { "PWD"  },
         { "XPWD" }, { "SIZE" }, { "MDTM" }, { "TYPE" }, { "USER" },
         { "PASS" }, { "PASV" }, { "LIST" }, { "RETR" }, { "STOR" },
         { "DELE" }, { "RMD"  }, { "MKD"  }, { "RNFR" }, { "RNTO" },
-        { "NOOP" }, { "QUIT" }, { "APPE" }, { "NLST" }, { "AUTH" }
+        { "NOOP" }, { "QUIT" }, { "APPE" }, { "NLST" }, { "AUTH" },
+        { "REST" }, { "MLSD" }
 };
 
 uint64_t mp_hal_ticks_ms(void) {
@@ -115,101 +143,183 @@ static void stoupper(char *str) {
     }
 }
 
-static bool ftp_open_file(const char *path, const char *mode) {
+static void closesocket_sd(int32_t *sd) {
+    if (*sd >= 0)
+        closesocket(*sd);
+    *sd = -1;
+}
+
+static void set_nonblocking(int32_t sd) {
+    uint32_t option = fcntl(sd, F_GETFL, 0);
+    option |= O_NONBLOCK;
+    fcntl(sd, F_SETFL, option);
+}
+
+static bool ftp_open_file(ftp_data_t *ftp, const char *path, const char *mode) {
     ESP_LOGI(FTP_TAG, "ftp_open_file: path=[%s]", path);
     char fullname[128];
     strcpy(fullname, ftpserver_mount_point);
     strcat(fullname, path);
     ESP_LOGI(FTP_TAG, "ftp_open_file: fullname=[%s]", fullname);
-    ftp_data.fp = fopen(fullname, mode);
-    if (ftp_data.fp == NULL) {
+    ftp->fp = fopen(fullname, mode);
+    if (ftp->fp == NULL) {
         ESP_LOGE(FTP_TAG, "ftp_open_file: open fail [%s]", fullname);
         return false;
     }
-    ftp_data.e_open = E_FTP_FILE_OPEN;
+    ftp->e_open = E_FTP_FILE_OPEN;
     return true;
 }
 
-static void ftp_close_files_dir(void) {
-    if (ftp_data.e_open == E_FTP_FILE_OPEN) {
-        fclose(ftp_data.fp);
-        ftp_data.fp = NULL;
-    } else if (ftp_data.e_open == E_FTP_DIR_OPEN) {
-        closedir(ftp_data.dp);
-        ftp_data.dp = NULL;
+static bool ftp_seek_file(ftp_data_t *ftp, uint32_t offset) {
+    if (offset == 0 || fseek(ftp->fp, offset, SEEK_SET) == 0)
+        return true;
+
+    ESP_LOGW(FTP_TAG, "ftp_seek_file: can't seek to %"PRIu32, offset);
+    fclose(ftp->fp);
+    ftp->fp = NULL;
+    ftp->e_open = E_FTP_NOTHING_OPEN;
+    return false;
+}
+
+static void ftp_close_files_dir(ftp_data_t *ftp) {
+    // the reader task may still own the file
+    while (ftp->pf_state == E_FTP_PREFETCH_BUSY)
+        vTaskDelay(1);
+    ftp->pf_state = E_FTP_PREFETCH_IDLE;
+
+    if (ftp->e_open == E_FTP_FILE_OPEN) {
+        fclose(ftp->fp);
+        ftp->fp = NULL;
+    } else if (ftp->e_open == E_FTP_DIR_OPEN) {
+        closedir(ftp->dp);
+        ftp->dp = NULL;
     }
-    ftp_data.e_open = E_FTP_NOTHING_OPEN;
+    ftp->e_open = E_FTP_NOTHING_OPEN;
 }
 
-static void ftp_close_filesystem_on_error(void) {
-    ftp_close_files_dir();
-    if (ftp_data.fp) {
-        fclose(ftp_data.fp);
-        ftp_data.fp = NULL;
+static void ftp_close_filesystem_on_error(ftp_data_t *ftp) {
+    ftp_close_files_dir(ftp);
+    if (ftp->fp) {
+        fclose(ftp->fp);
+        ftp->fp = NULL;
+    }
+    if (ftp->dp) {
+        closedir(ftp->dp);
+        ftp->dp = NULL;
     }
-    if (ftp_data.dp) {
-        closedir(ftp_data.dp);
-        ftp_data.dp = NULL;
+}
+
+static void ftp_buffers_put(ftp_data_t *ftp) {
+    for (int b = 0; b < 2; b++) {
+        if (ftp->buf[b] == NULL)
+            continue;
+        for (int n = 0; n < FTPSERVER_BUFFER_POOL; n++)
+            if (ftp_pool[n] == ftp->buf[b])
+                ftp_pool_used[n] = false;
+        ftp->buf[b] = NULL;
+    }
+    ftp->buf_tx = 0;
+}
+
+// take the transfer buffers of a session from the pool
+static bool ftp_buffers_get(ftp_data_t *ftp, int count) {
+    ftp_buffers_put(ftp);
+    for (int n = 0; n < FTPSERVER_BUFFER_POOL && count > 0; n++) {
+        if (ftp_pool_used[n] || ftp_pool[n] == NULL)
+            continue;
+        ftp_pool_used[n] = true;
+        ftp->buf[--count] = ftp_pool[n];
+    }
+    if (count == 0)
+        return true;
+
+    ESP_LOGW(FTP_TAG, "No free transfer buffer");
+    ftp_buffers_put(ftp);
+    return false;
+}
+
+#if FTPSERVER_DOUBLE_BUFFER
+// fills the idle buffer of a session while the ftp task sends the other one
+static void ftp_prefetch_task(void *pvParameters) {
+    ftp_data_t *ftp;
+    uint64_t wake = 1;
+
+    while (1) {
+        if (xQueueReceive(ftp_prefetch_queue, &ftp, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        ftp->pf_len = fread(ftp->buf[ftp->buf_tx ^ 1], 1, ftp_buff_size, ftp->fp);
+        ftp->pf_eof = ftp->pf_len < ftp_buff_size;
+        ftp->pf_state = ferror(ftp->fp) ? E_FTP_PREFETCH_FAILED : E_FTP_PREFETCH_READY;
+
+        // wake up select()
+        write(ftp_wake_fd, &wake, sizeof(wake));
     }
 }
 
-static ftp_result_t ftp_read_file(char *filebuf, uint32_t desiredsize, uint32_t *actualsize) {
+static void ftp_prefetch(ftp_data_t *ftp) {
+    ftp->pf_state = E_FTP_PREFETCH_BUSY;
+    xQueueSend(ftp_prefetch_queue, &ftp, portMAX_DELAY);
+}
+#endif
+
+#if !FTPSERVER_DOUBLE_BUFFER
+static ftp_result_t ftp_read_file(ftp_data_t *ftp, char *filebuf, uint32_t desiredsize, uint32_t *actualsize) {
     ftp_result_t result = E_FTP_RESULT_CONTINUE;
-    *actualsize = fread(filebuf, 1, desiredsize, ftp_data.fp);
-    if (*actualsize == 0) {
-        ftp_close_files_dir();
-        result = E_FTP_RESULT_FAILED;
-    } else if (*actualsize < desiredsize) {
-        ftp_close_files_dir();
-        result = E_FTP_RESULT_OK;
+    *actualsize = fread(filebuf, 1, desiredsize, ftp->fp);
+    if (*actualsize < desiredsize) {
+        // short read: end of file, unless the stream reports an error
+        result = ferror(ftp->fp) ? E_FTP_RESULT_FAILED : E_FTP_RESULT_OK;
+        ftp_close_files_dir(ftp);
     }
     return result;
 }
+#endif
 
-static ftp_result_t ftp_write_file(char *filebuf, uint32_t size) {
+static ftp_result_t ftp_write_file(ftp_data_t *ftp, char *filebuf, uint32_t size) {
     ftp_result_t result = E_FTP_RESULT_FAILED;
-    uint32_t actualsize = fwrite(filebuf, 1, size, ftp_data.fp);
+    uint32_t actualsize = fwrite(filebuf, 1, size, ftp->fp);
     if (actualsize == size) {
         result = E_FTP_RESULT_OK;
     } else {
-        ftp_close_files_dir();
+        ftp_close_files_dir(ftp);
     }
     return result;
 }
 
-static ftp_result_t ftp_open_dir_for_listing(const char *path) {
-    if (ftp_data.dp) {
-        closedir(ftp_data.dp);
-        ftp_data.dp = NULL;
+static ftp_result_t ftp_open_dir_for_listing(ftp_data_t *ftp, const char *path) {
+    if (ftp->dp) {
+        closedir(ftp->dp);
+        ftp->dp = NULL;
     }
     ESP_LOGI(FTP_TAG, "ftp_open_dir_for_listing path=[%s] MOUNT_POINT=[%s]", path, ftpserver_mount_point);
     char fullname[128];
     strcpy(fullname, ftpserver_mount_point);
     strcat(fullname, path);
     ESP_LOGI(FTP_TAG, "ftp_open_dir_for_listing: %s", fullname);
-    ftp_data.dp = opendir(fullname);  // Open the directory
-    if (ftp_data.dp == NULL) {
+    ftp->dp = opendir(fullname);  // Open the directory
+    if (ftp->dp == NULL) {
         return E_FTP_RESULT_FAILED;
     }
-    ftp_data.e_open = E_FTP_DIR_OPEN;
-    ftp_data.listroot = false;
+    ftp->e_open = E_FTP_DIR_OPEN;
+    ftp->listroot = false;
     return E_FTP_RESULT_CONTINUE;
 }
 
-static int ftp_get_eplf_item(char *dest, uint32_t destsize, struct dirent *de) {
+static int ftp_get_eplf_item(ftp_data_t *ftp, char *dest, uint32_t destsize, struct dirent *de) {
     char *type = (de->d_type & DT_DIR) ? "d" : "-";
 
     // Get full file path needed for stat function
     char fullname[128];
     strcpy(fullname, ftpserver_mount_point);
-    strcat(fullname, ftp_path);
+    strcat(fullname, ftp->path);
     if (fullname[strlen(fullname) - 1] != '/')
         strcat(fullname, "/");
-    strcat(fullname, de->d_name);
+    strlcat(fullname, de->d_name, sizeof(fullname));
 
     struct stat buf;
     int res = stat(fullname, &buf);
-    ESP_LOGI(FTP_TAG, "ftp_get_eplf_item res=%d buf.st_size=%ld", res, buf.st_size);
+    ESP_LOGD(FTP_TAG, "ftp_get_eplf_item res=%d buf.st_size=%ld", res, buf.st_size);
     if (res < 0) {
         buf.st_size = 0;
         buf.st_mtime = 946684800; // Jan 1, 2000
@@ -218,49 +328,47 @@ static int ftp_get_eplf_item(char *dest, uint32_t destsize, struct dirent *de) {
     char str_time[64];
     struct tm *tm_info;
     time_t now;
-    if (time(&now) < 0)
-        now = 946684800; // get the current time from the RTC
-    tm_info = localtime(&buf.st_mtime); // get broken-down file time
+    int addsize;
+
+    if (ftp->list_fmt == E_FTP_LIST_NAMES) {
+        addsize = snprintf(dest, destsize, "%s\r\n", de->d_name);
+    } else if (ftp->list_fmt == E_FTP_LIST_MLSD) {
+        // RFC 3659 facts, modify is UTC
+        tm_info = gmtime(&buf.st_mtime);
+        strftime(str_time, 63, "%Y%m%d%H%M%S", tm_info);
+        addsize = snprintf(dest, destsize, "type=%s;size=%"PRIu32";modify=%s; %s\r\n", (de->d_type & DT_DIR) ? "dir" : "file", (uint32_t) buf.st_size,
+                str_time, de->d_name);
+    } else {
+        if (time(&now) < 0)
+            now = 946684800; // get the current time from the RTC
+        tm_info = localtime(&buf.st_mtime); // get broken-down file time
 
-    // if file is older than 180 days show dat,month,year else show month, day and time
-    if ((buf.st_mtime + FTPSERVER_UNIX_SECONDS_180_DAYS) < now)
-        strftime(str_time, 127, "%b %d %Y", tm_info);
-    else
-        strftime(str_time, 63, "%b %d %H:%M", tm_info);
+        // if file is older than 180 days show dat,month,year else show month, day and time
+        if ((buf.st_mtime + FTPSERVER_UNIX_SECONDS_180_DAYS) < now)
+            strftime(str_time, 63, "%b %d %Y", tm_info);
+        else
+            strftime(str_time, 63, "%b %d %H:%M", tm_info);
 
-    int addsize = destsize + 64;
+        addsize = snprintf(dest, destsize, "%srw-rw-rw-   1 root  root %9"PRIu32" %s %s\r\n", type, (uint32_t) buf.st_size, str_time, de->d_name);
+    }
 
-    while (addsize >= destsize) {
-        if (ftp_nlist)
-            addsize = snprintf(dest, destsize, "%s\r\n", de->d_name);
-        else
-            addsize = snprintf(dest, destsize, "%srw-rw-rw-   1 root  root %9"PRIu32" %s %s\r\n", type, (uint32_t) buf.st_size, str_time, de->d_name);
-        if (addsize >= destsize) {
-            ESP_LOGW(FTP_TAG, "Buffer too small, reallocating [%d > %"PRIi32"]", ftp_buff_size, ftp_buff_size + (addsize - destsize) + 64);
-            char *new_dest = realloc(dest, ftp_buff_size + (addsize - destsize) + 65);
-            if (new_dest) {
-                ftp_buff_size += (addsize - destsize) + 64;
-                destsize += (addsize - destsize) + 64;
-                dest = new_dest;
-                addsize = destsize + 64;
-            } else {
-                ESP_LOGE(FTP_TAG, "Buffer reallocation ERROR");
-                addsize = 0;
-            }
-        }
+    if (addsize >= destsize) {
+        // the caller keeps FTPSERVER_LIST_LINE_MAX free, only an oversized name gets here
+        ESP_LOGW(FTP_TAG, "List entry truncated: %s", de->d_name);
+        addsize = destsize - 1;
     }
     return addsize;
 }
 
-static ftp_result_t ftp_list_dir(char *list, uint32_t maxlistsize, uint32_t *listsize) {
+static ftp_result_t ftp_list_dir(ftp_data_t *ftp, char *list, uint32_t maxlistsize, uint32_t *listsize) {
     uint next = 0;
     uint listcount = 0;
     ftp_result_t result = E_FTP_RESULT_CONTINUE;
     struct dirent *de;
 
     // read up to 8 directory items
-    while (((maxlistsize - next) > 64) && (listcount < 8)) {
-        de = readdir(ftp_data.dp); // Read a directory item
+    while (((maxlistsize - next) > FTPSERVER_LIST_LINE_MAX) && (listcount < 8)) {
+        de = readdir(ftp->dp); // Read a directory item
         if (de == NULL) {
             result = E_FTP_RESULT_OK;
             break; // Break on error or end of dp
@@ -271,37 +379,45 @@ static ftp_result_t ftp_list_dir(char *list, uint32_t maxlistsize, uint32_t *lis
             continue; // Ignore .. entry
 
         // add the entry to the list
-        ESP_LOGI(FTP_TAG, "Add to dir list: %s", de->d_name);
-        next += ftp_get_eplf_item((list + next), (maxlistsize - next), de);
+        ESP_LOGD(FTP_TAG, "Add to dir list: %s", de->d_name);
+        next += ftp_get_eplf_item(ftp, (list + next), (maxlistsize - next), de);
         listcount++;
     }
     if (result == E_FTP_RESULT_OK) {
-        ftp_close_files_dir();
+        ftp_close_files_dir(ftp);
     }
     *listsize = next;
     return result;
 }
 
-static void ftp_close_cmd_data(void) {
-    closesocket(ftp_data.c_sd);
-    closesocket(ftp_data.d_sd);
-    ftp_data.c_sd = -1;
-    ftp_data.d_sd = -1;
-    ftp_close_filesystem_on_error();
+static void ftp_close_data(ftp_data_t *ftp) {
+    closesocket_sd(&ftp->d_sd);
+    closesocket_sd(&ftp->ld_sd);
+    ftp->d_len = 0;
+    ftp->d_off = 0;
+    ftp->substate = E_FTP_STE_SUB_DISCONNECTED;
+}
+
+static void ftp_close_session(ftp_data_t *ftp) {
+    if (ftp->c_sd >= 0)
+        ESP_LOGI(FTP_TAG, "Session %u closed", ftp->id);
+    closesocket_sd(&ftp->c_sd);
+    ftp_close_data(ftp);
+    ftp_close_filesystem_on_error(ftp);
+    ftp_buffers_put(ftp);
+    free(ftp->upload);
+    ftp->upload = NULL;
+    ftp->state = E_FTP_STE_READY;
 }
 
 static void _ftp_reset(void) {
     // close all connections and start all over again
     ESP_LOGW(FTP_TAG, "FTP RESET");
-    closesocket(ftp_data.lc_sd);
-    closesocket(ftp_data.ld_sd);
-    ftp_data.lc_sd = -1;
-    ftp_data.ld_sd = -1;
-    ftp_close_cmd_data();
-
-    ftp_data.e_open = E_FTP_NOTHING_OPEN;
-    ftp_data.state = E_FTP_STE_START;
-    ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
+    closesocket_sd(&ftp_server.lc_sd);
+    for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++)
+        ftp_close_session(&ftp_sessions[n]);
+
+    ftp_server.state = E_FTP_STE_START;
 }
 
 static bool ftp_create_listening_socket(int32_t *sd, uint32_t port, uint8_t backlog) {
@@ -313,14 +429,12 @@ static bool ftp_create_listening_socket(int32_t *sd, uint32_t port, uint8_t back
     *sd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
     _sd = *sd;
 
-    if (_sd > 0) {
+    if (_sd >= 0) {
         // enable non-blocking mode
-        uint32_t option = fcntl(_sd, F_GETFL, 0);
-        option |= O_NONBLOCK;
-        fcntl(_sd, F_SETFL, option);
+        set_nonblocking(_sd);
 
         // enable address reusing
-        option = 1;
+        uint32_t option = 1;
         result = setsockopt(_sd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
 
         // bind the socket to a port number
@@ -337,7 +451,7 @@ static bool ftp_create_listening_socket(int32_t *sd, uint32_t port, uint8_t back
         if (!result) {
             return true;
         }
-        closesocket(*sd);
+        closesocket_sd(sd);
     }
     return false;
 }
@@ -345,17 +459,16 @@ static bool ftp_create_listening_socket(int32_t *sd, uint32_t port, uint8_t back
 static ftp_result_t ftp_wait_for_connection(int32_t l_sd, int32_t *n_sd, uint32_t *ip_addr) {
     esp_err_t err;
     struct sockaddr_in sClientAddress;
-    socklen_t in_addrSize;
+    socklen_t in_addrSize = sizeof(sClientAddress);
 
     // accepts a connection from a TCP client, if there is any, otherwise returns EAGAIN
     *n_sd = accept(l_sd, (struct sockaddr*) &sClientAddress, (socklen_t*) &in_addrSize);
     int32_t _sd = *n_sd;
     if (_sd < 0) {
-        if (errno == EAGAIN) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
             return E_FTP_RESULT_CONTINUE;
         }
         // error
-        _ftp_reset();
         return E_FTP_RESULT_FAILED;
     }
 
@@ -392,114 +505,75 @@ static ftp_result_t ftp_wait_for_connection(int32_t l_sd, int32_t *n_sd, uint32_
         }
     }
 
-    // enable non-blocking mode if not data channel connection
-    uint32_t option = fcntl(_sd, F_GETFL, 0);
-    if (l_sd != ftp_data.ld_sd)
-        option |= O_NONBLOCK;
-    fcntl(_sd, F_SETFL, option);
+    // every socket is driven from the select() loop
+    set_nonblocking(_sd);
 
     // client connected, so go on
     return E_FTP_RESULT_OK;
 }
 
-static void ftp_send_reply(uint32_t status, char *message) {
+static void ftp_send_reply(ftp_data_t *ftp, uint32_t status, char *message) {
+    if (ftp->c_sd < 0)
+        return;
     if (!message) {
         message = "";
     }
-    snprintf((char*) ftp_cmd_buffer, 4, "%"PRIu32, status);
-    strcat((char*) ftp_cmd_buffer, " ");
-    strcat((char*) ftp_cmd_buffer, message);
-    strcat((char*) ftp_cmd_buffer, "\r\n");
+    snprintf((char*) ftp->cmd_buffer, 4, "%"PRIu32, status);
+    // a message starting with '-' is the first line of a multi-line reply
+    if (message[0] != '-')
+        strcat((char*) ftp->cmd_buffer, " ");
+    strcat((char*) ftp->cmd_buffer, message);
+    strcat((char*) ftp->cmd_buffer, "\r\n");
 
     int32_t timeout = 200;
-    ftp_result_t result;
-    size_t size = strlen((char*) ftp_cmd_buffer);
+    int32_t result;
+    size_t size = strlen((char*) ftp->cmd_buffer);
 
-    ESP_LOGI(FTP_TAG, "Send reply: [%.*s]", size - 2, ftp_cmd_buffer);
-    vTaskDelay(1);
+    ESP_LOGI(FTP_TAG, "Send reply: [%.*s]", size - 2, ftp->cmd_buffer);
 
     while (1) {
-        result = send(ftp_data.c_sd, ftp_cmd_buffer, size, 0);
+        // replies are short, the socket buffer only fills up if the client stops reading
+        result = send(ftp->c_sd, ftp->cmd_buffer, size, 0);
         if (result == size) {
             if (status == 221) {
-                closesocket(ftp_data.d_sd);
-                ftp_data.d_sd = -1;
-                closesocket(ftp_data.ld_sd);
-                ftp_data.ld_sd = -1;
-                closesocket(ftp_data.c_sd);
-                ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
-                ftp_close_filesystem_on_error();
+                ftp_close_session(ftp);
             } else if (status == 426 || status == 451 || status == 550) {
-                closesocket(ftp_data.d_sd);
-                ftp_data.d_sd = -1;
-                ftp_close_filesystem_on_error();
+                closesocket_sd(&ftp->d_sd);
+                ftp_close_filesystem_on_error(ftp);
             }
-            vTaskDelay(1);
             ESP_LOGI(FTP_TAG, "Send reply: OK (%u)", size);
             break;
         } else {
-            vTaskDelay(1);
-            if ((timeout <= 0) || (errno != EAGAIN)) {
+            if ((timeout <= 0) || (errno != EAGAIN && errno != EWOULDBLOCK)) {
                 // error
-                _ftp_reset();
+                ftp_close_session(ftp);
                 ESP_LOGW(FTP_TAG, "Error sending command reply.");
                 break;
             }
-        }
-        timeout -= portTICK_PERIOD_MS;
-    }
-}
-
-static void ftp_send_list(uint32_t datasize) {
-    int32_t timeout = 200;
-    ftp_result_t result;
-
-    ESP_LOGI(FTP_TAG, "Send list data: (%"PRIu32")", datasize);
-    vTaskDelay(1);
-
-    while (1) {
-        result = send(ftp_data.d_sd, ftp_data.dBuffer, datasize, 0);
-        if (result == datasize) {
             vTaskDelay(1);
-            ESP_LOGI(FTP_TAG, "Send OK");
-            break;
-        } else {
-            vTaskDelay(1);
-            if ((timeout <= 0) || (errno != EAGAIN)) {
-                // error
-                _ftp_reset();
-                ESP_LOGW(FTP_TAG, "Error sending list data.");
-                break;
-            }
         }
         timeout -= portTICK_PERIOD_MS;
     }
 }
 
-static void ftp_send_file_data(uint32_t datasize) {
-    ftp_result_t result;
-    uint32_t timeout = 200;
+// send what is left in the data buffer, E_FTP_RESULT_CONTINUE while something remains
+static ftp_result_t ftp_send_data(ftp_data_t *ftp) {
+    int32_t sent = send(ftp->d_sd, ftp->buf[ftp->buf_tx] + ftp->d_off, ftp->d_len - ftp->d_off, 0);
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return E_FTP_RESULT_CONTINUE;
+        ESP_LOGW(FTP_TAG, "Error sending data (%d)", errno);
+        return E_FTP_RESULT_FAILED;
+    }
 
-    ESP_LOGI(FTP_TAG, "Send file data: (%"PRIu32")", datasize);
-    vTaskDelay(1);
+    ftp->dtimeout = 0;
+    ftp->d_off += sent;
+    if (ftp->d_off < ftp->d_len)
+        return E_FTP_RESULT_CONTINUE;
 
-    while (1) {
-        result = send(ftp_data.d_sd, ftp_data.dBuffer, datasize, 0);
-        if (result == datasize) {
-            vTaskDelay(1);
-            ESP_LOGI(FTP_TAG, "Send OK");
-            break;
-        } else {
-            vTaskDelay(1);
-            if ((timeout <= 0) || (errno != EAGAIN)) {
-                // error
-                _ftp_reset();
-                ESP_LOGW(FTP_TAG, "Error sending file data.");
-                break;
-            }
-        }
-        timeout -= portTICK_PERIOD_MS;
-    }
+    ftp->d_off = 0;
+    ftp->d_len = 0;
+    return E_FTP_RESULT_OK;
 }
 
 static ftp_result_t ftp_recv_non_blocking(int32_t sd, void *buff, int32_t Maxlen, int32_t *rxLen) {
@@ -509,10 +583,11 @@ static ftp_result_t ftp_recv_non_blocking(int32_t sd, void *buff, int32_t Maxlen
     *rxLen = recv(sd, buff, Maxlen, 0);
     if (*rxLen > 0)
         return E_FTP_RESULT_OK;
-    else if (errno != EAGAIN)
-        return E_FTP_RESULT_FAILED;
+    else if (*rxLen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return E_FTP_RESULT_CONTINUE;
 
-    return E_FTP_RESULT_CONTINUE;
+    // closed by the peer or error
+    return E_FTP_RESULT_FAILED;
 }
 
 static void ftp_open_child(char *pwd, char *dir) {
@@ -611,37 +686,52 @@ static ftp_cmd_index_t ftp_pop_command(char **str) {
     return E_FTP_CMD_NOT_SUPPORTED;
 }
 
-static void ftp_get_param_and_open_child(char **bufptr) {
-    ftp_pop_param(bufptr, ftp_scratch_buffer, false, false);
-    ftp_open_child(ftp_path, ftp_scratch_buffer);
-    ftp_data.closechild = true;
+static void ftp_get_param_and_open_child(ftp_data_t *ftp, char **bufptr) {
+    ftp_pop_param(bufptr, ftp->scratch, false, false);
+    ftp_open_child(ftp->path, ftp->scratch);
+    ftp->closechild = true;
 }
 
-static void ftp_process_cmd(void) {
+// a transfer needs the data connection opened after PASV
+static bool ftp_data_ready(ftp_data_t *ftp) {
+    if (ftp->substate == E_FTP_STE_SUB_DATA_CONNECTED)
+        return true;
+
+    ftp_send_reply(ftp, 425, NULL);
+    return false;
+}
+
+static void ftp_process_cmd(ftp_data_t *ftp) {
     int32_t len;
-    char *bufptr = (char*) ftp_cmd_buffer;
+    char *bufptr = (char*) ftp->cmd_buffer;
     ftp_result_t result;
     struct stat buf;
+    uint32_t rest;
+    bool opened;
     int res;
 
     memset(bufptr, 0, FTPSERVER_MAX_PARAM_SIZE + FTPSERVER_CMD_SIZE_MAX);
-    ftp_data.closechild = false;
+    ftp->closechild = false;
 
     // use the reply buffer to receive new commands
-    result = ftp_recv_non_blocking(ftp_data.c_sd, ftp_cmd_buffer, FTPSERVER_MAX_PARAM_SIZE + FTPSERVER_CMD_SIZE_MAX, &len);
+    result = ftp_recv_non_blocking(ftp->c_sd, ftp->cmd_buffer, FTPSERVER_MAX_PARAM_SIZE + FTPSERVER_CMD_SIZE_MAX - 1, &len);
     if (result == E_FTP_RESULT_OK) {
-        ftp_cmd_buffer[len] = '\0';
+        ftp->ctimeout = 0;
+        ftp->cmd_buffer[len] = '\0';
         // bufptr is moved as commands are being popped
         ftp_cmd_index_t cmd = ftp_pop_command(&bufptr);
-        if (!ftp_data.loggin.passvalid
+        // a REST offset only applies to the command that follows it
+        rest = ftp->rest;
+        ftp->rest = 0;
+        if (!ftp->loggin.passvalid
                 && ((cmd != E_FTP_CMD_USER) && (cmd != E_FTP_CMD_PASS) && (cmd != E_FTP_CMD_QUIT) && (cmd != E_FTP_CMD_FEAT) && (cmd != E_FTP_CMD_AUTH))) {
-            ftp_send_reply(332, NULL);
+            ftp_send_reply(ftp, 332, NULL);
             return;
         }
         if ((cmd >= 0) && (cmd < E_FTP_NUM_FTP_CMDS)) {
-            ESP_LOGI(FTP_TAG, "CMD: %s", ftp_cmd_table[cmd].cmd);
+            ESP_LOGI(FTP_TAG, "CMD[%u]: %s", ftp->id, ftp_cmd_table[cmd].cmd);
         } else {
-            ESP_LOGI(FTP_TAG, "CMD: %d", cmd);
+            ESP_LOGI(FTP_TAG, "CMD[%u]: %d", ftp->id, cmd);
         }
         char fullname[128];
         char fullname2[128];
@@ -650,517 +740,542 @@ static void ftp_process_cmd(void) {
 
         switch (cmd) {
             case E_FTP_CMD_FEAT:
-                ftp_send_reply(502, "no-features");
+                ftp_send_reply(ftp, 211, "-Features:\r\n SIZE\r\n MDTM\r\n REST STREAM\r\n MLSD type*;size*;modify*;\r\n211 End");
                 break;
             case E_FTP_CMD_AUTH:
-                ftp_send_reply(504, "not-supported");
+                ftp_send_reply(ftp, 504, "not-supported");
                 break;
             case E_FTP_CMD_SYST:
-                ftp_send_reply(215, "UNIX Type: L8");
+                ftp_send_reply(ftp, 215, "UNIX Type: L8");
                 break;
             case E_FTP_CMD_CDUP:
-                ftp_close_child(ftp_path);
-                ftp_send_reply(250, NULL);
+                ftp_close_child(ftp->path);
+                ftp_send_reply(ftp, 250, NULL);
                 break;
             case E_FTP_CMD_CWD:
-                ftp_pop_param(&bufptr, ftp_scratch_buffer, false, false);
+                ftp_pop_param(&bufptr, ftp->scratch, false, false);
 
-                if (strlen(ftp_scratch_buffer) > 0) {
-                    if ((ftp_scratch_buffer[0] == '.') && (ftp_scratch_buffer[1] == '\0')) {
-                        ftp_data.dp = NULL;
-                        ftp_send_reply(250, NULL);
+                if (strlen(ftp->scratch) > 0) {
+                    if ((ftp->scratch[0] == '.') && (ftp->scratch[1] == '\0')) {
+                        ftp->dp = NULL;
+                        ftp_send_reply(ftp, 250, NULL);
                         break;
                     }
-                    if ((ftp_scratch_buffer[0] == '.') && (ftp_scratch_buffer[1] == '.') && (ftp_scratch_buffer[2] == '\0')) {
-                        ftp_close_child(ftp_path);
-                        ftp_send_reply(250, NULL);
+                    if ((ftp->scratch[0] == '.') && (ftp->scratch[1] == '.') && (ftp->scratch[2] == '\0')) {
+                        ftp_close_child(ftp->path);
+                        ftp_send_reply(ftp, 250, NULL);
                         break;
                     } else
-                        ftp_open_child(ftp_path, ftp_scratch_buffer);
+                        ftp_open_child(ftp->path, ftp->scratch);
                 }
 
-                if ((ftp_path[0] == '/') && (ftp_path[1] == '\0')) {
-                    ftp_data.dp = NULL;
-                    ftp_send_reply(250, NULL);
+                if ((ftp->path[0] == '/') && (ftp->path[1] == '\0')) {
+                    ftp->dp = NULL;
+                    ftp_send_reply(ftp, 250, NULL);
                 } else {
-                    strcat(fullname, ftp_path);
+                    strcat(fullname, ftp->path);
                     ESP_LOGI(FTP_TAG, "E_FTP_CMD_CWD fullname=[%s]", fullname);
-                    ftp_data.dp = opendir(fullname);
-                    if (ftp_data.dp != NULL) {
-                        closedir(ftp_data.dp);
-                        ftp_data.dp = NULL;
-                        ftp_send_reply(250, NULL);
+                    ftp->dp = opendir(fullname);
+                    if (ftp->dp != NULL) {
+                        closedir(ftp->dp);
+                        ftp->dp = NULL;
+                        ftp_send_reply(ftp, 250, NULL);
                     } else {
-                        ftp_close_child(ftp_path);
-                        ftp_send_reply(550, NULL);
+                        ftp_close_child(ftp->path);
+                        ftp_send_reply(ftp, 550, NULL);
                     }
                 }
                 break;
             case E_FTP_CMD_PWD:
             case E_FTP_CMD_XPWD: {
                 char lpath[128];
-                strcpy(lpath, ftp_path);
+                strcpy(lpath, ftp->path);
 
-                ftp_send_reply(257, lpath);
+                ftp_send_reply(ftp, 257, lpath);
             }
                 break;
             case E_FTP_CMD_SIZE: {
-                ftp_get_param_and_open_child(&bufptr);
-                strcat(fullname, ftp_path);
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                strcat(fullname, ftp->path);
                 ESP_LOGI(FTP_TAG, "E_FTP_CMD_SIZE fullname=[%s]", fullname);
                 int res = stat(fullname, &buf);
                 if (res == 0) {
                     // send the file size
-                    snprintf((char*) ftp_data.dBuffer, ftp_buff_size, "%"PRIu32, (uint32_t) buf.st_size);
-                    ftp_send_reply(213, (char*) ftp_data.dBuffer);
+                    snprintf((char*) ftp->dBuffer, FTPSERVER_MAX_PARAM_SIZE, "%"PRIu32, (uint32_t) buf.st_size);
+                    ftp_send_reply(ftp, 213, (char*) ftp->dBuffer);
                 } else {
-                    ftp_send_reply(550, NULL);
+                    ftp_send_reply(ftp, 550, NULL);
                 }
             }
                 break;
             case E_FTP_CMD_MDTM:
-                ftp_get_param_and_open_child(&bufptr);
-                strcat(fullname, ftp_path);
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                strcat(fullname, ftp->path);
                 ESP_LOGI(FTP_TAG, "E_FTP_CMD_MDTM fullname=[%s]", fullname);
                 res = stat(fullname, &buf);
                 if (res == 0) {
                     // send the file modification time
                     time_t time = buf.st_mtime;
-                    struct tm *ptm = localtime(&time);
-                    strftime((char*) ftp_data.dBuffer, ftp_buff_size, "%Y%m%d%H%M%S", ptm);
-                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_MDTM ftp_data.dBuffer=[%s]", ftp_data.dBuffer);
-                    ftp_send_reply(213, (char*) ftp_data.dBuffer);
+                    struct tm *ptm = gmtime(&time); // RFC 3659: UTC
+                    strftime((char*) ftp->dBuffer, FTPSERVER_MAX_PARAM_SIZE, "%Y%m%d%H%M%S", ptm);
+                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_MDTM ftp->dBuffer=[%s]", ftp->dBuffer);
+                    ftp_send_reply(ftp, 213, (char*) ftp->dBuffer);
                 } else {
-                    ftp_send_reply(550, NULL);
+                    ftp_send_reply(ftp, 550, NULL);
                 }
                 break;
             case E_FTP_CMD_TYPE:
-                ftp_send_reply(200, NULL);
+                ftp_send_reply(ftp, 200, NULL);
                 break;
             case E_FTP_CMD_USER:
-                ftp_pop_param(&bufptr, ftp_scratch_buffer, true, true);
-                if (!memcmp(ftp_scratch_buffer, ftp_user,
-                        ((strlen(ftp_scratch_buffer)) > (strlen(ftp_user)) ? (strlen(ftp_scratch_buffer)) : (strlen(ftp_user))))) {
-                    ftp_data.loggin.uservalid = true && (strlen(ftp_user) == strlen(ftp_scratch_buffer));
+                ftp_pop_param(&bufptr, ftp->scratch, true, true);
+                if (!memcmp(ftp->scratch, ftp_user,
+                        ((strlen(ftp->scratch)) > (strlen(ftp_user)) ? (strlen(ftp->scratch)) : (strlen(ftp_user))))) {
+                    ftp->loggin.uservalid = true && (strlen(ftp_user) == strlen(ftp->scratch));
                 }
-                ftp_send_reply(331, NULL);
+                ftp_send_reply(ftp, 331, NULL);
                 break;
             case E_FTP_CMD_PASS:
-                ftp_pop_param(&bufptr, ftp_scratch_buffer, true, true);
-                if (!memcmp(ftp_scratch_buffer, ftp_pass,
-                        ((strlen(ftp_scratch_buffer)) > (strlen(ftp_pass)) ? (strlen(ftp_scratch_buffer)) : (strlen(ftp_pass)))) && ftp_data.loggin.uservalid) {
-                    ftp_data.loggin.passvalid = true && (strlen(ftp_pass) == strlen(ftp_scratch_buffer));
-                    if (ftp_data.loggin.passvalid) {
-                        ftp_send_reply(230, NULL);
+                ftp_pop_param(&bufptr, ftp->scratch, true, true);
+                if (!memcmp(ftp->scratch, ftp_pass,
+                        ((strlen(ftp->scratch)) > (strlen(ftp_pass)) ? (strlen(ftp->scratch)) : (strlen(ftp_pass)))) && ftp->loggin.uservalid) {
+                    ftp->loggin.passvalid = true && (strlen(ftp_pass) == strlen(ftp->scratch));
+                    if (ftp->loggin.passvalid) {
+                        ftp_send_reply(ftp, 230, NULL);
                         break;
                     }
                 }
-                ftp_send_reply(530, NULL);
+                ftp_send_reply(ftp, 530, NULL);
                 break;
             case E_FTP_CMD_PASV: {
                 // some servers (e.g. google chrome) send PASV several times very quickly
-                closesocket(ftp_data.d_sd);
-                ftp_data.d_sd = -1;
-                ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
+                closesocket_sd(&ftp->d_sd);
+                ftp->substate = E_FTP_STE_SUB_DISCONNECTED;
                 bool socketcreated = true;
-                if (ftp_data.ld_sd < 0) {
-                    socketcreated = ftp_create_listening_socket(&ftp_data.ld_sd, FTPSERVER_PASIVE_DATA_PORT, FTPSERVER_DATA_CLIENTS_MAX - 1);
+                uint32_t port = FTPSERVER_PASIVE_DATA_PORT + ftp->id;
+                if (ftp->ld_sd < 0) {
+                    socketcreated = ftp_create_listening_socket(&ftp->ld_sd, port, FTPSERVER_DATA_CLIENTS_MAX - 1);
                 }
                 if (socketcreated) {
-                    uint8_t *pip = (uint8_t*) &ftp_data.ip_addr;
-                    ftp_data.dtimeout = 0;
-                    snprintf((char*) ftp_data.dBuffer, ftp_buff_size, "(%u,%u,%u,%u,%u,%u)", pip[0], pip[1], pip[2], pip[3], (FTPSERVER_PASIVE_DATA_PORT >> 8),
-                            (FTPSERVER_PASIVE_DATA_PORT & 0xFF));
-                    ftp_data.substate = E_FTP_STE_SUB_LISTEN_FOR_DATA;
+                    uint8_t *pip = (uint8_t*) &ftp->ip_addr;
+                    ftp->dtimeout = 0;
+                    snprintf((char*) ftp->dBuffer, FTPSERVER_MAX_PARAM_SIZE, "(%u,%u,%u,%u,%u,%u)", pip[0], pip[1], pip[2], pip[3], (unsigned) (port >> 8),
+                            (unsigned) (port & 0xFF));
+                    ftp->substate = E_FTP_STE_SUB_LISTEN_FOR_DATA;
                     ESP_LOGI(FTP_TAG, "Data socket created");
-                    ftp_send_reply(227, (char*) ftp_data.dBuffer);
+                    ftp_send_reply(ftp, 227, (char*) ftp->dBuffer);
                 } else {
                     ESP_LOGW(FTP_TAG, "Error creating data socket");
-                    ftp_send_reply(425, NULL);
+                    ftp_send_reply(ftp, 425, NULL);
                 }
             }
                 break;
             case E_FTP_CMD_LIST:
             case E_FTP_CMD_NLST:
-                ftp_get_param_and_open_child(&bufptr);
-                if (cmd == E_FTP_CMD_LIST)
-                    ftp_nlist = 0;
-                else
-                    ftp_nlist = 1;
-                if (ftp_open_dir_for_listing(ftp_path) == E_FTP_RESULT_CONTINUE) {
-                    ftp_data.state = E_FTP_STE_CONTINUE_LISTING;
-                    ftp_send_reply(150, NULL);
+            case E_FTP_CMD_MLSD:
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                if (!ftp_data_ready(ftp))
+                    break;
+                if (!ftp_buffers_get(ftp, 1)) {
+                    ftp_send_reply(ftp, 425, NULL);
+                    break;
+                }
+                ftp->list_fmt = cmd == E_FTP_CMD_NLST ? E_FTP_LIST_NAMES : cmd == E_FTP_CMD_MLSD ? E_FTP_LIST_MLSD : E_FTP_LIST_LONG;
+                if (ftp_open_dir_for_listing(ftp, ftp->path) == E_FTP_RESULT_CONTINUE) {
+                    ftp->state = E_FTP_STE_CONTINUE_LISTING;
+                    ftp_send_reply(ftp, 150, NULL);
                 } else
-                    ftp_send_reply(550, NULL);
+                    ftp_send_reply(ftp, 550, NULL);
                 break;
             case E_FTP_CMD_RETR:
-                ftp_data.total = 0;
-                ftp_data.time = 0;
-                ftp_get_param_and_open_child(&bufptr);
-                if ((strlen(ftp_path) > 0) && (ftp_path[strlen(ftp_path) - 1] != '/')) {
-                    if (ftp_open_file(ftp_path, "rb")) {
-                        ftp_data.state = E_FTP_STE_CONTINUE_FILE_TX;
-                        vTaskDelay(20 / portTICK_PERIOD_MS);
-                        ftp_send_reply(150, NULL);
-                    } else {
-                        ftp_data.state = E_FTP_STE_END_TRANSFER;
-                        ftp_send_reply(550, NULL);
-                    }
-                } else {
-                    ftp_data.state = E_FTP_STE_END_TRANSFER;
-                    ftp_send_reply(550, NULL);
+                ftp->total = 0;
+                ftp->time = 0;
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                if (!ftp_data_ready(ftp))
+                    break;
+                if (!ftp_buffers_get(ftp, FTPSERVER_DOUBLE_BUFFER ? 2 : 1)) {
+                    ftp_send_reply(ftp, 425, NULL);
+                    break;
                 }
-                break;
-            case E_FTP_CMD_APPE:
-                ftp_data.total = 0;
-                ftp_data.time = 0;
-                ftp_get_param_and_open_child(&bufptr);
-                if ((strlen(ftp_path) > 0) && (ftp_path[strlen(ftp_path) - 1] != '/')) {
-                    if (ftp_open_file(ftp_path, "ab")) {
-                        ftp_data.state = E_FTP_STE_CONTINUE_FILE_RX;
-                        vTaskDelay(20 / portTICK_PERIOD_MS);
-                        ftp_send_reply(150, NULL);
+                if ((strlen(ftp->path) > 0) && (ftp->path[strlen(ftp->path) - 1] != '/')) {
+                    if (ftp_open_file(ftp, ftp->path, "rb") && ftp_seek_file(ftp, rest)) {
+                        ftp->state = E_FTP_STE_CONTINUE_FILE_TX;
+                        ftp_send_reply(ftp, 150, NULL);
                     } else {
-                        ftp_data.state = E_FTP_STE_END_TRANSFER;
-                        ftp_send_reply(550, NULL);
+                        ftp->state = E_FTP_STE_END_TRANSFER;
+                        ftp_send_reply(ftp, 550, NULL);
                     }
                 } else {
-                    ftp_data.state = E_FTP_STE_END_TRANSFER;
-                    ftp_send_reply(550, NULL);
+                    ftp->state = E_FTP_STE_END_TRANSFER;
+                    ftp_send_reply(ftp, 550, NULL);
                 }
                 break;
+            case E_FTP_CMD_APPE:
             case E_FTP_CMD_STOR:
-                ftp_data.total = 0;
-                ftp_data.time = 0;
-                ftp_get_param_and_open_child(&bufptr);
-                if ((strlen(ftp_path) > 0) && (ftp_path[strlen(ftp_path) - 1] != '/')) {
-                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_STOR ftp_path=[%s]", ftp_path);
-                    if (ftp_open_file(ftp_path, "wb")) {
-                        ftp_data.state = E_FTP_STE_CONTINUE_FILE_RX;
-                        vTaskDelay(20 / portTICK_PERIOD_MS);
-                        ftp_send_reply(150, NULL);
+                ftp->total = 0;
+                ftp->time = 0;
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                if (!ftp_data_ready(ftp))
+                    break;
+                if (!ftp_buffers_get(ftp, 1)) {
+                    ftp_send_reply(ftp, 425, NULL);
+                    break;
+                }
+                if ((strlen(ftp->path) > 0) && (ftp->path[strlen(ftp->path) - 1] != '/')) {
+                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_%s ftp->path=[%s]", ftp_cmd_table[cmd].cmd, ftp->path);
+                    // STOR after REST overwrites from the offset and keeps what is before it
+                    if (cmd == E_FTP_CMD_STOR && rest > 0)
+                        opened = ftp_open_file(ftp, ftp->path, "r+b") && ftp_seek_file(ftp, rest);
+                    else
+                        opened = ftp_open_file(ftp, ftp->path, cmd == E_FTP_CMD_APPE ? "ab" : "wb");
+                    if (opened) {
+                        free(ftp->upload);
+                        ftp->upload = ftp_upload_cb != NULL ? strdup(ftp->path) : NULL;
+                        ftp->state = E_FTP_STE_CONTINUE_FILE_RX;
+                        ftp_send_reply(ftp, 150, NULL);
                     } else {
-                        ftp_data.state = E_FTP_STE_END_TRANSFER;
-                        ftp_send_reply(550, NULL);
+                        ftp->state = E_FTP_STE_END_TRANSFER;
+                        ftp_send_reply(ftp, 550, NULL);
                     }
                 } else {
-                    ftp_data.state = E_FTP_STE_END_TRANSFER;
-                    ftp_send_reply(550, NULL);
+                    ftp->state = E_FTP_STE_END_TRANSFER;
+                    ftp_send_reply(ftp, 550, NULL);
                 }
                 break;
             case E_FTP_CMD_DELE:
-                ftp_get_param_and_open_child(&bufptr);
-                if ((strlen(ftp_path) > 0) && (ftp_path[strlen(ftp_path) - 1] != '/')) {
-                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_DELE ftp_path=[%s]", ftp_path);
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                if ((strlen(ftp->path) > 0) && (ftp->path[strlen(ftp->path) - 1] != '/')) {
+                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_DELE ftp->path=[%s]", ftp->path);
 
-                    strcat(fullname, ftp_path);
+                    strcat(fullname, ftp->path);
                     ESP_LOGI(FTP_TAG, "E_FTP_CMD_DELE fullname=[%s]", fullname);
 
                     if (unlink(fullname) == 0) {
-                        vTaskDelay(20 / portTICK_PERIOD_MS);
-                        ftp_send_reply(250, NULL);
+                        ftp_send_reply(ftp, 250, NULL);
                     } else
-                        ftp_send_reply(550, NULL);
+                        ftp_send_reply(ftp, 550, NULL);
                 } else
-                    ftp_send_reply(250, NULL);
+                    ftp_send_reply(ftp, 250, NULL);
                 break;
             case E_FTP_CMD_RMD:
-                ftp_get_param_and_open_child(&bufptr);
-                if ((strlen(ftp_path) > 0) && (ftp_path[strlen(ftp_path) - 1] != '/')) {
-                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_RMD ftp_path=[%s]", ftp_path);
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                if ((strlen(ftp->path) > 0) && (ftp->path[strlen(ftp->path) - 1] != '/')) {
+                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_RMD ftp->path=[%s]", ftp->path);
 
-                    strcat(fullname, ftp_path);
+                    strcat(fullname, ftp->path);
                     ESP_LOGI(FTP_TAG, "E_FTP_CMD_MKD fullname=[%s]", fullname);
 
                     if (rmdir(fullname) == 0) {
-                        vTaskDelay(20 / portTICK_PERIOD_MS);
-                        ftp_send_reply(250, NULL);
+                        ftp_send_reply(ftp, 250, NULL);
                     } else
-                        ftp_send_reply(550, NULL);
+                        ftp_send_reply(ftp, 550, NULL);
                 } else
-                    ftp_send_reply(250, NULL);
+                    ftp_send_reply(ftp, 250, NULL);
                 break;
             case E_FTP_CMD_MKD:
-                ftp_get_param_and_open_child(&bufptr);
-                if ((strlen(ftp_path) > 0) && (ftp_path[strlen(ftp_path) - 1] != '/')) {
-                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_MKD ftp_path=[%s]", ftp_path);
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                if ((strlen(ftp->path) > 0) && (ftp->path[strlen(ftp->path) - 1] != '/')) {
+                    ESP_LOGI(FTP_TAG, "E_FTP_CMD_MKD ftp->path=[%s]", ftp->path);
 
-                    strcat(fullname, ftp_path);
+                    strcat(fullname, ftp->path);
                     ESP_LOGI(FTP_TAG, "E_FTP_CMD_MKD fullname=[%s]", fullname);
 
                     if (mkdir(fullname, 0755) == 0) {
-                        vTaskDelay(20 / portTICK_PERIOD_MS);
-                        ftp_send_reply(250, NULL);
+                        ftp_send_reply(ftp, 250, NULL);
                     } else
-                        ftp_send_reply(550, NULL);
+                        ftp_send_reply(ftp, 550, NULL);
                 } else
-                    ftp_send_reply(250, NULL);
+                    ftp_send_reply(ftp, 250, NULL);
                 break;
             case E_FTP_CMD_RNFR:
-                ftp_get_param_and_open_child(&bufptr);
-                ESP_LOGI(FTP_TAG, "E_FTP_CMD_RNFR ftp_path=[%s]", ftp_path);
+                ftp_get_param_and_open_child(ftp, &bufptr);
+                ESP_LOGI(FTP_TAG, "E_FTP_CMD_RNFR ftp->path=[%s]", ftp->path);
 
-                strcat(fullname, ftp_path);
+                strcat(fullname, ftp->path);
                 ESP_LOGI(FTP_TAG, "E_FTP_CMD_MKD fullname=[%s]", fullname);
 
                 res = stat(fullname, &buf);
                 if (res == 0) {
-                    ftp_send_reply(350, NULL);
+                    ftp_send_reply(ftp, 350, NULL);
                     // save the path of the file to rename
-                    strcpy((char*) ftp_data.dBuffer, ftp_path);
+                    strcpy((char*) ftp->dBuffer, ftp->path);
                 } else {
-                    ftp_send_reply(550, NULL);
+                    ftp_send_reply(ftp, 550, NULL);
                 }
                 break;
             case E_FTP_CMD_RNTO:
-                ftp_get_param_and_open_child(&bufptr);
+                ftp_get_param_and_open_child(ftp, &bufptr);
                 // the path of the file to rename was saved in the data buffer
-                ESP_LOGI(FTP_TAG, "E_FTP_CMD_RNTO ftp_path=[%s], ftp_data.dBuffer=[%s]", ftp_path, (char* ) ftp_data.dBuffer);
-                strcat(fullname, (char*) ftp_data.dBuffer);
+                ESP_LOGI(FTP_TAG, "E_FTP_CMD_RNTO ftp->path=[%s], ftp->dBuffer=[%s]", ftp->path, (char* ) ftp->dBuffer);
+                strcat(fullname, (char*) ftp->dBuffer);
                 ESP_LOGI(FTP_TAG, "E_FTP_CMD_RNTO fullname=[%s]", fullname);
-                strcat(fullname2, ftp_path);
+                strcat(fullname2, ftp->path);
                 ESP_LOGI(FTP_TAG, "E_FTP_CMD_RNTO fullname2=[%s]", fullname2);
 
                 if (rename(fullname, fullname2) == 0) {
-                    ftp_send_reply(250, NULL);
+                    ftp_send_reply(ftp, 250, NULL);
                 } else {
-                    ftp_send_reply(550, NULL);
+                    ftp_send_reply(ftp, 550, NULL);
                 }
                 break;
+            case E_FTP_CMD_REST: {
+                char *end;
+                ftp_pop_param(&bufptr, ftp->scratch, true, true);
+                unsigned long offset = strtoul(ftp->scratch, &end, 10);
+                if (ftp->scratch[0] != '\0' && *end == '\0') {
+                    ftp->rest = offset;
+                    snprintf((char*) ftp->dBuffer, FTPSERVER_MAX_PARAM_SIZE, "Restarting at %"PRIu32, ftp->rest);
+                    ftp_send_reply(ftp, 350, (char*) ftp->dBuffer);
+                } else {
+                    ftp_send_reply(ftp, 501, NULL);
+                }
+            }
+                break;
             case E_FTP_CMD_NOOP:
-                ftp_send_reply(200, NULL);
+                ftp_send_reply(ftp, 200, NULL);
                 break;
             case E_FTP_CMD_QUIT:
-                ftp_send_reply(221, NULL);
+                ftp_send_reply(ftp, 221, NULL);
                 break;
             default:
                 // command not implemented
-                ftp_send_reply(502, NULL);
+                ftp_send_reply(ftp, 502, NULL);
                 break;
         }
 
-        if (ftp_data.closechild) {
-            remove_fname_from_path(ftp_path, ftp_scratch_buffer);
-        }
-    } else if (result == E_FTP_RESULT_CONTINUE) {
-        if (ftp_data.ctimeout > ftp_timeout) {
-            ftp_send_reply(221, NULL);
-            ESP_LOGW(FTP_TAG, "Connection timeout");
+        if (ftp->closechild) {
+            remove_fname_from_path(ftp->path, ftp->scratch);
         }
-    } else {
-        ftp_close_cmd_data();
+    } else if (result == E_FTP_RESULT_FAILED) {
+        ftp_close_session(ftp);
     }
 }
 
-static void ftp_wait_for_enabled(void) {
-    // Check if the telnet service has been enabled
-    if (ftp_data.enabled) {
-        ftp_data.state = E_FTP_STE_START;
-    }
+static void ftp_session_open(ftp_data_t *ftp, int32_t sd, uint32_t ip_addr) {
+    ftp->c_sd = sd;
+    ftp->ip_addr = ip_addr;
+    ftp->state = E_FTP_STE_READY;
+    ftp->substate = E_FTP_STE_SUB_DISCONNECTED;
+    ftp->txRetries = 0;
+    ftp->logginRetries = 0;
+    ftp->ctimeout = 0;
+    ftp->rest = 0;
+    ftp->loggin.uservalid = false;
+    ftp->loggin.passvalid = false;
+    strcpy(ftp->path, "/");
+    ESP_LOGI(FTP_TAG, "Connected (session %u).", ftp->id);
+    ftp_send_reply(ftp, 220, "ESP FTP Server");
 }
 
-void ftpserver_deinit(void) {
-    if (ftp_path)
-        free(ftp_path);
-    if (ftp_cmd_buffer)
-        free(ftp_cmd_buffer);
-    if (ftp_data.dBuffer)
-        free(ftp_data.dBuffer);
-    if (ftp_scratch_buffer)
-        free(ftp_scratch_buffer);
-    ftp_path = NULL;
-    ftp_cmd_buffer = NULL;
-    ftp_data.dBuffer = NULL;
-    ftp_scratch_buffer = NULL;
-}
+static void ftp_accept(void) {
+    int32_t sd;
+    uint32_t ip_addr = 0;
 
-bool ftpserver_init(void) {
-    ftp_stop = 0;
-    // Allocate memory for the data buffer, and the file system structures (from the RTOS heap)
-    ftpserver_deinit();
+    ftp_result_t result = ftp_wait_for_connection(ftp_server.lc_sd, &sd, &ip_addr);
+    if (result == E_FTP_RESULT_FAILED) {
+        _ftp_reset();
+        return;
+    }
+    if (result != E_FTP_RESULT_OK)
+        return;
 
-    memset(&ftp_data, 0, sizeof(ftp_data_t));
-    ftp_data.dBuffer = malloc(ftp_buff_size + 1);
-    if (ftp_data.dBuffer == NULL)
-        return false;
-    ftp_path = malloc(FTPSERVER_MAX_PARAM_SIZE);
-    if (ftp_path == NULL) {
-        free(ftp_data.dBuffer);
-        return false;
+    for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++) {
+        if (ftp_sessions[n].c_sd < 0) {
+            ftp_session_open(&ftp_sessions[n], sd, ip_addr);
+            return;
+        }
     }
-    ftp_scratch_buffer = malloc(FTPSERVER_MAX_PARAM_SIZE);
-    if (ftp_scratch_buffer == NULL) {
-        free(ftp_path);
-        free(ftp_data.dBuffer);
-        return false;
+
+    ESP_LOGW(FTP_TAG, "No free session");
+    send(sd, "421 Too many users\r\n", 20, 0);
+    closesocket(sd);
+}
+
+// read and send file blocks until the socket would block, returns the final reply or 0 while in progress
+static uint32_t ftp_tx_file(ftp_data_t *ftp) {
+    uint32_t burst = 0;
+
+    while (burst < FTPSERVER_BURST_MAX) {
+        if (ftp->d_len == 0) {
+            if (ftp->e_open != E_FTP_FILE_OPEN)
+                return 226;
+#if FTPSERVER_DOUBLE_BUFFER
+            if (ftp->pf_state == E_FTP_PREFETCH_IDLE)
+                ftp_prefetch(ftp);
+            if (ftp->pf_state == E_FTP_PREFETCH_BUSY)
+                return 0; // the reader task wakes up select() when done
+            if (ftp->pf_state == E_FTP_PREFETCH_FAILED)
+                return 451;
+
+            // send the block read ahead and start reading the next one
+            ftp->buf_tx ^= 1;
+            ftp->d_len = ftp->pf_len;
+            ftp->pf_state = E_FTP_PREFETCH_IDLE;
+            if (ftp->pf_eof)
+                ftp_close_files_dir(ftp);
+            else
+                ftp_prefetch(ftp);
+#else
+            if (ftp_read_file(ftp, (char*) ftp->buf[0], ftp_buff_size, &ftp->d_len) == E_FTP_RESULT_FAILED)
+                return 451;
+#endif
+            continue;
+        }
+
+        uint32_t pending = ftp->d_len - ftp->d_off;
+        ftp_result_t result = ftp_send_data(ftp);
+        if (result == E_FTP_RESULT_FAILED)
+            return 426;
+
+        uint32_t sent = pending - (ftp->d_len - ftp->d_off);
+        ftp->total += sent;
+        burst += sent;
+        if (result == E_FTP_RESULT_CONTINUE)
+            return 0;
     }
-    ftp_cmd_buffer = malloc(FTPSERVER_MAX_PARAM_SIZE + FTPSERVER_CMD_SIZE_MAX);
-    if (ftp_cmd_buffer == NULL) {
-        free(ftp_scratch_buffer);
-        free(ftp_path);
-        free(ftp_data.dBuffer);
-        return false;
+
+    return 0;
+}
+
+// receive and write blocks until the socket would block, returns the final reply or 0 while in progress
+static uint32_t ftp_rx_file(ftp_data_t *ftp) {
+    uint32_t burst = 0;
+    int32_t len;
+
+    while (burst < FTPSERVER_BURST_MAX) {
+        len = -1;
+        ftp_result_t result = ftp_recv_non_blocking(ftp->d_sd, ftp->buf[0], ftp_buff_size, &len);
+        if (result == E_FTP_RESULT_CONTINUE)
+            return 0;
+        if (result == E_FTP_RESULT_FAILED && len != 0) {
+            // reset or error: the file is incomplete, the upload callback is not called
+            ESP_LOGW(FTP_TAG, "Data connection error (%d) after %"PRIu32" bytes", errno, ftp->total);
+            ftp_close_files_dir(ftp);
+            return 426;
+        }
+        if (result == E_FTP_RESULT_FAILED) {
+            // data connection closed by the client: file received once the last blocks reach the flash
+            bool flushed = ftp->e_open == E_FTP_FILE_OPEN && fflush(ftp->fp) == 0;
+            ftp_close_files_dir(ftp);
+            return flushed ? 226 : 451;
+        }
+
+        ftp->dtimeout = 0;
+        if (ftp_write_file(ftp, (char*) ftp->buf[0], len) != E_FTP_RESULT_OK) {
+            ESP_LOGW(FTP_TAG, "Error writing to file");
+            return 451;
+        }
+        ftp->total += len;
+        burst += len;
     }
 
-    ftp_data.c_sd = -1;
-    ftp_data.d_sd = -1;
-    ftp_data.lc_sd = -1;
-    ftp_data.ld_sd = -1;
-    ftp_data.e_open = E_FTP_NOTHING_OPEN;
-    ftp_data.state = E_FTP_STE_DISABLED;
-    ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
+    return 0;
+}
 
-    return true;
+// one log line per transfer instead of one per block
+static void ftp_transfer_end(ftp_data_t *ftp, bool upload, uint32_t status) {
+    uint32_t ms = ftp->time > 0 ? ftp->time : 1;
+
+    ftp_send_reply(ftp, status, NULL);
+    ftp->state = E_FTP_STE_END_TRANSFER;
+    metrics_ftp_transfer(upload, ftp->total, status == 226);
+    ESP_LOGI(FTP_TAG, "File %s %s (%"PRIu32" bytes in %"PRIu32" msec, %"PRIu32" KB/s).", upload ? "receive" : "send", status == 226 ? "done" : "failed",
+            ftp->total, ftp->time, (uint32_t) (((uint64_t) ftp->total * 1000) / ms / 1024));
+
+    if (upload && status == 226 && ftp->upload != NULL && ftp_upload_cb != NULL)
+        ftp_upload_cb(ftp->upload);
+    free(ftp->upload);
+    ftp->upload = NULL;
 }
 
-int ftpserver_run(uint32_t elapsed) {
-    if (ftp_stop)
-        return -2;
+static void ftp_session_run(ftp_data_t *ftp, uint32_t elapsed, fd_set *rfds, fd_set *wfds) {
+    uint32_t status;
 
-    ftp_data.dtimeout += elapsed;
-    ftp_data.ctimeout += elapsed;
-    ftp_data.time += elapsed;
+    ftp->dtimeout += elapsed;
+    ftp->ctimeout += elapsed;
+    ftp->time += elapsed;
 
-    switch (ftp_data.state) {
-        case E_FTP_STE_DISABLED:
-            ftp_wait_for_enabled();
-            break;
-        case E_FTP_STE_START:
-            if (ftp_create_listening_socket(&ftp_data.lc_sd, FTPSERVER_CMD_PORT, FTPSERVER_CMD_CLIENTS_MAX - 1)) {
-                ftp_data.state = E_FTP_STE_READY;
-            }
-            break;
+    switch (ftp->state) {
         case E_FTP_STE_READY:
-            if (ftp_data.c_sd < 0 && ftp_data.substate == E_FTP_STE_SUB_DISCONNECTED) {
-                if (E_FTP_RESULT_OK == ftp_wait_for_connection(ftp_data.lc_sd, &ftp_data.c_sd, &ftp_data.ip_addr)) {
-                    ftp_data.txRetries = 0;
-                    ftp_data.logginRetries = 0;
-                    ftp_data.ctimeout = 0;
-                    ftp_data.loggin.uservalid = false;
-                    ftp_data.loggin.passvalid = false;
-                    strcpy(ftp_path, "/");
-                    ESP_LOGI(FTP_TAG, "Connected.");
-                    ftp_send_reply(220, "ESP FTP Server");
-                    break;
-                }
-            }
-            if (ftp_data.c_sd > 0 && ftp_data.substate != E_FTP_STE_SUB_LISTEN_FOR_DATA) {
-                ftp_process_cmd();
-                if (ftp_data.state != E_FTP_STE_READY) {
-                    break;
-                }
+            if (ftp->substate != E_FTP_STE_SUB_LISTEN_FOR_DATA && FD_ISSET(ftp->c_sd, rfds)) {
+                ftp_process_cmd(ftp);
+            } else if (ftp->ctimeout > ftp_timeout) {
+                ftp_send_reply(ftp, 221, NULL);
+                ESP_LOGW(FTP_TAG, "Connection timeout");
             }
             break;
         case E_FTP_STE_END_TRANSFER:
-            if (ftp_data.d_sd >= 0) {
-                closesocket(ftp_data.d_sd);
-                ftp_data.d_sd = -1;
-            }
+            closesocket_sd(&ftp->d_sd);
             break;
         case E_FTP_STE_CONTINUE_LISTING:
             // go on with listing
-        {
-            uint32_t listsize = 0;
-            ftp_result_t list_res = ftp_list_dir((char*) ftp_data.dBuffer, ftp_buff_size, &listsize);
-            if (listsize > 0)
-                ftp_send_list(listsize);
-            if (list_res == E_FTP_RESULT_OK) {
-                ftp_send_reply(226, NULL);
-                ftp_data.state = E_FTP_STE_END_TRANSFER;
+            if (!FD_ISSET(ftp->d_sd, wfds))
+                break;
+            if (ftp->d_len == 0) {
+                uint32_t listsize = 0;
+                ftp_list_dir(ftp, (char*) ftp->buf[0], ftp_buff_size, &listsize);
+                ftp->d_len = listsize;
             }
-            ftp_data.ctimeout = 0;
-        }
+            if (ftp->d_len > 0 && ftp_send_data(ftp) == E_FTP_RESULT_FAILED) {
+                ftp_send_reply(ftp, 426, NULL);
+                ftp->state = E_FTP_STE_END_TRANSFER;
+                break;
+            }
+            if (ftp->d_len == 0 && ftp->e_open != E_FTP_DIR_OPEN) {
+                ftp_send_reply(ftp, 226, NULL);
+                ftp->state = E_FTP_STE_END_TRANSFER;
+            }
+            ftp->ctimeout = 0;
             break;
         case E_FTP_STE_CONTINUE_FILE_TX:
-            // read and send the next block from the file
-        {
-            uint32_t readsize;
-            ftp_result_t result;
-            ftp_data.ctimeout = 0;
-            result = ftp_read_file((char*) ftp_data.dBuffer, ftp_buff_size, &readsize);
-            if (result == E_FTP_RESULT_FAILED) {
-                ftp_send_reply(451, NULL);
-                ftp_data.state = E_FTP_STE_END_TRANSFER;
-            } else {
-                if (readsize > 0) {
-                    ftp_send_file_data(readsize);
-                    ftp_data.total += readsize;
-                    ESP_LOGI(FTP_TAG, "Sent %"PRIu32", total: %"PRIu32, readsize, ftp_data.total);
-                }
-                if (result == E_FTP_RESULT_OK) {
-                    ftp_send_reply(226, NULL);
-                    ftp_data.state = E_FTP_STE_END_TRANSFER;
-                    ESP_LOGI(FTP_TAG, "File sent (%"PRIu32" bytes in %"PRIu32" msec).", ftp_data.total, ftp_data.time);
-                }
-            }
-        }
+            // an empty buffer is refilled without waiting for the socket
+            if (ftp->d_len > 0 && !FD_ISSET(ftp->d_sd, wfds))
+                break;
+            ftp->ctimeout = 0;
+            status = ftp_tx_file(ftp);
+            if (status != 0)
+                ftp_transfer_end(ftp, false, status);
             break;
-        case E_FTP_STE_CONTINUE_FILE_RX: {
-            int32_t len;
-            ftp_result_t result = E_FTP_RESULT_OK;
-
-            result = ftp_recv_non_blocking(ftp_data.d_sd, ftp_data.dBuffer, ftp_buff_size, &len);
-            if (result == E_FTP_RESULT_OK) {
-                // block of data received
-                ftp_data.dtimeout = 0;
-                ftp_data.ctimeout = 0;
-                // save received data to file
-                if (E_FTP_RESULT_OK != ftp_write_file((char*) ftp_data.dBuffer, len)) {
-                    ftp_send_reply(451, NULL);
-                    ftp_data.state = E_FTP_STE_END_TRANSFER;
-                    ESP_LOGW(FTP_TAG, "Error writing to file");
-                } else {
-                    ftp_data.total += len;
-                    ESP_LOGI(FTP_TAG, "Received %"PRIu32", total: %"PRIu32, len, ftp_data.total);
-                }
-            } else if (result == E_FTP_RESULT_CONTINUE) {
+        case E_FTP_STE_CONTINUE_FILE_RX:
+            if (FD_ISSET(ftp->d_sd, rfds)) {
+                ftp->ctimeout = 0;
+                status = ftp_rx_file(ftp);
+                if (status != 0)
+                    ftp_transfer_end(ftp, true, status);
+            } else if (ftp->dtimeout > FTPSERVER_DATA_TIMEOUT_MS) {
                 // nothing received
-                if (ftp_data.dtimeout > FTPSERVER_DATA_TIMEOUT_MS) {
-                    ftp_close_files_dir();
-                    ftp_send_reply(426, NULL);
-                    ftp_data.state = E_FTP_STE_END_TRANSFER;
-                    ESP_LOGW(FTP_TAG, "Receiving to file timeout");
-                }
-            } else {
-                // File received (E_FTP_RESULT_FAILED)
-                ftp_close_files_dir();
-                ftp_send_reply(226, NULL);
-                ftp_data.state = E_FTP_STE_END_TRANSFER;
-                ESP_LOGI(FTP_TAG, "File received (%"PRIu32" bytes in %"PRIu32" msec).", ftp_data.total, ftp_data.time);
-                break;
+                ftp_close_files_dir(ftp);
+                ESP_LOGW(FTP_TAG, "Receiving to file timeout");
+                ftp_transfer_end(ftp, true, 426);
             }
-        }
             break;
         default:
             break;
     }
 
-    switch (ftp_data.substate) {
+    if (ftp->c_sd < 0)
+        return;
+
+    switch (ftp->substate) {
         case E_FTP_STE_SUB_DISCONNECTED:
             break;
         case E_FTP_STE_SUB_LISTEN_FOR_DATA:
-            if (E_FTP_RESULT_OK == ftp_wait_for_connection(ftp_data.ld_sd, &ftp_data.d_sd, NULL)) {
-                ftp_data.dtimeout = 0;
-                ftp_data.substate = E_FTP_STE_SUB_DATA_CONNECTED;
+            if (FD_ISSET(ftp->ld_sd, rfds) && E_FTP_RESULT_OK == ftp_wait_for_connection(ftp->ld_sd, &ftp->d_sd, NULL)) {
+                ftp->dtimeout = 0;
+                ftp->substate = E_FTP_STE_SUB_DATA_CONNECTED;
                 ESP_LOGI(FTP_TAG, "Data socket connected");
-            } else if (ftp_data.dtimeout > FTPSERVER_DATA_TIMEOUT_MS) {
-                ESP_LOGW(FTP_TAG, "Waiting for data connection timeout (%"PRIi32")", ftp_data.dtimeout);
-                ftp_data.dtimeout = 0;
+            } else if (ftp->dtimeout > FTPSERVER_DATA_TIMEOUT_MS) {
+                ESP_LOGW(FTP_TAG, "Waiting for data connection timeout (%"PRIi32")", ftp->dtimeout);
+                ftp->dtimeout = 0;
                 // close the listening socket
-                closesocket(ftp_data.ld_sd);
-                ftp_data.ld_sd = -1;
-                ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
+                ftp_close_data(ftp);
             }
             break;
         case E_FTP_STE_SUB_DATA_CONNECTED:
-            if (ftp_data.state == E_FTP_STE_READY && (ftp_data.dtimeout > FTPSERVER_DATA_TIMEOUT_MS)) {
+            if (ftp->state == E_FTP_STE_READY && (ftp->dtimeout > FTPSERVER_DATA_TIMEOUT_MS)) {
                 // close the listening and the data socket
-                closesocket(ftp_data.ld_sd);
-                closesocket(ftp_data.d_sd);
-                ftp_data.ld_sd = -1;
-                ftp_data.d_sd = -1;
-                ftp_close_filesystem_on_error();
-                ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
+                ftp_close_data(ftp);
+                ftp_close_filesystem_on_error(ftp);
                 ESP_LOGW(FTP_TAG, "Data connection timeout");
             }
             break;
@@ -1169,35 +1284,215 @@ int ftpserver_run(uint32_t elapsed) {
     }
 
     // check the state of the data sockets
-    if (ftp_data.d_sd < 0 && (ftp_data.state > E_FTP_STE_READY)) {
-        ftp_data.substate = E_FTP_STE_SUB_DISCONNECTED;
-        ftp_data.state = E_FTP_STE_READY;
+    if (ftp->d_sd < 0)
+        ftp_buffers_put(ftp);
+    if (ftp->d_sd < 0 && (ftp->state > E_FTP_STE_READY)) {
+        ftp->d_len = 0;
+        ftp->d_off = 0;
+        ftp->substate = E_FTP_STE_SUB_DISCONNECTED;
+        ftp->state = E_FTP_STE_READY;
         ESP_LOGI(FTP_TAG, "Data socket disconnected");
     }
+}
+
+static void fd_add(int32_t sd, fd_set *fds, int32_t *maxfd) {
+    if (sd < 0)
+        return;
+    FD_SET(sd, fds);
+    if (sd > *maxfd)
+        *maxfd = sd;
+}
+
+void ftpserver_deinit(void) {
+    for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++) {
+        ftp_data_t *ftp = &ftp_sessions[n];
+
+        free(ftp->dBuffer);
+        free(ftp->path);
+        free(ftp->scratch);
+        free(ftp->cmd_buffer);
+        ftp->dBuffer = NULL;
+        ftp->path = NULL;
+        ftp->scratch = NULL;
+        ftp->cmd_buffer = NULL;
+        ftp->buf[0] = NULL;
+        ftp->buf[1] = NULL;
+    }
+
+    for (int n = 0; n < FTPSERVER_BUFFER_POOL; n++) {
+        free(ftp_pool[n]);
+        ftp_pool[n] = NULL;
+        ftp_pool_used[n] = false;
+    }
+}
+
+bool ftpserver_init(void) {
+    ftp_stop = 0;
+    // Allocate memory for the data buffer, and the file system structures (from the RTOS heap)
+    ftpserver_deinit();
+
+    memset(&ftp_server, 0, sizeof(ftp_server_t));
+    memset(ftp_sessions, 0, sizeof(ftp_sessions));
+    for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++) {
+        ftp_data_t *ftp = &ftp_sessions[n];
+
+        ftp->id = n;
+        ftp->dBuffer = malloc(FTPSERVER_MAX_PARAM_SIZE);
+        ftp->path = malloc(FTPSERVER_MAX_PARAM_SIZE);
+        ftp->scratch = malloc(FTPSERVER_MAX_PARAM_SIZE);
+        ftp->cmd_buffer = malloc(FTPSERVER_MAX_PARAM_SIZE + FTPSERVER_CMD_SIZE_MAX);
+        if (ftp->dBuffer == NULL || ftp->path == NULL || ftp->scratch == NULL || ftp->cmd_buffer == NULL) {
+            ftpserver_deinit();
+            return false;
+        }
+
+        ftp->c_sd = -1;
+        ftp->d_sd = -1;
+        ftp->ld_sd = -1;
+        ftp->e_open = E_FTP_NOTHING_OPEN;
+        ftp->state = E_FTP_STE_READY;
+        ftp->substate = E_FTP_STE_SUB_DISCONNECTED;
+    }
+
+    // transfer buffers are shared, a session only holds them while a transfer runs
+    for (int n = 0; n < FTPSERVER_BUFFER_POOL; n++) {
+        ftp_pool[n] = malloc(ftp_buff_size);
+        if (ftp_pool[n] == NULL) {
+            ftpserver_deinit();
+            return false;
+        }
+    }
+
+#if FTPSERVER_DOUBLE_BUFFER
+    if (ftp_prefetch_queue == NULL) {
+        esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+        esp_vfs_eventfd_register(&config); // ESP_ERR_INVALID_STATE if another component did it already
+        ftp_wake_fd = eventfd(0, 0);
+        ftp_prefetch_queue = xQueueCreate(FTPSERVER_CMD_CLIENTS_MAX, sizeof(ftp_data_t*));
+        if (ftp_wake_fd < 0 || ftp_prefetch_queue == NULL || xTaskCreate(ftp_prefetch_task, "ftp_prefetch", 1024 * 3, NULL, 2, NULL) != pdPASS) {
+            ESP_LOGE(FTP_TAG, "Can't start the prefetch task");
+            ftpserver_deinit();
+            return false;
+        }
+    }
+#endif
+
+    ftp_server.lc_sd = -1;
+    ftp_server.state = E_FTP_STE_DISABLED;
+
+    return true;
+}
+
+int ftpserver_run(uint32_t timeout_ms) {
+    static uint64_t time_ms = 0;
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    fd_set rfds, wfds;
+    int32_t maxfd = -1;
+
+    if (ftp_stop)
+        return -2;
+
+    switch (ftp_server.state) {
+        case E_FTP_STE_DISABLED:
+            // Check if the ftp service has been enabled
+            if (ftp_server.enabled)
+                ftp_server.state = E_FTP_STE_START;
+            vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+            return 0;
+        case E_FTP_STE_START:
+            if (ftp_create_listening_socket(&ftp_server.lc_sd, FTPSERVER_CMD_PORT, FTPSERVER_CMD_CLIENTS_MAX)) {
+                ftp_server.state = E_FTP_STE_READY;
+                time_ms = mp_hal_ticks_ms();
+            } else {
+                vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+                return 0;
+            }
+            break;
+        default:
+            break;
+    }
+
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+    fd_add(ftp_server.lc_sd, &rfds, &maxfd);
+    for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++) {
+        ftp_data_t *ftp = &ftp_sessions[n];
+
+        if (ftp->c_sd < 0)
+            continue;
+
+        if (ftp->state == E_FTP_STE_READY && ftp->substate != E_FTP_STE_SUB_LISTEN_FOR_DATA)
+            fd_add(ftp->c_sd, &rfds, &maxfd);
+        if (ftp->substate == E_FTP_STE_SUB_LISTEN_FOR_DATA)
+            fd_add(ftp->ld_sd, &rfds, &maxfd);
+        if (ftp->state == E_FTP_STE_CONTINUE_LISTING)
+            fd_add(ftp->d_sd, &wfds, &maxfd);
+        if (ftp->state == E_FTP_STE_CONTINUE_FILE_TX) {
+            // an empty buffer waits for the reader task, not for the socket
+            if (ftp->d_len == 0 && ftp->pf_state == E_FTP_PREFETCH_BUSY)
+                continue;
+            if (ftp->d_len == 0)
+                tv.tv_sec = tv.tv_usec = 0;
+            else
+                fd_add(ftp->d_sd, &wfds, &maxfd);
+        }
+        if (ftp->state == E_FTP_STE_CONTINUE_FILE_RX)
+            fd_add(ftp->d_sd, &rfds, &maxfd);
+        // pending state changes are handled without waiting
+        if (ftp->state == E_FTP_STE_END_TRANSFER)
+            tv.tv_sec = tv.tv_usec = 0;
+    }
+
+#if FTPSERVER_DOUBLE_BUFFER
+    fd_add(ftp_wake_fd, &rfds, &maxfd);
+#endif
+
+    if (select(maxfd + 1, &rfds, &wfds, NULL, &tv) < 0) {
+        ESP_LOGW(FTP_TAG, "select error (%d)", errno);
+        _ftp_reset();
+        return 0;
+    }
+
+    uint32_t elapsed = mp_hal_ticks_ms() - time_ms;
+    time_ms += elapsed;
+
+#if FTPSERVER_DOUBLE_BUFFER
+    if (FD_ISSET(ftp_wake_fd, &rfds)) {
+        uint64_t wake;
+        read(ftp_wake_fd, &wake, sizeof(wake));
+    }
+#endif
+
+    for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++)
+        if (ftp_sessions[n].c_sd >= 0)
+            ftp_session_run(&ftp_sessions[n], elapsed, &rfds, &wfds);
+
+    if (ftp_server.lc_sd >= 0 && FD_ISSET(ftp_server.lc_sd, &rfds))
+        ftp_accept();
 
     return 0;
 }
 
 bool ftpserver_enable(void) {
     bool res = false;
-    if (ftp_data.state == E_FTP_STE_DISABLED) {
-        ftp_data.enabled = true;
+    if (ftp_server.state == E_FTP_STE_DISABLED) {
+        ftp_server.enabled = true;
         res = true;
     }
     return res;
 }
 
 bool ftpserver_isenabled(void) {
-    bool res = (ftp_data.enabled == true);
+    bool res = (ftp_server.enabled == true);
     return res;
 }
 
 bool ftpserver_disable(void) {
     bool res = false;
-    if (ftp_data.state == E_FTP_STE_READY) {
+    if (ftp_server.state == E_FTP_STE_READY) {
         _ftp_reset();
-        ftp_data.enabled = false;
-        ftp_data.state = E_FTP_STE_DISABLED;
+        ftp_server.enabled = false;
+        ftp_server.state = E_FTP_STE_DISABLED;
         res = true;
     }
     return res;
@@ -1209,15 +1504,18 @@ bool ftpserver_reset(void) {
 }
 
 int ftpserver_getstate() {
-    int fstate = ftp_data.state | (ftp_data.substate << 8);
-    if ((ftp_data.state == E_FTP_STE_READY) && (ftp_data.c_sd > 0))
-        fstate = E_FTP_STE_CONNECTED;
+    int fstate = ftp_server.state;
+    if (ftp_server.state == E_FTP_STE_READY) {
+        for (int n = 0; n < FTPSERVER_CMD_CLIENTS_MAX; n++)
+            if (ftp_sessions[n].c_sd >= 0)
+                fstate = E_FTP_STE_CONNECTED;
+    }
     return fstate;
 }
 
 bool ftpserver_terminate(void) {
     bool res = false;
-    if (ftp_data.state == E_FTP_STE_READY) {
+    if (ftp_server.state == E_FTP_STE_READY) {
         ftp_stop = 1;
         _ftp_reset();
         res = true;
@@ -1233,7 +1531,6 @@ bool ftpserver_stop_requested(void) {
 ////////////////////////////////////////////////////////////////
 
 static void ftp_task(void *pvParameters) {
-    uint64_t elapsed, time_ms = mp_hal_ticks_ms();
     // Initialize ftp, create rx buffer and mutex
     if (!ftpserver_init()) {
         ESP_LOGE(FTP_TAG, "Init Error");
@@ -1243,13 +1540,9 @@ static void ftp_task(void *pvParameters) {
     // We have network connection, enable ftp
     ftpserver_enable();
 
-    time_ms = mp_hal_ticks_ms();
     while (1) {
-        // Calculate time between two ftp_run() calls
-        elapsed = mp_hal_ticks_ms() - time_ms;
-        time_ms = mp_hal_ticks_ms();
-
-        int res = ftpserver_run(elapsed);
+        // blocks in select() until a socket is ready or the timeout expires
+        int res = ftpserver_run(FTPSERVER_SELECT_TIMEOUT_MS);
         if (res < 0) {
             if (res == -1) {
                 ESP_LOGE(FTP_TAG, "\nRun Error");
@@ -1257,9 +1550,6 @@ static void ftp_task(void *pvParameters) {
             // -2 is returned if Ftp stop was requested by user
             break;
         }
-
-        vTaskDelay(1);
-
     }
 
     ESP_LOGW(FTP_TAG, "\nTask terminated!");
@@ -1282,3 +1572,7 @@ void ftpserver_start(const char *_ftp_user, const char *_ftp_password, const cha
             NULL         //
             );
 }
+
+void ftpserver_set_upload_cb(ftpserver_upload_cb_t cb) {
+    ftp_upload_cb = cb;
+}
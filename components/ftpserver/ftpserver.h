@@ -31,6 +31,7 @@
 #define FTPSERVER_H_
 
 #include <dirent.h>
+#include <stdio.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
@@ -106,6 +107,29 @@ typedef enum {
     E_FTP_CLOSE_CMD_AND_DATA, /**< E_FTP_CLOSE_CMD_AND_DATA */
 } ftp_e_closesocket_t;
 
+/**
+ * @enum
+ * @brief Directory listing format
+ *
+ */
+typedef enum {
+    E_FTP_LIST_LONG = 0, /**< LIST, "ls -l" style */
+    E_FTP_LIST_NAMES,    /**< NLST, names only */
+    E_FTP_LIST_MLSD      /**< MLSD, RFC 3659 facts */
+} ftp_list_format_t;
+
+/**
+ * @enum
+ * @brief Read ahead state of a double buffered transfer
+ *
+ */
+typedef enum {
+    E_FTP_PREFETCH_IDLE = 0, /**< nothing requested */
+    E_FTP_PREFETCH_BUSY,     /**< the reader task is filling the idle buffer */
+    E_FTP_PREFETCH_READY,    /**< idle buffer filled */
+    E_FTP_PREFETCH_FAILED    /**< read error */
+} ftp_prefetch_t;
+
 /**
  * @enum
  * @brief
@@ -138,27 +162,39 @@ typedef enum {
     E_FTP_CMD_APPE,               /**< E_FTP_CMD_APPE */
     E_FTP_CMD_NLST,               /**< E_FTP_CMD_NLST */
     E_FTP_CMD_AUTH,               /**< E_FTP_CMD_AUTH */
+    E_FTP_CMD_REST,               /**< E_FTP_CMD_REST */
+    E_FTP_CMD_MLSD,               /**< E_FTP_CMD_MLSD */
     E_FTP_NUM_FTP_CMDS            /**< E_FTP_NUM_FTP_CMDS */
 } ftp_cmd_index_t;                /**<  */
 
 /**
  * @struct ftp_data_s
- * @brief
+ * @brief Per session state
  *
  */
 typedef struct ftp_data_s {
-     uint8_t *dBuffer;          /**<  */
+     uint8_t *dBuffer;          /**< reply and rename buffer */
+     uint8_t *buf[2];           /**< transfer buffers taken from the pool while a transfer runs */
+        char *path;             /**< working directory */
+        char *scratch;          /**< command parameter */
+        char *cmd_buffer;       /**< command and reply buffer */
     uint32_t ctimeout;          /**<  */
     union {
          DIR *dp;               /**<  */
         FILE *fp;               /**<  */
     };
-         int32_t lc_sd;         /**<  */
-         int32_t ld_sd;         /**<  */
-         int32_t c_sd;          /**<  */
-         int32_t d_sd;          /**<  */
+         int32_t ld_sd;         /**< passive data listening socket */
+         int32_t c_sd;          /**< command socket, -1 if the session is free */
+         int32_t d_sd;          /**< data socket */
          int32_t dtimeout;      /**<  */
         uint32_t ip_addr;       /**<  */
+        uint32_t d_len;         /**< bytes in buf[buf_tx] */
+        uint32_t d_off;         /**< bytes of buf[buf_tx] already sent */
+        uint32_t pf_len;        /**< bytes read ahead in buf[buf_tx ^ 1] */
+volatile uint8_t pf_state;      /**< ftp_prefetch_t */
+            bool pf_eof;        /**< the read ahead reached the end of file */
+         uint8_t buf_tx;        /**< buffer being sent */
+         uint8_t id;            /**< session index, selects the passive data port */
          uint8_t state;         /**<  */
          uint8_t substate;      /**<  */
          uint8_t txRetries;     /**<  */
@@ -166,12 +202,31 @@ typedef struct ftp_data_s {
     ftp_loggin_t loggin;        /**<  */
          uint8_t e_open;        /**<  */
             bool closechild;    /**<  */
-            bool enabled;       /**<  */
             bool listroot;      /**<  */
+         uint8_t list_fmt;      /**< ftp_list_format_t */
+        uint32_t rest;          /**< REST offset for the next RETR/STOR */
+            char *upload;       /**< path of the file being stored, reported to the upload callback */
         uint32_t total;         /**<  */
         uint32_t time;          /**<  */
 } ftp_data_t;                   /**<  */
 
+/**
+ * @struct ftp_server_s
+ * @brief Listening socket and service state shared by all sessions
+ *
+ */
+typedef struct ftp_server_s {
+    int32_t lc_sd;   /**< command listening socket */
+    uint8_t state;   /**<  */
+       bool enabled; /**<  */
+} ftp_server_t;      /**<  */
+
+/**
+ * @brief Called from the ftp task when a STOR/APPE completes, path is relative to the mount point
+ *
+ */
+typedef void (*ftpserver_upload_cb_t)(const char *path);
+
 /**
  * @struct
  * @brief
@@ -185,7 +240,7 @@ typedef struct ftp_cmd_s {
 
    bool ftpserver_init(void);
    void ftpserver_deinit(void);
-    int ftpserver_run(uint32_t elapsed);
+    int ftpserver_run(uint32_t timeout_ms);
    bool ftpserver_enable(void);
    bool ftpserver_isenabled(void);
    bool ftpserver_disable(void);
@@ -195,5 +250,6 @@ typedef struct ftp_cmd_s {
    bool ftpserver_stop_requested();
 int32_t ftpserver_get_maxstack(void);
    void ftpserver_start(const char *_ftp_user, const char *_ftp_password, const char *mount_point);
+   void ftpserver_set_upload_cb(ftpserver_upload_cb_t cb);
 
 #endif /* FTPSERVER_H_ */
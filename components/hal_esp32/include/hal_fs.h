@@ -30,11 +30,19 @@
 #ifndef HAL_FS_H_
 #define HAL_FS_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#ifndef MOUNT_POINT
 #define MOUNT_POINT           "/littlefs"
+#endif
 #define PARTITION_LABEL       "littlefs"
 
+#define FS_ASYNC_QUEUE_MAX    16    // pending requests
+#define FS_ASYNC_PATH_MAX     64    // file name, relative to the mount point
+#define FS_ASYNC_COALESCE_MAX 16384 // appends to the same file are merged up to this size
+
 #define fs_init()             littlefs_init()
 #define fs_open(FN, OT)       littlefs_fopen(FN, OT)
 #define fs_reopen(FN, OT, ST) littlefs_freopen(FN, OT, ST)
@@ -42,6 +50,28 @@
 #define fs_rename(ON, NN)     littlefs_rename(ON, NN)
 #define fs_ls()               littlefs_ls()
 
+#define fs_write_async(FN, D, L, P, CB, A)  littlefs_async_write(FN, D, L, P, CB, A)
+#define fs_append_async(FN, D, L, P, CB, A) littlefs_async_append(FN, D, L, P, CB, A)
+#define fs_remove_async(FN, P, CB, A)       littlefs_async_remove(FN, P, CB, A)
+#define fs_sync(MS)                         littlefs_async_sync(MS)
+
+/**
+ * @enum fs_async_prio_t
+ * @brief Asynchronous request priority
+ *
+ */
+typedef enum FS_ASYNC_PRIO {
+    FS_ASYNC_HIGH,   // program and retentive data
+    FS_ASYNC_NORMAL, // status files
+    FS_ASYNC_LOW,    // logs
+} fs_async_prio_t;
+
+/**
+ * @brief Asynchronous request completion, called from the storage task
+ *
+ */
+typedef void (*fs_async_cb_t)(const char *file, int result, void *arg);
+
   int littlefs_init(void);
  void littlefs_deinit(void);
 FILE* littlefs_fopen(const char *file, const char *mode);
@@ -51,4 +81,17 @@ FILE* littlefs_freopen(const char *filename, const char *opentype, FILE *stream)
   int littlefs_rename(const char *file, char *newname);
   int littlefs_ls(void);
 
+/*
+ * Write-behind storage service: requests are queued and done by a low priority task so callers never wait on flash
+ * erases. Pending writes of a whole file are replaced by newer ones and appends to the same file are merged, in both
+ * cases only when the callback and its argument are the same. Requests on the same file keep their order.
+ * "data" must be allocated with malloc, the service owns it from the call (also on error).
+ * The callback result is 0 or -1.
+ */
+  int littlefs_async_init(void);
+  int littlefs_async_write(const char *file, char *data, size_t len, fs_async_prio_t prio, fs_async_cb_t cb, void *arg);
+  int littlefs_async_append(const char *file, char *data, size_t len, fs_async_prio_t prio, fs_async_cb_t cb, void *arg);
+  int littlefs_async_remove(const char *file, fs_async_prio_t prio, fs_async_cb_t cb, void *arg);
+  int littlefs_async_sync(uint32_t timeout_ms);
+
 #endif /* HAL_FS_H_ */
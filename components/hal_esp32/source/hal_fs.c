@@ -74,6 +74,10 @@ int littlefs_init(void) {
         ESP_LOGI(TAG, "Partition size: total: %d, used: %d", total, used);
     }
     littlefs_initialized = true;
+
+    if (littlefs_async_init() != ESP_OK)
+        ESP_LOGE(TAG, "Failed to start the storage task");
+
     return ESP_OK;
 }
 
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "hal_fs.h"
+
+static const char *TAG = "hal_fs_async";
+
+typedef enum FS_ASYNC_OP {
+    FS_ASYNC_OP_WRITE,  // whole file, through a temporary file and rename
+    FS_ASYNC_OP_APPEND, //
+    FS_ASYNC_OP_REMOVE, //
+} fs_async_op_t;
+
+typedef struct fs_async_req_s {
+    fs_async_op_t op;              //
+    fs_async_prio_t prio;          //
+    char file[FS_ASYNC_PATH_MAX];  //
+    char *data;                    //
+    size_t len;                    //
+    fs_async_cb_t cb;              //
+    void *arg;                     //
+    int64_t queued;                // us, for the slow request log
+    struct fs_async_req_s *next;   //
+} fs_async_req_t;
+
+static fs_async_req_t *pending = NULL; // FIFO, the highest priority request is taken first
+static uint32_t pending_qty = 0;
+static volatile bool busy = false;
+static SemaphoreHandle_t async_mutex = NULL;
+static TaskHandle_t async_task = NULL;
+
+static int async_write(const char *route, const char *data, size_t len, const char *mode) {
+    FILE *fp = fopen(route, mode);
+    if (fp == NULL)
+        return -1;
+
+    int ret = (fwrite(data, 1, len, fp) == len && fflush(fp) == 0 && fsync(fileno(fp)) == 0) ? 0 : -1;
+    if (fclose(fp) != 0)
+        ret = -1;
+
+    return ret;
+}
+
+static int async_do(fs_async_req_t *req) {
+    char route[FS_ASYNC_PATH_MAX + sizeof(MOUNT_POINT) + 8];
+    char route_tmp[sizeof(route)];
+
+    snprintf(route, sizeof(route), "%s/%s", MOUNT_POINT, req->file);
+
+    switch (req->op) {
+        case FS_ASYNC_OP_WRITE:
+            // a reset in the middle leaves the previous file untouched
+            snprintf(route_tmp, sizeof(route_tmp), "%s.tmp", route);
+            if (async_write(route_tmp, req->data, req->len, "w") != 0) {
+                unlink(route_tmp);
+                return -1;
+            }
+            return rename(route_tmp, route) == 0 ? 0 : -1;
+
+        case FS_ASYNC_OP_APPEND:
+            return async_write(route, req->data, req->len, "a");
+
+        case FS_ASYNC_OP_REMOVE:
+            return (unlink(route) == 0 || errno == ENOENT) ? 0 : -1;
+    }
+
+    return -1;
+}
+
+static fs_async_req_t *async_take(void) {
+    fs_async_req_t **best = NULL;
+
+    xSemaphoreTake(async_mutex, portMAX_DELAY);
+    for (fs_async_req_t **r = &pending; *r != NULL; r = &(*r)->next)
+        if (best == NULL || (*r)->prio < (*best)->prio)
+            best = r;
+
+    fs_async_req_t *req = NULL;
+    if (best != NULL) {
+        req = *best;
+        *best = req->next;
+        pending_qty--;
+        busy = true;
+    }
+    xSemaphoreGive(async_mutex);
+
+    return req;
+}
+
+static void async_storage_task(void *arg) {
+    fs_async_req_t *req;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while ((req = async_take()) != NULL) {
+            int result = async_do(req);
+            int64_t ms = (esp_timer_get_time() - req->queued) / 1000;
+
+            if (result != 0)
+                ESP_LOGE(TAG, "ERROR %s (%d)", req->file, errno);
+            else if (ms > 1000)
+                ESP_LOGW(TAG, "%s: %u bytes, %lld ms since queued", req->file, (unsigned)req->len, ms);
+
+            if (req->cb != NULL)
+                req->cb(req->file, result, req->arg);
+            free(req->data);
+            free(req);
+            busy = false;
+        }
+    }
+}
+
+static int async_queue(fs_async_op_t op, const char *file, char *data, size_t len, fs_async_prio_t prio, fs_async_cb_t cb, void *arg) {
+    fs_async_req_t *last = NULL;
+
+    if (async_task == NULL || file == NULL || strlen(file) >= FS_ASYNC_PATH_MAX) {
+        free(data);
+        return -1;
+    }
+
+    xSemaphoreTake(async_mutex, portMAX_DELAY);
+
+    // coalescing only with the last pending request on the file, so the order on the file is kept
+    for (fs_async_req_t *r = pending; r != NULL; r = r->next)
+        if (strcmp(r->file, file) == 0)
+            last = r;
+
+    if (last != NULL && last->op == op && last->cb == cb && last->arg == arg) {
+        if (op == FS_ASYNC_OP_WRITE) {
+            free(last->data);
+            last->data = data;
+            last->len = len;
+            goto coalesced;
+        }
+
+        if (op == FS_ASYNC_OP_APPEND && last->len + len <= FS_ASYNC_COALESCE_MAX) {
+            char *merged = realloc(last->data, last->len + len);
+            if (merged != NULL) {
+                memcpy(merged + last->len, data, len);
+                last->data = merged;
+                last->len += len;
+                free(data);
+                goto coalesced;
+            }
+        }
+    }
+
+    if (pending_qty >= FS_ASYNC_QUEUE_MAX)
+        goto full;
+
+    fs_async_req_t *req = calloc(1, sizeof(fs_async_req_t));
+    if (req == NULL)
+        goto full;
+
+    req->op = op;
+    req->prio = prio;
+    strcpy(req->file, file);
+    req->data = data;
+    req->len = len;
+    req->cb = cb;
+    req->arg = arg;
+    req->queued = esp_timer_get_time();
+
+    fs_async_req_t **tail = &pending;
+    while (*tail != NULL) {
+        // earlier requests on the file can't be overtaken
+        if (strcmp((*tail)->file, file) == 0 && (*tail)->prio > prio)
+            (*tail)->prio = prio;
+        tail = &(*tail)->next;
+    }
+    *tail = req;
+    pending_qty++;
+
+    xSemaphoreGive(async_mutex);
+    xTaskNotifyGive(async_task);
+    return 0;
+
+coalesced:
+    if (prio < last->prio)
+        for (fs_async_req_t *r = pending; r != NULL; r = r->next)
+            if (strcmp(r->file, file) == 0 && r->prio > prio)
+                r->prio = prio;
+    xSemaphoreGive(async_mutex);
+    return 0;
+
+full:
+    xSemaphoreGive(async_mutex);
+    ESP_LOGE(TAG, "ERROR queue full (%s)", file);
+    free(data);
+    return -1;
+}
+
+int littlefs_async_init(void) {
+    if (async_task != NULL)
+        return ESP_OK;
+
+    async_mutex = xSemaphoreCreateMutex();
+    if (async_mutex == NULL)
+        return ESP_FAIL;
+
+    if (xTaskCreate(async_storage_task, "fs_async", 4096, NULL, 2, &async_task) != pdPASS) {
+        async_task = NULL;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+int littlefs_async_write(const char *file, char *data, size_t len, fs_async_prio_t prio, fs_async_cb_t cb, void *arg) {
+    return async_queue(FS_ASYNC_OP_WRITE, file, data, len, prio, cb, arg);
+}
+
+int littlefs_async_append(const char *file, char *data, size_t len, fs_async_prio_t prio, fs_async_cb_t cb, void *arg) {
+    return async_queue(FS_ASYNC_OP_APPEND, file, data, len, prio, cb, arg);
+}
+
+int littlefs_async_remove(const char *file, fs_async_prio_t prio, fs_async_cb_t cb, void *arg) {
+    return async_queue(FS_ASYNC_OP_REMOVE, file, NULL, 0, prio, cb, arg);
+}
+
+int littlefs_async_sync(uint32_t timeout_ms) {
+    int64_t end = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+
+    if (async_task == NULL)
+        return ESP_OK;
+
+    while (pending_qty > 0 || busy) {
+        if (esp_timer_get_time() >= end)
+            return ESP_ERR_TIMEOUT;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "driver/gpio.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+#include "soc/soc_caps.h"
+
+#include "ladder.h"
+#include "ladder_adc.h"
+#include "ladder_warm.h"
+#include "ladderlib_esp32_gpio.h"
+
+static const char *TAG = "ladder_adc";
+
+#define ADC_TASK_STACK 3072 //
+#define ADC_TASK_PRIO  5    // below the scan, which runs on the other core
+#define ADC_TASK_CORE  0    //
+
+typedef struct adc_input_s {
+    int8_t hw_channel;        // adc_channel_t, -1 without a pin
+    ladder_adc_input_t state; //
+} adc_input_t;
+
+static ladder_adc_config_t adc_config;
+static adc_input_t adc_ch[LADDER_ADC_CHANNELS];
+static int8_t adc_map[16]; // hardware channel to adc_ch
+static adc_continuous_handle_t adc_handle = NULL;
+static TaskHandle_t adc_task_handle = NULL;
+static ladder_adc_stats_t adc_stats;
+
+static const uint32_t adc_pins[LADDER_ADC_CHANNELS] = {
+#ifdef ADC_01
+    ADC_01, //
+#else
+    0, //
+#endif
+#ifdef ADC_02
+    ADC_02, //
+#else
+    0, //
+#endif
+};
+
+static void adc_frame(const uint8_t *buf, uint32_t len) {
+    uint32_t samples = len / SOC_ADC_DIGI_RESULT_BYTES;
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+
+    for (uint32_t n = 0; n < samples; n++) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&buf[n * SOC_ADC_DIGI_RESULT_BYTES];
+        int8_t ch = adc_map[p->type1.channel];
+        if (ch >= 0)
+            ladder_adc_filter_sample(&adc_ch[ch].state, &adc_config, &adc_config.channel[ch], p->type1.data);
+    }
+
+    if (samples > 0) {
+        adc_stats.cycles_per_sample = (esp_cpu_get_cycle_count() - start) / samples;
+        adc_stats.samples += samples;
+    }
+    adc_stats.frames++;
+}
+
+static bool adc_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *arg) {
+    adc_stats.overruns++;
+    return false;
+}
+
+static void adc_task(void *arg) {
+    uint8_t buf[LADDER_ADC_FRAME_BYTES];
+    uint32_t len;
+
+    for (;;) {
+        if (adc_continuous_read(adc_handle, buf, sizeof(buf), &len, 100) == ESP_OK)
+            adc_frame(buf, len);
+    }
+}
+
+// synthetic source: the same frames the DMA delivers, a triangle of 1 s on channel 0 and a noisy mid-scale on channel 1
+static void adc_sim_task(void *arg) {
+    uint8_t buf[LADDER_ADC_FRAME_BYTES];
+    uint32_t per_tick = adc_config.sample_hz * LADDER_ADC_SIM_MS / 1000;
+    ladder_adc_sim_t sim;
+    TickType_t wake = xTaskGetTickCount();
+
+    ladder_adc_sim_init(&sim, adc_config.sample_hz);
+
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(LADDER_ADC_SIM_MS));
+
+        for (uint32_t done = 0; done < per_tick;) {
+            uint32_t len = 0;
+            for (; len + SOC_ADC_DIGI_RESULT_BYTES <= sizeof(buf) && done < per_tick; done++, len += SOC_ADC_DIGI_RESULT_BYTES) {
+                adc_digi_output_data_t *p = (adc_digi_output_data_t *)&buf[len];
+                uint32_t channel;
+
+                p->val = 0;
+                p->type1.data = ladder_adc_sim_sample(&sim, &channel);
+                p->type1.channel = adc_ch[channel].hw_channel;
+            }
+            adc_frame(buf, len);
+        }
+    }
+}
+
+static bool adc_hw_start(void) {
+    adc_digi_pattern_config_t pattern[LADDER_ADC_CHANNELS];
+    uint32_t pattern_num = 0;
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = 4 * LADDER_ADC_FRAME_BYTES, //
+        .conv_frame_size = LADDER_ADC_FRAME_BYTES,        //
+    };
+    if (adc_continuous_new_handle(&handle_cfg, &adc_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "ERROR adc handle");
+        return false;
+    }
+
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS; n++) {
+        if (adc_ch[n].hw_channel < 0)
+            continue;
+        pattern[pattern_num].atten = adc_config.channel[n].atten;
+        pattern[pattern_num].channel = adc_ch[n].hw_channel;
+        pattern[pattern_num].unit = ADC_UNIT_1;
+        pattern[pattern_num].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        pattern_num++;
+    }
+
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = pattern_num,             //
+        .adc_pattern = pattern,                 //
+        .sample_freq_hz = adc_config.sample_hz, //
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,    //
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1, //
+    };
+    adc_continuous_evt_cbs_t cbs = {
+        .on_pool_ovf = adc_pool_ovf, //
+    };
+    if (adc_continuous_config(adc_handle, &dig_cfg) != ESP_OK || adc_continuous_register_event_callbacks(adc_handle, &cbs, NULL) != ESP_OK ||
+        adc_continuous_start(adc_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "ERROR adc config");
+        return false;
+    }
+
+    return true;
+}
+
+void ladder_adc_default(ladder_adc_config_t *config) {
+    memset(config, 0, sizeof(ladder_adc_config_t));
+    config->source = LADDER_ADC_HW;
+    config->sample_hz = 20000;
+    config->oversample = 16;
+    config->filter = LADDER_ADC_FILTER_AVG;
+    config->window = 8;
+    config->iir_shift = 3;
+    // I6/I7 stay digital inputs until adc.json lists their channels
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS; n++) {
+        config->channel[n].enabled = false;
+        config->channel[n].atten = ADC_ATTEN_DB_12;
+    }
+}
+
+static int json_int(cJSON *object, const char *name, int def) {
+    cJSON *item = cJSON_GetObjectItem(object, name);
+    return cJSON_IsNumber(item) ? item->valueint : def;
+}
+
+// nearest attenuation not below the requested one
+static uint8_t adc_atten(double db) {
+    if (db > 6)
+        return ADC_ATTEN_DB_12;
+    if (db > 2.5)
+        return ADC_ATTEN_DB_6;
+    if (db > 0)
+        return ADC_ATTEN_DB_2_5;
+    return ADC_ATTEN_DB_0;
+}
+
+bool ladder_adc_load(const char *file, ladder_adc_config_t *config) {
+    static const char *filters[] = {
+        "none", //
+        "avg",  //
+        "iir",  //
+    };
+    cJSON *item;
+    const char *str;
+    uint32_t n = 0;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return false;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return false;
+    }
+
+    str = cJSON_GetStringValue(cJSON_GetObjectItem(root, "source"));
+    if (str != NULL)
+        config->source = strcmp(str, "sim") == 0 ? LADDER_ADC_SIM : LADDER_ADC_HW;
+    str = cJSON_GetStringValue(cJSON_GetObjectItem(root, "filter"));
+    for (uint32_t f = 0; str != NULL && f < sizeof(filters) / sizeof(filters[0]); f++)
+        if (strcmp(str, filters[f]) == 0)
+            config->filter = f;
+    config->sample_hz = json_int(root, "sample_hz", config->sample_hz);
+    config->oversample = json_int(root, "oversample", config->oversample);
+    config->window = json_int(root, "window", config->window);
+    config->iir_shift = json_int(root, "iir_shift", config->iir_shift);
+
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "channels")) {
+        if (n >= LADDER_ADC_CHANNELS)
+            break;
+        ladder_adc_channel_t *channel = &config->channel[n++];
+        cJSON *atten = cJSON_GetObjectItem(item, "atten_db");
+
+        // a listed channel is sampled unless "enabled" is false
+        channel->enabled = !cJSON_IsFalse(cJSON_GetObjectItem(item, "enabled"));
+        if (cJSON_IsNumber(atten))
+            channel->atten = adc_atten(atten->valuedouble);
+        channel->raw_min = json_int(item, "raw_min", channel->raw_min);
+        channel->raw_max = json_int(item, "raw_max", channel->raw_max);
+        channel->eng_min = json_int(item, "eng_min", channel->eng_min);
+        channel->eng_max = json_int(item, "eng_max", channel->eng_max);
+    }
+
+    cJSON_Delete(root);
+    return true;
+}
+
+bool ladder_adc_start(const ladder_adc_config_t *config) {
+    BaseType_t res;
+
+    if (adc_task_handle != NULL)
+        return true;
+
+    ladder_warm_config_add(LADDER_WARM_CONFIG_ADC, 0, config, sizeof(ladder_adc_config_t));
+    memcpy(&adc_config, config, sizeof(ladder_adc_config_t));
+    ladder_adc_filter_limits(&adc_config);
+    if (adc_config.sample_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW)
+        adc_config.sample_hz = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+    if (adc_config.sample_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH)
+        adc_config.sample_hz = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+
+    memset(adc_ch, 0, sizeof(adc_ch));
+    memset(adc_map, -1, sizeof(adc_map));
+    memset(&adc_stats, 0, sizeof(adc_stats));
+
+    uint32_t enabled = 0;
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS; n++) {
+        adc_unit_t unit;
+        adc_channel_t channel;
+
+        adc_ch[n].hw_channel = -1;
+        if (!adc_config.channel[n].enabled || adc_pins[n] == 0)
+            continue;
+        if (adc_continuous_io_to_channel(adc_pins[n], &unit, &channel) != ESP_OK || unit != ADC_UNIT_1) {
+            ESP_LOGE(TAG, "ERROR gpio %" PRIu32 " is not an ADC1 pin", adc_pins[n]);
+            continue;
+        }
+        adc_ch[n].hw_channel = channel;
+        adc_map[channel] = n;
+        enabled++;
+    }
+    if (enabled == 0)
+        return true;
+
+    if (adc_config.source == LADDER_ADC_HW && !adc_hw_start())
+        return false;
+
+    res = xTaskCreatePinnedToCore(adc_config.source == LADDER_ADC_SIM ? adc_sim_task : adc_task, "adc", ADC_TASK_STACK, NULL, ADC_TASK_PRIO, &adc_task_handle,
+                                  ADC_TASK_CORE);
+    if (res != pdPASS) {
+        ESP_LOGE(TAG, "ERROR adc task");
+        return false;
+    }
+
+    adc_stats.running = true;
+    ESP_LOGI(TAG, "%" PRIu32 " channels, %s, %" PRIu32 " Hz, oversample %u", enabled, adc_config.source == LADDER_ADC_SIM ? "sim" : "dma", adc_config.sample_hz,
+             adc_config.oversample);
+    return true;
+}
+
+bool ladder_adc_owns(uint32_t input) {
+    if (adc_handle == NULL || input >= LOCAL_INPUTS)
+        return false;
+
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS; n++)
+        if (adc_ch[n].hw_channel >= 0 && adc_pins[n] == inputs[input])
+            return true;
+
+    return false;
+}
+
+void ladder_adc_read(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    if (!adc_stats.running)
+        return;
+
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS && n < (*ladder_ctx).input[id].iw_qty; n++)
+        if (adc_ch[n].hw_channel >= 0)
+            (*ladder_ctx).input[id].IW[n] = __atomic_load_n(&adc_ch[n].state.value, __ATOMIC_RELAXED);
+}
+
+void ladder_adc_stats(ladder_adc_stats_t *stats) {
+    memcpy(stats, &adc_stats, sizeof(ladder_adc_stats_t));
+    for (uint32_t n = 0; n < LADDER_ADC_CHANNELS; n++) {
+        stats->raw[n] = __atomic_load_n(&adc_ch[n].state.raw, __ATOMIC_RELAXED);
+        stats->value[n] = __atomic_load_n(&adc_ch[n].state.value, __ATOMIC_RELAXED);
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_ADC_H_
+#define LADDER_ADC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "ladder_adc_filter.h"
+
+#define LADDER_ADC_FRAME_BYTES 256        // DMA conversion frame
+#define LADDER_ADC_SIM_MS      10         // synthetic samples are generated at this period
+#define LADDER_ADC_CONFIG      "adc.json" // configuration loaded at boot
+
+/**
+ * @struct ladder_adc_stats_s
+ * @brief Sampling counters
+ *
+ */
+typedef struct ladder_adc_stats_s {
+    bool running;                       //
+    uint32_t samples;                   // raw samples processed
+    uint32_t frames;                    // conversion frames read
+    uint32_t overruns;                  // frames lost, the driver pool was full
+    uint32_t cycles_per_sample;         // CPU cycles spent per raw sample, averaged over the last frame
+    int32_t raw[LADDER_ADC_CHANNELS];   // last oversampled value
+    int32_t value[LADDER_ADC_CHANNELS]; // published value
+} ladder_adc_stats_t;
+
+/**
+ * @fn void ladder_adc_default(ladder_adc_config_t*)
+ * @brief No channel sampled (I6/I7 are digital inputs), 12 dB, raw counts published, 20 kHz, 16 times oversampling,
+ *        moving average of 8
+ *
+ * @param config Configuration
+ */
+void ladder_adc_default(ladder_adc_config_t *config);
+
+/**
+ * @fn bool ladder_adc_load(const char*, ladder_adc_config_t*)
+ * @brief Read a configuration file, members not in the file keep their values. Sampling is opt-in: a channel is
+ *        enabled by its "channels" entry, unless "enabled" is false. Without the file nothing is sampled.
+ *
+ *        {"source":"hw"|"sim","sample_hz":20000,"oversample":16,"filter":"avg"|"iir"|"none","window":8,"iir_shift":3,
+ *         "channels":[{"atten_db":12,"raw_min":0,"raw_max":4095,"eng_min":0,"eng_max":10000},{"enabled":false}]}
+ *
+ * @param file File name, relative to the mount point
+ * @param config Configuration
+ * @return true if read
+ */
+bool ladder_adc_load(const char *file, ladder_adc_config_t *config);
+
+/**
+ * @fn bool ladder_adc_start(const ladder_adc_config_t*)
+ * @brief Start the sampling task, independent of the ladder state
+ *
+ * @param config Configuration, copied
+ * @return true if started
+ */
+bool ladder_adc_start(const ladder_adc_config_t *config);
+
+/**
+ * @fn bool ladder_adc_owns(uint32_t)
+ * @brief The input pin is converted by the ADC hardware, it can not be a counter input
+ *
+ * @param input inputs[] index
+ * @return true if sampled
+ */
+bool ladder_adc_owns(uint32_t input);
+
+/**
+ * @fn void ladder_adc_read(ladder_ctx_t*, uint32_t)
+ * @brief Scan read: the last published values into the module IW, never waits for a conversion
+ *
+ * @param ladder_ctx Ladder context
+ * @param id Local module
+ */
+void ladder_adc_read(ladder_ctx_t *ladder_ctx, uint32_t id);
+
+/**
+ * @fn void ladder_adc_stats(ladder_adc_stats_t*)
+ * @brief Counters
+ *
+ * @param stats Counters
+ */
+void ladder_adc_stats(ladder_adc_stats_t *stats);
+
+#endif /* LADDER_ADC_H_ */
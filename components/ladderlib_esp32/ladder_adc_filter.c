@@ -0,0 +1,114 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder_adc_filter.h"
+
+void ladder_adc_filter_limits(ladder_adc_config_t *config) {
+    if (config->oversample < 1)
+        config->oversample = 1;
+    if (config->oversample > LADDER_ADC_OVERSAMPLE)
+        config->oversample = LADDER_ADC_OVERSAMPLE;
+    if (config->window < 1)
+        config->window = 1;
+    if (config->window > LADDER_ADC_WINDOW_MAX)
+        config->window = LADDER_ADC_WINDOW_MAX;
+    if (config->iir_shift > 15)
+        config->iir_shift = 15;
+}
+
+bool ladder_adc_filter_sample(ladder_adc_input_t *input, const ladder_adc_config_t *config, const ladder_adc_channel_t *channel, int32_t sample) {
+    int32_t x, y;
+
+    input->acc += sample;
+    if (++input->acc_n < config->oversample)
+        return false;
+    x = (input->acc + input->acc_n / 2) / input->acc_n;
+    input->acc = 0;
+    input->acc_n = 0;
+
+    switch (config->filter) {
+        case LADDER_ADC_FILTER_AVG:
+            input->ring_sum += x - input->ring[input->ring_pos];
+            input->ring[input->ring_pos] = x;
+            input->ring_pos = (input->ring_pos + 1) % config->window;
+            if (input->ring_n < config->window)
+                input->ring_n++;
+            y = input->ring_sum / input->ring_n;
+            break;
+        case LADDER_ADC_FILTER_IIR:
+            if (!input->iir_init) {
+                input->iir = x << LADDER_ADC_IIR_FRAC;
+                input->iir_init = true;
+            } else
+                input->iir += ((x << LADDER_ADC_IIR_FRAC) - input->iir) >> config->iir_shift;
+            y = (input->iir + (1 << (LADDER_ADC_IIR_FRAC - 1))) >> LADDER_ADC_IIR_FRAC;
+            break;
+        default:
+            y = x;
+            break;
+    }
+
+    if (channel->raw_max != channel->raw_min)
+        y = channel->eng_min + (int32_t)((int64_t)(y - channel->raw_min) * (channel->eng_max - channel->eng_min) / (channel->raw_max - channel->raw_min));
+
+    __atomic_store_n(&input->raw, x, __ATOMIC_RELAXED);
+    __atomic_store_n(&input->value, y, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+void ladder_adc_sim_init(ladder_adc_sim_t *sim, uint32_t sample_hz) {
+    sim->period = sample_hz / LADDER_ADC_CHANNELS;
+    sim->phase = 0;
+    sim->lfsr = 0xace1;
+    sim->next = 0;
+}
+
+int32_t ladder_adc_sim_sample(ladder_adc_sim_t *sim, uint32_t *channel) {
+    uint32_t v;
+
+    if (sim->next == 0) {
+        v = (uint32_t)((uint64_t)sim->phase * 2 * LADDER_ADC_SIM_FULL / sim->period);
+        if (v > LADDER_ADC_SIM_FULL)
+            v = 2 * LADDER_ADC_SIM_FULL - v;
+        if (++sim->phase >= sim->period)
+            sim->phase = 0;
+    } else {
+        sim->lfsr = (sim->lfsr >> 1) ^ (-(sim->lfsr & 1u) & 0xb400u);
+        v = LADDER_ADC_SIM_FULL / 2 + (sim->lfsr & 0x7f) - 0x40;
+    }
+
+    *channel = sim->next;
+    sim->next = (sim->next + 1) % LADDER_ADC_CHANNELS;
+
+    return v;
+}
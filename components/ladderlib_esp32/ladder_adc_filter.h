@@ -0,0 +1,163 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_ADC_FILTER_H_
+#define LADDER_ADC_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LADDER_ADC_CHANNELS   2    // ADC_01 into IW[0], ADC_02 into IW[1] of the local module
+#define LADDER_ADC_WINDOW_MAX 32   // moving average length
+#define LADDER_ADC_OVERSAMPLE 256  // maximum raw samples per filtered sample
+#define LADDER_ADC_IIR_FRAC   8    // fraction bits of the IIR state
+#define LADDER_ADC_SIM_FULL   4095 // synthetic samples span the 12 bits range
+
+/**
+ * @enum ladder_adc_source_t
+ * @brief Samples source
+ *
+ */
+typedef enum LADDER_ADC_SOURCE {
+    LADDER_ADC_HW,  // continuous (DMA) conversions
+    LADDER_ADC_SIM, // synthetic: a triangle on channel 0, a noisy constant on channel 1
+} ladder_adc_source_t;
+
+/**
+ * @enum ladder_adc_filter_t
+ * @brief Filter applied to the oversampled values
+ *
+ */
+typedef enum LADDER_ADC_FILTER {
+    LADDER_ADC_FILTER_NONE, //
+    LADDER_ADC_FILTER_AVG,  // moving average of "window" values
+    LADDER_ADC_FILTER_IIR,  // y += (x - y) / 2^iir_shift
+} ladder_adc_filter_t;
+
+/**
+ * @struct ladder_adc_channel_s
+ * @brief Channel and its scaling: raw_min..raw_max is published as eng_min..eng_max
+ *
+ */
+typedef struct ladder_adc_channel_s {
+    bool enabled;    //
+    uint8_t atten;   // adc_atten_t
+    int32_t raw_min; //
+    int32_t raw_max; //
+    int32_t eng_min; //
+    int32_t eng_max; //
+} ladder_adc_channel_t;
+
+/**
+ * @struct ladder_adc_config_s
+ * @brief Sampling configuration
+ *
+ */
+typedef struct ladder_adc_config_s {
+    uint8_t source;                                    // ladder_adc_source_t
+    uint32_t sample_hz;                                // conversions per second, every channel
+    uint16_t oversample;                               // raw samples averaged into one filter input
+    uint8_t filter;                                    // ladder_adc_filter_t
+    uint8_t window;                                    // LADDER_ADC_FILTER_AVG
+    uint8_t iir_shift;                                 // LADDER_ADC_FILTER_IIR
+    ladder_adc_channel_t channel[LADDER_ADC_CHANNELS]; //
+} ladder_adc_config_t;
+
+/**
+ * @struct ladder_adc_input_s
+ * @brief Channel filter state, written by the sampling task only
+ *
+ */
+typedef struct ladder_adc_input_s {
+    uint32_t acc;                        // oversampling sum
+    uint16_t acc_n;                      //
+    int32_t ring[LADDER_ADC_WINDOW_MAX]; // LADDER_ADC_FILTER_AVG
+    int32_t ring_sum;                    //
+    uint8_t ring_pos;                    //
+    uint8_t ring_n;                      //
+    int32_t iir;                         // LADDER_ADC_FILTER_IIR, LADDER_ADC_IIR_FRAC fraction bits
+    bool iir_init;                       //
+    int32_t raw;                         // last oversampled value, atomic
+    int32_t value;                       // published value, atomic
+} ladder_adc_input_t;
+
+/**
+ * @struct ladder_adc_sim_s
+ * @brief Synthetic source: a triangle of 1 s on channel 0 and a noisy mid-scale on channel 1, channels interleaved
+ *        as the DMA delivers them
+ *
+ */
+typedef struct ladder_adc_sim_s {
+    uint32_t period; // triangle samples
+    uint32_t phase;  //
+    uint32_t lfsr;   // noise
+    uint8_t next;    // channel of the next sample
+} ladder_adc_sim_t;
+
+/**
+ * @fn void ladder_adc_filter_limits(ladder_adc_config_t*)
+ * @brief Clamp oversample, window and iir_shift to what the filter supports
+ *
+ * @param config Configuration
+ */
+void ladder_adc_filter_limits(ladder_adc_config_t *config);
+
+/**
+ * @fn bool ladder_adc_filter_sample(ladder_adc_input_t*, const ladder_adc_config_t*, const ladder_adc_channel_t*, int32_t)
+ * @brief Add a raw sample. Every "oversample" samples the average is filtered, scaled and published with one atomic
+ *        store.
+ *
+ * @param input Channel filter state
+ * @param config Configuration, limited by ladder_adc_filter_limits()
+ * @param channel Channel scaling
+ * @param sample Raw sample
+ * @return true if a value was published
+ */
+bool ladder_adc_filter_sample(ladder_adc_input_t *input, const ladder_adc_config_t *config, const ladder_adc_channel_t *channel, int32_t sample);
+
+/**
+ * @fn void ladder_adc_sim_init(ladder_adc_sim_t*, uint32_t)
+ * @brief Start the synthetic source
+ *
+ * @param sim Source
+ * @param sample_hz Conversions per second, every channel
+ */
+void ladder_adc_sim_init(ladder_adc_sim_t *sim, uint32_t sample_hz);
+
+/**
+ * @fn int32_t ladder_adc_sim_sample(ladder_adc_sim_t*, uint32_t*)
+ * @brief Next synthetic sample
+ *
+ * @param sim Source
+ * @param channel Channel of the sample, 0..LADDER_ADC_CHANNELS - 1
+ * @return Raw sample, 0..LADDER_ADC_SIM_FULL
+ */
+int32_t ladder_adc_sim_sample(ladder_adc_sim_t *sim, uint32_t *channel);
+
+#endif /* LADDER_ADC_FILTER_H_ */
@@ -0,0 +1,332 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "driver/dac_oneshot.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_aout.h"
+#include "ladder_warm.h"
+#include "ladderlib_esp32_gpio.h"
+
+static const char *TAG = "ladder_aout";
+
+#define AOUT_PWM_FREQ_HZ    5000 // defaults
+#define AOUT_PWM_RESOLUTION 10   //
+#define AOUT_PWM_RES_MAX    20   // LEDC duty bits
+
+typedef struct aout_s {
+    ladder_aout_config_t config; //
+    dac_oneshot_handle_t dac;    // LADDER_AOUT_DAC
+    ladder_aout_channel_t state; //
+    bool started;                //
+} aout_t;
+
+typedef struct aout_backend_s {
+    bool (*start)(uint32_t n, aout_t *out);         //
+    void (*set)(uint32_t n, aout_t *out, uint32_t); //
+} aout_backend_t;
+
+static aout_t aout[LADDER_AOUT_MAX];
+static ladder_aout_log_ring_t aout_log_ring;
+static uint32_t aout_scan = 0;
+static int64_t aout_time = 0;
+static portMUX_TYPE aout_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool pwm_start(uint32_t n, aout_t *out) {
+    ledc_timer_config_t timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,         //
+        .duty_resolution = out->config.resolution, //
+        .timer_num = LEDC_TIMER_0 + n,             // one timer per output, frequency and resolution are independent
+        .freq_hz = out->config.freq_hz,            //
+        .clk_cfg = LEDC_AUTO_CLK,                  //
+    };
+    ledc_channel_config_t channel = {
+        .gpio_num = outputs[out->config.output], //
+        .speed_mode = LEDC_LOW_SPEED_MODE,       //
+        .channel = LEDC_CHANNEL_0 + n,           //
+        .intr_type = LEDC_INTR_DISABLE,          //
+        .timer_sel = LEDC_TIMER_0 + n,           //
+        .duty = 0,                               //
+        .hpoint = 0,                             //
+    };
+#ifdef INVERT_OUTPUT
+    channel.flags.output_invert = 1;
+#endif
+
+    return ledc_timer_config(&timer) == ESP_OK && ledc_channel_config(&channel) == ESP_OK;
+}
+
+// the new duty is latched at the end of the current PWM period, no partial cycle is ever output
+static void pwm_set(uint32_t n, aout_t *out, uint32_t duty) {
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0 + n, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0 + n);
+}
+
+// the DAC has no output inversion, unlike LEDC: the level is inverted here
+static uint8_t dac_level(uint32_t duty) {
+#ifdef INVERT_OUTPUT
+    return LADDER_AOUT_DAC_FULL - duty;
+#else
+    return duty;
+#endif
+}
+
+static bool dac_start(uint32_t n, aout_t *out) {
+    dac_oneshot_config_t config;
+
+    switch (outputs[out->config.output]) {
+        case GPIO_NUM_25:
+            config.chan_id = DAC_CHAN_0;
+            break;
+        case GPIO_NUM_26:
+            config.chan_id = DAC_CHAN_1;
+            break;
+        default:
+            ESP_LOGE(TAG, "ERROR QW%" PRIu32 ": gpio %" PRIu32 " has no DAC", n, outputs[out->config.output]);
+            return false;
+    }
+
+    return dac_oneshot_new_channel(&config, &out->dac) == ESP_OK && dac_oneshot_output_voltage(out->dac, dac_level(0)) == ESP_OK;
+}
+
+static void dac_set(uint32_t n, aout_t *out, uint32_t duty) {
+    dac_oneshot_output_voltage(out->dac, dac_level(duty));
+}
+
+static bool mock_start(uint32_t n, aout_t *out) {
+    return true;
+}
+
+static void mock_set(uint32_t n, aout_t *out, uint32_t duty) {
+}
+
+static const aout_backend_t backends[] = {
+    {NULL, NULL},           // LADDER_AOUT_NONE
+    {pwm_start, pwm_set},   // LADDER_AOUT_PWM
+    {dac_start, dac_set},   // LADDER_AOUT_DAC
+    {mock_start, mock_set}, // LADDER_AOUT_MOCK
+};
+
+bool ladder_aout_set(uint32_t qw, const ladder_aout_config_t *config) {
+    if (qw >= LADDER_AOUT_MAX || config->mode > LADDER_AOUT_MOCK) {
+        ESP_LOGE(TAG, "ERROR QW%" PRIu32 ": invalid mapping", qw);
+        return false;
+    }
+    if (config->mode != LADDER_AOUT_NONE && (config->output < 0 || config->output >= LOCAL_OUTPUTS)) {
+        ESP_LOGE(TAG, "ERROR QW%" PRIu32 ": invalid output %d", qw, config->output);
+        return false;
+    }
+    bool pwm = config->mode == LADDER_AOUT_PWM || config->mode == LADDER_AOUT_MOCK;
+    if (pwm && (config->resolution < 1 || config->resolution > AOUT_PWM_RES_MAX || config->freq_hz == 0)) {
+        ESP_LOGE(TAG, "ERROR QW%" PRIu32 ": invalid frequency or resolution", qw);
+        return false;
+    }
+    for (uint32_t n = 0; n < LADDER_AOUT_MAX; n++) {
+        if (n != qw && aout[n].config.mode != LADDER_AOUT_NONE && config->mode != LADDER_AOUT_NONE && aout[n].config.output == config->output) {
+            ESP_LOGE(TAG, "ERROR QW%" PRIu32 ": output %d already used by QW%" PRIu32, qw, config->output, n);
+            return false;
+        }
+    }
+
+    memset(&aout[qw], 0, sizeof(aout_t));
+    memcpy(&aout[qw].config, config, sizeof(ladder_aout_config_t));
+    ladder_warm_config_add(LADDER_WARM_CONFIG_AOUT, qw, config, sizeof(ladder_aout_config_t));
+
+    return true;
+}
+
+static int json_int(cJSON *object, const char *name, int def) {
+    cJSON *item = cJSON_GetObjectItem(object, name);
+    return cJSON_IsNumber(item) ? item->valueint : def;
+}
+
+uint32_t ladder_aout_load(const char *file) {
+    static const char *modes[] = {
+        "none", //
+        "pwm",  //
+        "dac",  //
+        "mock", //
+    };
+    ladder_aout_config_t config;
+    uint32_t qw = 0, mapped = 0;
+    cJSON *item;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return 0;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return 0;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return 0;
+    }
+
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "outputs")) {
+        const char *mode = cJSON_GetStringValue(cJSON_GetObjectItem(item, "mode"));
+
+        memset(&config, 0, sizeof(config));
+        config.mode = LADDER_AOUT_NONE;
+        for (uint32_t m = 0; mode != NULL && m < sizeof(modes) / sizeof(modes[0]); m++)
+            if (strcmp(mode, modes[m]) == 0)
+                config.mode = m;
+        config.output = json_int(item, "output", -1);
+        config.freq_hz = json_int(item, "freq_hz", AOUT_PWM_FREQ_HZ);
+        // validated before it sizes the default range, 0 is refused by ladder_aout_set
+        int resolution = json_int(item, "resolution", AOUT_PWM_RESOLUTION);
+        config.resolution = resolution >= 1 && resolution <= AOUT_PWM_RES_MAX ? resolution : 0;
+        config.qw_min = json_int(item, "qw_min", 0);
+        config.qw_max = json_int(item, "qw_max", config.mode == LADDER_AOUT_DAC ? LADDER_AOUT_DAC_FULL : config.resolution > 0 ? (1 << config.resolution) : 0);
+        config.ramp = json_int(item, "ramp", 0);
+
+        if (ladder_aout_set(qw, &config) && config.mode != LADDER_AOUT_NONE)
+            mapped++;
+        qw++;
+    }
+
+    cJSON_Delete(root);
+    return mapped;
+}
+
+bool ladder_aout_start(void) {
+    bool ok = true;
+
+    for (uint32_t n = 0; n < LADDER_AOUT_MAX; n++) {
+        aout_t *out = &aout[n];
+
+        if (out->config.mode == LADDER_AOUT_NONE)
+            continue;
+
+        if (!out->started) {
+            out->started = backends[out->config.mode].start(n, out);
+            if (!out->started) {
+                ESP_LOGE(TAG, "ERROR starting QW%" PRIu32, n);
+                ok = false;
+                continue;
+            }
+            ESP_LOGI(TAG, "QW%" PRIu32 ": gpio %" PRIu32, n, outputs[out->config.output]);
+        }
+        ladder_aout_channel_reset(&out->state, &out->config);
+    }
+    aout_time = 0;
+
+    return ok;
+}
+
+void ladder_aout_stop(void) {
+    for (uint32_t n = 0; n < LADDER_AOUT_MAX; n++) {
+        aout_t *out = &aout[n];
+
+        if (!out->started)
+            continue;
+        backends[out->config.mode].set(n, out, 0);
+        ladder_aout_channel_reset(&out->state, &out->config);
+    }
+}
+
+void ladder_aout_write(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = aout_time == 0 ? 0 : now - aout_time;
+
+    aout_time = now;
+    aout_scan++;
+
+    for (uint32_t n = 0; n < LADDER_AOUT_MAX; n++) {
+        aout_t *out = &aout[n];
+
+        out->state.scan_updates = 0;
+        if (!out->started || n >= (*ladder_ctx).output[id].qw_qty)
+            continue;
+        if (!ladder_aout_channel_update(&out->state, &out->config, (*ladder_ctx).output[id].QW[n], elapsed))
+            continue;
+
+        backends[out->config.mode].set(n, out, out->state.duty);
+
+        portENTER_CRITICAL(&aout_mux);
+        ladder_aout_log_add(&aout_log_ring, aout_scan, n, out->state.duty);
+        portEXIT_CRITICAL(&aout_mux);
+    }
+}
+
+bool ladder_aout_owns(uint32_t port) {
+    for (uint32_t n = 0; n < LADDER_AOUT_MAX; n++)
+        if (aout[n].config.mode != LADDER_AOUT_NONE && aout[n].config.mode != LADDER_AOUT_MOCK && aout[n].config.output == (int8_t)port)
+            return true;
+
+    return false;
+}
+
+uint32_t ladder_aout_info(ladder_aout_info_t *info, uint32_t max) {
+    uint32_t n;
+
+    for (n = 0; n < LADDER_AOUT_MAX && n < max; n++) {
+        memcpy(&info[n].config, &aout[n].config, sizeof(ladder_aout_config_t));
+        info[n].qw = (int32_t)(aout[n].state.current / 1000);
+        info[n].duty = aout[n].state.duty;
+        info[n].updates = aout[n].state.updates;
+        info[n].scan_updates = aout[n].state.scan_updates;
+    }
+
+    return n;
+}
+
+uint32_t ladder_aout_log(ladder_aout_log_t *log, uint32_t max) {
+    uint32_t n;
+
+    portENTER_CRITICAL(&aout_mux);
+    n = ladder_aout_log_copy(&aout_log_ring, log, max);
+    portEXIT_CRITICAL(&aout_mux);
+
+    return n;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_AOUT_H_
+#define LADDER_AOUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "ladder_aout_channel.h"
+
+#define LADDER_AOUT_MAX    2           // local module QW
+#define LADDER_AOUT_CONFIG "aout.json" // configuration loaded at boot
+
+/**
+ * @struct ladder_aout_info_s
+ * @brief Output status
+ *
+ */
+typedef struct ladder_aout_info_s {
+    ladder_aout_config_t config; //
+    int32_t qw;                  // value driven, after the ramp
+    uint32_t duty;               //
+    uint32_t updates;            // hardware updates
+    uint32_t scan_updates;       // hardware updates at the last scan
+} ladder_aout_info_t;
+
+/**
+ * @fn bool ladder_aout_set(uint32_t, const ladder_aout_config_t*)
+ * @brief Map a QW of the local module. Call before the ladder is started.
+ *
+ * @param qw QW index
+ * @param config Mapping
+ * @return true if valid
+ */
+bool ladder_aout_set(uint32_t qw, const ladder_aout_config_t *config);
+
+/**
+ * @fn uint32_t ladder_aout_load(const char*)
+ * @brief Read a mapping file, array position is the QW
+ *
+ *        {"outputs":[{"mode":"pwm","output":4,"freq_hz":5000,"resolution":10,"qw_min":0,"qw_max":10000,"ramp":2000},
+ *                    {"mode":"dac","output":5,"qw_min":0,"qw_max":255}]}
+ *
+ * @param file File name, relative to the mount point
+ * @return Outputs mapped
+ */
+uint32_t ladder_aout_load(const char *file);
+
+/**
+ * @fn bool ladder_aout_start(void)
+ * @brief Configure the hardware. Called by the local module output init, after the GPIO configuration.
+ *
+ * @return true if ok
+ */
+bool ladder_aout_start(void);
+
+/**
+ * @fn void ladder_aout_stop(void)
+ * @brief Drive every output to 0
+ *
+ */
+void ladder_aout_stop(void);
+
+/**
+ * @fn void ladder_aout_write(ladder_ctx_t*, uint32_t)
+ * @brief Scan write: the hardware is updated only when the driven value changes
+ *
+ * @param ladder_ctx Ladder context
+ * @param id Local module
+ */
+void ladder_aout_write(ladder_ctx_t *ladder_ctx, uint32_t id);
+
+/**
+ * @fn bool ladder_aout_owns(uint32_t)
+ * @brief The port is an analog output
+ *
+ * @param port outputs[] index
+ * @return true if mapped
+ */
+bool ladder_aout_owns(uint32_t port);
+
+/**
+ * @fn uint32_t ladder_aout_info(ladder_aout_info_t*, uint32_t)
+ * @brief Outputs status
+ *
+ * @param info Status of every QW
+ * @param max info size
+ * @return QW filled
+ */
+uint32_t ladder_aout_info(ladder_aout_info_t *info, uint32_t max);
+
+/**
+ * @fn uint32_t ladder_aout_log(ladder_aout_log_t*, uint32_t)
+ * @brief Last hardware updates, oldest first
+ *
+ * @param log Updates
+ * @param max log size
+ * @return Updates filled
+ */
+uint32_t ladder_aout_log(ladder_aout_log_t *log, uint32_t max);
+
+#endif /* LADDER_AOUT_H_ */
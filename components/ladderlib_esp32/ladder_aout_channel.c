@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder_aout_channel.h"
+
+static uint32_t aout_full(const ladder_aout_config_t *config) {
+    return config->mode == LADDER_AOUT_DAC ? LADDER_AOUT_DAC_FULL : 1UL << config->resolution;
+}
+
+static int32_t aout_clamp(const ladder_aout_config_t *config, int32_t value) {
+    int32_t lo = config->qw_min < config->qw_max ? config->qw_min : config->qw_max;
+    int32_t hi = config->qw_min < config->qw_max ? config->qw_max : config->qw_min;
+
+    return value < lo ? lo : value > hi ? hi : value;
+}
+
+uint32_t ladder_aout_channel_duty(const ladder_aout_config_t *config, int32_t value) {
+    int64_t span = (int64_t)config->qw_max - config->qw_min;
+
+    if (span == 0)
+        return 0;
+
+    return (uint32_t)((((int64_t)value - config->qw_min) * aout_full(config) * 2 + span) / (2 * span));
+}
+
+void ladder_aout_channel_reset(ladder_aout_channel_t *channel, const ladder_aout_config_t *config) {
+    channel->duty = 0;
+    channel->current = (int64_t)aout_clamp(config, config->qw_min) * 1000;
+}
+
+bool ladder_aout_channel_update(ladder_aout_channel_t *channel, const ladder_aout_config_t *config, int32_t qw, int64_t elapsed_us) {
+    int64_t target = (int64_t)aout_clamp(config, qw) * 1000;
+
+    if (config->ramp == 0) {
+        channel->current = target;
+    } else {
+        // QW units per second over microseconds, in 1/1000 units
+        int64_t step = (int64_t)config->ramp * elapsed_us / 1000;
+        if (target > channel->current)
+            channel->current = channel->current + step < target ? channel->current + step : target;
+        else
+            channel->current = channel->current - step > target ? channel->current - step : target;
+    }
+
+    uint32_t duty = ladder_aout_channel_duty(config, (int32_t)(channel->current / 1000));
+    if (duty == channel->duty)
+        return false;
+
+    channel->duty = duty;
+    channel->updates++;
+    channel->scan_updates++;
+
+    return true;
+}
+
+void ladder_aout_log_add(ladder_aout_log_ring_t *ring, uint32_t scan, uint8_t qw, uint32_t duty) {
+    ring->entry[ring->pos].scan = scan;
+    ring->entry[ring->pos].qw = qw;
+    ring->entry[ring->pos].duty = duty;
+    ring->pos = (ring->pos + 1) % LADDER_AOUT_LOG;
+    if (ring->qty < LADDER_AOUT_LOG)
+        ring->qty++;
+}
+
+uint32_t ladder_aout_log_copy(const ladder_aout_log_ring_t *ring, ladder_aout_log_t *log, uint32_t max) {
+    uint32_t qty = ring->qty < max ? ring->qty : max;
+    uint32_t first = (ring->pos + LADDER_AOUT_LOG - qty) % LADDER_AOUT_LOG;
+
+    for (uint32_t n = 0; n < qty; n++)
+        log[n] = ring->entry[(first + n) % LADDER_AOUT_LOG];
+
+    return qty;
+}
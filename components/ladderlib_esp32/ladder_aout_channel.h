@@ -0,0 +1,153 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_AOUT_CHANNEL_H_
+#define LADDER_AOUT_CHANNEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LADDER_AOUT_LOG      32  // updates kept for "aout log"
+#define LADDER_AOUT_DAC_FULL 255 // 8 bits DAC
+
+/**
+ * @enum ladder_aout_mode_t
+ * @brief Output hardware
+ *
+ */
+typedef enum LADDER_AOUT_MODE {
+    LADDER_AOUT_NONE, // QW not mapped
+    LADDER_AOUT_PWM,  // LEDC channel
+    LADDER_AOUT_DAC,  // 8 bits DAC, GPIO25 or GPIO26 only
+    LADDER_AOUT_MOCK, // no hardware, updates are only recorded and the port stays a digital Q
+} ladder_aout_mode_t;
+
+/**
+ * @struct ladder_aout_config_s
+ * @brief QW mapping: qw_min..qw_max drives duty 0..full scale, out of range values are clamped
+ *
+ */
+typedef struct ladder_aout_config_s {
+    uint8_t mode;       // ladder_aout_mode_t
+    int8_t output;      // outputs[] index, the digital Q of that port is no longer driven
+    uint32_t freq_hz;   // LADDER_AOUT_PWM
+    uint8_t resolution; // LADDER_AOUT_PWM: duty bits
+    int32_t qw_min;     //
+    int32_t qw_max;     //
+    uint32_t ramp;      // QW units per second the output may move, 0: none
+} ladder_aout_config_t;
+
+/**
+ * @struct ladder_aout_log_s
+ * @brief Recorded hardware update
+ *
+ */
+typedef struct ladder_aout_log_s {
+    uint32_t scan; // local module write count
+    uint8_t qw;    //
+    uint32_t duty; //
+} ladder_aout_log_t;
+
+/**
+ * @struct ladder_aout_channel_s
+ * @brief Output state, written by the scan only
+ *
+ */
+typedef struct ladder_aout_channel_s {
+    int64_t current;       // driven value, 1/1000 QW units
+    uint32_t duty;         // last value sent to the hardware
+    uint32_t updates;      //
+    uint32_t scan_updates; // at the last scan
+} ladder_aout_channel_t;
+
+/**
+ * @struct ladder_aout_log_ring_s
+ * @brief Last LADDER_AOUT_LOG hardware updates, the newest overwrites the oldest
+ *
+ */
+typedef struct ladder_aout_log_ring_s {
+    ladder_aout_log_t entry[LADDER_AOUT_LOG]; //
+    uint32_t pos;                             // next entry written
+    uint32_t qty;                             //
+} ladder_aout_log_ring_t;
+
+/**
+ * @fn uint32_t ladder_aout_channel_duty(const ladder_aout_config_t*, int32_t)
+ * @brief Duty of a QW value, rounded: qw_min is 0, qw_max full scale (2^resolution, or LADDER_AOUT_DAC_FULL)
+ *
+ * @param config Mapping
+ * @param value QW value, within the mapping range
+ * @return Duty
+ */
+uint32_t ladder_aout_channel_duty(const ladder_aout_config_t *config, int32_t value);
+
+/**
+ * @fn void ladder_aout_channel_reset(ladder_aout_channel_t*, const ladder_aout_config_t*)
+ * @brief Output at qw_min, duty 0
+ *
+ * @param channel Output state
+ * @param config Mapping
+ */
+void ladder_aout_channel_reset(ladder_aout_channel_t *channel, const ladder_aout_config_t *config);
+
+/**
+ * @fn bool ladder_aout_channel_update(ladder_aout_channel_t*, const ladder_aout_config_t*, int32_t, int64_t)
+ * @brief Move the output towards a QW value, no faster than the ramp
+ *
+ * @param channel Output state
+ * @param config Mapping
+ * @param qw QW value, clamped to the mapping range
+ * @param elapsed_us Time since the previous update
+ * @return true if the duty changed and the hardware must be updated with channel->duty
+ */
+bool ladder_aout_channel_update(ladder_aout_channel_t *channel, const ladder_aout_config_t *config, int32_t qw, int64_t elapsed_us);
+
+/**
+ * @fn void ladder_aout_log_add(ladder_aout_log_ring_t*, uint32_t, uint8_t, uint32_t)
+ * @brief Record a hardware update
+ *
+ * @param ring Log
+ * @param scan Local module write count
+ * @param qw QW index
+ * @param duty Duty
+ */
+void ladder_aout_log_add(ladder_aout_log_ring_t *ring, uint32_t scan, uint8_t qw, uint32_t duty);
+
+/**
+ * @fn uint32_t ladder_aout_log_copy(const ladder_aout_log_ring_t*, ladder_aout_log_t*, uint32_t)
+ * @brief Newest updates, oldest first
+ *
+ * @param ring Log
+ * @param log Updates
+ * @param max log size
+ * @return Updates filled
+ */
+uint32_t ladder_aout_log_copy(const ladder_aout_log_ring_t *ring, ladder_aout_log_t *log, uint32_t max);
+
+#endif /* LADDER_AOUT_CHANNEL_H_ */
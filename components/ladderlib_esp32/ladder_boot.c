@@ -0,0 +1,237 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_boot.h"
+#include "ladder_program_check.h"
+#include "ladder_program_json.h"
+#include "ladder_program_store.h"
+
+static const char *TAG = "ladder_boot";
+
+extern TaskHandle_t laddertsk_handle;
+
+typedef struct boot_job_s {
+    ladder_ctx_t *ladder_ctx;    //
+    ladder_boot_config_t config; //
+} boot_job_t;
+
+static ladder_boot_phase_t boot_phase[LADDER_BOOT_PHASES_MAX];
+static uint32_t boot_phases = 0;
+static portMUX_TYPE boot_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// the boot.json program, parsed and checked aside and swapped in at the scan boundary like a stored version
+static bool boot_program_file(ladder_ctx_t *ladder_ctx, const char *program) {
+    ladder_prg_check_t check = { 0 };
+    ladder_store_result_t res = LADDER_STORE_INVALID;
+    ladder_json_error_t err;
+
+    ladder_ctx_t *shadow = malloc(sizeof(ladder_ctx_t));
+    if (shadow == NULL)
+        return false;
+    *shadow = *ladder_ctx;
+    (*shadow).network = NULL;
+    (*shadow).ladder.quantity.networks = 0;
+
+    int phase = ladder_boot_begin("program load");
+    err = ladder_json_to_program(program, NULL, shadow, false);
+    ladder_boot_end(phase);
+    if (err != JSON_ERROR_OK) {
+        ESP_LOGE(TAG, "ERROR loading %s (%d)", program, err);
+        goto end;
+    }
+
+    phase = ladder_boot_begin("program check");
+    check = ladder_program_check(*shadow);
+    ladder_boot_end(phase);
+    if (check.error != LADDER_ERR_PRG_CHECK_OK) {
+        ESP_LOGE(TAG, "ERROR %s not valid (%u) at network:%" PRIu32 " [%" PRIu32 ",%" PRIu32 "]", program, check.error, check.network, check.row,
+                 check.column);
+        goto end;
+    }
+
+    res = ladder_program_store_swap(ladder_ctx, (*shadow).network, (*shadow).ladder.quantity.networks, 0);
+    if (res != LADDER_STORE_BUSY && res != LADDER_STORE_ERROR)
+        (*shadow).network = NULL;
+
+end:
+    ladder_program_free((*shadow).network, (*shadow).ladder.quantity.networks);
+    free(shadow);
+
+    return res == LADDER_STORE_OK || res == LADDER_STORE_QUEUED;
+}
+
+static void boot_task(void *arg) {
+    boot_job_t *job = arg;
+    ladder_ctx_t *ladder_ctx = job->ladder_ctx;
+    const char *program = "active version";
+
+    // the store active version is what last ran; boot.json names the program only while the store is empty
+    int phase = ladder_boot_begin("program store");
+    ladder_store_result_t res = ladder_program_store_load_active(ladder_ctx);
+    ladder_boot_end(phase);
+
+    if (res == LADDER_STORE_NOT_FOUND && job->config.program[0] != '\0') {
+        program = job->config.program;
+        if (!boot_program_file(ladder_ctx, program))
+            goto end;
+    } else if (res != LADDER_STORE_OK && res != LADDER_STORE_QUEUED) {
+        ESP_LOGE(TAG, "ERROR loading the active version (%d)", res);
+        goto end;
+    }
+
+    if (!job->config.autostart) {
+        ESP_LOGI(TAG, "%s loaded, no autostart", program);
+        goto end;
+    }
+
+    int64_t wait_ms = (int64_t)job->config.delay_ms - esp_timer_get_time() / 1000;
+    if (wait_ms > 0)
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+
+    // the console or the editor may have started it meanwhile
+    if ((*ladder_ctx).ladder.state == LADDER_ST_RUNNING)
+        goto end;
+
+    phase = ladder_boot_begin("ladder start");
+    (*ladder_ctx).ladder.state = LADDER_ST_RUNNING;
+    if (xTaskCreatePinnedToCore(ladder_task, "ladder", 30000, (void *)ladder_ctx, 10, &laddertsk_handle, 1) != pdPASS) {
+        ESP_LOGE(TAG, "ERROR: start task ladder");
+        (*ladder_ctx).ladder.state = LADDER_ST_STOPPED;
+    }
+    ladder_boot_end(phase);
+
+end:
+    free(job);
+    vTaskDelete(NULL);
+}
+
+bool ladder_boot_load(const char *file, ladder_boot_config_t *config) {
+    cJSON *item;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return false;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return false;
+    }
+
+    memset(config, 0, sizeof(ladder_boot_config_t));
+    const char *program = cJSON_GetStringValue(cJSON_GetObjectItem(root, "program"));
+    if (program != NULL)
+        strlcpy(config->program, program, sizeof(config->program));
+    config->autostart = cJSON_IsTrue(cJSON_GetObjectItem(root, "autostart"));
+    if ((item = cJSON_GetObjectItem(root, "delay_ms")) != NULL && cJSON_IsNumber(item) && item->valuedouble > 0)
+        config->delay_ms = item->valuedouble;
+
+    cJSON_Delete(root);
+    return true;
+}
+
+bool ladder_boot_start(ladder_ctx_t *ladder_ctx, const ladder_boot_config_t *config) {
+    if ((*ladder_ctx).ladder.state == LADDER_ST_RUNNING) {
+        ESP_LOGI(TAG, "ladder already running, boot program not loaded");
+        return false;
+    }
+
+    boot_job_t *job = malloc(sizeof(boot_job_t));
+    if (job == NULL)
+        return false;
+
+    job->ladder_ctx = ladder_ctx;
+    job->config = *config;
+
+    if (xTaskCreate(boot_task, "ladder_boot", 8192, job, 5, NULL) != pdPASS) {
+        free(job);
+        return false;
+    }
+
+    return true;
+}
+
+int ladder_boot_begin(const char *name) {
+    int phase = -1;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&boot_mux);
+    if (boot_phases < LADDER_BOOT_PHASES_MAX) {
+        phase = boot_phases++;
+        boot_phase[phase].name = name;
+        boot_phase[phase].start_us = now;
+        boot_phase[phase].end_us = 0;
+    }
+    portEXIT_CRITICAL(&boot_mux);
+
+    return phase;
+}
+
+void ladder_boot_end(int phase) {
+    if (phase < 0)
+        return;
+
+    boot_phase[phase].end_us = esp_timer_get_time();
+}
+
+uint32_t ladder_boot_phases(ladder_boot_phase_t *phase, uint32_t max) {
+    portENTER_CRITICAL(&boot_mux);
+    uint32_t qty = boot_phases < max ? boot_phases : max;
+    memcpy(phase, boot_phase, qty * sizeof(ladder_boot_phase_t));
+    portEXIT_CRITICAL(&boot_mux);
+
+    return qty;
+}
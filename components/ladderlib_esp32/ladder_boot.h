@@ -0,0 +1,115 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_BOOT_H_
+#define LADDER_BOOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+
+#define LADDER_BOOT_CONFIG      "boot.json" // boot configuration, relative to the mount point
+#define LADDER_BOOT_PHASES_MAX  16          // boot phases timed
+#define LADDER_BOOT_PROGRAM_MAX 64          // program file name length
+
+/**
+ * @struct ladder_boot_config_s
+ * @brief Boot configuration
+ *
+ */
+typedef struct ladder_boot_config_s {
+    char program[LADDER_BOOT_PROGRAM_MAX]; // loaded at boot if no stored version is active, relative to the mount point
+    bool autostart;                        // start the ladder once the program is loaded and checked
+    uint32_t delay_ms;                     // earliest start, counted from reset
+} ladder_boot_config_t;
+
+/**
+ * @struct ladder_boot_phase_s
+ * @brief Boot phase timing
+ *
+ */
+typedef struct ladder_boot_phase_s {
+    const char *name; //
+    int64_t start_us; // since reset
+    int64_t end_us;   // since reset, 0: not finished
+} ladder_boot_phase_t;
+
+/**
+ * @fn bool ladder_boot_load(const char*, ladder_boot_config_t*)
+ * @brief Read the boot configuration
+ *
+ *        {"program":"prg.json","autostart":true,"delay_ms":0}
+ *
+ * @param file File name, relative to the mount point
+ * @param config Configuration, left untouched if the file can't be read
+ * @return true if read
+ */
+bool ladder_boot_load(const char *file, ladder_boot_config_t *config);
+
+/**
+ * @fn bool ladder_boot_start(ladder_ctx_t*, const ladder_boot_config_t*)
+ * @brief Load the store active version, or the configured program if the store is empty, and start the ladder, in a
+ *        task of its own so the rest of the initialization (Wi-Fi, console, services) goes on in parallel. The program
+ *        is checked and swapped in at the scan boundary. Nothing is done if the ladder already runs (warm start).
+ *
+ * @param ladder_ctx Ladder context, stopped
+ * @param config Configuration
+ * @return true if the task was created
+ */
+bool ladder_boot_start(ladder_ctx_t *ladder_ctx, const ladder_boot_config_t *config);
+
+/**
+ * @fn int ladder_boot_begin(const char*)
+ * @brief Start timing a boot phase
+ *
+ * @param name Phase name, a literal
+ * @return Phase handle or -1 if there are already LADDER_BOOT_PHASES_MAX phases
+ */
+int ladder_boot_begin(const char *name);
+
+/**
+ * @fn void ladder_boot_end(int)
+ * @brief End of a boot phase
+ *
+ * @param phase Phase handle
+ */
+void ladder_boot_end(int phase);
+
+/**
+ * @fn uint32_t ladder_boot_phases(ladder_boot_phase_t*, uint32_t)
+ * @brief Boot phases timings, in start order
+ *
+ * @param phase Phases
+ * @param max Phases array size
+ * @return Phases quantity
+ */
+uint32_t ladder_boot_phases(ladder_boot_phase_t *phase, uint32_t max);
+
+#endif /* LADDER_BOOT_H_ */
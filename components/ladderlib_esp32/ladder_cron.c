@@ -0,0 +1,183 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "hal_fs.h"
+
+#include "cron.h"
+#include "ladder.h"
+#include "ladder_cron.h"
+#include "ladder_registers.h"
+
+static const char *TAG = "ladder_cron";
+
+typedef struct ladder_cron_action_s {
+    bool used;                     //
+    int32_t id;                    // cron id
+    ladder_register_write_t write; //
+} ladder_cron_action_t;
+
+static ladder_cron_action_t actions[LADDER_CRON_ACTIONS_MAX];
+static ladder_ctx_t *cron_ctx = NULL;
+static SemaphoreHandle_t actions_mutex = NULL;
+
+// cron task: one register batch, so one scan boundary, for everything due now
+static void ladder_cron_fire(const uint32_t *values, uint32_t qty) {
+    ladder_register_write_t writes[LADDER_CRON_ACTIONS_MAX];
+    uint32_t writes_qty = 0;
+    ladder_registers_error_t err;
+
+    xSemaphoreTake(actions_mutex, portMAX_DELAY);
+    for (uint32_t n = 0; n < qty; n++)
+        if (values[n] < LADDER_CRON_ACTIONS_MAX && actions[values[n]].used)
+            writes[writes_qty++] = actions[values[n]].write;
+    xSemaphoreGive(actions_mutex);
+
+    if ((err = ladder_registers_write(cron_ctx, writes, writes_qty)) != REGISTERS_ERROR_OK)
+        ESP_LOGE(TAG, "ERROR writing %" PRIu32 " registers (%d)", writes_qty, err);
+}
+
+bool ladder_cron_init(ladder_ctx_t *ladder_ctx, int8_t tz) {
+    if (actions_mutex != NULL)
+        return true;
+
+    actions_mutex = xSemaphoreCreateMutex();
+    if (actions_mutex == NULL)
+        return false;
+
+    cron_ctx = ladder_ctx;
+
+    return cron_start(tz) == ESP_OK;
+}
+
+int32_t ladder_cron_add(const char *expr, ladder_register_t type, uint32_t index, int32_t value) {
+    ladder_register_value_t current;
+    int32_t id = -1;
+    uint32_t slot;
+
+    if (actions_mutex == NULL || (type != LADDER_REGISTER_M && type != LADDER_REGISTER_D) ||
+        ladder_registers_get(cron_ctx, type, 0, index, &current) != REGISTERS_ERROR_OK)
+        return -1;
+
+    xSemaphoreTake(actions_mutex, portMAX_DELAY);
+
+    for (slot = 0; slot < LADDER_CRON_ACTIONS_MAX && actions[slot].used; slot++)
+        ;
+
+    if (slot < LADDER_CRON_ACTIONS_MAX && (id = cron_add_batch(expr, ladder_cron_fire, slot)) >= 0) {
+        actions[slot].used = true;
+        actions[slot].id = id;
+        actions[slot].write.type = type;
+        actions[slot].write.module = 0;
+        actions[slot].write.index = index;
+        actions[slot].write.value.i32 = type == LADDER_REGISTER_M ? value != 0 : value;
+    }
+
+    xSemaphoreGive(actions_mutex);
+
+    if (id < 0)
+        ESP_LOGE(TAG, "ERROR adding \"%s\"", expr);
+
+    return id;
+}
+
+bool ladder_cron_delete(int32_t id) {
+    bool found = false;
+
+    if (actions_mutex == NULL || cron_delete(id) != ESP_OK)
+        return false;
+
+    xSemaphoreTake(actions_mutex, portMAX_DELAY);
+    for (uint32_t slot = 0; slot < LADDER_CRON_ACTIONS_MAX && !found; slot++) {
+        if (actions[slot].used && actions[slot].id == id) {
+            actions[slot].used = false;
+            found = true;
+        }
+    }
+    xSemaphoreGive(actions_mutex);
+
+    return found;
+}
+
+uint32_t ladder_cron_load(const char *file) {
+    uint32_t qty = 0, entry = 0;
+    cJSON *item;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return 0;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return 0;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return 0;
+    }
+
+    cJSON_ArrayForEach(item, root) {
+        const char *expr = cJSON_GetStringValue(cJSON_GetObjectItem(item, "expr"));
+        const char *type = cJSON_GetStringValue(cJSON_GetObjectItem(item, "type"));
+        cJSON *index = cJSON_GetObjectItem(item, "index");
+        cJSON *value = cJSON_GetObjectItem(item, "value");
+
+        if (expr == NULL || type == NULL || !cJSON_IsNumber(index) || !cJSON_IsNumber(value) ||
+            ladder_cron_add(expr, ladder_registers_type(type), index->valueint, value->valueint) < 0) {
+            ESP_LOGE(TAG, "%s: entry %" PRIu32 " ignored", file, entry++);
+            continue;
+        }
+        entry++;
+        qty++;
+    }
+
+    cJSON_Delete(root);
+    ESP_LOGI(TAG, "%s: %" PRIu32 " actions", file, qty);
+
+    return qty;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_CRON_H_
+#define LADDER_CRON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+
+#define LADDER_CRON_ACTIONS_MAX 32          // scheduled register writes
+#define LADDER_CRON_CONFIG      "cron.json" // actions loaded at boot
+
+/**
+ * @fn bool ladder_cron_init(ladder_ctx_t*, int8_t)
+ * @brief Start the cron scheduler for the ladder actions
+ *
+ * @param ladder_ctx Ladder context
+ * @param tz Time zone (hours)
+ * @return true if started
+ */
+bool ladder_cron_init(ladder_ctx_t *ladder_ctx, int8_t tz);
+
+/**
+ * @fn int32_t ladder_cron_add(const char*, ladder_register_t, uint32_t, int32_t)
+ * @brief Schedule a write of an M bit or a D register. The writes of all actions firing at the same time are applied
+ *        together at the next scan boundary.
+ *
+ * @param expr Cron expression (seconds minutes hours days_of_month months days_of_week)
+ * @param type LADDER_REGISTER_M or LADDER_REGISTER_D
+ * @param index Register index
+ * @param value Value, M: 0 or 1
+ * @return cron id or -1
+ */
+int32_t ladder_cron_add(const char *expr, ladder_register_t type, uint32_t index, int32_t value);
+
+/**
+ * @fn bool ladder_cron_delete(int32_t)
+ * @brief Remove an action
+ *
+ * @param id cron id
+ * @return true if removed
+ */
+bool ladder_cron_delete(int32_t id);
+
+/**
+ * @fn uint32_t ladder_cron_load(const char*)
+ * @brief Add the actions of a JSON file: [{"expr":"0 0 8 * * 1-5","type":"M","index":3,"value":1},...]
+ *
+ * @param file File name, relative to the mount point
+ * @return actions added
+ */
+uint32_t ladder_cron_load(const char *file);
+
+#endif /* LADDER_CRON_H_ */
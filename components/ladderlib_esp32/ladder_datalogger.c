@@ -0,0 +1,596 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_datalogger.h"
+#include "ladder_datalogger_chunk.h"
+#include "ladder_registers.h"
+
+static const char *TAG = "ladder_datalogger";
+
+#define DATALOGGER_CSV_BUFFER 1024                                      //
+#define DATALOGGER_CSV_LINE   ((1 + LADDER_DATALOGGER_CHANNELS_MAX) * 16) //
+
+typedef struct datalogger_s {
+    ladder_datalogger_config_t config; //
+    volatile bool running;             //
+    uint32_t words;                    // int32 per sample: time and channels
+
+    // scan task side
+    int32_t *ring;                               // LADDER_DATALOGGER_RING_SAMPLES samples
+    volatile uint32_t head;                      // written by the scan task
+    volatile uint32_t tail;                      // written by the writer task
+    int32_t *pre;                                // trigger mode: pre trigger window
+    uint32_t pre_qty;                            // samples taken into the window
+    uint32_t post_left;                          // trigger mode: samples still to log after the trigger
+    bool trigger_level;                          //
+    bool have_last;                              // change mode
+    int32_t last[LADDER_DATALOGGER_CHANNELS_MAX]; // change mode: last logged values
+    bool have_time;                              //
+    uint32_t last_time;                          // last sample time
+
+    // writer task side
+    ladder_datalogger_packer_t packer; // chunk being filled
+    uint64_t page_time;                // ms when the first sample was added
+    uint32_t file_index;               // current file
+    uint32_t file_pages;               // chunks in the current file
+    uint32_t seq;                      //
+
+    ladder_datalogger_stats_t stats; //
+} datalogger_t;
+
+static datalogger_t dl = { 0 };
+static SemaphoreHandle_t dl_config_mutex = NULL; // configuration, tried by the scan hook
+static SemaphoreHandle_t dl_file_mutex = NULL;   // chunk and file
+static TaskHandle_t dl_task = NULL;
+
+static const char *str_modes[] = {
+    "periodic", //
+    "change",   //
+    "trigger",  //
+};
+
+static uint32_t millis(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+static void file_name(char *name, size_t size, uint32_t index) {
+    snprintf(name, size, LADDER_DATALOGGER_DIR "/dl_%05" PRIu32 ".bin", index);
+}
+
+// next file index and retention of the files left by a previous run
+static void file_scan(void) {
+    struct dirent *de;
+    uint32_t index, max = 0;
+    bool found = false;
+    char name[64];
+
+    DIR *dir = opendir(MOUNT_POINT "/" LADDER_DATALOGGER_DIR);
+    if (dir == NULL)
+        return;
+
+    while ((de = readdir(dir)) != NULL) {
+        if (sscanf(de->d_name, "dl_%" SCNu32 ".bin", &index) != 1)
+            continue;
+        if (!found || index > max)
+            max = index;
+        found = true;
+    }
+    closedir(dir);
+
+    dl.file_index = found ? max + 1 : 0;
+
+    for (index = 0; found && index + LADDER_DATALOGGER_FILES_MAX <= max; index++) {
+        file_name(name, sizeof(name), index);
+        fs_remove_async(name, FS_ASYNC_LOW, NULL, NULL);
+    }
+}
+
+static uint16_t page_samples(void) {
+    return ((ladder_datalogger_chunk_t *)dl.packer.page)->samples;
+}
+
+// one whole page per append: the flash sees full blocks only
+static void page_write(void) {
+    uint16_t samples = page_samples();
+    char name[64];
+
+    if (samples == 0)
+        return;
+
+    uint32_t seq = dl.seq++;
+    ladder_datalogger_chunk_seal(&dl.packer, seq);
+
+    // a new file replaces the oldest one
+    if (dl.file_pages == 0 && dl.file_index >= LADDER_DATALOGGER_FILES_MAX) {
+        file_name(name, sizeof(name), dl.file_index - LADDER_DATALOGGER_FILES_MAX);
+        fs_remove_async(name, FS_ASYNC_LOW, NULL, NULL);
+    }
+
+    file_name(name, sizeof(name), dl.file_index);
+    char *data = malloc(LADDER_DATALOGGER_PAGE_SIZE);
+    if (data != NULL)
+        memcpy(data, dl.packer.page, LADDER_DATALOGGER_PAGE_SIZE);
+
+    if (data != NULL && fs_append_async(name, data, LADDER_DATALOGGER_PAGE_SIZE, FS_ASYNC_LOW, NULL, NULL) == 0) {
+        dl.stats.chunks++;
+        dl.stats.written += LADDER_DATALOGGER_PAGE_SIZE;
+    } else {
+        ESP_LOGE(TAG, "ERROR writing chunk %" PRIu32, seq);
+        dl.stats.dropped += samples;
+    }
+
+    if (++dl.file_pages >= LADDER_DATALOGGER_FILE_PAGES) {
+        dl.file_index++;
+        dl.file_pages = 0;
+    }
+
+    ladder_datalogger_chunk_reset(&dl.packer, dl.config.channels, dl.config.channel);
+}
+
+static void page_add(const int32_t *sample) {
+    if (page_samples() == 0)
+        dl.page_time = millis();
+
+    if (!ladder_datalogger_chunk_add(&dl.packer, sample)) {
+        page_write();
+        dl.page_time = millis();
+        ladder_datalogger_chunk_add(&dl.packer, sample);
+    }
+
+    dl.stats.raw_bytes += sizeof(int32_t) * dl.words;
+}
+
+static void ring_drain(void) {
+    if (dl.ring == NULL)
+        return;
+
+    while (dl.tail != dl.head) {
+        page_add(&dl.ring[(dl.tail % LADDER_DATALOGGER_RING_SAMPLES) * dl.words]);
+        __sync_synchronize();
+        dl.tail++;
+    }
+}
+
+static void ring_push(const int32_t *sample) {
+    uint32_t used = dl.head - dl.tail;
+
+    if (used >= LADDER_DATALOGGER_RING_SAMPLES) {
+        dl.stats.dropped++;
+        return;
+    }
+
+    memcpy(&dl.ring[(dl.head % LADDER_DATALOGGER_RING_SAMPLES) * dl.words], sample, sizeof(int32_t) * dl.words);
+    __sync_synchronize();
+    dl.head++;
+    dl.stats.samples++;
+
+    if (used + 1 == LADDER_DATALOGGER_RING_SAMPLES / 2)
+        xTaskNotifyGive(dl_task);
+}
+
+static void datalogger_task(void *arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+        xSemaphoreTake(dl_file_mutex, portMAX_DELAY);
+        if (dl.packer.page != NULL) {
+            ring_drain();
+            if (page_samples() > 0 && millis() - dl.page_time >= LADDER_DATALOGGER_FLUSH_MS)
+                page_write();
+        }
+        xSemaphoreGive(dl_file_mutex);
+    }
+}
+
+static void buffers_free(void) {
+    free(dl.ring);
+    free(dl.pre);
+    free(dl.packer.page);
+    dl.ring = NULL;
+    dl.pre = NULL;
+    dl.packer.page = NULL;
+}
+
+bool ladder_datalogger_init(void) {
+    if (dl_task != NULL)
+        return true;
+
+    dl_config_mutex = xSemaphoreCreateMutex();
+    dl_file_mutex = xSemaphoreCreateMutex();
+    if (dl_config_mutex == NULL || dl_file_mutex == NULL)
+        return false;
+
+    mkdir(MOUNT_POINT "/" LADDER_DATALOGGER_DIR, 0755);
+
+    if (xTaskCreate(datalogger_task, "datalogger", 4096, NULL, 1, &dl_task) != pdPASS) {
+        dl_task = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+bool ladder_datalogger_start(ladder_ctx_t *ladder_ctx, const ladder_datalogger_config_t *config) {
+    ladder_register_value_t value;
+
+    if (dl_task == NULL || config->channels == 0 || config->channels > LADDER_DATALOGGER_CHANNELS_MAX || config->mode > LADDER_DATALOGGER_TRIGGER)
+        return false;
+    if (config->mode == LADDER_DATALOGGER_TRIGGER && (config->trigger >= config->channels || config->pre > LADDER_DATALOGGER_PRE_MAX))
+        return false;
+    for (uint8_t c = 0; c < config->channels; c++) {
+        const ladder_datalogger_channel_t *channel = &config->channel[c];
+        if (channel->type == LADDER_REGISTER_S || ladder_registers_get(ladder_ctx, channel->type, channel->module, channel->index, &value) != REGISTERS_ERROR_OK) {
+            ESP_LOGE(TAG, "ERROR channel %u", c);
+            return false;
+        }
+    }
+
+    ladder_datalogger_stop();
+
+    uint32_t words = 1 + config->channels;
+    int32_t *ring = malloc(LADDER_DATALOGGER_RING_SAMPLES * words * sizeof(int32_t));
+    int32_t *pre = config->mode == LADDER_DATALOGGER_TRIGGER && config->pre > 0 ? malloc(config->pre * words * sizeof(int32_t)) : NULL;
+    uint8_t *page = malloc(LADDER_DATALOGGER_PAGE_SIZE);
+    if (ring == NULL || page == NULL || (pre == NULL && config->mode == LADDER_DATALOGGER_TRIGGER && config->pre > 0)) {
+        free(ring);
+        free(pre);
+        free(page);
+        return false;
+    }
+
+    xSemaphoreTake(dl_config_mutex, portMAX_DELAY);
+    xSemaphoreTake(dl_file_mutex, portMAX_DELAY);
+
+    memset(&dl, 0, sizeof(datalogger_t));
+    dl.config = *config;
+    dl.words = words;
+    dl.ring = ring;
+    dl.pre = pre;
+    dl.packer.page = page;
+    file_scan();
+    ladder_datalogger_chunk_reset(&dl.packer, dl.config.channels, dl.config.channel);
+    dl.running = true;
+
+    xSemaphoreGive(dl_file_mutex);
+    xSemaphoreGive(dl_config_mutex);
+
+    ESP_LOGI(TAG, "Logging %u channels (%s, %" PRIu32 " ms) to file %" PRIu32, config->channels, str_modes[config->mode], config->period_ms, dl.file_index);
+
+    return true;
+}
+
+bool ladder_datalogger_load(ladder_ctx_t *ladder_ctx, const char *file) {
+    ladder_datalogger_config_t config = { 0 };
+    cJSON *item;
+    bool ok = false;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return false;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return false;
+    }
+
+    const char *mode = cJSON_GetStringValue(cJSON_GetObjectItem(root, "mode"));
+    for (int m = 0; mode != NULL && m < sizeof(str_modes) / sizeof(str_modes[0]); m++)
+        if (strcmp(mode, str_modes[m]) == 0)
+            config.mode = m;
+
+    if ((item = cJSON_GetObjectItem(root, "period_ms")) != NULL && cJSON_IsNumber(item))
+        config.period_ms = item->valueint;
+    if ((item = cJSON_GetObjectItem(root, "pre")) != NULL && cJSON_IsNumber(item))
+        config.pre = item->valueint;
+    if ((item = cJSON_GetObjectItem(root, "post")) != NULL && cJSON_IsNumber(item))
+        config.post = item->valueint;
+    if ((item = cJSON_GetObjectItem(root, "trigger")) != NULL && cJSON_IsNumber(item))
+        config.trigger = item->valueint;
+
+    cJSON *channels = cJSON_GetObjectItem(root, "channels");
+    cJSON_ArrayForEach(item, channels) {
+        if (config.channels == LADDER_DATALOGGER_CHANNELS_MAX)
+            goto end;
+
+        ladder_datalogger_channel_t *channel = &config.channel[config.channels++];
+        cJSON *module = cJSON_GetObjectItem(item, "module");
+        cJSON *index = cJSON_GetObjectItem(item, "index");
+
+        channel->type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(item, "type")));
+        channel->module = cJSON_IsNumber(module) ? module->valueint : 0;
+        channel->index = cJSON_IsNumber(index) ? index->valueint : 0;
+        if (channel->type == LADDER_REGISTER_INV)
+            goto end;
+    }
+
+    ok = ladder_datalogger_start(ladder_ctx, &config);
+
+end:
+    if (!ok)
+        ESP_LOGE(TAG, "ERROR configuration %s", file);
+    cJSON_Delete(root);
+    return ok;
+}
+
+void ladder_datalogger_stop(void) {
+    if (dl_task == NULL)
+        return;
+
+    xSemaphoreTake(dl_config_mutex, portMAX_DELAY);
+    dl.running = false;
+    xSemaphoreGive(dl_config_mutex);
+
+    // the scan hook doesn't touch the ring any more
+    xSemaphoreTake(dl_file_mutex, portMAX_DELAY);
+    if (dl.packer.page != NULL) {
+        ring_drain();
+        page_write();
+    }
+    buffers_free();
+    xSemaphoreGive(dl_file_mutex);
+}
+
+void ladder_datalogger_sample(ladder_ctx_t *ladder_ctx) {
+    int32_t sample[1 + LADDER_DATALOGGER_CHANNELS_MAX];
+    ladder_register_value_t value;
+
+    if (!dl.running || xSemaphoreTake(dl_config_mutex, 0) != pdTRUE)
+        return;
+    if (!dl.running)
+        goto end;
+
+    uint32_t now = millis();
+    if (dl.have_time && dl.config.period_ms > 0 && now - dl.last_time < dl.config.period_ms)
+        goto end;
+    dl.last_time = now;
+    dl.have_time = true;
+
+    sample[0] = now;
+    for (uint8_t c = 0; c < dl.config.channels; c++) {
+        const ladder_datalogger_channel_t *channel = &dl.config.channel[c];
+        value.i32 = 0;
+        ladder_registers_get(ladder_ctx, channel->type, channel->module, channel->index, &value);
+        sample[1 + c] = value.i32; // R is logged as its bits
+    }
+
+    switch (dl.config.mode) {
+        case LADDER_DATALOGGER_CHANGE:
+            if (dl.have_last && memcmp(dl.last, &sample[1], sizeof(int32_t) * dl.config.channels) == 0)
+                break;
+            memcpy(dl.last, &sample[1], sizeof(int32_t) * dl.config.channels);
+            dl.have_last = true;
+            ring_push(sample);
+            break;
+
+        case LADDER_DATALOGGER_TRIGGER: {
+            bool level = sample[1 + dl.config.trigger] != 0;
+            bool edge = level && !dl.trigger_level;
+            dl.trigger_level = level;
+
+            if (dl.post_left > 0) {
+                ring_push(sample);
+                dl.post_left--;
+            } else if (edge) {
+                // the pre trigger window goes first, oldest sample first
+                uint32_t qty = dl.pre_qty < dl.config.pre ? dl.pre_qty : dl.config.pre;
+                for (uint32_t n = dl.pre_qty - qty; n < dl.pre_qty; n++)
+                    ring_push(&dl.pre[(n % dl.config.pre) * dl.words]);
+                dl.pre_qty = 0;
+                ring_push(sample);
+                dl.post_left = dl.config.post;
+            } else if (dl.config.pre > 0) {
+                memcpy(&dl.pre[(dl.pre_qty % dl.config.pre) * dl.words], sample, sizeof(int32_t) * dl.words);
+                dl.pre_qty++;
+            }
+        }
+            break;
+
+        default:
+            ring_push(sample);
+            break;
+    }
+
+end:
+    xSemaphoreGive(dl_config_mutex);
+}
+
+void ladder_datalogger_stats(ladder_datalogger_stats_t *stats) {
+    *stats = dl.stats;
+    stats->running = dl.running;
+}
+
+char *ladder_datalogger_list(void) {
+    ladder_datalogger_stats_t stats;
+    struct dirent *de;
+    struct stat st;
+    char path[300];
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL)
+        return NULL;
+
+    ladder_datalogger_stats(&stats);
+    cJSON_AddBoolToObject(root, "running", stats.running);
+    cJSON_AddNumberToObject(root, "samples", stats.samples);
+    cJSON_AddNumberToObject(root, "dropped", stats.dropped);
+    cJSON_AddNumberToObject(root, "chunks", stats.chunks);
+    cJSON_AddNumberToObject(root, "raw_bytes", stats.raw_bytes);
+    cJSON_AddNumberToObject(root, "written_bytes", stats.written);
+    cJSON_AddNumberToObject(root, "write_amplification", stats.raw_bytes > 0 ? (double)stats.written / stats.raw_bytes : 0);
+
+    cJSON *files = cJSON_AddArrayToObject(root, "files");
+    DIR *dir = opendir(MOUNT_POINT "/" LADDER_DATALOGGER_DIR);
+    while (files != NULL && dir != NULL && (de = readdir(dir)) != NULL) {
+        if (strncmp(de->d_name, "dl_", 3) != 0)
+            continue;
+
+        snprintf(path, sizeof(path), MOUNT_POINT "/" LADDER_DATALOGGER_DIR "/%s", de->d_name);
+        cJSON *file = cJSON_CreateObject();
+        cJSON_AddStringToObject(file, "name", de->d_name);
+        cJSON_AddNumberToObject(file, "size", stat(path, &st) == 0 ? st.st_size : 0);
+        cJSON_AddItemToArray(files, file);
+    }
+    if (dir != NULL)
+        closedir(dir);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    return json;
+}
+
+static bool csv_put(char *buf, size_t *len, const char *line, ladder_datalogger_out_fn out_fn, void *arg, bool flush) {
+    size_t line_len = strlen(line);
+
+    if (*len + line_len > DATALOGGER_CSV_BUFFER || (flush && *len > 0)) {
+        if (!out_fn(buf, *len, arg))
+            return false;
+        *len = 0;
+    }
+    memcpy(buf + *len, line, line_len);
+    *len += line_len;
+
+    return true;
+}
+
+static int csv_value(char *line, size_t size, const ladder_datalogger_channel_t *channel, int32_t value) {
+    if (channel->type == LADDER_REGISTER_R) {
+        float real;
+        memcpy(&real, &value, sizeof(real));
+        return snprintf(line, size, ",%g", real);
+    }
+
+    return snprintf(line, size, ",%" PRIi32, value);
+}
+
+bool ladder_datalogger_csv(const char *name, ladder_datalogger_out_fn out_fn, void *arg) {
+    char path[64], check[32], line[DATALOGGER_CSV_LINE];
+    uint32_t index;
+    size_t len = 0;
+    bool header = false, ok = true;
+
+    // only names built by the logger, nothing outside its directory
+    if (sscanf(name, "dl_%" SCNu32 ".bin", &index) != 1)
+        return false;
+    snprintf(check, sizeof(check), "dl_%05" PRIu32 ".bin", index);
+    if (strcmp(check, name) != 0)
+        return false;
+
+    file_name(path, sizeof(path), index);
+    FILE *fp = fs_open(path, "r");
+    if (fp == NULL)
+        return false;
+
+    uint8_t *page = malloc(LADDER_DATALOGGER_PAGE_SIZE);
+    char *buf = malloc(DATALOGGER_CSV_BUFFER);
+    if (page == NULL || buf == NULL) {
+        ok = false;
+        goto end;
+    }
+
+    for (uint32_t n = 0; ok && fread(page, 1, LADDER_DATALOGGER_PAGE_SIZE, fp) == LADDER_DATALOGGER_PAGE_SIZE; n++) {
+        ladder_datalogger_chunk_t *chunk = (ladder_datalogger_chunk_t *)page;
+        ladder_datalogger_channel_t channels[LADDER_DATALOGGER_CHANNELS_MAX];
+        int32_t sample[1 + LADDER_DATALOGGER_CHANNELS_MAX];
+        uint32_t pos = 0;
+        uint16_t s = 0;
+
+        if (!ladder_datalogger_chunk_check(page)) {
+            ESP_LOGW(TAG, "%s: chunk %" PRIu32 " skipped", name, n);
+            continue;
+        }
+        memcpy(channels, chunk->channel, sizeof(channels));
+
+        if (!header) {
+            int l = snprintf(line, sizeof(line), "time_ms");
+            for (uint8_t c = 0; c < chunk->channels; c++) {
+                const ladder_datalogger_channel_t *channel = &channels[c];
+                if (channel->type == LADDER_REGISTER_I || channel->type == LADDER_REGISTER_Q || channel->type == LADDER_REGISTER_IW ||
+                    channel->type == LADDER_REGISTER_QW)
+                    l += snprintf(line + l, sizeof(line) - l, ",%s%u.%u", ladder_registers_type_name(channel->type), channel->module, channel->index);
+                else
+                    l += snprintf(line + l, sizeof(line) - l, ",%s%u", ladder_registers_type_name(channel->type), channel->index);
+            }
+            snprintf(line + l, sizeof(line) - l, "\n");
+            ok = csv_put(buf, &len, line, out_fn, arg, false);
+            header = true;
+        }
+
+        for (; ok && s < chunk->samples && ladder_datalogger_chunk_next(page, &pos, sample); s++) {
+            int l = snprintf(line, sizeof(line), "%" PRIu32, (uint32_t)sample[0]);
+            for (uint8_t c = 0; c < chunk->channels; c++)
+                l += csv_value(line + l, sizeof(line) - l, &channels[c], sample[1 + c]);
+            snprintf(line + l, sizeof(line) - l, "\n");
+            ok = csv_put(buf, &len, line, out_fn, arg, false);
+        }
+        if (ok && s < chunk->samples)
+            ESP_LOGW(TAG, "%s: chunk %" PRIu32 " truncated", name, n);
+    }
+
+    if (ok && len > 0)
+        ok = out_fn(buf, len, arg);
+
+end:
+    fclose(fp);
+    free(page);
+    free(buf);
+
+    return ok;
+}
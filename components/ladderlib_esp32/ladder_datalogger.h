@@ -0,0 +1,167 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_DATALOGGER_H_
+#define LADDER_DATALOGGER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "ladder_datalogger_chunk.h"
+
+#define LADDER_DATALOGGER_RING_SAMPLES 128               // RAM ring between the scan and the writer task
+#define LADDER_DATALOGGER_PRE_MAX      64                // trigger mode: samples kept before the trigger
+#define LADDER_DATALOGGER_FILE_PAGES   16                // chunks per file before rotating
+#define LADDER_DATALOGGER_FILES_MAX    8                 // files kept, the oldest is removed
+#define LADDER_DATALOGGER_FLUSH_MS     60000             // a partially filled chunk is written after this time
+#define LADDER_DATALOGGER_DIR          "log"             // relative to the mount point
+#define LADDER_DATALOGGER_CONFIG       "datalogger.json" // configuration loaded at boot
+
+/**
+ * @enum ladder_datalogger_mode_t
+ * @brief When a sample is stored
+ *
+ */
+typedef enum LADDER_DATALOGGER_MODE {
+    LADDER_DATALOGGER_PERIODIC, // every period
+    LADDER_DATALOGGER_CHANGE,   // every period, if any channel changed
+    LADDER_DATALOGGER_TRIGGER,  // pre samples before and post samples after a rising edge of the trigger channel
+} ladder_datalogger_mode_t;
+
+/**
+ * @struct ladder_datalogger_config_s
+ * @brief Logger configuration
+ *
+ */
+typedef struct ladder_datalogger_config_s {
+    ladder_datalogger_mode_t mode;                                   //
+    uint32_t period_ms;                                              // sample period, 0: every scan
+    uint32_t pre;                                                    // trigger mode: samples before the trigger
+    uint32_t post;                                                   // trigger mode: samples after the trigger
+    uint8_t trigger;                                                 // trigger mode: channel
+    uint8_t channels;                                                // channels quantity
+    ladder_datalogger_channel_t channel[LADDER_DATALOGGER_CHANNELS_MAX]; //
+} ladder_datalogger_config_t;
+
+/**
+ * @struct ladder_datalogger_stats_s
+ * @brief Logger counters
+ *
+ */
+typedef struct ladder_datalogger_stats_s {
+    bool running;       //
+    uint32_t samples;   // samples stored
+    uint32_t dropped;   // samples lost, ring full
+    uint32_t chunks;    // chunks written
+    uint64_t raw_bytes; // uncompressed sample bytes
+    uint64_t written;   // bytes written to flash
+} ladder_datalogger_stats_t;
+
+/**
+ * @brief Output callback, return false to abort
+ *
+ */
+typedef bool (*ladder_datalogger_out_fn)(const char *data, size_t len, void *arg);
+
+/**
+ * @fn bool ladder_datalogger_init(void)
+ * @brief Start the writer task
+ *
+ * @return true if started
+ */
+bool ladder_datalogger_init(void);
+
+/**
+ * @fn bool ladder_datalogger_start(ladder_ctx_t*, const ladder_datalogger_config_t*)
+ * @brief Start logging, a running log is stopped first
+ *
+ * @param ladder_ctx Ladder context
+ * @param config Configuration
+ * @return true if the configuration is valid
+ */
+bool ladder_datalogger_start(ladder_ctx_t *ladder_ctx, const ladder_datalogger_config_t *config);
+
+/**
+ * @fn bool ladder_datalogger_load(ladder_ctx_t*, const char*)
+ * @brief Start logging with a JSON configuration file
+ *
+ *        {"mode":"periodic"|"change"|"trigger","period_ms":100,"pre":10,"post":50,"trigger":0,
+ *         "channels":[{"type":"M","index":0},{"type":"IW","module":0,"index":1}]}
+ *
+ * @param ladder_ctx Ladder context
+ * @param file File name, relative to the mount point
+ * @return true if started
+ */
+bool ladder_datalogger_load(ladder_ctx_t *ladder_ctx, const char *file);
+
+/**
+ * @fn void ladder_datalogger_stop(void)
+ * @brief Stop logging and write the pending samples
+ *
+ */
+void ladder_datalogger_stop(void);
+
+/**
+ * @fn void ladder_datalogger_sample(ladder_ctx_t*)
+ * @brief Scan hook, never blocks
+ *
+ * @param ladder_ctx Ladder context
+ */
+void ladder_datalogger_sample(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_datalogger_stats(ladder_datalogger_stats_t*)
+ * @brief Counters since the last start
+ *
+ * @param stats Counters
+ */
+void ladder_datalogger_stats(ladder_datalogger_stats_t *stats);
+
+/**
+ * @fn char* ladder_datalogger_list(void)
+ * @brief Log files and counters as JSON
+ *
+ * @return JSON (free after use) or NULL
+ */
+char *ladder_datalogger_list(void);
+
+/**
+ * @fn bool ladder_datalogger_csv(const char*, ladder_datalogger_out_fn, void*)
+ * @brief Decode a log file to CSV. Chunks with a bad CRC are skipped.
+ *
+ * @param name File name as returned by ladder_datalogger_list
+ * @param out_fn Output callback
+ * @param arg Callback argument
+ * @return false if the file can't be read or the output was aborted
+ */
+bool ladder_datalogger_csv(const char *name, ladder_datalogger_out_fn out_fn, void *arg);
+
+#endif /* LADDER_DATALOGGER_H_ */
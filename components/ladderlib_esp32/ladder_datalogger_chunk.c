@@ -0,0 +1,151 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+#include "ladder_datalogger_chunk.h"
+
+#define CHUNK_HEADER     sizeof(ladder_datalogger_chunk_t)          //
+#define CHUNK_SAMPLE_MAX ((1 + LADDER_DATALOGGER_CHANNELS_MAX) * 5) // encoded sample worst case
+#define CHUNK_CRC_START  offsetof(ladder_datalogger_chunk_t, seq)  // magic and crc are not covered
+
+static int varint_put(uint8_t *buf, int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    int n = 0;
+
+    while (zigzag >= 0x80) {
+        buf[n++] = zigzag | 0x80;
+        zigzag >>= 7;
+    }
+    buf[n++] = zigzag;
+
+    return n;
+}
+
+static bool varint_get(const uint8_t *buf, uint32_t len, uint32_t *pos, int32_t *value) {
+    uint32_t zigzag = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= len)
+            return false;
+
+        uint8_t byte = buf[(*pos)++];
+        zigzag |= (uint32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ladder_datalogger_chunk_reset(ladder_datalogger_packer_t *packer, uint8_t channels, const ladder_datalogger_channel_t *channel) {
+    ladder_datalogger_chunk_t *chunk = (ladder_datalogger_chunk_t *)packer->page;
+
+    memset(chunk, 0, CHUNK_HEADER);
+    chunk->magic = LADDER_DATALOGGER_MAGIC;
+    chunk->channels = channels;
+    memcpy(chunk->channel, channel, sizeof(ladder_datalogger_channel_t) * channels);
+    packer->len = CHUNK_HEADER;
+    packer->words = 1 + channels;
+}
+
+bool ladder_datalogger_chunk_add(ladder_datalogger_packer_t *packer, const int32_t *sample) {
+    ladder_datalogger_chunk_t *chunk = (ladder_datalogger_chunk_t *)packer->page;
+    uint8_t buf[CHUNK_SAMPLE_MAX];
+    int len = 0;
+
+    if (chunk->samples == UINT16_MAX)
+        return false;
+
+    if (chunk->samples == 0) {
+        chunk->time = sample[0];
+        packer->prev[0] = sample[0];
+        memset(&packer->prev[1], 0, sizeof(int32_t) * (packer->words - 1));
+    }
+
+    for (uint32_t w = 0; w < packer->words; w++)
+        len += varint_put(buf + len, (int32_t)((uint32_t)sample[w] - (uint32_t)packer->prev[w])); // R bits wrap
+
+    if (packer->len + len > LADDER_DATALOGGER_PAGE_SIZE)
+        return false;
+
+    memcpy(packer->page + packer->len, buf, len);
+    memcpy(packer->prev, sample, sizeof(int32_t) * packer->words);
+    packer->len += len;
+    chunk->samples++;
+
+    return true;
+}
+
+void ladder_datalogger_chunk_seal(ladder_datalogger_packer_t *packer, uint32_t seq) {
+    ladder_datalogger_chunk_t *chunk = (ladder_datalogger_chunk_t *)packer->page;
+
+    chunk->seq = seq;
+    chunk->payload = packer->len - CHUNK_HEADER;
+    chunk->crc = esp_rom_crc32_le(0, packer->page + CHUNK_CRC_START, packer->len - CHUNK_CRC_START);
+    memset(packer->page + packer->len, 0xff, LADDER_DATALOGGER_PAGE_SIZE - packer->len);
+}
+
+bool ladder_datalogger_chunk_check(const uint8_t *page) {
+    const ladder_datalogger_chunk_t *chunk = (const ladder_datalogger_chunk_t *)page;
+    uint32_t len = CHUNK_HEADER + chunk->payload;
+
+    return chunk->magic == LADDER_DATALOGGER_MAGIC && len <= LADDER_DATALOGGER_PAGE_SIZE && chunk->channels <= LADDER_DATALOGGER_CHANNELS_MAX &&
+           chunk->crc == esp_rom_crc32_le(0, page + CHUNK_CRC_START, len - CHUNK_CRC_START);
+}
+
+bool ladder_datalogger_chunk_next(const uint8_t *page, uint32_t *pos, int32_t *sample) {
+    const ladder_datalogger_chunk_t *chunk = (const ladder_datalogger_chunk_t *)page;
+    uint32_t len = CHUNK_HEADER + chunk->payload;
+    int32_t delta;
+
+    if (*pos == 0) {
+        sample[0] = chunk->time;
+        memset(&sample[1], 0, sizeof(int32_t) * chunk->channels);
+        *pos = CHUNK_HEADER;
+    }
+
+    if (*pos >= len)
+        return false;
+
+    for (uint32_t w = 0; w <= chunk->channels; w++) {
+        if (!varint_get(page, len, pos, &delta))
+            return false;
+        sample[w] = (int32_t)((uint32_t)sample[w] + (uint32_t)delta);
+    }
+
+    return true;
+}
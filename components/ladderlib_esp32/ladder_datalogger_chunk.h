@@ -0,0 +1,131 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_DATALOGGER_CHUNK_H_
+#define LADDER_DATALOGGER_CHUNK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LADDER_DATALOGGER_CHANNELS_MAX 16         // registers per sample
+#define LADDER_DATALOGGER_PAGE_SIZE    4096       // chunk size, one LittleFS block
+#define LADDER_DATALOGGER_MAGIC        0x31474c44 // "DLG1"
+
+/**
+ * @struct ladder_datalogger_channel_s
+ * @brief Logged register
+ *
+ */
+typedef struct ladder_datalogger_channel_s {
+    uint8_t type;   // ladder_register_t
+    uint8_t module; // I/Q/IW/QW only
+    uint16_t index; // register index
+} ladder_datalogger_channel_t;
+
+/**
+ * @struct ladder_datalogger_chunk_s
+ * @brief Chunk header. Each LADDER_DATALOGGER_PAGE_SIZE page of a log file starts with one, followed by the samples:
+ *        zigzag varint deltas of the time (ms) and of each channel against the previous sample of the same chunk.
+ *        The first sample is relative to "time" and 0. R values are logged as their IEEE-754 bits.
+ *
+ */
+typedef struct __attribute__((packed)) ladder_datalogger_chunk_s {
+    uint32_t magic;                                                  // LADDER_DATALOGGER_MAGIC
+    uint32_t crc;                                                    // CRC-32 of the rest of the header and the payload
+    uint32_t seq;                                                    // chunk sequence
+    uint32_t time;                                                   // ms of the first sample
+    uint16_t samples;                                                // samples in the chunk
+    uint16_t payload;                                                // payload bytes after the header
+    uint8_t channels;                                                // channels quantity
+    uint8_t reserved[3];                                             //
+    ladder_datalogger_channel_t channel[LADDER_DATALOGGER_CHANNELS_MAX]; //
+} ladder_datalogger_chunk_t;
+
+/**
+ * @struct ladder_datalogger_packer_s
+ * @brief Chunk being filled
+ *
+ */
+typedef struct ladder_datalogger_packer_s {
+    uint8_t *page;                                    // LADDER_DATALOGGER_PAGE_SIZE bytes
+    uint32_t len;                                     // header and payload bytes
+    uint32_t words;                                   // int32 per sample: time and channels
+    int32_t prev[1 + LADDER_DATALOGGER_CHANNELS_MAX]; // previous sample of the chunk
+} ladder_datalogger_packer_t;
+
+/**
+ * @fn void ladder_datalogger_chunk_reset(ladder_datalogger_packer_t*, uint8_t, const ladder_datalogger_channel_t*)
+ * @brief Start an empty chunk
+ *
+ * @param packer Packer, page already allocated
+ * @param channels Channels quantity, up to LADDER_DATALOGGER_CHANNELS_MAX
+ * @param channel Channels
+ */
+void ladder_datalogger_chunk_reset(ladder_datalogger_packer_t *packer, uint8_t channels, const ladder_datalogger_channel_t *channel);
+
+/**
+ * @fn bool ladder_datalogger_chunk_add(ladder_datalogger_packer_t*, const int32_t*)
+ * @brief Append a sample
+ *
+ * @param packer Packer
+ * @param sample Time (ms) and channels
+ * @return false if the chunk is full: seal it, write it, reset and add again
+ */
+bool ladder_datalogger_chunk_add(ladder_datalogger_packer_t *packer, const int32_t *sample);
+
+/**
+ * @fn void ladder_datalogger_chunk_seal(ladder_datalogger_packer_t*, uint32_t)
+ * @brief Complete the header and fill the rest of the page with 0xff, the page is ready to be written
+ *
+ * @param packer Packer
+ * @param seq Chunk sequence
+ */
+void ladder_datalogger_chunk_seal(ladder_datalogger_packer_t *packer, uint32_t seq);
+
+/**
+ * @fn bool ladder_datalogger_chunk_check(const uint8_t*)
+ * @brief Magic, sizes and CRC of a page read back
+ *
+ * @param page LADDER_DATALOGGER_PAGE_SIZE bytes
+ * @return true if the chunk can be decoded
+ */
+bool ladder_datalogger_chunk_check(const uint8_t *page);
+
+/**
+ * @fn bool ladder_datalogger_chunk_next(const uint8_t*, uint32_t*, int32_t*)
+ * @brief Decode the next sample of a checked chunk. Start with pos 0.
+ *
+ * @param page Chunk
+ * @param pos Decoder position, updated
+ * @param sample Previous sample on entry, next one on return
+ * @return false at the end of the payload or if it is truncated
+ */
+bool ladder_datalogger_chunk_next(const uint8_t *page, uint32_t *pos, int32_t *sample);
+
+#endif /* LADDER_DATALOGGER_CHUNK_H_ */
@@ -0,0 +1,440 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "driver/gpio.h"
+#include "driver/pulse_cnt.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_adc.h"
+#include "ladder_aout.h"
+#include "ladder_hsc.h"
+#include "ladder_hsc_counter.h"
+#include "ladder_warm.h"
+#include "ladderlib_esp32_gpio.h"
+
+static const char *TAG = "ladder_hsc";
+
+#define HSC_PCNT_HIGH 32767  // PCNT counter limits, the driver accumulates across them
+#define HSC_PCNT_LOW  -32768 //
+
+typedef struct hsc_s {
+    ladder_hsc_config_t config; //
+    uint32_t gpio_a;            // pins, inputs[] and outputs[] are in flash: the interrupt runs with the cache off
+    int32_t gpio_b;             // -1: none
+    int32_t gpio_out;           // -1: none
+    pcnt_unit_handle_t unit;    // LADDER_HSC_PCNT
+    int32_t base;               // LADDER_HSC_PCNT: value at the last preset, the unit restarts from 0
+    ladder_hsc_counter_t state; // count: LADDER_HSC_ISR and LADDER_HSC_SIM
+    bool preset_level;          // preset M at the previous scan
+    bool started;               //
+} hsc_t;
+
+static hsc_t hsc[LADDER_HSC_MAX];
+static uint32_t hsc_qty = 0;
+static portMUX_TYPE hsc_mux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t hsc_timer = NULL;
+
+// interrupt or timer context: the output is switched here, not at the next scan. In IRAM with everything it touches,
+// counting goes on while the flash is written (file system, program store)
+static void IRAM_ATTR hsc_fire(hsc_t *counter) {
+    if (counter->gpio_out < 0)
+        return;
+
+    counter->state.latched = true;
+#ifdef INVERT_OUTPUT
+    gpio_set_level(counter->gpio_out, 0);
+#else
+    gpio_set_level(counter->gpio_out, 1);
+#endif
+}
+
+static void IRAM_ATTR hsc_add(hsc_t *counter, int32_t delta) {
+    portENTER_CRITICAL_SAFE(&hsc_mux);
+    if (ladder_hsc_counter_add(&counter->state, delta, esp_timer_get_time()) > 0)
+        hsc_fire(counter);
+    portEXIT_CRITICAL_SAFE(&hsc_mux);
+}
+
+static void IRAM_ATTR hsc_isr(void *arg) {
+    hsc_t *counter = arg;
+
+    if (counter->gpio_b < 0) {
+        hsc_add(counter, 1);
+        return;
+    }
+
+    int32_t delta = ladder_hsc_counter_quad(&counter->state, (gpio_get_level(counter->gpio_a) << 1) | gpio_get_level(counter->gpio_b));
+    if (delta != 0)
+        hsc_add(counter, delta);
+}
+
+// the unit restarts from 0 at the high limit, which is the compare value when there is one
+static bool IRAM_ATTR hsc_pcnt_reach(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata, void *arg) {
+    hsc_t *counter = arg;
+
+    if (counter->config.compare > 0 && edata->watch_point_value == counter->config.compare) {
+        portENTER_CRITICAL_ISR(&hsc_mux);
+        counter->state.fires++;
+        counter->state.fire_time = esp_timer_get_time();
+        hsc_fire(counter);
+        portEXIT_CRITICAL_ISR(&hsc_mux);
+    }
+
+    return false;
+}
+
+static int32_t hsc_count(hsc_t *counter) {
+    int value = 0;
+
+    if (counter->config.mode != LADDER_HSC_PCNT)
+        return __atomic_load_n(&counter->state.count, __ATOMIC_RELAXED);
+
+    pcnt_unit_get_count(counter->unit, &value);
+    return __atomic_load_n(&counter->base, __ATOMIC_RELAXED) + value;
+}
+
+// simulated pulses and the frequency gate
+static void hsc_timer_cb(void *arg) {
+    static uint32_t ticks = 0;
+    int64_t now = esp_timer_get_time();
+
+    ticks++;
+    for (uint32_t n = 0; n < hsc_qty; n++) {
+        hsc_t *counter = &hsc[n];
+
+        if (counter->config.mode == LADDER_HSC_SIM) {
+            uint32_t pulses = ladder_hsc_counter_sim(&counter->state, counter->config.sim_hz, LADDER_HSC_SIM_MS);
+            if (pulses > 0)
+                hsc_add(counter, pulses);
+        }
+
+        if (ticks % (LADDER_HSC_GATE_MS / LADDER_HSC_SIM_MS) != 0)
+            continue;
+
+        ladder_hsc_counter_gate(&counter->state, hsc_count(counter), now);
+    }
+}
+
+static bool hsc_pcnt_start(hsc_t *counter) {
+    int high = counter->config.compare > 0 ? counter->config.compare : HSC_PCNT_HIGH;
+    pcnt_unit_config_t unit_config = {
+        .low_limit = HSC_PCNT_LOW, //
+        .high_limit = high,        //
+        .flags.accum_count = true, //
+    };
+    pcnt_chan_config_t chan_config = {
+        .edge_gpio_num = inputs[counter->config.input],                                        //
+        .level_gpio_num = counter->config.input_b >= 0 ? inputs[counter->config.input_b] : -1, //
+    };
+    pcnt_event_callbacks_t callbacks = {
+        .on_reach = hsc_pcnt_reach, //
+    };
+    pcnt_channel_handle_t chan_a, chan_b;
+
+    if (pcnt_new_unit(&unit_config, &counter->unit) != ESP_OK || pcnt_new_channel(counter->unit, &chan_config, &chan_a) != ESP_OK)
+        return false;
+
+    if (counter->config.filter_ns > 0) {
+        pcnt_glitch_filter_config_t filter_config = {
+            .max_glitch_ns = counter->config.filter_ns, //
+        };
+        pcnt_unit_set_glitch_filter(counter->unit, &filter_config);
+    }
+
+    if (counter->config.input_b < 0) {
+#ifdef INVERT_INPUT
+        pcnt_channel_set_edge_action(chan_a, counter->config.both_edges ? PCNT_CHANNEL_EDGE_ACTION_INCREASE : PCNT_CHANNEL_EDGE_ACTION_HOLD,
+                                     PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+#else
+        pcnt_channel_set_edge_action(chan_a, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                     counter->config.both_edges ? PCNT_CHANNEL_EDGE_ACTION_INCREASE : PCNT_CHANNEL_EDGE_ACTION_HOLD);
+#endif
+    } else {
+        // x4: each input counts on both edges, the other gives the direction
+        chan_config.edge_gpio_num = inputs[counter->config.input_b];
+        chan_config.level_gpio_num = inputs[counter->config.input];
+        if (pcnt_new_channel(counter->unit, &chan_config, &chan_b) != ESP_OK)
+            return false;
+        pcnt_channel_set_edge_action(chan_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+        pcnt_channel_set_level_action(chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+        pcnt_channel_set_edge_action(chan_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+        pcnt_channel_set_level_action(chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    }
+
+    // accumulation needs the limits as watch points
+    pcnt_unit_add_watch_point(counter->unit, high);
+    pcnt_unit_add_watch_point(counter->unit, HSC_PCNT_LOW);
+    if (pcnt_unit_register_event_callbacks(counter->unit, &callbacks, counter) != ESP_OK || pcnt_unit_enable(counter->unit) != ESP_OK ||
+        pcnt_unit_clear_count(counter->unit) != ESP_OK || pcnt_unit_start(counter->unit) != ESP_OK)
+        return false;
+
+    return true;
+}
+
+int ladder_hsc_add(const ladder_hsc_config_t *config) {
+    if (hsc_qty == LADDER_HSC_MAX || config->mode > LADDER_HSC_SIM)
+        return -1;
+    if (config->mode != LADDER_HSC_SIM &&
+        (config->input < 0 || config->input >= LOCAL_INPUTS || config->input_b >= LOCAL_INPUTS || config->input_b == config->input))
+        return -1;
+    if (config->output >= LOCAL_OUTPUTS || config->compare < 0 || (config->mode == LADDER_HSC_PCNT && config->compare > HSC_PCNT_HIGH))
+        return -1;
+
+    // ports already taken by the ADC (I6/I7) or driven by LEDC or the DAC
+    if (config->mode != LADDER_HSC_SIM && (ladder_adc_owns(config->input) || (config->input_b >= 0 && ladder_adc_owns(config->input_b)))) {
+        ESP_LOGE(TAG, "ERROR input %d is sampled by the ADC", ladder_adc_owns(config->input) ? config->input : config->input_b);
+        return -1;
+    }
+    if (config->output >= 0 && ladder_aout_owns(config->output)) {
+        ESP_LOGE(TAG, "ERROR output %d is an analog output", config->output);
+        return -1;
+    }
+
+    hsc_t *counter = &hsc[hsc_qty];
+    memset(counter, 0, sizeof(hsc_t));
+    counter->config = *config;
+    counter->gpio_a = config->input >= 0 ? inputs[config->input] : 0;
+    counter->gpio_b = config->input_b >= 0 ? (int32_t)inputs[config->input_b] : -1;
+    counter->gpio_out = config->output >= 0 ? (int32_t)outputs[config->output] : -1;
+    counter->base = config->preset;
+    ladder_hsc_counter_init(&counter->state, config->preset, config->compare);
+
+    ladder_warm_config_add(LADDER_WARM_CONFIG_HSC, hsc_qty, config, sizeof(ladder_hsc_config_t));
+    ESP_LOGI(TAG, "counter %" PRIu32 ": IW%d", hsc_qty, LADDER_HSC_IW_FIRST + 2 * (int)hsc_qty);
+    return hsc_qty++;
+}
+
+static int json_int(cJSON *object, const char *name, int def) {
+    cJSON *item = cJSON_GetObjectItem(object, name);
+    return cJSON_IsNumber(item) ? item->valueint : def;
+}
+
+uint32_t ladder_hsc_load(const char *file) {
+    static const char *modes[] = {
+        "pcnt", //
+        "isr",  //
+        "sim",  //
+    };
+    ladder_hsc_config_t config;
+    uint32_t added = 0;
+    cJSON *item;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return 0;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return 0;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return 0;
+    }
+
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "counters")) {
+        const char *mode = cJSON_GetStringValue(cJSON_GetObjectItem(item, "mode"));
+
+        memset(&config, 0, sizeof(config));
+        config.mode = LADDER_HSC_PCNT;
+        for (uint32_t m = 0; mode != NULL && m < sizeof(modes) / sizeof(modes[0]); m++)
+            if (strcmp(mode, modes[m]) == 0)
+                config.mode = m;
+        config.input = json_int(item, "input", -1);
+        config.input_b = json_int(item, "input_b", -1);
+        config.both_edges = cJSON_IsTrue(cJSON_GetObjectItem(item, "both_edges"));
+        config.filter_ns = json_int(item, "filter_ns", 0);
+        config.compare = json_int(item, "compare", 0);
+        config.output = json_int(item, "output", -1);
+        config.pulse_ms = json_int(item, "pulse_ms", 0);
+        config.preset = json_int(item, "preset", 0);
+        config.preset_m = json_int(item, "preset_m", -1);
+        config.sim_hz = json_int(item, "sim_hz", 0);
+
+        if (ladder_hsc_add(&config) < 0)
+            ESP_LOGE(TAG, "ERROR counter %" PRIu32 " of %s", added, file);
+        else
+            added++;
+    }
+
+    cJSON_Delete(root);
+    return added;
+}
+
+uint32_t ladder_hsc_qty(void) {
+    return hsc_qty;
+}
+
+bool ladder_hsc_start(void) {
+    bool ok = true;
+
+    if (hsc_qty == 0)
+        return true;
+
+    // the handlers stay in IRAM, pulses are not lost while the flash is busy
+    gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+
+    for (uint32_t n = 0; n < hsc_qty; n++) {
+        hsc_t *counter = &hsc[n];
+
+        if (!counter->started) {
+            switch (counter->config.mode) {
+                case LADDER_HSC_PCNT:
+                    counter->started = hsc_pcnt_start(counter);
+                    break;
+                case LADDER_HSC_ISR:
+                    counter->started = gpio_isr_handler_add(inputs[counter->config.input], hsc_isr, counter) == ESP_OK &&
+                                       (counter->config.input_b < 0 || gpio_isr_handler_add(inputs[counter->config.input_b], hsc_isr, counter) == ESP_OK);
+                    break;
+                default:
+                    counter->started = true;
+                    break;
+            }
+            if (!counter->started) {
+                ESP_LOGE(TAG, "ERROR starting counter %" PRIu32, n);
+                ok = false;
+                continue;
+            }
+        }
+
+        // the local module input init configures the pins again, with interrupts disabled
+        if (counter->config.mode == LADDER_HSC_ISR) {
+            gpio_int_type_t edge;
+            if (counter->config.input_b >= 0 || counter->config.both_edges)
+                edge = GPIO_INTR_ANYEDGE;
+            else
+#ifdef INVERT_INPUT
+                edge = GPIO_INTR_NEGEDGE;
+#else
+                edge = GPIO_INTR_POSEDGE;
+#endif
+            gpio_set_intr_type(inputs[counter->config.input], edge);
+            gpio_intr_enable(inputs[counter->config.input]);
+            if (counter->config.input_b >= 0) {
+                gpio_set_intr_type(inputs[counter->config.input_b], GPIO_INTR_ANYEDGE);
+                gpio_intr_enable(inputs[counter->config.input_b]);
+                counter->state.quad = (gpio_get_level(inputs[counter->config.input]) << 1) | gpio_get_level(inputs[counter->config.input_b]);
+            }
+        }
+    }
+
+    if (hsc_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = hsc_timer_cb, //
+            .name = "hsc",            //
+        };
+        if (esp_timer_create(&timer_args, &hsc_timer) != ESP_OK || esp_timer_start_periodic(hsc_timer, LADDER_HSC_SIM_MS * 1000) != ESP_OK) {
+            ESP_LOGE(TAG, "ERROR starting timer");
+            return false;
+        }
+    }
+
+    return ok;
+}
+
+void ladder_hsc_read(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    int64_t now = esp_timer_get_time();
+
+    for (uint32_t n = 0; n < hsc_qty; n++) {
+        hsc_t *counter = &hsc[n];
+        uint32_t iw = LADDER_HSC_IW_FIRST + 2 * n;
+
+        if (counter->config.preset_m >= 0 && counter->config.preset_m < (*ladder_ctx).ladder.quantity.m) {
+            bool level = (*ladder_ctx).memory.M[counter->config.preset_m] != 0;
+            if (level && !counter->preset_level)
+                ladder_hsc_preset(n);
+            counter->preset_level = level;
+        }
+
+        ladder_hsc_counter_pulse(&counter->state, counter->config.pulse_ms, now);
+
+        if (iw + 1 < (*ladder_ctx).input[id].iw_qty) {
+            (*ladder_ctx).input[id].IW[iw] = hsc_count(counter);
+            (*ladder_ctx).input[id].IW[iw + 1] = __atomic_load_n(&counter->state.freq, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+bool ladder_hsc_output(uint32_t port) {
+    for (uint32_t n = 0; n < hsc_qty; n++)
+        if (hsc[n].state.latched && hsc[n].config.output == (int8_t)port)
+            return true;
+
+    return false;
+}
+
+void ladder_hsc_preset(uint32_t n) {
+    if (n >= hsc_qty)
+        return;
+
+    hsc_t *counter = &hsc[n];
+    if (counter->config.mode == LADDER_HSC_PCNT) {
+        pcnt_unit_clear_count(counter->unit);
+        __atomic_store_n(&counter->base, counter->config.preset, __ATOMIC_RELAXED);
+    }
+
+    portENTER_CRITICAL(&hsc_mux);
+    ladder_hsc_counter_preset(&counter->state);
+    portEXIT_CRITICAL(&hsc_mux);
+}
+
+uint32_t ladder_hsc_info(ladder_hsc_info_t *info, uint32_t max) {
+    uint32_t n;
+
+    for (n = 0; n < hsc_qty && n < max; n++) {
+        info[n].mode = hsc[n].config.mode;
+        info[n].count = hsc_count(&hsc[n]);
+        info[n].freq = __atomic_load_n(&hsc[n].state.freq, __ATOMIC_RELAXED);
+        info[n].fires = hsc[n].state.fires;
+        info[n].latched = hsc[n].state.latched;
+    }
+
+    return n;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_HSC_H_
+#define LADDER_HSC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+
+#define LADDER_HSC_MAX      4          // counters
+#define LADDER_HSC_IW_FIRST 2          // local module IW of the first counter, IW[0..1] are the analog inputs
+#define LADDER_HSC_GATE_MS  100        // frequency measurement gate
+#define LADDER_HSC_SIM_MS   10         // simulated pulses are added at this period
+#define LADDER_HSC_CONFIG   "hsc.json" // counters loaded at boot
+
+/**
+ * @enum ladder_hsc_mode_t
+ * @brief Pulse source
+ *
+ */
+typedef enum LADDER_HSC_MODE {
+    LADDER_HSC_PCNT, // pulse counter peripheral
+    LADDER_HSC_ISR,  // GPIO interrupt per edge
+    LADDER_HSC_SIM,  // no input: "sim_hz" pulses per second, for testing without wiring
+} ladder_hsc_mode_t;
+
+/**
+ * @struct ladder_hsc_config_s
+ * @brief Counter
+ *
+ */
+typedef struct ladder_hsc_config_s {
+    uint8_t mode;       // ladder_hsc_mode_t
+    int8_t input;       // inputs[] index of the pulses (quadrature A)
+    int8_t input_b;     // inputs[] index of quadrature B, -1: single input, counting up
+    bool both_edges;    // single input: count both edges
+    uint32_t filter_ns; // PCNT glitch filter, 0: none
+    int32_t compare;    // the output fires every "compare" counts from the preset value, 0: none (PCNT: up to 32767)
+    int8_t output;      // outputs[] index fired on compare, -1: none
+    uint32_t pulse_ms;  // output pulse, 0: latched until the next preset
+    int32_t preset;     // value loaded by a preset
+    int16_t preset_m;   // M register presetting the counter on its rising edge, -1: none
+    uint32_t sim_hz;    // LADDER_HSC_SIM
+} ladder_hsc_config_t;
+
+/**
+ * @struct ladder_hsc_info_s
+ * @brief Counter status
+ *
+ */
+typedef struct ladder_hsc_info_s {
+    ladder_hsc_mode_t mode; //
+    int32_t count;          //
+    int32_t freq;           // pulses per second, signed with the direction
+    uint32_t fires;         // compare matches
+    bool latched;           // compare output on
+} ladder_hsc_info_t;
+
+/**
+ * @fn int ladder_hsc_add(const ladder_hsc_config_t*)
+ * @brief Add a counter. Its count goes to IW[LADDER_HSC_IW_FIRST + 2 * n] and its frequency to the next IW of the
+ *        local module. Call before the ladder is started and after the analog I/O: inputs sampled by the ADC and
+ *        outputs mapped to a QW are refused.
+ *
+ * @param config Counter
+ * @return Counter number or -1
+ */
+int ladder_hsc_add(const ladder_hsc_config_t *config);
+
+/**
+ * @fn uint32_t ladder_hsc_load(const char*)
+ * @brief Read a counters file and add them
+ *
+ *        {"counters":[{"mode":"pcnt","input":2,"input_b":3,"filter_ns":1000},
+ *                     {"mode":"isr","input":4,"compare":500,"output":5,"pulse_ms":100,"preset":0,"preset_m":10},
+ *                     {"mode":"sim","sim_hz":2500,"compare":1000,"output":4}]}
+ *
+ * @param file File name, relative to the mount point
+ * @return Counters added
+ */
+uint32_t ladder_hsc_load(const char *file);
+
+/**
+ * @fn uint32_t ladder_hsc_qty(void)
+ * @brief Counters quantity
+ *
+ * @return Counters
+ */
+uint32_t ladder_hsc_qty(void);
+
+/**
+ * @fn bool ladder_hsc_start(void)
+ * @brief Start counting. Called by the local module input init, after the GPIO configuration. Idempotent.
+ *
+ * @return true if every counter runs
+ */
+bool ladder_hsc_start(void);
+
+/**
+ * @fn void ladder_hsc_read(ladder_ctx_t*, uint32_t)
+ * @brief Scan read: presets from the M registers and counts and frequencies into the module IW
+ *
+ * @param ladder_ctx Ladder context
+ * @param id Local module
+ */
+void ladder_hsc_read(ladder_ctx_t *ladder_ctx, uint32_t id);
+
+/**
+ * @fn bool ladder_hsc_output(uint32_t)
+ * @brief Compare output state, or'ed with Q by the local module write
+ *
+ * @param port outputs[] index
+ * @return true if a counter holds the output on
+ */
+bool ladder_hsc_output(uint32_t port);
+
+/**
+ * @fn void ladder_hsc_preset(uint32_t)
+ * @brief Load the preset value and release the compare output
+ *
+ * @param n Counter
+ */
+void ladder_hsc_preset(uint32_t n);
+
+/**
+ * @fn uint32_t ladder_hsc_info(ladder_hsc_info_t*, uint32_t)
+ * @brief Counters status
+ *
+ * @param info Status
+ * @param max Status array size
+ * @return Counters quantity
+ */
+uint32_t ladder_hsc_info(ladder_hsc_info_t *info, uint32_t max);
+
+#endif /* LADDER_HSC_H_ */
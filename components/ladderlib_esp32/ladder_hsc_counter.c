@@ -0,0 +1,110 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_attr.h"
+
+#include "ladder_hsc_counter.h"
+
+// x4 quadrature decoding: [previous A/B][current A/B]
+static const DRAM_ATTR int8_t quad_table[16] = {
+    0,  -1, 1,  0,  //
+    1,  0,  0,  -1, //
+    -1, 0,  0,  1,  //
+    0,  1,  -1, 0,  //
+};
+
+void ladder_hsc_counter_init(ladder_hsc_counter_t *counter, int32_t preset, int32_t compare) {
+    memset(counter, 0, sizeof(ladder_hsc_counter_t));
+    counter->count = preset;
+    counter->preset = preset;
+    counter->compare = compare;
+    counter->next = preset + compare;
+    counter->gate_skip = true;
+}
+
+int32_t IRAM_ATTR ladder_hsc_counter_quad(ladder_hsc_counter_t *counter, uint8_t state) {
+    int32_t delta = quad_table[(counter->quad << 2) | state];
+
+    counter->quad = state;
+    return delta;
+}
+
+uint32_t IRAM_ATTR ladder_hsc_counter_add(ladder_hsc_counter_t *counter, int32_t delta, int64_t now) {
+    uint32_t matches = 0;
+
+    // the scan reads the count with a single atomic load
+    int32_t count = __atomic_add_fetch(&counter->count, delta, __ATOMIC_RELAXED);
+    if (counter->compare > 0) {
+        while (count >= counter->next) {
+            counter->next += counter->compare;
+            matches++;
+        }
+    }
+
+    if (matches > 0) {
+        counter->fires += matches;
+        counter->fire_time = now;
+    }
+
+    return matches;
+}
+
+void ladder_hsc_counter_preset(ladder_hsc_counter_t *counter) {
+    __atomic_store_n(&counter->count, counter->preset, __ATOMIC_RELAXED);
+    counter->next = counter->preset + counter->compare;
+    counter->latched = false;
+    counter->gate_skip = true;
+}
+
+uint32_t ladder_hsc_counter_sim(ladder_hsc_counter_t *counter, uint32_t hz, uint32_t period_ms) {
+    uint32_t pulses;
+
+    counter->sim_frac += hz * period_ms;
+    pulses = counter->sim_frac / 1000;
+    counter->sim_frac %= 1000;
+
+    return pulses;
+}
+
+void ladder_hsc_counter_gate(ladder_hsc_counter_t *counter, int32_t count, int64_t now) {
+    if (!counter->gate_skip && now > counter->gate_time)
+        __atomic_store_n(&counter->freq, (int32_t)((int64_t)(count - counter->gate_count) * 1000000 / (now - counter->gate_time)), __ATOMIC_RELAXED);
+    counter->gate_skip = false;
+    counter->gate_count = count;
+    counter->gate_time = now;
+}
+
+void ladder_hsc_counter_pulse(ladder_hsc_counter_t *counter, uint32_t pulse_ms, int64_t now) {
+    if (counter->latched && pulse_ms > 0 && now - counter->fire_time >= (int64_t)pulse_ms * 1000)
+        counter->latched = false;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_HSC_COUNTER_H_
+#define LADDER_HSC_COUNTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct ladder_hsc_counter_s
+ * @brief Counting state of a high speed counter, shared by the interrupt, the timer and the scan. The interrupt side
+ *        runs under the caller's critical section; the scan reads count and freq with single atomic loads.
+ *
+ */
+typedef struct ladder_hsc_counter_s {
+    int32_t count;      //
+    int32_t preset;     // value loaded by a preset
+    int32_t compare;    // a match every "compare" counts from the preset value, 0: none
+    int32_t next;       // next compare value
+    uint8_t quad;       // last A/B state
+    int32_t freq;       // pulses per second, signed with the direction
+    int32_t gate_count; //
+    int64_t gate_time;  // us
+    bool gate_skip;     // a preset broke the measurement
+    uint32_t sim_frac;  // simulated pulses * 1000 not added yet
+    uint32_t fires;     // compare matches
+    bool latched;       // compare output on
+    int64_t fire_time;  // us
+} ladder_hsc_counter_t;
+
+/**
+ * @fn void ladder_hsc_counter_init(ladder_hsc_counter_t*, int32_t, int32_t)
+ * @brief Counter at its preset value
+ *
+ * @param counter Counter
+ * @param preset Preset value
+ * @param compare Compare step, 0: none
+ */
+void ladder_hsc_counter_init(ladder_hsc_counter_t *counter, int32_t preset, int32_t compare);
+
+/**
+ * @fn int32_t ladder_hsc_counter_quad(ladder_hsc_counter_t*, uint8_t)
+ * @brief x4 quadrature decoding. A step skipping a state (both inputs changed) is not counted.
+ *
+ * @param counter Counter
+ * @param state (A << 1) | B
+ * @return Counts, -1, 0 or 1
+ */
+int32_t ladder_hsc_counter_quad(ladder_hsc_counter_t *counter, uint8_t state);
+
+/**
+ * @fn uint32_t ladder_hsc_counter_add(ladder_hsc_counter_t*, int32_t, int64_t)
+ * @brief Add counts and latch the compare output for every compare value reached
+ *
+ * @param counter Counter
+ * @param delta Counts
+ * @param now Time, us
+ * @return Compare matches, the caller switches the output on if not 0
+ */
+uint32_t ladder_hsc_counter_add(ladder_hsc_counter_t *counter, int32_t delta, int64_t now);
+
+/**
+ * @fn void ladder_hsc_counter_preset(ladder_hsc_counter_t*)
+ * @brief Load the preset value, release the compare output and skip the frequency gate in progress
+ *
+ * @param counter Counter
+ */
+void ladder_hsc_counter_preset(ladder_hsc_counter_t *counter);
+
+/**
+ * @fn uint32_t ladder_hsc_counter_sim(ladder_hsc_counter_t*, uint32_t, uint32_t)
+ * @brief Simulated pulses elapsed in a period, fractions carried to the next one
+ *
+ * @param counter Counter
+ * @param hz Pulses per second
+ * @param period_ms Period
+ * @return Pulses to add
+ */
+uint32_t ladder_hsc_counter_sim(ladder_hsc_counter_t *counter, uint32_t hz, uint32_t period_ms);
+
+/**
+ * @fn void ladder_hsc_counter_gate(ladder_hsc_counter_t*, int32_t, int64_t)
+ * @brief End of a frequency gate: pulses per second since the previous one
+ *
+ * @param counter Counter
+ * @param count Count now
+ * @param now Time, us
+ */
+void ladder_hsc_counter_gate(ladder_hsc_counter_t *counter, int32_t count, int64_t now);
+
+/**
+ * @fn void ladder_hsc_counter_pulse(ladder_hsc_counter_t*, uint32_t, int64_t)
+ * @brief Release the compare output once it was on for "pulse_ms"
+ *
+ * @param counter Counter
+ * @param pulse_ms Output pulse, 0: latched until the next preset
+ * @param now Time, us
+ */
+void ladder_hsc_counter_pulse(ladder_hsc_counter_t *counter, uint32_t pulse_ms, int64_t now);
+
+#endif /* LADDER_HSC_COUNTER_H_ */
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ladder_io_exchange.h"
+
+static const char *TAG = "ladder_io_exchange";
+
+#define IMAGE_SWAP(A, B)  \
+    do {                  \
+        uint8_t _t = (A); \
+        (A) = (B);        \
+        (B) = _t;         \
+    } while (0)
+
+static bool image_alloc(ladder_io_image_t *image, uint32_t bits, uint32_t words) {
+    image->bits = calloc(bits > 0 ? bits : 1, sizeof(uint8_t));
+    image->words = calloc(words > 0 ? words : 1, sizeof(int32_t));
+
+    return image->bits != NULL && image->words != NULL;
+}
+
+static void image_copy(ladder_io_image_t *dst, const ladder_io_image_t *src, uint32_t bits, uint32_t words) {
+    memcpy(dst->bits, src->bits, bits * sizeof(uint8_t));
+    memcpy(dst->words, src->words, words * sizeof(int32_t));
+}
+
+bool ladder_io_exchange_init(ladder_io_exchange_t *io, const ladder_io_module_def_t *def) {
+    bool ok = true;
+
+    memset(io, 0, sizeof(ladder_io_exchange_t));
+    io->def = *def;
+    if (io->def.stale_ms == 0)
+        io->def.stale_ms = LADDER_IO_STALE_PERIODS * (def->period_ms > 0 ? def->period_ms : 1);
+
+    for (uint32_t n = 0; n < 3; n++)
+        ok &= image_alloc(&io->in[n], def->i_qty, def->iw_qty);
+    for (uint32_t n = 0; n < 4; n++)
+        ok &= image_alloc(&io->out[n], def->q_qty, def->qw_qty);
+    if (!ok) {
+        ladder_io_exchange_free(io);
+        return false;
+    }
+
+    io->in_front = 0;
+    io->in_ready = 1;
+    io->in_back = 2;
+    io->out_prod = 1;
+    io->out_ready = 2;
+    io->out_cons = 3;
+    portMUX_INITIALIZE(&io->mux);
+
+    return true;
+}
+
+void ladder_io_exchange_free(ladder_io_exchange_t *io) {
+    for (uint32_t n = 0; n < 3; n++) {
+        free(io->in[n].bits);
+        free(io->in[n].words);
+        io->in[n].bits = NULL;
+        io->in[n].words = NULL;
+    }
+    for (uint32_t n = 0; n < 4; n++) {
+        free(io->out[n].bits);
+        free(io->out[n].words);
+        io->out[n].bits = NULL;
+        io->out[n].words = NULL;
+    }
+}
+
+void ladder_io_exchange_task(void *arg) {
+    ladder_io_exchange_t *io = arg;
+    TickType_t period = pdMS_TO_TICKS(io->def.period_ms) > 0 ? pdMS_TO_TICKS(io->def.period_ms) : 1;
+    TickType_t wake;
+
+    if (io->def.init != NULL && !io->def.init(io->def.arg)) {
+        ESP_LOGE(TAG, "ERROR initializing module %s", io->def.name);
+        io->task = NULL;
+        vTaskDelete(NULL);
+    }
+
+    wake = xTaskGetTickCount();
+    while (1) {
+        ladder_io_exchange_poll(io);
+        vTaskDelayUntil(&wake, period);
+    }
+}
+
+void ladder_io_exchange_poll(ladder_io_exchange_t *io) {
+    portENTER_CRITICAL(&io->mux);
+    if (io->out_fresh) {
+        IMAGE_SWAP(io->out_ready, io->out_cons);
+        io->out_fresh = false;
+    }
+    portEXIT_CRITICAL(&io->mux);
+
+    int64_t start = esp_timer_get_time();
+    bool ok = io->def.poll(io->def.arg, &io->out[io->out_cons], &io->in[io->in_back]);
+    int64_t now = esp_timer_get_time();
+
+    io->poll_us = now - start;
+    if (io->poll_us > io->poll_max_us)
+        io->poll_max_us = io->poll_us;
+
+    if (ok) {
+        portENTER_CRITICAL(&io->mux);
+        IMAGE_SWAP(io->in_back, io->in_ready);
+        io->in_fresh = true;
+        io->in_time = now;
+        portEXIT_CRITICAL(&io->mux);
+        io->polls++;
+    } else {
+        io->errors++;
+    }
+}
+
+bool ladder_io_exchange_read(ladder_io_exchange_t *io) {
+    int64_t in_time;
+
+    portENTER_CRITICAL(&io->mux);
+    if (io->in_fresh) {
+        IMAGE_SWAP(io->in_front, io->in_ready);
+        io->in_fresh = false;
+    }
+    in_time = io->in_time;
+    portEXIT_CRITICAL(&io->mux);
+
+    bool stale = in_time == 0 || esp_timer_get_time() - in_time > (int64_t)io->def.stale_ms * 1000;
+    if (stale != io->stale) {
+        io->stale = stale;
+        if (stale) {
+            io->faults++;
+            ESP_LOGW(TAG, "module %s inputs stale", io->def.name);
+        } else {
+            ESP_LOGI(TAG, "module %s inputs updated", io->def.name);
+        }
+    }
+
+    if (stale && io->def.stale_clear) {
+        memset(io->in[io->in_front].bits, 0, io->def.i_qty * sizeof(uint8_t));
+        memset(io->in[io->in_front].words, 0, io->def.iw_qty * sizeof(int32_t));
+    }
+
+    return stale;
+}
+
+void ladder_io_exchange_write(ladder_io_exchange_t *io) {
+    image_copy(&io->out[io->out_prod], &io->out[0], io->def.q_qty, io->def.qw_qty);
+
+    portENTER_CRITICAL(&io->mux);
+    IMAGE_SWAP(io->out_prod, io->out_ready);
+    io->out_fresh = true;
+    portEXIT_CRITICAL(&io->mux);
+}
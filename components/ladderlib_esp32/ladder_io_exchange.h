@@ -0,0 +1,167 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_IO_EXCHANGE_H_
+#define LADDER_IO_EXCHANGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define LADDER_IO_STALE_PERIODS 3 // default staleness limit, in polling periods
+
+/**
+ * @struct ladder_io_image_s
+ * @brief Module process image, one direction
+ *
+ */
+typedef struct ladder_io_image_s {
+    uint8_t *bits;  // I or Q
+    int32_t *words; // IW or QW
+} ladder_io_image_t;
+
+/**
+ * @brief Module poll, called from the module task every period: write "out" to the device and read the device into
+ *        "in". Every point of "in" must be written. Return false if the device didn't answer, "in" is then discarded.
+ *
+ */
+typedef bool (*ladder_io_poll_fn)(void *arg, const ladder_io_image_t *out, ladder_io_image_t *in);
+
+/**
+ * @brief Module start, called from the module task before the first poll
+ *
+ */
+typedef bool (*ladder_io_init_fn)(void *arg);
+
+/**
+ * @struct ladder_io_module_def_s
+ * @brief Module declaration
+ *
+ */
+typedef struct ladder_io_module_def_s {
+    const char *name;       // literal
+    uint32_t i_qty;         // I points
+    uint32_t iw_qty;        // IW points
+    uint32_t q_qty;         // Q points
+    uint32_t qw_qty;        // QW points
+    uint32_t period_ms;     // polling period
+    uint32_t stale_ms;      // inputs older than this are a fault, 0: LADDER_IO_STALE_PERIODS periods
+    bool stale_clear;       // stale inputs read as 0, else the last values are kept
+    ladder_io_init_fn init; // may be NULL
+    ladder_io_poll_fn poll; //
+    void *arg;              // init and poll argument
+} ladder_io_module_def_t;
+
+/**
+ * @struct ladder_io_exchange_s
+ * @brief Process images shared by the scan and the module task
+ *
+ */
+typedef struct ladder_io_exchange_s {
+    ladder_io_module_def_t def; //
+
+    // inputs, triple buffer: the scan owns "front", the task owns "back", "ready" is the newest complete image
+    ladder_io_image_t in[3]; //
+    uint8_t in_front;        //
+    uint8_t in_ready;        //
+    uint8_t in_back;         //
+    bool in_fresh;           // "ready" is newer than "front"
+    int64_t in_time;         // us of the last successful poll, 0: never
+
+    // outputs: the ladder writes out[0], the scan copies it to "prod" and publishes it as "ready", the task polls with "cons"
+    ladder_io_image_t out[4]; //
+    uint8_t out_prod;         //
+    uint8_t out_ready;        //
+    uint8_t out_cons;         //
+    bool out_fresh;           // "ready" is newer than "cons"
+
+    portMUX_TYPE mux;     // image exchange
+    TaskHandle_t task;    //
+    bool stale;           //
+    uint32_t polls;       //
+    uint32_t errors;      //
+    uint32_t faults;      //
+    uint32_t poll_us;     //
+    uint32_t poll_max_us; //
+} ladder_io_exchange_t;
+
+/**
+ * @fn bool ladder_io_exchange_init(ladder_io_exchange_t*, const ladder_io_module_def_t*)
+ * @brief Allocate the images of a module, all zero
+ *
+ * @param io Exchange
+ * @param def Declaration, copied
+ * @return false if out of memory, the images are then freed
+ */
+bool ladder_io_exchange_init(ladder_io_exchange_t *io, const ladder_io_module_def_t *def);
+
+/**
+ * @fn void ladder_io_exchange_free(ladder_io_exchange_t*)
+ * @brief Free the images, the task must not be running
+ *
+ * @param io Exchange
+ */
+void ladder_io_exchange_free(ladder_io_exchange_t *io);
+
+/**
+ * @fn void ladder_io_exchange_task(void*)
+ * @brief Module task: init, then poll the device every period with the newest output image
+ *
+ * @param arg Exchange
+ */
+void ladder_io_exchange_task(void *arg);
+
+/**
+ * @fn void ladder_io_exchange_poll(ladder_io_exchange_t*)
+ * @brief One device poll, from the module task
+ *
+ * @param io Exchange
+ */
+void ladder_io_exchange_poll(ladder_io_exchange_t *io);
+
+/**
+ * @fn bool ladder_io_exchange_read(ladder_io_exchange_t*)
+ * @brief Scan: make the newest input image in[in_front] and check its age, never waits on the device
+ *
+ * @param io Exchange
+ * @return true if the inputs are stale
+ */
+bool ladder_io_exchange_read(ladder_io_exchange_t *io);
+
+/**
+ * @fn void ladder_io_exchange_write(ladder_io_exchange_t*)
+ * @brief Scan: hand out[0] over to the module task
+ *
+ * @param io Exchange
+ */
+void ladder_io_exchange_write(ladder_io_exchange_t *io);
+
+#endif /* LADDER_IO_EXCHANGE_H_ */
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ladder.h"
+#include "ladder_io_modules.h"
+#include "ladder_registers.h"
+
+static const char *TAG = "ladder_io_modules";
+
+typedef struct io_module_s {
+    ladder_io_exchange_t io; //
+    uint32_t in_id;          // ladder module number, I/IW
+    uint32_t out_id;         // ladder module number, Q/QW
+    uint8_t *Ih;             // previous scan inputs
+    uint8_t *Qh;             // previous scan outputs
+} io_module_t;
+
+static io_module_t *io_module[LADDER_IO_MODULES_MAX];
+static uint32_t io_modules = 0;
+static io_module_t *io_in[LADDER_IO_ID_MAX];
+static io_module_t *io_out[LADDER_IO_ID_MAX];
+
+static void module_free(io_module_t *module) {
+    ladder_io_exchange_free(&module->io);
+    free(module->Ih);
+    free(module->Qh);
+    free(module);
+}
+
+// scan: take the newest input image, never waits on the device
+static void io_read(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    io_module_t *module = io_in[id];
+
+    memcpy(module->Ih, module->io.in[module->io.in_front].bits, module->io.def.i_qty);
+    ladder_io_exchange_read(&module->io);
+
+    (*ladder_ctx).input[id].I = module->io.in[module->io.in_front].bits;
+    (*ladder_ctx).input[id].IW = module->io.in[module->io.in_front].words;
+
+    ladder_registers_force_inputs(ladder_ctx, id);
+}
+
+// scan: hand the output image over to the module task
+static void io_write(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    io_module_t *module = io_out[id];
+
+    ladder_registers_force_outputs(ladder_ctx, id);
+    memcpy(module->Qh, module->io.out[0].bits, module->io.def.q_qty);
+    ladder_io_exchange_write(&module->io);
+}
+
+static bool io_init_read(ladder_ctx_t *ladder_ctx, uint32_t id, bool init) {
+    io_module_t *module = io_in[id];
+
+    if (!init) {
+        (*ladder_ctx).input[id].I = NULL;
+        (*ladder_ctx).input[id].IW = NULL;
+        (*ladder_ctx).input[id].Ih = NULL;
+        (*ladder_ctx).input[id].i_qty = 0;
+        (*ladder_ctx).input[id].iw_qty = 0;
+        return true;
+    }
+
+    // the task keeps running while the ladder is stopped, outputs are then off
+    if (module->io.task == NULL && xTaskCreatePinnedToCore(ladder_io_exchange_task, module->io.def.name, LADDER_IO_TASK_STACK, &module->io,
+                                                           LADDER_IO_TASK_PRIO, &module->io.task, 0) != pdPASS) {
+        ESP_LOGE(TAG, "ERROR starting module %s task", module->io.def.name);
+        module->io.task = NULL;
+        return false;
+    }
+
+    (*ladder_ctx).input[id].I = module->io.in[module->io.in_front].bits;
+    (*ladder_ctx).input[id].IW = module->io.in[module->io.in_front].words;
+    (*ladder_ctx).input[id].Ih = module->Ih;
+    (*ladder_ctx).input[id].i_qty = module->io.def.i_qty;
+    (*ladder_ctx).input[id].iw_qty = module->io.def.iw_qty;
+
+    return true;
+}
+
+static bool io_init_write(ladder_ctx_t *ladder_ctx, uint32_t id, bool init) {
+    io_module_t *module = io_out[id];
+
+    if (!init) {
+        memset(module->io.out[0].bits, 0, module->io.def.q_qty * sizeof(uint8_t));
+        memset(module->io.out[0].words, 0, module->io.def.qw_qty * sizeof(int32_t));
+        memset(module->Qh, 0, module->io.def.q_qty);
+        ladder_io_exchange_write(&module->io);
+
+        (*ladder_ctx).output[id].Q = NULL;
+        (*ladder_ctx).output[id].QW = NULL;
+        (*ladder_ctx).output[id].Qh = NULL;
+        (*ladder_ctx).output[id].q_qty = 0;
+        (*ladder_ctx).output[id].qw_qty = 0;
+        return true;
+    }
+
+    (*ladder_ctx).output[id].Q = module->io.out[0].bits;
+    (*ladder_ctx).output[id].QW = module->io.out[0].words;
+    (*ladder_ctx).output[id].Qh = module->Qh;
+    (*ladder_ctx).output[id].q_qty = module->io.def.q_qty;
+    (*ladder_ctx).output[id].qw_qty = module->io.def.qw_qty;
+
+    return true;
+}
+
+int ladder_io_module_add(ladder_ctx_t *ladder_ctx, const ladder_io_module_def_t *def) {
+    if (def == NULL || def->poll == NULL || io_modules == LADDER_IO_MODULES_MAX || (*ladder_ctx).hw.io.fn_read_qty >= LADDER_IO_ID_MAX ||
+        (*ladder_ctx).hw.io.fn_write_qty >= LADDER_IO_ID_MAX)
+        return -1;
+
+    io_module_t *module = calloc(1, sizeof(io_module_t));
+    if (module == NULL)
+        return -1;
+
+    bool ok = ladder_io_exchange_init(&module->io, def);
+    module->Ih = calloc(def->i_qty > 0 ? def->i_qty : 1, sizeof(uint8_t));
+    module->Qh = calloc(def->q_qty > 0 ? def->q_qty : 1, sizeof(uint8_t));
+    if (!ok || module->Ih == NULL || module->Qh == NULL) {
+        module_free(module);
+        return -1;
+    }
+
+    module->in_id = (*ladder_ctx).hw.io.fn_read_qty;
+    module->out_id = (*ladder_ctx).hw.io.fn_write_qty;
+    io_in[module->in_id] = module;
+    io_out[module->out_id] = module;
+
+    if (!ladder_add_read_fn(ladder_ctx, io_read, io_init_read) || !ladder_add_write_fn(ladder_ctx, io_write, io_init_write)) {
+        ESP_LOGE(TAG, "ERROR adding module %s", def->name);
+        return -1;
+    }
+
+    io_module[io_modules++] = module;
+    ESP_LOGI(TAG, "module %s: I%" PRIu32 " Q%" PRIu32 " (%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 " points, %" PRIu32 " ms)", def->name,
+             module->in_id, module->out_id, def->i_qty, def->iw_qty, def->q_qty, def->qw_qty, def->period_ms);
+
+    return module->in_id;
+}
+
+uint32_t ladder_io_modules_info(ladder_io_module_info_t *info, uint32_t max) {
+    int64_t now = esp_timer_get_time();
+    uint32_t n;
+
+    for (n = 0; n < io_modules && n < max; n++) {
+        io_module_t *module = io_module[n];
+
+        portENTER_CRITICAL(&module->io.mux);
+        int64_t in_time = module->io.in_time;
+        portEXIT_CRITICAL(&module->io.mux);
+
+        info[n].name = module->io.def.name;
+        info[n].in_id = module->in_id;
+        info[n].out_id = module->out_id;
+        info[n].period_ms = module->io.def.period_ms;
+        info[n].age_ms = in_time == 0 ? UINT32_MAX : (now - in_time) / 1000;
+        info[n].stale = module->io.stale;
+        info[n].polls = module->io.polls;
+        info[n].errors = module->io.errors;
+        info[n].faults = module->io.faults;
+        info[n].poll_us = module->io.poll_us;
+        info[n].poll_max_us = module->io.poll_max_us;
+    }
+
+    return n;
+}
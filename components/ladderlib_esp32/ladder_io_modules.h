@@ -0,0 +1,85 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_IO_MODULES_H_
+#define LADDER_IO_MODULES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "ladder_io_exchange.h"
+
+#define LADDER_IO_MODULES_MAX    8    // registered modules
+#define LADDER_IO_ID_MAX         16   // ladder read/write function ids
+#define LADDER_IO_TASK_STACK     4096 // polling task
+#define LADDER_IO_TASK_PRIO      5    // below the ladder task
+
+/**
+ * @struct ladder_io_module_info_s
+ * @brief Module status
+ *
+ */
+typedef struct ladder_io_module_info_s {
+    const char *name;     //
+    uint32_t in_id;       // ladder module number of I/IW
+    uint32_t out_id;      // ladder module number of Q/QW
+    uint32_t period_ms;   //
+    uint32_t age_ms;      // inputs age, UINT32_MAX: never read
+    bool stale;           // inputs too old at the last scan
+    uint32_t polls;       // successful polls
+    uint32_t errors;      // failed polls
+    uint32_t faults;      // staleness faults
+    uint32_t poll_us;     // last poll duration
+    uint32_t poll_max_us; // longest poll
+} ladder_io_module_info_t;
+
+/**
+ * @fn int ladder_io_module_add(ladder_ctx_t*, const ladder_io_module_def_t*)
+ * @brief Register a module and add its read/write functions to the ladder. The scan only exchanges images with the
+ *        module: inputs are taken by a pointer swap and outputs handed over by a copy, the device is accessed by the
+ *        module task. Call before the ladder is started.
+ *
+ * @param ladder_ctx Ladder context
+ * @param def Declaration, copied
+ * @return Ladder module number of the inputs or -1
+ */
+int ladder_io_module_add(ladder_ctx_t *ladder_ctx, const ladder_io_module_def_t *def);
+
+/**
+ * @fn uint32_t ladder_io_modules_info(ladder_io_module_info_t*, uint32_t)
+ * @brief Modules status
+ *
+ * @param info Status
+ * @param max Status array size
+ * @return Modules quantity
+ */
+uint32_t ladder_io_modules_info(ladder_io_module_info_t *info, uint32_t max);
+
+#endif /* LADDER_IO_MODULES_H_ */
@@ -33,7 +33,7 @@
 #include "ladder_internals.h"
 
 ladder_prg_check_t ladder_program_check(ladder_ctx_t ladder_ctx) {
-    ladder_prg_check_t status;
+    ladder_prg_check_t status = { 0 };
 
     for (uint32_t nt = 0; nt < ladder_ctx.ladder.quantity.networks; nt++)
         for (uint32_t column = 0; column < ladder_ctx.network[nt].cols; column++)
@@ -118,3 +118,15 @@ ladder_prg_check_t ladder_program_check(ladder_ctx_t ladder_ctx) {
 end:
     return status;
 }
+
+ladder_prg_check_t ladder_network_check(ladder_ctx_t ladder_ctx, ladder_network_t *network, uint32_t id) {
+    ladder_prg_check_t status;
+
+    ladder_ctx.network = network;
+    ladder_ctx.ladder.quantity.networks = 1;
+
+    status = ladder_program_check(ladder_ctx);
+    status.network = id;
+
+    return status;
+}
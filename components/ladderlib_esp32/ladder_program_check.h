@@ -76,4 +76,15 @@ typedef struct ladder_prg_check_s {
  */
 ladder_prg_check_t ladder_program_check(ladder_ctx_t ladder_ctx);
 
+/**
+ * @fn ladder_prg_check_t ladder_network_check(ladder_ctx_t, ladder_network_t*, uint32_t)
+ * @brief Check a single network against the context I/O configuration
+ *
+ * @param ladder_ctx Ladder context
+ * @param network Network to check
+ * @param id Network id reported in status
+ * @return Status
+ */
+ladder_prg_check_t ladder_network_check(ladder_ctx_t ladder_ctx, ladder_network_t *network, uint32_t id);
+
 #endif /* LADDER_PROGRAM_CHECK_H_ */
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_program_check.h"
+#include "ladder_program_deploy.h"
+#include "ladder_program_json.h"
+#include "ladder_program_store.h"
+#include "webeditor.h"
+
+static const char *TAG = "ladder_program_deploy";
+
+static ladder_ctx_t *deploy_ctx = NULL;
+static QueueHandle_t deploy_queue = NULL;
+
+static void deploy_status(const char *path, const char *result, ladder_json_error_t json_err, ladder_prg_check_t *check, uint32_t ms) {
+    cJSON *status = cJSON_CreateObject();
+    if (status == NULL)
+        return;
+
+    cJSON_AddStringToObject(status, "file", path);
+    cJSON_AddStringToObject(status, "result", result);
+    cJSON_AddNumberToObject(status, "json_error", json_err);
+    cJSON *chk = cJSON_AddObjectToObject(status, "check");
+    if (chk != NULL) {
+        cJSON_AddNumberToObject(chk, "error", check->error);
+        cJSON_AddNumberToObject(chk, "network", check->network);
+        cJSON_AddNumberToObject(chk, "row", check->row);
+        cJSON_AddNumberToObject(chk, "column", check->column);
+        cJSON_AddNumberToObject(chk, "code", check->code);
+    }
+    cJSON_AddNumberToObject(status, "ms", ms);
+
+    char *text = cJSON_PrintUnformatted(status);
+    cJSON_Delete(status);
+    if (text == NULL)
+        return;
+
+    char *file_text = strdup(text);
+    if (file_text == NULL || fs_write_async(LADDER_DEPLOY_STATUS, file_text, strlen(file_text), FS_ASYNC_NORMAL, NULL, NULL) != 0)
+        ESP_LOGE(TAG, "ERROR writing %s", LADDER_DEPLOY_STATUS);
+
+    size_t len = strlen(text) + 40;
+    char *msg = malloc(len);
+    if (msg != NULL) {
+        snprintf(msg, len, "{\"action\":\"deploy\",\"data\":%s}", text);
+        ws_broadcast(msg);
+        free(msg);
+    }
+
+    free(text);
+}
+
+static void deploy_program(const char *path) {
+    ladder_prg_check_t check = { 0 };
+    ladder_json_error_t err;
+    const char *result = "applied";
+    int64_t start = esp_timer_get_time();
+
+    // parse into a copy of the context, the running program is untouched until the swap
+    ladder_ctx_t *shadow = malloc(sizeof(ladder_ctx_t));
+    if (shadow == NULL) {
+        ESP_LOGE(TAG, "ERROR allocating context");
+        return;
+    }
+    *shadow = *deploy_ctx;
+    (*shadow).network = NULL;
+    (*shadow).ladder.quantity.networks = 0;
+
+    err = ladder_json_to_program(path[0] == '/' ? path + 1 : path, NULL, shadow, false);
+    if (err != JSON_ERROR_OK) {
+        result = "parse_error";
+    } else if ((check = ladder_program_check(*shadow)).error != LADDER_ERR_PRG_CHECK_OK) {
+        result = "invalid";
+    } else {
+        // the replaced program is kept as the store rollback image
+        ladder_store_result_t res = ladder_program_store_swap(deploy_ctx, (*shadow).network, (*shadow).ladder.quantity.networks, 0);
+        if (res == LADDER_STORE_BUSY || res == LADDER_STORE_ERROR) {
+            result = "busy";
+        } else {
+            (*shadow).network = NULL;
+            if (res == LADDER_STORE_QUEUED)
+                result = "queued";
+        }
+    }
+
+    ladder_program_free((*shadow).network, (*shadow).ladder.quantity.networks);
+    free(shadow);
+
+    uint32_t ms = (esp_timer_get_time() - start) / 1000;
+    ESP_LOGI(TAG, "%s: %s (json %d, check %d at network %" PRIu32 ") %" PRIu32 " ms", path, result, err, check.error, check.network, ms);
+    deploy_status(path, result, err, &check, ms);
+}
+
+static void deploy_task(void *arg) {
+    char *path;
+
+    while (1) {
+        if (xQueueReceive(deploy_queue, &path, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        deploy_program(path);
+        free(path);
+    }
+}
+
+bool ladder_program_deploy_init(ladder_ctx_t *ladder_ctx) {
+    if (deploy_queue != NULL)
+        return true;
+
+    deploy_ctx = ladder_ctx;
+    deploy_queue = xQueueCreate(LADDER_DEPLOY_QUEUE_LEN, sizeof(char *));
+    if (deploy_queue == NULL)
+        return false;
+
+    if (xTaskCreate(deploy_task, "ladder_deploy", 8192, NULL, 3, NULL) != pdPASS) {
+        vQueueDelete(deploy_queue);
+        deploy_queue = NULL;
+        return false;
+    }
+
+    mkdir(MOUNT_POINT LADDER_DEPLOY_DIR, 0755);
+
+    return true;
+}
+
+void ladder_program_deploy_file(const char *path) {
+    size_t dir = strlen(LADDER_DEPLOY_DIR);
+    size_t len = strlen(path);
+
+    if (deploy_queue == NULL || strncmp(path, LADDER_DEPLOY_DIR "/", dir + 1) != 0 || len < dir + 6 || strcmp(path + len - 5, ".json") != 0)
+        return;
+
+    char *copy = strdup(path);
+    if (copy == NULL || xQueueSend(deploy_queue, &copy, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Deploy queue full, %s ignored", path);
+        free(copy);
+    }
+}
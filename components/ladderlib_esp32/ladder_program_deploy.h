@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_PROGRAM_DEPLOY_H_
+#define LADDER_PROGRAM_DEPLOY_H_
+
+#include <stdbool.h>
+
+#include "ladder.h"
+
+#define LADDER_DEPLOY_DIR              "/programs"          // uploads below this directory are deployed
+#define LADDER_DEPLOY_STATUS           "deploy_status.json" // result of the last deploy, relative to the mount point
+#define LADDER_DEPLOY_QUEUE_LEN        4                    // pending uploads
+
+/**
+ * @fn bool ladder_program_deploy_init(ladder_ctx_t*)
+ * @brief Start the deploy task
+ *
+ * @param ladder_ctx Ladder context the programs are applied to
+ * @return true if started
+ */
+bool ladder_program_deploy_init(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_program_deploy_file(const char*)
+ * @brief Queue an uploaded file. Files outside LADDER_DEPLOY_DIR or not ending in ".json" are ignored.
+ *        The program is parsed and checked in the deploy task and, if valid, swapped in at the next scan boundary
+ *        (ladder_program_store_swap, the replaced program can be rolled back to).
+ *        The result is written to LADDER_DEPLOY_STATUS and broadcast to the websocket clients.
+ *
+ * @param path File path relative to the mount point
+ */
+void ladder_program_deploy_file(const char *path);
+
+#endif /* LADDER_PROGRAM_DEPLOY_H_ */
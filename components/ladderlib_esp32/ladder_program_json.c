@@ -39,9 +39,13 @@
 #include "cJSON.h"
 #endif
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "hal_fs.h"
 #include "ladder.h"
 #include "ladder_program_json.h"
+#include "ladderlib_esp32_std.h"
 
 static const char *str_symbol[] = {
     "NOP",     //
@@ -172,11 +176,183 @@ static int write_file(const char *path, const char *content) {
     return 1;
 }
 
+static ladder_json_error_t json_to_network(cJSON *network_json, ladder_network_t *network) {
+    network->enable = true;
+
+    cJSON *rows_json = cJSON_GetObjectItem(network_json, "rows");
+    network->rows = (int)cJSON_GetNumberValue(rows_json);
+    cJSON *cols_json = cJSON_GetObjectItem(network_json, "cols");
+    network->cols = (int)cJSON_GetNumberValue(cols_json);
+
+    network->cells = calloc(network->rows, sizeof(ladder_cell_t *));
+    if (network->cells == NULL)
+        return JSON_ERROR_ALLOC_NETWORK;
+    for (int r = 0; r < network->rows; r++) {
+        network->cells[r] = calloc(network->cols, sizeof(ladder_cell_t));
+        if (network->cells[r] == NULL)
+            return JSON_ERROR_ALLOC_NETWORK;
+    }
+
+    cJSON *networkData = cJSON_GetObjectItem(network_json, "networkData");
+    for (int r = 0; r < network->rows; r++) {
+        cJSON *row_json = cJSON_GetArrayItem(networkData, r);
+        for (int c = 0; c < network->cols; c++) {
+            cJSON *cell_json = cJSON_GetArrayItem(row_json, c);
+            ladder_cell_t *cell = &network->cells[r][c];
+            cell->state = false;
+
+            cJSON *bar_json = cJSON_GetObjectItem(cell_json, "bar");
+            cell->vertical_bar = cJSON_IsTrue(bar_json);
+
+            cJSON *symbol_json = cJSON_GetObjectItem(cell_json, "symbol");
+            char *symbol = cJSON_GetStringValue(symbol_json);
+            cell->code = symbol != NULL ? get_instruction_code(symbol) : LADDER_INS_INV;
+            if (cell->code == LADDER_INS_INV)
+                return JSON_ERROR_INS_INV;
+
+            cJSON *data_json = cJSON_GetObjectItem(cell_json, "data");
+            int data_qty = cJSON_GetArraySize(data_json);
+            cell->data_qty = data_qty;
+            cell->data = calloc(data_qty, sizeof(ladder_value_t));
+
+            for (int d = 0; d < data_qty; d++) {
+                cJSON *data_item = cJSON_GetArrayItem(data_json, d);
+                cJSON *type_json = cJSON_GetObjectItem(data_item, "type");
+                char *type_str = cJSON_GetStringValue(type_json);
+                cell->data[d].type = type_str != NULL ? get_register_code(type_str) : LADDER_REGISTER_INV;
+
+                if (cell->data[d].type == LADDER_REGISTER_INV)
+                    return JSON_ERROR_TYPE_INV;
+
+                cJSON *value_json = cJSON_GetObjectItem(data_item, "value");
+                char *value_str = cJSON_GetStringValue(value_json);
+                if (value_str == NULL)
+                    return JSON_ERROR_INVALIDVALUE;
+
+                if (cell->code == LADDER_INS_TON || cell->code == LADDER_INS_TOF || cell->code == LADDER_INS_TP) {
+                    cell->data[d].value.u32 = strtoul(value_str, NULL, 10);
+                } else {
+                    switch (cell->data[d].type) {
+                        case LADDER_REGISTER_I:
+                        case LADDER_REGISTER_Q:
+                            if (!parse_module_port(value_str, &(cell->data[d].value.mp)))
+                                return JSON_ERROR_INVALIDVALUE;
+                            break;
+
+                        case LADDER_REGISTER_S:
+                            cell->data[d].value.cstr = strdup(value_str);
+                            break;
+                        case LADDER_REGISTER_R:
+                            cell->data[d].value.real = atof(value_str);
+                            break;
+
+                        default:
+                            cell->data[d].value.u32 = strtoul(value_str, NULL, 10);
+                            break;
+                    }
+                }
+            }
+        }
+    }
+
+    return JSON_ERROR_OK;
+}
+
+static ladder_json_error_t network_to_json(ladder_ctx_t *ladder_ctx, uint32_t n, cJSON **network_out) {
+    cJSON *network_obj = cJSON_CreateObject();
+    if (network_obj == NULL)
+        return JSON_ERROR_CREATENETOBJT;
+
+    cJSON_AddNumberToObject(network_obj, "id", n);
+    cJSON_AddNumberToObject(network_obj, "rows", (*ladder_ctx).network[n].rows);
+    cJSON_AddNumberToObject(network_obj, "cols", (*ladder_ctx).network[n].cols);
+
+    cJSON *networkData = cJSON_CreateArray();
+    if (networkData == NULL) {
+        cJSON_Delete(network_obj);
+        return JSON_ERROR_CREATENETDATA;
+    }
+    cJSON_AddItemToObject(network_obj, "networkData", networkData);
+
+    for (uint32_t r = 0; r < (*ladder_ctx).network[n].rows; r++) {
+        cJSON *row_array = cJSON_CreateArray();
+        if (row_array == NULL) {
+            cJSON_Delete(network_obj);
+            return JSON_ERROR_CREATEROWARRAY;
+        }
+        cJSON_AddItemToArray(networkData, row_array);
+
+        for (uint32_t c = 0; c < (*ladder_ctx).network[n].cols; c++) {
+            ladder_cell_t *cell = &((*ladder_ctx).network[n].cells[r][c]);
+            cJSON *cell_obj = cJSON_CreateObject();
+            if (cell_obj == NULL) {
+                cJSON_Delete(network_obj);
+                return JSON_ERROR_CREATECELLOBJ;
+            }
+            cJSON_AddItemToArray(row_array, cell_obj);
+
+            const char *symbol = (cell->code < sizeof(str_symbol) / sizeof(str_symbol[0])) ? str_symbol[cell->code] : "INV";
+            cJSON_AddStringToObject(cell_obj, "symbol", symbol);
+            cJSON_AddBoolToObject(cell_obj, "bar", cell->vertical_bar);
+
+            cJSON *data_array = cJSON_CreateArray();
+            if (data_array == NULL) {
+                cJSON_Delete(network_obj);
+                return JSON_ERROR_CREATEDATAARRAY;
+            }
+            cJSON_AddItemToObject(cell_obj, "data", data_array);
+
+            for (uint8_t d = 0; d < cell->data_qty; d++) {
+                ladder_value_t *val = &cell->data[d];
+                cJSON *data_obj = cJSON_CreateObject();
+                if (data_obj == NULL) {
+                    cJSON_Delete(network_obj);
+                    return JSON_ERROR_CREATEDATAOBJ;
+                }
+                cJSON_AddItemToArray(data_array, data_obj);
+
+                const char *type_str = ((cell->code == LADDER_INS_TON || cell->code == LADDER_INS_TOF || cell->code == LADDER_INS_TP) && d == 1)
+                                           ? ((val->type < sizeof(str_basetime) / sizeof(str_basetime[0])) ? str_basetime[val->type] : "INV")
+                                           : ((val->type < sizeof(str_types) / sizeof(str_types[0])) ? str_types[val->type] : "INV");
+                char val_str[16];
+                sprintf(val_str, "value%d", d);
+                cJSON_AddStringToObject(data_obj, "name", val_str);
+                cJSON_AddStringToObject(data_obj, "type", type_str);
+
+                char value_str[32];
+                switch (cell->data[d].type) {
+                    case LADDER_REGISTER_I:
+                    case LADDER_REGISTER_Q:
+                        snprintf(value_str, sizeof(value_str), "%u.%u", val->value.mp.module, val->value.mp.port);
+                        break;
+
+                    case LADDER_REGISTER_S:
+                        snprintf(value_str, sizeof(value_str), "%s", val->value.cstr ? val->value.cstr : "");
+                        break;
+                    case LADDER_REGISTER_R:
+                        snprintf(value_str, sizeof(value_str), "%f", val->value.real);
+                        break;
+
+                    default:
+                        snprintf(value_str, sizeof(value_str), "%lu", (unsigned long)val->value.u32);
+                        break;
+                }
+
+                cJSON_AddStringToObject(data_obj, "value", value_str);
+            }
+        }
+    }
+
+    *network_out = network_obj;
+    return JSON_ERROR_OK;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 ladder_json_error_t ladder_json_to_program(const char *prg, char *prg_extern, ladder_ctx_t *ladder_ctx, bool from_extern) {
     cJSON *root = NULL;
     char *json_string = NULL;
+    ladder_json_error_t err;
 
     if (!from_extern) {
         FILE *fp = fs_open(prg, "r");
@@ -218,78 +394,11 @@ ladder_json_error_t ladder_json_to_program(const char *prg, char *prg_extern, la
     }
 
     for (int n = 0; n < (*ladder_ctx).ladder.quantity.networks; n++) {
-        cJSON *network_json = cJSON_GetArrayItem(root, n);
-        ladder_network_t *network = &((*ladder_ctx).network[n]);
-        network->enable = true;
-
-        cJSON *rows_json = cJSON_GetObjectItem(network_json, "rows");
-        network->rows = (int)cJSON_GetNumberValue(rows_json);
-        cJSON *cols_json = cJSON_GetObjectItem(network_json, "cols");
-        network->cols = (int)cJSON_GetNumberValue(cols_json);
-
-        network->cells = calloc(network->rows, sizeof(ladder_cell_t *));
-        for (int r = 0; r < network->rows; r++) {
-            network->cells[r] = calloc(network->cols, sizeof(ladder_cell_t));
-        }
-
-        cJSON *networkData = cJSON_GetObjectItem(network_json, "networkData");
-        for (int r = 0; r < network->rows; r++) {
-            cJSON *row_json = cJSON_GetArrayItem(networkData, r);
-            for (int c = 0; c < network->cols; c++) {
-                cJSON *cell_json = cJSON_GetArrayItem(row_json, c);
-                ladder_cell_t *cell = &network->cells[r][c];
-                cell->state = false;
-
-                cJSON *bar_json = cJSON_GetObjectItem(cell_json, "bar");
-                cell->vertical_bar = cJSON_IsTrue(bar_json);
-
-                cJSON *symbol_json = cJSON_GetObjectItem(cell_json, "symbol");
-                char *symbol = cJSON_GetStringValue(symbol_json);
-                cell->code = get_instruction_code(symbol);
-                if (cell->code == LADDER_INS_INV)
-                    return JSON_ERROR_INS_INV;
-
-                cJSON *data_json = cJSON_GetObjectItem(cell_json, "data");
-                int data_qty = cJSON_GetArraySize(data_json);
-                cell->data_qty = data_qty;
-                cell->data = calloc(data_qty, sizeof(ladder_value_t));
-
-                for (int d = 0; d < data_qty; d++) {
-                    cJSON *data_item = cJSON_GetArrayItem(data_json, d);
-                    cJSON *type_json = cJSON_GetObjectItem(data_item, "type");
-                    char *type_str = cJSON_GetStringValue(type_json);
-                    cell->data[d].type = get_register_code(type_str);
-
-                    if (cell->data[d].type == LADDER_REGISTER_INV)
-                        return JSON_ERROR_TYPE_INV;
-
-                    cJSON *value_json = cJSON_GetObjectItem(data_item, "value");
-                    char *value_str = cJSON_GetStringValue(value_json);
-
-                    if (cell->code == LADDER_INS_TON || cell->code == LADDER_INS_TOF || cell->code == LADDER_INS_TP) {
-                        cell->data[d].value.u32 = strtoul(value_str, NULL, 10);
-                    } else {
-                        switch (cell->data[d].type) {
-                            case LADDER_REGISTER_I:
-                            case LADDER_REGISTER_Q:
-                                if (!parse_module_port(value_str, &(cell->data[d].value.mp)))
-                                    return JSON_ERROR_INVALIDVALUE;
-                                break;
-
-                            case LADDER_REGISTER_S:
-                                cell->data[d].value.cstr = strdup(value_str);
-                                break;
-                            case LADDER_REGISTER_R:
-                                cell->data[d].value.real = atof(value_str);
-                                break;
-
-                            default:
-                                cell->data[d].value.u32 = strtoul(value_str, NULL, 10);
-                                break;
-                        }
-                    }
-                }
-            }
+        if ((err = json_to_network(cJSON_GetArrayItem(root, n), &((*ladder_ctx).network[n]))) != JSON_ERROR_OK) {
+            cJSON_Delete(root);
+            if (!from_extern)
+                free(json_string);
+            return err;
         }
     }
 
@@ -300,161 +409,154 @@ ladder_json_error_t ladder_json_to_program(const char *prg, char *prg_extern, la
     return JSON_ERROR_OK;
 }
 
-ladder_json_error_t ladder_program_to_json(const char *prg, char **prg_extern, ladder_ctx_t *ladder_ctx, bool to_extern) {
-    if (ladder_ctx == NULL || (*ladder_ctx).network == NULL)
-        return JSON_ERROR_NOPROGRAM;
+ladder_json_error_t ladder_json_to_network(const char *json, size_t len, ladder_network_t *network) {
+    ladder_json_error_t err;
 
-    FILE *fp = NULL;
-    if (!to_extern) {
-        fp = fs_open(prg, "w");
-        if (fp == NULL) {
-            return JSON_ERROR_OPENFILE;
-        }
-    }
+    memset(network, 0, sizeof(ladder_network_t));
 
-    cJSON *root = cJSON_CreateArray();
-    if (root == NULL) {
-        if (!to_extern)
-            fclose(fp);
-        return JSON_ERROR_CREATEARRAY;
-    }
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!root)
+        return JSON_ERROR_PARSE;
 
-    for (uint32_t n = 0; n < (*ladder_ctx).ladder.quantity.networks; n++) {
-        cJSON *network_obj = cJSON_CreateObject();
-        if (network_obj == NULL) {
-            cJSON_Delete(root);
-            if (!to_extern)
-                fclose(fp);
-            return JSON_ERROR_CREATENETOBJT;
-        }
+    if ((err = json_to_network(root, network)) != JSON_ERROR_OK)
+        ladder_network_free(network);
 
-        cJSON_AddNumberToObject(network_obj, "id", n);
-        cJSON_AddNumberToObject(network_obj, "rows", (*ladder_ctx).network[n].rows);
-        cJSON_AddNumberToObject(network_obj, "cols", (*ladder_ctx).network[n].cols);
+    cJSON_Delete(root);
 
-        cJSON *networkData = cJSON_CreateArray();
-        if (networkData == NULL) {
-            cJSON_Delete(network_obj);
-            cJSON_Delete(root);
-            if (!to_extern)
-                fclose(fp);
-            return JSON_ERROR_CREATENETDATA;
-        }
+    return err;
+}
 
-        for (uint32_t r = 0; r < (*ladder_ctx).network[n].rows; r++) {
-            cJSON *row_array = cJSON_CreateArray();
-            if (row_array == NULL) {
-                cJSON_Delete(networkData);
-                cJSON_Delete(network_obj);
-                cJSON_Delete(root);
-                if (!to_extern)
-                    fclose(fp);
-                return JSON_ERROR_CREATEROWARRAY;
-            }
+void ladder_network_free(ladder_network_t *network) {
+    if (network->cells == NULL)
+        return;
 
-            for (uint32_t c = 0; c < (*ladder_ctx).network[n].cols; c++) {
-                ladder_cell_t *cell = &((*ladder_ctx).network[n].cells[r][c]);
-                cJSON *cell_obj = cJSON_CreateObject();
-                if (cell_obj == NULL) {
-                    cJSON_Delete(row_array);
-                    cJSON_Delete(networkData);
-                    cJSON_Delete(network_obj);
-                    cJSON_Delete(root);
-                    fclose(fp);
-                    return JSON_ERROR_CREATECELLOBJ;
-                }
+    for (uint32_t r = 0; r < network->rows; r++) {
+        if (network->cells[r] == NULL)
+            continue;
 
-                const char *symbol = (cell->code < sizeof(str_symbol) / sizeof(str_symbol[0])) ? str_symbol[cell->code] : "INV";
-                cJSON_AddStringToObject(cell_obj, "symbol", symbol);
-                cJSON_AddBoolToObject(cell_obj, "bar", cell->vertical_bar);
+        for (uint32_t c = 0; c < network->cols; c++) {
+            ladder_cell_t *cell = &network->cells[r][c];
+            if (cell->data == NULL)
+                continue;
 
-                cJSON *data_array = cJSON_CreateArray();
-                if (data_array == NULL) {
-                    cJSON_Delete(cell_obj);
-                    cJSON_Delete(row_array);
-                    cJSON_Delete(networkData);
-                    cJSON_Delete(network_obj);
-                    cJSON_Delete(root);
-                    if (!to_extern)
-                        fclose(fp);
-                    return JSON_ERROR_CREATEDATAARRAY;
-                }
+            if (cell->code != LADDER_INS_TON && cell->code != LADDER_INS_TOF && cell->code != LADDER_INS_TP)
+                for (uint8_t d = 0; d < cell->data_qty; d++)
+                    if (cell->data[d].type == LADDER_REGISTER_S)
+                        free(cell->data[d].value.cstr);
 
-                for (uint8_t d = 0; d < cell->data_qty; d++) {
-                    ladder_value_t *val = &cell->data[d];
-                    cJSON *data_obj = cJSON_CreateObject();
-                    if (data_obj == NULL) {
-                        cJSON_Delete(data_array);
-                        cJSON_Delete(cell_obj);
-                        cJSON_Delete(row_array);
-                        cJSON_Delete(networkData);
-                        cJSON_Delete(network_obj);
-                        cJSON_Delete(root);
-                        if (!to_extern)
-                            fclose(fp);
-                        return JSON_ERROR_CREATEDATAOBJ;
-                    }
+            free(cell->data);
+        }
+        free(network->cells[r]);
+    }
 
-                    const char *type_str = ((cell->code == LADDER_INS_TON || cell->code == LADDER_INS_TOF || cell->code == LADDER_INS_TP) && d == 1)
-                                               ? ((val->type < sizeof(str_basetime) / sizeof(str_basetime[0])) ? str_basetime[val->type] : "INV")
-                                               : ((val->type < sizeof(str_types) / sizeof(str_types[0])) ? str_types[val->type] : "INV");
-                    char val_str[16];
-                    sprintf(val_str, "value%d", d);
-                    cJSON_AddStringToObject(data_obj, "name", val_str);
-                    cJSON_AddStringToObject(data_obj, "type", type_str);
+    free(network->cells);
+    network->cells = NULL;
+}
 
-                    char value_str[32];
-                    switch (cell->data[d].type) {
-                        case LADDER_REGISTER_I:
-                        case LADDER_REGISTER_Q:
-                            snprintf(value_str, sizeof(value_str), "%u.%u", val->value.mp.module, val->value.mp.port);
-                            break;
+void ladder_program_free(ladder_network_t *network, uint32_t networks) {
+    if (network == NULL)
+        return;
 
-                        case LADDER_REGISTER_S:
-                            snprintf(value_str, sizeof(value_str), "%s", val->value.cstr ? val->value.cstr : "");
-                            break;
-                        case LADDER_REGISTER_R:
-                            snprintf(value_str, sizeof(value_str), "%f", val->value.real);
-                            break;
+    for (uint32_t n = 0; n < networks; n++)
+        ladder_network_free(&network[n]);
+    free(network);
+}
 
-                        default:
-                            snprintf(value_str, sizeof(value_str), "%lu", (unsigned long)val->value.u32);
-                            break;
-                    }
+typedef struct json_save_s {
+    SemaphoreHandle_t done; //
+    int result;             // of the temporary file write and the rename
+} json_save_t;
 
-                    cJSON_AddStringToObject(data_obj, "value", value_str);
-                    cJSON_AddItemToArray(data_array, data_obj);
-                }
+static void json_saved(const char *file, int result, void *arg) {
+    json_save_t *save = arg;
 
-                cJSON_AddItemToObject(cell_obj, "data", data_array);
-                cJSON_AddItemToArray(row_array, cell_obj);
-            }
+    save->result = result;
+    xSemaphoreGive(save->done);
+}
 
-            cJSON_AddItemToArray(networkData, row_array);
-        }
+ladder_json_error_t ladder_program_to_json(const char *prg, char **prg_extern, ladder_ctx_t *ladder_ctx, bool to_extern) {
+    ladder_json_error_t err;
 
-        cJSON_AddItemToObject(network_obj, "networkData", networkData);
+    if (ladder_ctx == NULL || (*ladder_ctx).network == NULL)
+        return JSON_ERROR_NOPROGRAM;
+
+    cJSON *root = cJSON_CreateArray();
+    if (root == NULL)
+        return JSON_ERROR_CREATEARRAY;
+
+    for (uint32_t n = 0; n < (*ladder_ctx).ladder.quantity.networks; n++) {
+        cJSON *network_obj = NULL;
+        if ((err = network_to_json(ladder_ctx, n, &network_obj)) != JSON_ERROR_OK) {
+            cJSON_Delete(root);
+            return err;
+        }
         cJSON_AddItemToArray(root, network_obj);
     }
 
     char *json_str = cJSON_Print(root);
-    if (json_str == NULL) {
-        cJSON_Delete(root);
-        if (!to_extern)
-            fclose(fp);
+    cJSON_Delete(root);
+    if (json_str == NULL)
         return JSON_ERROR_PRINTOBJ;
+
+    if (to_extern) {
+        (*prg_extern) = json_str;
+        return JSON_ERROR_OK;
     }
 
-    if (!to_extern)
-        fprintf(fp, "%s", json_str);
-    else {
-        (*prg_extern) = strdup(json_str);
+    // written by the storage task, in order with the other requests on the file, the caller waits for its result
+    json_save_t save = { xSemaphoreCreateBinary(), -1 };
+    if (save.done == NULL) {
+        free(json_str);
+        return JSON_ERROR_WRITEFILE;
     }
 
-    free(json_str);
-    cJSON_Delete(root);
-    if (!to_extern)
-        fclose(fp);
+    if (fs_write_async(prg, json_str, strlen(json_str), FS_ASYNC_HIGH, json_saved, &save) == 0)
+        xSemaphoreTake(save.done, portMAX_DELAY);
+    vSemaphoreDelete(save.done);
+
+    return save.result == 0 ? JSON_ERROR_OK : JSON_ERROR_WRITEFILE;
+}
+
+ladder_json_error_t ladder_program_to_json_stream(ladder_ctx_t *ladder_ctx, ladder_json_stream_fn stream_fn, void *arg) {
+    ladder_json_error_t err = JSON_ERROR_OK;
+    uint32_t generation = esp32_program_generation();
+
+    if (ladder_ctx == NULL || (*ladder_ctx).network == NULL)
+        return JSON_ERROR_NOPROGRAM;
+
+    if (!stream_fn("[", 1, arg))
+        return JSON_ERROR_STREAM;
+
+    // only one network is materialized at a time, the networks are read under the scan lock and sent without it
+    for (uint32_t n = 0;; n++) {
+        cJSON *network_obj = NULL;
+        char *json_str = NULL;
+
+        esp32_scan_lock();
+        if (esp32_program_generation() != generation)
+            err = JSON_ERROR_CHANGED;
+        else if (n < (*ladder_ctx).ladder.quantity.networks && (err = network_to_json(ladder_ctx, n, &network_obj)) == JSON_ERROR_OK)
+            json_str = cJSON_PrintUnformatted(network_obj);
+        esp32_scan_unlock();
+
+        if (network_obj != NULL)
+            cJSON_Delete(network_obj);
+        if (err != JSON_ERROR_OK)
+            return err;
+        if (network_obj == NULL)
+            break;
+        if (json_str == NULL)
+            return JSON_ERROR_PRINTOBJ;
+
+        bool ok = (n == 0 || stream_fn(",", 1, arg)) && stream_fn(json_str, strlen(json_str), arg);
+        free(json_str);
+        if (!ok)
+            return JSON_ERROR_STREAM;
+    }
+
+    if (!stream_fn("]", 1, arg))
+        return JSON_ERROR_STREAM;
+
     return JSON_ERROR_OK;
 }
 
@@ -30,6 +30,10 @@
 #ifndef LADDER_PROGRAM_PARSER_H
 #define LADDER_PROGRAM_PARSER_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "ladder.h"
 
 typedef enum JSON_ERROR {
@@ -52,11 +56,19 @@ typedef enum JSON_ERROR {
     JSON_ERROR_WRITEFILE,       //
     JSON_ERROR_INVALIDVALUE,    //
     JSON_ERROR_NOPROGRAM,       //
+    JSON_ERROR_STREAM,          //
+    JSON_ERROR_CHANGED,         // program swapped while streaming
     //////////////////////////////
     JSON_ERROR_FAIL             //
 
 } ladder_json_error_t;
 
+/**
+ * @brief Stream output callback, return false to abort the stream
+ *
+ */
+typedef bool (*ladder_json_stream_fn)(const char *data, size_t len, void *arg);
+
 /**
  * @fn ladder_json_error_t ladder_json_to_program(const char *prg, ladder_ctx_t* ladder_ctx)
  * @brief
@@ -69,9 +81,38 @@ typedef enum JSON_ERROR {
  */
 ladder_json_error_t ladder_json_to_program(const char *prg, char *prg_extern, ladder_ctx_t *ladder_ctx, bool from_extern);
 
+/**
+ * @fn ladder_json_error_t ladder_json_to_network(const char *json, size_t len, ladder_network_t *network)
+ * @brief Parse a single network object
+ *
+ * @param json JSON network object
+ * @param len JSON length
+ * @param network Parsed network (freed on error)
+ * @return Status
+ */
+ladder_json_error_t ladder_json_to_network(const char *json, size_t len, ladder_network_t *network);
+
+/**
+ * @fn void ladder_network_free(ladder_network_t *network)
+ * @brief Free cells and data of a network
+ *
+ * @param network Network
+ */
+void ladder_network_free(ladder_network_t *network);
+
+/**
+ * @fn void ladder_program_free(ladder_network_t *network, uint32_t networks)
+ * @brief Free a networks array not installed in a context (a parsed copy, a replaced program)
+ *
+ * @param network Networks, may be NULL
+ * @param networks Networks quantity
+ */
+void ladder_program_free(ladder_network_t *network, uint32_t networks);
+
 /**
  * @fn ladder_json_error_t ladder_program_to_json(const char *prg, ladder_ctx_t* ladder_ctx)
- * @brief
+ * @brief Serialize the program to a string or to a file. The file is written by the storage task (fs_write_async) and
+ *        the call returns once it is renamed in place, with its result. httpd handlers save through ladder_program_store.
  *
  * @param prg prg file name of JSON program
  * @param prg_extern
@@ -81,6 +122,18 @@ ladder_json_error_t ladder_json_to_program(const char *prg, char *prg_extern, la
  */
 ladder_json_error_t ladder_program_to_json(const char *prg, char **prg_extern, ladder_ctx_t *ladder_ctx, bool to_extern);
 
+/**
+ * @fn ladder_json_error_t ladder_program_to_json_stream(ladder_ctx_t *ladder_ctx, ladder_json_stream_fn stream_fn, void *arg)
+ * @brief Serialize the program network by network, only one network is held in memory at a time. Each network is
+ *        serialized under the scan lock and sent without it; a program swap meanwhile ends the stream with JSON_ERROR_CHANGED.
+ *
+ * @param ladder_ctx Ladder context
+ * @param stream_fn Output callback
+ * @param arg Callback argument
+ * @return Status
+ */
+ladder_json_error_t ladder_program_to_json_stream(ladder_ctx_t *ladder_ctx, ladder_json_stream_fn stream_fn, void *arg);
+
 /**
  * @fn ladder_json_error_t ladder_compact_json_file(const char *input_path, const char *output_path)
  * @brief
@@ -0,0 +1,448 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_program_check.h"
+#include "ladder_program_json.h"
+#include "ladder_program_store.h"
+#include "ladderlib_esp32_std.h"
+
+static const char *TAG = "ladder_program_store";
+
+#define STORE_VERSIONS_MAX (LADDER_STORE_HISTORY + 2)
+
+typedef struct store_job_s {
+    ladder_network_t *network; // program swapped in, NULL for a rollback
+    uint32_t networks;         // networks quantity
+    TaskHandle_t notify;       // caller
+} store_job_t;
+
+static ladder_store_version_t versions[STORE_VERSIONS_MAX]; // oldest first
+static uint32_t versions_qty = 0;
+static uint32_t active = 0;   // slot A, 0: not a stored program
+static uint32_t previous = 0; // slot B
+static SemaphoreHandle_t store_mutex = NULL;
+
+// rollback image, only changed by the scan boundary job
+static ladder_network_t *image = NULL;
+static uint32_t image_networks = 0;
+static volatile bool image_ready = false;
+
+static void version_file(char *name, size_t size, uint32_t version) {
+    snprintf(name, size, LADDER_STORE_DIR "/v%05" PRIu32 ".json", version);
+}
+
+static char *read_text(const char *file, size_t *len) {
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    if (text != NULL) {
+        *len = fread(text, 1, size, fp);
+        text[*len] = '\0';
+    }
+    fclose(fp);
+
+    return text;
+}
+
+static cJSON *store_json(void) {
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL)
+        return NULL;
+
+    cJSON_AddNumberToObject(root, "active", active);
+    cJSON_AddNumberToObject(root, "previous", previous);
+    cJSON *array = cJSON_AddArrayToObject(root, "versions");
+    for (uint32_t v = 0; array != NULL && v < versions_qty; v++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "version", versions[v].version);
+        cJSON_AddNumberToObject(item, "hash", versions[v].hash);
+        cJSON_AddNumberToObject(item, "time", versions[v].time);
+        cJSON_AddNumberToObject(item, "size", versions[v].size);
+        cJSON_AddItemToArray(array, item);
+    }
+
+    return root;
+}
+
+// with store_mutex
+static void index_write(void) {
+    cJSON *root = store_json();
+    if (root == NULL)
+        return;
+
+    char *text = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (text == NULL || fs_write_async(LADDER_STORE_INDEX, text, strlen(text), FS_ASYNC_HIGH, NULL, NULL) != 0)
+        ESP_LOGE(TAG, "ERROR writing %s", LADDER_STORE_INDEX);
+}
+
+static void index_load(void) {
+    size_t len;
+    cJSON *item;
+
+    char *text = read_text(LADDER_STORE_INDEX, &len);
+    if (text == NULL)
+        return;
+
+    cJSON *root = cJSON_Parse(text);
+    free(text);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", LADDER_STORE_INDEX);
+        return;
+    }
+
+    active = cJSON_GetNumberValue(cJSON_GetObjectItem(root, "active"));
+    previous = cJSON_GetNumberValue(cJSON_GetObjectItem(root, "previous"));
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "versions")) {
+        if (versions_qty == STORE_VERSIONS_MAX)
+            break;
+
+        ladder_store_version_t *v = &versions[versions_qty++];
+        v->version = cJSON_GetNumberValue(cJSON_GetObjectItem(item, "version"));
+        v->hash = cJSON_GetNumberValue(cJSON_GetObjectItem(item, "hash"));
+        v->time = cJSON_GetNumberValue(cJSON_GetObjectItem(item, "time"));
+        v->size = cJSON_GetNumberValue(cJSON_GetObjectItem(item, "size"));
+    }
+
+    cJSON_Delete(root);
+}
+
+// scan boundary job: O(1), the replaced program is kept, the older image is freed
+static void store_apply(ladder_ctx_t *ladder_ctx, void *arg) {
+    store_job_t *job = arg;
+    ladder_network_t *network = (*ladder_ctx).network;
+    uint32_t networks = (*ladder_ctx).ladder.quantity.networks;
+
+    if (job->network == NULL) {
+        if (image != NULL) {
+            (*ladder_ctx).network = image;
+            (*ladder_ctx).ladder.quantity.networks = image_networks;
+            image = network;
+            image_networks = networks;
+        }
+    } else {
+        ladder_program_free(image, image_networks);
+        (*ladder_ctx).network = job->network;
+        (*ladder_ctx).ladder.quantity.networks = job->networks;
+        image = network;
+        image_networks = networks;
+    }
+    image_ready = image != NULL;
+    esp32_program_changed();
+
+    xTaskNotifyGive(job->notify);
+    free(job);
+}
+
+// with store_mutex, doesn't wait: the slots are updated in posting order and the caller waits without the mutex
+static ladder_store_result_t store_post(ladder_ctx_t *ladder_ctx, ladder_network_t *network, uint32_t networks) {
+    store_job_t *job = malloc(sizeof(store_job_t));
+    if (job == NULL)
+        return LADDER_STORE_ERROR;
+
+    job->network = network;
+    job->networks = networks;
+    job->notify = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    if (!esp32_scan_sync_post(ladder_ctx, store_apply, job)) {
+        free(job);
+        return LADDER_STORE_BUSY;
+    }
+
+    return LADDER_STORE_QUEUED;
+}
+
+// without store_mutex
+static ladder_store_result_t store_wait(void) {
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LADDER_STORE_APPLY_TIMEOUT_MS)) != 0 ? LADDER_STORE_OK : LADDER_STORE_QUEUED;
+}
+
+static bool store_find(uint32_t version, ladder_store_version_t *meta) {
+    bool found = false;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    for (uint32_t v = 0; v < versions_qty && !found; v++) {
+        if (versions[v].version == version) {
+            *meta = versions[v];
+            found = true;
+        }
+    }
+    xSemaphoreGive(store_mutex);
+
+    return found;
+}
+
+bool ladder_program_store_init(void) {
+    if (store_mutex != NULL)
+        return true;
+
+    store_mutex = xSemaphoreCreateMutex();
+    if (store_mutex == NULL)
+        return false;
+
+    mkdir(MOUNT_POINT "/" LADDER_STORE_DIR, 0755);
+    index_load();
+    ESP_LOGI(TAG, "%" PRIu32 " versions, active %" PRIu32 ", previous %" PRIu32, versions_qty, active, previous);
+
+    return true;
+}
+
+uint32_t ladder_program_store_save(ladder_ctx_t *ladder_ctx) {
+    char *text = NULL, name[32];
+    uint32_t version = 0;
+
+    if (store_mutex == NULL || ladder_program_to_json(NULL, &text, ladder_ctx, true) != JSON_ERROR_OK)
+        return 0;
+
+    uint32_t size = strlen(text);
+    uint32_t hash = esp_rom_crc32_le(0, (const uint8_t *)text, size);
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    for (uint32_t v = 0; v < versions_qty; v++) {
+        if (versions[v].hash == hash && versions[v].size == size) {
+            version = versions[v].version;
+            free(text);
+            goto end;
+        }
+    }
+
+    // the oldest history version makes room, the active and the previous one are kept
+    if (versions_qty == STORE_VERSIONS_MAX) {
+        uint32_t v = 0;
+        while (v < versions_qty && (versions[v].version == active || versions[v].version == previous))
+            v++;
+        if (v == versions_qty) {
+            ESP_LOGE(TAG, "ERROR no version can be removed");
+            free(text);
+            goto end;
+        }
+        version_file(name, sizeof(name), versions[v].version);
+        fs_remove_async(name, FS_ASYNC_HIGH, NULL, NULL);
+        memmove(&versions[v], &versions[v + 1], sizeof(ladder_store_version_t) * (versions_qty - v - 1));
+        versions_qty--;
+    }
+
+    version = versions_qty > 0 ? versions[versions_qty - 1].version + 1 : 1;
+    version_file(name, sizeof(name), version);
+    if (fs_write_async(name, text, size, FS_ASYNC_HIGH, NULL, NULL) != 0) {
+        version = 0;
+        goto end;
+    }
+
+    versions[versions_qty].version = version;
+    versions[versions_qty].hash = hash;
+    versions[versions_qty].time = time(NULL);
+    versions[versions_qty].size = size;
+    versions_qty++;
+
+end:
+    // the running program, the rollback image and the previous slot don't change
+    if (version != 0) {
+        active = version;
+        index_write();
+    }
+    xSemaphoreGive(store_mutex);
+
+    ESP_LOGI(TAG, "Saved version %" PRIu32 " (%08" PRIx32 ", %" PRIu32 " bytes)", version, hash, size);
+
+    return version;
+}
+
+static ladder_store_result_t store_swap(ladder_ctx_t *ladder_ctx, ladder_network_t *network, uint32_t networks, uint32_t version, bool slots) {
+    ladder_store_result_t result;
+
+    if (store_mutex == NULL || network == NULL)
+        return LADDER_STORE_ERROR;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    result = store_post(ladder_ctx, network, networks);
+    if (result == LADDER_STORE_QUEUED && slots) {
+        previous = active;
+        active = version;
+        index_write();
+    }
+    xSemaphoreGive(store_mutex);
+
+    if (result == LADDER_STORE_QUEUED)
+        result = store_wait();
+    ESP_LOGI(TAG, "Activate version %" PRIu32 " (%d)", version, result);
+
+    return result;
+}
+
+// slots false: the active version is loaded again, the slots don't change
+static ladder_store_result_t store_activate(ladder_ctx_t *ladder_ctx, uint32_t version, bool slots) {
+    ladder_store_version_t meta;
+    ladder_store_result_t result = LADDER_STORE_INVALID;
+    char name[32];
+    size_t len = 0;
+
+    if (store_mutex == NULL || !store_find(version, &meta))
+        return LADDER_STORE_NOT_FOUND;
+
+    // a version saved a moment ago may still be in the storage queue
+    fs_sync(LADDER_STORE_APPLY_TIMEOUT_MS);
+
+    version_file(name, sizeof(name), version);
+    char *text = read_text(name, &len);
+    if (text == NULL)
+        return LADDER_STORE_ERROR;
+
+    if (len != meta.size || esp_rom_crc32_le(0, (const uint8_t *)text, len) != meta.hash) {
+        ESP_LOGE(TAG, "Version %" PRIu32 ": hash mismatch", version);
+        free(text);
+        return LADDER_STORE_INVALID;
+    }
+
+    // parsed into a copy of the context, the running program is untouched until the swap
+    ladder_ctx_t *shadow = malloc(sizeof(ladder_ctx_t));
+    if (shadow == NULL) {
+        free(text);
+        return LADDER_STORE_ERROR;
+    }
+    *shadow = *ladder_ctx;
+    (*shadow).network = NULL;
+    (*shadow).ladder.quantity.networks = 0;
+
+    if (ladder_json_to_program("", text, shadow, true) == JSON_ERROR_OK && ladder_program_check(*shadow).error == LADDER_ERR_PRG_CHECK_OK) {
+        result = store_swap(ladder_ctx, (*shadow).network, (*shadow).ladder.quantity.networks, version, slots);
+        if (result != LADDER_STORE_BUSY && result != LADDER_STORE_ERROR)
+            (*shadow).network = NULL;
+    }
+
+    ladder_program_free((*shadow).network, (*shadow).ladder.quantity.networks);
+    free(shadow);
+    free(text);
+
+    return result;
+}
+
+ladder_store_result_t ladder_program_store_activate(ladder_ctx_t *ladder_ctx, uint32_t version) {
+    return store_activate(ladder_ctx, version, true);
+}
+
+ladder_store_result_t ladder_program_store_load_active(ladder_ctx_t *ladder_ctx) {
+    uint32_t version;
+
+    if (store_mutex == NULL)
+        return LADDER_STORE_ERROR;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    version = active;
+    xSemaphoreGive(store_mutex);
+
+    if (version == 0)
+        return LADDER_STORE_NOT_FOUND;
+
+    ESP_LOGI(TAG, "Loading active version %" PRIu32, version);
+    return store_activate(ladder_ctx, version, false);
+}
+
+ladder_store_result_t ladder_program_store_rollback(ladder_ctx_t *ladder_ctx) {
+    ladder_store_result_t result;
+
+    if (store_mutex == NULL)
+        return LADDER_STORE_ERROR;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+
+    if (!image_ready) {
+        uint32_t version = previous;
+        xSemaphoreGive(store_mutex);
+
+        if (version == 0)
+            return LADDER_STORE_NOT_FOUND;
+
+        ESP_LOGW(TAG, "No rollback image, loading version %" PRIu32, version);
+        return ladder_program_store_activate(ladder_ctx, version);
+    }
+
+    result = store_post(ladder_ctx, NULL, 0);
+    if (result == LADDER_STORE_QUEUED) {
+        uint32_t version = active;
+        active = previous;
+        previous = version;
+        index_write();
+    }
+
+    xSemaphoreGive(store_mutex);
+    if (result == LADDER_STORE_QUEUED)
+        result = store_wait();
+    ESP_LOGI(TAG, "Rollback to version %" PRIu32 " (%d)", active, result);
+
+    return result;
+}
+
+ladder_store_result_t ladder_program_store_swap(ladder_ctx_t *ladder_ctx, ladder_network_t *network, uint32_t networks, uint32_t version) {
+    return store_swap(ladder_ctx, network, networks, version, true);
+}
+
+char *ladder_program_store_list(void) {
+    char *json = NULL;
+
+    if (store_mutex == NULL)
+        return NULL;
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    cJSON *root = store_json();
+    xSemaphoreGive(store_mutex);
+    if (root == NULL)
+        return NULL;
+
+    cJSON_AddBoolToObject(root, "rollback_image", image_ready);
+    json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    return json;
+}
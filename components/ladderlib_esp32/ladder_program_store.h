@@ -0,0 +1,140 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_PROGRAM_STORE_H_
+#define LADDER_PROGRAM_STORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+
+#define LADDER_STORE_DIR              "store"            // relative to the mount point
+#define LADDER_STORE_INDEX            "store/index.json" // versions metadata
+#define LADDER_STORE_HISTORY          4                  // versions kept besides the active and the previous one
+#define LADDER_STORE_APPLY_TIMEOUT_MS 2000               // wait for the scan boundary before reporting "queued"
+
+/**
+ * @enum ladder_store_result_t
+ * @brief Store operation result
+ *
+ */
+typedef enum LADDER_STORE_RESULT {
+    LADDER_STORE_OK,        // applied
+    LADDER_STORE_QUEUED,    // applied at a scan boundary later than LADDER_STORE_APPLY_TIMEOUT_MS
+    LADDER_STORE_BUSY,      // scan sync queue full
+    LADDER_STORE_NOT_FOUND, // no such version or nothing to roll back to
+    LADDER_STORE_INVALID,   // hash mismatch, parse or check error
+    LADDER_STORE_ERROR,     // memory or file error
+} ladder_store_result_t;
+
+/**
+ * @struct ladder_store_version_s
+ * @brief Stored program version
+ *
+ */
+typedef struct ladder_store_version_s {
+    uint32_t version; // 1...
+    uint32_t hash;    // CRC-32 of the JSON text
+    int64_t time;     // seconds since the epoch when saved
+    uint32_t size;    // JSON bytes
+} ladder_store_version_t;
+
+/**
+ * @fn bool ladder_program_store_init(void)
+ * @brief Load the versions metadata
+ *
+ * @return true if ready
+ */
+bool ladder_program_store_init(void);
+
+/**
+ * @fn uint32_t ladder_program_store_save(ladder_ctx_t*)
+ * @brief Store the running program as a new version. The oldest history version is removed.
+ *        A program equal to a stored version (same hash) isn't stored again.
+ *
+ * @param ladder_ctx Ladder context
+ * @return version, 0 on error
+ */
+uint32_t ladder_program_store_save(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn ladder_store_result_t ladder_program_store_activate(ladder_ctx_t*, uint32_t)
+ * @brief Parse and check a stored version and swap it in at the next scan boundary.
+ *        The program it replaces stays in memory as the rollback image.
+ *
+ * @param ladder_ctx Ladder context
+ * @param version Version
+ * @return result
+ */
+ladder_store_result_t ladder_program_store_activate(ladder_ctx_t *ladder_ctx, uint32_t version);
+
+/**
+ * @fn ladder_store_result_t ladder_program_store_load_active(ladder_ctx_t*)
+ * @brief Load the active version at boot: parsed, checked against its hash and swapped in at the scan boundary.
+ *        The active and previous slots don't change.
+ *
+ * @param ladder_ctx Ladder context
+ * @return result, LADDER_STORE_NOT_FOUND if no stored version is active
+ */
+ladder_store_result_t ladder_program_store_load_active(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn ladder_store_result_t ladder_program_store_rollback(ladder_ctx_t*)
+ * @brief Swap the rollback image back in at the next scan boundary, without parsing: the previous program runs in the
+ *        next scan. A second rollback returns to the program rolled back from. After a restart there is no image
+ *        and the previous version is activated from its file.
+ *
+ * @param ladder_ctx Ladder context
+ * @return result
+ */
+ladder_store_result_t ladder_program_store_rollback(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn ladder_store_result_t ladder_program_store_swap(ladder_ctx_t*, ladder_network_t*, uint32_t, uint32_t)
+ * @brief Swap an already checked program in at the next scan boundary, the replaced one becomes the rollback image.
+ *        The store owns the networks unless the result is LADDER_STORE_BUSY or LADDER_STORE_ERROR.
+ *
+ * @param ladder_ctx Ladder context
+ * @param network Networks
+ * @param networks Networks quantity
+ * @param version Stored version of the program, 0 if not stored
+ * @return result
+ */
+ladder_store_result_t ladder_program_store_swap(ladder_ctx_t *ladder_ctx, ladder_network_t *network, uint32_t networks, uint32_t version);
+
+/**
+ * @fn char* ladder_program_store_list(void)
+ * @brief Versions metadata as JSON
+ *
+ * @return JSON (free after use) or NULL
+ */
+char *ladder_program_store_list(void);
+
+#endif /* LADDER_PROGRAM_STORE_H_ */
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+
+#include "ladder.h"
+#include "ladder_program_json.h"
+#include "ladder_program_update.h"
+#include "ladderlib_esp32_std.h"
+
+static const char *TAG = "ladder_program_update";
+
+typedef struct network_update_s {
+    uint32_t id;
+    ladder_network_t network;
+} network_update_t;
+
+static void network_update_apply(ladder_ctx_t *ladder_ctx, void *arg) {
+    network_update_t *update = arg;
+
+    if (update->id < (*ladder_ctx).ladder.quantity.networks) {
+        ladder_network_t old = (*ladder_ctx).network[update->id];
+        (*ladder_ctx).network[update->id] = update->network;
+        ladder_network_free(&old);
+    } else if (update->id == (*ladder_ctx).ladder.quantity.networks) {
+        ladder_network_t *network = realloc((*ladder_ctx).network, (update->id + 1) * sizeof(ladder_network_t));
+        if (network == NULL) {
+            ESP_LOGE(TAG, "ERROR append network %u", (unsigned)update->id);
+            ladder_network_free(&update->network);
+            free(update);
+            return;
+        }
+        network[update->id] = update->network;
+        (*ladder_ctx).network = network;
+        (*ladder_ctx).ladder.quantity.networks++;
+    } else {
+        ESP_LOGE(TAG, "ERROR network id %u out of range", (unsigned)update->id);
+        ladder_network_free(&update->network);
+        free(update);
+        return;
+    }
+
+    esp32_program_changed();
+    ESP_LOGI(TAG, "Network %u applied", (unsigned)update->id);
+    free(update);
+}
+
+bool ladder_program_update_network(ladder_ctx_t *ladder_ctx, uint32_t id, ladder_network_t *network) {
+    network_update_t *update = malloc(sizeof(network_update_t));
+    if (update == NULL)
+        return false;
+
+    update->id = id;
+    update->network = *network;
+
+    if (!esp32_scan_sync_post(ladder_ctx, network_update_apply, update)) {
+        free(update);
+        return false;
+    }
+
+    return true;
+}
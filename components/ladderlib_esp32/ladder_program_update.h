@@ -0,0 +1,50 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_PROGRAM_UPDATE_H_
+#define LADDER_PROGRAM_UPDATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+
+/**
+ * @fn bool ladder_program_update_network(ladder_ctx_t*, uint32_t, ladder_network_t*)
+ * @brief Replace (or append when id equals the networks quantity) one network at the next scan boundary.
+ *        Ownership of the network cells is transferred, the replaced network is freed.
+ *
+ * @param ladder_ctx Ladder context
+ * @param id Network id
+ * @param network New network
+ * @return true if queued
+ */
+bool ladder_program_update_network(ladder_ctx_t *ladder_ctx, uint32_t id, ladder_network_t *network);
+
+#endif /* LADDER_PROGRAM_UPDATE_H_ */
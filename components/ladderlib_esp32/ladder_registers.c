@@ -0,0 +1,623 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+
+#include "ladder.h"
+#include "ladder_registers.h"
+#include "ladderlib_esp32_std.h"
+
+static const char *TAG = "ladder_registers";
+
+typedef struct registers_job_s {
+    uint32_t qty;
+    ladder_register_write_t writes[];
+} registers_job_t;
+
+typedef struct force_job_s {
+    uint32_t qty;
+    ladder_force_op_t ops[];
+} force_job_t;
+
+// only modified from scan boundary jobs
+static ladder_force_table_t force_table;
+
+static const char *str_registers[] = {
+    "NONE", //
+    "M",    //
+    "Q",    //
+    "I",    //
+    "Cd",   //
+    "Cr",   //
+    "Td",   //
+    "Tr",   //
+    "IW",   //
+    "QW",   //
+    "C",    //
+    "T",    //
+    "D",    //
+    "S",    //
+    "R",    //
+};
+
+ladder_register_t ladder_registers_type(const char *name) {
+    if (name == NULL)
+        return LADDER_REGISTER_INV;
+
+    for (int i = LADDER_REGISTER_M; i < sizeof(str_registers) / sizeof(str_registers[0]); i++)
+        if (i != LADDER_REGISTER_S && strcmp(name, str_registers[i]) == 0)
+            return (ladder_register_t)i;
+
+    return LADDER_REGISTER_INV;
+}
+
+const char *ladder_registers_type_name(ladder_register_t type) {
+    if (type <= LADDER_REGISTER_NONE || type >= sizeof(str_registers) / sizeof(str_registers[0]))
+        return "?";
+
+    return str_registers[type];
+}
+
+static ladder_registers_error_t register_check(ladder_ctx_t *ladder_ctx, ladder_register_t type, uint8_t module, uint32_t index) {
+    uint32_t qty = 0;
+
+    switch (type) {
+        case LADDER_REGISTER_M:
+            qty = (*ladder_ctx).ladder.quantity.m;
+            break;
+        case LADDER_REGISTER_Cd:
+        case LADDER_REGISTER_Cr:
+        case LADDER_REGISTER_C:
+            qty = (*ladder_ctx).ladder.quantity.c;
+            break;
+        case LADDER_REGISTER_Td:
+        case LADDER_REGISTER_Tr:
+        case LADDER_REGISTER_T:
+            qty = (*ladder_ctx).ladder.quantity.t;
+            break;
+        case LADDER_REGISTER_D:
+            qty = (*ladder_ctx).ladder.quantity.d;
+            break;
+        case LADDER_REGISTER_R:
+            qty = (*ladder_ctx).ladder.quantity.r;
+            break;
+        case LADDER_REGISTER_I:
+        case LADDER_REGISTER_IW:
+            if (module >= (*ladder_ctx).hw.io.fn_read_qty)
+                return REGISTERS_ERROR_RANGE;
+            qty = type == LADDER_REGISTER_I ? (*ladder_ctx).input[module].i_qty : (*ladder_ctx).input[module].iw_qty;
+            break;
+        case LADDER_REGISTER_Q:
+        case LADDER_REGISTER_QW:
+            if (module >= (*ladder_ctx).hw.io.fn_write_qty)
+                return REGISTERS_ERROR_RANGE;
+            qty = type == LADDER_REGISTER_Q ? (*ladder_ctx).output[module].q_qty : (*ladder_ctx).output[module].qw_qty;
+            break;
+        default:
+            return REGISTERS_ERROR_TYPE;
+    }
+
+    return index < qty ? REGISTERS_ERROR_OK : REGISTERS_ERROR_RANGE;
+}
+
+static void register_set(ladder_ctx_t *ladder_ctx, const ladder_register_write_t *write) {
+    switch (write->type) {
+        case LADDER_REGISTER_M:
+            (*ladder_ctx).memory.M[write->index] = write->value.u32 != 0;
+            break;
+        case LADDER_REGISTER_Q:
+            (*ladder_ctx).output[write->module].Q[write->index] = write->value.u32 != 0;
+            break;
+        case LADDER_REGISTER_Cd:
+            (*ladder_ctx).memory.Cd[write->index] = write->value.u32 != 0;
+            break;
+        case LADDER_REGISTER_Cr:
+            (*ladder_ctx).memory.Cr[write->index] = write->value.u32 != 0;
+            break;
+        case LADDER_REGISTER_Td:
+            (*ladder_ctx).memory.Td[write->index] = write->value.u32 != 0;
+            break;
+        case LADDER_REGISTER_Tr:
+            (*ladder_ctx).memory.Tr[write->index] = write->value.u32 != 0;
+            break;
+        case LADDER_REGISTER_QW:
+            (*ladder_ctx).output[write->module].QW[write->index] = write->value.i32;
+            break;
+        case LADDER_REGISTER_C:
+            (*ladder_ctx).registers.C[write->index] = write->value.u32;
+            break;
+        case LADDER_REGISTER_T:
+            (*ladder_ctx).timers[write->index].acc = write->value.u32;
+            break;
+        case LADDER_REGISTER_D:
+            (*ladder_ctx).registers.D[write->index] = write->value.i32;
+            break;
+        case LADDER_REGISTER_R:
+            (*ladder_ctx).registers.R[write->index] = write->value.real;
+            break;
+        default:
+            break;
+    }
+}
+
+static void registers_job_apply(ladder_ctx_t *ladder_ctx, void *arg) {
+    registers_job_t *job = arg;
+
+    // quantities can only change with a new program, check again
+    for (uint32_t n = 0; n < job->qty; n++)
+        if (register_check(ladder_ctx, job->writes[n].type, job->writes[n].module, job->writes[n].index) == REGISTERS_ERROR_OK)
+            register_set(ladder_ctx, &job->writes[n]);
+
+    free(job);
+}
+
+static void force_job_apply(ladder_ctx_t *ladder_ctx, void *arg) {
+    force_job_t *job = arg;
+
+    ladder_force_table_apply(&force_table, job->ops, job->qty);
+    free(job);
+}
+
+static ladder_registers_error_t force_check(ladder_ctx_t *ladder_ctx, const ladder_force_op_t *op) {
+    if (op->all)
+        return REGISTERS_ERROR_OK;
+
+    if (op->module >= LADDER_REGISTERS_FORCE_MODULES || op->port >= LADDER_REGISTERS_FORCE_PORTS)
+        return REGISTERS_ERROR_RANGE;
+
+    return register_check(ladder_ctx, op->output ? LADDER_REGISTER_Q : LADDER_REGISTER_I, op->module, op->port);
+}
+
+static ladder_registers_error_t force_post(ladder_ctx_t *ladder_ctx, const ladder_force_op_t *ops, uint32_t qty) {
+    ladder_registers_error_t err;
+
+    for (uint32_t n = 0; n < qty; n++)
+        if ((err = force_check(ladder_ctx, &ops[n])) != REGISTERS_ERROR_OK)
+            return err;
+
+    force_job_t *job = malloc(sizeof(force_job_t) + qty * sizeof(ladder_force_op_t));
+    if (job == NULL)
+        return REGISTERS_ERROR_ALLOC;
+
+    job->qty = qty;
+    memcpy(job->ops, ops, qty * sizeof(ladder_force_op_t));
+
+    if (!esp32_scan_sync_post(ladder_ctx, force_job_apply, job)) {
+        free(job);
+        return REGISTERS_ERROR_BUSY;
+    }
+
+    return REGISTERS_ERROR_OK;
+}
+
+// "module" of an entry, 0 if absent. Checked before it is narrowed: module 256 must not address module 0
+static ladder_registers_error_t json_module(cJSON *entry, uint8_t *module) {
+    cJSON *item = cJSON_GetObjectItem(entry, "module");
+
+    *module = 0;
+    if (item == NULL)
+        return REGISTERS_ERROR_OK;
+    if (!cJSON_IsNumber(item))
+        return REGISTERS_ERROR_PARSE;
+    if (item->valuedouble < 0 || item->valuedouble > UINT8_MAX)
+        return REGISTERS_ERROR_RANGE;
+
+    *module = item->valueint;
+    return REGISTERS_ERROR_OK;
+}
+
+static ladder_registers_error_t json_read(ladder_ctx_t *ladder_ctx, cJSON *read, cJSON *response) {
+    ladder_registers_error_t err;
+    ladder_register_value_t value;
+    cJSON *entry;
+
+    cJSON *read_response = cJSON_AddArrayToObject(response, "read");
+    if (read_response == NULL)
+        return REGISTERS_ERROR_ALLOC;
+
+    cJSON_ArrayForEach(entry, read) {
+        ladder_register_t type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(entry, "type")));
+        cJSON *start = cJSON_GetObjectItem(entry, "start");
+        cJSON *qty = cJSON_GetObjectItem(entry, "qty");
+        uint8_t module;
+
+        if (type == LADDER_REGISTER_INV)
+            return REGISTERS_ERROR_TYPE;
+        if ((err = json_module(entry, &module)) != REGISTERS_ERROR_OK)
+            return err;
+        if (!cJSON_IsNumber(start) || start->valueint < 0 || (qty != NULL && (!cJSON_IsNumber(qty) || qty->valueint < 1)))
+            return REGISTERS_ERROR_PARSE;
+        if (qty != NULL && qty->valueint > LADDER_REGISTERS_BATCH_MAX)
+            return REGISTERS_ERROR_RANGE;
+
+        cJSON *entry_response = cJSON_CreateObject();
+        if (entry_response == NULL)
+            return REGISTERS_ERROR_ALLOC;
+        cJSON_AddItemToArray(read_response, entry_response);
+
+        cJSON_AddStringToObject(entry_response, "type", str_registers[type]);
+        if (cJSON_GetObjectItem(entry, "module") != NULL)
+            cJSON_AddNumberToObject(entry_response, "module", module);
+        cJSON_AddNumberToObject(entry_response, "start", start->valueint);
+
+        cJSON *values = cJSON_AddArrayToObject(entry_response, "values");
+        if (values == NULL)
+            return REGISTERS_ERROR_ALLOC;
+
+        for (uint32_t n = 0; n < (qty != NULL ? qty->valueint : 1); n++) {
+            if ((err = ladder_registers_get(ladder_ctx, type, module, start->valueint + n, &value)) != REGISTERS_ERROR_OK)
+                return err;
+
+            switch (type) {
+                case LADDER_REGISTER_R:
+                    cJSON_AddItemToArray(values, cJSON_CreateNumber(value.real));
+                    break;
+                case LADDER_REGISTER_IW:
+                case LADDER_REGISTER_QW:
+                case LADDER_REGISTER_D:
+                    cJSON_AddItemToArray(values, cJSON_CreateNumber(value.i32));
+                    break;
+                default:
+                    cJSON_AddItemToArray(values, cJSON_CreateNumber(value.u32));
+                    break;
+            }
+        }
+    }
+
+    return REGISTERS_ERROR_OK;
+}
+
+static ladder_registers_error_t json_write(ladder_ctx_t *ladder_ctx, cJSON *write) {
+    ladder_registers_error_t err = REGISTERS_ERROR_OK;
+    uint32_t qty = 0, n = 0;
+    cJSON *entry, *item;
+
+    cJSON_ArrayForEach(entry, write) {
+        cJSON *values = cJSON_GetObjectItem(entry, "values");
+        if (!cJSON_IsArray(values))
+            return REGISTERS_ERROR_PARSE;
+        qty += cJSON_GetArraySize(values);
+    }
+
+    if (qty == 0)
+        return REGISTERS_ERROR_OK;
+    if (qty > LADDER_REGISTERS_BATCH_MAX)
+        return REGISTERS_ERROR_RANGE;
+
+    registers_job_t *job = malloc(sizeof(registers_job_t) + qty * sizeof(ladder_register_write_t));
+    if (job == NULL)
+        return REGISTERS_ERROR_ALLOC;
+    job->qty = qty;
+
+    cJSON_ArrayForEach(entry, write) {
+        ladder_register_t type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(entry, "type")));
+        cJSON *start = cJSON_GetObjectItem(entry, "start");
+        uint8_t module;
+
+        if (type == LADDER_REGISTER_INV) {
+            err = REGISTERS_ERROR_TYPE;
+            goto end;
+        }
+        if ((err = json_module(entry, &module)) != REGISTERS_ERROR_OK)
+            goto end;
+        if (!cJSON_IsNumber(start) || start->valueint < 0) {
+            err = REGISTERS_ERROR_PARSE;
+            goto end;
+        }
+
+        uint32_t index = start->valueint;
+        cJSON *values = cJSON_GetObjectItem(entry, "values");
+
+        cJSON_ArrayForEach(item, values) {
+            if (!cJSON_IsNumber(item)) {
+                err = REGISTERS_ERROR_PARSE;
+                goto end;
+            }
+
+            job->writes[n].type = type;
+            job->writes[n].module = module;
+            job->writes[n].index = index++;
+            if (type == LADDER_REGISTER_R)
+                job->writes[n].value.real = item->valuedouble;
+            else if (type == LADDER_REGISTER_D || type == LADDER_REGISTER_QW)
+                job->writes[n].value.i32 = item->valueint;
+            else
+                job->writes[n].value.u32 = item->valuedouble < 0 ? 0 : (uint32_t)item->valuedouble;
+            n++;
+        }
+    }
+
+    err = ladder_registers_write(ladder_ctx, job->writes, job->qty);
+
+end:
+    free(job);
+    return err;
+}
+
+static ladder_registers_error_t json_force(ladder_ctx_t *ladder_ctx, cJSON *force, cJSON *unforce, bool unforce_all) {
+    uint32_t qty = cJSON_GetArraySize(force) + cJSON_GetArraySize(unforce) + (unforce_all ? 1 : 0), n = 0;
+    ladder_registers_error_t err;
+    cJSON *entry;
+
+    if (qty == 0)
+        return REGISTERS_ERROR_OK;
+    if (qty > LADDER_REGISTERS_BATCH_MAX)
+        return REGISTERS_ERROR_RANGE;
+
+    ladder_force_op_t *ops = calloc(qty, sizeof(ladder_force_op_t));
+    if (ops == NULL)
+        return REGISTERS_ERROR_ALLOC;
+
+    // release first, so that "unforce_all" plus "force" replaces the table
+    if (unforce_all)
+        ops[n++].all = true;
+
+    for (int list = 0; list < 2; list++) {
+        cJSON *items = list == 0 ? unforce : force;
+
+        cJSON_ArrayForEach(entry, items) {
+            cJSON *port = cJSON_GetObjectItem(entry, "port");
+            cJSON *value = cJSON_GetObjectItem(entry, "value");
+
+            if (!cJSON_IsNumber(port) || port->valueint < 0 || (list == 1 && !cJSON_IsNumber(value) && !cJSON_IsBool(value))) {
+                free(ops);
+                return REGISTERS_ERROR_PARSE;
+            }
+            ladder_register_t type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(entry, "type")));
+            if (type != LADDER_REGISTER_I && type != LADDER_REGISTER_Q)
+                err = REGISTERS_ERROR_TYPE;
+            else
+                err = json_module(entry, &ops[n].module);
+            if (err != REGISTERS_ERROR_OK) {
+                free(ops);
+                return err;
+            }
+
+            ops[n].output = type == LADDER_REGISTER_Q;
+            ops[n].port = port->valueint;
+            ops[n].enable = list == 1;
+            ops[n].value = list == 1 && (cJSON_IsTrue(value) || (cJSON_IsNumber(value) && value->valueint != 0));
+            n++;
+        }
+    }
+
+    err = force_post(ladder_ctx, ops, n);
+    free(ops);
+
+    return err;
+}
+
+static ladder_registers_error_t json_forced(cJSON *response) {
+    cJSON *forced = cJSON_AddArrayToObject(response, "forced");
+    if (forced == NULL)
+        return REGISTERS_ERROR_ALLOC;
+
+    for (int list = 0; list < 2; list++) {
+        for (uint32_t module = 0; module < LADDER_REGISTERS_FORCE_MODULES; module++) {
+            ladder_force_t force = list == 0 ? force_table.i[module] : force_table.q[module];
+
+            while (force.mask != 0) {
+                uint32_t port = __builtin_ctz(force.mask);
+                force.mask &= force.mask - 1;
+
+                cJSON *entry = cJSON_CreateObject();
+                if (entry == NULL)
+                    return REGISTERS_ERROR_ALLOC;
+                cJSON_AddItemToArray(forced, entry);
+
+                cJSON_AddStringToObject(entry, "type", list == 0 ? "I" : "Q");
+                cJSON_AddNumberToObject(entry, "module", module);
+                cJSON_AddNumberToObject(entry, "port", port);
+                cJSON_AddNumberToObject(entry, "value", (force.value >> port) & 1);
+            }
+        }
+    }
+
+    return REGISTERS_ERROR_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+ladder_registers_error_t ladder_registers_get(ladder_ctx_t *ladder_ctx, ladder_register_t type, uint8_t module, uint32_t index, ladder_register_value_t *value) {
+    ladder_registers_error_t err;
+
+    if ((err = register_check(ladder_ctx, type, module, index)) != REGISTERS_ERROR_OK)
+        return err;
+
+    switch (type) {
+        case LADDER_REGISTER_M:
+            value->u32 = (*ladder_ctx).memory.M[index];
+            break;
+        case LADDER_REGISTER_Q:
+            value->u32 = (*ladder_ctx).output[module].Q[index];
+            break;
+        case LADDER_REGISTER_I:
+            value->u32 = (*ladder_ctx).input[module].I[index];
+            break;
+        case LADDER_REGISTER_Cd:
+            value->u32 = (*ladder_ctx).memory.Cd[index];
+            break;
+        case LADDER_REGISTER_Cr:
+            value->u32 = (*ladder_ctx).memory.Cr[index];
+            break;
+        case LADDER_REGISTER_Td:
+            value->u32 = (*ladder_ctx).memory.Td[index];
+            break;
+        case LADDER_REGISTER_Tr:
+            value->u32 = (*ladder_ctx).memory.Tr[index];
+            break;
+        case LADDER_REGISTER_IW:
+            value->i32 = (*ladder_ctx).input[module].IW[index];
+            break;
+        case LADDER_REGISTER_QW:
+            value->i32 = (*ladder_ctx).output[module].QW[index];
+            break;
+        case LADDER_REGISTER_C:
+            value->u32 = (*ladder_ctx).registers.C[index];
+            break;
+        case LADDER_REGISTER_T:
+            value->u32 = (*ladder_ctx).timers[index].acc;
+            break;
+        case LADDER_REGISTER_D:
+            value->i32 = (*ladder_ctx).registers.D[index];
+            break;
+        case LADDER_REGISTER_R:
+            value->real = (*ladder_ctx).registers.R[index];
+            break;
+        default:
+            return REGISTERS_ERROR_TYPE;
+    }
+
+    return REGISTERS_ERROR_OK;
+}
+
+ladder_registers_error_t ladder_registers_write(ladder_ctx_t *ladder_ctx, const ladder_register_write_t *writes, uint32_t qty) {
+    ladder_registers_error_t err;
+
+    if (qty == 0)
+        return REGISTERS_ERROR_OK;
+
+    for (uint32_t n = 0; n < qty; n++) {
+        // inputs are overwritten on every read, use the force table instead
+        if (writes[n].type == LADDER_REGISTER_I || writes[n].type == LADDER_REGISTER_IW)
+            return REGISTERS_ERROR_READONLY;
+        if ((err = register_check(ladder_ctx, writes[n].type, writes[n].module, writes[n].index)) != REGISTERS_ERROR_OK)
+            return err;
+    }
+
+    registers_job_t *job = malloc(sizeof(registers_job_t) + qty * sizeof(ladder_register_write_t));
+    if (job == NULL)
+        return REGISTERS_ERROR_ALLOC;
+
+    job->qty = qty;
+    memcpy(job->writes, writes, qty * sizeof(ladder_register_write_t));
+
+    if (!esp32_scan_sync_post(ladder_ctx, registers_job_apply, job)) {
+        free(job);
+        return REGISTERS_ERROR_BUSY;
+    }
+
+    return REGISTERS_ERROR_OK;
+}
+
+ladder_registers_error_t ladder_registers_force(ladder_ctx_t *ladder_ctx, ladder_register_t type, uint8_t module, uint32_t port, bool enable, bool value) {
+    ladder_force_op_t op = {
+        .all = false,                        //
+        .output = type == LADDER_REGISTER_Q, //
+        .module = module,                    //
+        .port = port,                        //
+        .enable = enable,                    //
+        .value = value,                      //
+    };
+
+    if (type != LADDER_REGISTER_I && type != LADDER_REGISTER_Q)
+        return REGISTERS_ERROR_TYPE;
+
+    return force_post(ladder_ctx, &op, 1);
+}
+
+ladder_registers_error_t ladder_registers_unforce_all(ladder_ctx_t *ladder_ctx) {
+    ladder_force_op_t op = {
+        .all = true, //
+    };
+
+    return force_post(ladder_ctx, &op, 1);
+}
+
+void ladder_registers_force_inputs(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    if (id >= LADDER_REGISTERS_FORCE_MODULES || force_table.i[id].mask == 0)
+        return;
+
+    ladder_force_image(&force_table.i[id], (*ladder_ctx).input[id].I);
+}
+
+void ladder_registers_force_outputs(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    if (id >= LADDER_REGISTERS_FORCE_MODULES || force_table.q[id].mask == 0)
+        return;
+
+    ladder_force_image(&force_table.q[id], (*ladder_ctx).output[id].Q);
+}
+
+char *ladder_registers_json(ladder_ctx_t *ladder_ctx, const char *json, size_t len) {
+    ladder_registers_error_t err = REGISTERS_ERROR_OK;
+    char *str = NULL;
+
+    cJSON *request = cJSON_ParseWithLength(json, len);
+    cJSON *response = cJSON_CreateObject();
+    if (response == NULL) {
+        cJSON_Delete(request);
+        return NULL;
+    }
+
+    if (request == NULL) {
+        err = REGISTERS_ERROR_PARSE;
+        goto end;
+    }
+
+    cJSON *read = cJSON_GetObjectItem(request, "read");
+    cJSON *write = cJSON_GetObjectItem(request, "write");
+    cJSON *force = cJSON_GetObjectItem(request, "force");
+    cJSON *unforce = cJSON_GetObjectItem(request, "unforce");
+
+    if ((read != NULL && !cJSON_IsArray(read)) || (write != NULL && !cJSON_IsArray(write)) || (force != NULL && !cJSON_IsArray(force)) ||
+        (unforce != NULL && !cJSON_IsArray(unforce))) {
+        err = REGISTERS_ERROR_PARSE;
+        goto end;
+    }
+
+    // reads see the image before this request writes
+    if (read != NULL && (err = json_read(ladder_ctx, read, response)) != REGISTERS_ERROR_OK)
+        goto end;
+
+    if (write != NULL && (err = json_write(ladder_ctx, write)) != REGISTERS_ERROR_OK)
+        goto end;
+
+    if ((err = json_force(ladder_ctx, force, unforce, cJSON_IsTrue(cJSON_GetObjectItem(request, "unforce_all")))) != REGISTERS_ERROR_OK)
+        goto end;
+
+    if (cJSON_IsTrue(cJSON_GetObjectItem(request, "forced")))
+        err = json_forced(response);
+
+end:
+    if (err != REGISTERS_ERROR_OK)
+        ESP_LOGW(TAG, "request error %d", err);
+
+    cJSON_AddNumberToObject(response, "error", err);
+    str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    cJSON_Delete(request);
+
+    return str;
+}
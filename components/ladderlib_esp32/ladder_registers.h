@@ -0,0 +1,179 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_REGISTERS_H_
+#define LADDER_REGISTERS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "ladder_registers_force.h"
+
+#define LADDER_REGISTERS_BATCH_MAX 64 // values per read/write entry
+
+typedef enum REGISTERS_ERROR {
+    REGISTERS_ERROR_OK,       //
+    REGISTERS_ERROR_PARSE,    //
+    REGISTERS_ERROR_TYPE,     //
+    REGISTERS_ERROR_RANGE,    //
+    REGISTERS_ERROR_READONLY, //
+    REGISTERS_ERROR_ALLOC,    //
+    REGISTERS_ERROR_BUSY,     //
+    ///////////////////////////
+    REGISTERS_ERROR_FAIL      //
+} ladder_registers_error_t;
+
+/**
+ * @brief Register value: real for R, i32 for D/IW/QW, u32 for the rest
+ *
+ */
+typedef union ladder_register_value_u {
+    int32_t i32;
+    uint32_t u32;
+    float real;
+} ladder_register_value_t;
+
+/**
+ * @brief One register write
+ *
+ */
+typedef struct ladder_register_write_s {
+    ladder_register_t type;        // register type
+    uint8_t module;                // module (I/Q/IW/QW only)
+    uint32_t index;                // register index
+    ladder_register_value_t value; // new value
+} ladder_register_write_t;
+
+/**
+ * @fn ladder_registers_error_t ladder_registers_get(ladder_ctx_t*, ladder_register_t, uint8_t, uint32_t, ladder_register_value_t*)
+ * @brief Read one register. Words are read directly from the running scan
+ *
+ * @param ladder_ctx Ladder context
+ * @param type Register type
+ * @param module Module (I/Q/IW/QW only)
+ * @param index Register index
+ * @param value Value
+ * @return Status
+ */
+ladder_registers_error_t ladder_registers_get(ladder_ctx_t *ladder_ctx, ladder_register_t type, uint8_t module, uint32_t index, ladder_register_value_t *value);
+
+/**
+ * @fn ladder_registers_error_t ladder_registers_write(ladder_ctx_t*, const ladder_register_write_t*, uint32_t)
+ * @brief Validate a batch of writes and apply all of them at the next scan boundary
+ *
+ * @param ladder_ctx Ladder context
+ * @param writes Writes
+ * @param qty Writes quantity
+ * @return Status
+ */
+ladder_registers_error_t ladder_registers_write(ladder_ctx_t *ladder_ctx, const ladder_register_write_t *writes, uint32_t qty);
+
+/**
+ * @fn ladder_registers_error_t ladder_registers_force(ladder_ctx_t*, ladder_register_t, uint8_t, uint32_t, bool, bool)
+ * @brief Add or remove an I/Q point from the force table (applied at the next scan boundary)
+ *
+ * @param ladder_ctx Ladder context
+ * @param type LADDER_REGISTER_I or LADDER_REGISTER_Q
+ * @param module Module
+ * @param port Port
+ * @param enable Force (true) or release (false)
+ * @param value Forced value
+ * @return Status
+ */
+ladder_registers_error_t ladder_registers_force(ladder_ctx_t *ladder_ctx, ladder_register_t type, uint8_t module, uint32_t port, bool enable, bool value);
+
+/**
+ * @fn ladder_registers_error_t ladder_registers_unforce_all(ladder_ctx_t*)
+ * @brief Release every forced point
+ *
+ * @param ladder_ctx Ladder context
+ * @return Status
+ */
+ladder_registers_error_t ladder_registers_unforce_all(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_registers_force_inputs(ladder_ctx_t*, uint32_t)
+ * @brief Apply forced inputs on the input image. Call from the read function after the hardware read
+ *
+ * @param ladder_ctx Ladder context
+ * @param id Module
+ */
+void ladder_registers_force_inputs(ladder_ctx_t *ladder_ctx, uint32_t id);
+
+/**
+ * @fn void ladder_registers_force_outputs(ladder_ctx_t*, uint32_t)
+ * @brief Apply forced outputs on the output image. Call from the write function before the hardware write
+ *
+ * @param ladder_ctx Ladder context
+ * @param id Module
+ */
+void ladder_registers_force_outputs(ladder_ctx_t *ladder_ctx, uint32_t id);
+
+/**
+ * @fn ladder_register_t ladder_registers_type(const char*)
+ * @brief Register type from its name ("M", "IW", ...)
+ *
+ * @param name Name
+ * @return Type or LADDER_REGISTER_INV
+ */
+ladder_register_t ladder_registers_type(const char *name);
+
+/**
+ * @fn const char* ladder_registers_type_name(ladder_register_t)
+ * @brief Register type name
+ *
+ * @param type Type
+ * @return Name
+ */
+const char *ladder_registers_type_name(ladder_register_t type);
+
+/**
+ * @fn char* ladder_registers_json(ladder_ctx_t*, const char*, size_t)
+ * @brief Execute a JSON batch request
+ *
+ *        {"read":[{"type":"D","start":0,"qty":4},{"type":"I","module":0,"start":0,"qty":8}],
+ *         "write":[{"type":"M","start":2,"values":[1,0]}],
+ *         "force":[{"type":"Q","module":0,"port":3,"value":1}],
+ *         "unforce":[{"type":"Q","module":0,"port":3}],
+ *         "unforce_all":true,
+ *         "forced":true}
+ *
+ *        Every member is optional. The response has the same "read" entries with "values" added,
+ *        "forced" (the force table) when requested or modified and "error".
+ *
+ * @param ladder_ctx Ladder context
+ * @param json Request
+ * @param len Request length
+ * @return JSON response (free after use) or NULL
+ */
+char *ladder_registers_json(ladder_ctx_t *ladder_ctx, const char *json, size_t len);
+
+#endif /* LADDER_REGISTERS_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ladder_registers_force.h"
+
+void ladder_force_table_apply(ladder_force_table_t *table, const ladder_force_op_t *ops, uint32_t qty) {
+    for (uint32_t n = 0; n < qty; n++) {
+        const ladder_force_op_t *op = &ops[n];
+
+        if (op->all) {
+            memset(table, 0, sizeof(ladder_force_table_t));
+            continue;
+        }
+
+        ladder_force_t *force = op->output ? &table->q[op->module] : &table->i[op->module];
+        if (op->enable) {
+            force->mask |= 1UL << op->port;
+            if (op->value)
+                force->value |= 1UL << op->port;
+            else
+                force->value &= ~(1UL << op->port);
+        } else {
+            force->mask &= ~(1UL << op->port);
+            force->value &= ~(1UL << op->port);
+        }
+    }
+}
+
+void ladder_force_image(const ladder_force_t *force, uint8_t *image) {
+    uint32_t mask = force->mask;
+
+    while (mask != 0) {
+        uint32_t port = __builtin_ctz(mask);
+        mask &= mask - 1;
+        image[port] = (force->value >> port) & 1;
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_REGISTERS_FORCE_H_
+#define LADDER_REGISTERS_FORCE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LADDER_REGISTERS_FORCE_MODULES 8  // forceable I/Q modules
+#define LADDER_REGISTERS_FORCE_PORTS   32 // forceable ports of a module
+
+/**
+ * @struct ladder_force_s
+ * @brief Forced ports of a module, one direction
+ *
+ */
+typedef struct ladder_force_s {
+    uint32_t mask;  // forced ports
+    uint32_t value; // forced values
+} ladder_force_t;
+
+/**
+ * @struct ladder_force_table_s
+ * @brief Force table, only modified at scan boundaries
+ *
+ */
+typedef struct ladder_force_table_s {
+    ladder_force_t i[LADDER_REGISTERS_FORCE_MODULES]; //
+    ladder_force_t q[LADDER_REGISTERS_FORCE_MODULES]; //
+} ladder_force_table_t;
+
+/**
+ * @struct ladder_force_op_s
+ * @brief Force table change, validated before it is posted
+ *
+ */
+typedef struct ladder_force_op_s {
+    bool all;       // release every point
+    bool output;    // Q, else I
+    uint8_t module; // below LADDER_REGISTERS_FORCE_MODULES
+    uint32_t port;  // below LADDER_REGISTERS_FORCE_PORTS
+    bool enable;    //
+    bool value;     //
+} ladder_force_op_t;
+
+/**
+ * @fn void ladder_force_table_apply(ladder_force_table_t*, const ladder_force_op_t*, uint32_t)
+ * @brief Apply changes in order, from the scan boundary
+ *
+ * @param table Force table
+ * @param ops Changes
+ * @param qty Changes quantity
+ */
+void ladder_force_table_apply(ladder_force_table_t *table, const ladder_force_op_t *ops, uint32_t qty);
+
+/**
+ * @fn void ladder_force_image(const ladder_force_t*, uint8_t*)
+ * @brief Overwrite the forced ports of a module image, only the forced ones are touched
+ *
+ * @param force Forced ports
+ * @param image I or Q points of the module, at least the highest forced port + 1
+ */
+void ladder_force_image(const ladder_force_t *force, uint8_t *image);
+
+#endif /* LADDER_REGISTERS_FORCE_H_ */
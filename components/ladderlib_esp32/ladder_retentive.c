@@ -0,0 +1,412 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_registers.h"
+#include "ladder_retentive.h"
+#include "ladderlib_esp32_std.h"
+
+static const char *TAG = "ladder_retentive";
+
+#define RETENTIVE_TYPES      5                                               // M, C, T, D, R
+#define RETENTIVE_RANGES_MAX (RETENTIVE_TYPES * LADDER_RETENTIVE_RANGES_MAX) //
+
+static const ladder_register_t retentive_types[RETENTIVE_TYPES] = {
+    LADDER_REGISTER_M, //
+    LADDER_REGISTER_C, //
+    LADDER_REGISTER_T, //
+    LADDER_REGISTER_D, //
+    LADDER_REGISTER_R, //
+};
+
+// survives a software reset, a panic or a watchdog reset, not a power cycle
+typedef struct retentive_rtc_s {
+    ladder_retentive_record_t header;                   //
+    uint32_t data[LADDER_RETENTIVE_SIZE_MAX / sizeof(uint32_t)]; // values, word aligned
+} retentive_rtc_t;
+
+static RTC_NOINIT_ATTR retentive_rtc_t ret_rtc;
+
+static ladder_retentive_range_t ret_range[RETENTIVE_RANGES_MAX];
+static uint32_t ret_qty = 0;
+static uint32_t ret_size = 0;
+static uint32_t ret_hash = 0;
+static uint32_t ret_seq = 0;
+static ladder_retentive_pace_t ret_pace = { 0 };
+static volatile bool ret_ready = false; // configured and restored, the scan hook may run
+static uint32_t ret_pending_len = 0;
+static ladder_retentive_stats_t ret_stats = { 0 };
+
+// contiguous values of a range, NULL for the timers accumulators
+static uint8_t *retentive_values(ladder_ctx_t *ladder_ctx, const ladder_retentive_range_t *range, uint32_t *len) {
+    uint32_t qty = range->last - range->first + 1;
+
+    switch (range->type) {
+        case LADDER_REGISTER_M:
+            *len = qty * sizeof((*ladder_ctx).memory.M[0]);
+            return (uint8_t *)&(*ladder_ctx).memory.M[range->first];
+        case LADDER_REGISTER_C:
+            *len = qty * sizeof((*ladder_ctx).registers.C[0]);
+            return (uint8_t *)&(*ladder_ctx).registers.C[range->first];
+        case LADDER_REGISTER_D:
+            *len = qty * sizeof((*ladder_ctx).registers.D[0]);
+            return (uint8_t *)&(*ladder_ctx).registers.D[range->first];
+        case LADDER_REGISTER_R:
+            *len = qty * sizeof((*ladder_ctx).registers.R[0]);
+            return (uint8_t *)&(*ladder_ctx).registers.R[range->first];
+        default:
+            *len = qty * sizeof((*ladder_ctx).timers[0].acc);
+            return NULL;
+    }
+}
+
+// copy the ranges into the RTC mirror, true if a value changed
+static bool retentive_capture(ladder_ctx_t *ladder_ctx) {
+    uint8_t *mirror = (uint8_t *)ret_rtc.data;
+    bool changed = false;
+    uint32_t len;
+
+    for (uint32_t n = 0; n < ret_qty; n++) {
+        uint8_t *values = retentive_values(ladder_ctx, &ret_range[n], &len);
+
+        if (values != NULL) {
+            changed |= ladder_retentive_mirror(mirror, values, len);
+            mirror += len;
+            continue;
+        }
+
+        for (uint32_t t = ret_range[n].first; t <= ret_range[n].last; t++) {
+            changed |= ladder_retentive_mirror(mirror, &(*ladder_ctx).timers[t].acc, sizeof((*ladder_ctx).timers[t].acc));
+            mirror += sizeof((*ladder_ctx).timers[t].acc);
+        }
+    }
+
+    return changed;
+}
+
+static void retentive_apply(ladder_ctx_t *ladder_ctx, const uint8_t *data) {
+    uint32_t len;
+
+    for (uint32_t n = 0; n < ret_qty; n++) {
+        uint8_t *values = retentive_values(ladder_ctx, &ret_range[n], &len);
+
+        if (values != NULL) {
+            memcpy(values, data, len);
+            data += len;
+            continue;
+        }
+
+        for (uint32_t t = ret_range[n].first; t <= ret_range[n].last; t++) {
+            memcpy(&(*ladder_ctx).timers[t].acc, data, sizeof((*ladder_ctx).timers[t].acc));
+            data += sizeof((*ladder_ctx).timers[t].acc);
+        }
+    }
+}
+
+static void retentive_seal(void) {
+    ladder_retentive_record_seal(&ret_rtc.header, ret_rtc.data, ret_seq, ret_hash, ret_size);
+}
+
+static bool retentive_valid(const ladder_retentive_record_t *header, const void *data) {
+    return ladder_retentive_record_valid(header, data, ret_hash, ret_size);
+}
+
+// data must hold ret_size bytes
+static bool retentive_read(const char *file, ladder_retentive_record_t *header, uint8_t *data) {
+    bool ok = false;
+
+    FILE *fp = fs_open(file, "rb");
+    if (fp == NULL)
+        return false;
+
+    if (fread(header, 1, sizeof(ladder_retentive_record_t), fp) == sizeof(ladder_retentive_record_t) && header->len == ret_size &&
+        fread(data, 1, ret_size, fp) == ret_size)
+        ok = retentive_valid(header, data);
+
+    fclose(fp);
+
+    if (!ok)
+        ESP_LOGW(TAG, "invalid record %s", file);
+
+    return ok;
+}
+
+// storage task
+static void retentive_written(const char *file, int result, void *arg) {
+    if (result == 0) {
+        ret_stats.flushes++;
+        ret_stats.written += ret_pending_len;
+    } else {
+        // written again by the scan hook, after the backoff interval
+        ESP_LOGE(TAG, "ERROR writing %s", file);
+        ret_stats.errors++;
+    }
+
+    ladder_retentive_pace_written(&ret_pace, result == 0);
+    ret_stats.failing = ret_pace.failing;
+}
+
+static void retentive_flush_job(ladder_ctx_t *ladder_ctx, void *arg) {
+    ret_pace.force = true;
+    ladder_retentive_scan(ladder_ctx);
+}
+
+bool ladder_retentive_config(ladder_ctx_t *ladder_ctx, const ladder_retentive_range_t *range, uint32_t qty) {
+    uint32_t per_type[RETENTIVE_TYPES] = { 0 };
+    uint32_t size = 0, len, quantity;
+
+    if (qty > RETENTIVE_RANGES_MAX)
+        return false;
+
+    ret_ready = false;
+
+    for (uint32_t n = 0; n < qty; n++) {
+        switch (range[n].type) {
+            case LADDER_REGISTER_M:
+                quantity = (*ladder_ctx).ladder.quantity.m;
+                break;
+            case LADDER_REGISTER_C:
+                quantity = (*ladder_ctx).ladder.quantity.c;
+                break;
+            case LADDER_REGISTER_T:
+                quantity = (*ladder_ctx).ladder.quantity.t;
+                break;
+            case LADDER_REGISTER_D:
+                quantity = (*ladder_ctx).ladder.quantity.d;
+                break;
+            case LADDER_REGISTER_R:
+                quantity = (*ladder_ctx).ladder.quantity.r;
+                break;
+            default:
+                return false;
+        }
+
+        for (uint32_t t = 0; t < RETENTIVE_TYPES; t++)
+            if (retentive_types[t] == range[n].type && ++per_type[t] > LADDER_RETENTIVE_RANGES_MAX)
+                return false;
+
+        if (range[n].first > range[n].last || range[n].last >= quantity)
+            return false;
+
+        retentive_values(ladder_ctx, &range[n], &len);
+        size += len;
+    }
+
+    if (size > LADDER_RETENTIVE_SIZE_MAX)
+        return false;
+
+    memcpy(ret_range, range, qty * sizeof(ladder_retentive_range_t));
+    ret_qty = qty;
+    ret_size = size;
+
+    // a record is only restored into the same layout
+    ret_hash = esp_rom_crc32_le(0, (const uint8_t *)ret_range, qty * sizeof(ladder_retentive_range_t));
+    ret_hash = esp_rom_crc32_le(ret_hash, (const uint8_t *)&(*ladder_ctx).ladder.quantity, sizeof((*ladder_ctx).ladder.quantity));
+
+    ret_stats.ranges = qty;
+    ret_stats.size = size;
+    ESP_LOGI(TAG, "%" PRIu32 " ranges, %" PRIu32 " bytes", qty, size);
+
+    return true;
+}
+
+bool ladder_retentive_load(ladder_ctx_t *ladder_ctx, const char *file) {
+    ladder_retentive_range_t range[RETENTIVE_RANGES_MAX];
+    uint32_t qty = 0;
+    cJSON *item;
+    bool ok = false;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return false;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return false;
+    }
+
+    for (uint32_t t = 0; t < RETENTIVE_TYPES; t++) {
+        cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, ladder_registers_type_name(retentive_types[t]))) {
+            cJSON *first = cJSON_GetArrayItem(item, 0);
+            cJSON *last = cJSON_GetArrayItem(item, 1);
+
+            if (qty == RETENTIVE_RANGES_MAX || !cJSON_IsNumber(first) || !cJSON_IsNumber(last) || first->valueint < 0 || last->valueint < 0)
+                goto end;
+
+            range[qty].type = retentive_types[t];
+            range[qty].first = first->valueint;
+            range[qty].last = last->valueint;
+            qty++;
+        }
+    }
+
+    ok = ladder_retentive_config(ladder_ctx, range, qty);
+
+end:
+    if (!ok)
+        ESP_LOGE(TAG, "ERROR configuration %s", file);
+    cJSON_Delete(root);
+    return ok;
+}
+
+bool ladder_retentive_restore(ladder_ctx_t *ladder_ctx) {
+    ladder_retentive_record_t header;
+    const char *files[] = { LADDER_RETENTIVE_FILE_A, LADDER_RETENTIVE_FILE_B };
+    const char *source = NULL;
+    uint8_t *data;
+
+    strcpy(ret_stats.restored, "none");
+    if (ret_size == 0)
+        return false;
+
+    data = malloc(ret_size);
+    if (data == NULL)
+        return false;
+
+    // newest valid file record, also to continue its sequence
+    ret_seq = 0;
+    for (uint32_t f = 0; f < 2; f++) {
+        if (!retentive_read(files[f], &header, data) || (source != NULL && header.seq <= ret_seq))
+            continue;
+
+        ret_seq = header.seq;
+        source = files[f];
+    }
+
+    // warm start: the registers resumed with the program are newer than any copy, only the sequence is recovered
+    if ((*ladder_ctx).ladder.state == LADDER_ST_RUNNING) {
+        if (ret_rtc.header.magic == LADDER_RETENTIVE_MAGIC && ret_rtc.header.hash == ret_hash && ret_rtc.header.seq > ret_seq)
+            ret_seq = ret_rtc.header.seq;
+        source = "warm";
+        ret_pace.dirty = true;
+    } else if (esp_reset_reason() != ESP_RST_POWERON && retentive_valid(&ret_rtc.header, ret_rtc.data)) {
+        retentive_apply(ladder_ctx, (const uint8_t *)ret_rtc.data);
+        source = "rtc";
+        if (ret_rtc.header.seq > ret_seq)
+            ret_seq = ret_rtc.header.seq;
+        // not known to be on flash yet
+        ret_pace.dirty = true;
+    } else if (source != NULL) {
+        // re-read: the second file may have been the invalid or older one
+        if (retentive_read(source, &header, data))
+            retentive_apply(ladder_ctx, data);
+        else
+            source = NULL;
+    }
+
+    free(data);
+
+    retentive_capture(ladder_ctx);
+    retentive_seal();
+    ret_pace.last = esp_timer_get_time() / 1000;
+    ret_ready = true;
+
+    if (source == NULL) {
+        ESP_LOGW(TAG, "no retained values");
+        return false;
+    }
+
+    strlcpy(ret_stats.restored, source, sizeof(ret_stats.restored));
+    ESP_LOGI(TAG, "restored from %s (%" PRIu32 ")", source, ret_seq);
+
+    return true;
+}
+
+void ladder_retentive_scan(ladder_ctx_t *ladder_ctx) {
+    if (!ret_ready || ret_size == 0)
+        return;
+
+    if (retentive_capture(ladder_ctx)) {
+        retentive_seal();
+        ret_pace.dirty = true;
+        ret_stats.changes++;
+    }
+
+    uint64_t now = esp_timer_get_time() / 1000;
+    if (!ladder_retentive_pace_due(&ret_pace, now))
+        return;
+
+    ret_pending_len = sizeof(ladder_retentive_record_t) + ret_size;
+    char *record = malloc(ret_pending_len);
+    if (record == NULL)
+        return;
+
+    ret_seq++;
+    retentive_seal();
+    memcpy(record, &ret_rtc.header, sizeof(ladder_retentive_record_t));
+    memcpy(record + sizeof(ladder_retentive_record_t), ret_rtc.data, ret_size);
+
+    ladder_retentive_pace_queued(&ret_pace, now);
+
+    // double buffer: the previous record stays valid while this one is written
+    if (fs_write_async((ret_seq & 1) ? LADDER_RETENTIVE_FILE_A : LADDER_RETENTIVE_FILE_B, record, ret_pending_len, FS_ASYNC_HIGH, retentive_written, NULL) != 0) {
+        ret_stats.errors++;
+        ladder_retentive_pace_written(&ret_pace, false);
+        ret_stats.failing = ret_pace.failing;
+    }
+}
+
+void ladder_retentive_flush(ladder_ctx_t *ladder_ctx) {
+    if (!esp32_scan_sync_post(ladder_ctx, retentive_flush_job, NULL))
+        ret_pace.force = true;
+}
+
+void ladder_retentive_stats(ladder_retentive_stats_t *stats) {
+    *stats = ret_stats;
+    stats->uptime_s = esp_timer_get_time() / 1000000;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_RETENTIVE_H_
+#define LADDER_RETENTIVE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "ladder_retentive_record.h"
+
+#define LADDER_RETENTIVE_RANGES_MAX 4                // ranges per register type
+#define LADDER_RETENTIVE_SIZE_MAX   2048             // retained bytes, RTC slow memory mirror size
+#define LADDER_RETENTIVE_FILE_A     "retain_a.bin"   // double buffer, records are written alternately
+#define LADDER_RETENTIVE_FILE_B     "retain_b.bin"   //
+#define LADDER_RETENTIVE_CONFIG     "retentive.json" // retentive ranges loaded at boot
+
+/**
+ * @struct ladder_retentive_range_s
+ * @brief Retained registers, first to last inclusive
+ *
+ */
+typedef struct ladder_retentive_range_s {
+    uint8_t type;   // LADDER_REGISTER_M, C, T (accumulator), D or R
+    uint16_t first; //
+    uint16_t last;  //
+} ladder_retentive_range_t;
+
+/**
+ * @struct ladder_retentive_stats_s
+ * @brief Persistence counters
+ *
+ */
+typedef struct ladder_retentive_stats_s {
+    uint32_t ranges;   // configured ranges
+    uint32_t size;     // retained bytes
+    uint32_t changes;  // scans that changed a retained value
+    uint32_t flushes;  // records written
+    uint32_t errors;   // records not written
+    uint32_t failing;  // consecutive failed writes, retried with backoff
+    uint64_t written;  // bytes written to flash
+    uint32_t uptime_s; // seconds since boot, for a per day estimate
+    char restored[16]; // restore source: "rtc", "warm", file name or "none"
+} ladder_retentive_stats_t;
+
+/**
+ * @fn bool ladder_retentive_config(ladder_ctx_t*, const ladder_retentive_range_t*, uint32_t)
+ * @brief Set the retentive ranges
+ *
+ * @param ladder_ctx Ladder context
+ * @param range Ranges
+ * @param qty Ranges quantity
+ * @return false if a range is invalid or the values don't fit in LADDER_RETENTIVE_SIZE_MAX
+ */
+bool ladder_retentive_config(ladder_ctx_t *ladder_ctx, const ladder_retentive_range_t *range, uint32_t qty);
+
+/**
+ * @fn bool ladder_retentive_load(ladder_ctx_t*, const char*)
+ * @brief Set the retentive ranges from a JSON configuration file
+ *
+ *        {"M":[[0,15]],"C":[[0,7]],"T":[[0,3]],"D":[[0,7],[10,11]],"R":[[0,3]]}
+ *
+ * @param ladder_ctx Ladder context
+ * @param file File name, relative to the mount point
+ * @return true if configured
+ */
+bool ladder_retentive_load(ladder_ctx_t *ladder_ctx, const char *file);
+
+/**
+ * @fn bool ladder_retentive_restore(ladder_ctx_t*)
+ * @brief Restore the retained values, before starting the ladder. The RTC memory copy is used after a reset that kept
+ *        it, else the newest valid file record. If the ladder already runs (warm start) the values are kept.
+ *
+ * @param ladder_ctx Ladder context
+ * @return true if the values were restored
+ */
+bool ladder_retentive_restore(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_retentive_scan(ladder_ctx_t*)
+ * @brief Scan hook: mirror the ranges into RTC memory and queue a flash write if they changed, never blocks
+ *
+ * @param ladder_ctx Ladder context
+ */
+void ladder_retentive_scan(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_retentive_flush(ladder_ctx_t*)
+ * @brief Write the values at the next scan end without waiting for LADDER_RETENTIVE_FLUSH_MS
+ *
+ * @param ladder_ctx Ladder context
+ */
+void ladder_retentive_flush(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_retentive_stats(ladder_retentive_stats_t*)
+ * @brief Counters since boot
+ *
+ * @param stats Counters
+ */
+void ladder_retentive_stats(ladder_retentive_stats_t *stats);
+
+#endif /* LADDER_RETENTIVE_H_ */
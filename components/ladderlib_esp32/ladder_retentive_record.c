@@ -0,0 +1,92 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+#include "ladder_retentive_record.h"
+
+static uint32_t record_crc(const ladder_retentive_record_t *header, const void *data) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&header->seq, sizeof(ladder_retentive_record_t) - offsetof(ladder_retentive_record_t, seq));
+    return esp_rom_crc32_le(crc, data, header->len);
+}
+
+void ladder_retentive_record_seal(ladder_retentive_record_t *header, const void *data, uint32_t seq, uint32_t hash, uint32_t len) {
+    header->magic = LADDER_RETENTIVE_MAGIC;
+    header->seq = seq;
+    header->hash = hash;
+    header->len = len;
+    header->crc = record_crc(header, data);
+}
+
+bool ladder_retentive_record_valid(const ladder_retentive_record_t *header, const void *data, uint32_t hash, uint32_t len) {
+    return header->magic == LADDER_RETENTIVE_MAGIC && header->hash == hash && header->len == len && header->crc == record_crc(header, data);
+}
+
+bool ladder_retentive_mirror(uint8_t *mirror, const void *values, uint32_t len) {
+    if (memcmp(mirror, values, len) == 0)
+        return false;
+
+    memcpy(mirror, values, len);
+    return true;
+}
+
+bool ladder_retentive_pace_due(const ladder_retentive_pace_t *pace, uint64_t now) {
+    if ((!pace->dirty && !pace->force) || pace->busy)
+        return false;
+
+    if (pace->force)
+        return true;
+
+    // rate bound: a counter changing every scan is written once per LADDER_RETENTIVE_FLUSH_MS, a failing flash less often
+    uint32_t backoff = pace->failing < LADDER_RETENTIVE_BACKOFF ? pace->failing : LADDER_RETENTIVE_BACKOFF;
+    return now - pace->last >= ((uint64_t)LADDER_RETENTIVE_FLUSH_MS << backoff);
+}
+
+void ladder_retentive_pace_queued(ladder_retentive_pace_t *pace, uint64_t now) {
+    pace->dirty = false;
+    pace->force = false;
+    pace->busy = true;
+    pace->last = now;
+}
+
+void ladder_retentive_pace_written(ladder_retentive_pace_t *pace, bool ok) {
+    if (ok) {
+        pace->failing = 0;
+    } else {
+        pace->failing++;
+        pace->dirty = true;
+    }
+
+    pace->busy = false;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_RETENTIVE_RECORD_H_
+#define LADDER_RETENTIVE_RECORD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LADDER_RETENTIVE_FLUSH_MS 10000      // minimum time between two flash writes
+#define LADDER_RETENTIVE_BACKOFF  5          // after a failed write the interval doubles, up to FLUSH_MS << BACKOFF
+#define LADDER_RETENTIVE_MAGIC    0x31544552 // "RET1"
+
+/**
+ * @struct ladder_retentive_record_s
+ * @brief Record header, in RTC memory and in the files, followed by the retained values in range order
+ *
+ */
+typedef struct ladder_retentive_record_s {
+    uint32_t magic; // LADDER_RETENTIVE_MAGIC
+    uint32_t crc;   // CRC-32 of the rest of the header and the values
+    uint32_t seq;   // record sequence, the newest valid file record is restored
+    uint32_t hash;  // ranges and registers quantities, a record of another configuration is ignored
+    uint32_t len;   // values bytes
+} ladder_retentive_record_t;
+
+/**
+ * @struct ladder_retentive_pace_s
+ * @brief Flash write pacing. The scan hook sets dirty or force, the storage task reports the write result.
+ *
+ */
+typedef struct ladder_retentive_pace_s {
+    uint64_t last;       // ms, last write queued
+    uint32_t failing;    // consecutive failed writes
+    bool dirty;          // values not on flash yet
+    volatile bool force; // write at the next scan end, without waiting for the interval
+    volatile bool busy;  // a record is queued in the storage service
+} ladder_retentive_pace_t;
+
+/**
+ * @fn void ladder_retentive_record_seal(ladder_retentive_record_t*, const void*, uint32_t, uint32_t, uint32_t)
+ * @brief Fill a record header for the values
+ *
+ * @param header Header
+ * @param data Values
+ * @param seq Record sequence
+ * @param hash Configuration hash
+ * @param len Values bytes
+ */
+void ladder_retentive_record_seal(ladder_retentive_record_t *header, const void *data, uint32_t seq, uint32_t hash, uint32_t len);
+
+/**
+ * @fn bool ladder_retentive_record_valid(const ladder_retentive_record_t*, const void*, uint32_t, uint32_t)
+ * @brief Check a record read back from RTC memory or a file
+ *
+ * @param header Header
+ * @param data Values, len bytes
+ * @param hash Configuration hash
+ * @param len Values bytes
+ * @return true if the record belongs to this configuration and is intact
+ */
+bool ladder_retentive_record_valid(const ladder_retentive_record_t *header, const void *data, uint32_t hash, uint32_t len);
+
+/**
+ * @fn bool ladder_retentive_mirror(uint8_t*, const void*, uint32_t)
+ * @brief Bring a mirror up to date with the values
+ *
+ * @param mirror Mirror
+ * @param values Values
+ * @param len Bytes
+ * @return true if the mirror changed
+ */
+bool ladder_retentive_mirror(uint8_t *mirror, const void *values, uint32_t len);
+
+/**
+ * @fn bool ladder_retentive_pace_due(const ladder_retentive_pace_t*, uint64_t)
+ * @brief A record must be written now: the values are dirty and LADDER_RETENTIVE_FLUSH_MS, doubled for every failed
+ *        write up to LADDER_RETENTIVE_BACKOFF times, elapsed since the last one, or a write was forced. Never while a
+ *        write is queued.
+ *
+ * @param pace Pacing
+ * @param now Milliseconds
+ * @return true to write
+ */
+bool ladder_retentive_pace_due(const ladder_retentive_pace_t *pace, uint64_t now);
+
+/**
+ * @fn void ladder_retentive_pace_queued(ladder_retentive_pace_t*, uint64_t)
+ * @brief A record was queued
+ *
+ * @param pace Pacing
+ * @param now Milliseconds
+ */
+void ladder_retentive_pace_queued(ladder_retentive_pace_t *pace, uint64_t now);
+
+/**
+ * @fn void ladder_retentive_pace_written(ladder_retentive_pace_t*, bool)
+ * @brief The queued record was written, or failed and is written again after the backoff interval
+ *
+ * @param pace Pacing
+ * @param ok Written
+ */
+void ladder_retentive_pace_written(ladder_retentive_pace_t *pace, bool ok);
+
+#endif /* LADDER_RETENTIVE_RECORD_H_ */
@@ -0,0 +1,548 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "ladder.h"
+#include "ladder_program_json.h"
+#include "ladder_warm.h"
+
+static const char *TAG = "ladder_warm";
+
+#define WARM_REGIONS 9 // M, Cr, Cd, Tr, Td, C, D, R, timers
+
+typedef struct warm_header_s {
+    uint32_t magic;  // LADDER_WARM_MAGIC
+    uint32_t crc;    // CRC-32 of the rest of the header and the data
+    uint32_t layout; // registers quantities and structures sizes
+    uint32_t image;  // image: networks quantity, state: CRC of its image
+    uint32_t seq;    // state: newest slot is restored
+    uint32_t len;    // data bytes
+    uint64_t millis; // state: ladder clock when it was taken
+} warm_header_t;
+
+typedef struct warm_buf_s {
+    uint8_t *data; //
+    uint32_t len;  //
+    uint32_t max;  //
+} warm_buf_t;
+
+typedef struct warm_config_entry_s {
+    uint8_t kind;  // ladder_warm_config_kind_t
+    uint8_t index; //
+    uint16_t len;  // configuration bytes, followed by the configuration padded to a word
+} warm_config_entry_t;
+
+typedef struct warm_region_s {
+    void *ptr;    //
+    uint32_t len; //
+} warm_region_t;
+
+// not cleared by a software, panic or watchdog reset; the CRC tells whether it survived a brownout
+static __NOINIT_ATTR struct {
+    warm_header_t header;
+    uint32_t data[LADDER_WARM_IMAGE_MAX / sizeof(uint32_t)];
+} warm_image;
+
+static __NOINIT_ATTR struct {
+    warm_header_t header;
+    uint32_t data[LADDER_WARM_STATE_MAX / sizeof(uint32_t)];
+} warm_state[2];
+
+// I/O layout of the running program, rebuilt before the file system is mounted
+static __NOINIT_ATTR struct {
+    warm_header_t header;
+    uint32_t data[LADDER_WARM_CONFIG_MAX / sizeof(uint32_t)];
+} warm_config;
+
+// consecutive resumes, valid if check is its complement
+static __NOINIT_ATTR struct {
+    uint32_t count;
+    uint32_t check;
+} warm_attempts;
+
+static volatile bool warm_changed = true;
+static ladder_network_t *warm_network = NULL;
+static uint32_t warm_networks = 0;
+static bool warm_image_ok = false;
+static uint32_t warm_seq = 0;
+static ladder_warm_stats_t warm_info = { 0 };
+static bool warm_config_full = false;
+
+static void warm_attempts_set(uint32_t count) {
+    warm_attempts.count = count;
+    warm_attempts.check = ~count;
+}
+
+static uint32_t warm_crc(const warm_header_t *header, const void *data) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&header->layout, sizeof(warm_header_t) - offsetof(warm_header_t, layout));
+    return esp_rom_crc32_le(crc, data, header->len);
+}
+
+static void warm_seal(warm_header_t *header, const void *data) {
+    header->magic = LADDER_WARM_MAGIC;
+    header->crc = warm_crc(header, data);
+}
+
+static uint32_t warm_layout(ladder_ctx_t *ladder_ctx) {
+    uint32_t layout[] = {
+        (*ladder_ctx).ladder.quantity.m,  //
+        (*ladder_ctx).ladder.quantity.c,  //
+        (*ladder_ctx).ladder.quantity.t,  //
+        (*ladder_ctx).ladder.quantity.d,  //
+        (*ladder_ctx).ladder.quantity.r,  //
+        (*ladder_ctx).hw.io.fn_read_qty,  // remote modules present
+        (*ladder_ctx).hw.io.fn_write_qty, //
+        sizeof(ladder_cell_t),            //
+        sizeof(ladder_value_t),           //
+        sizeof(ladder_timer_t),           //
+    };
+
+    return esp_rom_crc32_le(0, (const uint8_t *)layout, sizeof(layout));
+}
+
+static bool warm_valid(const warm_header_t *header, const void *data, uint32_t max, uint32_t layout) {
+    return header->magic == LADDER_WARM_MAGIC && header->layout == layout && header->len <= max && header->crc == warm_crc(header, data);
+}
+
+// same ownership rule as ladder_network_free
+static bool warm_owns_strings(const ladder_cell_t *cell) {
+    return cell->code != LADDER_INS_TON && cell->code != LADDER_INS_TOF && cell->code != LADDER_INS_TP;
+}
+
+static bool warm_put(warm_buf_t *buf, const void *src, uint32_t len) {
+    if (buf->len + len > buf->max)
+        return false;
+
+    memcpy(buf->data + buf->len, src, len);
+    buf->len += len;
+
+    return true;
+}
+
+static bool warm_get(warm_buf_t *buf, void *dst, uint32_t len) {
+    if (buf->len + len > buf->max)
+        return false;
+
+    memcpy(dst, buf->data + buf->len, len);
+    buf->len += len;
+
+    return true;
+}
+
+static uint32_t warm_regions(ladder_ctx_t *ladder_ctx, warm_region_t *region) {
+    uint32_t c = (*ladder_ctx).ladder.quantity.c;
+    uint32_t t = (*ladder_ctx).ladder.quantity.t;
+
+    region[0] = (warm_region_t){ (*ladder_ctx).memory.M, (*ladder_ctx).ladder.quantity.m * sizeof((*ladder_ctx).memory.M[0]) };
+    region[1] = (warm_region_t){ (*ladder_ctx).memory.Cr, c * sizeof((*ladder_ctx).memory.Cr[0]) };
+    region[2] = (warm_region_t){ (*ladder_ctx).memory.Cd, c * sizeof((*ladder_ctx).memory.Cd[0]) };
+    region[3] = (warm_region_t){ (*ladder_ctx).memory.Tr, t * sizeof((*ladder_ctx).memory.Tr[0]) };
+    region[4] = (warm_region_t){ (*ladder_ctx).memory.Td, t * sizeof((*ladder_ctx).memory.Td[0]) };
+    region[5] = (warm_region_t){ (*ladder_ctx).registers.C, c * sizeof((*ladder_ctx).registers.C[0]) };
+    region[6] = (warm_region_t){ (*ladder_ctx).registers.D, (*ladder_ctx).ladder.quantity.d * sizeof((*ladder_ctx).registers.D[0]) };
+    region[7] = (warm_region_t){ (*ladder_ctx).registers.R, (*ladder_ctx).ladder.quantity.r * sizeof((*ladder_ctx).registers.R[0]) };
+    region[8] = (warm_region_t){ (*ladder_ctx).timers, t * sizeof((*ladder_ctx).timers[0]) };
+
+    return WARM_REGIONS;
+}
+
+static bool warm_image_build(ladder_ctx_t *ladder_ctx) {
+    warm_buf_t buf = { (uint8_t *)warm_image.data, 0, LADDER_WARM_IMAGE_MAX };
+
+    // invalid until sealed, a reset in between falls back to a cold start
+    warm_image.header.magic = 0;
+
+    if ((*ladder_ctx).network == NULL)
+        return false;
+
+    for (uint32_t n = 0; n < (*ladder_ctx).ladder.quantity.networks; n++) {
+        ladder_network_t *network = &(*ladder_ctx).network[n];
+
+        if (!warm_put(&buf, &network->enable, sizeof(network->enable)) || !warm_put(&buf, &network->rows, sizeof(network->rows)) ||
+            !warm_put(&buf, &network->cols, sizeof(network->cols)))
+            return false;
+
+        for (uint32_t r = 0; r < network->rows; r++) {
+            for (uint32_t c = 0; c < network->cols; c++) {
+                ladder_cell_t *cell = &network->cells[r][c];
+                uint8_t code = cell->code;
+
+                if (!warm_put(&buf, &cell->state, sizeof(cell->state)) || !warm_put(&buf, &cell->vertical_bar, sizeof(cell->vertical_bar)) ||
+                    !warm_put(&buf, &code, sizeof(code)) || !warm_put(&buf, &cell->data_qty, sizeof(cell->data_qty)))
+                    return false;
+
+                if (cell->data_qty == 0 || cell->data == NULL)
+                    continue;
+
+                if (!warm_put(&buf, cell->data, cell->data_qty * sizeof(ladder_value_t)))
+                    return false;
+
+                for (uint8_t d = 0; warm_owns_strings(cell) && d < cell->data_qty; d++) {
+                    if (cell->data[d].type != LADDER_REGISTER_S)
+                        continue;
+
+                    uint16_t len = cell->data[d].value.cstr != NULL ? strlen(cell->data[d].value.cstr) : 0;
+                    if (!warm_put(&buf, &len, sizeof(len)) || !warm_put(&buf, cell->data[d].value.cstr, len))
+                        return false;
+                }
+            }
+        }
+    }
+
+    warm_image.header.layout = warm_layout(ladder_ctx);
+    warm_image.header.image = (*ladder_ctx).ladder.quantity.networks;
+    warm_image.header.seq = 0;
+    warm_image.header.len = buf.len;
+    warm_image.header.millis = 0;
+    warm_seal(&warm_image.header, warm_image.data);
+
+    return true;
+}
+
+static bool warm_image_load(ladder_network_t **out) {
+    warm_buf_t buf = { (uint8_t *)warm_image.data, 0, warm_image.header.len };
+    uint32_t networks = warm_image.header.image;
+    uint8_t code;
+
+    ladder_network_t *network = calloc(networks, sizeof(ladder_network_t));
+    if (network == NULL)
+        return false;
+
+    for (uint32_t n = 0; n < networks; n++) {
+        if (!warm_get(&buf, &network[n].enable, sizeof(network[n].enable)) || !warm_get(&buf, &network[n].rows, sizeof(network[n].rows)) ||
+            !warm_get(&buf, &network[n].cols, sizeof(network[n].cols)))
+            goto error;
+
+        network[n].cells = calloc(network[n].rows, sizeof(ladder_cell_t *));
+        if (network[n].cells == NULL)
+            goto error;
+
+        for (uint32_t r = 0; r < network[n].rows; r++) {
+            network[n].cells[r] = calloc(network[n].cols, sizeof(ladder_cell_t));
+            if (network[n].cells[r] == NULL)
+                goto error;
+
+            for (uint32_t c = 0; c < network[n].cols; c++) {
+                ladder_cell_t *cell = &network[n].cells[r][c];
+
+                if (!warm_get(&buf, &cell->state, sizeof(cell->state)) || !warm_get(&buf, &cell->vertical_bar, sizeof(cell->vertical_bar)) ||
+                    !warm_get(&buf, &code, sizeof(code)) || !warm_get(&buf, &cell->data_qty, sizeof(cell->data_qty)))
+                    goto error;
+                cell->code = code;
+
+                if (cell->data_qty == 0)
+                    continue;
+
+                cell->data = malloc(cell->data_qty * sizeof(ladder_value_t));
+                if (cell->data == NULL)
+                    goto error;
+                if (!warm_get(&buf, cell->data, cell->data_qty * sizeof(ladder_value_t))) {
+                    free(cell->data);
+                    cell->data = NULL;
+                    goto error;
+                }
+
+                // the pointers are stale until replaced, ladder_network_free must not see them
+                if (warm_owns_strings(cell))
+                    for (uint8_t d = 0; d < cell->data_qty; d++)
+                        if (cell->data[d].type == LADDER_REGISTER_S)
+                            cell->data[d].value.cstr = NULL;
+
+                for (uint8_t d = 0; warm_owns_strings(cell) && d < cell->data_qty; d++) {
+                    uint16_t len;
+
+                    if (cell->data[d].type != LADDER_REGISTER_S)
+                        continue;
+
+                    if (!warm_get(&buf, &len, sizeof(len)) || (cell->data[d].value.cstr = malloc(len + 1)) == NULL ||
+                        !warm_get(&buf, cell->data[d].value.cstr, len))
+                        goto error;
+                    cell->data[d].value.cstr[len] = '\0';
+                }
+            }
+        }
+    }
+
+    *out = network;
+    return true;
+
+error:
+    for (uint32_t n = 0; n < networks; n++)
+        ladder_network_free(&network[n]);
+    free(network);
+    return false;
+}
+
+// only an unexpected reset of a running ladder is resumed, never a power on or a requested restart
+static bool warm_reset_unexpected(void) {
+    switch (esp_reset_reason()) {
+        case ESP_RST_PANIC:
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:
+        case ESP_RST_BROWNOUT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// time stamps of running timers come from the clock before the reset, move them onto the restarted one
+static void warm_timers_rebase(ladder_ctx_t *ladder_ctx, uint64_t then) {
+    uint64_t now = (*ladder_ctx).hw.time.millis();
+
+    for (uint32_t t = 0; t < (*ladder_ctx).ladder.quantity.t; t++) {
+        if (!(*ladder_ctx).memory.Tr[t])
+            continue;
+
+        uint64_t elapsed = then > (*ladder_ctx).timers[t].time_stamp ? then - (*ladder_ctx).timers[t].time_stamp : 0;
+        (*ladder_ctx).timers[t].time_stamp = now > elapsed ? now - elapsed : 0;
+    }
+}
+
+static uint32_t warm_attempts_get(void) {
+    return warm_attempts.check == ~warm_attempts.count ? warm_attempts.count : 0;
+}
+
+bool ladder_warm_pending(void) {
+    return warm_reset_unexpected() && warm_attempts_get() < LADDER_WARM_ATTEMPTS && warm_image.header.magic == LADDER_WARM_MAGIC;
+}
+
+void ladder_warm_config_clear(void) {
+    warm_config_full = false;
+    warm_config.header.layout = 0;
+    warm_config.header.image = 0;
+    warm_config.header.seq = 0;
+    warm_config.header.len = 0;
+    warm_config.header.millis = 0;
+    warm_seal(&warm_config.header, warm_config.data);
+}
+
+void ladder_warm_config_add(uint8_t kind, uint32_t index, const void *config, uint32_t len) {
+    warm_config_entry_t entry = { kind, index, len };
+    uint32_t size = sizeof(warm_config_entry_t) + ((len + 3) & ~3);
+
+    if (warm_config_full)
+        return;
+
+    if (!warm_valid(&warm_config.header, warm_config.data, LADDER_WARM_CONFIG_MAX, 0))
+        ladder_warm_config_clear();
+
+    // an incomplete layout must not be resumed
+    if (warm_config.header.len + size > LADDER_WARM_CONFIG_MAX) {
+        ESP_LOGW(TAG, "I/O configuration over %u bytes, no warm start", LADDER_WARM_CONFIG_MAX);
+        warm_config.header.magic = 0;
+        warm_config_full = true;
+        return;
+    }
+
+    uint8_t *data = (uint8_t *)warm_config.data + warm_config.header.len;
+    memcpy(data, &entry, sizeof(warm_config_entry_t));
+    memcpy(data + sizeof(warm_config_entry_t), config, len);
+    warm_config.header.len += size;
+    warm_seal(&warm_config.header, warm_config.data);
+}
+
+bool ladder_warm_config_replay(ladder_warm_config_fn_t fn, void *arg) {
+    uint32_t len = warm_config.header.len;
+    warm_config_entry_t entry;
+
+    if (!warm_valid(&warm_config.header, warm_config.data, LADDER_WARM_CONFIG_MAX, 0))
+        return false;
+
+    // the modules keep every entry again as they apply it
+    uint8_t *copy = malloc(len > 0 ? len : 1);
+    if (copy == NULL)
+        return false;
+    memcpy(copy, warm_config.data, len);
+    ladder_warm_config_clear();
+
+    for (uint32_t off = 0; off + sizeof(warm_config_entry_t) <= len;) {
+        memcpy(&entry, copy + off, sizeof(warm_config_entry_t));
+        off += sizeof(warm_config_entry_t);
+        if (off + entry.len > len)
+            break;
+        fn(entry.kind, entry.index, copy + off, entry.len, arg);
+        off += (entry.len + 3) & ~3;
+    }
+    free(copy);
+
+    return true;
+}
+
+bool ladder_warm_resume(ladder_ctx_t *ladder_ctx) {
+    warm_region_t region[WARM_REGIONS];
+    ladder_network_t *network;
+    int slot = -1;
+
+    if (!warm_reset_unexpected()) {
+        warm_attempts_set(0);
+        return false;
+    }
+
+    // a program that resets again before running stable is not resumed forever
+    uint32_t attempts = warm_attempts_get();
+    if (attempts >= LADDER_WARM_ATTEMPTS) {
+        ESP_LOGE(TAG, "%" PRIu32 " warm resumes in a row, cold start with the ladder stopped", attempts);
+        ladder_warm_stop();
+        warm_image.header.magic = 0;
+        warm_info.attempts = attempts;
+        warm_info.boot_loop = true;
+        return false;
+    }
+    warm_attempts_set(0);
+
+    uint32_t layout = warm_layout(ladder_ctx);
+    if (!warm_valid(&warm_image.header, warm_image.data, LADDER_WARM_IMAGE_MAX, layout)) {
+        ESP_LOGW(TAG, "no valid program image");
+        return false;
+    }
+
+    for (int s = 0; s < 2; s++) {
+        if (!warm_valid(&warm_state[s].header, warm_state[s].data, LADDER_WARM_STATE_MAX, layout) || warm_state[s].header.image != warm_image.header.crc)
+            continue;
+        if (slot < 0 || (int32_t)(warm_state[s].header.seq - warm_state[slot].header.seq) > 0)
+            slot = s;
+    }
+
+    // no state: the ladder was stopped before the reset
+    if (slot < 0)
+        return false;
+
+    uint32_t regions = warm_regions(ladder_ctx, region);
+    uint32_t len = 0;
+    for (uint32_t r = 0; r < regions; r++)
+        len += region[r].len;
+    if (len != warm_state[slot].header.len)
+        return false;
+
+    if (!warm_image_load(&network)) {
+        ESP_LOGE(TAG, "ERROR loading program image");
+        return false;
+    }
+
+    const uint8_t *data = (const uint8_t *)warm_state[slot].data;
+    for (uint32_t r = 0; r < regions; r++) {
+        memcpy(region[r].ptr, data, region[r].len);
+        data += region[r].len;
+    }
+    warm_timers_rebase(ladder_ctx, warm_state[slot].header.millis);
+
+    (*ladder_ctx).network = network;
+    (*ladder_ctx).ladder.quantity.networks = warm_image.header.image;
+
+    warm_network = network;
+    warm_networks = warm_image.header.image;
+    warm_changed = false;
+    warm_image_ok = true;
+    warm_seq = warm_state[slot].header.seq;
+
+    warm_attempts_set(attempts + 1);
+    warm_info.attempts = attempts + 1;
+    warm_info.resumed = true;
+    warm_info.resume_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "resumed %" PRIu32 " networks, %" PRIu32 " bytes state, %lld us after reset", warm_networks, len, (long long)warm_info.resume_us);
+
+    return true;
+}
+
+void ladder_warm_program_changed(void) {
+    warm_changed = true;
+}
+
+void ladder_warm_scan(ladder_ctx_t *ladder_ctx) {
+    warm_region_t region[WARM_REGIONS];
+
+    if (warm_info.first_write_us == 0) {
+        warm_info.first_write_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "first scan done %lld us after reset (%s start)", (long long)warm_info.first_write_us, warm_info.resumed ? "warm" : "cold");
+    }
+
+    if (warm_info.attempts != 0 && esp_timer_get_time() - warm_info.resume_us > LADDER_WARM_STABLE_MS * 1000LL) {
+        warm_attempts_set(0);
+        warm_info.attempts = 0;
+    }
+
+    if (warm_changed || (*ladder_ctx).network != warm_network || (*ladder_ctx).ladder.quantity.networks != warm_networks) {
+        warm_changed = false;
+        warm_network = (*ladder_ctx).network;
+        warm_networks = (*ladder_ctx).ladder.quantity.networks;
+        warm_image_ok = warm_image_build(ladder_ctx);
+        if (!warm_image_ok)
+            ESP_LOGW(TAG, "program image over %u bytes, no warm start", LADDER_WARM_IMAGE_MAX);
+    }
+
+    if (!warm_image_ok)
+        return;
+
+    // two slots: the previous one stays valid if the reset comes while this one is written
+    warm_header_t *header = &warm_state[++warm_seq & 1].header;
+    uint8_t *data = (uint8_t *)warm_state[warm_seq & 1].data;
+    uint32_t regions = warm_regions(ladder_ctx, region);
+    uint32_t len = 0;
+
+    header->magic = 0;
+    for (uint32_t r = 0; r < regions; r++) {
+        if (len + region[r].len > LADDER_WARM_STATE_MAX)
+            return;
+        memcpy(data + len, region[r].ptr, region[r].len);
+        len += region[r].len;
+    }
+
+    header->layout = warm_image.header.layout;
+    header->image = warm_image.header.crc;
+    header->seq = warm_seq;
+    header->len = len;
+    header->millis = (*ladder_ctx).hw.time.millis();
+    warm_seal(header, data);
+}
+
+void ladder_warm_stop(void) {
+    warm_attempts_set(0);
+    warm_state[0].header.magic = 0;
+    warm_state[1].header.magic = 0;
+}
+
+void ladder_warm_stats(ladder_warm_stats_t *stats) {
+    *stats = warm_info;
+    stats->image = warm_image_ok ? warm_image.header.len : 0;
+    stats->state = warm_image_ok ? warm_state[warm_seq & 1].header.len : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef LADDER_WARM_H_
+#define LADDER_WARM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+
+#define LADDER_WARM_IMAGE_MAX  8192       // program image bytes kept in no-init memory
+#define LADDER_WARM_STATE_MAX  1024       // registers state bytes, per slot
+#define LADDER_WARM_MAGIC      0x314d5257 // "WRM1"
+#define LADDER_WARM_ATTEMPTS   3          // warm resumes in a row before a cold start with the ladder stopped
+#define LADDER_WARM_STABLE_MS  60000      // run time after which a resume is not counted as a boot loop
+#define LADDER_WARM_CONFIG_MAX 3072       // I/O configuration bytes kept for a resume before the file system is mounted
+
+/**
+ * @enum ladder_warm_config_kind_t
+ * @brief I/O configuration kept in no-init memory
+ *
+ */
+typedef enum LADDER_WARM_CONFIG_KIND {
+    LADDER_WARM_CONFIG_HSC,           // ladder_hsc_config_t
+    LADDER_WARM_CONFIG_ADC,           // ladder_adc_config_t
+    LADDER_WARM_CONFIG_AOUT,          // ladder_aout_config_t, index: QW
+    LADDER_WARM_CONFIG_MODBUS_MASTER, // modbus_master_config_t
+} ladder_warm_config_kind_t;
+
+/**
+ * @brief Apply a kept I/O configuration
+ *
+ */
+typedef void (*ladder_warm_config_fn_t)(uint8_t kind, uint32_t index, const void *config, uint32_t len, void *arg);
+
+/**
+ * @struct ladder_warm_stats_s
+ * @brief Warm start information
+ *
+ */
+typedef struct ladder_warm_stats_s {
+    bool resumed;           // this boot resumed the program kept in memory
+    uint32_t image;         // program image bytes, 0: no image (program too big or not running)
+    uint32_t state;         // registers state bytes
+    int64_t resume_us;      // time since reset when the ladder task was started, 0: cold start
+    int64_t first_write_us; // time since reset at the end of the first scan (outputs written)
+    uint32_t attempts;      // warm resumes in a row, cleared after LADDER_WARM_STABLE_MS of scans or a stop
+    bool boot_loop;         // LADDER_WARM_ATTEMPTS reached: cold start, the boot program is not started
+} ladder_warm_stats_t;
+
+/**
+ * @fn bool ladder_warm_pending(void)
+ * @brief A warm resume will be tried: unexpected reset, program image kept and no boot loop. The I/O layout must then
+ *        be rebuilt with ladder_warm_config_replay before ladder_warm_resume, not from the files.
+ *
+ * @return true if pending
+ */
+bool ladder_warm_pending(void);
+
+/**
+ * @fn void ladder_warm_config_clear(void)
+ * @brief Forget the kept I/O configuration, before it is loaded from the files in a cold start
+ *
+ */
+void ladder_warm_config_clear(void);
+
+/**
+ * @fn void ladder_warm_config_add(uint8_t, uint32_t, const void*, uint32_t)
+ * @brief Keep an applied I/O configuration for the next warm resume. Called by the modules that change the I/O layout.
+ *
+ * @param kind ladder_warm_config_kind_t
+ * @param index Kind dependent index
+ * @param config Configuration, copied
+ * @param len Configuration bytes
+ */
+void ladder_warm_config_add(uint8_t kind, uint32_t index, const void *config, uint32_t len);
+
+/**
+ * @fn bool ladder_warm_config_replay(ladder_warm_config_fn_t, void*)
+ * @brief Apply the kept I/O configuration in the order it was added. The entries are kept again by the modules.
+ *
+ * @param fn Called for every entry
+ * @param arg Callback argument
+ * @return true if there was a valid configuration
+ */
+bool ladder_warm_config_replay(ladder_warm_config_fn_t fn, void *arg);
+
+/**
+ * @fn bool ladder_warm_resume(ladder_ctx_t*)
+ * @brief Restore the program image and the registers kept in no-init memory, after a panic, watchdog or brownout
+ *        reset of a running ladder. Call after ladder_ctx_init with the same registers quantities and after
+ *        ladder_warm_config_replay, before the file system is mounted. On success the caller starts the ladder task. After LADDER_WARM_ATTEMPTS resumes in a
+ *        row, each one ending in a reset before LADDER_WARM_STABLE_MS, the image is dropped and boot_loop is reported:
+ *        the caller keeps the ladder stopped with the outputs off.
+ *
+ * @param ladder_ctx Ladder context
+ * @return true if the program and registers were restored
+ */
+bool ladder_warm_resume(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_warm_program_changed(void)
+ * @brief The program changed, the image is rebuilt at the next scan end
+ *
+ */
+void ladder_warm_program_changed(void);
+
+/**
+ * @fn void ladder_warm_scan(ladder_ctx_t*)
+ * @brief Scan hook: keep the image and the registers state
+ *
+ * @param ladder_ctx Ladder context
+ */
+void ladder_warm_scan(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void ladder_warm_stop(void)
+ * @brief The ladder was stopped, a reset must not resume it
+ *
+ */
+void ladder_warm_stop(void);
+
+/**
+ * @fn void ladder_warm_stats(ladder_warm_stats_t*)
+ * @brief Warm start information
+ *
+ * @param stats Information
+ */
+void ladder_warm_stats(ladder_warm_stats_t *stats);
+
+#endif /* LADDER_WARM_H_ */
@@ -37,6 +37,10 @@
 #include "freertos/task.h"
 
 #include "ladder.h"
+#include "ladder_adc.h"
+#include "ladder_aout.h"
+#include "ladder_hsc.h"
+#include "ladder_registers.h"
 #include "ladderlib_esp32_gpio.h"
 #include "ladderlib_esp32_std.h"
 
@@ -65,18 +69,11 @@ const uint32_t outputs[] = {
 static bool _esp32_gpio_read_init(void) {
     gpio_config_t io_conf = {};
 
-    io_conf.pin_bit_mask = ((1ULL << INPUT_00) | (1ULL << INPUT_01) | (1ULL << INPUT_02) | (1ULL << INPUT_03) | (1ULL << INPUT_04) | (1ULL << INPUT_05)
-#ifdef ADC_01
-                            | 0
-#else
-                            | (1ULL << INPUT_06)
-#endif
-#ifdef ADC_02
-                            | 0
-#else
-                            | (1ULL << INPUT_07)
-#endif
-    );
+    io_conf.pin_bit_mask = 0;
+    // pins sampled by the ADC (adc.json channels) are left to it, else they are digital inputs too
+    for (uint32_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+        if (!ladder_adc_owns(i))
+            io_conf.pin_bit_mask |= 1ULL << inputs[i];
     io_conf.mode = GPIO_MODE_INPUT;
     io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
     io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
@@ -106,6 +103,10 @@ static bool _esp32_gpio_write_init(void) {
                             | (1ULL << OUTPUT_05)
 #endif
     );
+    // ports mapped to a QW are driven by LEDC or the DAC
+    for (uint32_t p = 0; p < sizeof(outputs) / sizeof(outputs[0]); p++)
+        if (ladder_aout_owns(p))
+            io_conf.pin_bit_mask &= ~(1ULL << outputs[p]);
     io_conf.pull_down_en = GPIO_PULLUP_DISABLE;
     io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
     if (gpio_config(&io_conf) != ESP_OK) {
@@ -121,19 +122,25 @@ bool esp32_local_init_read(ladder_ctx_t *ladder_ctx, uint32_t id, bool init) {
         if (!_esp32_gpio_read_init())
             return false;
 
+        // IW: the analog inputs, then count and frequency of each high-speed counter
+        uint32_t iw_qty = LADDER_HSC_IW_FIRST + 2 * ladder_hsc_qty();
+
         (*ladder_ctx).input[id].I = calloc(sizeof(inputs) / sizeof(uint32_t), sizeof(uint8_t));
-        (*ladder_ctx).input[id].IW = calloc(2, sizeof(int32_t));
-        (*ladder_ctx).input[id].Ih = calloc(2, sizeof(uint8_t));
+        (*ladder_ctx).input[id].IW = calloc(iw_qty, sizeof(int32_t));
+        (*ladder_ctx).input[id].Ih = calloc(sizeof(inputs) / sizeof(uint32_t), sizeof(uint8_t));
         (*ladder_ctx).input[id].i_qty = sizeof(inputs) / sizeof(uint32_t);
-        (*ladder_ctx).input[id].iw_qty = 2;
+        (*ladder_ctx).input[id].iw_qty = iw_qty;
 
         for (uint32_t n = 0; n < sizeof(inputs) / sizeof(uint32_t); n++) {
             (*ladder_ctx).input[id].I[n] = 0;
             (*ladder_ctx).input[id].Ih[n] = 0;
         }
-        for (uint32_t n = 0; n < 2; n++) {
+        for (uint32_t n = 0; n < iw_qty; n++) {
             (*ladder_ctx).input[id].IW[n] = 0;
         }
+
+        if (!ladder_hsc_start())
+            ESP_LOGE(TAG, "ERROR starting high-speed counters");
     } else {
         free((*ladder_ctx).input[id].I);
         free((*ladder_ctx).input[id].IW);
@@ -151,11 +158,15 @@ bool esp32_local_init_write(ladder_ctx_t *ladder_ctx, uint32_t id, bool init) {
             return false;
 
         (*ladder_ctx).output[id].Q = calloc(sizeof(outputs) / sizeof(uint32_t), sizeof(uint8_t));
-        (*ladder_ctx).output[id].QW = calloc(2, sizeof(int32_t));
+        (*ladder_ctx).output[id].QW = calloc(LADDER_AOUT_MAX, sizeof(int32_t));
         (*ladder_ctx).output[id].Qh = calloc(sizeof(outputs) / sizeof(uint32_t), sizeof(uint8_t));
         (*ladder_ctx).output[id].q_qty = sizeof(outputs) / sizeof(uint32_t);
-        (*ladder_ctx).output[id].qw_qty = 2;
+        (*ladder_ctx).output[id].qw_qty = LADDER_AOUT_MAX;
+
+        if (!ladder_aout_start())
+            ESP_LOGE(TAG, "ERROR starting analog outputs");
     } else {
+        ladder_aout_stop();
         free((*ladder_ctx).output[id].Q);
         free((*ladder_ctx).output[id].QW);
         free((*ladder_ctx).output[id].Qh);
@@ -175,17 +186,28 @@ void esp32_local_read(ladder_ctx_t *ladder_ctx, uint32_t id) {
         (*ladder_ctx).input[id].I[is] = (uint8_t)gpio_get_level(inputs[is]);
 #endif
     }
+    ladder_adc_read(ladder_ctx, id);
+    ladder_hsc_read(ladder_ctx, id);
+
+    ladder_registers_force_inputs(ladder_ctx, id);
 }
 
 void esp32_local_write(ladder_ctx_t *ladder_ctx, uint32_t id) {
+    ladder_registers_force_outputs(ladder_ctx, id);
+
     for (uint32_t p = 0; p < sizeof(outputs) / sizeof(outputs[0]); p++) {
         (*ladder_ctx).output[id].Qh[p] = (*ladder_ctx).output[id].Q[p];
+        if (ladder_aout_owns(p))
+            continue;
+        // a counter compare output stays on until its pulse ends or the counter is preset
+        bool level = (*ladder_ctx).output[id].Q[p] || ladder_hsc_output(p);
 #ifdef INVERT_OUTPUT
-        gpio_set_level(outputs[p], !(*ladder_ctx).output[id].Q[p]));
+        gpio_set_level(outputs[p], !level);
 #else
-        gpio_set_level(outputs[p], (*ladder_ctx).output[id].Q[p]);
+        gpio_set_level(outputs[p], level);
 #endif
     }
+    ladder_aout_write(ladder_ctx, id);
 }
 
 void _esp32_port_test(bool input) {
@@ -39,6 +39,8 @@
 #define INPUT_06 GPIO_NUM_39
 #define INPUT_07 GPIO_NUM_36
 
+#define LOCAL_INPUTS 8 // inputs[] size
+
 #define OUTPUT_00 GPIO_NUM_4
 #define OUTPUT_01 GPIO_NUM_16
 #define OUTPUT_02 GPIO_NUM_2
@@ -46,6 +48,8 @@
 #define OUTPUT_04 GPIO_NUM_26
 #define OUTPUT_05 GPIO_NUM_25
 
+#define LOCAL_OUTPUTS 6 // outputs[] size
+
 #define ADC_01 INPUT_06
 #define ADC_02 INPUT_07
 
@@ -34,14 +34,34 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
 #include "ladder.h"
+#include "ladder_datalogger.h"
+#include "ladder_retentive.h"
+#include "ladder_warm.h"
 #include "ladderlib_esp32_std.h"
+#include "metrics.h"
+#include "mqtt_publisher.h"
 #include "webeditor.h"
 
 static const char *TAG = "ladderlib_esp32_std";
 
+#define SCAN_SYNC_QUEUE_LEN 16
+#define SCAN_SYNC_LOCK_MS   500 // longest wait for the last scan of a stopping ladder
+
+typedef struct scan_sync_job_s {
+    esp32_scan_sync_fn_t fn;
+    void *arg;
+} scan_sync_job_t;
+
+static QueueHandle_t scan_sync_queue = NULL;
+static SemaphoreHandle_t scan_lock = NULL; // held by the scan task from task_before to task_after, and by every job
+static bool scan_locked = false;           // scan task only
+static uint32_t program_generation = 0;    // changed under scan_lock by every program swap
+
 static const char *_ladder_status_str[] = {
     "STOPPED",  //
     "RUNNING",  //
@@ -111,6 +131,11 @@ uint64_t esp32_millis(void) {
 }
 
 bool esp32_on_scan_end(ladder_ctx_t *ladder_ctx) {
+    metrics_scan((*ladder_ctx).scan_internals.actual_scan_time);
+    ladder_warm_scan(ladder_ctx);
+    ladder_datalogger_sample(ladder_ctx);
+    ladder_retentive_scan(ladder_ctx);
+    mqtt_publisher_scan(ladder_ctx);
     ws_send_netstate(true);
 
     return false;
@@ -121,10 +146,22 @@ bool esp32_on_instruction(ladder_ctx_t *ladder_ctx) {
 }
 
 bool esp32_on_task_before(ladder_ctx_t *ladder_ctx) {
+    // a loop that skipped task_after still holds the lock
+    if (!scan_locked && scan_lock != NULL) {
+        xSemaphoreTakeRecursive(scan_lock, portMAX_DELAY);
+        scan_locked = true;
+    }
+    esp32_scan_sync_run(ladder_ctx);
+
     return false;
 }
 
 bool esp32_on_task_after(ladder_ctx_t *ladder_ctx) {
+    if (scan_locked) {
+        scan_locked = false;
+        xSemaphoreGiveRecursive(scan_lock);
+    }
+
     if ((*ladder_ctx).scan_internals.actual_scan_time < 1)
         esp32_delay(1);
 
@@ -144,6 +181,87 @@ void esp32_on_panic(ladder_ctx_t *ladder_ctx) {
 
 void esp32_on_end_task(ladder_ctx_t *ladder_ctx) {
     ESP_LOGI(TAG, "End Task Ladder");
+    ladder_warm_stop();
+    esp32_scan_sync_run(ladder_ctx);
+    if (scan_locked) {
+        scan_locked = false;
+        xSemaphoreGiveRecursive(scan_lock);
+    }
     ws_send_netstate(false);
     vTaskDelete(NULL);
 }
+
+bool esp32_scan_sync_init(void) {
+    if (scan_sync_queue != NULL)
+        return true;
+
+    scan_sync_queue = xQueueCreate(SCAN_SYNC_QUEUE_LEN, sizeof(scan_sync_job_t));
+    scan_lock = xSemaphoreCreateRecursiveMutex();
+    if (scan_sync_queue == NULL || scan_lock == NULL) {
+        ESP_LOGE(TAG, "ERROR scan sync init");
+        return false;
+    }
+
+    return true;
+}
+
+bool esp32_scan_sync_post(ladder_ctx_t *ladder_ctx, esp32_scan_sync_fn_t fn, void *arg) {
+    scan_sync_job_t job = {
+        .fn = fn,   //
+        .arg = arg, //
+    };
+
+    if (scan_sync_queue == NULL)
+        return false;
+
+    // not running: apply now, after anything still pending. The lock waits for a scan still in progress (EXIT_TSK)
+    // and holds a scan task started meanwhile at its first boundary. A task that keeps scanning gets the job queued.
+    if ((*ladder_ctx).ladder.state != LADDER_ST_RUNNING) {
+        if (xSemaphoreTakeRecursive(scan_lock, pdMS_TO_TICKS(SCAN_SYNC_LOCK_MS)) == pdTRUE) {
+            esp32_scan_sync_run(ladder_ctx);
+            fn(ladder_ctx, arg);
+            xSemaphoreGiveRecursive(scan_lock);
+            return true;
+        }
+        if ((*ladder_ctx).ladder.state != LADDER_ST_RUNNING) {
+            ESP_LOGW(TAG, "scan sync: scan task not released");
+            return false;
+        }
+    }
+
+    if (xQueueSend(scan_sync_queue, &job, pdMS_TO_TICKS(100)) != pdTRUE) {
+        ESP_LOGW(TAG, "scan sync queue full");
+        return false;
+    }
+
+    return true;
+}
+
+void esp32_scan_sync_run(ladder_ctx_t *ladder_ctx) {
+    scan_sync_job_t job;
+
+    if (scan_sync_queue == NULL || uxQueueMessagesWaiting(scan_sync_queue) == 0)
+        return;
+
+    xSemaphoreTakeRecursive(scan_lock, portMAX_DELAY);
+    while (xQueueReceive(scan_sync_queue, &job, 0) == pdTRUE)
+        job.fn(ladder_ctx, job.arg);
+    xSemaphoreGiveRecursive(scan_lock);
+}
+
+void esp32_scan_lock(void) {
+    xSemaphoreTakeRecursive(scan_lock, portMAX_DELAY);
+}
+
+void esp32_scan_unlock(void) {
+    xSemaphoreGiveRecursive(scan_lock);
+}
+
+void esp32_program_changed(void) {
+    __atomic_add_fetch(&program_generation, 1, __ATOMIC_RELEASE);
+    ladder_warm_program_changed();
+}
+
+uint32_t esp32_program_generation(void) {
+    return __atomic_load_n(&program_generation, __ATOMIC_ACQUIRE);
+}
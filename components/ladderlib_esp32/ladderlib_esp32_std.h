@@ -32,6 +32,12 @@
 
 #include "ladder.h"
 
+/**
+ * @brief Job executed between two scans
+ *
+ */
+typedef void (*esp32_scan_sync_fn_t)(ladder_ctx_t *ladder_ctx, void *arg);
+
 /**
  * @fn bool esp32_on_scan_end(ladder_ctx_t*)
  * @brief
@@ -100,4 +106,60 @@ void esp32_delay(long msec);
  */
 uint64_t esp32_millis(void);
 
+/**
+ * @fn bool esp32_scan_sync_init(void)
+ * @brief Create the scan boundary job queue
+ *
+ * @return
+ */
+bool esp32_scan_sync_init(void);
+
+/**
+ * @fn bool esp32_scan_sync_post(ladder_ctx_t*, esp32_scan_sync_fn_t, void*)
+ * @brief Run fn at the next scan boundary (immediately if the ladder is not running, excluded from the scan task)
+ *
+ * @param ladder_ctx
+ * @param fn
+ * @param arg
+ * @return
+ */
+bool esp32_scan_sync_post(ladder_ctx_t *ladder_ctx, esp32_scan_sync_fn_t fn, void *arg);
+
+/**
+ * @fn void esp32_scan_sync_run(ladder_ctx_t*)
+ * @brief Run pending scan boundary jobs
+ *
+ * @param ladder_ctx
+ */
+void esp32_scan_sync_run(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void esp32_scan_lock(void)
+ * @brief Exclude scans and scan boundary jobs (recursive). The scan task holds it for a whole scan, keep it short.
+ *
+ */
+void esp32_scan_lock(void);
+
+/**
+ * @fn void esp32_scan_unlock(void)
+ * @brief Release esp32_scan_lock
+ *
+ */
+void esp32_scan_unlock(void);
+
+/**
+ * @fn void esp32_program_changed(void)
+ * @brief Record a program swap (called by the scan boundary jobs that replace networks)
+ *
+ */
+void esp32_program_changed(void);
+
+/**
+ * @fn uint32_t esp32_program_generation(void)
+ * @brief Count of program swaps, readers walking the networks outside the scan lock compare it to detect a swap
+ *
+ * @return
+ */
+uint32_t esp32_program_generation(void);
+
 #endif /* LADDERLIB_ESP32_STD_H_ */
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "metrics.h"
+
+static const char *TAG = "metrics";
+
+#define METRICS_OUT_BUFFER 1024
+#define METRICS_WS_CLIENTS 16
+
+static const uint32_t scan_buckets_ms[] = {
+    1,    //
+    2,    //
+    5,    //
+    10,   //
+    20,   //
+    50,   //
+    100,  //
+    250,  //
+    500,  //
+    1000, //
+};
+
+static const char *scan_buckets_le[] = {
+    "0.001", //
+    "0.002", //
+    "0.005", //
+    "0.01",  //
+    "0.02",  //
+    "0.05",  //
+    "0.1",   //
+    "0.25",  //
+    "0.5",   //
+    "1",     //
+};
+
+#define SCAN_BUCKETS (sizeof(scan_buckets_ms) / sizeof(scan_buckets_ms[0]))
+
+typedef struct metrics_counters_s {
+    uint32_t scan_bucket[SCAN_BUCKETS + 1]; // not cumulative, last is +Inf
+    uint64_t scan_count;                    //
+    uint64_t scan_sum_ms;                   //
+    uint64_t scan_overruns;                 //
+    uint64_t ws_sent_bytes;                 //
+    uint32_t ftp_transfers[2][2];           // [upload][ok]
+    uint64_t ftp_bytes[2];                  // [upload]
+} metrics_counters_t;
+
+typedef struct metrics_task_s {
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t number;
+    uint32_t stack_free;
+    uint32_t runtime;
+    float cpu;
+} metrics_task_t;
+
+typedef struct metrics_cache_s {
+    int64_t updated;
+    uint32_t heap_free;
+    uint32_t heap_min_free;
+    uint32_t heap_largest;
+    bool rssi_valid;
+    int8_t rssi;
+    uint32_t tasks_total;
+    uint32_t tasks_qty;
+    metrics_task_t tasks[METRICS_TASKS_MAX];
+} metrics_cache_t;
+
+typedef struct metrics_out_s {
+    httpd_req_t *req;
+    size_t len;
+    char buf[METRICS_OUT_BUFFER];
+} metrics_out_t;
+
+static metrics_counters_t counters;
+static portMUX_TYPE counters_lock = portMUX_INITIALIZER_UNLOCKED;
+static metrics_cache_t cache;
+static SemaphoreHandle_t cache_mutex = NULL;
+static TaskHandle_t metrics_task_hndl = NULL;
+
+static void metrics_refresh(metrics_cache_t *next, const metrics_cache_t *prev) {
+    wifi_ap_record_t ap;
+
+    memset(next, 0, sizeof(metrics_cache_t));
+    next->updated = esp_timer_get_time();
+    next->heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    next->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    next->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        next->rssi_valid = true;
+        next->rssi = ap.rssi;
+    }
+
+    UBaseType_t qty = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = malloc(qty * sizeof(TaskStatus_t));
+    if (status == NULL)
+        return;
+
+    uint32_t total = 0;
+    qty = uxTaskGetSystemState(status, qty, &total);
+    next->tasks_total = qty;
+
+#ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    // usage over the last refresh period, 100% is every core busy
+    uint32_t elapsed = (uint32_t)(next->updated - prev->updated) * portNUM_PROCESSORS;
+#endif
+
+    for (UBaseType_t n = 0; n < qty && next->tasks_qty < METRICS_TASKS_MAX; n++) {
+        metrics_task_t *task = &next->tasks[next->tasks_qty++];
+
+        strlcpy(task->name, status[n].pcTaskName, sizeof(task->name));
+        task->number = status[n].xTaskNumber;
+        task->stack_free = status[n].usStackHighWaterMark;
+#ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        task->runtime = status[n].ulRunTimeCounter;
+        for (uint32_t p = 0; p < prev->tasks_qty; p++) {
+            if (prev->tasks[p].number == task->number) {
+                if (elapsed > 0 && prev->updated > 0)
+                    task->cpu = (float)(task->runtime - prev->tasks[p].runtime) * 100.0f / elapsed;
+                break;
+            }
+        }
+#endif
+    }
+
+    free(status);
+}
+
+static void metrics_task(void *pvParameters) {
+    static metrics_cache_t next;
+
+    while (1) {
+        metrics_refresh(&next, &cache);
+
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        memcpy(&cache, &next, sizeof(metrics_cache_t));
+        xSemaphoreGive(cache_mutex);
+
+        vTaskDelay(pdMS_TO_TICKS(METRICS_REFRESH_MS));
+    }
+}
+
+static bool metrics_flush(metrics_out_t *out) {
+    if (out->len == 0)
+        return true;
+
+    esp_err_t err = httpd_resp_send_chunk(out->req, out->buf, out->len);
+    out->len = 0;
+
+    return err == ESP_OK;
+}
+
+static bool metrics_printf(metrics_out_t *out, const char *fmt, ...) {
+    va_list args;
+    int len;
+
+    for (int retry = 0; retry < 2; retry++) {
+        va_start(args, fmt);
+        len = vsnprintf(out->buf + out->len, METRICS_OUT_BUFFER - out->len, fmt, args);
+        va_end(args);
+
+        if (len < 0)
+            return false;
+
+        if (out->len + len < METRICS_OUT_BUFFER) {
+            out->len += len;
+            return true;
+        }
+
+        // did not fit: flush and try again on an empty buffer
+        if (!metrics_flush(out))
+            return false;
+    }
+
+    return false;
+}
+
+static uint32_t metrics_ws_clients(httpd_handle_t server) {
+    int client_fds[METRICS_WS_CLIENTS];
+    size_t fds = METRICS_WS_CLIENTS;
+    uint32_t clients = 0;
+
+    if (httpd_get_client_list(server, &fds, client_fds) != ESP_OK)
+        return 0;
+
+    for (size_t n = 0; n < fds; n++)
+        if (httpd_ws_get_fd_info(server, client_fds[n]) == HTTPD_WS_CLIENT_WEBSOCKET)
+            clients++;
+
+    return clients;
+}
+
+static esp_err_t metrics_get_req_handler(httpd_req_t *req) {
+    static metrics_cache_t snapshot;
+    static metrics_out_t out;
+    metrics_counters_t cnt;
+    uint32_t cumulative = 0;
+
+    // values are copied first, rendering never blocks the scan or the refresh task
+    taskENTER_CRITICAL(&counters_lock);
+    memcpy(&cnt, &counters, sizeof(metrics_counters_t));
+    taskEXIT_CRITICAL(&counters_lock);
+
+    // the handler runs on the single httpd task, the static buffers are not shared
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    memcpy(&snapshot, &cache, sizeof(metrics_cache_t));
+    xSemaphoreGive(cache_mutex);
+
+    out.req = req;
+    out.len = 0;
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    metrics_printf(&out, "# HELP plc_scan_duration_seconds Ladder scan time\n# TYPE plc_scan_duration_seconds histogram\n");
+    for (uint32_t n = 0; n < SCAN_BUCKETS; n++) {
+        cumulative += cnt.scan_bucket[n];
+        metrics_printf(&out, "plc_scan_duration_seconds_bucket{le=\"%s\"} %" PRIu32 "\n", scan_buckets_le[n], cumulative);
+    }
+    metrics_printf(&out, "plc_scan_duration_seconds_bucket{le=\"+Inf\"} %" PRIu32 "\n", cumulative + cnt.scan_bucket[SCAN_BUCKETS]);
+    metrics_printf(&out, "plc_scan_duration_seconds_sum %" PRIu64 ".%03" PRIu64 "\n", cnt.scan_sum_ms / 1000, cnt.scan_sum_ms % 1000);
+    metrics_printf(&out, "plc_scan_duration_seconds_count %" PRIu64 "\n", cnt.scan_count);
+
+    metrics_printf(&out, "# HELP plc_scans_total Ladder scans\n# TYPE plc_scans_total counter\nplc_scans_total %" PRIu64 "\n", cnt.scan_count);
+    metrics_printf(&out, "# HELP plc_scan_overruns_total Scans longer than %d ms\n# TYPE plc_scan_overruns_total counter\nplc_scan_overruns_total %" PRIu64 "\n",
+                   METRICS_SCAN_OVERRUN_MS, cnt.scan_overruns);
+
+    metrics_printf(&out, "# HELP plc_heap_free_bytes Free heap\n# TYPE plc_heap_free_bytes gauge\nplc_heap_free_bytes %" PRIu32 "\n", snapshot.heap_free);
+    metrics_printf(&out, "# HELP plc_heap_min_free_bytes Minimum free heap since boot\n# TYPE plc_heap_min_free_bytes gauge\nplc_heap_min_free_bytes %" PRIu32 "\n",
+                   snapshot.heap_min_free);
+    metrics_printf(&out, "# HELP plc_heap_largest_free_block_bytes Largest free heap block\n# TYPE plc_heap_largest_free_block_bytes gauge\n");
+    metrics_printf(&out, "plc_heap_largest_free_block_bytes %" PRIu32 "\n", snapshot.heap_largest);
+
+    metrics_printf(&out, "# HELP plc_tasks Running tasks\n# TYPE plc_tasks gauge\nplc_tasks %" PRIu32 "\n", snapshot.tasks_total);
+    metrics_printf(&out, "# HELP plc_task_stack_free_bytes Task stack high water mark\n# TYPE plc_task_stack_free_bytes gauge\n");
+    for (uint32_t n = 0; n < snapshot.tasks_qty; n++)
+        metrics_printf(&out, "plc_task_stack_free_bytes{task=\"%s\"} %" PRIu32 "\n", snapshot.tasks[n].name, snapshot.tasks[n].stack_free);
+#ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    metrics_printf(&out, "# HELP plc_task_cpu_percent Task CPU usage over the last %d ms\n# TYPE plc_task_cpu_percent gauge\n", METRICS_REFRESH_MS);
+    for (uint32_t n = 0; n < snapshot.tasks_qty; n++)
+        metrics_printf(&out, "plc_task_cpu_percent{task=\"%s\"} %.2f\n", snapshot.tasks[n].name, snapshot.tasks[n].cpu);
+#endif
+
+    metrics_printf(&out, "# HELP plc_ws_clients Connected websocket clients\n# TYPE plc_ws_clients gauge\nplc_ws_clients %" PRIu32 "\n",
+                   metrics_ws_clients(req->handle));
+    metrics_printf(&out, "# HELP plc_ws_sent_bytes_total Bytes sent to websocket clients\n# TYPE plc_ws_sent_bytes_total counter\nplc_ws_sent_bytes_total %" PRIu64 "\n",
+                   cnt.ws_sent_bytes);
+
+    // one contiguous group per family
+    metrics_printf(&out, "# HELP plc_ftp_transfers_total FTP file transfers\n# TYPE plc_ftp_transfers_total counter\n");
+    for (int upload = 0; upload < 2; upload++) {
+        const char *direction = upload ? "rx" : "tx";
+        metrics_printf(&out, "plc_ftp_transfers_total{direction=\"%s\",result=\"ok\"} %" PRIu32 "\n", direction, cnt.ftp_transfers[upload][1]);
+        metrics_printf(&out, "plc_ftp_transfers_total{direction=\"%s\",result=\"error\"} %" PRIu32 "\n", direction, cnt.ftp_transfers[upload][0]);
+    }
+    metrics_printf(&out, "# HELP plc_ftp_bytes_total FTP file bytes\n# TYPE plc_ftp_bytes_total counter\n");
+    for (int upload = 0; upload < 2; upload++)
+        metrics_printf(&out, "plc_ftp_bytes_total{direction=\"%s\"} %" PRIu64 "\n", upload ? "rx" : "tx", cnt.ftp_bytes[upload]);
+
+    if (snapshot.rssi_valid)
+        metrics_printf(&out, "# HELP plc_wifi_rssi_dbm Wi-Fi signal\n# TYPE plc_wifi_rssi_dbm gauge\nplc_wifi_rssi_dbm %d\n", snapshot.rssi);
+
+    metrics_printf(&out, "# HELP plc_metrics_cache_age_seconds Age of heap, task and Wi-Fi values\n# TYPE plc_metrics_cache_age_seconds gauge\n");
+    metrics_printf(&out, "plc_metrics_cache_age_seconds %.3f\n", (float)(esp_timer_get_time() - snapshot.updated) / 1000000.0f);
+
+    if (!metrics_flush(&out))
+        return ESP_FAIL;
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void metrics_scan(uint64_t scan_time_ms) {
+    uint32_t bucket = 0;
+
+    while (bucket < SCAN_BUCKETS && scan_time_ms > scan_buckets_ms[bucket])
+        bucket++;
+
+    taskENTER_CRITICAL(&counters_lock);
+    counters.scan_bucket[bucket]++;
+    counters.scan_count++;
+    counters.scan_sum_ms += scan_time_ms;
+    if (scan_time_ms > METRICS_SCAN_OVERRUN_MS)
+        counters.scan_overruns++;
+    taskEXIT_CRITICAL(&counters_lock);
+}
+
+void metrics_ws_sent(size_t bytes) {
+    taskENTER_CRITICAL(&counters_lock);
+    counters.ws_sent_bytes += bytes;
+    taskEXIT_CRITICAL(&counters_lock);
+}
+
+void metrics_ftp_transfer(bool upload, size_t bytes, bool ok) {
+    taskENTER_CRITICAL(&counters_lock);
+    counters.ftp_transfers[upload ? 1 : 0][ok ? 1 : 0]++;
+    counters.ftp_bytes[upload ? 1 : 0] += bytes;
+    taskEXIT_CRITICAL(&counters_lock);
+}
+
+esp_err_t metrics_start(httpd_handle_t server) {
+    if (cache_mutex == NULL) {
+        cache_mutex = xSemaphoreCreateMutex();
+        if (cache_mutex == NULL)
+            return ESP_ERR_NO_MEM;
+
+        if (xTaskCreate(metrics_task, "metrics", 3072, NULL, 1, &metrics_task_hndl) != pdPASS) {
+            ESP_LOGE(TAG, "ERROR start metrics task");
+            return ESP_FAIL;
+        }
+    }
+
+    httpd_uri_t metrics = {
+        .uri = "/metrics",                  //
+        .method = HTTP_GET,                 //
+        .handler = metrics_get_req_handler, //
+        .user_ctx = NULL                    //
+    };
+
+    return httpd_register_uri_handler(server, &metrics);
+}
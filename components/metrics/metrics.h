@@ -0,0 +1,78 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_http_server.h"
+
+#define METRICS_REFRESH_MS      5000 // heap, tasks and RSSI cache refresh period
+#define METRICS_TASKS_MAX       24   // tasks reported
+#define METRICS_SCAN_OVERRUN_MS 10   // scans longer than this are counted as overruns
+
+/**
+ * @fn void metrics_scan(uint64_t)
+ * @brief Account one ladder scan. Called from the scan task
+ *
+ * @param scan_time_ms Scan time
+ */
+void metrics_scan(uint64_t scan_time_ms);
+
+/**
+ * @fn void metrics_ws_sent(size_t)
+ * @brief Account bytes sent to websocket clients
+ *
+ * @param bytes Bytes
+ */
+void metrics_ws_sent(size_t bytes);
+
+/**
+ * @fn void metrics_ftp_transfer(bool, size_t, bool)
+ * @brief Account one finished FTP file transfer
+ *
+ * @param upload true for STOR/APPE, false for RETR
+ * @param bytes Bytes transferred
+ * @param ok Transfer completed
+ */
+void metrics_ftp_transfer(bool upload, size_t bytes, bool ok);
+
+/**
+ * @fn esp_err_t metrics_start(httpd_handle_t)
+ * @brief Start the cache refresh task and register GET /metrics
+ *
+ * @param server HTTP server
+ * @return Status
+ */
+esp_err_t metrics_start(httpd_handle_t server);
+
+#endif /* METRICS_H_ */
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_H_
+#define MODBUS_H_
+
+#include <stdint.h>
+
+#define MODBUS_TCP_PORT      502 //
+#define MODBUS_MBAP_LEN      7   // transaction, protocol, length, unit
+#define MODBUS_PDU_MAX       253 //
+#define MODBUS_ADU_MAX       (MODBUS_MBAP_LEN + MODBUS_PDU_MAX)
+#define MODBUS_READ_BITS_MAX 2000 // FC 1, 2
+#define MODBUS_READ_REGS_MAX 125  // FC 3, 4
+#define MODBUS_WRITE_BITS_MAX 1968 // FC 15
+#define MODBUS_WRITE_REGS_MAX 123  // FC 16
+
+/**
+ * @enum modbus_function_t
+ * @brief Function codes
+ *
+ */
+typedef enum MODBUS_FUNCTION {
+    MODBUS_FC_READ_COILS = 0x01,          //
+    MODBUS_FC_READ_DISCRETE = 0x02,       //
+    MODBUS_FC_READ_HOLDING = 0x03,        //
+    MODBUS_FC_READ_INPUT = 0x04,          //
+    MODBUS_FC_WRITE_COIL = 0x05,          //
+    MODBUS_FC_WRITE_REGISTER = 0x06,      //
+    MODBUS_FC_WRITE_COILS = 0x0f,         //
+    MODBUS_FC_WRITE_REGISTERS = 0x10,     //
+    MODBUS_FC_EXCEPTION = 0x80,           // or'ed with the function code
+} modbus_function_t;
+
+/**
+ * @enum modbus_exception_t
+ * @brief Exception codes
+ *
+ */
+typedef enum MODBUS_EXCEPTION {
+    MODBUS_EX_NONE = 0x00,             //
+    MODBUS_EX_ILLEGAL_FUNCTION = 0x01, //
+    MODBUS_EX_ILLEGAL_ADDRESS = 0x02,  //
+    MODBUS_EX_ILLEGAL_VALUE = 0x03,    //
+    MODBUS_EX_DEVICE_FAILURE = 0x04,   //
+    MODBUS_EX_GATEWAY_TIMEOUT = 0x0b,  // no response from the target (client side)
+} modbus_exception_t;
+
+#define MODBUS_GET16(P)    ((uint16_t)(((P)[0] << 8) | (P)[1]))
+#define MODBUS_PUT16(P, V)              \
+    do {                                \
+        (P)[0] = (uint8_t)((V) >> 8);   \
+        (P)[1] = (uint8_t)(V);          \
+    } while (0)
+
+#endif /* MODBUS_H_ */
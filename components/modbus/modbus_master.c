@@ -0,0 +1,386 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_io_modules.h"
+#include "ladder_registers.h"
+#include "ladder_warm.h"
+#include "modbus.h"
+#include "modbus_master.h"
+
+static const char *TAG = "modbus_master";
+
+#define MODBUS_MASTER_RTU_BUFFER 512 // UART driver rx buffer
+
+typedef struct mm_module_s {
+    modbus_master_config_t config;                     // entries as configured
+    modbus_poll_t poll;                                // requests merged from the entries
+    modbus_master_session_t session;                   // link and points state
+    uint32_t stale_ms;                                 //
+    uint8_t *bits;                                     // inputs as last read
+    int32_t *words;                                    //
+    uint32_t i_qty;                                    //
+    uint32_t iw_qty;                                   //
+    uint32_t q_qty;                                    //
+    uint32_t qw_qty;                                   //
+    int in_id;                                         //
+    uint32_t cycle_us;                                 //
+    uint32_t cycle_max_us;                             //
+} mm_module_t;
+
+static mm_module_t *mm_module[MODBUS_MASTER_MODULES_MAX];
+static uint32_t mm_modules = 0;
+
+static inline uint32_t now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static bool point_valid(const modbus_master_point_t *point) {
+    uint8_t type;
+
+    switch (point->function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE:
+            type = LADDER_REGISTER_I;
+            break;
+        case MODBUS_FC_READ_HOLDING:
+        case MODBUS_FC_READ_INPUT:
+            type = LADDER_REGISTER_IW;
+            break;
+        case MODBUS_FC_WRITE_COIL:
+        case MODBUS_FC_WRITE_COILS:
+            type = LADDER_REGISTER_Q;
+            break;
+        case MODBUS_FC_WRITE_REGISTER:
+        case MODBUS_FC_WRITE_REGISTERS:
+            type = LADDER_REGISTER_QW;
+            break;
+        default:
+            return false;
+    }
+
+    return point->type == type && point->count > 0 && point->count <= modbus_poll_function_max(point->function) &&
+           (uint32_t)point->addr + point->count <= 0x10000 && (uint32_t)point->index + point->count <= MODBUS_READ_BITS_MAX;
+}
+
+static bool mm_init(void *arg) {
+    mm_module_t *module = arg;
+
+    if (module->config.link != MODBUS_MASTER_RTU)
+        return true;
+
+    uart_parity_t parity = UART_PARITY_DISABLE;
+    if (module->config.parity == 'E')
+        parity = UART_PARITY_EVEN;
+    else if (module->config.parity == 'O')
+        parity = UART_PARITY_ODD;
+
+    uart_config_t uart_config = {
+        .baud_rate = module->config.baud,                                                 //
+        .data_bits = UART_DATA_8_BITS,                                                    //
+        .parity = parity,                                                                 //
+        .stop_bits = parity == UART_PARITY_DISABLE ? UART_STOP_BITS_2 : UART_STOP_BITS_1, // 11 bits per character
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,                                            //
+        .source_clk = UART_SCLK_DEFAULT,                                                  //
+    };
+
+    if (uart_driver_install(module->config.uart, MODBUS_MASTER_RTU_BUFFER, 0, 0, NULL, 0) != ESP_OK ||
+        uart_param_config(module->config.uart, &uart_config) != ESP_OK ||
+        uart_set_pin(module->config.uart, module->config.tx, module->config.rx, module->config.de, UART_PIN_NO_CHANGE) != ESP_OK) {
+        ESP_LOGE(TAG, "ERROR %s: uart %u", module->config.name, module->config.uart);
+        return false;
+    }
+    if (module->config.de >= 0)
+        uart_set_mode(module->config.uart, UART_MODE_RS485_HALF_DUPLEX);
+
+    module->session.bus_idle = esp_timer_get_time();
+
+    return true;
+}
+
+static bool mm_poll(void *arg, const ladder_io_image_t *out, ladder_io_image_t *in) {
+    mm_module_t *module = arg;
+    int64_t start = esp_timer_get_time();
+
+    uint32_t answered = modbus_master_session_cycle(&module->session, out);
+
+    uint32_t ms = now_ms();
+    for (uint32_t n = 0; n < module->config.points; n++) {
+        const modbus_master_point_t *point = &module->config.point[n];
+        bool stale = module->session.point_ok_ms[n] == 0 || ms - module->session.point_ok_ms[n] > module->stale_ms;
+
+        if (!stale || !module->config.stale_clear)
+            continue;
+        if (point->type == LADDER_REGISTER_I)
+            memset(&module->bits[point->index], 0, point->count * sizeof(uint8_t));
+        else if (point->type == LADDER_REGISTER_IW)
+            memset(&module->words[point->index], 0, point->count * sizeof(int32_t));
+    }
+
+    memcpy(in->bits, module->bits, module->i_qty * sizeof(uint8_t));
+    memcpy(in->words, module->words, module->iw_qty * sizeof(int32_t));
+
+    module->cycle_us = esp_timer_get_time() - start;
+    if (module->cycle_us > module->cycle_max_us)
+        module->cycle_max_us = module->cycle_us;
+
+    // the module is failed only when no slave answered
+    return answered > 0;
+}
+
+int modbus_master_add(ladder_ctx_t *ladder_ctx, const modbus_master_config_t *config) {
+    ladder_io_module_def_t def = { 0 };
+
+    if (mm_modules == MODBUS_MASTER_MODULES_MAX || config->points == 0 || config->points > MODBUS_MASTER_POINTS_MAX)
+        return -1;
+
+    for (uint32_t n = 0; n < config->points; n++) {
+        if (!point_valid(&config->point[n])) {
+            ESP_LOGE(TAG, "ERROR %s: point %" PRIu32, config->name, n);
+            return -1;
+        }
+    }
+
+    mm_module_t *module = calloc(1, sizeof(mm_module_t));
+    if (module == NULL)
+        return -1;
+
+    module->config = *config;
+    if (module->config.period_ms == 0)
+        module->config.period_ms = 100;
+    if (module->config.timeout_ms == 0)
+        module->config.timeout_ms = MODBUS_MASTER_TIMEOUT_MS;
+    if (module->config.pipeline == 0 || module->config.link == MODBUS_MASTER_RTU)
+        module->config.pipeline = 1;
+    if (module->config.pipeline > MODBUS_MASTER_PIPELINE_MAX)
+        module->config.pipeline = MODBUS_MASTER_PIPELINE_MAX;
+    module->stale_ms = module->config.stale_ms > 0 ? module->config.stale_ms : LADDER_IO_STALE_PERIODS * module->config.period_ms;
+
+    modbus_poll_build(&module->poll, module->config.point, module->config.points);
+
+    for (uint32_t n = 0; n < module->config.points; n++) {
+        const modbus_master_point_t *point = &module->config.point[n];
+        uint32_t end = point->index + point->count;
+
+        switch (point->type) {
+            case LADDER_REGISTER_I:
+                module->i_qty = end > module->i_qty ? end : module->i_qty;
+                break;
+            case LADDER_REGISTER_IW:
+                module->iw_qty = end > module->iw_qty ? end : module->iw_qty;
+                break;
+            case LADDER_REGISTER_Q:
+                module->q_qty = end > module->q_qty ? end : module->q_qty;
+                break;
+            case LADDER_REGISTER_QW:
+                module->qw_qty = end > module->qw_qty ? end : module->qw_qty;
+                break;
+        }
+    }
+
+    module->bits = calloc(module->i_qty > 0 ? module->i_qty : 1, sizeof(uint8_t));
+    module->words = calloc(module->iw_qty > 0 ? module->iw_qty : 1, sizeof(int32_t));
+    if (module->bits == NULL || module->words == NULL)
+        goto error;
+    modbus_master_session_init(&module->session, &module->config, &module->poll, module->bits, module->words);
+
+    def.name = module->config.name;
+    def.i_qty = module->i_qty;
+    def.iw_qty = module->iw_qty;
+    def.q_qty = module->q_qty;
+    def.qw_qty = module->qw_qty;
+    def.period_ms = module->config.period_ms;
+    def.stale_ms = module->stale_ms;
+    def.stale_clear = module->config.stale_clear;
+    def.init = mm_init;
+    def.poll = mm_poll;
+    def.arg = module;
+
+    module->in_id = ladder_io_module_add(ladder_ctx, &def);
+    if (module->in_id < 0)
+        goto error;
+
+    mm_module[mm_modules] = module;
+    ladder_warm_config_add(LADDER_WARM_CONFIG_MODBUS_MASTER, mm_modules++, config, sizeof(modbus_master_config_t));
+    ESP_LOGI(TAG, "%s: %" PRIu32 " points in %" PRIu32 " requests", module->config.name, module->config.points, module->poll.requests);
+
+    return module->in_id;
+
+error:
+    free(module->bits);
+    free(module->words);
+    free(module);
+    return -1;
+}
+
+static int json_int(cJSON *object, const char *name, int def) {
+    cJSON *item = cJSON_GetObjectItem(object, name);
+    return cJSON_IsNumber(item) ? item->valueint : def;
+}
+
+uint32_t modbus_master_load(ladder_ctx_t *ladder_ctx, const char *file) {
+    modbus_master_config_t *config;
+    uint32_t added = 0;
+    cJSON *item;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return 0;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return 0;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return 0;
+    }
+
+    config = malloc(sizeof(modbus_master_config_t));
+    if (config == NULL) {
+        cJSON_Delete(root);
+        return 0;
+    }
+
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "modules")) {
+        cJSON *point;
+        const char *value;
+
+        memset(config, 0, sizeof(modbus_master_config_t));
+        strlcpy(config->name, (value = cJSON_GetStringValue(cJSON_GetObjectItem(item, "name"))) != NULL ? value : "modbus", sizeof(config->name));
+
+        if ((value = cJSON_GetStringValue(cJSON_GetObjectItem(item, "host"))) != NULL) {
+            config->link = MODBUS_MASTER_TCP;
+            strlcpy(config->host, value, sizeof(config->host));
+            config->port = json_int(item, "port", MODBUS_TCP_PORT);
+            config->pipeline = json_int(item, "pipeline", 4);
+        } else {
+            config->link = MODBUS_MASTER_RTU;
+            config->uart = json_int(item, "uart", 1);
+            config->baud = json_int(item, "baud", 19200);
+            config->parity = (value = cJSON_GetStringValue(cJSON_GetObjectItem(item, "parity"))) != NULL ? value[0] : 'E';
+            config->tx = json_int(item, "tx", UART_PIN_NO_CHANGE);
+            config->rx = json_int(item, "rx", UART_PIN_NO_CHANGE);
+            config->de = json_int(item, "de", -1);
+        }
+        config->period_ms = json_int(item, "period_ms", 100);
+        config->timeout_ms = json_int(item, "timeout_ms", MODBUS_MASTER_TIMEOUT_MS);
+        config->stale_ms = json_int(item, "stale_ms", 0);
+        config->stale_clear = cJSON_IsTrue(cJSON_GetObjectItem(item, "stale_clear"));
+
+        cJSON_ArrayForEach(point, cJSON_GetObjectItem(item, "points")) {
+            if (config->points == MODBUS_MASTER_POINTS_MAX)
+                break;
+
+            modbus_master_point_t *entry = &config->point[config->points++];
+            entry->slave = json_int(point, "slave", 1);
+            entry->function = json_int(point, "function", 0);
+            entry->addr = json_int(point, "addr", 0);
+            entry->count = json_int(point, "count", 1);
+            entry->type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(point, "type")));
+            entry->index = json_int(point, "index", 0);
+            entry->sign = cJSON_IsTrue(cJSON_GetObjectItem(point, "sign"));
+        }
+
+        if (modbus_master_add(ladder_ctx, config) < 0)
+            ESP_LOGE(TAG, "ERROR adding module %s", config->name);
+        else
+            added++;
+    }
+
+    free(config);
+    cJSON_Delete(root);
+    return added;
+}
+
+uint32_t modbus_master_info(modbus_master_info_t *info, uint32_t max) {
+    uint32_t n;
+
+    for (n = 0; n < mm_modules && n < max; n++) {
+        const mm_module_t *module = mm_module[n];
+
+        info[n].name = module->config.name;
+        info[n].in_id = module->in_id;
+        info[n].requests = module->poll.requests;
+        info[n].transactions = module->session.transactions;
+        info[n].timeouts = module->session.timeouts;
+        info[n].exceptions = module->session.exceptions;
+        info[n].connects = module->session.connects;
+        info[n].cycle_us = module->cycle_us;
+        info[n].cycle_max_us = module->cycle_max_us;
+    }
+
+    return n;
+}
+
+uint32_t modbus_master_points_info(uint32_t module_n, modbus_master_point_info_t *info, uint32_t max) {
+    uint32_t ms = now_ms();
+    uint32_t n;
+
+    if (module_n >= mm_modules)
+        return 0;
+
+    const mm_module_t *module = mm_module[module_n];
+    for (n = 0; n < module->config.points && n < max; n++) {
+        uint32_t ok_ms = module->session.point_ok_ms[n];
+
+        info[n].point = module->config.point[n];
+        info[n].request = module->poll.point_request[n];
+        info[n].age_ms = ok_ms == 0 ? UINT32_MAX : ms - ok_ms;
+        info[n].stale = ok_ms == 0 || ms - ok_ms > module->stale_ms;
+        info[n].errors = module->session.point_errors[n];
+        info[n].exception = module->session.point_exception[n];
+    }
+
+    return n;
+}
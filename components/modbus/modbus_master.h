@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_MASTER_H_
+#define MODBUS_MASTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "modbus_master_session.h"
+#include "modbus_poll.h"
+
+#define MODBUS_MASTER_MODULES_MAX  4                     // remote modules
+#define MODBUS_MASTER_CONFIG       "modbus_master.json" // modules loaded at boot
+
+/**
+ * @struct modbus_master_point_info_s
+ * @brief Poll table entry status
+ *
+ */
+typedef struct modbus_master_point_info_s {
+    modbus_master_point_t point; //
+    uint16_t request;            // merged request serving the point
+    uint32_t age_ms;             // last good exchange, UINT32_MAX: never
+    bool stale;                  //
+    uint32_t errors;             // timeouts and bad frames
+    uint8_t exception;           // last exception code, 0: none
+} modbus_master_point_info_t;
+
+/**
+ * @struct modbus_master_info_s
+ * @brief Module status
+ *
+ */
+typedef struct modbus_master_info_s {
+    const char *name;      //
+    int in_id;             // ladder module number of I/IW
+    uint32_t requests;     // merged requests per poll
+    uint32_t transactions; // completed transactions
+    uint32_t timeouts;     //
+    uint32_t exceptions;   //
+    uint32_t connects;     // TCP connections opened
+    uint32_t cycle_us;     // last poll, every request
+    uint32_t cycle_max_us; // longest poll
+} modbus_master_info_t;
+
+/**
+ * @fn int modbus_master_add(ladder_ctx_t*, const modbus_master_config_t*)
+ * @brief Add a remote module as a ladder I/O module. Entries of the same slave and function with adjacent addresses
+ *        are merged into one request. Call before the ladder is started.
+ *
+ * @param ladder_ctx Ladder context
+ * @param config Module, copied
+ * @return Ladder module number of the inputs or -1
+ */
+int modbus_master_add(ladder_ctx_t *ladder_ctx, const modbus_master_config_t *config);
+
+/**
+ * @fn uint32_t modbus_master_load(ladder_ctx_t*, const char*)
+ * @brief Read a modules file and add them
+ *
+ *        {"modules":[
+ *          {"name":"rio","host":"192.168.1.50","port":502,"period_ms":50,"timeout_ms":200,"pipeline":4,
+ *           "points":[{"slave":1,"function":2,"addr":0,"count":16,"type":"I","index":0},
+ *                     {"slave":1,"function":15,"addr":0,"count":8,"type":"Q","index":0}]},
+ *          {"name":"rtu","uart":1,"baud":19200,"parity":"E","tx":17,"rx":16,"de":4,"period_ms":100,
+ *           "points":[{"slave":3,"function":4,"addr":0,"count":4,"type":"IW","index":0,"sign":true}]}]}
+ *
+ * @param ladder_ctx Ladder context
+ * @param file File name, relative to the mount point
+ * @return Modules added
+ */
+uint32_t modbus_master_load(ladder_ctx_t *ladder_ctx, const char *file);
+
+/**
+ * @fn uint32_t modbus_master_info(modbus_master_info_t*, uint32_t)
+ * @brief Modules status
+ *
+ * @param info Status
+ * @param max Status array size
+ * @return Modules quantity
+ */
+uint32_t modbus_master_info(modbus_master_info_t *info, uint32_t max);
+
+/**
+ * @fn uint32_t modbus_master_points_info(uint32_t, modbus_master_point_info_t*, uint32_t)
+ * @brief Module poll table status, ordered as polled
+ *
+ * @param module Module, as listed by modbus_master_info()
+ * @param info Status
+ * @param max Status array size
+ * @return Entries quantity
+ */
+uint32_t modbus_master_points_info(uint32_t module, modbus_master_point_info_t *info, uint32_t max);
+
+#endif /* MODBUS_MASTER_H_ */
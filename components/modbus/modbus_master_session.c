@@ -0,0 +1,356 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+#include "modbus.h"
+#include "modbus_master_session.h"
+
+static const char *TAG = "modbus_master";
+
+#define MODBUS_MASTER_RTU_HEADER 2 // slave, function: enough to tell an exception from a response
+
+// pipelined transaction
+typedef struct mm_slot_s {
+    int32_t request;  // -1: free
+    uint16_t tid;     //
+    int64_t deadline; // us
+} mm_slot_t;
+
+static inline uint32_t now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void request_failed(modbus_master_session_t *session, const modbus_poll_request_t *request) {
+    for (uint32_t p = 0; p < request->points; p++)
+        session->point_errors[modbus_poll_entry(session->poll, request, p)]++;
+}
+
+// response PDU into the inputs, false if not a response to the request. NULL: broadcast, nothing comes back
+static bool response(modbus_master_session_t *session, const modbus_poll_request_t *request, const uint8_t *pdu, uint16_t len) {
+    uint32_t ms = now_ms();
+
+    if (pdu == NULL) {
+        for (uint32_t p = 0; p < request->points; p++)
+            session->point_ok_ms[modbus_poll_entry(session->poll, request, p)] = ms > 0 ? ms : 1;
+        return true;
+    }
+
+    switch (modbus_poll_response(session->poll, request, pdu, len, session->bits, session->words)) {
+        case MODBUS_POLL_EXCEPTION:
+            for (uint32_t p = 0; p < request->points; p++)
+                session->point_exception[modbus_poll_entry(session->poll, request, p)] = pdu[1];
+            session->exceptions++;
+            break;
+
+        case MODBUS_POLL_DATA:
+            for (uint32_t p = 0; p < request->points; p++) {
+                uint32_t entry = modbus_poll_entry(session->poll, request, p);
+                session->point_ok_ms[entry] = ms > 0 ? ms : 1;
+                session->point_exception[entry] = MODBUS_EX_NONE;
+            }
+            break;
+
+        default:
+            request_failed(session, request);
+            return false;
+    }
+
+    session->transactions++;
+    return true;
+}
+
+void modbus_master_session_close(modbus_master_session_t *session) {
+    if (session->sd < 0)
+        return;
+
+    closesocket(session->sd);
+    session->sd = -1;
+    session->rx_len = 0;
+}
+
+static bool tcp_connect(modbus_master_session_t *session) {
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    struct timeval timeout;
+    fd_set wfds;
+    int option = 1, error = 0;
+    socklen_t error_len = sizeof(error);
+    char port[8];
+
+    snprintf(port, sizeof(port), "%u", session->config->port);
+    if (getaddrinfo(session->config->host, port, &hints, &res) != 0 || res == NULL)
+        return false;
+
+    session->sd = socket(res->ai_family, res->ai_socktype, 0);
+    if (session->sd < 0) {
+        freeaddrinfo(res);
+        return false;
+    }
+
+    setsockopt(session->sd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+    fcntl(session->sd, F_SETFL, fcntl(session->sd, F_GETFL, 0) | O_NONBLOCK);
+
+    int ret = connect(session->sd, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (ret != 0 && errno != EINPROGRESS) {
+        modbus_master_session_close(session);
+        return false;
+    }
+
+    FD_ZERO(&wfds);
+    FD_SET(session->sd, &wfds);
+    timeout.tv_sec = session->config->timeout_ms / 1000;
+    timeout.tv_usec = (session->config->timeout_ms % 1000) * 1000;
+    if (select(session->sd + 1, NULL, &wfds, NULL, &timeout) <= 0 || getsockopt(session->sd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0 ||
+        error != 0) {
+        modbus_master_session_close(session);
+        return false;
+    }
+
+    session->rx_len = 0;
+    session->connects++;
+    return true;
+}
+
+/*
+ * Up to "pipeline" transactions are outstanding: a new request goes out as soon as a response (or a timeout) frees a
+ * slot. Responses are matched by transaction identifier, so slaves answering out of order or late are handled; late
+ * answers to expired transactions are discarded.
+ */
+static uint32_t tcp_cycle(modbus_master_session_t *session, const ladder_io_image_t *out) {
+    mm_slot_t slot[MODBUS_MASTER_PIPELINE_MAX];
+    uint8_t adu[MODBUS_ADU_MAX];
+    uint32_t next = 0, done = 0, active = 0, answered = 0;
+
+    // the module task starts with the ladder, possibly before the network is up
+    esp_netif_t *netif = esp_netif_get_default_netif();
+    if (session->sd < 0 && (netif == NULL || !esp_netif_is_netif_up(netif) || !tcp_connect(session))) {
+        for (uint32_t r = 0; r < session->poll->requests; r++)
+            request_failed(session, &session->poll->request[r]);
+        return 0;
+    }
+
+    for (uint32_t s = 0; s < session->config->pipeline; s++)
+        slot[s].request = -1;
+
+    while (done < session->poll->requests) {
+        // fill the window
+        while (next < session->poll->requests && active < session->config->pipeline) {
+            const modbus_poll_request_t *request = &session->poll->request[next];
+            uint16_t len = modbus_poll_request_pdu(session->poll, request, out, &adu[MODBUS_MBAP_LEN]);
+
+            session->tid++;
+            MODBUS_PUT16(&adu[0], session->tid);
+            MODBUS_PUT16(&adu[2], 0);
+            MODBUS_PUT16(&adu[4], len + 1);
+            adu[6] = request->slave;
+
+            if (send(session->sd, adu, MODBUS_MBAP_LEN + len, 0) != MODBUS_MBAP_LEN + len)
+                goto broken;
+
+            for (uint32_t s = 0; s < session->config->pipeline; s++) {
+                if (slot[s].request >= 0)
+                    continue;
+                slot[s].request = next;
+                slot[s].tid = session->tid;
+                slot[s].deadline = esp_timer_get_time() + (int64_t)session->config->timeout_ms * 1000;
+                break;
+            }
+            active++;
+            next++;
+        }
+
+        // expired transactions
+        int64_t now = esp_timer_get_time();
+        int64_t deadline = INT64_MAX;
+        for (uint32_t s = 0; s < session->config->pipeline; s++) {
+            if (slot[s].request < 0)
+                continue;
+            if (slot[s].deadline <= now) {
+                request_failed(session, &session->poll->request[slot[s].request]);
+                session->timeouts++;
+                slot[s].request = -1;
+                active--;
+                done++;
+            } else if (slot[s].deadline < deadline) {
+                deadline = slot[s].deadline;
+            }
+        }
+        if (active == 0)
+            continue;
+
+        struct timeval timeout = {
+            .tv_sec = (deadline - now) / 1000000,  //
+            .tv_usec = (deadline - now) % 1000000, //
+        };
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(session->sd, &rfds);
+        if (select(session->sd + 1, &rfds, NULL, NULL, &timeout) <= 0)
+            continue;
+
+        int len = recv(session->sd, session->rx + session->rx_len, sizeof(session->rx) - session->rx_len, 0);
+        if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            goto broken;
+        if (len > 0)
+            session->rx_len += len;
+
+        // complete frames
+        while (session->rx_len >= MODBUS_MBAP_LEN) {
+            uint16_t length = MODBUS_GET16(&session->rx[4]);
+            if (length < 2 || length > MODBUS_PDU_MAX + 1)
+                goto broken;
+            uint32_t adu_len = MODBUS_MBAP_LEN - 1 + length;
+            if (session->rx_len < adu_len)
+                break;
+
+            uint16_t tid = MODBUS_GET16(&session->rx[0]);
+            for (uint32_t s = 0; s < session->config->pipeline; s++) {
+                if (slot[s].request < 0 || slot[s].tid != tid)
+                    continue;
+                if (response(session, &session->poll->request[slot[s].request], &session->rx[MODBUS_MBAP_LEN], adu_len - MODBUS_MBAP_LEN))
+                    answered++;
+                slot[s].request = -1;
+                active--;
+                done++;
+                break;
+            }
+
+            session->rx_len -= adu_len;
+            memmove(session->rx, session->rx + adu_len, session->rx_len);
+        }
+    }
+
+    return answered;
+
+broken:
+    ESP_LOGW(TAG, "%s: connection lost", session->config->name);
+    for (uint32_t s = 0; s < session->config->pipeline; s++)
+        if (slot[s].request >= 0)
+            request_failed(session, &session->poll->request[slot[s].request]);
+    for (; next < session->poll->requests; next++)
+        request_failed(session, &session->poll->request[next]);
+    modbus_master_session_close(session);
+    return answered;
+}
+
+/*
+ * One transaction at a time. The response length is known from the request, so the frame end is not detected by a
+ * 3.5 characters silence: the next request only waits for what is left of the inter-frame gap after the last byte.
+ */
+static uint32_t rtu_cycle(modbus_master_session_t *session, const ladder_io_image_t *out) {
+    uint8_t adu[MODBUS_ADU_MAX];
+    uint32_t answered = 0;
+    TickType_t timeout = pdMS_TO_TICKS(session->config->timeout_ms);
+
+    for (uint32_t r = 0; r < session->poll->requests; r++) {
+        const modbus_poll_request_t *request = &session->poll->request[r];
+        uint16_t len = 1 + modbus_poll_request_pdu(session->poll, request, out, &adu[1]);
+
+        adu[0] = request->slave;
+        uint16_t crc = modbus_poll_crc16(adu, len);
+        adu[len++] = crc & 0xff;
+        adu[len++] = crc >> 8;
+
+        int64_t wait = session->bus_idle + session->t35_us - esp_timer_get_time();
+        if (wait > 0)
+            esp_rom_delay_us(wait);
+
+        uart_flush_input(session->config->uart);
+        uart_write_bytes(session->config->uart, adu, len);
+        uart_wait_tx_done(session->config->uart, timeout);
+        session->bus_idle = esp_timer_get_time();
+
+        // broadcast: no answer
+        if (request->slave == 0) {
+            response(session, request, NULL, 0);
+            continue;
+        }
+
+        len = MODBUS_MASTER_RTU_HEADER;
+        if (uart_read_bytes(session->config->uart, adu, len, timeout) != len) {
+            request_failed(session, request);
+            session->timeouts++;
+            continue;
+        }
+        uint16_t rest = (adu[1] & MODBUS_FC_EXCEPTION) ? 3 : modbus_poll_response_len(request) + 1 - len + 2;
+        if (uart_read_bytes(session->config->uart, adu + len, rest, timeout) != rest) {
+            request_failed(session, request);
+            session->timeouts++;
+            continue;
+        }
+        len += rest;
+        session->bus_idle = esp_timer_get_time();
+
+        if (adu[0] != request->slave || modbus_poll_crc16(adu, len - 2) != (adu[len - 2] | (adu[len - 1] << 8))) {
+            request_failed(session, request);
+            continue;
+        }
+
+        if (response(session, request, &adu[1], len - 3))
+            answered++;
+    }
+
+    return answered;
+}
+
+void modbus_master_session_init(modbus_master_session_t *session, const modbus_master_config_t *config, const modbus_poll_t *poll, uint8_t *bits,
+                                int32_t *words) {
+    memset(session, 0, sizeof(modbus_master_session_t));
+    session->config = config;
+    session->poll = poll;
+    session->bits = bits;
+    session->words = words;
+    session->sd = -1;
+
+    // 3.5 characters, fixed at 1750 us above 19200 baud
+    if (config->link == MODBUS_MASTER_RTU && config->baud > 0)
+        session->t35_us = config->baud > 19200 ? 1750 : (uint32_t)(3.5 * 11 * 1000000 / config->baud);
+    session->bus_idle = esp_timer_get_time();
+}
+
+uint32_t modbus_master_session_cycle(modbus_master_session_t *session, const ladder_io_image_t *out) {
+    return session->config->link == MODBUS_MASTER_RTU ? rtu_cycle(session, out) : tcp_cycle(session, out);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_MASTER_SESSION_H_
+#define MODBUS_MASTER_SESSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder_io_exchange.h"
+#include "modbus.h"
+#include "modbus_poll.h"
+
+#define MODBUS_MASTER_PIPELINE_MAX 8   // outstanding TCP transactions
+#define MODBUS_MASTER_TIMEOUT_MS   200 // default response timeout
+
+/**
+ * @enum modbus_master_link_t
+ * @brief Link to the slaves
+ *
+ */
+typedef enum MODBUS_MASTER_LINK {
+    MODBUS_MASTER_TCP, // Modbus TCP, transactions pipelined
+    MODBUS_MASTER_RTU, // serial line, one transaction at a time
+} modbus_master_link_t;
+
+/**
+ * @struct modbus_master_config_s
+ * @brief Remote module
+ *
+ */
+typedef struct modbus_master_config_s {
+    char name[16];                                        //
+    uint8_t link;                                         // modbus_master_link_t
+    char host[64];                                        // TCP: name or address
+    uint16_t port;                                        // TCP
+    uint8_t uart;                                         // RTU: port number
+    uint32_t baud;                                        // RTU
+    uint8_t parity;                                       // RTU: 'N', 'E' or 'O'
+    int8_t tx;                                            // RTU: pins, -1: unchanged
+    int8_t rx;                                            //
+    int8_t de;                                            // RTU: RS-485 driver enable, -1: none
+    uint32_t period_ms;                                   // polling period
+    uint32_t timeout_ms;                                  // response timeout
+    uint32_t stale_ms;                                    // points older than this are stale, 0: module default
+    bool stale_clear;                                     // stale points read as 0
+    uint8_t pipeline;                                     // TCP: outstanding transactions
+    uint32_t points;                                      //
+    modbus_master_point_t point[MODBUS_MASTER_POINTS_MAX]; //
+} modbus_master_config_t;
+
+/**
+ * @struct modbus_master_session_s
+ * @brief Link state of a module: the TCP connection or the serial line, the transactions and the result of each point
+ *
+ */
+typedef struct modbus_master_session_s {
+    const modbus_master_config_t *config;              // pipeline and timeout already set
+    const modbus_poll_t *poll;                         //
+    uint8_t *bits;                                     // inputs as last read
+    int32_t *words;                                    //
+    uint32_t point_ok_ms[MODBUS_MASTER_POINTS_MAX];    // last good exchange, 0: never
+    uint32_t point_errors[MODBUS_MASTER_POINTS_MAX];   //
+    uint8_t point_exception[MODBUS_MASTER_POINTS_MAX]; //
+    int sd;                                            // TCP socket, -1: closed
+    uint16_t tid;                                      // last transaction identifier
+    uint8_t rx[MODBUS_ADU_MAX * 2];                    // TCP stream
+    uint32_t rx_len;                                   //
+    int64_t bus_idle;                                  // RTU: end of the last frame on the line
+    uint32_t t35_us;                                   // RTU: inter-frame gap
+    uint32_t transactions;                             //
+    uint32_t timeouts;                                 //
+    uint32_t exceptions;                               //
+    uint32_t connects;                                 //
+} modbus_master_session_t;
+
+/**
+ * @fn void modbus_master_session_init(modbus_master_session_t*, const modbus_master_config_t*, const modbus_poll_t*, uint8_t*, int32_t*)
+ * @brief Closed session, no point exchanged yet. The RTU inter-frame gap is set from the baud rate.
+ *
+ * @param session Session
+ * @param config Module configuration, kept by reference
+ * @param poll Requests, kept by reference
+ * @param bits I points of the module
+ * @param words IW points of the module
+ */
+void modbus_master_session_init(modbus_master_session_t *session, const modbus_master_config_t *config, const modbus_poll_t *poll, uint8_t *bits,
+                                int32_t *words);
+
+/**
+ * @fn uint32_t modbus_master_session_cycle(modbus_master_session_t*, const ladder_io_image_t*)
+ * @brief Every request once: TCP transactions pipelined, connecting first if needed; RTU ones on the UART in turn
+ *
+ * @param session Session
+ * @param out Output image
+ * @return Requests answered, exceptions included
+ */
+uint32_t modbus_master_session_cycle(modbus_master_session_t *session, const ladder_io_image_t *out);
+
+/**
+ * @fn void modbus_master_session_close(modbus_master_session_t*)
+ * @brief Close the TCP connection, the next cycle opens a new one
+ *
+ * @param session Session
+ */
+void modbus_master_session_close(modbus_master_session_t *session);
+
+#endif /* MODBUS_MASTER_SESSION_H_ */
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "modbus.h"
+#include "modbus_pdu.h"
+
+uint32_t modbus_pdu_map_span(modbus_table_t table, const modbus_map_t *map) {
+    return (table == MODBUS_TABLE_COILS || table == MODBUS_TABLE_DISCRETE) ? map->qty : (uint32_t)map->qty * map->words;
+}
+
+static const modbus_map_t *map_find(const modbus_server_config_t *config, modbus_table_t table, uint32_t addr) {
+    for (uint32_t n = 0; n < config->maps[table]; n++) {
+        const modbus_map_t *map = &config->map[table][n];
+        if (addr >= map->addr && addr < map->addr + modbus_pdu_map_span(table, map))
+            return map;
+    }
+
+    return NULL;
+}
+
+typedef enum MB_OP {
+    MB_OP_CHECK_READ,  //
+    MB_OP_CHECK_WRITE, //
+    MB_OP_READ,        // into "data"
+    MB_OP_WRITE,       // from "data"
+} mb_op_t;
+
+/*
+ * Walk the entries covering [addr, addr + qty) one contiguous slice at a time. Bits are packed LSB first as in the
+ * Modbus frames, registers are big endian.
+ */
+static modbus_exception_t mb_access(const modbus_server_config_t *config, modbus_region_fn region_get, modbus_table_t table, mb_op_t op, uint32_t addr,
+                                    uint32_t qty, uint8_t *data) {
+    uint32_t done = 0;
+    modbus_region_t region;
+
+    while (done < qty) {
+        const modbus_map_t *map = map_find(config, table, addr + done);
+        if (map == NULL || !region_get(map, &region))
+            return MODBUS_EX_ILLEGAL_ADDRESS;
+        if ((op == MB_OP_CHECK_WRITE || op == MB_OP_WRITE) && !region.writable)
+            return MODBUS_EX_ILLEGAL_ADDRESS;
+
+        uint32_t offset = addr + done - map->addr;
+        uint32_t slice = modbus_pdu_map_span(table, map) - offset;
+        if (slice > qty - done)
+            slice = qty - done;
+
+        if (op == MB_OP_READ || op == MB_OP_WRITE) {
+            for (uint32_t k = 0; k < slice; k++) {
+                uint32_t out = done + k;
+
+                if (region.bits) {
+                    uint8_t *reg = region.base + (offset + k) * region.stride;
+                    if (op == MB_OP_READ) {
+                        if (*reg)
+                            data[out / 8] |= 1 << (out % 8);
+                    } else {
+                        *reg = (data[out / 8] >> (out % 8)) & 1;
+                    }
+                    continue;
+                }
+
+                uint32_t value_index = (offset + k) / map->words;
+                uint32_t part = (offset + k) % map->words;
+                uint8_t *reg = region.base + value_index * region.stride;
+                uint32_t value;
+
+                memcpy(&value, reg, sizeof(value));
+                if (op == MB_OP_READ) {
+                    uint16_t word = (map->words == 2 && part == 0) ? value >> 16 : value & 0xffff;
+                    MODBUS_PUT16(&data[out * 2], word);
+                    continue;
+                }
+
+                uint16_t word = MODBUS_GET16(&data[out * 2]);
+                if (map->words == 1)
+                    value = region.sign ? (uint32_t)(int32_t)(int16_t)word : word;
+                else if (part == 0)
+                    value = (value & 0x0000ffff) | ((uint32_t)word << 16);
+                else
+                    value = (value & 0xffff0000) | word;
+                memcpy(reg, &value, sizeof(value));
+            }
+        }
+
+        done += slice;
+    }
+
+    return MODBUS_EX_NONE;
+}
+
+uint16_t modbus_pdu_serve(const modbus_server_config_t *config, modbus_region_fn region, const uint8_t *req, uint16_t req_len, uint8_t *resp) {
+    uint8_t function = req[0];
+    modbus_exception_t ex = MODBUS_EX_ILLEGAL_VALUE;
+    modbus_table_t table;
+    uint16_t addr, qty, len = 0;
+
+    if (req_len < 5)
+        goto exception;
+
+    addr = MODBUS_GET16(&req[1]);
+    qty = MODBUS_GET16(&req[3]);
+    resp[0] = function;
+
+    switch (function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE:
+            table = function == MODBUS_FC_READ_COILS ? MODBUS_TABLE_COILS : MODBUS_TABLE_DISCRETE;
+            if (qty == 0 || qty > MODBUS_READ_BITS_MAX)
+                goto exception;
+            resp[1] = (qty + 7) / 8;
+            memset(&resp[2], 0, resp[1]);
+            if ((ex = mb_access(config, region, table, MB_OP_READ, addr, qty, &resp[2])) != MODBUS_EX_NONE)
+                goto exception;
+            len = 2 + resp[1];
+            break;
+
+        case MODBUS_FC_READ_HOLDING:
+        case MODBUS_FC_READ_INPUT:
+            table = function == MODBUS_FC_READ_HOLDING ? MODBUS_TABLE_HOLDING : MODBUS_TABLE_INPUT;
+            if (qty == 0 || qty > MODBUS_READ_REGS_MAX)
+                goto exception;
+            resp[1] = qty * 2;
+            if ((ex = mb_access(config, region, table, MB_OP_READ, addr, qty, &resp[2])) != MODBUS_EX_NONE)
+                goto exception;
+            len = 2 + resp[1];
+            break;
+
+        case MODBUS_FC_WRITE_COIL: {
+            uint8_t bit = qty == 0xff00;
+            if (qty != 0xff00 && qty != 0x0000)
+                goto exception;
+            if ((ex = mb_access(config, region, MODBUS_TABLE_COILS, MB_OP_CHECK_WRITE, addr, 1, NULL)) != MODBUS_EX_NONE)
+                goto exception;
+            mb_access(config, region, MODBUS_TABLE_COILS, MB_OP_WRITE, addr, 1, &bit);
+            memcpy(&resp[1], &req[1], 4);
+            len = 5;
+            break;
+        }
+
+        case MODBUS_FC_WRITE_REGISTER:
+            if ((ex = mb_access(config, region, MODBUS_TABLE_HOLDING, MB_OP_CHECK_WRITE, addr, 1, NULL)) != MODBUS_EX_NONE)
+                goto exception;
+            mb_access(config, region, MODBUS_TABLE_HOLDING, MB_OP_WRITE, addr, 1, (uint8_t *)&req[3]);
+            memcpy(&resp[1], &req[1], 4);
+            len = 5;
+            break;
+
+        case MODBUS_FC_WRITE_COILS:
+        case MODBUS_FC_WRITE_REGISTERS:
+            table = function == MODBUS_FC_WRITE_COILS ? MODBUS_TABLE_COILS : MODBUS_TABLE_HOLDING;
+            if (req_len < 6 || qty == 0 || qty > (function == MODBUS_FC_WRITE_COILS ? MODBUS_WRITE_BITS_MAX : MODBUS_WRITE_REGS_MAX))
+                goto exception;
+            if (req[5] != (function == MODBUS_FC_WRITE_COILS ? (qty + 7) / 8 : qty * 2) || req_len < 6 + req[5])
+                goto exception;
+            // all or nothing
+            if ((ex = mb_access(config, region, table, MB_OP_CHECK_WRITE, addr, qty, NULL)) != MODBUS_EX_NONE)
+                goto exception;
+            mb_access(config, region, table, MB_OP_WRITE, addr, qty, (uint8_t *)&req[6]);
+            memcpy(&resp[1], &req[1], 4);
+            len = 5;
+            break;
+
+        default:
+            ex = MODBUS_EX_ILLEGAL_FUNCTION;
+            goto exception;
+    }
+
+    return len;
+
+exception:
+    resp[0] = function | MODBUS_FC_EXCEPTION;
+    resp[1] = ex;
+    return 2;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_PDU_H_
+#define MODBUS_PDU_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modbus.h"
+
+#define MODBUS_SERVER_MAP_MAX 16 // map entries per table
+
+/**
+ * @enum modbus_table_t
+ * @brief Modbus data tables
+ *
+ */
+typedef enum MODBUS_TABLE {
+    MODBUS_TABLE_COILS,    // Q, M
+    MODBUS_TABLE_DISCRETE, // I, Q, M, Cd, Cr, Td, Tr
+    MODBUS_TABLE_INPUT,    // IW, QW, C, D, T, R
+    MODBUS_TABLE_HOLDING,  // QW, C, D, T, R
+    MODBUS_TABLES,         //
+} modbus_table_t;
+
+/**
+ * @struct modbus_map_s
+ * @brief Address map entry: "qty" ladder registers from "index" on, at Modbus address "addr"
+ *
+ */
+typedef struct modbus_map_s {
+    uint16_t addr;  // first Modbus address
+    uint16_t qty;   // ladder registers
+    uint16_t index; // first ladder register
+    uint8_t type;   // ladder_register_t
+    uint8_t module; // I, Q, IW, QW only
+    uint8_t words;  // registers tables: 2 (32 bits, high word first) or 1 (low 16 bits, sign extended on write for D/IW/QW)
+} modbus_map_t;
+
+/**
+ * @struct modbus_server_config_s
+ * @brief Server configuration
+ *
+ */
+typedef struct modbus_server_config_s {
+    uint16_t port;                                            //
+    uint8_t unit;                                             // unit identifier answered, 0: any
+    uint8_t maps[MODBUS_TABLES];                              // entries per table
+    modbus_map_t map[MODBUS_TABLES][MODBUS_SERVER_MAP_MAX];   //
+} modbus_server_config_t;
+
+/**
+ * @struct modbus_region_s
+ * @brief Registers behind a map entry
+ *
+ */
+typedef struct modbus_region_s {
+    uint8_t *base;   // first register of the entry
+    uint32_t stride; // bytes between registers
+    bool bits;       // uint8/bool, else 32 bits
+    bool writable;   //
+    bool sign;       // 16 bit writes are sign extended
+} modbus_region_t;
+
+/**
+ * @brief Resolve the registers of a map entry, false if they are not available
+ *
+ */
+typedef bool (*modbus_region_fn)(const modbus_map_t *map, modbus_region_t *region);
+
+/**
+ * @fn uint32_t modbus_pdu_map_span(modbus_table_t, const modbus_map_t*)
+ * @brief Modbus addresses taken by a map entry
+ *
+ * @param table Table
+ * @param map Entry
+ * @return Addresses
+ */
+uint32_t modbus_pdu_map_span(modbus_table_t table, const modbus_map_t *map);
+
+/**
+ * @fn uint16_t modbus_pdu_serve(const modbus_server_config_t*, modbus_region_fn, const uint8_t*, uint16_t, uint8_t*)
+ * @brief Answer a request PDU through the address map. Bits are packed LSB first, registers are big endian, 32 bit
+ *        values are sent high word first. Writes are all or nothing.
+ *
+ * @param config Address map
+ * @param region Entry registers, called for every entry a request touches
+ * @param req Request PDU
+ * @param req_len Request length
+ * @param resp Response PDU, MODBUS_PDU_MAX bytes. An exception response has MODBUS_FC_EXCEPTION set in resp[0].
+ * @return Response length
+ */
+uint16_t modbus_pdu_serve(const modbus_server_config_t *config, modbus_region_fn region, const uint8_t *req, uint16_t req_len, uint8_t *resp);
+
+#endif /* MODBUS_PDU_H_ */
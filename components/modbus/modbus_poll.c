@@ -0,0 +1,212 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ladder_io_exchange.h"
+#include "modbus.h"
+#include "modbus_poll.h"
+
+// single and multiple writes of the same table merge together
+static uint8_t function_class(uint8_t function) {
+    switch (function) {
+        case MODBUS_FC_WRITE_COIL:
+            return MODBUS_FC_WRITE_COILS;
+        case MODBUS_FC_WRITE_REGISTER:
+            return MODBUS_FC_WRITE_REGISTERS;
+        default:
+            return function;
+    }
+}
+
+static int point_compare(const modbus_master_point_t *pa, const modbus_master_point_t *pb) {
+    if (pa->slave != pb->slave)
+        return pa->slave - pb->slave;
+    if (function_class(pa->function) != function_class(pb->function))
+        return function_class(pa->function) - function_class(pb->function);
+    return pa->addr - pb->addr;
+}
+
+uint32_t modbus_poll_function_max(uint8_t function) {
+    switch (function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE:
+            return MODBUS_READ_BITS_MAX;
+        case MODBUS_FC_READ_HOLDING:
+        case MODBUS_FC_READ_INPUT:
+            return MODBUS_READ_REGS_MAX;
+        case MODBUS_FC_WRITE_COILS:
+            return MODBUS_WRITE_BITS_MAX;
+        case MODBUS_FC_WRITE_REGISTERS:
+            return MODBUS_WRITE_REGS_MAX;
+        default:
+            return 1;
+    }
+}
+
+void modbus_poll_build(modbus_poll_t *poll, const modbus_master_point_t *point, uint32_t points) {
+    poll->point = point;
+    poll->points = points;
+
+    // stable insertion sort, a handful of entries
+    for (uint32_t n = 0; n < points; n++) {
+        uint32_t k = n;
+
+        for (; k > 0 && point_compare(&point[poll->order[k - 1]], &point[n]) > 0; k--)
+            poll->order[k] = poll->order[k - 1];
+        poll->order[k] = n;
+    }
+
+    poll->requests = 0;
+    for (uint32_t n = 0; n < points; n++) {
+        const modbus_master_point_t *entry = &point[poll->order[n]];
+        modbus_poll_request_t *last = poll->requests > 0 ? &poll->request[poll->requests - 1] : NULL;
+
+        if (last != NULL && last->slave == entry->slave && function_class(last->function) == function_class(entry->function) &&
+            entry->addr == last->addr + last->count && last->count + entry->count <= modbus_poll_function_max(function_class(entry->function))) {
+            last->function = function_class(entry->function);
+            last->count += entry->count;
+            last->points++;
+        } else {
+            last = &poll->request[poll->requests++];
+            last->slave = entry->slave;
+            last->function = entry->function;
+            last->addr = entry->addr;
+            last->count = entry->count;
+            last->first = n;
+            last->points = 1;
+        }
+
+        poll->point_request[poll->order[n]] = poll->requests - 1;
+    }
+}
+
+uint16_t modbus_poll_request_pdu(const modbus_poll_t *poll, const modbus_poll_request_t *request, const ladder_io_image_t *out, uint8_t *pdu) {
+    const modbus_master_point_t *point = &poll->point[modbus_poll_entry(poll, request, 0)];
+
+    pdu[0] = request->function;
+    MODBUS_PUT16(&pdu[1], request->addr);
+
+    switch (request->function) {
+        case MODBUS_FC_WRITE_COIL:
+            MODBUS_PUT16(&pdu[3], out->bits[point->index] ? 0xff00 : 0x0000);
+            return 5;
+
+        case MODBUS_FC_WRITE_REGISTER:
+            MODBUS_PUT16(&pdu[3], (uint16_t)out->words[point->index]);
+            return 5;
+
+        case MODBUS_FC_WRITE_COILS:
+            MODBUS_PUT16(&pdu[3], request->count);
+            pdu[5] = (request->count + 7) / 8;
+            memset(&pdu[6], 0, pdu[5]);
+            for (uint32_t p = 0; p < request->points; p++) {
+                point = &poll->point[modbus_poll_entry(poll, request, p)];
+                uint32_t offset = point->addr - request->addr;
+                for (uint32_t k = 0; k < point->count; k++)
+                    if (out->bits[point->index + k])
+                        pdu[6 + (offset + k) / 8] |= 1 << ((offset + k) % 8);
+            }
+            return 6 + pdu[5];
+
+        case MODBUS_FC_WRITE_REGISTERS:
+            MODBUS_PUT16(&pdu[3], request->count);
+            pdu[5] = request->count * 2;
+            for (uint32_t p = 0; p < request->points; p++) {
+                point = &poll->point[modbus_poll_entry(poll, request, p)];
+                uint32_t offset = point->addr - request->addr;
+                for (uint32_t k = 0; k < point->count; k++)
+                    MODBUS_PUT16(&pdu[6 + (offset + k) * 2], (uint16_t)out->words[point->index + k]);
+            }
+            return 6 + pdu[5];
+
+        default:
+            MODBUS_PUT16(&pdu[3], request->count);
+            return 5;
+    }
+}
+
+uint16_t modbus_poll_response_len(const modbus_poll_request_t *request) {
+    switch (request->function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE:
+            return 2 + (request->count + 7) / 8;
+        case MODBUS_FC_READ_HOLDING:
+        case MODBUS_FC_READ_INPUT:
+            return 2 + request->count * 2;
+        default:
+            return 5;
+    }
+}
+
+modbus_poll_response_t modbus_poll_response(const modbus_poll_t *poll, const modbus_poll_request_t *request, const uint8_t *pdu, uint16_t len, uint8_t *bits,
+                                            int32_t *words) {
+    if (len >= 2 && pdu[0] == (request->function | MODBUS_FC_EXCEPTION))
+        return MODBUS_POLL_EXCEPTION;
+
+    if (pdu[0] != request->function || len < modbus_poll_response_len(request) ||
+        ((request->function <= MODBUS_FC_READ_INPUT) && pdu[1] != modbus_poll_response_len(request) - 2))
+        return MODBUS_POLL_INVALID;
+
+    for (uint32_t p = 0; p < request->points; p++) {
+        const modbus_master_point_t *point = &poll->point[modbus_poll_entry(poll, request, p)];
+        uint32_t offset = point->addr - request->addr;
+
+        switch (point->function) {
+            case MODBUS_FC_READ_COILS:
+            case MODBUS_FC_READ_DISCRETE:
+                for (uint32_t k = 0; k < point->count; k++)
+                    bits[point->index + k] = (pdu[2 + (offset + k) / 8] >> ((offset + k) % 8)) & 1;
+                break;
+            case MODBUS_FC_READ_HOLDING:
+            case MODBUS_FC_READ_INPUT:
+                for (uint32_t k = 0; k < point->count; k++) {
+                    uint16_t word = MODBUS_GET16(&pdu[2 + (offset + k) * 2]);
+                    words[point->index + k] = point->sign ? (int16_t)word : (int32_t)word;
+                }
+                break;
+        }
+    }
+
+    return MODBUS_POLL_DATA;
+}
+
+uint16_t modbus_poll_crc16(const uint8_t *data, uint32_t len) {
+    uint16_t crc = 0xffff;
+
+    for (uint32_t n = 0; n < len; n++) {
+        crc ^= data[n];
+        for (uint32_t b = 0; b < 8; b++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : crc >> 1;
+    }
+
+    return crc;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_POLL_H_
+#define MODBUS_POLL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder_io_exchange.h"
+#include "modbus.h"
+
+#define MODBUS_MASTER_POINTS_MAX 32 // poll table entries per module
+
+/**
+ * @struct modbus_master_point_s
+ * @brief Poll table entry: "count" Modbus bits or registers from "addr" on, at module point "index" on
+ *
+ */
+typedef struct modbus_master_point_s {
+    uint8_t slave;    // unit identifier
+    uint8_t function; // FC 1/2 into I, 3/4 into IW, 5/15 from Q, 6/16 from QW
+    uint16_t addr;    // first Modbus address
+    uint16_t count;   // bits or registers
+    uint8_t type;     // LADDER_REGISTER_I, IW, Q or QW
+    uint16_t index;   // first point of the module image
+    bool sign;        // IW: registers are signed
+} modbus_master_point_t;
+
+/**
+ * @struct modbus_poll_request_s
+ * @brief Merged request: a run of consecutive entries of the sorted order
+ *
+ */
+typedef struct modbus_poll_request_s {
+    uint8_t slave;    //
+    uint8_t function; //
+    uint16_t addr;    //
+    uint16_t count;   //
+    uint16_t first;   // first entry, position in the sorted order
+    uint16_t points;  // entries
+} modbus_poll_request_t;
+
+/**
+ * @struct modbus_poll_s
+ * @brief Poll table merged into requests. The table keeps its configured order (the point numbers shown), requests are
+ *        merged over a sorted index.
+ *
+ */
+typedef struct modbus_poll_s {
+    const modbus_master_point_t *point;                      // entries as configured
+    uint32_t points;                                         //
+    uint8_t order[MODBUS_MASTER_POINTS_MAX];                 // entries sorted by slave, function, address
+    modbus_poll_request_t request[MODBUS_MASTER_POINTS_MAX]; //
+    uint32_t requests;                                       //
+    uint16_t point_request[MODBUS_MASTER_POINTS_MAX];        // request serving each entry
+} modbus_poll_t;
+
+/**
+ * @enum modbus_poll_response_t
+ * @brief Response check result
+ *
+ */
+typedef enum MODBUS_POLL_RESPONSE {
+    MODBUS_POLL_INVALID,   // not a response to the request
+    MODBUS_POLL_DATA,      // inputs stored, or write acknowledged
+    MODBUS_POLL_EXCEPTION, // exception code in pdu[1]
+} modbus_poll_response_t;
+
+/**
+ * @fn uint32_t modbus_poll_function_max(uint8_t)
+ * @brief Largest count of a function
+ *
+ * @param function Function code
+ * @return Bits or registers, 1 for single writes
+ */
+uint32_t modbus_poll_function_max(uint8_t function);
+
+/**
+ * @fn void modbus_poll_build(modbus_poll_t*, const modbus_master_point_t*, uint32_t)
+ * @brief Merge entries of the same slave and function with adjacent addresses into one request. Single and multiple
+ *        writes of the same table merge into a multiple write.
+ *
+ * @param poll Poll table
+ * @param point Entries, kept by reference
+ * @param points Entries quantity, up to MODBUS_MASTER_POINTS_MAX
+ */
+void modbus_poll_build(modbus_poll_t *poll, const modbus_master_point_t *point, uint32_t points);
+
+/**
+ * @fn uint32_t modbus_poll_entry(const modbus_poll_t*, const modbus_poll_request_t*, uint32_t)
+ * @brief Entry "p" of a request
+ *
+ * @param poll Poll table
+ * @param request Request
+ * @param p Entry of the request, below request->points
+ * @return Entry number, in the configured order
+ */
+static inline uint32_t modbus_poll_entry(const modbus_poll_t *poll, const modbus_poll_request_t *request, uint32_t p) {
+    return poll->order[request->first + p];
+}
+
+/**
+ * @fn uint16_t modbus_poll_request_pdu(const modbus_poll_t*, const modbus_poll_request_t*, const ladder_io_image_t*, uint8_t*)
+ * @brief Request PDU, outputs taken from "out"
+ *
+ * @param poll Poll table
+ * @param request Request
+ * @param out Output image
+ * @param pdu PDU, MODBUS_PDU_MAX bytes
+ * @return PDU length
+ */
+uint16_t modbus_poll_request_pdu(const modbus_poll_t *poll, const modbus_poll_request_t *request, const ladder_io_image_t *out, uint8_t *pdu);
+
+/**
+ * @fn uint16_t modbus_poll_response_len(const modbus_poll_request_t*)
+ * @brief Expected response PDU length
+ *
+ * @param request Request
+ * @return Length
+ */
+uint16_t modbus_poll_response_len(const modbus_poll_request_t *request);
+
+/**
+ * @fn modbus_poll_response_t modbus_poll_response(const modbus_poll_t*, const modbus_poll_request_t*, const uint8_t*, uint16_t, uint8_t*, int32_t*)
+ * @brief Check a response PDU and store the inputs it carries
+ *
+ * @param poll Poll table
+ * @param request Request
+ * @param pdu Response PDU
+ * @param len PDU length
+ * @param bits I points of the module
+ * @param words IW points of the module
+ * @return Result
+ */
+modbus_poll_response_t modbus_poll_response(const modbus_poll_t *poll, const modbus_poll_request_t *request, const uint8_t *pdu, uint16_t len, uint8_t *bits,
+                                            int32_t *words);
+
+/**
+ * @fn uint16_t modbus_poll_crc16(const uint8_t*, uint32_t)
+ * @brief RTU frame CRC, sent low byte first
+ *
+ * @param data Frame
+ * @param len Length
+ * @return CRC
+ */
+uint16_t modbus_poll_crc16(const uint8_t *data, uint32_t len);
+
+#endif /* MODBUS_POLL_H_ */
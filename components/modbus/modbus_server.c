@@ -0,0 +1,402 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+
+#include "ladder.h"
+#include "ladder_aout.h"
+#include "ladder_hsc.h"
+#include "ladder_registers.h"
+#include "ladderlib_esp32_gpio.h"
+#include "ladderlib_esp32_std.h"
+#include "modbus.h"
+#include "modbus_server.h"
+#include "modbus_server_session.h"
+
+static const char *TAG = "modbus_server";
+
+#define MODBUS_SERVER_TASK_STACK 4096 //
+#define MODBUS_SERVER_TASK_PRIO  5    // below the ladder task
+
+static const char *table_names[MODBUS_TABLES] = {
+    "coils",    //
+    "discrete", //
+    "input",    //
+    "holding",  //
+};
+
+static ladder_ctx_t *mb_ctx = NULL;
+static modbus_server_config_t mb_config;
+static modbus_server_session_t mb_session;
+static TaskHandle_t mb_task = NULL;
+
+static bool type_is_bit(uint8_t type) {
+    switch (type) {
+        case LADDER_REGISTER_Q:
+        case LADDER_REGISTER_I:
+        case LADDER_REGISTER_M:
+        case LADDER_REGISTER_Cd:
+        case LADDER_REGISTER_Cr:
+        case LADDER_REGISTER_Td:
+        case LADDER_REGISTER_Tr:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// types allowed in each table
+static bool map_type_valid(modbus_table_t table, const modbus_map_t *map) {
+    switch (table) {
+        case MODBUS_TABLE_COILS:
+            return map->type == LADDER_REGISTER_Q || map->type == LADDER_REGISTER_M;
+        case MODBUS_TABLE_DISCRETE:
+            return type_is_bit(map->type);
+        case MODBUS_TABLE_INPUT:
+        case MODBUS_TABLE_HOLDING:
+            if (map->words != 1 && map->words != 2)
+                return false;
+            if (map->type == LADDER_REGISTER_R && map->words != 2)
+                return false;
+            if (map->type == LADDER_REGISTER_IW)
+                return table == MODBUS_TABLE_INPUT;
+            return map->type == LADDER_REGISTER_QW || map->type == LADDER_REGISTER_C || map->type == LADDER_REGISTER_D ||
+                   map->type == LADDER_REGISTER_T || map->type == LADDER_REGISTER_R;
+        default:
+            return false;
+    }
+}
+
+static bool config_valid(const modbus_server_config_t *config) {
+    for (uint32_t t = 0; t < MODBUS_TABLES; t++) {
+        if (config->maps[t] > MODBUS_SERVER_MAP_MAX)
+            return false;
+
+        for (uint32_t n = 0; n < config->maps[t]; n++) {
+            const modbus_map_t *map = &config->map[t][n];
+            uint32_t end = map->addr + modbus_pdu_map_span(t, map);
+
+            if (map->qty == 0 || end > 0x10000 || !map_type_valid(t, map)) {
+                ESP_LOGE(TAG, "ERROR %s entry %" PRIu32, table_names[t], n);
+                return false;
+            }
+
+            for (uint32_t o = 0; o < n; o++) {
+                const modbus_map_t *other = &config->map[t][o];
+                if (map->addr < other->addr + modbus_pdu_map_span(t, other) && other->addr < end) {
+                    ESP_LOGE(TAG, "ERROR %s entries %" PRIu32 " and %" PRIu32 " overlap", table_names[t], o, n);
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// resolved at every request: I/Q images come and go with the ladder task
+static bool region_get(const modbus_map_t *map, modbus_region_t *region) {
+    ladder_ctx_t *ladder_ctx = mb_ctx;
+    uint32_t available = 0;
+
+    memset(region, 0, sizeof(modbus_region_t));
+    region->bits = type_is_bit(map->type);
+    region->stride = region->bits ? sizeof(uint8_t) : sizeof(uint32_t);
+
+    switch (map->type) {
+        case LADDER_REGISTER_Q:
+        case LADDER_REGISTER_QW:
+            if (map->module >= (*ladder_ctx).hw.io.fn_write_qty)
+                return false;
+            if (map->type == LADDER_REGISTER_Q) {
+                region->base = (*ladder_ctx).output[map->module].Q;
+                available = (*ladder_ctx).output[map->module].q_qty;
+            } else {
+                region->base = (uint8_t *)(*ladder_ctx).output[map->module].QW;
+                available = (*ladder_ctx).output[map->module].qw_qty;
+                region->sign = true;
+            }
+            region->writable = true;
+            break;
+        case LADDER_REGISTER_I:
+        case LADDER_REGISTER_IW:
+            if (map->module >= (*ladder_ctx).hw.io.fn_read_qty)
+                return false;
+            if (map->type == LADDER_REGISTER_I) {
+                region->base = (*ladder_ctx).input[map->module].I;
+                available = (*ladder_ctx).input[map->module].i_qty;
+            } else {
+                region->base = (uint8_t *)(*ladder_ctx).input[map->module].IW;
+                available = (*ladder_ctx).input[map->module].iw_qty;
+                region->sign = true;
+            }
+            break;
+        case LADDER_REGISTER_M:
+            region->base = (*ladder_ctx).memory.M;
+            available = (*ladder_ctx).ladder.quantity.m;
+            region->writable = true;
+            break;
+        case LADDER_REGISTER_Cd:
+            region->base = (uint8_t *)(*ladder_ctx).memory.Cd;
+            available = (*ladder_ctx).ladder.quantity.c;
+            break;
+        case LADDER_REGISTER_Cr:
+            region->base = (uint8_t *)(*ladder_ctx).memory.Cr;
+            available = (*ladder_ctx).ladder.quantity.c;
+            break;
+        case LADDER_REGISTER_Td:
+            region->base = (uint8_t *)(*ladder_ctx).memory.Td;
+            available = (*ladder_ctx).ladder.quantity.t;
+            break;
+        case LADDER_REGISTER_Tr:
+            region->base = (uint8_t *)(*ladder_ctx).memory.Tr;
+            available = (*ladder_ctx).ladder.quantity.t;
+            break;
+        case LADDER_REGISTER_C:
+            region->base = (uint8_t *)(*ladder_ctx).registers.C;
+            available = (*ladder_ctx).ladder.quantity.c;
+            region->writable = true;
+            break;
+        case LADDER_REGISTER_D:
+            region->base = (uint8_t *)(*ladder_ctx).registers.D;
+            available = (*ladder_ctx).ladder.quantity.d;
+            region->writable = true;
+            region->sign = true;
+            break;
+        case LADDER_REGISTER_T:
+            region->base = (uint8_t *)&(*ladder_ctx).timers[0].acc;
+            region->stride = sizeof(ladder_timer_t);
+            available = (*ladder_ctx).ladder.quantity.t;
+            region->writable = true;
+            break;
+        case LADDER_REGISTER_R:
+            region->base = (uint8_t *)(*ladder_ctx).registers.R;
+            available = (*ladder_ctx).ladder.quantity.r;
+            region->writable = true;
+            break;
+        default:
+            return false;
+    }
+
+    if (region->base == NULL || (uint32_t)map->index + map->qty > available)
+        return false;
+
+    region->base += map->index * region->stride;
+    return true;
+}
+
+// scan boundary job: every pending request of every client
+static void mb_batch(ladder_ctx_t *ladder_ctx, void *arg) {
+    modbus_server_session_serve(&mb_session);
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+static void mb_server_task(void *arg) {
+    while (!modbus_server_session_listen(&mb_session)) {
+        ESP_LOGW(TAG, "can't listen on port %u, retrying", mb_config.port);
+        vTaskDelay(pdMS_TO_TICKS(5000));
+    }
+    ESP_LOGI(TAG, "listening on port %u", mb_config.port);
+
+    while (1) {
+        if (!modbus_server_session_receive(&mb_session, 1000))
+            continue;
+
+        // one job for every client, at the next scan boundary (now if the ladder is stopped)
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (!esp32_scan_sync_post(mb_ctx, mb_batch, xTaskGetCurrentTaskHandle()))
+            continue;
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MODBUS_SERVER_SYNC_MS)) == 0)
+            ESP_LOGW(TAG, "waiting for the scan boundary");
+
+        modbus_server_session_send(&mb_session);
+    }
+}
+
+void modbus_server_default(ladder_ctx_t *ladder_ctx, modbus_server_config_t *config) {
+    const struct {
+        modbus_table_t table;
+        uint16_t addr;
+        uint8_t type;
+    } defaults[] = {
+        { MODBUS_TABLE_COILS, 0, LADDER_REGISTER_Q },       //
+        { MODBUS_TABLE_COILS, 1000, LADDER_REGISTER_M },    //
+        { MODBUS_TABLE_DISCRETE, 0, LADDER_REGISTER_I },    //
+        { MODBUS_TABLE_INPUT, 0, LADDER_REGISTER_IW },      //
+        { MODBUS_TABLE_HOLDING, 0, LADDER_REGISTER_D },     //
+        { MODBUS_TABLE_HOLDING, 1000, LADDER_REGISTER_C },  //
+        { MODBUS_TABLE_HOLDING, 2000, LADDER_REGISTER_T },  //
+        { MODBUS_TABLE_HOLDING, 3000, LADDER_REGISTER_QW }, //
+        { MODBUS_TABLE_HOLDING, 4000, LADDER_REGISTER_R },  //
+    };
+
+    memset(config, 0, sizeof(modbus_server_config_t));
+    config->port = MODBUS_TCP_PORT;
+
+    for (uint32_t n = 0; n < sizeof(defaults) / sizeof(defaults[0]); n++) {
+        uint32_t qty = 0;
+
+        // I/Q images are only sized when the ladder starts: the local module points, as esp32_local_init_read/write size them
+        switch (defaults[n].type) {
+            case LADDER_REGISTER_Q:
+                qty = LOCAL_OUTPUTS;
+                break;
+            case LADDER_REGISTER_I:
+                qty = LOCAL_INPUTS;
+                break;
+            case LADDER_REGISTER_IW:
+                qty = LADDER_HSC_IW_FIRST + 2 * ladder_hsc_qty(); // analog inputs, then count and frequency of each counter
+                break;
+            case LADDER_REGISTER_QW:
+                qty = LADDER_AOUT_MAX;
+                break;
+            case LADDER_REGISTER_M:
+                qty = (*ladder_ctx).ladder.quantity.m;
+                break;
+            case LADDER_REGISTER_C:
+                qty = (*ladder_ctx).ladder.quantity.c;
+                break;
+            case LADDER_REGISTER_T:
+                qty = (*ladder_ctx).ladder.quantity.t;
+                break;
+            case LADDER_REGISTER_D:
+                qty = (*ladder_ctx).ladder.quantity.d;
+                break;
+            case LADDER_REGISTER_R:
+                qty = (*ladder_ctx).ladder.quantity.r;
+                break;
+        }
+        if (qty == 0)
+            continue;
+
+        modbus_map_t *map = &config->map[defaults[n].table][config->maps[defaults[n].table]++];
+        map->addr = defaults[n].addr;
+        map->qty = qty;
+        map->type = defaults[n].type;
+        map->words = 2;
+    }
+}
+
+bool modbus_server_load(const char *file, modbus_server_config_t *config) {
+    modbus_server_config_t loaded = *config;
+    cJSON *item;
+    bool ok = false;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return false;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return false;
+    }
+
+    if ((item = cJSON_GetObjectItem(root, "port")) != NULL && cJSON_IsNumber(item))
+        loaded.port = item->valueint;
+    if ((item = cJSON_GetObjectItem(root, "unit")) != NULL && cJSON_IsNumber(item))
+        loaded.unit = item->valueint;
+
+    for (uint32_t t = 0; t < MODBUS_TABLES; t++) {
+        cJSON *entries = cJSON_GetObjectItem(root, table_names[t]);
+        if (entries == NULL)
+            continue;
+
+        loaded.maps[t] = 0;
+        cJSON_ArrayForEach(item, entries) {
+            if (loaded.maps[t] == MODBUS_SERVER_MAP_MAX)
+                goto end;
+
+            modbus_map_t *map = &loaded.map[t][loaded.maps[t]++];
+            cJSON *value;
+
+            map->type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(item, "type")));
+            map->addr = cJSON_IsNumber(value = cJSON_GetObjectItem(item, "addr")) ? value->valueint : 0;
+            map->qty = cJSON_IsNumber(value = cJSON_GetObjectItem(item, "qty")) ? value->valueint : 0;
+            map->index = cJSON_IsNumber(value = cJSON_GetObjectItem(item, "index")) ? value->valueint : 0;
+            map->module = cJSON_IsNumber(value = cJSON_GetObjectItem(item, "module")) ? value->valueint : 0;
+            map->words = cJSON_IsNumber(value = cJSON_GetObjectItem(item, "words")) ? value->valueint : 2;
+        }
+    }
+
+    if (!config_valid(&loaded))
+        goto end;
+
+    *config = loaded;
+    ok = true;
+
+end:
+    if (!ok)
+        ESP_LOGE(TAG, "ERROR configuration %s", file);
+    cJSON_Delete(root);
+    return ok;
+}
+
+bool modbus_server_start(ladder_ctx_t *ladder_ctx, const modbus_server_config_t *config) {
+    if (mb_task != NULL || !config_valid(config))
+        return false;
+
+    mb_ctx = ladder_ctx;
+    mb_config = *config;
+    modbus_server_session_init(&mb_session, &mb_config, region_get);
+
+    if (xTaskCreate(mb_server_task, "modbus_server", MODBUS_SERVER_TASK_STACK, NULL, MODBUS_SERVER_TASK_PRIO, &mb_task) != pdPASS) {
+        mb_task = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void modbus_server_stats(modbus_server_stats_t *stats) {
+    *stats = mb_session.stats;
+}
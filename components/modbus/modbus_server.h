@@ -0,0 +1,87 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_SERVER_H_
+#define MODBUS_SERVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "modbus_pdu.h"
+#include "modbus_server_session.h"
+
+#define MODBUS_SERVER_SYNC_MS 1000          // longest wait for the scan boundary
+#define MODBUS_SERVER_CONFIG  "modbus.json" // address map loaded at boot
+
+/**
+ * @fn void modbus_server_default(ladder_ctx_t*, modbus_server_config_t*)
+ * @brief Default map: coils 0 Q, 1000 M; discrete inputs 0 I; input registers 0 IW; holding registers 0 D, 1000 C,
+ *        2000 T, 3000 QW, 4000 R. 32 bit values, module 0. The local I/O counts include the counters IW, call it after
+ *        ladder_hsc_load.
+ *
+ * @param ladder_ctx Ladder context, for the registers quantities
+ * @param config Configuration
+ */
+void modbus_server_default(ladder_ctx_t *ladder_ctx, modbus_server_config_t *config);
+
+/**
+ * @fn bool modbus_server_load(const char*, modbus_server_config_t*)
+ * @brief Read a configuration file, tables not in the file keep their entries
+ *
+ *        {"port":502,"unit":0,
+ *         "coils":[{"addr":0,"type":"Q","module":0,"index":0,"qty":6}],
+ *         "holding":[{"addr":0,"type":"D","index":0,"qty":8,"words":1}]}
+ *
+ * @param file File name, relative to the mount point
+ * @param config Configuration
+ * @return true if read and valid
+ */
+bool modbus_server_load(const char *file, modbus_server_config_t *config);
+
+/**
+ * @fn bool modbus_server_start(ladder_ctx_t*, const modbus_server_config_t*)
+ * @brief Start the server task. Reads and writes are done at the scan boundary, all the requests pending at a time in
+ *        one job, so reads see one scan and writes are seen whole by the next one.
+ *
+ * @param ladder_ctx Ladder context
+ * @param config Configuration, copied
+ * @return true if started
+ */
+bool modbus_server_start(ladder_ctx_t *ladder_ctx, const modbus_server_config_t *config);
+
+/**
+ * @fn void modbus_server_stats(modbus_server_stats_t*)
+ * @brief Counters since start
+ *
+ * @param stats Counters
+ */
+void modbus_server_stats(modbus_server_stats_t *stats);
+
+#endif /* MODBUS_SERVER_H_ */
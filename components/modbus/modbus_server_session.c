@@ -0,0 +1,269 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+
+#include "modbus.h"
+#include "modbus_pdu.h"
+#include "modbus_server_session.h"
+
+static const char *TAG = "modbus_server";
+
+static void client_close(modbus_server_session_t *session, modbus_server_client_t *client) {
+    if (client->sd < 0)
+        return;
+
+    closesocket(client->sd);
+    client->sd = -1;
+    client->rx_len = 0;
+    client->pending = false;
+    session->stats.clients--;
+}
+
+// a complete request at the start of rx, false if the client must be closed
+static bool client_frame(modbus_server_session_t *session, modbus_server_client_t *client) {
+    client->pending = false;
+    if (client->rx_len < MODBUS_MBAP_LEN)
+        return true;
+
+    uint16_t length = MODBUS_GET16(&client->rx[4]);
+    if (MODBUS_GET16(&client->rx[2]) != 0 || length < 2 || length > MODBUS_PDU_MAX + 1)
+        return false;
+
+    if (client->rx_len >= MODBUS_MBAP_LEN - 1 + length) {
+        uint8_t unit = client->rx[6];
+        // requests to other units are dropped, as a gateway without that unit would do
+        if (session->config->unit != 0 && unit != session->config->unit) {
+            uint16_t adu_len = MODBUS_MBAP_LEN - 1 + length;
+            memmove(client->rx, client->rx + adu_len, client->rx_len - adu_len);
+            client->rx_len -= adu_len;
+            return client_frame(session, client);
+        }
+        client->pending = true;
+    }
+
+    return true;
+}
+
+static void client_accept(modbus_server_session_t *session) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+
+    int sd = accept(session->listen_sd, (struct sockaddr *)&addr, &addr_len);
+    if (sd < 0)
+        return;
+
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++) {
+        modbus_server_client_t *client = &session->client[c];
+        if (client->sd >= 0)
+            continue;
+
+        int option = 1;
+        setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+        fcntl(sd, F_SETFL, fcntl(sd, F_GETFL, 0) | O_NONBLOCK);
+
+        client->sd = sd;
+        client->rx_len = 0;
+        client->pending = false;
+        client->last = esp_timer_get_time();
+        session->stats.clients++;
+        return;
+    }
+
+    ESP_LOGW(TAG, "no free connection");
+    closesocket(sd);
+}
+
+void modbus_server_session_init(modbus_server_session_t *session, const modbus_server_config_t *config, modbus_region_fn region) {
+    memset(session, 0, sizeof(modbus_server_session_t));
+    session->config = config;
+    session->region = region;
+    session->listen_sd = -1;
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++)
+        session->client[c].sd = -1;
+}
+
+bool modbus_server_session_listen(modbus_server_session_t *session) {
+    struct sockaddr_in addr = { 0 };
+    int option = 1;
+
+    int sd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sd < 0)
+        return false;
+
+    setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(session->config->port);
+
+    if (bind(sd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sd, MODBUS_SERVER_CLIENTS_MAX) != 0) {
+        closesocket(sd);
+        return false;
+    }
+
+    session->listen_sd = sd;
+    return true;
+}
+
+bool modbus_server_session_receive(modbus_server_session_t *session, uint32_t wait_ms) {
+    fd_set rfds;
+    struct timeval timeout;
+    bool pending = false;
+    int max_sd = session->listen_sd;
+
+    FD_ZERO(&rfds);
+    FD_SET(session->listen_sd, &rfds);
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++) {
+        modbus_server_client_t *client = &session->client[c];
+        if (client->sd < 0)
+            continue;
+        pending |= client->pending;
+        // a full buffer holds a request for the next job: recv() into no room would read as a close
+        if (sizeof(client->rx) - client->rx_len == 0)
+            continue;
+        FD_SET(client->sd, &rfds);
+        if (client->sd > max_sd)
+            max_sd = client->sd;
+    }
+
+    // pipelined requests already buffered: don't wait
+    timeout.tv_sec = pending ? 0 : wait_ms / 1000;
+    timeout.tv_usec = pending ? 0 : (wait_ms % 1000) * 1000;
+    if (select(max_sd + 1, &rfds, NULL, NULL, &timeout) < 0) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        return false;
+    }
+
+    if (FD_ISSET(session->listen_sd, &rfds))
+        client_accept(session);
+
+    int64_t now = esp_timer_get_time();
+    pending = false;
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++) {
+        modbus_server_client_t *client = &session->client[c];
+        if (client->sd < 0)
+            continue;
+
+        if (FD_ISSET(client->sd, &rfds)) {
+            int len = recv(client->sd, client->rx + client->rx_len, sizeof(client->rx) - client->rx_len, 0);
+            if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                client_close(session, client);
+                continue;
+            }
+            if (len > 0) {
+                client->rx_len += len;
+                client->last = now;
+            }
+        }
+
+        if (!client_frame(session, client)) {
+            ESP_LOGW(TAG, "bad frame, closing connection");
+            client_close(session, client);
+            continue;
+        }
+
+        if (!client->pending && now - client->last > (int64_t)MODBUS_SERVER_IDLE_MS * 1000) {
+            client_close(session, client);
+            continue;
+        }
+
+        pending |= client->pending;
+    }
+
+    return pending;
+}
+
+void modbus_server_session_serve(modbus_server_session_t *session) {
+    int64_t start = esp_timer_get_time();
+
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++) {
+        modbus_server_client_t *client = &session->client[c];
+        if (client->sd < 0 || !client->pending)
+            continue;
+
+        uint16_t adu_len = MODBUS_MBAP_LEN - 1 + MODBUS_GET16(&client->rx[4]);
+        uint16_t pdu_len =
+            modbus_pdu_serve(session->config, session->region, &client->rx[MODBUS_MBAP_LEN], adu_len - MODBUS_MBAP_LEN, &client->tx[MODBUS_MBAP_LEN]);
+
+        session->stats.requests++;
+        if (client->tx[MODBUS_MBAP_LEN] & MODBUS_FC_EXCEPTION)
+            session->stats.exceptions++;
+
+        memcpy(client->tx, client->rx, MODBUS_MBAP_LEN);
+        MODBUS_PUT16(&client->tx[4], pdu_len + 1);
+        client->tx_len = MODBUS_MBAP_LEN + pdu_len;
+    }
+
+    session->stats.job_us = esp_timer_get_time() - start;
+    if (session->stats.job_us > session->stats.job_max_us)
+        session->stats.job_max_us = session->stats.job_us;
+    session->stats.batches++;
+}
+
+void modbus_server_session_send(modbus_server_session_t *session) {
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++) {
+        modbus_server_client_t *client = &session->client[c];
+        if (client->sd < 0 || !client->pending)
+            continue;
+
+        uint16_t adu_len = MODBUS_MBAP_LEN - 1 + MODBUS_GET16(&client->rx[4]);
+        memmove(client->rx, client->rx + adu_len, client->rx_len - adu_len);
+        client->rx_len -= adu_len;
+        client->pending = false;
+
+        if (send(client->sd, client->tx, client->tx_len, 0) != client->tx_len) {
+            client_close(session, client);
+            continue;
+        }
+
+        // next pipelined request
+        if (!client_frame(session, client))
+            client_close(session, client);
+    }
+}
+
+void modbus_server_session_close(modbus_server_session_t *session) {
+    for (uint32_t c = 0; c < MODBUS_SERVER_CLIENTS_MAX; c++)
+        client_close(session, &session->client[c]);
+
+    if (session->listen_sd >= 0) {
+        closesocket(session->listen_sd);
+        session->listen_sd = -1;
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MODBUS_SERVER_SESSION_H_
+#define MODBUS_SERVER_SESSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modbus.h"
+#include "modbus_pdu.h"
+
+#define MODBUS_SERVER_CLIENTS_MAX 4     // concurrent connections
+#define MODBUS_SERVER_IDLE_MS     60000 // idle connections are closed
+
+/**
+ * @struct modbus_server_stats_s
+ * @brief Server counters
+ *
+ */
+typedef struct modbus_server_stats_s {
+    uint32_t clients;    // open connections
+    uint32_t requests;   // requests answered
+    uint32_t exceptions; // exception responses
+    uint32_t batches;    // scan boundary jobs, each serves every pending request
+    uint32_t job_us;     // last job duration (scan time added)
+    uint32_t job_max_us; // longest job
+} modbus_server_stats_t;
+
+/**
+ * @struct modbus_server_client_s
+ * @brief Connection
+ *
+ */
+typedef struct modbus_server_client_s {
+    int sd;                     // -1: free
+    uint8_t rx[MODBUS_ADU_MAX]; //
+    uint16_t rx_len;            //
+    uint8_t tx[MODBUS_ADU_MAX]; //
+    uint16_t tx_len;            //
+    bool pending;               // rx starts with a complete request for the next job
+    int64_t last;               // us of the last request
+} modbus_server_client_t;
+
+/**
+ * @struct modbus_server_session_s
+ * @brief Listening socket and connections. Requests are read and answered on the server task, served in one job at the
+ *        scan boundary.
+ *
+ */
+typedef struct modbus_server_session_s {
+    const modbus_server_config_t *config;                     // port, unit and address map
+    modbus_region_fn region;                                  // map entry registers
+    int listen_sd;                                            // -1: not listening
+    modbus_server_client_t client[MODBUS_SERVER_CLIENTS_MAX]; //
+    modbus_server_stats_t stats;                              //
+} modbus_server_session_t;
+
+/**
+ * @fn void modbus_server_session_init(modbus_server_session_t*, const modbus_server_config_t*, modbus_region_fn)
+ * @brief Session without socket nor connection
+ *
+ * @param session Session
+ * @param config Configuration, kept by reference
+ * @param region Map entry registers, only called from modbus_server_session_serve
+ */
+void modbus_server_session_init(modbus_server_session_t *session, const modbus_server_config_t *config, modbus_region_fn region);
+
+/**
+ * @fn bool modbus_server_session_listen(modbus_server_session_t*)
+ * @brief Listen on the configured port
+ *
+ * @param session Session
+ * @return false if the port can't be bound
+ */
+bool modbus_server_session_listen(modbus_server_session_t *session);
+
+/**
+ * @fn bool modbus_server_session_receive(modbus_server_session_t*, uint32_t)
+ * @brief Accept connections, read and frame requests, close bad and idle connections
+ *
+ * @param session Session
+ * @param wait_ms Longest wait for data, none if a pipelined request is already buffered
+ * @return true if a request is pending
+ */
+bool modbus_server_session_receive(modbus_server_session_t *session, uint32_t wait_ms);
+
+/**
+ * @fn void modbus_server_session_serve(modbus_server_session_t*)
+ * @brief Answer the pending request of every connection, the scan boundary job
+ *
+ * @param session Session
+ */
+void modbus_server_session_serve(modbus_server_session_t *session);
+
+/**
+ * @fn void modbus_server_session_send(modbus_server_session_t*)
+ * @brief Send the responses of the last job and frame the next pipelined requests
+ *
+ * @param session Session
+ */
+void modbus_server_session_send(modbus_server_session_t *session);
+
+/**
+ * @fn void modbus_server_session_close(modbus_server_session_t*)
+ * @brief Close every connection and the listening socket
+ *
+ * @param session Session
+ */
+void modbus_server_session_close(modbus_server_session_t *session);
+
+#endif /* MODBUS_SERVER_SESSION_H_ */
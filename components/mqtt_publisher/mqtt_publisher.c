@@ -0,0 +1,407 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "hal_fs.h"
+#include "mqtt_client.h"
+
+#include "ladder.h"
+#include "ladder_registers.h"
+#include "mqtt_publisher.h"
+
+static const char *TAG = "mqtt_publisher";
+
+#define MQTT_PUBLISHER_TASK_STACK 4096 //
+#define MQTT_PUBLISHER_TASK_PRIO  4    // below the ladder and the I/O modules
+#define MQTT_PUBLISHER_PAYLOAD    (32 + MQTT_PUBLISHER_VALUES_MAX * 16)
+
+// group snapshot, R values as their bits
+typedef struct mp_message_s {
+    uint8_t group;                            //
+    uint32_t time;                            // ms
+    int32_t value[MQTT_PUBLISHER_VALUES_MAX]; //
+} mp_message_t;
+
+static mqtt_publisher_config_t mp_config;
+static mqtt_publisher_state_t mp_group[MQTT_PUBLISHER_GROUPS_MAX];
+static ladder_ctx_t *mp_ctx = NULL;
+static esp_mqtt_client_handle_t mp_client = NULL;
+static QueueHandle_t mp_queue = NULL;
+static TaskHandle_t mp_task = NULL;
+static volatile bool mp_running = false;
+static uint32_t mp_last_sample = 0;
+static mqtt_publisher_stats_t mp_stats = { 0 };
+
+static inline uint32_t millis(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void group_read(ladder_ctx_t *ladder_ctx, const mqtt_publisher_group_t *group, int32_t *value) {
+    ladder_register_value_t reg;
+    uint32_t v = 0;
+
+    for (uint32_t p = 0; p < group->points; p++) {
+        const mqtt_publisher_point_t *point = &group->point[p];
+        for (uint32_t n = 0; n < point->qty; n++) {
+            reg.i32 = 0;
+            ladder_registers_get(ladder_ctx, point->type, point->module, point->index + n, &reg);
+            value[v++] = reg.i32;
+        }
+    }
+}
+
+static mqtt_publisher_format_t point_format(uint8_t type) {
+    switch (type) {
+        case LADDER_REGISTER_R:
+            return MQTT_PUBLISHER_REAL;
+        case LADDER_REGISTER_IW:
+        case LADDER_REGISTER_QW:
+        case LADDER_REGISTER_D:
+            return MQTT_PUBLISHER_SIGNED;
+        default:
+            return MQTT_PUBLISHER_UNSIGNED;
+    }
+}
+
+void mqtt_publisher_scan(ladder_ctx_t *ladder_ctx) {
+    int32_t value[MQTT_PUBLISHER_VALUES_MAX];
+    mp_message_t message;
+
+    if (!mp_running)
+        return;
+
+    int64_t start = esp_timer_get_time();
+    uint32_t now = (uint32_t)(start / 1000);
+    if (mp_config.sample_ms > 0 && now - mp_last_sample < mp_config.sample_ms)
+        return;
+    mp_last_sample = now;
+
+    for (uint32_t g = 0; g < mp_config.groups; g++) {
+        group_read(ladder_ctx, &mp_config.group[g], value);
+        if (!mqtt_publisher_due(&mp_group[g], value, now, &mp_stats.coalesced))
+            continue;
+
+        message.group = g;
+        message.time = now;
+        memcpy(message.value, value, mp_group[g].values * sizeof(int32_t));
+
+        if (xQueueSend(mp_queue, &message, 0) == pdTRUE)
+            mp_stats.snapshots++;
+        else
+            mp_stats.dropped++;
+    }
+
+    mp_stats.scan_us = esp_timer_get_time() - start;
+    if (mp_stats.scan_us > mp_stats.scan_max_us)
+        mp_stats.scan_max_us = mp_stats.scan_us;
+}
+
+static void publisher_task(void *arg) {
+    static char payload[MQTT_PUBLISHER_PAYLOAD];
+    mp_message_t message;
+
+    while (1) {
+        if (xQueueReceive(mp_queue, &message, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        const mqtt_publisher_group_t *group = &mp_config.group[message.group];
+        uint32_t len = mqtt_publisher_payload(&mp_group[message.group], message.time, message.value, payload, sizeof(payload));
+
+        if (!mp_stats.connected || len == 0 || esp_mqtt_client_publish(mp_client, group->topic, payload, len, group->qos, group->retain) < 0)
+            mp_stats.failed++;
+        else
+            mp_stats.published++;
+    }
+}
+
+// ["I0.0","IW0.1","M3",...]
+static void names_publish(esp_mqtt_client_handle_t client) {
+    char topic[sizeof(mp_config.group[0].topic) + 8];
+    char name[16];
+
+    for (uint32_t g = 0; g < mp_config.groups; g++) {
+        const mqtt_publisher_group_t *group = &mp_config.group[g];
+        cJSON *names = cJSON_CreateArray();
+        if (names == NULL)
+            return;
+
+        for (uint32_t p = 0; p < group->points; p++) {
+            const mqtt_publisher_point_t *point = &group->point[p];
+            bool io = point->type == LADDER_REGISTER_I || point->type == LADDER_REGISTER_Q || point->type == LADDER_REGISTER_IW ||
+                      point->type == LADDER_REGISTER_QW;
+
+            for (uint32_t n = 0; n < point->qty; n++) {
+                if (io)
+                    snprintf(name, sizeof(name), "%s%u.%" PRIu32, ladder_registers_type_name(point->type), point->module, point->index + n);
+                else
+                    snprintf(name, sizeof(name), "%s%" PRIu32, ladder_registers_type_name(point->type), point->index + n);
+                cJSON_AddItemToArray(names, cJSON_CreateString(name));
+            }
+        }
+
+        char *json = cJSON_PrintUnformatted(names);
+        cJSON_Delete(names);
+        if (json == NULL)
+            return;
+
+        snprintf(topic, sizeof(topic), "%s/names", group->topic);
+        esp_mqtt_client_publish(client, topic, json, strlen(json), 1, 1);
+        free(json);
+    }
+}
+
+static void write_request(esp_mqtt_client_handle_t client, const char *data, int len) {
+    char topic[sizeof(mp_config.write) + 8];
+    bool ok = false;
+
+    char *reply = ladder_registers_json(mp_ctx, data, len);
+    if (reply != NULL) {
+        cJSON *root = cJSON_Parse(reply);
+        cJSON *error = cJSON_GetObjectItem(root, "error");
+        ok = cJSON_IsNumber(error) && error->valueint == REGISTERS_ERROR_OK;
+        cJSON_Delete(root);
+
+        snprintf(topic, sizeof(topic), "%s/result", mp_config.write);
+        esp_mqtt_client_publish(client, topic, reply, strlen(reply), 0, 0);
+        free(reply);
+    }
+
+    if (ok)
+        mp_stats.writes++;
+    else
+        mp_stats.write_errors++;
+}
+
+static void mqtt_event(void *arg, esp_event_base_t base, int32_t event_id, void *event_data) {
+    esp_mqtt_event_handle_t event = event_data;
+
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_CONNECTED:
+            ESP_LOGI(TAG, "connected to %s", mp_config.uri);
+            mp_stats.connected = true;
+            if (mp_config.write[0] != '\0')
+                esp_mqtt_client_subscribe(event->client, mp_config.write, 1);
+            names_publish(event->client);
+            break;
+
+        case MQTT_EVENT_DISCONNECTED:
+            mp_stats.connected = false;
+            break;
+
+        case MQTT_EVENT_DATA:
+            // only whole requests, fragmented ones are rejected
+            if (mp_config.write[0] == '\0' || event->topic_len != (int)strlen(mp_config.write) || memcmp(event->topic, mp_config.write, event->topic_len) != 0)
+                break;
+            if (event->current_data_offset != 0 || event->data_len != event->total_data_len) {
+                mp_stats.write_errors++;
+                break;
+            }
+            write_request(event->client, event->data, event->data_len);
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool mqtt_publisher_start(ladder_ctx_t *ladder_ctx, const mqtt_publisher_config_t *config) {
+    if (mp_client != NULL || config->uri[0] == '\0' || config->groups > MQTT_PUBLISHER_GROUPS_MAX)
+        return false;
+
+    uint32_t window_ms = config->window_ms > 0 ? config->window_ms : MQTT_PUBLISHER_WINDOW_MS;
+    for (uint32_t g = 0; g < config->groups; g++) {
+        const mqtt_publisher_group_t *group = &config->group[g];
+
+        if (group->topic[0] == '\0' || group->points > MQTT_PUBLISHER_POINTS_MAX || group->qos > 2) {
+            ESP_LOGE(TAG, "ERROR group %" PRIu32, g);
+            return false;
+        }
+
+        mqtt_publisher_state_init(&mp_group[g], group->change, group->period_ms, window_ms);
+        for (uint32_t p = 0; p < group->points; p++) {
+            const mqtt_publisher_point_t *point = &group->point[p];
+
+            if (!mqtt_publisher_state_add(&mp_group[g], point_format(point->type), point->deadband, point->qty)) {
+                ESP_LOGE(TAG, "ERROR group %s: more than %d values", group->topic, MQTT_PUBLISHER_VALUES_MAX);
+                return false;
+            }
+        }
+    }
+
+    mp_config = *config;
+    mp_config.window_ms = window_ms;
+    mp_ctx = ladder_ctx;
+
+    esp_mqtt_client_config_t mqtt_config = { 0 };
+    mqtt_config.broker.address.uri = mp_config.uri;
+    mqtt_config.credentials.client_id = mp_config.client_id[0] != '\0' ? mp_config.client_id : NULL;
+    mqtt_config.credentials.username = mp_config.username[0] != '\0' ? mp_config.username : NULL;
+    mqtt_config.credentials.authentication.password = mp_config.password[0] != '\0' ? mp_config.password : NULL;
+
+    mp_client = esp_mqtt_client_init(&mqtt_config);
+    if (mp_client == NULL) {
+        ESP_LOGE(TAG, "ERROR client init");
+        return false;
+    }
+    esp_mqtt_client_register_event(mp_client, MQTT_EVENT_ANY, mqtt_event, NULL);
+
+    mp_queue = xQueueCreate(MQTT_PUBLISHER_QUEUE, sizeof(mp_message_t));
+    if (mp_queue == NULL)
+        goto error;
+
+    if (xTaskCreate(publisher_task, "mqtt_publisher", MQTT_PUBLISHER_TASK_STACK, NULL, MQTT_PUBLISHER_TASK_PRIO, &mp_task) != pdPASS) {
+        mp_task = NULL;
+        goto error;
+    }
+
+    if (esp_mqtt_client_start(mp_client) != ESP_OK) {
+        ESP_LOGE(TAG, "ERROR client start");
+        goto error;
+    }
+
+    // the scan hook starts comparing once everything is in place
+    __sync_synchronize();
+    mp_running = true;
+
+    return true;
+
+error:
+    // nothing was published yet, the task waits on the queue
+    if (mp_task != NULL)
+        vTaskDelete(mp_task);
+    if (mp_queue != NULL)
+        vQueueDelete(mp_queue);
+    esp_mqtt_client_destroy(mp_client);
+    mp_task = NULL;
+    mp_queue = NULL;
+    mp_client = NULL;
+    return false;
+}
+
+static void json_string(cJSON *object, const char *name, char *dest, size_t size) {
+    const char *value = cJSON_GetStringValue(cJSON_GetObjectItem(object, name));
+    if (value != NULL)
+        strlcpy(dest, value, size);
+}
+
+static int json_int(cJSON *object, const char *name, int def) {
+    cJSON *item = cJSON_GetObjectItem(object, name);
+    return cJSON_IsNumber(item) ? item->valueint : def;
+}
+
+bool mqtt_publisher_load(ladder_ctx_t *ladder_ctx, const char *file) {
+    cJSON *item, *group_item;
+    bool ok;
+
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *json = malloc(size + 1);
+    if (json == NULL) {
+        fclose(fp);
+        return false;
+    }
+    json[fread(json, 1, size, fp)] = '\0';
+    fclose(fp);
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "ERROR parsing %s", file);
+        return false;
+    }
+
+    mqtt_publisher_config_t *config = calloc(1, sizeof(mqtt_publisher_config_t));
+    if (config == NULL) {
+        cJSON_Delete(root);
+        return false;
+    }
+
+    json_string(root, "uri", config->uri, sizeof(config->uri));
+    json_string(root, "client_id", config->client_id, sizeof(config->client_id));
+    json_string(root, "username", config->username, sizeof(config->username));
+    json_string(root, "password", config->password, sizeof(config->password));
+    json_string(root, "write", config->write, sizeof(config->write));
+    config->window_ms = json_int(root, "window_ms", MQTT_PUBLISHER_WINDOW_MS);
+    config->sample_ms = json_int(root, "sample_ms", 0);
+
+    cJSON_ArrayForEach(group_item, cJSON_GetObjectItem(root, "groups")) {
+        if (config->groups == MQTT_PUBLISHER_GROUPS_MAX)
+            break;
+
+        mqtt_publisher_group_t *group = &config->group[config->groups++];
+        json_string(group_item, "topic", group->topic, sizeof(group->topic));
+        group->change = !cJSON_IsFalse(cJSON_GetObjectItem(group_item, "change"));
+        group->period_ms = json_int(group_item, "period_ms", 0);
+        group->qos = json_int(group_item, "qos", 0);
+        group->retain = cJSON_IsTrue(cJSON_GetObjectItem(group_item, "retain"));
+
+        cJSON_ArrayForEach(item, cJSON_GetObjectItem(group_item, "points")) {
+            if (group->points == MQTT_PUBLISHER_POINTS_MAX)
+                break;
+
+            mqtt_publisher_point_t *point = &group->point[group->points++];
+            cJSON *deadband = cJSON_GetObjectItem(item, "deadband");
+
+            point->type = ladder_registers_type(cJSON_GetStringValue(cJSON_GetObjectItem(item, "type")));
+            point->module = json_int(item, "module", 0);
+            point->index = json_int(item, "index", 0);
+            point->qty = json_int(item, "qty", 1);
+            point->deadband = cJSON_IsNumber(deadband) ? (float)deadband->valuedouble : 0;
+        }
+    }
+
+    ok = mqtt_publisher_start(ladder_ctx, config);
+    if (!ok)
+        ESP_LOGE(TAG, "ERROR configuration %s", file);
+
+    free(config);
+    cJSON_Delete(root);
+    return ok;
+}
+
+void mqtt_publisher_stats(mqtt_publisher_stats_t *stats) {
+    *stats = mp_stats;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MQTT_PUBLISHER_H_
+#define MQTT_PUBLISHER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ladder.h"
+#include "mqtt_publisher_group.h"
+
+#define MQTT_PUBLISHER_GROUPS_MAX 8           // topics
+#define MQTT_PUBLISHER_POINTS_MAX 8           // register ranges per topic
+#define MQTT_PUBLISHER_QUEUE      16          // messages between the scan and the publishing task
+#define MQTT_PUBLISHER_WINDOW_MS  100         // default coalescing window
+#define MQTT_PUBLISHER_CONFIG     "mqtt.json" // configuration loaded at boot
+
+/**
+ * @struct mqtt_publisher_point_s
+ * @brief "qty" consecutive registers
+ *
+ */
+typedef struct mqtt_publisher_point_s {
+    uint8_t type;   // ladder_register_t
+    uint8_t module; // I/Q/IW/QW only
+    uint16_t index; // first register
+    uint16_t qty;   //
+    float deadband; // word registers: smaller changes are not reported, 0: any change
+} mqtt_publisher_point_t;
+
+/**
+ * @struct mqtt_publisher_group_s
+ * @brief Registers published together on one topic
+ *
+ */
+typedef struct mqtt_publisher_group_s {
+    char topic[64];                                          //
+    bool change;                                             // publish on change
+    uint32_t period_ms;                                      // publish at least this often, 0: never
+    uint8_t qos;                                             //
+    bool retain;                                             //
+    uint8_t points;                                          //
+    mqtt_publisher_point_t point[MQTT_PUBLISHER_POINTS_MAX]; //
+} mqtt_publisher_group_t;
+
+/**
+ * @struct mqtt_publisher_config_s
+ * @brief Publisher configuration
+ *
+ */
+typedef struct mqtt_publisher_config_s {
+    char uri[96];                                            // mqtt://host:port
+    char client_id[32];                                      // empty: broker default
+    char username[32];                                       //
+    char password[64];                                       //
+    char write[64];                                          // ladder_registers_json() requests topic, empty: no writes
+    uint32_t window_ms;                                      // changes within the window are published together
+    uint32_t sample_ms;                                      // registers compared at most this often, 0: every scan
+    uint8_t groups;                                          //
+    mqtt_publisher_group_t group[MQTT_PUBLISHER_GROUPS_MAX]; //
+} mqtt_publisher_config_t;
+
+/**
+ * @struct mqtt_publisher_stats_s
+ * @brief Publisher counters
+ *
+ */
+typedef struct mqtt_publisher_stats_s {
+    bool connected;        //
+    uint32_t snapshots;    // messages queued by the scan
+    uint32_t coalesced;    // changes merged into a pending message
+    uint32_t dropped;      // messages lost, queue full
+    uint32_t published;    // messages handed to the client
+    uint32_t failed;       // messages the client refused (not connected)
+    uint32_t writes;       // write requests applied
+    uint32_t write_errors; // write requests rejected
+    uint32_t scan_us;      // last scan hook duration
+    uint32_t scan_max_us;  // longest scan hook
+} mqtt_publisher_stats_t;
+
+/**
+ * @fn bool mqtt_publisher_start(ladder_ctx_t*, const mqtt_publisher_config_t*)
+ * @brief Connect to the broker and start publishing
+ *
+ * @param ladder_ctx Ladder context
+ * @param config Configuration, copied
+ * @return true if started
+ */
+bool mqtt_publisher_start(ladder_ctx_t *ladder_ctx, const mqtt_publisher_config_t *config);
+
+/**
+ * @fn bool mqtt_publisher_load(ladder_ctx_t*, const char*)
+ * @brief Start with a JSON configuration file
+ *
+ *        {"uri":"mqtt://192.168.1.10:1883","client_id":"plc","window_ms":100,"write":"plc/write",
+ *         "groups":[{"topic":"plc/io","change":true,"period_ms":10000,
+ *                    "points":[{"type":"I","module":0,"index":0,"qty":8},{"type":"IW","module":0,"index":0,"qty":2,"deadband":10}]}]}
+ *
+ *        Each group is published as {"t":<ms>,"v":[<values in points order>]}; the register names of the values are
+ *        published retained on "<topic>/names" at every connection. Requests on the write topic are executed by
+ *        ladder_registers_json() and answered on "<write>/result".
+ *
+ * @param ladder_ctx Ladder context
+ * @param file File name, relative to the mount point
+ * @return true if started
+ */
+bool mqtt_publisher_load(ladder_ctx_t *ladder_ctx, const char *file);
+
+/**
+ * @fn void mqtt_publisher_scan(ladder_ctx_t*)
+ * @brief Scan hook: compare the registers and queue the messages due, never blocks
+ *
+ * @param ladder_ctx Ladder context
+ */
+void mqtt_publisher_scan(ladder_ctx_t *ladder_ctx);
+
+/**
+ * @fn void mqtt_publisher_stats(mqtt_publisher_stats_t*)
+ * @brief Counters
+ *
+ * @param stats Counters
+ */
+void mqtt_publisher_stats(mqtt_publisher_stats_t *stats);
+
+#endif /* MQTT_PUBLISHER_H_ */
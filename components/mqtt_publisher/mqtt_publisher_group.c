@@ -0,0 +1,131 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_publisher_group.h"
+
+void mqtt_publisher_state_init(mqtt_publisher_state_t *state, bool change, uint32_t period_ms, uint32_t window_ms) {
+    memset(state, 0, sizeof(mqtt_publisher_state_t));
+    state->change = change;
+    state->period_ms = period_ms;
+    state->window_ms = window_ms;
+}
+
+bool mqtt_publisher_state_add(mqtt_publisher_state_t *state, mqtt_publisher_format_t format, float deadband, uint32_t qty) {
+    if (state->values + qty > MQTT_PUBLISHER_VALUES_MAX)
+        return false;
+
+    for (uint32_t n = 0; n < qty; n++, state->values++) {
+        state->format[state->values] = format;
+        state->deadband[state->values] = deadband;
+    }
+
+    return true;
+}
+
+bool mqtt_publisher_changed(const mqtt_publisher_state_t *state, const int32_t *value) {
+    if (!state->have_last)
+        return true;
+
+    for (uint32_t v = 0; v < state->values; v++) {
+        if (value[v] == state->last[v])
+            continue;
+        if (state->deadband[v] <= 0)
+            return true;
+
+        if (state->format[v] == MQTT_PUBLISHER_REAL) {
+            float now, last;
+            memcpy(&now, &value[v], sizeof(float));
+            memcpy(&last, &state->last[v], sizeof(float));
+            if (fabsf(now - last) >= state->deadband[v] || !isnan(now) != !isnan(last))
+                return true;
+        } else if (llabs((int64_t)value[v] - state->last[v]) >= state->deadband[v]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool mqtt_publisher_due(mqtt_publisher_state_t *state, const int32_t *value, uint32_t now, uint32_t *coalesced) {
+    if (state->change && mqtt_publisher_changed(state, value)) {
+        if (!state->pending) {
+            state->pending = true;
+            state->due = now + state->window_ms;
+        } else {
+            (*coalesced)++;
+        }
+    }
+
+    bool periodic = state->period_ms > 0 && (!state->have_last || now - state->last_time >= state->period_ms);
+    if (!periodic && !(state->pending && (int32_t)(now - state->due) >= 0))
+        return false;
+
+    // what is queued becomes the reference for the next changes, sent or not
+    memcpy(state->last, value, state->values * sizeof(int32_t));
+    state->have_last = true;
+    state->last_time = now;
+    state->pending = false;
+
+    return true;
+}
+
+uint32_t mqtt_publisher_payload(const mqtt_publisher_state_t *state, uint32_t time, const int32_t *value, char *payload, uint32_t size) {
+    uint32_t len = snprintf(payload, size, "{\"t\":%" PRIu32 ",\"v\":[", time);
+
+    for (uint32_t v = 0; v < state->values && len < size; v++) {
+        const char *sep = v > 0 ? "," : "";
+        float real;
+
+        switch (state->format[v]) {
+            case MQTT_PUBLISHER_REAL:
+                memcpy(&real, &value[v], sizeof(float));
+                len += isfinite(real) ? snprintf(payload + len, size - len, "%s%g", sep, real) : snprintf(payload + len, size - len, "%snull", sep);
+                break;
+            case MQTT_PUBLISHER_SIGNED:
+                len += snprintf(payload + len, size - len, "%s%" PRId32, sep, value[v]);
+                break;
+            default:
+                len += snprintf(payload + len, size - len, "%s%" PRIu32, sep, (uint32_t)value[v]);
+                break;
+        }
+    }
+
+    if (len < size)
+        len += snprintf(payload + len, size - len, "]}");
+
+    return len < size ? len : 0;
+}
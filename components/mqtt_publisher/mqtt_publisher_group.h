@@ -0,0 +1,127 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef MQTT_PUBLISHER_GROUP_H_
+#define MQTT_PUBLISHER_GROUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MQTT_PUBLISHER_VALUES_MAX 64 // registers per topic
+
+/**
+ * @enum mqtt_publisher_format_e
+ * @brief How a value is compared and published
+ *
+ */
+typedef enum mqtt_publisher_format_e {
+    MQTT_PUBLISHER_UNSIGNED, // bits, counters
+    MQTT_PUBLISHER_SIGNED,   // IW/QW/D
+    MQTT_PUBLISHER_REAL,     // R, the float bits
+} mqtt_publisher_format_t;
+
+/**
+ * @struct mqtt_publisher_state_s
+ * @brief Group reporting state, owned by the scan
+ *
+ */
+typedef struct mqtt_publisher_state_s {
+    bool change;                               // publish on change
+    uint32_t period_ms;                        // publish at least this often, 0: never
+    uint32_t window_ms;                        // coalescing window
+    uint32_t values;                           //
+    uint8_t format[MQTT_PUBLISHER_VALUES_MAX]; // mqtt_publisher_format_t
+    float deadband[MQTT_PUBLISHER_VALUES_MAX]; //
+    int32_t last[MQTT_PUBLISHER_VALUES_MAX];   // as last queued
+    bool have_last;                            //
+    uint32_t last_time;                        //
+    bool pending;                              // change seen, queued when the window ends
+    uint32_t due;                              //
+} mqtt_publisher_state_t;
+
+/**
+ * @fn void mqtt_publisher_state_init(mqtt_publisher_state_t*, bool, uint32_t, uint32_t)
+ * @brief Empty group
+ *
+ * @param state Group state
+ * @param change Publish on change
+ * @param period_ms Publish at least this often, 0: never
+ * @param window_ms Changes within the window are published together
+ */
+void mqtt_publisher_state_init(mqtt_publisher_state_t *state, bool change, uint32_t period_ms, uint32_t window_ms);
+
+/**
+ * @fn bool mqtt_publisher_state_add(mqtt_publisher_state_t*, mqtt_publisher_format_t, float, uint32_t)
+ * @brief Append "qty" values
+ *
+ * @param state Group state
+ * @param format Value format
+ * @param deadband Smaller changes are not reported, 0: any change
+ * @param qty Values
+ * @return false if the group would hold more than MQTT_PUBLISHER_VALUES_MAX values
+ */
+bool mqtt_publisher_state_add(mqtt_publisher_state_t *state, mqtt_publisher_format_t format, float deadband, uint32_t qty);
+
+/**
+ * @fn bool mqtt_publisher_changed(const mqtt_publisher_state_t*, const int32_t*)
+ * @brief Values differ from the last queued ones by at least their deadband
+ *
+ * @param state Group state
+ * @param value Current values
+ * @return true if changed
+ */
+bool mqtt_publisher_changed(const mqtt_publisher_state_t *state, const int32_t *value);
+
+/**
+ * @fn bool mqtt_publisher_due(mqtt_publisher_state_t*, const int32_t*, uint32_t, uint32_t*)
+ * @brief Sample the group: a change opens a window, later changes within it are coalesced. When the window ends or
+ *        the period elapses the values become the reference for the next changes and must be queued.
+ *
+ * @param state Group state
+ * @param value Current values
+ * @param now Time, ms
+ * @param coalesced Incremented for every change merged into a pending message
+ * @return true if a message is due
+ */
+bool mqtt_publisher_due(mqtt_publisher_state_t *state, const int32_t *value, uint32_t now, uint32_t *coalesced);
+
+/**
+ * @fn uint32_t mqtt_publisher_payload(const mqtt_publisher_state_t*, uint32_t, const int32_t*, char*, uint32_t)
+ * @brief {"t":<ms>,"v":[<values>]}, non finite reals as null
+ *
+ * @param state Group state
+ * @param time Time, ms
+ * @param value Values
+ * @param payload Buffer
+ * @param size Buffer size
+ * @return Payload length, 0 if it does not fit
+ */
+uint32_t mqtt_publisher_payload(const mqtt_publisher_state_t *state, uint32_t time, const int32_t *value, char *payload, uint32_t size);
+
+#endif /* MQTT_PUBLISHER_GROUP_H_ */
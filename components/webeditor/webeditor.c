@@ -35,14 +35,31 @@
 
 #include <esp_http_server.h>
 #include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_rom_md5.h>
+#include <esp_timer.h>
 
+#include "hal_fs.h"
+#include "ladder_datalogger.h"
+#include "ladder_program_check.h"
 #include "ladder_program_json.h"
+#include "ladder_program_store.h"
+#include "ladder_program_update.h"
+#include "ladder_registers.h"
+#include "metrics.h"
 #include "webeditor.h"
 
 static const char *TAG = "WebSocket Server";
 
-extern const char index_html[] asm("_binary_ladder_editor_html_start");
-extern const char favicon_ico[] asm("_binary_webeditor_favicon_ico_start");
+#define PROGRAM_STREAM_CHUNK 1024
+#define REGISTERS_REQUEST_MAX 4096
+#define WS_BROADCAST_CLIENTS  8
+#define NETSTATE_CELL_MAX     80 // {"networkId":%u,"row":%u,"col":%u,"state":%u},
+
+extern const uint8_t index_html_gz_start[] asm("_binary_ladder_editor_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_ladder_editor_html_gz_end");
+extern const uint8_t favicon_ico_gz_start[] asm("_binary_webeditor_favicon_ico_gz_start");
+extern const uint8_t favicon_ico_gz_end[] asm("_binary_webeditor_favicon_ico_gz_end");
 extern TaskHandle_t laddertsk_handle;
 extern ladder_ctx_t ladder_ctx;
 bool websocket_open = false;
@@ -50,17 +67,23 @@ static httpd_handle_t server = NULL;
 static char *response_data = NULL;
 
 static char *ws_commands[] = {
-    "get_flag", //
-    "load",     //
-    "save",     //
-    "start",    //
-    "stop",     //
+    "get_flag",     //
+    "load",         //
+    "load_file",    //
+    "registers",    //
+    "save",         //
+    "save_network", //
+    "start",        //
+    "stop",         //
 };
 
 enum WS_COMMAND {
     WS_GET_FLAG,
     WS_LOAD,
+    WS_LOAD_FILE,
+    WS_REGISTERS,
     WS_SAVE,
+    WS_SAVE_NETWORK,
     WS_START,
     WS_STOP,
 };
@@ -70,15 +93,430 @@ typedef struct async_resp_arg_s {
     int fd;
 } async_resp_arg_t;
 
-static esp_err_t root_get_req_handler(httpd_req_t *req) {
-    if (response_data != NULL)
-        return httpd_resp_send(req, response_data, HTTPD_RESP_USE_STRLEN);
-    else
-        return httpd_resp_send(req, index_html, HTTPD_RESP_USE_STRLEN);
+typedef struct static_asset_s {
+    const uint8_t *start;
+    const uint8_t *end;
+    const char *type;
+    char etag[2 * ESP_ROM_MD5_DIGEST_LEN + 3];
+} static_asset_t;
+
+static static_asset_t asset_index = {
+    .start = index_html_gz_start, //
+    .end = index_html_gz_end,     //
+    .type = "text/html",          //
+};
+
+static static_asset_t asset_favicon = {
+    .start = favicon_ico_gz_start, //
+    .end = favicon_ico_gz_end,     //
+    .type = "image/x-icon",        //
+};
+
+static void static_asset_etag(static_asset_t *asset) {
+    md5_context_t md5;
+    uint8_t digest[ESP_ROM_MD5_DIGEST_LEN];
+
+    esp_rom_md5_init(&md5);
+    esp_rom_md5_update(&md5, asset->start, asset->end - asset->start);
+    esp_rom_md5_final(digest, &md5);
+
+    // strong validator: quoted hex digest of the compressed content
+    asset->etag[0] = '"';
+    for (uint8_t n = 0; n < ESP_ROM_MD5_DIGEST_LEN; n++)
+        sprintf(&asset->etag[1 + n * 2], "%02x", digest[n]);
+    strcat(asset->etag, "\"");
+}
+
+static esp_err_t static_asset_get_req_handler(httpd_req_t *req) {
+    static_asset_t *asset = req->user_ctx;
+    int64_t start = esp_timer_get_time();
+    char if_none_match[sizeof(asset->etag) + 8];
+    esp_err_t ret;
+
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK && strstr(if_none_match, asset->etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        ret = httpd_resp_send(req, NULL, 0);
+        ESP_LOGD(TAG, "%s: 304 (%lld us)", req->uri, esp_timer_get_time() - start);
+        return ret;
+    }
+
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    ret = httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
+    ESP_LOGD(TAG, "%s: 200 %u bytes (%lld us)", req->uri, (unsigned)(asset->end - asset->start), esp_timer_get_time() - start);
+
+    return ret;
+}
+
+typedef struct program_stream_s {
+    httpd_req_t *req;
+    bool ws;
+    bool started;
+    bool failed; // a send failed, the client has a truncated reply
+    size_t bytes;
+} program_stream_t;
+
+static bool program_stream_send(const char *data, size_t len, void *arg) {
+    program_stream_t *stream = arg;
+
+    stream->bytes += len;
+    if (!stream->ws) {
+        if (httpd_resp_send_chunk(stream->req, data, len) != ESP_OK)
+            stream->failed = true;
+        return !stream->failed;
+    }
+
+    // websocket: every piece is a fragment of one text message
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.type = stream->started ? HTTPD_WS_TYPE_CONTINUE : HTTPD_WS_TYPE_TEXT;
+    ws_pkt.fragmented = true;
+    ws_pkt.final = false;
+    ws_pkt.payload = (uint8_t *)data;
+    ws_pkt.len = len;
+    stream->started = true;
+    metrics_ws_sent(len);
+
+    if (httpd_ws_send_frame(stream->req, &ws_pkt) != ESP_OK)
+        stream->failed = true;
+
+    return !stream->failed;
+}
+
+static bool program_stream_begin(program_stream_t *stream, httpd_req_t *req, bool ws) {
+    memset(stream, 0, sizeof(program_stream_t));
+    stream->req = req;
+    stream->ws = ws;
+
+    if (!ws) {
+        httpd_resp_set_type(req, "application/json");
+        return true;
+    }
+
+    return program_stream_send("{\"action\":\"load_response\",\"data\":", 33, stream);
+}
+
+static bool program_stream_end(program_stream_t *stream) {
+    if (!stream->ws)
+        return httpd_resp_send_chunk(stream->req, NULL, 0) == ESP_OK;
+
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.type = HTTPD_WS_TYPE_CONTINUE;
+    ws_pkt.fragmented = true;
+    ws_pkt.final = true;
+    ws_pkt.payload = (uint8_t *)"}";
+    ws_pkt.len = 1;
+
+    return httpd_ws_send_frame(stream->req, &ws_pkt) == ESP_OK;
+}
+
+// a partial program must not look complete: no terminating chunk or frame, the connection is closed
+static void program_stream_abort(program_stream_t *stream) {
+    ESP_LOGI(TAG, ">> ERROR: Program stream aborted after %u bytes", (unsigned)stream->bytes);
+    if (stream->ws)
+        httpd_sess_trigger_close(stream->req->handle, httpd_req_to_sockfd(stream->req));
+}
+
+// stored programs are plain names in the mount point
+static bool program_file_valid(const char *file) {
+    return file[0] != '\0' && strstr(file, "..") == NULL && strchr(file, '/') == NULL && strchr(file, '\\') == NULL;
+}
+
+// send a stored program as is, without parsing it
+static bool program_stream_file(program_stream_t *stream, const char *file) {
+    FILE *fp = fs_open(file, "r");
+    if (fp == NULL)
+        return false;
+
+    char *chunk = malloc(PROGRAM_STREAM_CHUNK);
+    if (chunk == NULL) {
+        fclose(fp);
+        return false;
+    }
+
+    bool ok = true;
+    size_t len;
+    while (ok && (len = fread(chunk, 1, PROGRAM_STREAM_CHUNK, fp)) > 0)
+        ok = program_stream_send(chunk, len, stream);
+
+    free(chunk);
+    fclose(fp);
+
+    return ok;
+}
+
+static bool program_stream_ctx(program_stream_t *stream) {
+    ladder_json_error_t err;
+
+    if ((err = ladder_program_to_json_stream(&ladder_ctx, program_stream_send, stream)) != JSON_ERROR_OK) {
+        ESP_LOGI(TAG, ">> ERROR: Program stream (%d)", err);
+        return false;
+    }
+
+    return true;
+}
+
+static bool ws_get_str_value(const char *payload, const char *key, char *value, size_t size) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+
+    const char *str_start = strstr(payload, pattern);
+    if (str_start == NULL)
+        return false;
+
+    str_start = strchr(str_start + strlen(pattern), '"');
+    if (str_start == NULL)
+        return false;
+
+    const char *str_end = strchr(str_start + 1, '"');
+    if (str_end == NULL || (size_t)(str_end - str_start - 1) >= size)
+        return false;
+
+    memcpy(value, str_start + 1, str_end - str_start - 1);
+    value[str_end - str_start - 1] = '\0';
+
+    return true;
+}
+
+static bool ws_get_num_value(const char *payload, const char *key, uint32_t *value) {
+    char pattern[32];
+    char *end = NULL;
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+
+    const char *str_start = strstr(payload, pattern);
+    if (str_start == NULL)
+        return false;
+
+    *value = strtoul(str_start + strlen(pattern), &end, 10);
+
+    return end != str_start + strlen(pattern);
+}
+
+static esp_err_t ws_reply(httpd_req_t *req, const char *msg) {
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    ws_pkt.payload = (uint8_t *)msg;
+    ws_pkt.len = strlen(msg);
+    metrics_ws_sent(ws_pkt.len);
+
+    return httpd_ws_send_frame(req, &ws_pkt);
+}
+
+/*
+ * {"action":"save_network","id":<n>,"hash":"<crc32 hex>","network":{...}}
+ *
+ * "network" must be the last member, the hash is the CRC-32 of its text exactly as sent.
+ * An id equal to the networks quantity appends a new network.
+ */
+static void ws_save_network(httpd_req_t *req, const char *payload) {
+    char hash_str[16], reply[160];
+    uint32_t id = 0;
+    int err = 0;
+    const char *status = "queued";
+    ladder_network_t network;
+
+    const char *net_start = strstr(payload, "\"network\":");
+    const char *net_end = strrchr(payload, '}');
+
+    if (!ws_get_num_value(payload, "id", &id) || !ws_get_str_value(payload, "hash", hash_str, sizeof(hash_str)) || net_start == NULL || net_end == NULL ||
+        (net_start = strchr(net_start, '{')) == NULL || net_start >= net_end) {
+        status = "bad_request";
+        goto reply;
+    }
+
+    // network object ends at the last '}' before the one closing the message
+    size_t len = net_end - net_start;
+    while (len > 0 && net_start[len - 1] != '}')
+        len--;
+
+    if (esp_rom_crc32_le(0, (const uint8_t *)net_start, len) != strtoul(hash_str, NULL, 16)) {
+        status = "hash_mismatch";
+        goto reply;
+    }
+
+    if (id > ladder_ctx.ladder.quantity.networks) {
+        status = "invalid_id";
+        goto reply;
+    }
+
+    if ((err = ladder_json_to_network(net_start, len, &network)) != JSON_ERROR_OK) {
+        status = "parse_error";
+        goto reply;
+    }
+
+    ladder_prg_check_t check = ladder_network_check(ladder_ctx, &network, id);
+    if (check.error != LADDER_ERR_PRG_CHECK_OK) {
+        ladder_network_free(&network);
+        err = check.error;
+        status = "check_error";
+        goto reply;
+    }
+
+    if (!ladder_program_update_network(&ladder_ctx, id, &network)) {
+        ladder_network_free(&network);
+        status = "busy";
+    }
+
+reply:
+    ESP_LOGI(TAG, "save_network %u: %s (%d)", (unsigned)id, status, err);
+    snprintf(reply, sizeof(reply), "{\"action\":\"save_network_response\",\"id\":%u,\"status\":\"%s\",\"error\":%d}", (unsigned)id, status, err);
+    ws_reply(req, reply);
+}
+
+// the whole program: parsed and checked aside, swapped at the scan boundary (the editor sends single networks when it can)
+static void ws_save_program(char *prg) {
+    ladder_json_error_t err;
+    ladder_prg_check_t check = { 0 };
+    ladder_store_result_t res = LADDER_STORE_INVALID;
+
+    ladder_ctx_t *shadow = malloc(sizeof(ladder_ctx_t));
+    if (shadow == NULL)
+        return;
+    *shadow = ladder_ctx;
+    (*shadow).network = NULL;
+    (*shadow).ladder.quantity.networks = 0;
+
+    if ((err = ladder_json_to_program("", prg, shadow, true)) == JSON_ERROR_OK && (check = ladder_program_check(*shadow)).error == LADDER_ERR_PRG_CHECK_OK) {
+        res = ladder_program_store_swap(&ladder_ctx, (*shadow).network, (*shadow).ladder.quantity.networks, 0);
+        if (res != LADDER_STORE_BUSY && res != LADDER_STORE_ERROR)
+            (*shadow).network = NULL;
+    }
+    ESP_LOGI(TAG, "save: json %d, check %d, store %d", err, check.error, res);
+
+    ladder_program_free((*shadow).network, (*shadow).ladder.quantity.networks);
+    free(shadow);
+}
+
+static void ws_registers(httpd_req_t *req, const char *payload, size_t len) {
+    char *response = ladder_registers_json(&ladder_ctx, payload, len);
+    if (response == NULL) {
+        ESP_LOGI(TAG, ">> ERROR: registers response");
+        return;
+    }
+
+    char *reply = malloc(strlen(response) + 48);
+    if (reply != NULL) {
+        sprintf(reply, "{\"action\":\"registers_response\",\"data\":%s}", response);
+        ws_reply(req, reply);
+        free(reply);
+    }
+    free(response);
 }
 
-static esp_err_t favicon_get_req_handler(httpd_req_t *req) {
-    return httpd_resp_send(req, favicon_ico, HTTPD_RESP_USE_STRLEN);
+static esp_err_t registers_post_req_handler(httpd_req_t *req) {
+    int received = 0, ret;
+
+    if (req->content_len == 0 || req->content_len > REGISTERS_REQUEST_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid request size");
+        return ESP_OK;
+    }
+
+    char *request = malloc(req->content_len);
+    if (request == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+
+    while (received < req->content_len) {
+        if ((ret = httpd_req_recv(req, request + received, req->content_len - received)) <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT)
+                continue;
+            free(request);
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+
+    char *response = ladder_registers_json(&ladder_ctx, request, received);
+    free(request);
+    if (response == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, response);
+    free(response);
+
+    return ESP_OK;
+}
+
+static esp_err_t program_get_req_handler(httpd_req_t *req) {
+    program_stream_t stream;
+    char query[128], file[64];
+    bool from_file = false, ok;
+    int64_t start = esp_timer_get_time();
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK && httpd_query_key_value(query, "file", file, sizeof(file)) == ESP_OK)
+        from_file = true;
+
+    if (from_file && !program_file_valid(file)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid file name");
+        return ESP_OK;
+    }
+
+    if (!from_file && ladder_ctx.network == NULL) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No program");
+        return ESP_OK;
+    }
+
+    program_stream_begin(&stream, req, false);
+    ok = from_file ? program_stream_file(&stream, file) : program_stream_ctx(&stream);
+
+    if (!ok && stream.bytes == 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Program not available");
+        return ESP_OK;
+    }
+
+    // ESP_FAIL without the last chunk: httpd closes the socket
+    if (!ok) {
+        program_stream_abort(&stream);
+        return ESP_FAIL;
+    }
+
+    program_stream_end(&stream);
+    ESP_LOGI(TAG, "/program: %u bytes (%lld ms)", (unsigned)stream.bytes, (esp_timer_get_time() - start) / 1000);
+
+    return ESP_OK;
+}
+
+static bool log_csv_out(const char *data, size_t len, void *arg) {
+    return httpd_resp_send_chunk((httpd_req_t *)arg, data, len) == ESP_OK;
+}
+
+static esp_err_t log_get_req_handler(httpd_req_t *req) {
+    char query[64], file[32];
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK && httpd_query_key_value(query, "file", file, sizeof(file)) == ESP_OK) {
+        if (!program_file_valid(file)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid file name");
+            return ESP_OK;
+        }
+        httpd_resp_set_type(req, "text/csv");
+        if (!ladder_datalogger_csv(file, log_csv_out, req)) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Log not available");
+            return ESP_OK;
+        }
+        httpd_resp_send_chunk(req, NULL, 0);
+        return ESP_OK;
+    }
+
+    char *response = ladder_datalogger_list();
+    if (response == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, response);
+    free(response);
+
+    return ESP_OK;
 }
 
 static void ws_async_send(void *arg) {
@@ -88,6 +526,7 @@ static void ws_async_send(void *arg) {
 
     if (response_data == NULL) {
         ESP_LOGI(TAG, "No response data");
+        free(resp_arg);
         return;
     }
 
@@ -106,6 +545,7 @@ static void ws_async_send(void *arg) {
 
     if (ret != ESP_OK) {
         ESP_LOGI(TAG, "No clients");
+        free(resp_arg);
         free(response_data);
         response_data = NULL;
         return;
@@ -115,7 +555,8 @@ static void ws_async_send(void *arg) {
         int client_info = httpd_ws_get_fd_info(server, client_fds[i]);
         if (client_info == HTTPD_WS_CLIENT_WEBSOCKET) {
             // ESP_LOGI(TAG, "Response on client %d", i);
-            httpd_ws_send_frame_async(hd, client_fds[i], &ws_pkt);
+            if (httpd_ws_send_frame_async(hd, client_fds[i], &ws_pkt) == ESP_OK)
+                metrics_ws_sent(ws_pkt.len);
         }
     }
     if (resp_arg != NULL)
@@ -218,38 +659,54 @@ static esp_err_t handle_ws_req(httpd_req_t *req) {
                     websocket_open = true;
                     break;
                 case WS_LOAD:
-                    ESP_LOGI(TAG, "Requested: load");
-                    char *json = NULL;
-                    if ((err = ladder_program_to_json("", &json, &ladder_ctx, true)) != JSON_ERROR_OK) {
-                        ESP_LOGI(TAG, ">> ERROR: Program to websocket (%d)\n", err);
-                        return 1;
+                case WS_LOAD_FILE: {
+                    ESP_LOGI(TAG, "Requested: %s", ws_commands[_cmd]);
+                    program_stream_t stream;
+                    char file[64];
+                    bool ok = false;
+
+                    if (_cmd == WS_LOAD_FILE && (!ws_get_str_value((char *)ws_pkt.payload, "file", file, sizeof(file)) || !program_file_valid(file))) {
+                        ESP_LOGI(TAG, ">> ERROR: No file name");
+                        free(buf);
+                        return ESP_OK;
                     }
 
-                    if (json != NULL)
-                        ESP_LOGI(TAG, "JSON: ok");
-                    else
-                        ESP_LOGI(TAG, "JSON: empty");
+                    // the program is sent as one fragmented message straight to the requesting client
+                    if (program_stream_begin(&stream, req, true)) {
+                        size_t head = stream.bytes;
+                        ok = (_cmd == WS_LOAD_FILE) ? program_stream_file(&stream, file) : program_stream_ctx(&stream);
+                        if (ok || (!stream.failed && stream.bytes == head && program_stream_send("null", 4, &stream)))
+                            program_stream_end(&stream);
+                        else
+                            program_stream_abort(&stream);
+                    }
+                    ESP_LOGI(TAG, "JSON: %s (%u bytes)", ok ? "ok" : "empty", (unsigned)stream.bytes);
 
-                    response_data = malloc(strlen(json) + 35);
-                    sprintf(response_data, "{\"action\":\"load_response\",\"data\": %s}", json);
-                    free(json);
-                    break;
-                case WS_SAVE:
+                    free(buf);
+                    return ESP_OK;
+                }
+                case WS_REGISTERS:
+                    ws_registers(req, (char *)ws_pkt.payload, ws_pkt.len);
+                    free(buf);
+                    return ESP_OK;
+                case WS_SAVE: {
                     ESP_LOGI(TAG, "Requested: save");
-                    char *prg = NULL;
-                    prg = strchr((char *)ws_pkt.payload, '[');
+                    char *prg = strchr((char *)ws_pkt.payload, '[');
                     if (prg == NULL) {
                         ESP_LOGI(TAG, ">> ERROR: Program from websocket");
+                        free(buf);
                         return ESP_OK;
                     }
 
                     prg[strlen(prg) - 1] = ' ';
-
-                    if ((err = ladder_json_to_program("", prg, &ladder_ctx, true)) != JSON_ERROR_OK) {
-                        ESP_LOGI(TAG, ">> ERROR: Program from websocket (%d)\n", err);
-                        return 1;
-                    }
+                    ws_save_program(prg);
                     break;
+                }
+                case WS_SAVE_NETWORK:
+                    ESP_LOGI(TAG, "Requested: save_network");
+                    ws_save_network(req, (char *)ws_pkt.payload);
+                    free(buf);
+                    return ESP_OK;
                 case WS_START:
                     if (ladder_ctx.network == NULL || ladder_ctx.ladder.state == LADDER_ST_RUNNING) {
                         ESP_LOGI(TAG, ">> ERROR: No networks or already running");
@@ -291,21 +748,49 @@ void start_websocket_server(void) {
     config.core_id = 0;
 
     if (httpd_start(&server, &config) == ESP_OK) {
+        static_asset_etag(&asset_index);
+        static_asset_etag(&asset_favicon);
+        ESP_LOGI(TAG, "Editor: %u bytes gzip, ETag %s", (unsigned)(asset_index.end - asset_index.start), asset_index.etag);
+
         httpd_uri_t root = {
-            .uri = "/",                      //
-            .method = HTTP_GET,              //
-            .handler = root_get_req_handler, //
-            .user_ctx = NULL                 //
+            .uri = "/",                              //
+            .method = HTTP_GET,                      //
+            .handler = static_asset_get_req_handler, //
+            .user_ctx = &asset_index                 //
         };
         httpd_register_uri_handler(server, &root);
 
         httpd_uri_t favicon = {
-            .uri = "/favicon.ico",              //
+            .uri = "/favicon.ico",                   //
+            .method = HTTP_GET,                      //
+            .handler = static_asset_get_req_handler, //
+            .user_ctx = &asset_favicon               //
+        };
+        httpd_register_uri_handler(server, &favicon);
+
+        httpd_uri_t program = {
+            .uri = "/program",                  //
             .method = HTTP_GET,                 //
-            .handler = favicon_get_req_handler, //
+            .handler = program_get_req_handler, //
             .user_ctx = NULL                    //
         };
-        httpd_register_uri_handler(server, &favicon);
+        httpd_register_uri_handler(server, &program);
+
+        httpd_uri_t registers = {
+            .uri = "/registers",                   //
+            .method = HTTP_POST,                   //
+            .handler = registers_post_req_handler, //
+            .user_ctx = NULL                       //
+        };
+        httpd_register_uri_handler(server, &registers);
+
+        httpd_uri_t log = {
+            .uri = "/log",                  //
+            .method = HTTP_GET,             //
+            .handler = log_get_req_handler, //
+            .user_ctx = NULL                //
+        };
+        httpd_register_uri_handler(server, &log);
 
         httpd_uri_t ws = {
             .uri = "/ws",             //
@@ -316,53 +801,95 @@ void start_websocket_server(void) {
         };
         httpd_register_uri_handler(server, &ws);
 
+        if (metrics_start(server) != ESP_OK)
+            ESP_LOGI(TAG, "Metrics failed");
+
         ESP_LOGI(TAG, "Websocket server started");
     } else {
         ESP_LOGI(TAG, "Websocket server failed");
     }
 }
 
-esp_err_t ws_send_netstate(bool running) {
-    esp_err_t err = 0;
-    char *msg = malloc(37);
-    char msg_status[128];
-    async_resp_arg_t *arg = malloc(sizeof(struct async_resp_arg_s));
-    arg->hd = server;
-
-    if (running) {
-        msg = malloc(37);
-        strcpy(msg, "{\"status\":\"running\",\"cell_states\":[");
-        for (unsigned int network = 0; network < ladder_ctx.ladder.quantity.networks; network++) {
-            for (unsigned int column = 0; column < ladder_ctx.exec_network->cols; column++) {
-                for (unsigned int row = 0; row < ladder_ctx.exec_network->rows; row++) {
-                    memset(msg_status, 0, 128);
-                    snprintf(msg_status, 127, "{\"networkId\":%u,\"row\":%u,\"col\":%u,\"state\":%u},", network, row, column,
-                             (unsigned int)(ladder_ctx.network[network].cells[row][column].state == true ? 1 : 0));
-                    msg = realloc(msg, strlen(msg) + strlen(msg_status) + 1);
-                    if (msg == NULL) {
-                        ESP_LOGI(TAG, "Can't allocate networks status");
-                        return ESP_FAIL;
-                    }
-                    memcpy(msg + strlen(msg), msg_status, strlen(msg_status) + 1);
-                }
-            }
+static void ws_broadcast_work(void *arg) {
+    char *msg = arg;
+    httpd_ws_frame_t ws_pkt;
+    int client_fds[WS_BROADCAST_CLIENTS];
+    size_t fds = WS_BROADCAST_CLIENTS;
+
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.payload = (uint8_t *)msg;
+    ws_pkt.len = strlen(msg);
+    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+
+    if (httpd_get_client_list(server, &fds, client_fds) == ESP_OK) {
+        for (int i = 0; i < fds; i++) {
+            if (httpd_ws_get_fd_info(server, client_fds[i]) != HTTPD_WS_CLIENT_WEBSOCKET)
+                continue;
+            if (httpd_ws_send_frame_async(server, client_fds[i], &ws_pkt) == ESP_OK)
+                metrics_ws_sent(ws_pkt.len);
         }
-        memset(msg_status, 0, 128);
-        msg[strlen(msg) - 1] = ' ';
-        strcpy(msg_status, "]}");
-        msg = realloc(msg, strlen(msg) + strlen(msg_status) + 1);
-        if (msg == NULL) {
-            ESP_LOGI(TAG, "Can't allocate networks status");
-            return ESP_FAIL;
+    }
+
+    free(msg);
+}
+
+esp_err_t ws_broadcast(const char *msg) {
+    if (server == NULL)
+        return ESP_ERR_INVALID_STATE;
+
+    char *copy = strdup(msg);
+    if (copy == NULL)
+        return ESP_ERR_NO_MEM;
+
+    // sent from the httpd task, the caller may run in any task
+    esp_err_t err = httpd_queue_work(server, ws_broadcast_work, copy);
+    if (err != ESP_OK)
+        free(copy);
+
+    return err;
+}
+
+// every cell of every network, each network with its own size
+static char *netstate_json(void) {
+    size_t size = 64, len;
+
+    for (uint32_t n = 0; n < ladder_ctx.ladder.quantity.networks; n++)
+        size += (size_t)ladder_ctx.network[n].rows * ladder_ctx.network[n].cols * NETSTATE_CELL_MAX;
+
+    char *msg = malloc(size);
+    if (msg == NULL)
+        return NULL;
+
+    len = snprintf(msg, size, "{\"status\":\"running\",\"cell_states\":[");
+    size_t head = len;
+    for (uint32_t n = 0; n < ladder_ctx.ladder.quantity.networks; n++) {
+        ladder_network_t *network = &ladder_ctx.network[n];
+        for (uint32_t column = 0; column < network->cols; column++) {
+            for (uint32_t row = 0; row < network->rows; row++)
+                len += snprintf(msg + len, size - len, "%s{\"networkId\":%u,\"row\":%u,\"col\":%u,\"state\":%u}", len > head ? "," : "",
+                                (unsigned)n, (unsigned)row, (unsigned)column, network->cells[row][column].state ? 1u : 0u);
         }
-        memcpy(msg + strlen(msg), msg_status, strlen(msg_status) + 1);
-    } else {
-        msg = malloc(37);
-        strcpy(msg, "{\"status\":\"not_running\"}");
+    }
+    snprintf(msg + len, size - len, "]}");
+
+    return msg;
+}
+
+esp_err_t ws_send_netstate(bool running) {
+    // a warm started ladder scans before the server is up
+    if (server == NULL)
+        return ESP_ERR_INVALID_STATE;
+
+    // built here, on the scan task under the scan lock; sent by the httpd task, which owns the message from then on
+    char *msg = running ? netstate_json() : strdup("{\"status\":\"not_running\"}");
+    if (msg == NULL) {
+        ESP_LOGI(TAG, "Can't allocate networks status");
+        return ESP_ERR_NO_MEM;
     }
 
-    response_data = msg;
-    ws_async_send(arg);
+    esp_err_t err = httpd_queue_work(server, ws_broadcast_work, msg);
+    if (err != ESP_OK)
+        free(msg);
 
     return err;
 }
@@ -39,4 +39,13 @@ extern bool websocket_open;
 void start_websocket_server(void);
 esp_err_t ws_send_netstate(bool running);
 
+/**
+ * @fn esp_err_t ws_broadcast(const char*)
+ * @brief Send a text frame to every websocket client. The message is copied, safe to call from any task.
+ *
+ * @param msg Message
+ * @return ESP_OK if queued
+ */
+esp_err_t ws_broadcast(const char *msg);
+
 #endif /* WEBEDITOR_H_ */
@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+#
+# Editor assets for the firmware image. The save_network client is injected into the editor page, then every asset is
+# gzipped and served with "Content-Encoding: gzip" (mtime=0 keeps the output, and so the ETag, stable between builds).
+#
+# usage: webeditor_assets.py <editor.html> <client.js> <editor.html.gz> <favicon.ico> <favicon.ico.gz>
+
+import gzip
+import sys
+
+
+def inject(page, script):
+    tag = b'<script>\n' + script + b'</script>\n'
+    pos = page.lower().rfind(b'</body>')
+    return page[:pos] + tag + page[pos:] if pos >= 0 else page + tag
+
+
+def compress(data, path):
+    with open(path, 'wb') as out:
+        out.write(gzip.compress(data, 9, mtime=0))
+
+
+def main(html, script, html_gz, favicon, favicon_gz):
+    with open(html, 'rb') as page, open(script, 'rb') as client:
+        compress(inject(page.read(), client.read()), html_gz)
+    with open(favicon, 'rb') as icon:
+        compress(icon.read(), favicon_gz)
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:])
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * The MIT License (MIT)
+ *
+ * Injected into the editor page at build time (webeditor_assets.py).
+ *
+ * The editor saves with one {"action":"save","data":[...]} message holding every network. Once the networks on the
+ * device are known (a "load" of the running program, or a previous save) only the networks changed since then are sent,
+ * each one as {"action":"save_network","id":<n>,"hash":"<crc32 hex>","network":{...}}. The device checks and applies
+ * them at the next scan boundary without touching the other networks.
+ *
+ * The whole program is still sent when the device networks are unknown, when networks were removed, when more than one
+ * was appended, and after any save_network reply other than "queued".
+ */
+(function () {
+    'use strict';
+
+    var crcTable = null;
+    var deviceHashes = null; // per network, what the device runs
+    var lastLoad = null;     // "load" (running program) or "load_file" (a stored file)
+    var send = WebSocket.prototype.send;
+
+    function crc32(text) {
+        var bytes = new TextEncoder().encode(text);
+        var crc = 0xffffffff;
+
+        if (crcTable === null) {
+            crcTable = [];
+            for (var n = 0; n < 256; n++) {
+                var c = n;
+                for (var k = 0; k < 8; k++)
+                    c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+                crcTable[n] = c >>> 0;
+            }
+        }
+
+        for (var i = 0; i < bytes.length; i++)
+            crc = crcTable[(crc ^ bytes[i]) & 0xff] ^ (crc >>> 8);
+
+        return ((crc ^ 0xffffffff) >>> 0).toString(16);
+    }
+
+    // the program is the first array member, as the device reads it
+    function programOf(msg) {
+        for (var key in msg)
+            if (Array.isArray(msg[key]))
+                return msg[key];
+
+        return null;
+    }
+
+    function parse(data) {
+        if (typeof data !== 'string')
+            return null;
+
+        try {
+            return JSON.parse(data);
+        } catch (e) {
+            return null;
+        }
+    }
+
+    function onMessage(event) {
+        var msg = parse(event.data);
+        if (msg === null)
+            return;
+
+        if (msg.action === 'load_response') {
+            // a stored file is not what the device runs
+            var program = programOf(msg);
+            deviceHashes = lastLoad === 'load' && program !== null ? program.map(function (network) {
+                return crc32(JSON.stringify(network));
+            }) : null;
+        } else if (msg.action === 'save_network_response' && msg.status !== 'queued') {
+            deviceHashes = null;
+        }
+    }
+
+    WebSocket.prototype.send = function (data) {
+        var msg = parse(data);
+        var program = msg !== null && msg.action === 'save' ? programOf(msg) : null;
+
+        if (!this.saveNetworkHooked) {
+            this.addEventListener('message', onMessage);
+            this.saveNetworkHooked = true;
+        }
+        if (msg !== null && (msg.action === 'load' || msg.action === 'load_file'))
+            lastLoad = msg.action;
+
+        if (program === null)
+            return send.call(this, data);
+
+        var texts = program.map(function (network) {
+            return JSON.stringify(network);
+        });
+        var hashes = texts.map(crc32);
+
+        if (deviceHashes === null || program.length < deviceHashes.length || program.length > deviceHashes.length + 1) {
+            deviceHashes = hashes;
+            return send.call(this, data);
+        }
+
+        // ascending ids: an appended network is the last one
+        for (var id = 0; id < program.length; id++) {
+            if (hashes[id] !== deviceHashes[id])
+                send.call(this, '{"action":"save_network","id":' + id + ',"hash":"' + hashes[id] + '","network":' + texts[id] + '}');
+        }
+        deviceHashes = hashes;
+    };
+})();
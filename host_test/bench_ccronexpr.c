@@ -0,0 +1,92 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// cron_next calls per second, bit-per-bit reference against 64-bit word bit scans
+//
+// usage: bench_ccronexpr [calls per expression]
+
+#include <stdlib.h>
+
+#include "ccronexpr.h"
+#include "ccronexpr_ref.h"
+#include "cron_corpus.h"
+#include "host_test.h"
+
+#define START 1767225600 // 2026-01-01 00:00:00 UTC
+
+int main(int argc, char **argv) {
+    uint32_t calls = argc > 1 ? (uint32_t)atoi(argv[1]) : 1000;
+    int64_t total_us = 0, ref_total_us = 0;
+    uint64_t total_calls = 0;
+    volatile time_t sink = 0;
+
+    printf("%-46s %12s %12s %7s\n", "expression", "ref calls/s", "calls/s", "speedup");
+    for (size_t e = 0; e < CRON_CORPUS_QTY; e++) {
+        const char *err = NULL;
+        cron_expr_t expr;
+        cron_ref_expr_t ref;
+
+        cron_parse_expr(cron_corpus[e].expr, &expr, &err);
+        cron_ref_parse_expr(cron_corpus[e].expr, &ref, NULL);
+        if (err != NULL)
+            continue;
+
+        // the same walk through the fire times for both
+        time_t date = START;
+        int64_t start = test_now_us();
+        for (uint32_t n = 0; n < calls; n++) {
+            date = cron_ref_next(&ref, date);
+            if (date == (time_t)-1)
+                date = START;
+        }
+        int64_t ref_us = test_now_us() - start;
+        sink += date;
+
+        date = START;
+        start = test_now_us();
+        for (uint32_t n = 0; n < calls; n++) {
+            date = cron_next(&expr, date);
+            if (date == (time_t)-1)
+                date = START;
+        }
+        int64_t us = test_now_us() - start;
+        sink += date;
+
+        ref_us = ref_us > 0 ? ref_us : 1;
+        us = us > 0 ? us : 1;
+        printf("%-46s %12.0f %12.0f %6.1fx\n", cron_corpus[e].expr, calls * 1e6 / ref_us, calls * 1e6 / us, (double)ref_us / us);
+        ref_total_us += ref_us;
+        total_us += us;
+        total_calls += calls;
+    }
+
+    printf("%-46s %12.0f %12.0f %6.1fx\n", "all", total_calls * 1e6 / ref_total_us, total_calls * 1e6 / total_us, (double)ref_total_us / total_us);
+
+    return TEST_RESULT();
+}
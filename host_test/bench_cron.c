@@ -0,0 +1,168 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// cron_add and fire cost from 10 to 10k jobs, and lateness of the fired jobs
+//
+// usage: bench_cron [max jobs] [lateness seconds]
+//
+// add and fire costs run on the simulated clock, one hour of it per size: every job fires once. The lateness
+// histogram runs on the real clock, from the second a job is due to its callback.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "cron.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define LATENESS_JOBS_MAX 1000 // a few per second, below the dispatch queue length
+
+static const uint32_t late_buckets_ms[] = { 1, 2, 5, 10, 20, 50, 100, 250, 500, 1000 };
+
+#define LATE_BUCKETS (sizeof(late_buckets_ms) / sizeof(late_buckets_ms[0]))
+
+static uint32_t fired;
+static uint32_t late_hist[LATE_BUCKETS + 1];
+
+static void job_count(uint32_t value) {
+    __atomic_add_fetch(&fired, 1, __ATOMIC_RELAXED);
+}
+
+static void job_late(uint32_t value) {
+    struct timeval tv;
+    uint32_t bucket = 0;
+
+    gettimeofday(&tv, NULL);
+    uint32_t late_ms = tv.tv_usec / 1000;
+    while (bucket < LATE_BUCKETS && late_ms >= late_buckets_ms[bucket])
+        bucket++;
+
+    __atomic_add_fetch(&late_hist[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&fired, 1, __ATOMIC_RELAXED);
+}
+
+// one fire a second on average over an hour, all seconds of the hour used
+static void job_expr(char *expr, size_t size, uint32_t n, bool hourly) {
+    if (hourly)
+        snprintf(expr, size, "%" PRIu32 " %" PRIu32 " * * * *", n % 60, (n / 60) % 60);
+    else
+        snprintf(expr, size, "%" PRIu32 " * * * * *", n % 60);
+}
+
+static bool wait_fired(uint32_t expected, uint32_t timeout_ms) {
+    for (uint32_t ms = 0; __atomic_load_n(&fired, __ATOMIC_RELAXED) < expected; ms++) {
+        if (ms == timeout_ms)
+            return false;
+        usleep(1000);
+    }
+
+    return true;
+}
+
+static void lateness(uint32_t jobs, uint32_t seconds) {
+    char expr[32];
+    uint32_t total = 0;
+
+    cron_start(0);
+    fired = 0;
+    for (uint32_t n = 0; n < jobs; n++) {
+        job_expr(expr, sizeof(expr), n, false);
+        CHECK(cron_add(expr, job_late, n) >= 0);
+    }
+    usleep(seconds * 1000000);
+    cron_stop();
+
+    printf("\nlateness, %" PRIu32 " jobs over %" PRIu32 " s\n", jobs, seconds);
+    for (uint32_t n = 0; n <= LATE_BUCKETS; n++) {
+        total += late_hist[n];
+        if (n < LATE_BUCKETS)
+            printf("  < %4" PRIu32 " ms %8" PRIu32 "\n", late_buckets_ms[n], late_hist[n]);
+        else
+            printf("  >=1000 ms %8" PRIu32 "\n", late_hist[n]);
+    }
+    // at least the jobs of every whole second run
+    CHECK(total >= jobs * (seconds - 1) / 60);
+    CHECK_EQ(late_hist[LATE_BUCKETS], 0);
+}
+
+// cost of stepping the simulated clock through an hour with the timer idle
+static int64_t hour_us(void) {
+    int64_t start = test_now_us();
+
+    for (uint32_t s = 0; s < 3600; s++)
+        host_clock_advance(1000);
+
+    return test_now_us() - start;
+}
+
+static void add_and_fire(uint32_t jobs, int64_t idle_us) {
+    char expr[32];
+
+    cron_start(0);
+    fired = 0;
+
+    int64_t start = test_now_us();
+    for (uint32_t n = 0; n < jobs; n++) {
+        job_expr(expr, sizeof(expr), n, true);
+        CHECK(cron_add(expr, job_count, n) >= 0);
+    }
+    int64_t add_us = test_now_us() - start;
+
+    int64_t fire_us = hour_us() - idle_us;
+    if (fire_us < 0)
+        fire_us = 0;
+
+    CHECK(wait_fired(jobs, 10000));
+    CHECK_EQ(fired, jobs);
+    cron_stop();
+
+    printf("%6" PRIu32 " jobs: add %7.2f us/job, fire %7.2f us/job\n", jobs, (double)add_us / jobs, (double)fire_us / jobs);
+}
+
+int main(int argc, char **argv) {
+    uint32_t max_jobs = argc > 1 ? (uint32_t)atoi(argv[1]) : 10000;
+    uint32_t seconds = argc > 2 ? (uint32_t)atoi(argv[2]) : 5;
+
+    if (seconds > 0)
+        lateness(max_jobs < LATENESS_JOBS_MAX ? max_jobs : LATENESS_JOBS_MAX, seconds);
+
+    // on the hour: the first simulated hour holds every fire time once
+    host_clock_simulate(1767225600); // 2026-01-01 00:00:00 UTC
+    cron_start(0);
+    int64_t idle_us = hour_us();
+    cron_stop();
+    printf("\nsimulated hour with no jobs: %.1f ms\n", idle_us / 1000.0);
+    for (uint32_t jobs = 10; jobs <= max_jobs; jobs *= 10)
+        add_and_fire(jobs, idle_us);
+
+    return TEST_RESULT();
+}
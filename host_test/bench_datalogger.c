@@ -0,0 +1,266 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Data logger chunk packer: sustained samples/s through the packer and the page writes, and write amplification
+// (bytes written to flash per raw sample byte) for a few signal profiles. The writer side is the same as the
+// logger task: a page is written when it is full or when its first sample is LADDER_DATALOGGER_FLUSH_MS old.
+// Every file is read back and decoded against the generated samples.
+//
+// usage: bench_datalogger [samples per profile]
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "host_test.h"
+#include "ladder_datalogger_chunk.h"
+
+#define BENCH_FILE     "bench_datalogger.bin" //
+#define BENCH_FLUSH_MS 60000                  // LADDER_DATALOGGER_FLUSH_MS
+#define BENCH_BLOCK    1024                   // samples generated ahead, outside of the timing
+
+typedef void (*signal_fn)(uint32_t n, uint8_t channels, int32_t *value);
+
+typedef struct profile_s {
+    const char *name;   //
+    uint8_t channels;   //
+    signal_fn signal;   // channel values of sample n
+    uint32_t period_ms; // between samples
+} profile_t;
+
+typedef struct result_s {
+    uint32_t pages;    //
+    uint64_t raw;      // sample bytes, as ladder_datalogger_stats_t raw_bytes
+    uint64_t payload;  // encoded sample bytes
+    int64_t us;        // packing and writing, signals not included
+} result_t;
+
+static uint32_t noise(uint32_t n, uint32_t c) {
+    uint32_t x = n * 2654435761u ^ c * 40503u;
+
+    x ^= x >> 15;
+    x *= 2246822519u;
+    return x ^ (x >> 13);
+}
+
+// I/Q/M points, each one toggling at its own slow rate
+static void signal_bits(uint32_t n, uint8_t channels, int32_t *value) {
+    for (uint8_t c = 0; c < channels; c++)
+        value[c] = (n >> (6 + c % 8)) & 1;
+}
+
+// C and T accumulators, counting and restarting
+static void signal_counters(uint32_t n, uint8_t channels, int32_t *value) {
+    for (uint8_t c = 0; c < channels; c++)
+        value[c] = c & 1 ? n % (1000 * (c + 1)) : (n / (c + 1)) % 1000;
+}
+
+// 12 bit ADC readings, slow sine and a few counts of noise
+static void signal_analog(uint32_t n, uint8_t channels, int32_t *value) {
+    for (uint8_t c = 0; c < channels; c++)
+        value[c] = 2048 + (int32_t)(1000 * sin(n / (800.0 * (c + 1)))) + (int32_t)(noise(n, c) % 17) - 8;
+}
+
+// R registers, logged as IEEE-754 bits: the worst case for deltas
+static void signal_real(uint32_t n, uint8_t channels, int32_t *value) {
+    for (uint8_t c = 0; c < channels; c++) {
+        float real = 20.0f + sinf(n / (800.0f * (c + 1))) + (noise(n, c) % 100) / 1000.0f;
+        memcpy(&value[c], &real, sizeof(real));
+    }
+}
+
+static void sample_make(const profile_t *profile, uint32_t n, int32_t *sample) {
+    sample[0] = n * profile->period_ms;
+    profile->signal(n, profile->channels, &sample[1]);
+}
+
+static void page_out(ladder_datalogger_packer_t *packer, const profile_t *profile, const ladder_datalogger_channel_t *channel, int fd, result_t *result) {
+    result->payload += packer->len - sizeof(ladder_datalogger_chunk_t);
+    ladder_datalogger_chunk_seal(packer, result->pages);
+    CHECK_EQ(write(fd, packer->page, LADDER_DATALOGGER_PAGE_SIZE), LADDER_DATALOGGER_PAGE_SIZE);
+    result->pages++;
+    ladder_datalogger_chunk_reset(packer, profile->channels, channel);
+}
+
+static void pack(const profile_t *profile, uint32_t samples, result_t *result) {
+    ladder_datalogger_channel_t channel[LADDER_DATALOGGER_CHANNELS_MAX] = { 0 };
+    ladder_datalogger_packer_t packer = { .page = malloc(LADDER_DATALOGGER_PAGE_SIZE) };
+    int32_t *block = malloc(BENCH_BLOCK * sizeof(int32_t) * (1 + LADDER_DATALOGGER_CHANNELS_MAX));
+    uint32_t words = 1 + profile->channels, page_time = 0;
+
+    for (uint8_t c = 0; c < profile->channels; c++)
+        channel[c] = (ladder_datalogger_channel_t){ .type = c, .index = c };
+
+    int fd = open(BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CHECK(fd >= 0);
+    memset(result, 0, sizeof(result_t));
+    ladder_datalogger_chunk_reset(&packer, profile->channels, channel);
+
+    for (uint32_t first = 0; first < samples; first += BENCH_BLOCK) {
+        uint32_t qty = samples - first < BENCH_BLOCK ? samples - first : BENCH_BLOCK;
+
+        for (uint32_t k = 0; k < qty; k++)
+            sample_make(profile, first + k, &block[k * words]);
+
+        int64_t start = test_now_us();
+        for (uint32_t k = 0; k < qty; k++) {
+            const int32_t *sample = &block[k * words];
+
+            if (((ladder_datalogger_chunk_t *)packer.page)->samples > 0 && (uint32_t)sample[0] - page_time >= BENCH_FLUSH_MS)
+                page_out(&packer, profile, channel, fd, result);
+            if (((ladder_datalogger_chunk_t *)packer.page)->samples == 0)
+                page_time = sample[0];
+            if (!ladder_datalogger_chunk_add(&packer, sample)) {
+                page_out(&packer, profile, channel, fd, result);
+                page_time = sample[0];
+                CHECK(ladder_datalogger_chunk_add(&packer, sample));
+            }
+            result->raw += sizeof(int32_t) * words;
+        }
+        if (first + qty == samples && ((ladder_datalogger_chunk_t *)packer.page)->samples > 0)
+            page_out(&packer, profile, channel, fd, result);
+        result->us += test_now_us() - start;
+    }
+
+    close(fd);
+    free(block);
+    free(packer.page);
+}
+
+// every page read back is valid and decodes to the generated samples, in order
+static void verify(const profile_t *profile, uint32_t samples, const result_t *result) {
+    uint8_t *page = malloc(LADDER_DATALOGGER_PAGE_SIZE);
+    int32_t sample[1 + LADDER_DATALOGGER_CHANNELS_MAX], expected[1 + LADDER_DATALOGGER_CHANNELS_MAX];
+    uint32_t n = 0, pages = 0, bad = 0;
+
+    FILE *fp = fopen(BENCH_FILE, "rb");
+    CHECK(fp != NULL);
+    while (fp != NULL && fread(page, 1, LADDER_DATALOGGER_PAGE_SIZE, fp) == LADDER_DATALOGGER_PAGE_SIZE) {
+        ladder_datalogger_chunk_t *chunk = (ladder_datalogger_chunk_t *)page;
+        uint32_t pos = 0, decoded = 0;
+
+        CHECK(ladder_datalogger_chunk_check(page));
+        CHECK_EQ(chunk->seq, pages);
+        CHECK_EQ(chunk->channels, profile->channels);
+        while (ladder_datalogger_chunk_next(page, &pos, sample)) {
+            sample_make(profile, n++, expected);
+            bad += memcmp(sample, expected, sizeof(int32_t) * (1 + profile->channels)) != 0;
+            decoded++;
+        }
+        CHECK_EQ(decoded, chunk->samples);
+        pages++;
+    }
+    if (fp != NULL)
+        fclose(fp);
+
+    CHECK_EQ(pages, result->pages);
+    CHECK_EQ(n, samples);
+    CHECK_EQ(bad, 0);
+    free(page);
+}
+
+// deltas that overflow int32 (R bits, sign changes) and a damaged chunk
+static void test_edges(void) {
+    ladder_datalogger_channel_t channel[2] = { 0 };
+    ladder_datalogger_packer_t packer = { .page = malloc(LADDER_DATALOGGER_PAGE_SIZE) };
+    const int32_t values[] = { INT32_MIN, INT32_MAX, 0, -1, INT32_MIN, 1, INT32_MAX, INT32_MIN };
+    int32_t sample[3];
+    uint32_t pos = 0, n = 0;
+
+    ladder_datalogger_chunk_reset(&packer, 2, channel);
+    for (uint32_t k = 0; k < sizeof(values) / sizeof(values[0]); k++) {
+        sample[0] = k == 0 ? UINT32_MAX - 2 : sample[0] + 1; // time wraps
+        sample[1] = values[k];
+        sample[2] = -values[k];
+        CHECK(ladder_datalogger_chunk_add(&packer, sample));
+    }
+    ladder_datalogger_chunk_seal(&packer, 7);
+    CHECK(ladder_datalogger_chunk_check(packer.page));
+
+    while (ladder_datalogger_chunk_next(packer.page, &pos, sample)) {
+        CHECK_EQ((uint32_t)sample[0], (uint32_t)(UINT32_MAX - 2 + n));
+        CHECK_EQ(sample[1], values[n]);
+        CHECK_EQ(sample[2], (int32_t)(0u - (uint32_t)values[n]));
+        n++;
+    }
+    CHECK_EQ(n, sizeof(values) / sizeof(values[0]));
+
+    packer.page[sizeof(ladder_datalogger_chunk_t) + 3] ^= 0x10;
+    CHECK(!ladder_datalogger_chunk_check(packer.page));
+
+    free(packer.page);
+}
+
+int main(int argc, char **argv) {
+    uint32_t samples = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    const profile_t profiles[] = {
+        { "bits x16",     16, signal_bits,     1    },
+        { "counters x8",  8,  signal_counters, 1    },
+        { "analog x4",    4,  signal_analog,   1    },
+        { "analog x4",    4,  signal_analog,   10   },
+        { "analog x4",    4,  signal_analog,   100  },
+        { "analog x4",    4,  signal_analog,   1000 },
+        { "real x4",      4,  signal_real,     1    },
+        { "real x16",     16, signal_real,     1    },
+    };
+    result_t result;
+
+    if (samples == 0) {
+        fprintf(stderr, "usage: %s [samples per profile]\n", argv[0]);
+        return 2;
+    }
+
+    test_edges();
+
+    printf("%-12s %7s %9s %9s %10s %9s %8s\n", "profile", "period", "B/sample", "per page", "ns/sample", "samples/s", "w. ampl");
+    for (uint32_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        const profile_t *profile = &profiles[p];
+
+        pack(profile, samples, &result);
+        verify(profile, samples, &result);
+
+        double written = (double)result.pages * LADDER_DATALOGGER_PAGE_SIZE;
+        printf("%-12s %4" PRIu32 " ms %9.2f %9.0f %10.1f %9.0f %8.3f\n", profile->name, profile->period_ms, (double)result.payload / samples,
+               (double)samples / result.pages, 1000.0 * result.us / samples, result.us > 0 ? 1e6 * samples / result.us : 0.0, written / result.raw);
+
+        // the logger keeps up with a 1 ms scan with room to spare, and compresses what a PLC logs
+        CHECK(result.us == 0 || 1e6 * samples / result.us > 10000);
+        if (profile->signal != signal_real && profile->period_ms == 1)
+            CHECK(written / result.raw < 1.0);
+    }
+
+    unlink(BENCH_FILE);
+
+    return TEST_RESULT();
+}
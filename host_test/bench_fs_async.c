@@ -0,0 +1,277 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// httpd latency while large programs are saved: one worker serves status requests and program saves in arrival
+// order, as the single httpd worker task does. "sync" writes the file on the worker (temporary file, fsync and
+// rename), "async" hands it to the storage service. fsync is wrapped to cost what a LittleFS sector erase and
+// program would, per 4 KiB written.
+//
+// usage: bench_fs_async [saves] [program KB] [ms per sector]
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "hal_fs.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define BENCH_PERIOD_US 2000 // between requests
+#define BENCH_PER_SAVE  100  // requests for each save
+#define BENCH_SECTOR    4096 //
+
+typedef struct bench_req_s {
+    bool save;       //
+    int64_t arrival; // us
+} bench_req_t;
+
+typedef struct bench_mode_s {
+    const char *name;  //
+    bool async;        //
+    int64_t *status;   // us, arrival to response
+    uint32_t statuses; //
+    int64_t *save;     // us, handler time
+    uint32_t saves;    //
+} bench_mode_t;
+
+static uint32_t sector_ms;
+static uint32_t program_len;
+static char *program;
+static QueueHandle_t requests;
+static SemaphoreHandle_t worker_done;
+static bench_mode_t *mode;
+
+int __real_fsync(int fd);
+
+// linked with -Wl,--wrap=fsync
+int __wrap_fsync(int fd) {
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        usleep((useconds_t)((st.st_size + BENCH_SECTOR - 1) / BENCH_SECTOR) * sector_ms * 1000);
+
+    return __real_fsync(fd);
+}
+
+// the save path before the storage service, on the calling task
+static int save_sync(const char *file, const char *data, size_t len) {
+    char route[128], route_tmp[sizeof(route) + 4];
+
+    snprintf(route, sizeof(route), "%s/%s", MOUNT_POINT, file);
+    snprintf(route_tmp, sizeof(route_tmp), "%s.tmp", route);
+
+    FILE *fp = fopen(route_tmp, "w");
+    if (fp == NULL)
+        return -1;
+    int ret = (fwrite(data, 1, len, fp) == len && fflush(fp) == 0 && fsync(fileno(fp)) == 0) ? 0 : -1;
+    if (fclose(fp) != 0)
+        ret = -1;
+
+    return ret == 0 && rename(route_tmp, route) == 0 ? 0 : -1;
+}
+
+static int save_async(const char *file, const char *data, size_t len) {
+    char *copy = malloc(len);
+
+    if (copy == NULL)
+        return -1;
+    memcpy(copy, data, len);
+
+    return fs_write_async(file, copy, len, FS_ASYNC_HIGH, NULL, NULL);
+}
+
+static void worker(void *arg) {
+    bench_req_t req;
+    char reply[64];
+
+    while (xQueueReceive(requests, &req, portMAX_DELAY) == pdTRUE) {
+        if (req.arrival < 0)
+            break;
+
+        if (req.save) {
+            int64_t start = test_now_us();
+            CHECK_EQ(mode->async ? save_async("prg.json", program, program_len) : save_sync("prg.json", program, program_len), 0);
+            mode->save[mode->saves++] = test_now_us() - start;
+            continue;
+        }
+
+        snprintf(reply, sizeof(reply), "{\"state\":%d,\"scan\":%" PRId64 "}", 1, req.arrival);
+        mode->status[mode->statuses++] = test_now_us() - req.arrival;
+    }
+
+    xSemaphoreGive(worker_done);
+    vTaskDelete(NULL);
+}
+
+static int cmp_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_run(bench_mode_t *m, uint32_t saves) {
+    uint32_t total = saves * BENCH_PER_SAVE;
+    int64_t next = test_now_us();
+
+    mode = m;
+    m->status = calloc(total, sizeof(int64_t));
+    m->save = calloc(saves, sizeof(int64_t));
+    CHECK(xTaskCreate(worker, "httpd", 4096, NULL, 5, NULL) == pdPASS);
+
+    for (uint32_t n = 0; n < total; n++) {
+        bench_req_t req = { n % BENCH_PER_SAVE == BENCH_PER_SAVE / 2, 0 };
+
+        while (test_now_us() < next)
+            usleep(100);
+        req.arrival = test_now_us();
+        xQueueSend(requests, &req, portMAX_DELAY);
+        next += BENCH_PERIOD_US;
+    }
+
+    bench_req_t end = { false, -1 };
+    xQueueSend(requests, &end, portMAX_DELAY);
+    xSemaphoreTake(worker_done, portMAX_DELAY);
+
+    int64_t start = test_now_us();
+    CHECK_EQ(fs_sync(60000), ESP_OK);
+    int64_t drain = test_now_us() - start;
+
+    qsort(m->status, m->statuses, sizeof(int64_t), cmp_i64);
+    qsort(m->save, m->saves, sizeof(int64_t), cmp_i64);
+    printf("%-5s status p50 %6" PRId64 " us, p99 %6" PRId64 " us, max %6" PRId64 " us | save p50 %6" PRId64 " us, max %6" PRId64
+           " us | drain %" PRId64 " ms\n",
+           m->name, m->status[m->statuses / 2], m->status[m->statuses * 99 / 100], m->status[m->statuses - 1], m->save[m->saves / 2],
+           m->save[m->saves - 1], drain / 1000);
+}
+
+static bool file_equal(const char *file, const char *data, size_t len) {
+    char route[128];
+    bool equal = false;
+
+    snprintf(route, sizeof(route), "%s/%s", MOUNT_POINT, file);
+    FILE *fp = fopen(route, "r");
+    if (fp == NULL)
+        return false;
+
+    char *buf = malloc(len + 1);
+    if (buf != NULL)
+        equal = fread(buf, 1, len + 1, fp) == len && memcmp(buf, data, len) == 0;
+    free(buf);
+    fclose(fp);
+
+    return equal;
+}
+
+typedef struct bench_wait_s {
+    SemaphoreHandle_t done; //
+    int result;             //
+} bench_wait_t;
+
+static void saved(const char *file, int result, void *arg) {
+    bench_wait_t *wait = arg;
+
+    wait->result = result;
+    xSemaphoreGive(wait->done);
+}
+
+// the console save waits for the completion, a failed temporary file or rename is its result
+static int save_wait(const char *file) {
+    bench_wait_t wait = { xSemaphoreCreateBinary(), 1 };
+    char *copy = strdup("[]");
+
+    if (fs_write_async(file, copy, strlen(copy), FS_ASYNC_HIGH, saved, &wait) == 0)
+        xSemaphoreTake(wait.done, portMAX_DELAY);
+    vSemaphoreDelete(wait.done);
+
+    return wait.result;
+}
+
+int main(int argc, char **argv) {
+    uint32_t saves = argc > 1 ? strtoul(argv[1], NULL, 10) : 8;
+    program_len = (argc > 2 ? strtoul(argv[2], NULL, 10) : 32) * 1024;
+    sector_ms = argc > 3 ? strtoul(argv[3], NULL, 10) : 10;
+
+    if (saves == 0 || program_len == 0) {
+        fprintf(stderr, "usage: %s [saves] [program KB] [ms per sector]\n", argv[0]);
+        return 2;
+    }
+
+    if (mkdir(MOUNT_POINT, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "can't create %s\n", MOUNT_POINT);
+        return 1;
+    }
+
+    program = malloc(program_len);
+    for (uint32_t n = 0; n < program_len; n++)
+        program[n] = "[{}],\"0123456789\n"[n % 17];
+    requests = xQueueCreate(BENCH_PER_SAVE * 2, sizeof(bench_req_t));
+    worker_done = xSemaphoreCreateBinary();
+    CHECK_EQ(littlefs_async_init(), ESP_OK);
+
+    printf("%" PRIu32 " saves of %" PRIu32 " KB, %" PRIu32 " ms per sector, a request every %d us\n", saves, program_len / 1024, sector_ms,
+           BENCH_PERIOD_US);
+
+    bench_mode_t sync = { "sync", false }, async = { "async", true };
+    bench_run(&sync, saves);
+    CHECK(file_equal("prg.json", program, program_len));
+    program[0] = '{';
+    bench_run(&async, saves);
+    CHECK(file_equal("prg.json", program, program_len));
+
+    CHECK_EQ(sync.saves, saves);
+    CHECK_EQ(async.saves, saves);
+    // a save on the worker delays every request queued behind it, a queued one doesn't
+    CHECK(async.status[async.statuses - 1] < sync.status[sync.statuses - 1]);
+    CHECK(async.save[async.saves - 1] < sync.save[0]);
+
+    CHECK_EQ(save_wait("prg.json"), 0);
+    CHECK_EQ(save_wait("missing/prg.json"), -1);
+
+    char route[128];
+    snprintf(route, sizeof(route), "%s/prg.json", MOUNT_POINT);
+    unlink(route);
+    rmdir(MOUNT_POINT);
+    free(sync.status);
+    free(sync.save);
+    free(async.status);
+    free(async.save);
+    free(program);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// FTP server throughput and command latency with parallel local clients
+//
+// usage: bench_ftp [clients] [file KB] [transfers per client] [NOOPs per client]
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ftp_client.h"
+#include "ftpserver.h"
+#include "host_port.h"
+
+#define BENCH_CLIENTS_MAX 3 // FTPSERVER_CMD_CLIENTS_MAX
+
+typedef struct bench_client_s {
+     pthread_t thread;    //
+           int id;        //
+       int64_t *noop_us;  // per NOOP round trip
+      uint64_t rx_bytes;  //
+      uint64_t tx_bytes;  //
+       int64_t rx_us;     //
+       int64_t tx_us;     //
+          bool failed;    //
+} bench_client_t;
+
+static uint32_t file_size;
+static uint32_t transfers;
+static uint32_t noops;
+static char *file_data;
+
+static int64_t now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *bench_client(void *arg) {
+    bench_client_t *bc = arg;
+    ftp_client_t client;
+    char name[32];
+    char *buf = malloc(file_size + 1);
+    size_t len;
+
+    if (buf == NULL || !ftp_client_open(&client, FTPSERVER_CMD_PORT, "test", "test")) {
+        bc->failed = true;
+        free(buf);
+        return NULL;
+    }
+
+    snprintf(name, sizeof(name), "/bench%d.bin", bc->id);
+    for (uint32_t n = 0; n < transfers && !bc->failed; n++) {
+        char cmd[48];
+
+        snprintf(cmd, sizeof(cmd), "STOR %s", name);
+        int64_t start = now_us();
+        if (ftp_client_put(&client, cmd, 0, file_data, file_size) != 226)
+            bc->failed = true;
+        bc->tx_us += now_us() - start;
+        bc->tx_bytes += file_size;
+
+        snprintf(cmd, sizeof(cmd), "RETR %s", name);
+        start = now_us();
+        if (ftp_client_get(&client, cmd, 0, buf, file_size + 1, &len) != 226 || len != file_size || memcmp(buf, file_data, file_size) != 0)
+            bc->failed = true;
+        bc->rx_us += now_us() - start;
+        bc->rx_bytes += len;
+    }
+
+    for (uint32_t n = 0; n < noops && !bc->failed; n++) {
+        int64_t start = now_us();
+        if (ftp_client_cmd(&client, "NOOP") != 200)
+            bc->failed = true;
+        bc->noop_us[n] = now_us() - start;
+    }
+
+    ftp_client_close(&client);
+    free(buf);
+    return NULL;
+}
+
+static int compare_us(const void *a, const void *b) {
+    int64_t x = *(const int64_t*) a, y = *(const int64_t*) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    bench_client_t bc[BENCH_CLIENTS_MAX] = { 0 };
+    char mount[] = "/tmp/bench_ftp.XXXXXX";
+    ftp_client_t probe;
+    int clients = argc > 1 ? atoi(argv[1]) : BENCH_CLIENTS_MAX;
+    int res = 0;
+
+    file_size = (argc > 2 ? (uint32_t)atoi(argv[2]) : 256) * 1024;
+    transfers = argc > 3 ? (uint32_t)atoi(argv[3]) : 8;
+    noops = argc > 4 ? (uint32_t)atoi(argv[4]) : 500;
+    if (clients < 1 || clients > BENCH_CLIENTS_MAX || file_size == 0) {
+        fprintf(stderr, "usage: %s [clients 1..%d] [file KB] [transfers per client] [NOOPs per client]\n", argv[0], BENCH_CLIENTS_MAX);
+        return 1;
+    }
+
+    file_data = malloc(file_size);
+    if (file_data == NULL || mkdtemp(mount) == NULL)
+        return 1;
+    for (uint32_t n = 0; n < file_size; n++)
+        file_data[n] = (char)(n * 31 + n / 251);
+
+    ftpserver_start("test", "test", mount);
+    for (int retry = 0; !ftp_client_open(&probe, FTPSERVER_CMD_PORT, "test", "test"); retry++) {
+        if (retry == 50) {
+            fprintf(stderr, "server not listening on %d\n", FTPSERVER_CMD_PORT);
+            return 1;
+        }
+        usleep(100000);
+    }
+    ftp_client_close(&probe);
+
+    for (int n = 0; n < clients; n++) {
+        bc[n].id = n;
+        bc[n].noop_us = calloc(noops + 1, sizeof(int64_t));
+        pthread_create(&bc[n].thread, NULL, bench_client, &bc[n]);
+    }
+
+    int64_t *all_us = calloc((size_t)clients * noops + 1, sizeof(int64_t));
+    uint64_t rx_bytes = 0, tx_bytes = 0;
+    int64_t rx_us = 0, tx_us = 0;
+    for (int n = 0; n < clients; n++) {
+        pthread_join(bc[n].thread, NULL);
+        if (bc[n].failed) {
+            fprintf(stderr, "client %d failed\n", n);
+            res = 1;
+        }
+        memcpy(all_us + (size_t)n * noops, bc[n].noop_us, noops * sizeof(int64_t));
+        rx_bytes += bc[n].rx_bytes;
+        tx_bytes += bc[n].tx_bytes;
+        // clients run side by side, the slowest one bounds the aggregate rate
+        rx_us = bc[n].rx_us > rx_us ? bc[n].rx_us : rx_us;
+        tx_us = bc[n].tx_us > tx_us ? bc[n].tx_us : tx_us;
+        free(bc[n].noop_us);
+    }
+
+    printf("clients %d, file %" PRIu32 " KB, %" PRIu32 " transfers per client\n", clients, file_size / 1024, transfers);
+    printf("STOR %8.2f MB/s\n", tx_us > 0 ? tx_bytes / (double)tx_us : 0.0);
+    printf("RETR %8.2f MB/s\n", rx_us > 0 ? rx_bytes / (double)rx_us : 0.0);
+    if (noops > 0) {
+        size_t qty = (size_t)clients * noops;
+        qsort(all_us, qty, sizeof(int64_t), compare_us);
+        printf("NOOP p50 %" PRId64 " us, p95 %" PRId64 " us, p99 %" PRId64 " us, max %" PRId64 " us\n", all_us[qty / 2], all_us[qty * 95 / 100],
+                all_us[qty * 99 / 100], all_us[qty - 1]);
+    }
+
+    for (int n = 0; n < clients; n++) {
+        char path[64];
+        snprintf(path, sizeof(path), "%s/bench%d.bin", mount, n);
+        unlink(path);
+    }
+    rmdir(mount);
+    free(all_us);
+    free(file_data);
+
+    return res;
+}
@@ -0,0 +1,436 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Modbus TCP server under load: 1 to MODBUS_SERVER_CLIENTS_MAX clients on loopback sockets, one request at a time or
+// pipelined, through the server session select loop and the scan boundary job, as modbus_server runs them. A scan
+// task on a 1 ms period runs the posted jobs first, then writes its scan count into D900..D909: a read of those
+// registers must always see one scan. Reported: requests/s, requests served per job, request latency, and the scan
+// time with the job included against the scan time without clients.
+//
+// usage: bench_modbus_server [ms per run]
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+
+#include "host_test.h"
+#include "modbus.h"
+#include "modbus_pdu.h"
+#include "modbus_server_session.h"
+
+#define BENCH_SCANS_MAX 100000 // scan times kept per run
+#define BENCH_LAT_MAX   200000 // request latencies kept per run
+#define BENCH_SCAN_REG  900    // D written by every scan
+#define BENCH_SCAN_QTY  10     //
+#define BENCH_WINDOW    4      // pipelined requests
+
+enum {
+    REG_M, // bits, writable
+    REG_D, // words, writable
+};
+
+typedef void (*job_fn)(void *arg);
+
+typedef struct job_s {
+    job_fn fn;
+    void *arg;
+} job_t;
+
+typedef struct client_s {
+    uint32_t id;       //
+    uint32_t window;   // requests sent before reading the responses
+    uint32_t requests; // answered
+    uint32_t errors;   // wrong, torn or missing responses
+} client_t;
+
+static uint8_t M[2048];
+static int32_t D[1000];
+
+static modbus_server_config_t config;
+static modbus_server_session_t session;
+static QueueHandle_t jobs;
+static SemaphoreHandle_t clients_done;
+static TaskHandle_t server_handle;
+static uint16_t server_port;
+static volatile bool server_stop, scan_stop, clients_stop;
+
+static int64_t scan_us[BENCH_SCANS_MAX];
+static volatile uint32_t scans;
+static int64_t lat_us[BENCH_LAT_MAX];
+static uint32_t lats;
+static SemaphoreHandle_t lat_lock;
+
+static bool region(const modbus_map_t *map, modbus_region_t *region) {
+    memset(region, 0, sizeof(modbus_region_t));
+    region->writable = true;
+
+    if (map->type == REG_M) {
+        region->base = M;
+        region->bits = true;
+        region->stride = sizeof(uint8_t);
+    } else {
+        region->base = (uint8_t *)D;
+        region->sign = true;
+        region->stride = sizeof(int32_t);
+    }
+
+    region->base += map->index * region->stride;
+    return true;
+}
+
+static void map_add(modbus_table_t table, uint16_t addr, uint8_t type, uint16_t qty, uint8_t words) {
+    modbus_map_t *map = &config.map[table][config.maps[table]++];
+
+    map->addr = addr;
+    map->type = type;
+    map->qty = qty;
+    map->words = words;
+}
+
+// jobs at the scan boundary, then the program
+static void scan_task(void *arg) {
+    job_t job;
+    uint32_t count = 0;
+
+    while (!scan_stop) {
+        int64_t start = test_now_us();
+
+        while (xQueueReceive(jobs, &job, 0) == pdTRUE)
+            job.fn(job.arg);
+
+        count++;
+        for (uint32_t r = 0; r < BENCH_SCAN_QTY; r++)
+            D[BENCH_SCAN_REG + r] = count & 0x7fff;
+
+        uint32_t n = __atomic_load_n(&scans, __ATOMIC_RELAXED);
+        if (n < BENCH_SCANS_MAX)
+            scan_us[n] = test_now_us() - start;
+        __atomic_store_n(&scans, n + 1, __ATOMIC_RELEASE);
+        vTaskDelay(1);
+    }
+
+    vTaskDelete(NULL);
+}
+
+static void server_job(void *arg) {
+    modbus_server_session_serve(&session);
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+// the modbus_server task loop, posting to the scan task instead of esp32_scan_sync_post
+static void server_task(void *arg) {
+    while (!server_stop) {
+        if (!modbus_server_session_receive(&session, 10))
+            continue;
+
+        job_t job = { server_job, xTaskGetCurrentTaskHandle() };
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (xQueueSend(jobs, &job, portMAX_DELAY) != pdTRUE)
+            continue;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        modbus_server_session_send(&session);
+    }
+
+    vTaskDelete(NULL);
+}
+
+static int client_connect(void) {
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(server_port) };
+    int option = 1;
+
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int sd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sd < 0)
+        return -1;
+    if (connect(sd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(sd);
+        return -1;
+    }
+    setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+
+    return sd;
+}
+
+static bool recv_all(int sd, uint8_t *buf, uint32_t len) {
+    struct timeval timeout = { .tv_sec = 2 };
+
+    setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    while (len > 0) {
+        ssize_t n = recv(sd, buf, len, 0);
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+// request "n" of a client: scan registers read, a write of its own registers, a coils read
+static uint16_t request_make(const client_t *client, uint16_t tid, uint8_t *adu) {
+    uint8_t *pdu = &adu[MODBUS_MBAP_LEN];
+    uint16_t pdu_len;
+
+    switch (tid % 3) {
+        case 0:
+            pdu[0] = MODBUS_FC_READ_HOLDING;
+            MODBUS_PUT16(&pdu[1], BENCH_SCAN_REG);
+            MODBUS_PUT16(&pdu[3], BENCH_SCAN_QTY);
+            pdu_len = 5;
+            break;
+        case 1:
+            pdu[0] = MODBUS_FC_WRITE_REGISTERS;
+            MODBUS_PUT16(&pdu[1], 100 + 10 * client->id);
+            MODBUS_PUT16(&pdu[3], 4);
+            pdu[5] = 8;
+            for (uint32_t r = 0; r < 4; r++)
+                MODBUS_PUT16(&pdu[6 + 2 * r], tid);
+            pdu_len = 14;
+            break;
+        default:
+            pdu[0] = MODBUS_FC_READ_COILS;
+            MODBUS_PUT16(&pdu[1], 64 * client->id);
+            MODBUS_PUT16(&pdu[3], 64);
+            pdu_len = 5;
+            break;
+    }
+
+    MODBUS_PUT16(&adu[0], tid);
+    MODBUS_PUT16(&adu[2], 0);
+    MODBUS_PUT16(&adu[4], pdu_len + 1);
+    adu[6] = 1;
+
+    return MODBUS_MBAP_LEN + pdu_len;
+}
+
+static bool response_check(uint16_t tid, const uint8_t *adu) {
+    const uint8_t *pdu = &adu[MODBUS_MBAP_LEN];
+
+    if (MODBUS_GET16(&adu[0]) != tid || adu[6] != 1 || (pdu[0] & MODBUS_FC_EXCEPTION))
+        return false;
+
+    switch (tid % 3) {
+        case 0:
+            // one scan: every register holds the same count
+            if (pdu[0] != MODBUS_FC_READ_HOLDING || pdu[1] != 2 * BENCH_SCAN_QTY)
+                return false;
+            for (uint32_t r = 1; r < BENCH_SCAN_QTY; r++)
+                if (MODBUS_GET16(&pdu[2 + 2 * r]) != MODBUS_GET16(&pdu[2]))
+                    return false;
+            return true;
+        case 1:
+            return pdu[0] == MODBUS_FC_WRITE_REGISTERS && MODBUS_GET16(&pdu[3]) == 4;
+        default:
+            return pdu[0] == MODBUS_FC_READ_COILS && pdu[1] == 8;
+    }
+}
+
+static void client_task(void *arg) {
+    client_t *client = arg;
+    uint8_t adu[MODBUS_ADU_MAX];
+    int64_t sent[BENCH_WINDOW];
+    uint16_t tid = 0;
+
+    int sd = client_connect();
+    if (sd < 0)
+        client->errors++;
+
+    while (sd >= 0 && !clients_stop) {
+        uint16_t first = tid;
+
+        for (uint32_t w = 0; w < client->window; w++) {
+            uint16_t len = request_make(client, tid++, adu);
+            sent[w] = test_now_us();
+            if (send(sd, adu, len, 0) != len)
+                client->errors++;
+        }
+
+        for (uint32_t w = 0; w < client->window; w++) {
+            if (!recv_all(sd, adu, MODBUS_MBAP_LEN) || !recv_all(sd, &adu[MODBUS_MBAP_LEN], MODBUS_GET16(&adu[4]) - 1)) {
+                client->errors++;
+                clients_stop = true;
+                break;
+            }
+            int64_t lat = test_now_us() - sent[w];
+
+            if (!response_check(first + w, adu))
+                client->errors++;
+            client->requests++;
+
+            xSemaphoreTake(lat_lock, portMAX_DELAY);
+            if (lats < BENCH_LAT_MAX)
+                lat_us[lats++] = lat;
+            xSemaphoreGive(lat_lock);
+        }
+    }
+
+    if (sd >= 0)
+        close(sd);
+    xSemaphoreGive(clients_done);
+    vTaskDelete(NULL);
+}
+
+static int cmp_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void scans_sorted(uint32_t first, uint32_t *qty) {
+    uint32_t end = __atomic_load_n(&scans, __ATOMIC_ACQUIRE);
+
+    if (end > BENCH_SCANS_MAX)
+        end = BENCH_SCANS_MAX;
+    *qty = end > first ? end - first : 0;
+    qsort(&scan_us[first], *qty, sizeof(int64_t), cmp_i64);
+}
+
+static void run(uint32_t qty, uint32_t window, uint32_t ms) {
+    client_t client[MODBUS_SERVER_CLIENTS_MAX] = { 0 };
+    modbus_server_stats_t before = session.stats;
+    uint32_t requests = 0, errors = 0, scan_qty;
+
+    lats = 0;
+    __atomic_store_n(&scans, 0, __ATOMIC_RELEASE);
+    clients_stop = false;
+
+    int64_t start = test_now_us();
+    for (uint32_t c = 0; c < qty; c++) {
+        client[c] = (client_t){ .id = c, .window = window };
+        CHECK(xTaskCreate(client_task, "client", 4096, &client[c], 5, NULL) == pdPASS);
+    }
+    vTaskDelay(pdMS_TO_TICKS(ms));
+    clients_stop = true;
+    for (uint32_t c = 0; c < qty; c++)
+        xSemaphoreTake(clients_done, portMAX_DELAY);
+    int64_t elapsed = test_now_us() - start;
+
+    for (uint32_t c = 0; c < qty; c++) {
+        requests += client[c].requests;
+        errors += client[c].errors;
+    }
+
+    uint32_t served = session.stats.requests - before.requests;
+    uint32_t batches = session.stats.batches - before.batches;
+    scans_sorted(0, &scan_qty);
+    qsort(lat_us, lats, sizeof(int64_t), cmp_i64);
+
+    printf("%u client%s x%-2" PRIu32 " %8.0f req/s %5.2f req/job | latency p50 %5" PRId64 " p99 %5" PRId64 " us | scan p50 %4" PRId64 " p99 %4" PRId64
+           " max %5" PRId64 " us\n",
+           (unsigned)qty, qty > 1 ? "s" : " ", window, 1e6 * requests / elapsed, batches > 0 ? (double)served / batches : 0.0, lats > 0 ? lat_us[lats / 2] : 0,
+           lats > 0 ? lat_us[lats * 99 / 100] : 0, scan_qty > 0 ? scan_us[scan_qty / 2] : 0, scan_qty > 0 ? scan_us[scan_qty * 99 / 100] : 0,
+           scan_qty > 0 ? scan_us[scan_qty - 1] : 0);
+
+    CHECK_EQ(errors, 0);
+    CHECK(requests > 0);
+    CHECK_EQ(session.stats.exceptions - before.exceptions, 0);
+    // a job serves the pending request of every client, one per client: pipelined ones wait for the next scans
+    if (qty > 1)
+        CHECK(served > batches);
+    CHECK(served <= batches * qty);
+}
+
+// one connection more than the server takes: closed at once, the others go on
+static void test_refused(void) {
+    int sd[MODBUS_SERVER_CLIENTS_MAX + 1];
+    uint8_t byte;
+
+    for (uint32_t c = 0; c <= MODBUS_SERVER_CLIENTS_MAX; c++) {
+        sd[c] = client_connect();
+        CHECK(sd[c] >= 0);
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    CHECK_EQ(session.stats.clients, MODBUS_SERVER_CLIENTS_MAX);
+    CHECK(!recv_all(sd[MODBUS_SERVER_CLIENTS_MAX], &byte, 1));
+
+    for (uint32_t c = 0; c <= MODBUS_SERVER_CLIENTS_MAX; c++)
+        if (sd[c] >= 0)
+            close(sd[c]);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    CHECK_EQ(session.stats.clients, 0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t ms = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    uint32_t scan_qty;
+
+    if (ms == 0) {
+        fprintf(stderr, "usage: %s [ms per run]\n", argv[0]);
+        return 2;
+    }
+
+    map_add(MODBUS_TABLE_COILS, 0, REG_M, sizeof(M), 0);
+    map_add(MODBUS_TABLE_HOLDING, 0, REG_D, sizeof(D) / sizeof(D[0]), 1);
+
+    // any free port
+    config.port = 0;
+    modbus_server_session_init(&session, &config, region);
+    CHECK(modbus_server_session_listen(&session));
+    CHECK(getsockname(session.listen_sd, (struct sockaddr *)&addr, &addr_len) == 0);
+    server_port = ntohs(addr.sin_port);
+
+    jobs = xQueueCreate(4, sizeof(job_t));
+    clients_done = xSemaphoreCreateCounting(MODBUS_SERVER_CLIENTS_MAX, 0);
+    lat_lock = xSemaphoreCreateMutex();
+    CHECK(xTaskCreate(scan_task, "ladder", 4096, NULL, 10, NULL) == pdPASS);
+    CHECK(xTaskCreate(server_task, "modbus_server", 4096, NULL, 5, &server_handle) == pdPASS);
+
+    // scan time without clients
+    __atomic_store_n(&scans, 0, __ATOMIC_RELEASE);
+    vTaskDelay(pdMS_TO_TICKS(ms / 2));
+    scans_sorted(0, &scan_qty);
+    printf("%-72s| scan p50 %4" PRId64 " p99 %4" PRId64 " max %5" PRId64 " us\n", "no clients", scan_us[scan_qty / 2],
+           scan_us[scan_qty * 99 / 100], scan_us[scan_qty - 1]);
+
+    for (uint32_t qty = 1; qty <= MODBUS_SERVER_CLIENTS_MAX; qty *= 2) {
+        run(qty, 1, ms);
+        run(qty, BENCH_WINDOW, ms);
+    }
+
+    test_refused();
+
+    printf("%" PRIu32 " requests in %" PRIu32 " jobs, longest job %" PRIu32 " us\n", session.stats.requests, session.stats.batches, session.stats.job_max_us);
+
+    server_stop = true;
+    scan_stop = true;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    modbus_server_session_close(&session);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   ccronexpr_ref.h
+ * Author: alex
+ *
+ * Created on February 24, 2015, 9:35 AM
+ *
+ * Reference copy of components/cron/ccronexpr.h before the 64-bit bitset rewrite, with cron_ renamed
+ * to cron_ref_, for the equivalence test and benchmark in host_test.
+ */
+
+#ifndef _CCRONEXPR_REF_H_
+#define _CCRONEXPR_REF_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Parsed cron expression
+ */
+typedef struct cron_ref_expr_s {
+    uint8_t seconds[8];
+    uint8_t minutes[8];
+    uint8_t hours[3];
+    uint8_t days_of_week[1];
+    uint8_t days_of_month[4];
+    uint8_t months[2];
+} cron_ref_expr_t;
+
+/**
+ * Parses specified cron expression.
+ *
+ * @param expression cron expression as nul-terminated string,
+ *        should be no longer that 256 bytes
+ * @param pointer to cron expression structure, it's client code responsibility
+ *        to free/destroy it afterwards
+ * @param error output error message, will be set to string literal
+ *        error message in case of error. Will be set to NULL on success.
+ *        The error message should NOT be freed by client.
+ */
+void cron_ref_parse_expr(const char *expression, cron_ref_expr_t *target, const char **error);
+
+/**
+ * Uses the specified expression to calculate the next 'fire' date after
+ * the specified date. All dates are processed as UTC (GMT) dates
+ * without timezones information. To use local dates (current system timezone)
+ * instead of GMT compile with '-DCRON_USE_LOCAL_TIME'
+ *
+ * @param expr parsed cron expression to use in next date calculation
+ * @param date start date to start calculation from
+ * @return next 'fire' date in case of success, '((time_t) -1)' in case of error.
+ */
+time_t cron_ref_next(cron_ref_expr_t *expr, time_t date);
+
+/**
+ * Uses the specified expression to calculate the previous 'fire' date after
+ * the specified date. All dates are processed as UTC (GMT) dates
+ * without timezones information. To use local dates (current system timezone)
+ * instead of GMT compile with '-DCRON_USE_LOCAL_TIME'
+ *
+ * @param expr parsed cron expression to use in previous date calculation
+ * @param date start date to start calculation from
+ * @return previous 'fire' date in case of success, '((time_t) -1)' in case of error.
+ */
+time_t cron_ref_prev(cron_ref_expr_t *expr, time_t date);
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CRON_CORPUS_H_
+#define CRON_CORPUS_H_
+
+#include <stdbool.h>
+
+// expressions for the ccronexpr equivalence test and benchmark, the last ones are invalid
+
+typedef struct cron_corpus_s {
+    const char *expr; //
+    bool prev;        // cron_prev usable: both versions recurse until the stack overflows on days that are rare or never occur
+} cron_corpus_t;
+
+static const cron_corpus_t cron_corpus[] = {
+    { "* * * * * *", true },                               //
+    { "0 * * * * *", true },                               //
+    { "0 0 * * * *", true },                               //
+    { "0 0 0 * * *", true },                               //
+    { "*/5 * * * * *", true },                             //
+    { "0 */15 * * * *", true },                            //
+    { "30 1 0 * * *", true },                              //
+    { "0 0 8 * * 1-5", true },                             //
+    { "0 0 8 * * MON-FRI", true },                         //
+    { "0 30 7,12,18 * * *", true },                        //
+    { "0 0 0 1 * *", true },                               //
+    { "0 0 12 31 * *", true },                             //
+    { "0 0 0 29 2 *", false },                             //
+    { "0 0 0 29 FEB ?", false },                           //
+    { "0 0 0 ? JAN,JUL *", true },                         //
+    { "59 59 23 31 12 *", true },                          //
+    { "0 0 0 1 1 *", true },                               //
+    { "15,45 10-20/3 * * * *", true },                     //
+    { "0 0 */6 * * SUN", true },                           //
+    { "0 0 9-17 * * 1,3,5", true },                        //
+    { "0 0 0 13 * 5", true },                              //
+    { "0 0 0 L * *", true },                               //
+    { "0 15 10 1-7 * MON", true },                         //
+    { "1-58/7 3-57/11 1-22/5 2-30/4 1-11/2 0-6/3", true }, //
+    { "0 0 0 30 2 *", false },                             //
+    { "0 0 0 31 4 *", false },                             //
+    { "*/59 */59 */23 * * *", true },                      //
+    { "0 0 0 * * 7", true },                               //
+    { "0 0 0 1,15 * *", true },                            //
+    { "0 0 0 * 6-8 6,0", true },                           //
+    { "", true },                                          //
+    { "* * * * *", true },                                 //
+    { "61 * * * * *", true },                              //
+    { "* 60 * * * *", true },                              //
+    { "* * 24 * * *", true },                              //
+    { "* * * 0 * *", true },                               //
+    { "* * * * 13 *", true },                              //
+    { "* * * * * 8", true },                               //
+    { "a b c d e f", true },                               //
+    { "1-70 * * * * *", true },                            //
+    { "*/0 * * * * *", true },                             //
+};
+
+#define CRON_CORPUS_QTY (sizeof(cron_corpus) / sizeof(cron_corpus[0]))
+
+#endif /* CRON_CORPUS_H_ */
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ftp_client.h"
+
+#define FTP_CLIENT_TIMEOUT_S 10
+
+static int tcp_connect(uint32_t addr, uint16_t port) {
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = addr };
+    struct timeval tv = { .tv_sec = FTP_CLIENT_TIMEOUT_S };
+    int one = 1;
+    int sd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (sd < 0)
+        return -1;
+
+    setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(sd, (struct sockaddr*) &sa, sizeof(sa)) < 0) {
+        close(sd);
+        return -1;
+    }
+
+    return sd;
+}
+
+static int read_line(int sd, char *line, size_t size) {
+    size_t len = 0;
+
+    while (1) {
+        char c;
+        if (recv(sd, &c, 1, 0) != 1)
+            return -1;
+        if (len < size - 1)
+            line[len++] = c;
+        if (c == '\n')
+            break;
+    }
+    line[len] = '\0';
+
+    return (int)len;
+}
+
+int ftp_client_reply(ftp_client_t *client) {
+    char line[512];
+    size_t len = 0;
+    int code = -1;
+
+    client->reply[0] = '\0';
+    while (1) {
+        if (read_line(client->cmd, line, sizeof(line)) < 4)
+            return -1;
+
+        size_t line_len = strlen(line);
+        if (len + line_len < sizeof(client->reply)) {
+            memcpy(client->reply + len, line, line_len + 1);
+            len += line_len;
+        }
+
+        // "nnn-" opens a multi-line reply, "nnn " ends it
+        if (code < 0)
+            code = atoi(line);
+        if (atoi(line) == code && line[3] == ' ')
+            return code;
+    }
+}
+
+int ftp_client_cmd(ftp_client_t *client, const char *fmt, ...) {
+    char cmd[600];
+    va_list args;
+
+    va_start(args, fmt);
+    int len = vsnprintf(cmd, sizeof(cmd) - 2, fmt, args);
+    va_end(args);
+    if (len < 0 || len >= (int)sizeof(cmd) - 2)
+        return -1;
+
+    memcpy(cmd + len, "\r\n", 2);
+    if (send(client->cmd, cmd, len + 2, 0) != len + 2)
+        return -1;
+
+    return ftp_client_reply(client);
+}
+
+bool ftp_client_open(ftp_client_t *client, uint16_t port, const char *user, const char *pass) {
+    client->cmd = tcp_connect(htonl(INADDR_LOOPBACK), port);
+    if (client->cmd < 0)
+        return false;
+
+    if (ftp_client_reply(client) == 220 && ftp_client_cmd(client, "USER %s", user) == 331 && ftp_client_cmd(client, "PASS %s", pass) == 230)
+        return true;
+
+    close(client->cmd);
+    client->cmd = -1;
+    return false;
+}
+
+void ftp_client_close(ftp_client_t *client) {
+    if (client->cmd < 0)
+        return;
+
+    ftp_client_cmd(client, "QUIT");
+    close(client->cmd);
+    client->cmd = -1;
+}
+
+int ftp_client_pasv(ftp_client_t *client) {
+    unsigned h[4], p[2];
+
+    if (ftp_client_cmd(client, "PASV") != 227)
+        return -1;
+
+    const char *open = strchr(client->reply, '(');
+    if (open == NULL || sscanf(open, "(%u,%u,%u,%u,%u,%u)", &h[0], &h[1], &h[2], &h[3], &p[0], &p[1]) != 6)
+        return -1;
+
+    return tcp_connect(htonl(h[0] << 24 | h[1] << 16 | h[2] << 8 | h[3]), (uint16_t)(p[0] << 8 | p[1]));
+}
+
+int ftp_client_get(ftp_client_t *client, const char *cmd, uint32_t rest, char *buf, size_t size, size_t *len) {
+    int sd = ftp_client_pasv(client);
+    int code;
+
+    *len = 0;
+    if (sd < 0)
+        return -1;
+
+    // REST only applies to the command right after it, so it goes after PASV
+    if (rest > 0 && ftp_client_cmd(client, "REST %" PRIu32, rest) != 350) {
+        close(sd);
+        return -1;
+    }
+
+    code = ftp_client_cmd(client, "%s", cmd);
+    if (code != 150 && code != 125) {
+        close(sd);
+        return code;
+    }
+
+    while (1) {
+        char discard[4096];
+        bool room = *len < size;
+        ssize_t got = recv(sd, room ? buf + *len : discard, room ? size - *len : sizeof(discard), 0);
+        if (got <= 0)
+            break;
+        if (room)
+            *len += got;
+    }
+    close(sd);
+
+    return ftp_client_reply(client);
+}
+
+int ftp_client_put(ftp_client_t *client, const char *cmd, uint32_t rest, const char *buf, size_t len) {
+    int sd = ftp_client_pasv(client);
+    int code;
+
+    if (sd < 0)
+        return -1;
+
+    if (rest > 0 && ftp_client_cmd(client, "REST %" PRIu32, rest) != 350) {
+        close(sd);
+        return -1;
+    }
+
+    code = ftp_client_cmd(client, "%s", cmd);
+    if (code != 150 && code != 125) {
+        close(sd);
+        return code;
+    }
+
+    for (size_t sent = 0; sent < len;) {
+        ssize_t res = send(sd, buf + sent, len - sent, 0);
+        if (res <= 0)
+            break;
+        sent += res;
+    }
+    close(sd);
+
+    return ftp_client_reply(client);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef FTP_CLIENT_H_
+#define FTP_CLIENT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FTP_CLIENT_REPLY_MAX 1024
+
+/**
+ * @struct ftp_client_s
+ * @brief Blocking FTP client on one command connection, for the host tests
+ *
+ */
+typedef struct ftp_client_s {
+     int cmd;                         /**< command socket */
+    char reply[FTP_CLIENT_REPLY_MAX]; /**< last reply, every line of a multi-line one */
+} ftp_client_t;
+
+/**
+ * @fn bool ftp_client_open(ftp_client_t*, uint16_t, const char*, const char*)
+ * @brief Connect to 127.0.0.1 and log in
+ *
+ * @param client Client
+ * @param port Command port
+ * @param user User
+ * @param pass Password
+ * @return Logged in
+ */
+bool ftp_client_open(ftp_client_t *client, uint16_t port, const char *user, const char *pass);
+
+/**
+ * @fn void ftp_client_close(ftp_client_t*)
+ * @brief QUIT and close the command connection
+ *
+ * @param client Client
+ */
+void ftp_client_close(ftp_client_t *client);
+
+/**
+ * @fn int ftp_client_cmd(ftp_client_t*, const char*, ...)
+ * @brief Send one command and wait for its final reply
+ *
+ * @param client Client
+ * @param fmt Command, printf format without the line end
+ * @return Reply code, -1 on a connection error
+ */
+int ftp_client_cmd(ftp_client_t *client, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @fn int ftp_client_reply(ftp_client_t*)
+ * @brief Wait for the next final reply, e.g. the 226 after a transfer
+ *
+ * @param client Client
+ * @return Reply code, -1 on a connection error
+ */
+int ftp_client_reply(ftp_client_t *client);
+
+/**
+ * @fn int ftp_client_pasv(ftp_client_t*)
+ * @brief PASV and connect the data connection
+ *
+ * @param client Client
+ * @return Data socket, -1 on error
+ */
+int ftp_client_pasv(ftp_client_t *client);
+
+/**
+ * @fn int ftp_client_get(ftp_client_t*, const char*, uint32_t, char*, size_t, size_t*)
+ * @brief Run a command that sends data to the client (RETR, LIST, NLST, MLSD) and collect it
+ *
+ * @param client Client
+ * @param cmd Command with its parameter
+ * @param rest REST offset sent right before the command, 0 for none
+ * @param buf Data
+ * @param size Data buffer size
+ * @param len Data length
+ * @return Final reply code
+ */
+int ftp_client_get(ftp_client_t *client, const char *cmd, uint32_t rest, char *buf, size_t size, size_t *len);
+
+/**
+ * @fn int ftp_client_put(ftp_client_t*, const char*, uint32_t, const char*, size_t)
+ * @brief Run a command that receives data from the client (STOR, APPE)
+ *
+ * @param client Client
+ * @param cmd Command with its parameter
+ * @param rest REST offset sent right before the command, 0 for none
+ * @param buf Data
+ * @param len Data length
+ * @return Final reply code
+ */
+int ftp_client_put(ftp_client_t *client, const char *cmd, uint32_t rest, const char *buf, size_t len);
+
+#endif /* FTP_CLIENT_H_ */
@@ -0,0 +1,1179 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// FreeRTOS and ESP-IDF services on POSIX threads, for the host build of the portable components
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "driver/uart.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+#include "host_port.h"
+
+#define HOST_HTTPD_HANDLERS 16
+#define HOST_UART_PORTS     3
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// clock
+
+static pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool clock_sim = false;
+static int64_t clock_sim_us = 0;
+static time_t clock_epoch = 0;
+static struct timespec clock_start;
+static pthread_once_t clock_once = PTHREAD_ONCE_INIT;
+
+static void clock_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &clock_start);
+}
+
+static int64_t clock_mono_us(void) {
+    struct timespec now;
+
+    pthread_once(&clock_once, clock_init);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - clock_start.tv_sec) * 1000000 + (now.tv_nsec - clock_start.tv_nsec) / 1000;
+}
+
+int64_t host_clock_us(void) {
+    int64_t us;
+
+    pthread_mutex_lock(&clock_mutex);
+    us = clock_sim ? clock_sim_us : clock_mono_us();
+    pthread_mutex_unlock(&clock_mutex);
+
+    return us;
+}
+
+int64_t esp_timer_get_time(void) {
+    return host_clock_us();
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(host_clock_us() / 1000);
+}
+
+// linked with -Wl,--wrap=gettimeofday
+int __real_gettimeofday(struct timeval *tv, void *tz);
+
+int __wrap_gettimeofday(struct timeval *tv, void *tz) {
+    pthread_mutex_lock(&clock_mutex);
+    if (!clock_sim) {
+        pthread_mutex_unlock(&clock_mutex);
+        return __real_gettimeofday(tv, tz);
+    }
+    tv->tv_sec = clock_epoch + clock_sim_us / 1000000;
+    tv->tv_usec = clock_sim_us % 1000000;
+    pthread_mutex_unlock(&clock_mutex);
+
+    return 0;
+}
+
+// deadline for a wait of "ticks", on the real clock: waits never depend on the simulated one
+static void wait_deadline(TickType_t ticks, struct timespec *deadline) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ticks / 1000;
+    deadline->tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (deadline->tv_nsec >= 1000000000) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+static void cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+// false on timeout
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, TickType_t ticks, const struct timespec *deadline) {
+    if (ticks == 0)
+        return false;
+    if (ticks == portMAX_DELAY)
+        return pthread_cond_wait(cond, mutex) == 0;
+
+    return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+static void mutex_unlock_cleanup(void *mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// tasks
+
+struct host_task {
+    pthread_t thread;                   //
+    char name[configMAX_TASK_NAME_LEN]; //
+    TaskFunction_t fn;                  //
+    void *arg;                          //
+    UBaseType_t number;                 //
+    UBaseType_t prio;                   //
+    SemaphoreHandle_t notify;           // task notification value, a counting semaphore
+    struct host_task *next;             //
+};
+
+static pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct host_task *task_list = NULL;
+static UBaseType_t task_number = 0;
+static pthread_key_t task_key;
+static pthread_once_t task_once = PTHREAD_ONCE_INIT;
+
+static SemaphoreHandle_t sem_create(UBaseType_t max, UBaseType_t initial, bool recursive);
+
+static void task_free(struct host_task *task) {
+    vSemaphoreDelete(task->notify);
+    free(task);
+}
+
+static void task_key_init(void) {
+    pthread_key_create(&task_key, NULL);
+}
+
+static void task_remove(struct host_task *task) {
+    pthread_mutex_lock(&task_mutex);
+    for (struct host_task **p = &task_list; *p != NULL; p = &(*p)->next) {
+        if (*p == task) {
+            *p = task->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&task_mutex);
+}
+
+static void *task_main(void *arg) {
+    struct host_task *task = arg;
+
+    pthread_setspecific(task_key, task);
+    task->fn(task->arg);
+
+    // a FreeRTOS task never returns, a host one that does just ends
+    task_remove(task);
+    task_free(task);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle) {
+    pthread_attr_t attr;
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+
+    if (task == NULL)
+        return pdFAIL;
+
+    pthread_once(&task_once, task_key_init);
+    strlcpy(task->name, name != NULL ? name : "", sizeof(task->name));
+    task->fn = fn;
+    task->arg = arg;
+    task->prio = prio;
+    task->notify = sem_create(UINT32_MAX, 0, false);
+    if (task->notify == NULL) {
+        free(task);
+        return pdFAIL;
+    }
+
+    pthread_mutex_lock(&task_mutex);
+    task->number = ++task_number;
+    task->next = task_list;
+    task_list = task;
+    pthread_mutex_unlock(&task_mutex);
+
+    if (handle != NULL)
+        *handle = task;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int res = pthread_create(&task->thread, &attr, task_main, task);
+    pthread_attr_destroy(&attr);
+    if (res != 0) {
+        task_remove(task);
+        task_free(task);
+        if (handle != NULL)
+            *handle = NULL;
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    pthread_once(&task_once, task_key_init);
+    return pthread_getspecific(task_key);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    if (task == NULL || task == self) {
+        if (self != NULL) {
+            task_remove(self);
+            task_free(self);
+        }
+        pthread_exit(NULL);
+    }
+
+    // blocked waits are cancellation points, the mutexes they hold are released on the way out
+    task_remove(task);
+    pthread_cancel(task->thread);
+    task_free(task);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    usleep((useconds_t)ticks * 1000);
+}
+
+void vTaskDelayUntil(TickType_t *wake, TickType_t period) {
+    TickType_t now = xTaskGetTickCount();
+
+    // a late task is not delayed, the next wake time stays on the period grid
+    *wake += period;
+    if ((int32_t)(*wake - now) > 0)
+        vTaskDelay(*wake - now);
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    UBaseType_t qty = 0;
+
+    pthread_mutex_lock(&task_mutex);
+    for (struct host_task *task = task_list; task != NULL; task = task->next)
+        qty++;
+    pthread_mutex_unlock(&task_mutex);
+
+    return qty;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t qty, uint32_t *total_runtime) {
+    UBaseType_t n = 0;
+
+    pthread_mutex_lock(&task_mutex);
+    for (struct host_task *task = task_list; task != NULL && n < qty; task = task->next, n++) {
+        memset(&status[n], 0, sizeof(TaskStatus_t));
+        status[n].xHandle = task;
+        status[n].pcTaskName = task->name;
+        status[n].xTaskNumber = task->number;
+        status[n].eCurrentState = eBlocked;
+        status[n].uxCurrentPriority = task->prio;
+        status[n].uxBasePriority = task->prio;
+        status[n].usStackHighWaterMark = 1024;
+    }
+    pthread_mutex_unlock(&task_mutex);
+
+    if (total_runtime != NULL)
+        *total_runtime = (uint32_t)host_clock_us();
+
+    return n;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return 1024;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// queues
+
+struct host_queue {
+    pthread_mutex_t mutex;    //
+    pthread_cond_t not_empty; //
+    pthread_cond_t not_full;  //
+    uint8_t *buf;             //
+    UBaseType_t item_size;    //
+    UBaseType_t len;          //
+    UBaseType_t head;         //
+    UBaseType_t count;        //
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+
+    if (queue == NULL)
+        return NULL;
+
+    queue->buf = malloc((size_t)len * item_size);
+    if (queue->buf == NULL) {
+        free(queue);
+        return NULL;
+    }
+    queue->len = len;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->mutex, NULL);
+    cond_init(&queue->not_empty);
+    cond_init(&queue->not_full);
+
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (queue == NULL)
+        return;
+
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->buf);
+    free(queue);
+}
+
+static BaseType_t queue_put(QueueHandle_t queue, const void *item, TickType_t ticks, bool front, bool overwrite) {
+    struct timespec deadline;
+    BaseType_t res = pdTRUE;
+
+    wait_deadline(ticks, &deadline);
+    pthread_mutex_lock(&queue->mutex);
+    pthread_cleanup_push(mutex_unlock_cleanup, &queue->mutex);
+
+    if (overwrite && queue->count == queue->len)
+        queue->count = 0;
+    while (queue->count == queue->len) {
+        if (!cond_wait(&queue->not_full, &queue->mutex, ticks, &deadline)) {
+            res = pdFALSE;
+            break;
+        }
+    }
+
+    if (res == pdTRUE) {
+        UBaseType_t slot;
+        if (front) {
+            queue->head = (queue->head + queue->len - 1) % queue->len;
+            slot = queue->head;
+        } else {
+            slot = (queue->head + queue->count) % queue->len;
+        }
+        memcpy(queue->buf + (size_t)slot * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_signal(&queue->not_empty);
+    }
+
+    pthread_cleanup_pop(1);
+    // on FreeRTOS a higher priority receiver runs right away, give it the chance here too
+    if (res == pdTRUE)
+        sched_yield();
+    return res;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_put(queue, item, ticks, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_put(queue, item, ticks, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    return queue_put(queue, item, 0, false, true);
+}
+
+static BaseType_t queue_get(QueueHandle_t queue, void *item, TickType_t ticks, bool peek) {
+    struct timespec deadline;
+    BaseType_t res = pdTRUE;
+
+    wait_deadline(ticks, &deadline);
+    pthread_mutex_lock(&queue->mutex);
+    pthread_cleanup_push(mutex_unlock_cleanup, &queue->mutex);
+
+    while (queue->count == 0) {
+        if (!cond_wait(&queue->not_empty, &queue->mutex, ticks, &deadline)) {
+            res = pdFALSE;
+            break;
+        }
+    }
+
+    if (res == pdTRUE) {
+        memcpy(item, queue->buf + (size_t)queue->head * queue->item_size, queue->item_size);
+        if (!peek) {
+            queue->head = (queue->head + 1) % queue->len;
+            queue->count--;
+            pthread_cond_signal(&queue->not_full);
+        }
+    }
+
+    pthread_cleanup_pop(1);
+    return res;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_get(queue, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_get(queue, item, ticks, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t spaces = queue->len - queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+
+    return spaces;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return pdPASS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// semaphores and mutexes
+
+struct host_sem {
+    pthread_mutex_t mutex; //
+    pthread_cond_t cond;   //
+    UBaseType_t count;     //
+    UBaseType_t max;       //
+    bool recursive;        //
+    pthread_t owner;       // recursive mutex
+    UBaseType_t depth;     //
+};
+
+static SemaphoreHandle_t sem_create(UBaseType_t max, UBaseType_t initial, bool recursive) {
+    struct host_sem *sem = calloc(1, sizeof(struct host_sem));
+
+    if (sem == NULL)
+        return NULL;
+
+    pthread_mutex_init(&sem->mutex, NULL);
+    cond_init(&sem->cond);
+    sem->max = max;
+    sem->count = initial;
+    sem->recursive = recursive;
+
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return sem_create(1, 1, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return sem_create(1, 1, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return sem_create(1, 0, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    return sem_create(max, initial, false);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    if (sem == NULL)
+        return;
+
+    pthread_mutex_destroy(&sem->mutex);
+    pthread_cond_destroy(&sem->cond);
+    free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    struct timespec deadline;
+    BaseType_t res = pdTRUE;
+
+    wait_deadline(ticks, &deadline);
+    pthread_mutex_lock(&sem->mutex);
+    pthread_cleanup_push(mutex_unlock_cleanup, &sem->mutex);
+
+    while (sem->count == 0) {
+        if (!cond_wait(&sem->cond, &sem->mutex, ticks, &deadline)) {
+            res = pdFALSE;
+            break;
+        }
+    }
+    if (res == pdTRUE)
+        sem->count--;
+
+    pthread_cleanup_pop(1);
+    return res;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    BaseType_t res = pdFALSE;
+
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->count < sem->max) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+
+    return res;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->depth > 0 && pthread_equal(sem->owner, pthread_self())) {
+        sem->depth++;
+        pthread_mutex_unlock(&sem->mutex);
+        return pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+
+    if (xSemaphoreTake(sem, ticks) != pdTRUE)
+        return pdFALSE;
+
+    pthread_mutex_lock(&sem->mutex);
+    sem->owner = pthread_self();
+    sem->depth = 1;
+    pthread_mutex_unlock(&sem->mutex);
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->depth == 0 || !pthread_equal(sem->owner, pthread_self())) {
+        pthread_mutex_unlock(&sem->mutex);
+        return pdFALSE;
+    }
+    bool last = --sem->depth == 0;
+    pthread_mutex_unlock(&sem->mutex);
+
+    return last ? xSemaphoreGive(sem) : pdTRUE;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem) {
+    pthread_mutex_lock(&sem->mutex);
+    UBaseType_t count = sem->count;
+    pthread_mutex_unlock(&sem->mutex);
+
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// task notifications, only the counting ones
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value;
+
+    // the value before the call: the count taken and the remaining ones, cleared or decremented
+    if (self == NULL || xSemaphoreTake(self->notify, ticks) != pdTRUE)
+        return 0;
+
+    pthread_mutex_lock(&self->notify->mutex);
+    value = self->notify->count + 1;
+    if (clear)
+        self->notify->count = 0;
+    pthread_mutex_unlock(&self->notify->mutex);
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    xSemaphoreGive(task->notify);
+    return pdPASS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// software timers
+
+struct host_timer {
+    char name[configMAX_TASK_NAME_LEN]; //
+    TickType_t period;                  //
+    bool reload;                        //
+    void *id;                           //
+    TimerCallbackFunction_t fn;         //
+    bool active;                        //
+    int64_t expiry;                     // host clock us
+    uint64_t order;                     // same expiry: in arming order
+    struct host_timer *next;            //
+};
+
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static pthread_cond_t timer_idle_cond;
+static struct host_timer *timer_list = NULL;
+static bool timer_idle = true;
+static uint64_t timer_order = 0;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+
+static struct host_timer *timer_first(void) {
+    struct host_timer *first = NULL;
+
+    for (struct host_timer *timer = timer_list; timer != NULL; timer = timer->next)
+        if (timer->active && (first == NULL || timer->expiry < first->expiry || (timer->expiry == first->expiry && timer->order < first->order)))
+            first = timer;
+
+    return first;
+}
+
+static void *timer_service(void *arg) {
+    pthread_mutex_lock(&timer_mutex);
+    while (1) {
+        struct host_timer *timer = timer_first();
+        int64_t now = clock_sim ? clock_sim_us : clock_mono_us();
+
+        if (timer != NULL && timer->expiry <= now) {
+            timer->active = timer->reload;
+            if (timer->reload) {
+                timer->expiry += (int64_t)timer->period * 1000;
+                timer->order = ++timer_order;
+            }
+            pthread_mutex_unlock(&timer_mutex);
+            timer->fn(timer);
+            pthread_mutex_lock(&timer_mutex);
+            continue;
+        }
+
+        timer_idle = true;
+        pthread_cond_broadcast(&timer_idle_cond);
+        if (clock_sim || timer == NULL) {
+            pthread_cond_wait(&timer_cond, &timer_mutex);
+        } else {
+            struct timespec deadline = clock_start;
+            int64_t ns = clock_start.tv_nsec + (timer->expiry % 1000000) * 1000;
+            deadline.tv_sec += timer->expiry / 1000000 + ns / 1000000000;
+            deadline.tv_nsec = ns % 1000000000;
+            pthread_cond_timedwait(&timer_cond, &timer_mutex, &deadline);
+        }
+    }
+
+    return NULL;
+}
+
+static void timer_init(void) {
+    pthread_t thread;
+
+    pthread_once(&clock_once, clock_init);
+    cond_init(&timer_cond);
+    cond_init(&timer_idle_cond);
+    pthread_create(&thread, NULL, timer_service, NULL);
+    pthread_detach(thread);
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t reload, void *id, TimerCallbackFunction_t fn) {
+    struct host_timer *timer = calloc(1, sizeof(struct host_timer));
+
+    if (timer == NULL || period == 0) {
+        free(timer);
+        return NULL;
+    }
+
+    pthread_once(&timer_once, timer_init);
+    strlcpy(timer->name, name != NULL ? name : "", sizeof(timer->name));
+    timer->period = period;
+    timer->reload = reload;
+    timer->id = id;
+    timer->fn = fn;
+
+    pthread_mutex_lock(&timer_mutex);
+    timer->next = timer_list;
+    timer_list = timer;
+    pthread_mutex_unlock(&timer_mutex);
+
+    return timer;
+}
+
+static BaseType_t timer_arm(TimerHandle_t timer, TickType_t period, bool active) {
+    pthread_mutex_lock(&timer_mutex);
+    if (period > 0)
+        timer->period = period;
+    timer->active = active;
+    timer->expiry = (clock_sim ? clock_sim_us : clock_mono_us()) + (int64_t)timer->period * 1000;
+    timer->order = ++timer_order;
+    pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_mutex);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks) {
+    return timer_arm(timer, 0, true);
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks) {
+    return timer_arm(timer, 0, true);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks) {
+    return timer_arm(timer, 0, false);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks) {
+    return period > 0 ? timer_arm(timer, period, true) : pdFAIL;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+    pthread_mutex_lock(&timer_mutex);
+    BaseType_t active = timer->active;
+    pthread_mutex_unlock(&timer_mutex);
+
+    return active;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks) {
+    pthread_mutex_lock(&timer_mutex);
+    for (struct host_timer **p = &timer_list; *p != NULL; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_mutex);
+    free(timer);
+
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) {
+    return timer->id;
+}
+
+void host_clock_simulate(time_t epoch) {
+    pthread_once(&timer_once, timer_init);
+
+    pthread_mutex_lock(&timer_mutex);
+    pthread_mutex_lock(&clock_mutex);
+    int64_t now = clock_sim ? clock_sim_us : clock_mono_us();
+    clock_sim = true;
+    clock_sim_us = now;
+    // same wall clock at the same simulated time, whatever it was when the simulation started
+    clock_epoch = epoch - now / 1000000;
+    clock_sim_us = now - now % 1000000;
+    pthread_mutex_unlock(&clock_mutex);
+    pthread_mutex_unlock(&timer_mutex);
+}
+
+void host_clock_advance(uint32_t ms) {
+    pthread_mutex_lock(&timer_mutex);
+    int64_t end = clock_sim_us + (int64_t)ms * 1000;
+
+    // step from deadline to deadline, each timer sees the clock at its own expiry
+    while (1) {
+        struct host_timer *timer = timer_first();
+        int64_t step = timer != NULL && timer->expiry > clock_sim_us && timer->expiry < end ? timer->expiry : end;
+
+        pthread_mutex_lock(&clock_mutex);
+        clock_sim_us = step;
+        pthread_mutex_unlock(&clock_mutex);
+
+        timer_idle = false;
+        pthread_cond_signal(&timer_cond);
+        while (!timer_idle)
+            pthread_cond_wait(&timer_idle_cond, &timer_mutex);
+
+        if (step == end)
+            break;
+    }
+    pthread_mutex_unlock(&timer_mutex);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// log, system
+
+static esp_log_level_t log_level = (esp_log_level_t)-1;
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void host_log(esp_log_level_t level, const char *tag, const char *fmt, ...) {
+    static const char letter[] = "NEWIDV";
+    va_list args;
+
+    if (log_level == (esp_log_level_t)-1) {
+        const char *env = getenv("HOST_TEST_LOG");
+        log_level = env != NULL ? (esp_log_level_t)atoi(env) : ESP_LOG_ERROR;
+    }
+    if (level > log_level)
+        return;
+
+    pthread_mutex_lock(&log_mutex);
+    fprintf(stderr, "%c (%lld) %s: ", letter[level], (long long)(host_clock_us() / 1000), tag);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&log_mutex);
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    log_level = level;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        default:
+            return "ERROR";
+    }
+}
+
+esp_reset_reason_t esp_reset_reason(void) {
+    return ESP_RST_POWERON;
+}
+
+void esp_restart(void) {
+    fprintf(stderr, "esp_restart\n");
+    exit(2);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    static uint32_t table[256];
+
+    // table driven, as in ROM
+    if (table[1] == 0) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    while (len--)
+        crc = table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+#ifdef HOST_COMPAT_STRLCPY
+size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+
+    if (size > 0) {
+        size_t copy = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+
+    return len;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size) {
+    size_t len = strnlen(dst, size);
+
+    return len == size ? size + strlen(src) : len + strlcpy(dst + len, src, size - len);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// network interface, heap, Wi-Fi
+
+static int host_netif_sta;
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *key) {
+    return strcmp(key, "WIFI_STA_DEF") == 0 ? (esp_netif_t *)&host_netif_sta : NULL;
+}
+
+esp_netif_t *esp_netif_get_default_netif(void) {
+    return (esp_netif_t *)&host_netif_sta;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *netif, esp_netif_ip_info_t *info) {
+    if (netif != (esp_netif_t *)&host_netif_sta)
+        return ESP_ERR_ESP_NETIF_INVALID_PARAMS;
+
+    memset(info, 0, sizeof(esp_netif_ip_info_t));
+    info->ip.addr = htonl(0x7f000001);
+    info->netmask.addr = htonl(0xff000000);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_netif_impl_name(esp_netif_t *netif, char *name) {
+    strcpy(name, "lo");
+    return ESP_OK;
+}
+
+bool esp_netif_is_netif_up(esp_netif_t *netif) {
+    return netif == (esp_netif_t *)&host_netif_sta;
+}
+
+static size_t heap_free = 200000;
+static size_t heap_min_free = 150000;
+static size_t heap_largest = 100000;
+
+void host_heap_set(size_t free_size, size_t min_free, size_t largest) {
+    heap_free = free_size;
+    heap_min_free = min_free;
+    heap_largest = largest;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return heap_free;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return heap_min_free;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_largest;
+}
+
+static bool wifi_connected = false;
+static int8_t wifi_rssi = 0;
+
+void host_wifi_rssi(bool connected, int8_t rssi) {
+    wifi_connected = connected;
+    wifi_rssi = rssi;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap) {
+    if (!wifi_connected)
+        return ESP_FAIL;
+
+    ap->rssi = wifi_rssi;
+    return ESP_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// UART, on file descriptors
+
+static int uart_fd[HOST_UART_PORTS] = { -1, -1, -1 };
+
+void host_uart_attach(int port, int fd) {
+    if (port >= 0 && port < HOST_UART_PORTS)
+        uart_fd[port] = fd;
+}
+
+static int uart_get_fd(uart_port_t port) {
+    return port >= 0 && port < HOST_UART_PORTS ? uart_fd[port] : -1;
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+    int fd = uart_get_fd(port);
+
+    if (fd < 0)
+        return ESP_ERR_INVALID_ARG;
+
+    tcflush(fd, TCIFLUSH);
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size) {
+    int fd = uart_get_fd(port);
+    size_t done = 0;
+
+    if (fd < 0)
+        return -1;
+
+    while (done < size) {
+        ssize_t len = write(fd, (const uint8_t *)src + done, size - done);
+        if (len < 0 && errno != EINTR)
+            return -1;
+        if (len > 0)
+            done += len;
+    }
+
+    return (int)done;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks) {
+    int fd = uart_get_fd(port);
+
+    if (fd < 0)
+        return ESP_ERR_INVALID_ARG;
+
+    tcdrain(fd);
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks) {
+    int fd = uart_get_fd(port);
+    int64_t end = host_clock_us() + (int64_t)ticks * 1000;
+    uint32_t done = 0;
+
+    if (fd < 0)
+        return -1;
+
+    while (done < length) {
+        int64_t left = end - host_clock_us();
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+        if (left <= 0 || poll(&pfd, 1, (int)((left + 999) / 1000)) <= 0)
+            break;
+
+        ssize_t len = read(fd, (uint8_t *)buf + done, length - done);
+        if (len < 0 && errno != EINTR && errno != EAGAIN)
+            return -1;
+        if (len > 0)
+            done += len;
+    }
+
+    return (int)done;
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    int64_t end = host_clock_us() + us;
+
+    // busy, as the ROM delay
+    while (host_clock_us() < end)
+        ;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// HTTP server
+
+typedef struct host_httpd_resp_s {
+    char *body;    //
+    size_t size;   //
+    size_t len;    //
+    size_t chunks; //
+    bool overflow; //
+    bool done;     // final chunk sent
+} host_httpd_resp_t;
+
+static httpd_uri_t httpd_handlers[HOST_HTTPD_HANDLERS];
+static uint32_t httpd_handlers_qty = 0;
+static uint32_t httpd_http_clients = 0;
+static uint32_t httpd_ws_clients = 0;
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri) {
+    if (httpd_handlers_qty == HOST_HTTPD_HANDLERS)
+        return ESP_ERR_NO_MEM;
+
+    httpd_handlers[httpd_handlers_qty++] = *uri;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t len) {
+    host_httpd_resp_t *resp = r->aux;
+
+    resp->chunks++;
+    if (buf == NULL || len == 0) {
+        resp->done = true;
+        return ESP_OK;
+    }
+    if (resp->done)
+        return ESP_FAIL;
+    if (resp->len + len >= resp->size) {
+        resp->overflow = true;
+        return ESP_FAIL;
+    }
+
+    memcpy(resp->body + resp->len, buf, len);
+    resp->len += len;
+    resp->body[resp->len] = '\0';
+
+    return ESP_OK;
+}
+
+void host_httpd_ws_clients(uint32_t http, uint32_t ws) {
+    httpd_http_clients = http;
+    httpd_ws_clients = ws;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds) {
+    size_t qty = 0;
+
+    for (uint32_t n = 0; n < httpd_http_clients + httpd_ws_clients && qty < *fds; n++)
+        client_fds[qty++] = (int)n;
+    *fds = qty;
+
+    return ESP_OK;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int sockfd) {
+    return (uint32_t)sockfd < httpd_http_clients ? HTTPD_WS_CLIENT_HTTP : HTTPD_WS_CLIENT_WEBSOCKET;
+}
+
+esp_err_t host_httpd_get(const char *uri, char *body, size_t size, size_t *chunks) {
+    host_httpd_resp_t resp = { .body = body, .size = size };
+    httpd_req_t req = { .handle = &httpd_handlers, .method = HTTP_GET, .uri = uri, .aux = &resp };
+
+    if (size == 0)
+        return ESP_ERR_INVALID_SIZE;
+    body[0] = '\0';
+
+    for (uint32_t n = 0; n < httpd_handlers_qty; n++) {
+        if (httpd_handlers[n].method != HTTP_GET || strcmp(httpd_handlers[n].uri, uri) != 0)
+            continue;
+
+        req.user_ctx = httpd_handlers[n].user_ctx;
+        esp_err_t err = httpd_handlers[n].handler(&req);
+        if (chunks != NULL)
+            *chunks = resp.chunks;
+
+        return resp.overflow ? ESP_ERR_INVALID_SIZE : err;
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
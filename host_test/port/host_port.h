@@ -0,0 +1,116 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef HOST_PORT_H_
+#define HOST_PORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "esp_err.h"
+
+/**
+ * @fn void host_clock_simulate(time_t)
+ * @brief Stop the host clock: xTaskGetTickCount, esp_timer_get_time, gettimeofday and the FreeRTOS timers only move
+ *        with host_clock_advance from now on
+ *
+ * @param epoch Wall clock (gettimeofday) at the simulated time 0
+ */
+void host_clock_simulate(time_t epoch);
+
+/**
+ * @fn void host_clock_advance(uint32_t)
+ * @brief Move the simulated clock, running every timer callback due on the way in order. Returns once the timer
+ *        service is idle again.
+ *
+ * @param ms Milliseconds
+ */
+void host_clock_advance(uint32_t ms);
+
+/**
+ * @fn int64_t host_clock_us(void)
+ * @brief Host clock: monotonic since start, or simulated
+ *
+ * @return Microseconds
+ */
+int64_t host_clock_us(void);
+
+/**
+ * @fn void host_heap_set(size_t, size_t, size_t)
+ * @brief Values returned by heap_caps_get_free_size, heap_caps_get_minimum_free_size and
+ *        heap_caps_get_largest_free_block
+ *
+ * @param free_size Free heap
+ * @param min_free Minimum free heap
+ * @param largest Largest free block
+ */
+void host_heap_set(size_t free_size, size_t min_free, size_t largest);
+
+/**
+ * @fn void host_wifi_rssi(bool, int8_t)
+ * @brief Station link reported by esp_wifi_sta_get_ap_info
+ *
+ * @param connected Associated
+ * @param rssi Signal
+ */
+void host_wifi_rssi(bool connected, int8_t rssi);
+
+/**
+ * @fn void host_httpd_ws_clients(uint32_t, uint32_t)
+ * @brief Clients reported by httpd_get_client_list and httpd_ws_get_fd_info
+ *
+ * @param http Plain HTTP clients
+ * @param ws Websocket clients
+ */
+void host_httpd_ws_clients(uint32_t http, uint32_t ws);
+
+/**
+ * @fn esp_err_t host_httpd_get(const char*, char*, size_t, size_t*)
+ * @brief Call the GET handler registered for the URI and collect its chunked response
+ *
+ * @param uri URI
+ * @param body Response body, NUL terminated
+ * @param size body size
+ * @param chunks Chunks sent, the final empty one included. NULL: not needed
+ * @return Handler result, ESP_ERR_NOT_FOUND without a handler, ESP_ERR_INVALID_SIZE if the body did not fit
+ */
+esp_err_t host_httpd_get(const char *uri, char *body, size_t size, size_t *chunks);
+
+/**
+ * @fn void host_uart_attach(int, int)
+ * @brief Serve a UART port from a file descriptor, the slave side of a pseudo terminal in raw mode
+ *
+ * @param port UART port
+ * @param fd File descriptor, -1: detached
+ */
+void host_uart_attach(int port, int fd);
+
+#endif /* HOST_PORT_H_ */
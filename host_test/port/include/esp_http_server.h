@@ -0,0 +1,74 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef HOST_ESP_HTTP_SERVER_H_
+#define HOST_ESP_HTTP_SERVER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+// no sockets: handlers are called by host_httpd_get(), the response is collected in memory
+
+typedef void *httpd_handle_t;
+
+typedef enum {
+    HTTP_GET = 1,  //
+    HTTP_POST = 3, //
+} httpd_method_t;
+
+typedef struct httpd_req {
+    httpd_handle_t handle; //
+    int method;            //
+    const char *uri;       //
+    void *user_ctx;        //
+    void *aux;             //
+} httpd_req_t;
+
+typedef struct httpd_uri {
+    const char *uri;                           //
+    httpd_method_t method;                     //
+    esp_err_t (*handler)(httpd_req_t *r);      //
+    void *user_ctx;                            //
+} httpd_uri_t;
+
+typedef enum {
+    HTTPD_WS_CLIENT_INVALID,   //
+    HTTPD_WS_CLIENT_HTTP,      //
+    HTTPD_WS_CLIENT_WEBSOCKET, //
+} httpd_ws_client_info_t;
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri);
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t len);
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds);
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int sockfd);
+
+#endif /* HOST_ESP_HTTP_SERVER_H_ */
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// ADC filtering on the synthetic source: oversampling, moving average and IIR step responses, scaling, the noise left
+// on the published value, and the CPU cost per raw sample
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "ladder_adc_filter.h"
+
+#define SAMPLE_HZ 20000 // ladder_adc_default()
+
+static ladder_adc_config_t config;
+static const ladder_adc_channel_t raw_counts = { .enabled = true };
+
+static void configure(uint8_t filter, uint16_t oversample) {
+    memset(&config, 0, sizeof(config));
+    config.source = LADDER_ADC_SIM;
+    config.sample_hz = SAMPLE_HZ;
+    config.oversample = oversample;
+    config.filter = filter;
+    config.window = 8;
+    config.iir_shift = 3;
+    ladder_adc_filter_limits(&config);
+}
+
+// one filter input, "oversample" equal raw samples
+static int32_t step(ladder_adc_input_t *input, int32_t x) {
+    for (uint32_t n = 0; n < config.oversample; n++)
+        ladder_adc_filter_sample(input, &config, &raw_counts, x);
+
+    return input->value;
+}
+
+// ns per raw sample of the synthetic source through the filter
+static double cost(uint8_t filter, uint16_t oversample) {
+    ladder_adc_input_t input[LADDER_ADC_CHANNELS];
+    ladder_adc_sim_t sim;
+    uint32_t channel, published = 0;
+
+    configure(filter, oversample);
+    memset(input, 0, sizeof(input));
+    ladder_adc_sim_init(&sim, SAMPLE_HZ);
+    int64_t start = test_now_us();
+    for (uint32_t n = 0; n < 50 * SAMPLE_HZ; n++) {
+        int32_t sample = ladder_adc_sim_sample(&sim, &channel);
+        published += ladder_adc_filter_sample(&input[channel], &config, &raw_counts, sample);
+    }
+    CHECK_EQ(published, 50 * SAMPLE_HZ / oversample);
+
+    return (test_now_us() - start) * 1000.0 / (50 * SAMPLE_HZ);
+}
+
+int main(void) {
+    ladder_adc_input_t input;
+
+    // limits
+    configure(LADDER_ADC_FILTER_AVG, 0);
+    CHECK_EQ(config.oversample, 1);
+    config.oversample = 1000;
+    config.window = 0;
+    config.iir_shift = 20;
+    ladder_adc_filter_limits(&config);
+    CHECK_EQ(config.oversample, LADDER_ADC_OVERSAMPLE);
+    CHECK_EQ(config.window, 1);
+    CHECK_EQ(config.iir_shift, 15);
+    config.window = 200;
+    ladder_adc_filter_limits(&config);
+    CHECK_EQ(config.window, LADDER_ADC_WINDOW_MAX);
+
+    // oversampling: one value per 16 samples, rounded
+    configure(LADDER_ADC_FILTER_NONE, 16);
+    memset(&input, 0, sizeof(input));
+    for (int32_t n = 1; n < 16; n++)
+        CHECK(!ladder_adc_filter_sample(&input, &config, &raw_counts, n));
+    CHECK(ladder_adc_filter_sample(&input, &config, &raw_counts, 16));
+    CHECK_EQ(input.raw, 9);
+    CHECK_EQ(input.value, 9);
+
+    // moving average: no start-up bias, then a step reaches its value in "window" inputs
+    configure(LADDER_ADC_FILTER_AVG, 4);
+    memset(&input, 0, sizeof(input));
+    CHECK_EQ(step(&input, 1000), 1000);
+    for (int n = 1; n < 8; n++)
+        step(&input, 1000);
+    for (int n = 1; n <= 8; n++)
+        CHECK_EQ(step(&input, 1800), 1000 + 100 * n);
+    CHECK_EQ(input.raw, 1800);
+
+    // IIR: 1/8 of the error per input, settles exactly
+    configure(LADDER_ADC_FILTER_IIR, 1);
+    memset(&input, 0, sizeof(input));
+    CHECK_EQ(step(&input, 0), 0);
+    CHECK_EQ(step(&input, 800), 100);
+    CHECK_EQ(step(&input, 800), 188);
+    for (int n = 0; n < 100; n++)
+        step(&input, 800);
+    CHECK_EQ(input.value, 800);
+    for (int n = 0; n < 100; n++)
+        step(&input, 0);
+    CHECK_EQ(input.value, 0);
+
+    // scaling to engineering units, reversed ranges too
+    const ladder_adc_channel_t volts = { .enabled = true, .raw_min = 0, .raw_max = 4095, .eng_min = 0, .eng_max = 10000 };
+    const ladder_adc_channel_t reversed = { .enabled = true, .raw_min = 4095, .raw_max = 0, .eng_min = -100, .eng_max = 100 };
+    configure(LADDER_ADC_FILTER_NONE, 1);
+    memset(&input, 0, sizeof(input));
+    ladder_adc_filter_sample(&input, &config, &volts, 4095);
+    CHECK_EQ(input.value, 10000);
+    ladder_adc_filter_sample(&input, &config, &volts, 2048);
+    CHECK_EQ(input.value, 5001);
+    CHECK_EQ(input.raw, 2048);
+    ladder_adc_filter_sample(&input, &config, &reversed, 4095);
+    CHECK_EQ(input.value, -100);
+    ladder_adc_filter_sample(&input, &config, &reversed, 0);
+    CHECK_EQ(input.value, 100);
+
+    // synthetic source: interleaved channels, a full scale triangle of 1 s, noise around mid-scale
+    ladder_adc_sim_t sim;
+    uint32_t channel, expected = 0;
+    int32_t tri_min = INT32_MAX, tri_max = INT32_MIN, tri_last = -1, noise_dev = 0;
+    ladder_adc_sim_init(&sim, SAMPLE_HZ);
+    for (uint32_t n = 0; n < SAMPLE_HZ; n++) {
+        int32_t sample = ladder_adc_sim_sample(&sim, &channel);
+        CHECK_EQ(channel, expected);
+        expected = (expected + 1) % LADDER_ADC_CHANNELS;
+        if (channel == 0) {
+            CHECK(tri_last < 0 || abs(sample - tri_last) <= 2 * LADDER_ADC_SIM_FULL * LADDER_ADC_CHANNELS / SAMPLE_HZ + 1);
+            tri_min = sample < tri_min ? sample : tri_min;
+            tri_max = sample > tri_max ? sample : tri_max;
+            tri_last = sample;
+        } else if (abs(sample - LADDER_ADC_SIM_FULL / 2) > noise_dev) {
+            noise_dev = abs(sample - LADDER_ADC_SIM_FULL / 2);
+        }
+    }
+    CHECK_EQ(tri_min, 0);
+    CHECK_EQ(tri_max, LADDER_ADC_SIM_FULL);
+    CHECK(noise_dev >= 60 && noise_dev <= 64);
+
+    // the default filter takes most of the noise off the published value (consecutive LFSR samples are correlated,
+    // averaging them gains less than on white noise)
+    ladder_adc_input_t filtered[LADDER_ADC_CHANNELS];
+    int32_t filtered_dev = 0;
+    configure(LADDER_ADC_FILTER_AVG, 16);
+    memset(filtered, 0, sizeof(filtered));
+    ladder_adc_sim_init(&sim, SAMPLE_HZ);
+    for (uint32_t n = 0; n < 10 * SAMPLE_HZ; n++) {
+        int32_t sample = ladder_adc_sim_sample(&sim, &channel);
+        if (ladder_adc_filter_sample(&filtered[channel], &config, &raw_counts, sample) && channel == 1 &&
+            abs(filtered[1].value - LADDER_ADC_SIM_FULL / 2) > filtered_dev)
+            filtered_dev = abs(filtered[1].value - LADDER_ADC_SIM_FULL / 2);
+    }
+    CHECK(filtered_dev * 2 < noise_dev);
+    printf("noise %d counts raw, %d counts filtered\n", noise_dev, filtered_dev);
+
+    printf("per raw sample: none %.1f ns, avg %.1f ns, iir %.1f ns, avg without oversampling %.1f ns\n", cost(LADDER_ADC_FILTER_NONE, 16),
+           cost(LADDER_ADC_FILTER_AVG, 16), cost(LADDER_ADC_FILTER_IIR, 16), cost(LADDER_ADC_FILTER_AVG, 1));
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Analog outputs against a mock that records the hardware updates of every scan: change-only updates, clamping and
+// scaling, ramp limiting, and the update log
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "ladder_aout_channel.h"
+
+#define SCAN_US 10000 // scan period simulated
+#define SCANS   1000  //
+
+// the mock backend: hardware updates per scan and the last duty written
+typedef struct mock_s {
+    ladder_aout_config_t config;  //
+    ladder_aout_channel_t state;  //
+    uint32_t scan_updates[SCANS]; //
+    uint32_t duty;                // as written
+    uint32_t writes;              //
+} mock_t;
+
+static ladder_aout_log_ring_t ring;
+
+static void mock_init(mock_t *mock, uint8_t mode, uint8_t resolution, int32_t qw_min, int32_t qw_max, uint32_t ramp) {
+    memset(mock, 0, sizeof(mock_t));
+    mock->config.mode = mode;
+    mock->config.resolution = resolution;
+    mock->config.freq_hz = 5000;
+    mock->config.qw_min = qw_min;
+    mock->config.qw_max = qw_max;
+    mock->config.ramp = ramp;
+    ladder_aout_channel_reset(&mock->state, &mock->config);
+}
+
+// ladder_aout_write() of one output
+static void mock_scan(mock_t *mock, uint32_t scan, int32_t qw) {
+    mock->state.scan_updates = 0;
+    if (ladder_aout_channel_update(&mock->state, &mock->config, qw, scan == 0 ? 0 : SCAN_US)) {
+        mock->duty = mock->state.duty;
+        mock->writes++;
+        ladder_aout_log_add(&ring, scan, 0, mock->duty);
+    }
+    mock->scan_updates[scan % SCANS] = mock->state.scan_updates;
+}
+
+static uint32_t updates(const mock_t *mock, uint32_t from, uint32_t to) {
+    uint32_t total = 0;
+
+    for (uint32_t n = from; n < to; n++)
+        total += mock->scan_updates[n];
+
+    return total;
+}
+
+int main(void) {
+    static mock_t mock;
+
+    // scaling, rounded to the nearest duty
+    mock_init(&mock, LADDER_AOUT_PWM, 10, 0, 10000, 0);
+    CHECK_EQ(ladder_aout_channel_duty(&mock.config, 0), 0);
+    CHECK_EQ(ladder_aout_channel_duty(&mock.config, 5000), 512);
+    CHECK_EQ(ladder_aout_channel_duty(&mock.config, 10000), 1024);
+    CHECK_EQ(ladder_aout_channel_duty(&mock.config, 4), 0);
+    CHECK_EQ(ladder_aout_channel_duty(&mock.config, 5), 1);
+
+    // a constant QW is written once
+    for (uint32_t scan = 0; scan < SCANS; scan++)
+        mock_scan(&mock, scan, 5000);
+    CHECK_EQ(mock.scan_updates[0], 1);
+    CHECK_EQ(updates(&mock, 1, SCANS), 0);
+    CHECK_EQ(mock.duty, 512);
+
+    // changes below one duty step are not written, the others once each
+    for (uint32_t scan = 0; scan < SCANS; scan++)
+        mock_scan(&mock, scan, 5000 + (scan % 2) * 4);
+    CHECK_EQ(updates(&mock, 0, SCANS), 0);
+    for (uint32_t scan = 0; scan < SCANS; scan++)
+        mock_scan(&mock, scan, scan / 100 * 1000);
+    CHECK_EQ(updates(&mock, 0, SCANS), 10);
+    CHECK_EQ(mock.duty, ladder_aout_channel_duty(&mock.config, 9000));
+
+    // out of range values are clamped, reversed and DAC mappings
+    mock_scan(&mock, 0, 20000);
+    CHECK_EQ(mock.duty, 1024);
+    mock_scan(&mock, 1, -20000);
+    CHECK_EQ(mock.duty, 0);
+    mock_init(&mock, LADDER_AOUT_PWM, 8, 100, 0, 0);
+    mock_scan(&mock, 0, 100);
+    CHECK_EQ(mock.writes, 0);
+    mock_scan(&mock, 1, 0);
+    CHECK_EQ(mock.duty, 256);
+    mock_init(&mock, LADDER_AOUT_DAC, 0, 0, LADDER_AOUT_DAC_FULL, 0);
+    mock_scan(&mock, 0, 1000);
+    CHECK_EQ(mock.duty, LADDER_AOUT_DAC_FULL);
+
+    // ramp of 2000 units per second: a 0 to 10000 step takes 5 s, one small update per scan, and turns back at once
+    mock_init(&mock, LADDER_AOUT_PWM, 10, 0, 10000, 2000);
+    uint32_t max_step = 0, last = 0;
+    for (uint32_t scan = 0; scan < SCANS; scan++) {
+        mock_scan(&mock, scan, 10000);
+        if (mock.duty - last > max_step)
+            max_step = mock.duty - last;
+        last = mock.duty;
+        if (scan == 500)
+            CHECK_EQ(mock.state.current, 10000 * 1000);
+        if (scan == 499)
+            CHECK(mock.state.current < 10000 * 1000);
+    }
+    CHECK_EQ(updates(&mock, 1, 501), 500);
+    CHECK_EQ(updates(&mock, 501, SCANS), 0);
+    CHECK(max_step <= 3);
+    mock_scan(&mock, 1, 0);
+    CHECK_EQ(mock.state.current, 9980 * 1000);
+
+    // the log keeps the newest updates, oldest first
+    ladder_aout_log_t log[LADDER_AOUT_LOG];
+    memset(&ring, 0, sizeof(ring));
+    CHECK_EQ(ladder_aout_log_copy(&ring, log, LADDER_AOUT_LOG), 0);
+    for (uint32_t n = 1; n <= 40; n++)
+        ladder_aout_log_add(&ring, n, n % 2, n * 10);
+    CHECK_EQ(ladder_aout_log_copy(&ring, log, LADDER_AOUT_LOG), LADDER_AOUT_LOG);
+    for (uint32_t n = 0; n < LADDER_AOUT_LOG; n++) {
+        CHECK_EQ(log[n].scan, 40 - LADDER_AOUT_LOG + 1 + n);
+        CHECK_EQ(log[n].duty, log[n].scan * 10);
+        CHECK_EQ(log[n].qw, log[n].scan % 2);
+    }
+    CHECK_EQ(ladder_aout_log_copy(&ring, log, 5), 5);
+    CHECK_EQ(log[0].scan, 36);
+    CHECK_EQ(log[4].scan, 40);
+
+    // scan cost of an output, unchanged and ramping
+    mock_init(&mock, LADDER_AOUT_PWM, 10, 0, 10000, 0);
+    int64_t start = test_now_us();
+    for (uint32_t n = 0; n < 1000000; n++)
+        mock_scan(&mock, n, 5000);
+    double still_ns = (test_now_us() - start) / 1000.0;
+    mock_init(&mock, LADDER_AOUT_PWM, 20, 0, 1000000000, 100000);
+    start = test_now_us();
+    for (uint32_t n = 0; n < 1000000; n++)
+        mock_scan(&mock, n, 1000000000);
+    double ramp_ns = (test_now_us() - start) / 1000.0;
+    CHECK_EQ(mock.writes, 1000000 - 1);
+    printf("per output and scan: %.1f ns unchanged, %.1f ns ramping\n", still_ns, ramp_ns);
+
+    return TEST_RESULT();
+}
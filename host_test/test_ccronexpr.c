@@ -0,0 +1,127 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// cron_next and cron_prev against the bit-per-bit implementation they replace (ccronexpr_ref)
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccronexpr.h"
+#include "ccronexpr_ref.h"
+#include "cron_corpus.h"
+#include "host_test.h"
+
+#define DATES_RANDOM 16   // start dates per expression, besides the fixed ones
+#define CHAIN        8    // consecutive fire times followed from each start date
+
+// month and year boundaries, leap days, the end of the 32-bit range
+static const time_t dates_fixed[] = {
+    0,          // 1970-01-01
+    951782399,  // 2000-02-28 23:59:59
+    951868799,  // 2000-02-29 23:59:59
+    1709164800, // 2024-02-29 00:00:00
+    1735689599, // 2024-12-31 23:59:59
+    1767225600, // 2026-01-01 00:00:00
+    4102444799, // 2099-12-31 23:59:59
+    2147483000, // close to 2038-01-19
+};
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static uint32_t mismatches = 0;
+
+static void compare(const char *expr_text, cron_expr_t *expr, cron_ref_expr_t *ref, time_t date, bool with_prev) {
+    time_t next = date, ref_next = date;
+    time_t prev = date, ref_prev = date;
+
+    for (int n = 0; n < CHAIN; n++) {
+        next = cron_next(expr, next);
+        ref_next = cron_ref_next(ref, ref_next);
+        if (next != ref_next) {
+            if (mismatches++ < 10)
+                fprintf(stderr, "\"%s\" next from %lld: %lld, reference %lld\n", expr_text, (long long)date, (long long)next, (long long)ref_next);
+            host_test_failures++;
+            return;
+        }
+        if (next == (time_t)-1)
+            break;
+    }
+
+    for (int n = 0; n < CHAIN && with_prev; n++) {
+        prev = cron_prev(expr, prev);
+        ref_prev = cron_ref_prev(ref, ref_prev);
+        if (prev != ref_prev) {
+            if (mismatches++ < 10)
+                fprintf(stderr, "\"%s\" prev from %lld: %lld, reference %lld\n", expr_text, (long long)date, (long long)prev, (long long)ref_prev);
+            host_test_failures++;
+            return;
+        }
+        if (prev == (time_t)-1)
+            break;
+    }
+}
+
+int main(void) {
+    uint32_t valid = 0, calls = 0;
+
+    for (size_t e = 0; e < CRON_CORPUS_QTY; e++) {
+        const char *err = NULL, *ref_err = NULL;
+        cron_expr_t expr;
+        cron_ref_expr_t ref;
+
+        cron_parse_expr(cron_corpus[e].expr, &expr, &err);
+        cron_ref_parse_expr(cron_corpus[e].expr, &ref, &ref_err);
+        if ((err == NULL) != (ref_err == NULL)) {
+            fprintf(stderr, "\"%s\": error \"%s\", reference \"%s\"\n", cron_corpus[e].expr, err ? err : "", ref_err ? ref_err : "");
+            host_test_failures++;
+            continue;
+        }
+        if (err != NULL)
+            continue;
+
+        valid++;
+        for (size_t d = 0; d < sizeof(dates_fixed) / sizeof(dates_fixed[0]); d++)
+            compare(cron_corpus[e].expr, &expr, &ref, dates_fixed[d], cron_corpus[e].prev);
+        for (int d = 0; d < DATES_RANDOM; d++)
+            compare(cron_corpus[e].expr, &expr, &ref, (time_t)(rng() % 4102444800ULL), cron_corpus[e].prev);
+        calls += (sizeof(dates_fixed) / sizeof(dates_fixed[0]) + DATES_RANDOM) * CHAIN * (cron_corpus[e].prev ? 2 : 1);
+    }
+
+    printf("%u of %zu expressions valid, up to %u cron_next/cron_prev calls compared\n", valid, CRON_CORPUS_QTY, calls);
+    CHECK(valid > 20);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// cron dispatch on the simulated clock: fire times, single and batched jobs, hundreds of jobs due at once, enable and
+// delete
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "cron.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define START_EPOCH 1767225600 // 2026-01-01 00:00:00 UTC, a Thursday
+#define EVENTS_MAX  512
+#define VALUES_MAX  32
+#define BURST       400 // jobs of each kind due at the same second
+
+typedef struct event_s {
+    time_t time;                 // simulated time of the call
+    int fn;                      // 0: single, 1/2: batch functions
+    uint32_t values[VALUES_MAX]; // the first ones
+    uint32_t qty;                // values kept
+    uint32_t total;              // values passed
+} event_t;
+
+static pthread_mutex_t events_mutex = PTHREAD_MUTEX_INITIALIZER;
+static event_t events[EVENTS_MAX];
+static uint32_t events_qty = 0;
+
+static void record(int fn, const uint32_t *values, uint32_t qty) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    pthread_mutex_lock(&events_mutex);
+    if (events_qty < EVENTS_MAX) {
+        event_t *event = &events[events_qty++];
+        event->time = tv.tv_sec;
+        event->fn = fn;
+        event->qty = qty < VALUES_MAX ? qty : VALUES_MAX;
+        event->total = qty;
+        memcpy(event->values, values, event->qty * sizeof(uint32_t));
+    }
+    pthread_mutex_unlock(&events_mutex);
+}
+
+static void job(uint32_t value) {
+    record(0, &value, 1);
+}
+
+static void batch_a(const uint32_t *values, uint32_t qty) {
+    record(1, values, qty);
+}
+
+static void batch_b(const uint32_t *values, uint32_t qty) {
+    record(2, values, qty);
+}
+
+static uint32_t events_count(void) {
+    pthread_mutex_lock(&events_mutex);
+    uint32_t qty = events_qty;
+    pthread_mutex_unlock(&events_mutex);
+
+    return qty;
+}
+
+static void events_clear(void) {
+    pthread_mutex_lock(&events_mutex);
+    events_qty = 0;
+    pthread_mutex_unlock(&events_mutex);
+}
+
+static time_t sim_now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec;
+}
+
+// move the simulated clock to an absolute time and hold it there while the execute task runs the callbacks
+static void advance_to(time_t time) {
+    host_clock_advance((uint32_t)(time - sim_now()) * 1000);
+    usleep(20000);
+}
+
+static bool has_value(const event_t *event, uint32_t value) {
+    for (uint32_t n = 0; n < event->qty; n++)
+        if (event->values[n] == value)
+            return true;
+
+    return false;
+}
+
+static void test_single(void) {
+    int32_t every_5m = cron_add("0 */5 * * * *", job, 5);
+    int32_t at_0130 = cron_add("30 1 0 * * *", job, 130);
+
+    CHECK(every_5m >= 0 && at_0130 >= 0);
+    CHECK(cron_add("not a cron expression", job, 0) < 0);
+    CHECK(cron_add("* * * * * *", NULL, 0) < 0);
+
+    // fire times are exact, and nothing fires in between
+    advance_to(START_EPOCH + 89);
+    CHECK_EQ(events_count(), 0);
+    advance_to(START_EPOCH + 90);
+    CHECK_EQ(events_count(), 1);
+    CHECK(events[0].time == START_EPOCH + 90 && events[0].fn == 0 && events[0].values[0] == 130);
+    for (uint32_t n = 1; n <= 3; n++) {
+        advance_to(START_EPOCH + n * 300 - 1);
+        CHECK_EQ(events_count(), n);
+        advance_to(START_EPOCH + n * 300);
+        CHECK_EQ(events_count(), n + 1);
+        CHECK(events[n].time == START_EPOCH + n * 300 && events[n].fn == 0 && events[n].qty == 1 && events[n].values[0] == 5);
+    }
+    events_clear();
+
+    // disabled jobs don't fire, enabled again they resume at their next time
+    CHECK_EQ(cron_enable(every_5m, false), ESP_OK);
+    advance_to(START_EPOCH + 25 * 60);
+    CHECK_EQ(events_count(), 0);
+    CHECK_EQ(cron_enable(every_5m, true), ESP_OK);
+    advance_to(START_EPOCH + 30 * 60);
+    CHECK_EQ(events_count(), 1);
+    CHECK_EQ(events[0].time, START_EPOCH + 30 * 60);
+    events_clear();
+
+    CHECK_EQ(cron_delete(every_5m), ESP_OK);
+    CHECK_EQ(cron_delete(at_0130), ESP_OK);
+    CHECK(cron_delete(at_0130) != ESP_OK);
+    CHECK(cron_enable(at_0130, true) != ESP_OK);
+    advance_to(START_EPOCH + 40 * 60);
+    CHECK_EQ(events_count(), 0);
+}
+
+// 00:40:00 on entry
+static void test_batch(void) {
+    int32_t ids[24];
+    uint32_t qty = 0;
+
+    // due at the same time: one call per batch function with every value, single jobs one call each
+    for (uint32_t n = 0; n < 10; n++)
+        ids[qty++] = cron_add_batch("0 45 * * * *", batch_a, n);
+    for (uint32_t n = 100; n < 104; n++)
+        ids[qty++] = cron_add_batch("0 45 * * * *", batch_b, n);
+    for (uint32_t n = 200; n < 203; n++)
+        ids[qty++] = cron_add("0 45 * * * *", job, n);
+    // one second later: a call of its own
+    ids[qty++] = cron_add_batch("1 45 * * * *", batch_a, 50);
+
+    advance_to(START_EPOCH + 45 * 60);
+    CHECK_EQ(events_count(), 5);
+
+    uint32_t a = 0, b = 0, single = 0;
+    for (uint32_t n = 0; n < events_count(); n++) {
+        event_t *event = &events[n];
+        uint32_t found = 0;
+        CHECK_EQ(event->time, START_EPOCH + 45 * 60);
+        if (event->fn == 1) {
+            a++;
+            for (uint32_t v = 0; v < 10; v++)
+                found += has_value(event, v);
+            CHECK(event->qty == 10 && found == 10);
+        } else if (event->fn == 2) {
+            b++;
+            for (uint32_t v = 100; v < 104; v++)
+                found += has_value(event, v);
+            CHECK(event->qty == 4 && found == 4);
+        } else {
+            single++;
+            CHECK(event->qty == 1 && event->values[0] >= 200 && event->values[0] < 203);
+        }
+    }
+    CHECK_EQ(a, 1);
+    CHECK_EQ(b, 1);
+    CHECK_EQ(single, 3);
+
+    advance_to(START_EPOCH + 45 * 60 + 1);
+    CHECK_EQ(events_count(), 6);
+    CHECK(events[5].fn == 1 && events[5].qty == 1 && events[5].values[0] == 50);
+    events_clear();
+
+    for (uint32_t n = 0; n < qty; n++)
+        CHECK_EQ(cron_delete(ids[n]), ESP_OK);
+}
+
+// 00:45:01 on entry: far more jobs due in the same second than any fixed queue would hold, none is lost
+static void test_burst(void) {
+    static int32_t ids[2 * BURST];
+    uint32_t single = 0, batch = 0, batch_values = 0;
+
+    for (uint32_t n = 0; n < BURST; n++) {
+        ids[2 * n] = cron_add("0 50 * * * *", job, n);
+        ids[2 * n + 1] = cron_add_batch("0 50 * * * *", batch_a, n);
+        CHECK(ids[2 * n] >= 0 && ids[2 * n + 1] >= 0);
+    }
+
+    advance_to(START_EPOCH + 50 * 60);
+    CHECK_EQ(events_count(), BURST + 1);
+    for (uint32_t n = 0; n < events_count(); n++) {
+        CHECK_EQ(events[n].time, START_EPOCH + 50 * 60);
+        if (events[n].fn == 0)
+            single++;
+        else if (events[n].fn == 1) {
+            batch++;
+            batch_values += events[n].total;
+        }
+    }
+    CHECK_EQ(single, BURST);
+    CHECK_EQ(batch, 1);
+    CHECK_EQ(batch_values, BURST);
+    events_clear();
+
+    // and again at the next hour, from the buffers grown by the first burst
+    advance_to(START_EPOCH + 110 * 60);
+    CHECK_EQ(events_count(), BURST + 1);
+    events_clear();
+
+    for (uint32_t n = 0; n < 2 * BURST; n++)
+        CHECK_EQ(cron_delete(ids[n]), ESP_OK);
+}
+
+// time zone: expressions are local time
+static void test_tz(void) {
+    cron_stop();
+    CHECK_EQ(cron_start(2), ESP_OK);
+
+    // next local midnight
+    time_t due = ((sim_now() + 2 * 3600) / 86400 + 1) * 86400 - 2 * 3600;
+
+    CHECK(cron_add("0 0 0 * * *", job, 7) >= 0);
+    advance_to(due - 1);
+    CHECK_EQ(events_count(), 0);
+    advance_to(due);
+    CHECK_EQ(events_count(), 1);
+    CHECK_EQ(events[0].time, due);
+    events_clear();
+}
+
+int main(void) {
+    host_clock_simulate(START_EPOCH);
+    CHECK_EQ(cron_start(0), ESP_OK);
+
+    test_single();
+    test_batch();
+    test_burst();
+    test_tz();
+
+    cron_stop();
+    return TEST_RESULT();
+}
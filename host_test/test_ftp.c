@@ -0,0 +1,200 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// REST, SIZE, MDTM and MLSD as used by an incremental sync client
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "ftp_client.h"
+#include "ftpserver.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define MDTM_EPOCH 1704164645 // 2024-01-02 03:04:05 UTC
+
+static char mount[] = "/tmp/test_ftp.XXXXXX";
+static char data[4096];
+static char buf[8192];
+
+static void local_path(char *path, size_t size, const char *name) {
+    snprintf(path, size, "%s/%s", mount, name);
+}
+
+static void local_write(const char *name, const char *mode, const char *src, size_t len) {
+    char path[64];
+
+    local_path(path, sizeof(path), name);
+    FILE *fp = fopen(path, mode);
+    CHECK(fp != NULL);
+    if (fp == NULL)
+        return;
+    fwrite(src, 1, len, fp);
+    fclose(fp);
+}
+
+static size_t local_read(const char *name, char *dst, size_t size) {
+    char path[64];
+
+    local_path(path, sizeof(path), name);
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return 0;
+    size_t len = fread(dst, 1, size, fp);
+    fclose(fp);
+
+    return len;
+}
+
+// the MLSD line of one entry, NULL if it is not listed
+static const char* mlsd_entry(const char *listing, const char *name, char *line, size_t size) {
+    for (const char *p = listing; *p != '\0';) {
+        const char *end = strstr(p, "\r\n");
+        if (end == NULL)
+            break;
+        const char *space = memchr(p, ' ', end - p);
+        if (space != NULL && (size_t)(end - space - 1) == strlen(name) && memcmp(space + 1, name, strlen(name)) == 0 && (size_t)(end - p) < size) {
+            memcpy(line, p, end - p);
+            line[end - p] = '\0';
+            return line;
+        }
+        p = end + 2;
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    ftp_client_t client;
+    struct utimbuf times = { .actime = MDTM_EPOCH, .modtime = MDTM_EPOCH };
+    char path[64], line[256];
+    size_t len;
+
+    for (size_t n = 0; n < sizeof(data); n++)
+        data[n] = (char)('a' + n % 26);
+
+    if (mkdtemp(mount) == NULL)
+        return 1;
+    local_write("log.txt", "wb", data, 1000);
+    local_path(path, sizeof(path), "log.txt");
+    utime(path, &times);
+    local_path(path, sizeof(path), "sub");
+    mkdir(path, 0755);
+
+    ftpserver_start("test", "test", mount);
+    bool open = false;
+    for (int retry = 0; retry < 50 && !(open = ftp_client_open(&client, FTPSERVER_CMD_PORT, "test", "test")); retry++)
+        usleep(100000);
+    CHECK(open);
+    if (!open)
+        return TEST_RESULT();
+
+    // the extensions are announced
+    CHECK_EQ(ftp_client_cmd(&client, "FEAT"), 211);
+    CHECK(strstr(client.reply, " SIZE\r\n") != NULL);
+    CHECK(strstr(client.reply, " MDTM\r\n") != NULL);
+    CHECK(strstr(client.reply, " REST STREAM\r\n") != NULL);
+    CHECK(strstr(client.reply, " MLSD ") != NULL);
+
+    // SIZE and MDTM
+    CHECK_EQ(ftp_client_cmd(&client, "SIZE log.txt"), 213);
+    CHECK(strcmp(client.reply, "213 1000\r\n") == 0);
+    CHECK_EQ(ftp_client_cmd(&client, "SIZE missing.txt"), 550);
+    CHECK_EQ(ftp_client_cmd(&client, "MDTM log.txt"), 213);
+    CHECK(strcmp(client.reply, "213 20240102030405\r\n") == 0);
+    CHECK_EQ(ftp_client_cmd(&client, "MDTM missing.txt"), 550);
+
+    // REST
+    CHECK_EQ(ftp_client_cmd(&client, "REST 12x"), 501);
+    CHECK_EQ(ftp_client_cmd(&client, "REST"), 501);
+    CHECK_EQ(ftp_client_get(&client, "RETR log.txt", 600, buf, sizeof(buf), &len), 226);
+    CHECK_EQ(len, 400);
+    CHECK(memcmp(buf, data + 600, 400) == 0);
+
+    // the offset is not kept for the next transfer
+    CHECK_EQ(ftp_client_get(&client, "RETR log.txt", 0, buf, sizeof(buf), &len), 226);
+    CHECK_EQ(len, 1000);
+    CHECK(memcmp(buf, data, 1000) == 0);
+
+    // incremental sync: the file grew, only the appended bytes are fetched
+    local_write("log.txt", "ab", data + 1000, 500);
+    CHECK_EQ(ftp_client_cmd(&client, "SIZE log.txt"), 213);
+    CHECK(strcmp(client.reply, "213 1500\r\n") == 0);
+    CHECK_EQ(ftp_client_get(&client, "RETR log.txt", 1000, buf, sizeof(buf), &len), 226);
+    CHECK_EQ(len, 500);
+    CHECK(memcmp(buf, data + 1000, 500) == 0);
+
+    // STOR after REST overwrites from the offset and keeps what is before it
+    CHECK_EQ(ftp_client_put(&client, "STOR log.txt", 1000, data + 2000, 200), 226);
+    len = local_read("log.txt", buf, sizeof(buf));
+    CHECK_EQ(len, 1500);
+    CHECK(memcmp(buf, data, 1000) == 0);
+    CHECK(memcmp(buf + 1000, data + 2000, 200) == 0);
+    CHECK(memcmp(buf + 1200, data + 1200, 300) == 0);
+
+    // resume an interrupted upload of a new file
+    CHECK_EQ(ftp_client_put(&client, "STOR up.bin", 0, data, 700), 226);
+    CHECK_EQ(ftp_client_cmd(&client, "SIZE up.bin"), 213);
+    CHECK(strcmp(client.reply, "213 700\r\n") == 0);
+    CHECK_EQ(ftp_client_put(&client, "STOR up.bin", 700, data + 700, 1300), 226);
+    len = local_read("up.bin", buf, sizeof(buf));
+    CHECK_EQ(len, 2000);
+    CHECK(memcmp(buf, data, 2000) == 0);
+
+    // plain STOR still truncates, APPE appends
+    CHECK_EQ(ftp_client_put(&client, "STOR up.bin", 0, data, 100), 226);
+    CHECK_EQ(ftp_client_put(&client, "APPE up.bin", 0, data + 100, 50), 226);
+    len = local_read("up.bin", buf, sizeof(buf));
+    CHECK_EQ(len, 150);
+    CHECK(memcmp(buf, data, 150) == 0);
+
+    // MLSD facts
+    local_path(path, sizeof(path), "log.txt");
+    utime(path, &times);
+    CHECK_EQ(ftp_client_get(&client, "MLSD", 0, buf, sizeof(buf) - 1, &len), 226);
+    buf[len] = '\0';
+    CHECK(mlsd_entry(buf, "log.txt", line, sizeof(line)) != NULL && strcmp(line, "type=file;size=1500;modify=20240102030405; log.txt") == 0);
+    CHECK(mlsd_entry(buf, "up.bin", line, sizeof(line)) != NULL && strncmp(line, "type=file;size=150;modify=", 26) == 0);
+    CHECK(mlsd_entry(buf, "sub", line, sizeof(line)) != NULL && strncmp(line, "type=dir;", 9) == 0);
+    CHECK(mlsd_entry(buf, "missing.txt", line, sizeof(line)) == NULL);
+
+    ftp_client_close(&client);
+
+    unlink(path);
+    local_path(path, sizeof(path), "up.bin");
+    unlink(path);
+    local_path(path, sizeof(path), "sub");
+    rmdir(path);
+    rmdir(mount);
+
+    return TEST_RESULT();
+}
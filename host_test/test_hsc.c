@@ -0,0 +1,204 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// High speed counters with a fake pulse source: quadrature decoding, compare matches and output pulses, simulated
+// pulses, the frequency gate, and a pulse task racing the scan without losing counts
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_test.h"
+#include "ladder_hsc_counter.h"
+
+#define COMPARE      500    // compare step of the raced counter
+#define SOURCE_EDGES 200000 // quadrature edges of the pulse task
+
+// A/B states of a forward rotation
+static const uint8_t forward[4] = { 0, 2, 3, 1 };
+
+typedef struct source_s {
+    ladder_hsc_counter_t counter; //
+    portMUX_TYPE mux;             // the interrupt critical section
+    uint32_t edges;               // edges sent, stored after they were counted
+    uint32_t outputs;             // compare output switched on
+    volatile bool done;           //
+} source_t;
+
+static source_t source = { .mux = portMUX_INITIALIZER_UNLOCKED };
+
+// what the GPIO interrupt does with the pins read
+static void source_isr(source_t *src, uint8_t state, int64_t now) {
+    portENTER_CRITICAL_SAFE(&src->mux);
+    int32_t delta = ladder_hsc_counter_quad(&src->counter, state);
+    if (delta != 0 && ladder_hsc_counter_add(&src->counter, delta, now) > 0) {
+        src->counter.latched = true;
+        src->outputs++;
+    }
+    portEXIT_CRITICAL_SAFE(&src->mux);
+}
+
+// fake encoder turning forward, one edge per call, yielding now and then like a real interrupt source
+static void source_task(void *arg) {
+    source_t *src = arg;
+
+    for (uint32_t n = 1; n <= SOURCE_EDGES; n++) {
+        source_isr(src, forward[n % 4], n);
+        __atomic_store_n(&src->edges, n, __ATOMIC_RELEASE);
+        if (n % 1000 == 0)
+            vTaskDelay(0);
+    }
+
+    src->done = true;
+    vTaskDelete(NULL);
+}
+
+static int32_t turn(ladder_hsc_counter_t *counter, int32_t edges) {
+    int32_t count = 0;
+
+    for (int32_t n = 1; n <= (edges < 0 ? -edges : edges); n++) {
+        uint8_t step = edges < 0 ? (4 - n % 4) % 4 : n % 4;
+        count += ladder_hsc_counter_quad(counter, forward[step]);
+    }
+
+    return count;
+}
+
+int main(void) {
+    ladder_hsc_counter_t counter;
+
+    // x4 decoding: four counts per cycle, signed with the direction
+    ladder_hsc_counter_init(&counter, 0, 0);
+    CHECK_EQ(turn(&counter, 400), 400);
+    counter.quad = 0;
+    CHECK_EQ(turn(&counter, -400), -400);
+
+    // contact bounce on A nets nothing, a skipped state is not counted
+    counter.quad = 0;
+    CHECK_EQ(ladder_hsc_counter_quad(&counter, 2), 1);
+    CHECK_EQ(ladder_hsc_counter_quad(&counter, 0), -1);
+    CHECK_EQ(ladder_hsc_counter_quad(&counter, 2), 1);
+    CHECK_EQ(ladder_hsc_counter_quad(&counter, 2), 0);
+    CHECK_EQ(ladder_hsc_counter_quad(&counter, 1), 0);
+    CHECK_EQ(counter.quad, 1);
+
+    // compare every 500 counts from the preset, several matches in one add
+    ladder_hsc_counter_init(&counter, 100, 500);
+    CHECK_EQ(counter.count, 100);
+    uint32_t matches = 0;
+    for (int n = 0; n < 2000; n++)
+        matches += ladder_hsc_counter_add(&counter, 1, n);
+    CHECK_EQ(matches, 4);
+    CHECK_EQ(counter.fires, 4);
+    CHECK_EQ(counter.fire_time, 1999);
+    CHECK_EQ(ladder_hsc_counter_add(&counter, 1200, 5000), 2);
+    CHECK_EQ(counter.next, 100 + 7 * 500);
+    CHECK_EQ(counter.fire_time, 5000);
+
+    // going back and forth across a match fires it once
+    CHECK_EQ(ladder_hsc_counter_add(&counter, -1000, 6000), 0);
+    CHECK_EQ(ladder_hsc_counter_add(&counter, 1000, 7000), 0);
+    CHECK_EQ(counter.fires, 6);
+
+    // the output pulse, then a preset releases a latched output and restarts the compare
+    counter.latched = true;
+    ladder_hsc_counter_pulse(&counter, 100, 5000 + 99999);
+    CHECK(counter.latched);
+    ladder_hsc_counter_pulse(&counter, 100, 5000 + 100000);
+    CHECK(!counter.latched);
+    counter.latched = true;
+    ladder_hsc_counter_pulse(&counter, 0, INT64_MAX);
+    CHECK(counter.latched);
+    ladder_hsc_counter_preset(&counter);
+    CHECK(!counter.latched);
+    CHECK_EQ(counter.count, 100);
+    CHECK_EQ(ladder_hsc_counter_add(&counter, 500, 8000), 1);
+
+    // no compare: never fires
+    ladder_hsc_counter_init(&counter, 0, 0);
+    CHECK_EQ(ladder_hsc_counter_add(&counter, 100000, 0), 0);
+
+    // simulated pulses: fractions are carried, no pulse is lost over a second
+    ladder_hsc_counter_init(&counter, 0, 0);
+    uint32_t pulses = 0;
+    for (int n = 0; n < 100; n++)
+        pulses += ladder_hsc_counter_sim(&counter, 333, 10);
+    CHECK_EQ(pulses, 333);
+    CHECK_EQ(ladder_hsc_counter_sim(&counter, 2500, 10), 25);
+
+    // frequency gate: the first one and the one broken by a preset are skipped
+    ladder_hsc_counter_init(&counter, 0, 0);
+    ladder_hsc_counter_gate(&counter, 0, 100000);
+    CHECK_EQ(counter.freq, 0);
+    ladder_hsc_counter_gate(&counter, 250, 200000);
+    CHECK_EQ(counter.freq, 2500);
+    ladder_hsc_counter_gate(&counter, 150, 300000);
+    CHECK_EQ(counter.freq, -1000);
+    ladder_hsc_counter_preset(&counter);
+    ladder_hsc_counter_gate(&counter, 0, 400000);
+    CHECK_EQ(counter.freq, -1000);
+    ladder_hsc_counter_gate(&counter, 10, 500000);
+    CHECK_EQ(counter.freq, 100);
+
+    // per edge cost of the interrupt path
+    source_t bench = { .mux = portMUX_INITIALIZER_UNLOCKED };
+    ladder_hsc_counter_init(&bench.counter, 0, COMPARE);
+    int64_t start = test_now_us();
+    for (uint32_t n = 1; n <= SOURCE_EDGES; n++)
+        source_isr(&bench, forward[n % 4], n);
+    int64_t edge_us = test_now_us() - start;
+    CHECK_EQ(bench.counter.count, SOURCE_EDGES);
+    printf("%d edges decoded in %.1f ns each\n", SOURCE_EDGES, edge_us * 1000.0 / SOURCE_EDGES);
+
+    // the pulse task races the scan: the count read is never behind the edges sent and never goes back
+    ladder_hsc_counter_init(&source.counter, 0, COMPARE);
+    TaskHandle_t task;
+    CHECK(xTaskCreate(source_task, "pulses", 4096, &source, 10, &task) == pdPASS);
+    uint32_t scans = 0, behind = 0, backwards = 0;
+    int32_t last = 0;
+    while (!source.done) {
+        uint32_t edges = __atomic_load_n(&source.edges, __ATOMIC_ACQUIRE);
+        int32_t count = __atomic_load_n(&source.counter.count, __ATOMIC_RELAXED);
+        behind += count < (int32_t)edges;
+        backwards += count < last;
+        last = count;
+        scans++;
+        vTaskDelay(0);
+    }
+    CHECK_EQ(behind, 0);
+    CHECK_EQ(backwards, 0);
+    CHECK_EQ(source.counter.count, SOURCE_EDGES);
+    CHECK_EQ(source.outputs, SOURCE_EDGES / COMPARE);
+    CHECK_EQ(source.counter.fires, SOURCE_EDGES / COMPARE);
+    printf("%d edges counted over %u scans, %u compare outputs\n", SOURCE_EDGES, scans, source.outputs);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// I/O module image exchange with simulated devices: the scan cost stays flat however slow the device answers, images
+// reach both sides whole, and a device that stops answering raises a staleness fault
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_test.h"
+#include "ladder_io_exchange.h"
+
+#define POINTS  8    // of every kind
+#define SCAN_US 1000 // scan period
+#define SCANS   400  // scans per device
+
+typedef struct device_s {
+    uint32_t delay_us;    // answer time
+    volatile bool answer; // false: timeout
+    uint32_t seq;         // polls answered
+    int32_t qw[POINTS];   // outputs as last written
+} device_t;
+
+typedef struct scan_stats_s {
+    int64_t total_us; //
+    int64_t max_us;   //
+    uint32_t torn;    // input images mixing two polls
+    uint32_t stale;   // scans with stale inputs
+    int32_t seq;      // newest poll seen
+} scan_stats_t;
+
+// outputs are stored, inputs echo the bits and carry the poll sequence in every word
+static bool device_poll(void *arg, const ladder_io_image_t *out, ladder_io_image_t *in) {
+    device_t *dev = arg;
+
+    usleep(dev->delay_us);
+    if (!dev->answer)
+        return false;
+
+    dev->seq++;
+    memcpy(dev->qw, out->words, sizeof(dev->qw));
+    for (uint32_t n = 0; n < POINTS; n++) {
+        in->bits[n] = out->bits[n];
+        in->words[n] = dev->seq;
+    }
+
+    return true;
+}
+
+static void module_start(ladder_io_exchange_t *io, device_t *dev, uint32_t period_ms, bool stale_clear) {
+    ladder_io_module_def_t def = {
+        .name = "sim",
+        .i_qty = POINTS,
+        .iw_qty = POINTS,
+        .q_qty = POINTS,
+        .qw_qty = POINTS,
+        .period_ms = period_ms,
+        .stale_clear = stale_clear,
+        .poll = device_poll,
+        .arg = dev,
+    };
+
+    CHECK(ladder_io_exchange_init(io, &def));
+    CHECK(xTaskCreate(ladder_io_exchange_task, "sim", 4096, io, 5, &io->task) == pdPASS);
+}
+
+static void module_stop(ladder_io_exchange_t *io) {
+    vTaskDelete(io->task);
+    ladder_io_exchange_free(io);
+}
+
+// the scan side of the ladder: read the inputs, write the scan number to the outputs
+static void scans(ladder_io_exchange_t *io, uint32_t qty, scan_stats_t *stats) {
+    static int32_t scan = 0;
+
+    memset(stats, 0, sizeof(scan_stats_t));
+    for (uint32_t n = 0; n < qty; n++) {
+        int64_t start = test_now_us();
+
+        stats->stale += ladder_io_exchange_read(io);
+        const ladder_io_image_t *in = &io->in[io->in_front];
+        for (uint32_t p = 1; p < POINTS; p++)
+            if (in->words[p] != in->words[0]) {
+                stats->torn++;
+                break;
+            }
+        if (in->words[0] > stats->seq)
+            stats->seq = in->words[0];
+
+        scan++;
+        for (uint32_t p = 0; p < POINTS; p++) {
+            io->out[0].bits[p] = scan & 1;
+            io->out[0].words[p] = scan;
+        }
+        ladder_io_exchange_write(io);
+
+        int64_t elapsed = test_now_us() - start;
+        stats->total_us += elapsed;
+        if (elapsed > stats->max_us)
+            stats->max_us = elapsed;
+
+        usleep(SCAN_US);
+    }
+}
+
+int main(void) {
+    const uint32_t delays_ms[] = { 0, 20, 80, 200 };
+    ladder_io_exchange_t io;
+    device_t dev;
+    scan_stats_t stats;
+    double fast_us = 0;
+
+    // a slow device only delays its own images, the scan exchange costs the same
+    printf("device ms   polls  poll max us  scan mean us  scan max us\n");
+    for (uint32_t d = 0; d < sizeof(delays_ms) / sizeof(delays_ms[0]); d++) {
+        memset(&dev, 0, sizeof(dev));
+        dev.delay_us = delays_ms[d] * 1000;
+        dev.answer = true;
+        module_start(&io, &dev, 10, false);
+        scans(&io, SCANS, &stats);
+
+        double mean_us = (double)stats.total_us / SCANS;
+        printf("%9u %7u %12u %13.2f %12lld\n", delays_ms[d], io.polls, io.poll_max_us, mean_us, (long long)stats.max_us);
+        if (d == 0)
+            fast_us = mean_us;
+
+        CHECK(io.polls > 0);
+        CHECK(io.poll_max_us >= delays_ms[d] * 1000);
+        CHECK(mean_us < fast_us * 4 + 5);
+        CHECK(stats.max_us < 5000);
+        CHECK_EQ(stats.torn, 0);
+
+        // both images travel: the newest poll is seen by the scan, the device got a recent scan number
+        CHECK(stats.seq >= (int32_t)dev.seq - 1);
+        CHECK(dev.qw[0] > 0);
+        CHECK(dev.qw[0] == dev.qw[POINTS - 1]);
+
+        module_stop(&io);
+    }
+
+    // staleness: never polled, polled, then the device stops answering
+    memset(&dev, 0, sizeof(dev));
+    dev.answer = true;
+    ladder_io_exchange_init(&io, &(ladder_io_module_def_t) { .name = "sim", .i_qty = POINTS, .iw_qty = POINTS, .q_qty = POINTS, .qw_qty = POINTS,
+                                                              .period_ms = 10, .stale_clear = true, .poll = device_poll, .arg = &dev });
+    CHECK_EQ(io.def.stale_ms, LADDER_IO_STALE_PERIODS * 10);
+    CHECK(ladder_io_exchange_read(&io));
+    CHECK_EQ(io.faults, 1);
+    CHECK(xTaskCreate(ladder_io_exchange_task, "sim", 4096, &io, 5, &io.task) == pdPASS);
+
+    scans(&io, 50, &stats);
+    CHECK(!io.stale);
+    CHECK(io.in[io.in_front].words[0] > 0);
+    CHECK_EQ(io.faults, 1);
+
+    dev.answer = false;
+    scans(&io, 100, &stats);
+    CHECK(io.stale);
+    CHECK_EQ(io.faults, 2);
+    CHECK(io.errors > 0);
+    CHECK_EQ(io.in[io.in_front].words[0], 0);
+
+    dev.answer = true;
+    scans(&io, 50, &stats);
+    CHECK(!io.stale);
+    CHECK_EQ(io.faults, 2);
+    CHECK(io.in[io.in_front].words[0] > 0);
+    module_stop(&io);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// GET /metrics read back by a minimal Prometheus text format (0.0.4) scraper
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_http_server.h"
+#include "host_port.h"
+#include "host_test.h"
+#include "metrics.h"
+
+#define BODY_SIZE    (64 * 1024)
+#define FAMILIES_MAX 32
+#define SAMPLES_MAX  128
+
+typedef struct family_s {
+    char name[64]; //
+    char type[16]; //
+    bool help;     //
+} family_t;
+
+typedef struct sample_s {
+    char name[64];    //
+    char labels[128]; //
+    double value;     //
+} sample_t;
+
+typedef struct scrape_s {
+    family_t families[FAMILIES_MAX]; //
+    uint32_t families_qty;           //
+    sample_t samples[SAMPLES_MAX];   //
+    uint32_t samples_qty;            //
+    uint32_t errors;                 // format violations
+} scrape_t;
+
+static char body[BODY_SIZE];
+
+static family_t *family_find(scrape_t *scrape, const char *name) {
+    for (uint32_t n = 0; n < scrape->families_qty; n++)
+        if (strcmp(scrape->families[n].name, name) == 0)
+            return &scrape->families[n];
+
+    return NULL;
+}
+
+static bool sample_of(const char *sample, const family_t *family) {
+    size_t len = strlen(family->name);
+
+    if (strncmp(sample, family->name, len) != 0)
+        return false;
+    if (sample[len] == '\0')
+        return true;
+
+    if (strcmp(family->type, "histogram") != 0)
+        return false;
+
+    return strcmp(sample + len, "_bucket") == 0 || strcmp(sample + len, "_sum") == 0 || strcmp(sample + len, "_count") == 0;
+}
+
+static void scrape_error(scrape_t *scrape, const char *line, const char *why) {
+    fprintf(stderr, "scrape: %s: [%s]\n", why, line);
+    scrape->errors++;
+}
+
+// every sample belongs to the family declared right before it, a family is declared once
+static void scrape_parse(scrape_t *scrape, char *text) {
+    family_t *current = NULL;
+
+    memset(scrape, 0, sizeof(scrape_t));
+    for (char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        char name[64], rest[160];
+
+        if (strncmp(line, "# HELP ", 7) == 0 || strncmp(line, "# TYPE ", 7) == 0) {
+            if (sscanf(line + 7, "%63s %159[^\n]", name, rest) != 2) {
+                scrape_error(scrape, line, "bad comment");
+                continue;
+            }
+            family_t *family = family_find(scrape, name);
+            if (family == NULL && scrape->families_qty < FAMILIES_MAX) {
+                family = &scrape->families[scrape->families_qty++];
+                strcpy(family->name, name);
+            } else if (family != current) {
+                scrape_error(scrape, line, "family declared twice");
+                continue;
+            }
+            if (line[2] == 'H') {
+                family->help = true;
+            } else {
+                if (strcmp(rest, "counter") != 0 && strcmp(rest, "gauge") != 0 && strcmp(rest, "histogram") != 0)
+                    scrape_error(scrape, line, "unknown type");
+                strlcpy(family->type, rest, sizeof(family->type));
+            }
+            current = family;
+            continue;
+        }
+        if (line[0] == '#')
+            continue;
+
+        sample_t *sample = &scrape->samples[scrape->samples_qty];
+        char *end;
+        size_t len = strcspn(line, "{ ");
+        if (scrape->samples_qty == SAMPLES_MAX || len == 0 || len >= sizeof(sample->name)) {
+            scrape_error(scrape, line, "bad sample");
+            continue;
+        }
+        memcpy(sample->name, line, len);
+        sample->name[len] = '\0';
+        sample->labels[0] = '\0';
+        char *value = line + len;
+        if (*value == '{') {
+            char *close = strchr(value, '}');
+            if (close == NULL || (size_t)(close - value) >= sizeof(sample->labels)) {
+                scrape_error(scrape, line, "bad labels");
+                continue;
+            }
+            memcpy(sample->labels, value + 1, close - value - 1);
+            sample->labels[close - value - 1] = '\0';
+            value = close + 1;
+        }
+        if (*value != ' ') {
+            scrape_error(scrape, line, "no value");
+            continue;
+        }
+        sample->value = strtod(value + 1, &end);
+        if (end == value + 1 || *end != '\0') {
+            scrape_error(scrape, line, "bad value");
+            continue;
+        }
+        if (current == NULL || current->type[0] == '\0' || !current->help || !sample_of(sample->name, current)) {
+            scrape_error(scrape, line, "sample outside its family");
+            continue;
+        }
+        scrape->samples_qty++;
+    }
+}
+
+static bool scrape_value(const scrape_t *scrape, const char *name, const char *labels, double *value) {
+    for (uint32_t n = 0; n < scrape->samples_qty; n++) {
+        if (strcmp(scrape->samples[n].name, name) == 0 && strcmp(scrape->samples[n].labels, labels) == 0) {
+            *value = scrape->samples[n].value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static double value_of(const scrape_t *scrape, const char *name, const char *labels) {
+    double value;
+
+    if (scrape_value(scrape, name, labels, &value))
+        return value;
+
+    fprintf(stderr, "missing %s{%s}\n", name, labels);
+    host_test_failures++;
+    return -1;
+}
+
+static void scrape(scrape_t *scrape, size_t *chunks) {
+    esp_err_t err = host_httpd_get("/metrics", body, sizeof(body), chunks);
+
+    CHECK_EQ(err, ESP_OK);
+    scrape_parse(scrape, body);
+    CHECK_EQ(scrape->errors, 0);
+}
+
+int main(void) {
+    static scrape_t first, second;
+    static const uint64_t scans_ms[] = { 0, 1, 3, 7, 15, 2000 };
+    int dummy_server;
+    size_t chunks;
+    double value;
+
+    host_heap_set(123456, 100000, 65536);
+    host_wifi_rssi(true, -61);
+    host_httpd_ws_clients(2, 3);
+    CHECK_EQ(metrics_start(&dummy_server), ESP_OK);
+
+    // the refresh task fills the cache right away
+    for (int retry = 0; retry < 100; retry++) {
+        scrape(&first, &chunks);
+        if (scrape_value(&first, "plc_heap_free_bytes", "", &value) && value > 0)
+            break;
+        usleep(10000);
+    }
+
+    CHECK_EQ(value_of(&first, "plc_heap_free_bytes", ""), 123456);
+    CHECK_EQ(value_of(&first, "plc_heap_min_free_bytes", ""), 100000);
+    CHECK_EQ(value_of(&first, "plc_heap_largest_free_block_bytes", ""), 65536);
+    CHECK_EQ(value_of(&first, "plc_wifi_rssi_dbm", ""), -61);
+    CHECK_EQ(value_of(&first, "plc_ws_clients", ""), 3);
+    CHECK(value_of(&first, "plc_tasks", "") >= 1);
+    CHECK(value_of(&first, "plc_task_stack_free_bytes", "task=\"metrics\"") > 0);
+    CHECK_EQ(value_of(&first, "plc_scans_total", ""), 0);
+    CHECK_EQ(value_of(&first, "plc_scan_duration_seconds_bucket", "le=\"+Inf\""), 0);
+
+    for (size_t n = 0; n < sizeof(scans_ms) / sizeof(scans_ms[0]); n++)
+        metrics_scan(scans_ms[n]);
+    metrics_ws_sent(100);
+    metrics_ws_sent(28);
+    metrics_ftp_transfer(true, 4096, true);
+    metrics_ftp_transfer(false, 1000, true);
+    metrics_ftp_transfer(false, 10, false);
+
+    scrape(&second, &chunks);
+    // larger than the handler buffer: sent in several chunks plus the final empty one
+    CHECK(chunks > 2);
+
+    CHECK_EQ(value_of(&second, "plc_scans_total", ""), 6);
+    CHECK_EQ(value_of(&second, "plc_scan_overruns_total", ""), 2);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_count", ""), 6);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_sum", "") * 1000 + 0.5, 2026);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_bucket", "le=\"0.001\""), 2);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_bucket", "le=\"0.005\""), 3);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_bucket", "le=\"0.01\""), 4);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_bucket", "le=\"0.02\""), 5);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_bucket", "le=\"1\""), 5);
+    CHECK_EQ(value_of(&second, "plc_scan_duration_seconds_bucket", "le=\"+Inf\""), 6);
+    CHECK_EQ(value_of(&second, "plc_ws_sent_bytes_total", ""), 128);
+    CHECK_EQ(value_of(&second, "plc_ftp_transfers_total", "direction=\"rx\",result=\"ok\""), 1);
+    CHECK_EQ(value_of(&second, "plc_ftp_transfers_total", "direction=\"tx\",result=\"ok\""), 1);
+    CHECK_EQ(value_of(&second, "plc_ftp_transfers_total", "direction=\"tx\",result=\"error\""), 1);
+    CHECK_EQ(value_of(&second, "plc_ftp_bytes_total", "direction=\"rx\""), 4096);
+    CHECK_EQ(value_of(&second, "plc_ftp_bytes_total", "direction=\"tx\""), 1010);
+
+    // buckets are cumulative
+    double prev = 0;
+    for (uint32_t n = 0; n < second.samples_qty; n++) {
+        if (strcmp(second.samples[n].name, "plc_scan_duration_seconds_bucket") != 0)
+            continue;
+        CHECK(second.samples[n].value >= prev);
+        prev = second.samples[n].value;
+    }
+
+    // no Wi-Fi: the gauge is left out rather than reported as 0
+    host_wifi_rssi(false, 0);
+    usleep((METRICS_REFRESH_MS + 500) * 1000);
+    scrape(&second, &chunks);
+    CHECK(!scrape_value(&second, "plc_wifi_rssi_dbm", "", &value));
+    CHECK(value_of(&second, "plc_metrics_cache_age_seconds", "") < 1.0);
+
+    // rendering cost does not grow with the number of scans accounted
+    int64_t start = test_now_us();
+    for (int n = 0; n < 1000; n++)
+        host_httpd_get("/metrics", body, sizeof(body), NULL);
+    int64_t before = test_now_us() - start;
+    for (int n = 0; n < 1000000; n++)
+        metrics_scan(n % 50);
+    start = test_now_us();
+    for (int n = 0; n < 1000; n++)
+        host_httpd_get("/metrics", body, sizeof(body), NULL);
+    int64_t after = test_now_us() - start;
+    printf("scrape %.1f us, %.1f us after 1M scans, %zu bytes\n", before / 1000.0, after / 1000.0, strlen(body));
+    CHECK(after < before * 3 + 10000);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,410 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Modbus master link state: TCP against a simulated slave on the loopback (pipelined window, answers out of order and
+// late, timeouts, reconnect) and RTU against a simulated slave on a pseudo terminal (timeouts, bad frames,
+// exceptions, broadcast and the inter-frame gap)
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "esp_timer.h"
+#include "host_port.h"
+#include "host_test.h"
+#include "lwip/sockets.h"
+#include "modbus.h"
+#include "modbus_master_session.h"
+#include "modbus_poll.h"
+
+#define TCP_POINTS   6
+#define TCP_PIPELINE 4
+#define TCP_TIMEOUT  100 // ms
+#define RTU_UART     1
+#define RTU_BAUD     9600
+#define RTU_TIMEOUT  50 // ms
+
+typedef enum SIM_MODE {
+    SIM_REVERSE, // a full window is answered last request first
+    SIM_LATE,    // the request for address 20 is answered after the timeout
+    SIM_DROP,    // the connection is closed after the third request
+} sim_mode_t;
+
+static volatile sim_mode_t sim_mode;
+static volatile uint32_t sim_tag;
+static volatile uint32_t sim_requests; // since the mode was set
+static volatile uint32_t sim_outstanding_max;
+static volatile bool sim_stop;
+static int sim_listen;
+
+static modbus_master_config_t config;
+static modbus_poll_t poll_table;
+static uint8_t bits[8];
+static int32_t words[16];
+static uint8_t out_bits[8];
+static int32_t out_words[8] = { 0x1234 };
+static const ladder_io_image_t out = { out_bits, out_words };
+
+static bool recv_all(int sd, uint8_t *buf, uint32_t len) {
+    uint32_t done = 0;
+
+    while (done < len) {
+        int n = recv(sd, buf + done, len - done, 0);
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+
+    return true;
+}
+
+// FC 3 answer, register "addr + k" reads tag + addr + k
+static void tcp_answer(int sd, const uint8_t *req, uint32_t tag) {
+    uint8_t adu[MODBUS_ADU_MAX];
+    uint16_t addr = MODBUS_GET16(&req[8]), count = MODBUS_GET16(&req[10]);
+
+    memcpy(adu, req, 4);
+    MODBUS_PUT16(&adu[4], 3 + count * 2);
+    adu[6] = req[6];
+    adu[7] = MODBUS_FC_READ_HOLDING;
+    adu[8] = count * 2;
+    for (uint16_t k = 0; k < count; k++)
+        MODBUS_PUT16(&adu[9 + k * 2], tag + addr + k);
+    send(sd, adu, 9 + count * 2, 0);
+}
+
+static bool tcp_pending(int sd, int ms) {
+    struct pollfd pfd = { .fd = sd, .events = POLLIN };
+    return poll(&pfd, 1, ms) > 0;
+}
+
+static void *tcp_slave(void *arg) {
+    uint8_t req[TCP_POINTS + 1][12];
+
+    while (!sim_stop) {
+        int sd = accept(sim_listen, NULL, NULL);
+        if (sd < 0)
+            continue;
+
+        uint32_t held = 0;
+        bool late = false;
+        while (!sim_stop) {
+            if (held > 0 && !tcp_pending(sd, 20)) {
+                // the window is full or nothing else comes: answer what is held
+                if (held > sim_outstanding_max)
+                    sim_outstanding_max = held;
+                for (uint32_t n = held; n-- > 0;)
+                    tcp_answer(sd, req[n], sim_tag);
+                held = 0;
+                continue;
+            }
+            if (late && !tcp_pending(sd, 20)) {
+                usleep((TCP_TIMEOUT + 50) * 1000);
+                tcp_answer(sd, req[TCP_POINTS], 0x7000);
+                late = false;
+                continue;
+            }
+
+            uint8_t *r = req[held];
+            if (!recv_all(sd, r, 12))
+                break;
+            sim_requests++;
+
+            if (sim_mode == SIM_DROP && sim_requests == 3)
+                break;
+            if (sim_mode == SIM_LATE && MODBUS_GET16(&r[8]) == 20) {
+                memcpy(req[TCP_POINTS], r, 12);
+                late = true;
+                continue;
+            }
+            if (sim_mode == SIM_LATE) {
+                tcp_answer(sd, r, sim_tag);
+                continue;
+            }
+            held++;
+        }
+        close(sd);
+    }
+
+    return NULL;
+}
+
+static void check_words(uint32_t tag, int skip) {
+    for (uint32_t n = 0; n < TCP_POINTS; n++) {
+        if ((int)n == skip)
+            continue;
+        CHECK_EQ(words[n * 2], tag + n * 10);
+        CHECK_EQ(words[n * 2 + 1], tag + n * 10 + 1);
+    }
+}
+
+static void test_tcp(void) {
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+    modbus_master_session_t session;
+    pthread_t thread;
+    int option = 1;
+
+    sim_listen = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(sim_listen, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    CHECK(bind(sim_listen, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    CHECK(listen(sim_listen, 2) == 0);
+    getsockname(sim_listen, (struct sockaddr *)&addr, &addr_len);
+
+    memset(&config, 0, sizeof(config));
+    strcpy(config.name, "tcp");
+    config.link = MODBUS_MASTER_TCP;
+    strcpy(config.host, "127.0.0.1");
+    config.port = ntohs(addr.sin_port);
+    config.timeout_ms = TCP_TIMEOUT;
+    config.pipeline = TCP_PIPELINE;
+    config.points = TCP_POINTS;
+    // addresses 10 apart, never merged: one request per point
+    for (uint32_t n = 0; n < TCP_POINTS; n++)
+        config.point[n] = (modbus_master_point_t){ .slave = 1, .function = MODBUS_FC_READ_HOLDING, .addr = n * 10, .count = 2, .index = n * 2 };
+    modbus_poll_build(&poll_table, config.point, config.points);
+    CHECK_EQ(poll_table.requests, TCP_POINTS);
+
+    memset(words, 0, sizeof(words));
+    modbus_master_session_init(&session, &config, &poll_table, bits, words);
+    pthread_create(&thread, NULL, tcp_slave, NULL);
+
+    // the window is kept full and the answers come back reversed: matched by transaction identifier
+    sim_mode = SIM_REVERSE;
+    sim_tag = 1000;
+    CHECK_EQ(modbus_master_session_cycle(&session, &out), TCP_POINTS);
+    CHECK_EQ(sim_outstanding_max, TCP_PIPELINE);
+    CHECK_EQ(session.transactions, TCP_POINTS);
+    CHECK_EQ(session.connects, 1);
+    check_words(1000, -1);
+
+    // a late answer: the transaction times out, its answer is dropped when it comes in the next cycle
+    sim_mode = SIM_LATE;
+    sim_tag = 2000;
+    int64_t start = esp_timer_get_time();
+    CHECK_EQ(modbus_master_session_cycle(&session, &out), TCP_POINTS - 1);
+    int64_t elapsed = esp_timer_get_time() - start;
+    CHECK(elapsed >= TCP_TIMEOUT * 1000 && elapsed < TCP_TIMEOUT * 3000);
+    CHECK_EQ(session.timeouts, 1);
+    CHECK_EQ(session.point_errors[2], 1);
+    check_words(2000, 2);
+    CHECK_EQ(words[4], 1000 + 20);
+    usleep(100 * 1000);
+
+    sim_mode = SIM_REVERSE;
+    sim_tag = 3000;
+    CHECK_EQ(modbus_master_session_cycle(&session, &out), TCP_POINTS);
+    check_words(3000, -1);
+    CHECK_EQ(session.timeouts, 1);
+    CHECK_EQ(session.connects, 1);
+
+    // connection lost in the middle of a cycle: every request left fails, the next cycle connects again
+    sim_mode = SIM_DROP;
+    sim_requests = 0;
+    CHECK(modbus_master_session_cycle(&session, &out) < TCP_POINTS);
+    CHECK_EQ(session.sd, -1);
+    uint32_t errors = 0;
+    for (uint32_t n = 0; n < TCP_POINTS; n++)
+        errors += session.point_errors[n];
+    CHECK_EQ(errors, 1 + TCP_POINTS);
+
+    sim_mode = SIM_REVERSE;
+    sim_tag = 4000;
+    CHECK_EQ(modbus_master_session_cycle(&session, &out), TCP_POINTS);
+    CHECK_EQ(session.connects, 2);
+    check_words(4000, -1);
+
+    // nobody listening: the connection attempt fails and every point with it
+    modbus_master_session_close(&session);
+    sim_stop = true;
+    shutdown(sim_listen, SHUT_RDWR);
+    close(sim_listen);
+    pthread_join(thread, NULL);
+    CHECK_EQ(modbus_master_session_cycle(&session, &out), 0);
+    CHECK_EQ(session.connects, 2);
+    CHECK_EQ(session.point_errors[0], 2);
+
+    printf("tcp: %u transactions, %u timeouts, %u connects, window %u\n", session.transactions, session.timeouts, session.connects,
+           sim_outstanding_max);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int rtu_master;
+static int64_t rtu_gap_min = INT64_MAX;
+static uint32_t rtu_gaps = 0;
+static uint32_t rtu_frames = 0;
+
+static void rtu_send(uint8_t *frame, uint32_t len, bool bad_crc) {
+    uint16_t crc = modbus_poll_crc16(frame, len);
+
+    frame[len++] = crc & 0xff;
+    frame[len++] = (crc >> 8) ^ (bad_crc ? 0x5a : 0);
+    CHECK_EQ(write(rtu_master, frame, len), len);
+}
+
+static void *rtu_slave(void *arg) {
+    uint8_t req[8], rsp[32];
+    int64_t answered = 0; // end of the last answer written
+
+    while (!sim_stop) {
+        uint32_t done = 0;
+
+        while (done < sizeof(req) && !sim_stop) {
+            struct pollfd pfd = { .fd = rtu_master, .events = POLLIN };
+            if (poll(&pfd, 1, 20) <= 0)
+                continue;
+            int n = read(rtu_master, req + done, sizeof(req) - done);
+            if (n > 0) {
+                if (done == 0 && answered != 0) {
+                    int64_t gap = esp_timer_get_time() - answered;
+                    rtu_gap_min = gap < rtu_gap_min ? gap : rtu_gap_min;
+                    rtu_gaps++;
+                }
+                done += n;
+            }
+        }
+        if (done < sizeof(req))
+            break;
+        rtu_frames++;
+        answered = 0;
+        CHECK_EQ(modbus_poll_crc16(req, 6), req[6] | (req[7] << 8));
+
+        uint8_t slave = req[0];
+        uint16_t addr = MODBUS_GET16(&req[2]), count = MODBUS_GET16(&req[4]);
+        switch (slave) {
+            case 0: // broadcast write
+                CHECK_EQ(req[1], MODBUS_FC_WRITE_REGISTER);
+                CHECK_EQ(count, 0x1234);
+                continue;
+            case 2: // silent
+                continue;
+            case 4:
+                rsp[0] = slave;
+                rsp[1] = req[1] | MODBUS_FC_EXCEPTION;
+                rsp[2] = MODBUS_EX_ILLEGAL_ADDRESS;
+                rtu_send(rsp, 3, false);
+                break;
+            default:
+                rsp[0] = slave;
+                rsp[1] = req[1];
+                rsp[2] = count * 2;
+                for (uint16_t k = 0; k < count; k++)
+                    MODBUS_PUT16(&rsp[3 + k * 2], 500 + addr + k);
+                rtu_send(rsp, 3 + count * 2, slave == 3);
+        }
+        tcdrain(rtu_master);
+        answered = esp_timer_get_time();
+    }
+
+    return NULL;
+}
+
+static void test_rtu(void) {
+    modbus_master_session_t session;
+    struct termios tio;
+    pthread_t thread;
+
+    rtu_master = posix_openpt(O_RDWR | O_NOCTTY);
+    CHECK(rtu_master >= 0 && grantpt(rtu_master) == 0 && unlockpt(rtu_master) == 0);
+    int line = open(ptsname(rtu_master), O_RDWR | O_NOCTTY);
+    CHECK(line >= 0);
+    tcgetattr(line, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(line, TCSANOW, &tio);
+    host_uart_attach(RTU_UART, line);
+
+    memset(&config, 0, sizeof(config));
+    strcpy(config.name, "rtu");
+    config.link = MODBUS_MASTER_RTU;
+    config.uart = RTU_UART;
+    config.baud = RTU_BAUD;
+    config.timeout_ms = RTU_TIMEOUT;
+    config.pipeline = 1;
+    config.point[0] = (modbus_master_point_t){ .slave = 1, .function = MODBUS_FC_READ_HOLDING, .addr = 0, .count = 2, .index = 0 };
+    config.point[1] = (modbus_master_point_t){ .slave = 2, .function = MODBUS_FC_READ_HOLDING, .addr = 0, .count = 1, .index = 2 };
+    config.point[2] = (modbus_master_point_t){ .slave = 3, .function = MODBUS_FC_READ_HOLDING, .addr = 0, .count = 1, .index = 3 };
+    config.point[3] = (modbus_master_point_t){ .slave = 4, .function = MODBUS_FC_READ_HOLDING, .addr = 0, .count = 1, .index = 4 };
+    config.point[4] = (modbus_master_point_t){ .slave = 1, .function = MODBUS_FC_READ_HOLDING, .addr = 10, .count = 1, .index = 5 };
+    config.point[5] = (modbus_master_point_t){ .slave = 0, .function = MODBUS_FC_WRITE_REGISTER, .addr = 5, .count = 1, .index = 0 };
+    config.points = 6;
+    modbus_poll_build(&poll_table, config.point, config.points);
+    CHECK_EQ(poll_table.requests, 6);
+
+    memset(words, 0, sizeof(words));
+    modbus_master_session_init(&session, &config, &poll_table, bits, words);
+    CHECK_EQ(session.t35_us, 4010);
+    sim_stop = false;
+    pthread_create(&thread, NULL, rtu_slave, NULL);
+
+    for (uint32_t cycle = 0; cycle < 3; cycle++) {
+        // slave 1 twice and the exception of slave 4; the broadcast isn't answered
+        CHECK_EQ(modbus_master_session_cycle(&session, &out), 3);
+    }
+    CHECK_EQ(rtu_frames, 18);
+    CHECK_EQ(session.transactions, 9);
+    CHECK_EQ(session.timeouts, 3);
+    CHECK_EQ(session.exceptions, 3);
+    CHECK_EQ(session.point_errors[0], 0);
+    CHECK_EQ(session.point_errors[1], 3);
+    CHECK_EQ(session.point_errors[2], 3);
+    CHECK_EQ(session.point_exception[3], MODBUS_EX_ILLEGAL_ADDRESS);
+    CHECK(session.point_ok_ms[5] != 0);
+    CHECK(session.point_ok_ms[2] == 0);
+    CHECK_EQ(words[0], 500);
+    CHECK_EQ(words[1], 501);
+    CHECK_EQ(words[5], 510);
+    CHECK_EQ(words[3], 0);
+
+    // after an answer the next request waits 3.5 characters of silence
+    CHECK(rtu_gaps > 0);
+    CHECK(rtu_gap_min >= session.t35_us);
+    printf("rtu: %u frames, %u timeouts, %u exceptions, gap after an answer >= %lld us (t3.5 %u us)\n", rtu_frames, session.timeouts,
+           session.exceptions, (long long)rtu_gap_min, session.t35_us);
+
+    sim_stop = true;
+    pthread_join(thread, NULL);
+    host_uart_attach(RTU_UART, -1);
+    close(line);
+    close(rtu_master);
+}
+
+int main(void) {
+    test_tcp();
+    test_rtu();
+
+    return TEST_RESULT();
+}
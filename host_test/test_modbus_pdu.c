@@ -0,0 +1,273 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Modbus server PDUs over an address map of fake registers: bit and register packing, 16/32 bit values, requests
+// spanning entries, all or nothing writes, exceptions and the cost of the largest requests
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "modbus.h"
+#include "modbus_pdu.h"
+
+// register kinds of the fake map, in place of the ladder types
+enum {
+    REG_Q,  // bits, writable
+    REG_M,  // bits, writable
+    REG_I,  // bits, read only
+    REG_IW, // words, read only
+    REG_D,  // words, writable, sign extended
+    REG_C,  // words, writable
+    REG_T,  // timer accumulators, writable
+};
+
+typedef struct fake_timer_s {
+    uint32_t preset; //
+    uint32_t acc;    //
+} fake_timer_t;
+
+static uint8_t Q[8], M[2048], I[8];
+static int32_t IW[4], D[8];
+static uint32_t C[128];
+static fake_timer_t T[4];
+static bool offline = false; // the M region is not available
+
+static modbus_server_config_t config;
+static uint8_t resp[MODBUS_PDU_MAX];
+
+static bool region(const modbus_map_t *map, modbus_region_t *region) {
+    memset(region, 0, sizeof(modbus_region_t));
+    region->stride = sizeof(uint32_t);
+
+    switch (map->type) {
+        case REG_Q:
+            region->base = Q;
+            region->bits = region->writable = true;
+            break;
+        case REG_M:
+            if (offline)
+                return false;
+            region->base = M;
+            region->bits = region->writable = true;
+            break;
+        case REG_I:
+            region->base = I;
+            region->bits = true;
+            break;
+        case REG_IW:
+            region->base = (uint8_t *)IW;
+            region->sign = true;
+            break;
+        case REG_D:
+            region->base = (uint8_t *)D;
+            region->writable = region->sign = true;
+            break;
+        case REG_C:
+            region->base = (uint8_t *)C;
+            region->writable = true;
+            break;
+        case REG_T:
+            region->base = (uint8_t *)&T[0].acc;
+            region->stride = sizeof(fake_timer_t);
+            region->writable = true;
+            break;
+    }
+    if (region->bits)
+        region->stride = sizeof(uint8_t);
+
+    region->base += map->index * region->stride;
+    return true;
+}
+
+static void map_add(modbus_table_t table, uint16_t addr, uint8_t type, uint16_t index, uint16_t qty, uint8_t words) {
+    modbus_map_t *map = &config.map[table][config.maps[table]++];
+
+    map->addr = addr;
+    map->type = type;
+    map->index = index;
+    map->qty = qty;
+    map->words = words;
+}
+
+// request from bytes, response in resp, its length returned
+static uint16_t serve(const uint8_t *req, uint16_t len) {
+    memset(resp, 0xaa, sizeof(resp));
+    return modbus_pdu_serve(&config, region, req, len, resp);
+}
+
+#define SERVE(...)                                    \
+    ({                                                \
+        const uint8_t _req[] = { __VA_ARGS__ };       \
+        serve(_req, sizeof(_req));                    \
+    })
+
+static void check_exception(uint16_t len, uint8_t function, modbus_exception_t ex) {
+    CHECK_EQ(len, 2);
+    CHECK_EQ(resp[0], function | MODBUS_FC_EXCEPTION);
+    CHECK_EQ(resp[1], ex);
+}
+
+int main(void) {
+    uint16_t len;
+
+    // coils 0-7 Q, 8-2055 M (adjacent), later 2056-2063 I, discrete 0-7 I, input 0-7 IW 32 bit, holding 0-7 D 16 bit, 100-355 C 32 bit,
+    // 1000-1007 T 32 bit
+    map_add(MODBUS_TABLE_COILS, 0, REG_Q, 0, 8, 1);
+    map_add(MODBUS_TABLE_COILS, 8, REG_M, 0, 2048, 1);
+    map_add(MODBUS_TABLE_DISCRETE, 0, REG_I, 0, 8, 1);
+    map_add(MODBUS_TABLE_INPUT, 0, REG_IW, 0, 4, 2);
+    map_add(MODBUS_TABLE_HOLDING, 0, REG_D, 0, 8, 1);
+    map_add(MODBUS_TABLE_HOLDING, 100, REG_C, 0, 128, 2);
+    map_add(MODBUS_TABLE_HOLDING, 1000, REG_T, 0, 4, 2);
+    CHECK_EQ(modbus_pdu_map_span(MODBUS_TABLE_HOLDING, &config.map[MODBUS_TABLE_HOLDING][1]), 256);
+    CHECK_EQ(modbus_pdu_map_span(MODBUS_TABLE_COILS, &config.map[MODBUS_TABLE_COILS][1]), 2048);
+
+    // FC 1: LSB first, across two entries, the last byte zero padded
+    Q[0] = Q[2] = Q[3] = Q[7] = 1;
+    M[1] = 1;
+    len = SERVE(MODBUS_FC_READ_COILS, 0, 0, 0, 11);
+    CHECK_EQ(len, 4);
+    CHECK_EQ(resp[0], MODBUS_FC_READ_COILS);
+    CHECK_EQ(resp[1], 2);
+    CHECK_EQ(resp[2], 0x8d);
+    CHECK_EQ(resp[3], 0x02);
+
+    // FC 2, past the entry
+    I[1] = I[6] = 1;
+    len = SERVE(MODBUS_FC_READ_DISCRETE, 0, 0, 0, 8);
+    CHECK_EQ(len, 3);
+    CHECK_EQ(resp[2], 0x42);
+    check_exception(SERVE(MODBUS_FC_READ_DISCRETE, 0, 0, 0, 9), MODBUS_FC_READ_DISCRETE, MODBUS_EX_ILLEGAL_ADDRESS);
+
+    // FC 3: 16 bit values are the low word, 32 bit ones high word first, a read may start on the low word
+    D[0] = -2;
+    D[1] = 0x12345;
+    C[0] = 0x12345678;
+    C[1] = 0x9abcdef0;
+    len = SERVE(MODBUS_FC_READ_HOLDING, 0, 0, 0, 2);
+    CHECK_EQ(len, 6);
+    CHECK_EQ(resp[1], 4);
+    CHECK_EQ(MODBUS_GET16(&resp[2]), 0xfffe);
+    CHECK_EQ(MODBUS_GET16(&resp[4]), 0x2345);
+    len = SERVE(MODBUS_FC_READ_HOLDING, 0, 101, 0, 3);
+    CHECK_EQ(len, 8);
+    CHECK_EQ(MODBUS_GET16(&resp[2]), 0x5678);
+    CHECK_EQ(MODBUS_GET16(&resp[4]), 0x9abc);
+    CHECK_EQ(MODBUS_GET16(&resp[6]), 0xdef0);
+
+    // timers: the accumulator, over the timer stride
+    T[1].preset = 0xffffffff;
+    T[1].acc = 70000;
+    len = SERVE(MODBUS_FC_READ_HOLDING, 0x03, 0xea, 0, 2);
+    CHECK_EQ(len, 6);
+    CHECK_EQ(((uint32_t)MODBUS_GET16(&resp[2]) << 16) | MODBUS_GET16(&resp[4]), 70000);
+
+    // FC 4, gaps are illegal addresses
+    IW[0] = -1;
+    len = SERVE(MODBUS_FC_READ_INPUT, 0, 0, 0, 2);
+    CHECK_EQ(len, 6);
+    CHECK_EQ(MODBUS_GET16(&resp[2]), 0xffff);
+    CHECK_EQ(MODBUS_GET16(&resp[4]), 0xffff);
+    check_exception(SERVE(MODBUS_FC_READ_HOLDING, 0, 7, 0, 2), MODBUS_FC_READ_HOLDING, MODBUS_EX_ILLEGAL_ADDRESS);
+    check_exception(SERVE(MODBUS_FC_READ_INPUT, 0, 8, 0, 1), MODBUS_FC_READ_INPUT, MODBUS_EX_ILLEGAL_ADDRESS);
+
+    // FC 5: only 0xff00 and 0x0000, the request is echoed
+    len = SERVE(MODBUS_FC_WRITE_COIL, 0, 1, 0xff, 0x00);
+    CHECK_EQ(len, 5);
+    CHECK_EQ(Q[1], 1);
+    CHECK_EQ(MODBUS_GET16(&resp[1]), 1);
+    CHECK_EQ(MODBUS_GET16(&resp[3]), 0xff00);
+    SERVE(MODBUS_FC_WRITE_COIL, 0, 1, 0x00, 0x00);
+    CHECK_EQ(Q[1], 0);
+    check_exception(SERVE(MODBUS_FC_WRITE_COIL, 0, 1, 0x12, 0x34), MODBUS_FC_WRITE_COIL, MODBUS_EX_ILLEGAL_VALUE);
+    check_exception(SERVE(MODBUS_FC_WRITE_COIL, 0x10, 0, 0xff, 0x00), MODBUS_FC_WRITE_COIL, MODBUS_EX_ILLEGAL_ADDRESS);
+
+    // FC 6: 16 bit values are sign extended for signed registers, one word of a 32 bit value keeps the other
+    SERVE(MODBUS_FC_WRITE_REGISTER, 0, 2, 0xff, 0xff);
+    CHECK_EQ(D[2], -1);
+    SERVE(MODBUS_FC_WRITE_REGISTER, 0, 101, 0x00, 0x01);
+    CHECK_EQ(C[0], 0x12340001);
+    SERVE(MODBUS_FC_WRITE_REGISTER, 0, 100, 0xab, 0xcd);
+    CHECK_EQ(C[0], 0xabcd0001);
+
+    // FC 15: LSB first, across two entries
+    len = SERVE(MODBUS_FC_WRITE_COILS, 0, 6, 0, 4, 1, 0x0a);
+    CHECK_EQ(len, 5);
+    CHECK_EQ(Q[6], 0);
+    CHECK_EQ(Q[7], 1);
+    CHECK_EQ(M[0], 0);
+    CHECK_EQ(M[1], 1);
+    CHECK_EQ(MODBUS_GET16(&resp[3]), 4);
+
+    // FC 16: all or nothing, read only entries refused
+    len = SERVE(MODBUS_FC_WRITE_REGISTERS, 0, 100, 0, 4, 8, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x04);
+    CHECK_EQ(len, 5);
+    CHECK_EQ(C[0], 0x00010002);
+    CHECK_EQ(C[1], 0x00030004);
+    check_exception(SERVE(MODBUS_FC_WRITE_REGISTERS, 0, 6, 0, 3, 6, 0, 1, 0, 2, 0, 3), MODBUS_FC_WRITE_REGISTERS, MODBUS_EX_ILLEGAL_ADDRESS);
+    CHECK_EQ(D[6], 0);
+    map_add(MODBUS_TABLE_COILS, 2056, REG_I, 0, 8, 1);
+    check_exception(SERVE(MODBUS_FC_WRITE_COILS, 0x08, 0x06, 0, 4, 1, 0x0f), MODBUS_FC_WRITE_COILS, MODBUS_EX_ILLEGAL_ADDRESS);
+    CHECK_EQ(M[2046], 0);
+    check_exception(SERVE(MODBUS_FC_WRITE_COIL, 0x08, 0x08, 0xff, 0x00), MODBUS_FC_WRITE_COIL, MODBUS_EX_ILLEGAL_ADDRESS);
+    CHECK_EQ(I[0], 0);
+
+    // malformed requests
+    check_exception(SERVE(0x07, 0, 0, 0, 1), 0x07, MODBUS_EX_ILLEGAL_FUNCTION);
+    check_exception(SERVE(MODBUS_FC_READ_COILS, 0, 0), MODBUS_FC_READ_COILS, MODBUS_EX_ILLEGAL_VALUE);
+    check_exception(SERVE(MODBUS_FC_READ_COILS, 0, 0, 0, 0), MODBUS_FC_READ_COILS, MODBUS_EX_ILLEGAL_VALUE);
+    check_exception(SERVE(MODBUS_FC_READ_COILS, 0, 0, 0x07, 0xd1), MODBUS_FC_READ_COILS, MODBUS_EX_ILLEGAL_VALUE);
+    check_exception(SERVE(MODBUS_FC_READ_HOLDING, 0, 100, 0, 126), MODBUS_FC_READ_HOLDING, MODBUS_EX_ILLEGAL_VALUE);
+    check_exception(SERVE(MODBUS_FC_WRITE_REGISTERS, 0, 0, 0, 2, 3, 0, 1, 0), MODBUS_FC_WRITE_REGISTERS, MODBUS_EX_ILLEGAL_VALUE);
+    check_exception(SERVE(MODBUS_FC_WRITE_REGISTERS, 0, 0, 0, 2, 4, 0, 1), MODBUS_FC_WRITE_REGISTERS, MODBUS_EX_ILLEGAL_VALUE);
+
+    // registers not available right now
+    offline = true;
+    check_exception(SERVE(MODBUS_FC_READ_COILS, 0, 0, 0, 9), MODBUS_FC_READ_COILS, MODBUS_EX_ILLEGAL_ADDRESS);
+    offline = false;
+
+    // largest requests
+    const uint8_t regs[] = { MODBUS_FC_READ_HOLDING, 0, 100, 0, MODBUS_READ_REGS_MAX };
+    const uint8_t bits[] = { MODBUS_FC_READ_COILS, 0, 8, 0x07, 0xd0 };
+    int64_t start = test_now_us();
+    for (int n = 0; n < 100000; n++)
+        len = modbus_pdu_serve(&config, region, regs, sizeof(regs), resp);
+    int64_t regs_us = test_now_us() - start;
+    CHECK_EQ(len, 2 + 2 * MODBUS_READ_REGS_MAX);
+    start = test_now_us();
+    for (int n = 0; n < 100000; n++)
+        len = modbus_pdu_serve(&config, region, bits, sizeof(bits), resp);
+    int64_t bits_us = test_now_us() - start;
+    CHECK_EQ(len, 2 + MODBUS_READ_BITS_MAX / 8);
+    printf("%d registers read: %.2f us, %d coils read: %.2f us\n", MODBUS_READ_REGS_MAX, regs_us / 100000.0, MODBUS_READ_BITS_MAX, bits_us / 100000.0);
+
+    return TEST_RESULT();
+}
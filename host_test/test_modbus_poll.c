@@ -0,0 +1,167 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Modbus master poll table: merging entries into requests, request PDUs from the output image, responses into the
+// input image, and the RTU CRC
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "modbus.h"
+#include "modbus_poll.h"
+
+// entry kinds, in place of the ladder types
+enum {
+    REG_I,  //
+    REG_IW, //
+    REG_Q,  //
+    REG_QW, //
+};
+
+// configured out of order: point numbers must survive the merge
+static const modbus_master_point_t points[] = {
+    { .slave = 2, .function = MODBUS_FC_READ_HOLDING, .addr = 10, .count = 2, .type = REG_IW, .index = 0 },          // 0
+    { .slave = 1, .function = MODBUS_FC_READ_DISCRETE, .addr = 8, .count = 8, .type = REG_I, .index = 8 },           // 1
+    { .slave = 1, .function = MODBUS_FC_READ_DISCRETE, .addr = 0, .count = 8, .type = REG_I, .index = 0 },           // 2
+    { .slave = 1, .function = MODBUS_FC_WRITE_COILS, .addr = 0, .count = 4, .type = REG_Q, .index = 0 },             // 3
+    { .slave = 1, .function = MODBUS_FC_WRITE_COIL, .addr = 4, .count = 1, .type = REG_Q, .index = 4 },              // 4
+    { .slave = 2, .function = MODBUS_FC_READ_HOLDING, .addr = 12, .count = 3, .type = REG_IW, .index = 2, .sign = 1 }, // 5
+    { .slave = 2, .function = MODBUS_FC_READ_HOLDING, .addr = 20, .count = 1, .type = REG_IW, .index = 5 },          // 6
+    { .slave = 1, .function = MODBUS_FC_WRITE_REGISTER, .addr = 100, .count = 1, .type = REG_QW, .index = 0 },       // 7
+    { .slave = 1, .function = MODBUS_FC_READ_DISCRETE, .addr = 16, .count = 1990, .type = REG_I, .index = 16 },      // 8
+};
+
+#define POINTS (sizeof(points) / sizeof(points[0]))
+
+static modbus_poll_t poll;
+static uint8_t bits[2048], q[8];
+static int32_t words[8], qw[8];
+static uint8_t pdu[MODBUS_PDU_MAX];
+
+static void check_request(uint32_t r, uint8_t slave, uint8_t function, uint16_t addr, uint16_t count, uint16_t entries) {
+    const modbus_poll_request_t *request = &poll.request[r];
+
+    CHECK_EQ(request->slave, slave);
+    CHECK_EQ(request->function, function);
+    CHECK_EQ(request->addr, addr);
+    CHECK_EQ(request->count, count);
+    CHECK_EQ(request->points, entries);
+}
+
+static void check_pdu(uint16_t len, const uint8_t *expected, uint16_t expected_len) {
+    CHECK_EQ(len, expected_len);
+    CHECK(memcmp(pdu, expected, expected_len) == 0);
+}
+
+int main(void) {
+    const ladder_io_image_t out = { .bits = q, .words = qw };
+
+    // merged per slave and function class over adjacent addresses, within the function limit
+    modbus_poll_build(&poll, points, POINTS);
+    CHECK_EQ(poll.requests, 6);
+    check_request(0, 1, MODBUS_FC_READ_DISCRETE, 0, 16, 2);
+    check_request(1, 1, MODBUS_FC_READ_DISCRETE, 16, 1990, 1);
+    check_request(2, 1, MODBUS_FC_WRITE_COILS, 0, 5, 2);
+    check_request(3, 1, MODBUS_FC_WRITE_REGISTER, 100, 1, 1);
+    check_request(4, 2, MODBUS_FC_READ_HOLDING, 10, 5, 2);
+    check_request(5, 2, MODBUS_FC_READ_HOLDING, 20, 1, 1);
+
+    // the configured order is kept, each entry knows its request
+    const uint16_t point_request[POINTS] = { 4, 0, 0, 2, 2, 4, 5, 3, 1 };
+    for (uint32_t n = 0; n < POINTS; n++) {
+        CHECK_EQ(poll.point_request[n], point_request[n]);
+        CHECK(poll.point == points);
+    }
+    CHECK_EQ(modbus_poll_entry(&poll, &poll.request[0], 0), 2);
+    CHECK_EQ(modbus_poll_entry(&poll, &poll.request[0], 1), 1);
+    CHECK_EQ(modbus_poll_entry(&poll, &poll.request[2], 1), 4);
+
+    // request PDUs
+    check_pdu(modbus_poll_request_pdu(&poll, &poll.request[0], &out, pdu), (const uint8_t[]) { 0x02, 0x00, 0x00, 0x00, 0x10 }, 5);
+    check_pdu(modbus_poll_request_pdu(&poll, &poll.request[4], &out, pdu), (const uint8_t[]) { 0x03, 0x00, 0x0a, 0x00, 0x05 }, 5);
+    q[0] = q[2] = q[3] = q[4] = 1;
+    check_pdu(modbus_poll_request_pdu(&poll, &poll.request[2], &out, pdu), (const uint8_t[]) { 0x0f, 0x00, 0x00, 0x00, 0x05, 0x01, 0x1d }, 7);
+    qw[0] = -2;
+    check_pdu(modbus_poll_request_pdu(&poll, &poll.request[3], &out, pdu), (const uint8_t[]) { 0x06, 0x00, 0x64, 0xff, 0xfe }, 5);
+
+    // a lone FC 5 entry
+    const modbus_master_point_t coil = { .slave = 1, .function = MODBUS_FC_WRITE_COIL, .addr = 7, .count = 1, .type = REG_Q, .index = 3 };
+    modbus_poll_t single;
+    modbus_poll_build(&single, &coil, 1);
+    check_pdu(modbus_poll_request_pdu(&single, &single.request[0], &out, pdu), (const uint8_t[]) { 0x05, 0x00, 0x07, 0xff, 0x00 }, 5);
+
+    // responses: bits LSB first to each entry's index, words signed per entry
+    CHECK_EQ(modbus_poll_response_len(&poll.request[0]), 4);
+    CHECK_EQ(modbus_poll_response_len(&poll.request[4]), 12);
+    CHECK_EQ(modbus_poll_response_len(&poll.request[2]), 5);
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[0], (const uint8_t[]) { 0x02, 0x02, 0xa5, 0x3c }, 4, bits, words), MODBUS_POLL_DATA);
+    const uint8_t expected_bits[16] = { 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0 };
+    CHECK(memcmp(bits, expected_bits, sizeof(expected_bits)) == 0);
+
+    const uint8_t regs[] = { 0x03, 0x0a, 0xff, 0xff, 0x00, 0x01, 0xff, 0xfe, 0x80, 0x00, 0x12, 0x34 };
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[4], regs, sizeof(regs), bits, words), MODBUS_POLL_DATA);
+    CHECK_EQ(words[0], 65535);
+    CHECK_EQ(words[1], 1);
+    CHECK_EQ(words[2], -2);
+    CHECK_EQ(words[3], -32768);
+    CHECK_EQ(words[4], 0x1234);
+
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[2], (const uint8_t[]) { 0x0f, 0x00, 0x00, 0x00, 0x05 }, 5, bits, words), MODBUS_POLL_DATA);
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[4], (const uint8_t[]) { 0x83, 0x02 }, 2, bits, words), MODBUS_POLL_EXCEPTION);
+
+    // not a response to the request: nothing stored
+    memset(words, 0, sizeof(words));
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[4], (const uint8_t[]) { 0x04, 0x0a }, 2, bits, words), MODBUS_POLL_INVALID);
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[4], regs, sizeof(regs) - 1, bits, words), MODBUS_POLL_INVALID);
+    const uint8_t short_count[] = { 0x03, 0x08, 0, 1, 0, 2, 0, 3, 0, 4, 0, 5 };
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[4], short_count, sizeof(short_count), bits, words), MODBUS_POLL_INVALID);
+    CHECK_EQ(modbus_poll_response(&poll, &poll.request[4], (const uint8_t[]) { 0x83 }, 1, bits, words), MODBUS_POLL_INVALID);
+    CHECK_EQ(words[0], 0);
+
+    // RTU CRC, low byte first on the line
+    CHECK_EQ(modbus_poll_crc16((const uint8_t[]) { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0a }, 6), 0xcdc5);
+
+    // a full table of adjacent registers merges into one request per limit
+    modbus_master_point_t table[MODBUS_MASTER_POINTS_MAX];
+    for (uint32_t n = 0; n < MODBUS_MASTER_POINTS_MAX; n++)
+        table[n] = (modbus_master_point_t) { .slave = 1, .function = MODBUS_FC_READ_INPUT, .addr = (MODBUS_MASTER_POINTS_MAX - 1 - n) * 10, .count = 10,
+                                             .type = REG_IW };
+    int64_t start = test_now_us();
+    for (int n = 0; n < 10000; n++)
+        modbus_poll_build(&poll, table, MODBUS_MASTER_POINTS_MAX);
+    int64_t build_us = test_now_us() - start;
+    CHECK_EQ(poll.requests, (MODBUS_MASTER_POINTS_MAX * 10 + MODBUS_READ_REGS_MAX - 1) / (MODBUS_READ_REGS_MAX / 10 * 10));
+    CHECK_EQ(poll.request[0].addr, 0);
+    CHECK_EQ(poll.request[0].count, MODBUS_READ_REGS_MAX / 10 * 10);
+    printf("%d entries in %u requests, built in %.2f us\n", MODBUS_MASTER_POINTS_MAX, poll.requests, build_us / 10000.0);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// MQTT publisher reporting: deadband per format, coalescing of the changes within a window, periodic publishing, the
+// payload, and the messages per second for a value changing every scan
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "mqtt_publisher_group.h"
+
+#define SCAN_MS   10  // scan period simulated
+#define WINDOW_MS 100 // MQTT_PUBLISHER_WINDOW_MS
+
+static mqtt_publisher_state_t state;
+static uint32_t coalesced;
+
+static int32_t real(float f) {
+    int32_t v;
+
+    memcpy(&v, &f, sizeof(v));
+    return v;
+}
+
+// queue the first message, it is the reference for the changes
+static void reference(const int32_t *value) {
+    CHECK(mqtt_publisher_changed(&state, value));
+    state.have_last = true;
+    memcpy(state.last, value, state.values * sizeof(int32_t));
+}
+
+static void check_payload(const int32_t *value, const char *expected) {
+    char payload[128];
+
+    CHECK_EQ(mqtt_publisher_payload(&state, 1234, value, payload, sizeof(payload)), strlen(expected));
+    CHECK(strcmp(payload, expected) == 0);
+}
+
+int main(void) {
+    // word deadband, measured from the last queued value so slow drifts are reported
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    CHECK(mqtt_publisher_state_add(&state, MQTT_PUBLISHER_SIGNED, 10, 1));
+    CHECK(mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 1));
+    reference((const int32_t[]) { 100, 0 });
+    CHECK(!mqtt_publisher_changed(&state, (const int32_t[]) { 100, 0 }));
+    CHECK(!mqtt_publisher_changed(&state, (const int32_t[]) { 109, 0 }));
+    CHECK(!mqtt_publisher_changed(&state, (const int32_t[]) { 91, 0 }));
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { 110, 0 }));
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { 90, 0 }));
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { 100, 1 }));
+    reference((const int32_t[]) { INT32_MIN, 0 });
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { INT32_MAX, 0 }));
+
+    // real deadband, NaN appearing or leaving is a change
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    CHECK(mqtt_publisher_state_add(&state, MQTT_PUBLISHER_REAL, 0.5f, 1));
+    reference((const int32_t[]) { real(20.0f) });
+    CHECK(!mqtt_publisher_changed(&state, (const int32_t[]) { real(20.4f) }));
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { real(19.5f) }));
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { real(NAN) }));
+    reference((const int32_t[]) { real(NAN) });
+    CHECK(mqtt_publisher_changed(&state, (const int32_t[]) { real(20.0f) }));
+
+    // more values than a message holds
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    CHECK(mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, MQTT_PUBLISHER_VALUES_MAX - 1));
+    CHECK(!mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 2));
+    CHECK(mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 1));
+    CHECK_EQ(state.values, MQTT_PUBLISHER_VALUES_MAX);
+
+    // a counter changing every scan for 10 s: one message per window, the other changes coalesced
+    int32_t value[1] = { 0 };
+    uint32_t messages = 0, last_message = 0, max_gap = 0;
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 1);
+    coalesced = 0;
+    for (uint32_t now = 1; now <= 10000; now += SCAN_MS) {
+        value[0]++;
+        if (!mqtt_publisher_due(&state, value, now, &coalesced))
+            continue;
+        CHECK_EQ(state.last[0], value[0]);
+        if (messages > 0 && now - last_message > max_gap)
+            max_gap = now - last_message;
+        last_message = now;
+        messages++;
+    }
+    CHECK_EQ(messages, 10000 / (WINDOW_MS + SCAN_MS));
+    CHECK_EQ(max_gap, WINDOW_MS + SCAN_MS);
+    CHECK_EQ(messages + coalesced + state.pending, 10000 / SCAN_MS);
+    printf("%u changes: %u messages, %u coalesced\n", 10000 / SCAN_MS, messages, coalesced);
+
+    // the window opens at the first change and the last value is sent
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_SIGNED, 5, 1);
+    coalesced = 0;
+    value[0] = 0;
+    CHECK(!mqtt_publisher_due(&state, value, 0, &coalesced));
+    CHECK(mqtt_publisher_due(&state, value, WINDOW_MS, &coalesced));
+    CHECK(!mqtt_publisher_due(&state, value, 5000, &coalesced));
+    coalesced = 0;
+    value[0] = 4;
+    CHECK(!mqtt_publisher_due(&state, value, 6000, &coalesced));
+    CHECK(!state.pending);
+    value[0] = 5;
+    CHECK(!mqtt_publisher_due(&state, value, 7000, &coalesced));
+    value[0] = 30;
+    CHECK(!mqtt_publisher_due(&state, value, 7000 + WINDOW_MS - 1, &coalesced));
+    CHECK(mqtt_publisher_due(&state, value, 7000 + WINDOW_MS, &coalesced));
+    CHECK_EQ(state.last[0], 30);
+    CHECK_EQ(coalesced, 2); // every scan the pending values differ
+
+    // across the 32 bit ms wrap
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 1);
+    CHECK(!mqtt_publisher_due(&state, value, UINT32_MAX - 10, &coalesced));
+    CHECK(!mqtt_publisher_due(&state, value, WINDOW_MS - 12, &coalesced));
+    CHECK(mqtt_publisher_due(&state, value, WINDOW_MS - 11, &coalesced));
+
+    // periodic only: at once, then every period whatever changes
+    mqtt_publisher_state_init(&state, false, 1000, WINDOW_MS);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 1);
+    messages = 0;
+    for (uint32_t now = 0; now < 10000; now += SCAN_MS) {
+        value[0] = now;
+        messages += mqtt_publisher_due(&state, value, now, &coalesced);
+    }
+    CHECK_EQ(messages, 10);
+    CHECK(!state.pending);
+
+    // payload: unsigned, signed, reals, non finite as null
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_UNSIGNED, 0, 2);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_SIGNED, 0, 1);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_REAL, 0, 2);
+    const int32_t payload_value[] = { 1, -1, -1, real(2.5f), real(INFINITY) };
+    check_payload(payload_value, "{\"t\":1234,\"v\":[1,4294967295,-1,2.5,null]}");
+
+    char small[16];
+    CHECK_EQ(mqtt_publisher_payload(&state, 1234, payload_value, small, sizeof(small)), 0);
+
+    // scan cost of a full group without changes
+    int32_t full[MQTT_PUBLISHER_VALUES_MAX] = { 0 };
+    mqtt_publisher_state_init(&state, true, 0, WINDOW_MS);
+    mqtt_publisher_state_add(&state, MQTT_PUBLISHER_SIGNED, 10, MQTT_PUBLISHER_VALUES_MAX);
+    mqtt_publisher_due(&state, full, 0, &coalesced);
+    mqtt_publisher_due(&state, full, WINDOW_MS, &coalesced);
+    int64_t start = test_now_us();
+    for (uint32_t n = 0; n < 100000; n++) {
+        full[n % MQTT_PUBLISHER_VALUES_MAX] = n & 7;
+        CHECK(!mqtt_publisher_due(&state, full, WINDOW_MS + n, &coalesced));
+    }
+    printf("%d values compared in %.3f us\n", MQTT_PUBLISHER_VALUES_MAX, (test_now_us() - start) / 100000.0);
+
+    return TEST_RESULT();
+}
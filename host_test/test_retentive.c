@@ -0,0 +1,198 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/ESP32-PLC *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Retentive records and flash write pacing: record checks, writes per day and bytes per day for a value changing every
+// scan, backoff on a failing flash and the per scan mirror cost
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_rom_crc.h"
+#include "host_test.h"
+#include "ladder_retentive_record.h"
+
+#define SCAN_MS  10                      // scan period simulated
+#define RETAINED 2048                    // LADDER_RETENTIVE_SIZE_MAX, the worst case
+#define SIM_SIZE 64                      // values mirrored by the pacing simulation, records are counted at RETAINED
+#define HOUR_MS  (3600 * 1000)           //
+#define RECORD   (sizeof(ladder_retentive_record_t) + RETAINED)
+
+typedef struct sim_s {
+    uint64_t now;     // ms
+    uint64_t done;    // ms, queued write completes
+    uint64_t last;    // ms, last write queued
+    uint64_t min_gap; // ms, shortest time between two writes
+    uint32_t writes;  // writes queued
+    uint32_t failed;  // writes failed
+    uint64_t bytes;   // bytes written
+} sim_t;
+
+static uint32_t values[RETAINED / sizeof(uint32_t)];
+static uint32_t mirror[RETAINED / sizeof(uint32_t)];
+static ladder_retentive_record_t header;
+
+// scans for ms, the storage service taking latency ms per write
+static void simulate(ladder_retentive_pace_t *pace, sim_t *sim, uint64_t ms, uint32_t latency, bool change, bool fail) {
+    for (uint64_t end = sim->now + ms; sim->now < end; sim->now += SCAN_MS) {
+        if (pace->busy && sim->now >= sim->done) {
+            if (fail)
+                sim->failed++;
+            else
+                sim->bytes += RECORD;
+            ladder_retentive_pace_written(pace, !fail);
+        }
+
+        if (change)
+            values[0]++;
+        if (ladder_retentive_mirror((uint8_t *)mirror, values, SIM_SIZE)) {
+            ladder_retentive_record_seal(&header, mirror, 0, 1, SIM_SIZE);
+            pace->dirty = true;
+        }
+
+        if (!ladder_retentive_pace_due(pace, sim->now))
+            continue;
+
+        if (sim->writes > 0 && sim->now - sim->last < sim->min_gap)
+            sim->min_gap = sim->now - sim->last;
+        ladder_retentive_pace_queued(pace, sim->now);
+        sim->last = sim->now;
+        sim->done = sim->now + latency;
+        sim->writes++;
+    }
+}
+
+static void sim_init(ladder_retentive_pace_t *pace, sim_t *sim) {
+    memset(pace, 0, sizeof(ladder_retentive_pace_t));
+    memset(sim, 0, sizeof(sim_t));
+    sim->min_gap = UINT64_MAX;
+    memcpy(mirror, values, RETAINED);
+}
+
+int main(void) {
+    ladder_retentive_pace_t pace;
+    sim_t sim;
+    uint8_t data[64];
+
+    // the ROM CRC: check value and chaining
+    CHECK_EQ(esp_rom_crc32_le(0, (const uint8_t *)"123456789", 9), 0xcbf43926);
+    CHECK_EQ(esp_rom_crc32_le(esp_rom_crc32_le(0, (const uint8_t *)"1234", 4), (const uint8_t *)"56789", 5), 0xcbf43926);
+
+    // records
+    for (uint32_t n = 0; n < sizeof(data); n++)
+        data[n] = n * 7;
+    ladder_retentive_record_seal(&header, data, 5, 0x1234, sizeof(data));
+    CHECK(ladder_retentive_record_valid(&header, data, 0x1234, sizeof(data)));
+    CHECK(!ladder_retentive_record_valid(&header, data, 0x1235, sizeof(data)));
+    CHECK(!ladder_retentive_record_valid(&header, data, 0x1234, sizeof(data) - 4));
+    data[17] ^= 0x10;
+    CHECK(!ladder_retentive_record_valid(&header, data, 0x1234, sizeof(data)));
+    data[17] ^= 0x10;
+    header.seq++;
+    CHECK(!ladder_retentive_record_valid(&header, data, 0x1234, sizeof(data)));
+    header.seq--;
+    header.magic = 0;
+    CHECK(!ladder_retentive_record_valid(&header, data, 0x1234, sizeof(data)));
+
+    // nothing changes: nothing is written
+    sim_init(&pace, &sim);
+    simulate(&pace, &sim, HOUR_MS, 30, false, false);
+    CHECK_EQ(sim.writes, 0);
+
+    // a counter changing every scan is written once per LADDER_RETENTIVE_FLUSH_MS, the first one an interval after start
+    sim_init(&pace, &sim);
+    simulate(&pace, &sim, HOUR_MS, 30, true, false);
+    CHECK_EQ(sim.writes, HOUR_MS / LADDER_RETENTIVE_FLUSH_MS - 1);
+    CHECK_EQ(sim.min_gap, LADDER_RETENTIVE_FLUSH_MS);
+    printf("value changing every %d ms scan: %u writes/day, %.1f MB/day of %zu byte records\n", SCAN_MS, sim.writes * 24,
+           sim.bytes * 24 / 1e6, RECORD);
+
+    // a forced write does not wait for the interval, the next one does
+    simulate(&pace, &sim, 1000, 30, true, false);
+    uint32_t writes = sim.writes;
+    pace.force = true;
+    simulate(&pace, &sim, SCAN_MS, 30, false, false);
+    CHECK_EQ(sim.writes, writes + 1);
+    simulate(&pace, &sim, LADDER_RETENTIVE_FLUSH_MS - SCAN_MS, 30, true, false);
+    CHECK_EQ(sim.writes, writes + 1);
+    simulate(&pace, &sim, SCAN_MS, 30, true, false);
+    CHECK_EQ(sim.writes, writes + 2);
+
+    // a storage service slower than the interval: one write at a time
+    sim_init(&pace, &sim);
+    simulate(&pace, &sim, HOUR_MS, 25000, true, false);
+    CHECK(sim.min_gap >= 25000);
+    CHECK(sim.writes <= HOUR_MS / 25000 + 1);
+
+    // a failing flash: retried with a doubling interval, never on every scan
+    sim_init(&pace, &sim);
+    simulate(&pace, &sim, HOUR_MS, 30, true, true);
+    uint64_t longest = (uint64_t)LADDER_RETENTIVE_FLUSH_MS << LADDER_RETENTIVE_BACKOFF;
+    uint64_t backoff = 0;
+    uint32_t expected = 0;
+    for (uint32_t n = 0; backoff + (LADDER_RETENTIVE_FLUSH_MS << (n < LADDER_RETENTIVE_BACKOFF ? n : LADDER_RETENTIVE_BACKOFF)) <= HOUR_MS; n++) {
+        backoff += LADDER_RETENTIVE_FLUSH_MS << (n < LADDER_RETENTIVE_BACKOFF ? n : LADDER_RETENTIVE_BACKOFF);
+        expected++;
+    }
+    CHECK_EQ(sim.writes, expected);
+    CHECK_EQ(sim.failed, sim.writes);
+    CHECK_EQ(sim.min_gap, 2 * LADDER_RETENTIVE_FLUSH_MS);
+    CHECK_EQ(pace.failing, sim.writes);
+    printf("failing flash: %u attempts/hour, up to %llu s apart\n", sim.writes, (unsigned long long)(longest / 1000));
+
+    // the flash recovers: written within the longest backoff, then at the normal rate again
+    writes = sim.writes;
+    uint64_t since = sim.now;
+    while (sim.writes == writes && sim.now - since <= longest)
+        simulate(&pace, &sim, SCAN_MS, 30, true, false);
+    CHECK_EQ(sim.writes, writes + 1);
+    simulate(&pace, &sim, 10 * LADDER_RETENTIVE_FLUSH_MS, 30, true, false);
+    CHECK_EQ(pace.failing, 0);
+    CHECK_EQ(sim.writes, writes + 11);
+
+    // scan hook cost on the largest mirror: unchanged values, then a change and its record seal
+    memcpy(mirror, values, RETAINED);
+    int64_t start = test_now_us();
+    uint32_t changed = 0;
+    for (int n = 0; n < 100000; n++)
+        changed += ladder_retentive_mirror((uint8_t *)mirror, values, RETAINED);
+    int64_t same = test_now_us() - start;
+    CHECK_EQ(changed, 0);
+    start = test_now_us();
+    for (int n = 0; n < 100000; n++) {
+        values[n % (RETAINED / sizeof(uint32_t))]++;
+        if (ladder_retentive_mirror((uint8_t *)mirror, values, RETAINED))
+            ladder_retentive_record_seal(&header, mirror, n, 1, RETAINED);
+    }
+    int64_t change = test_now_us() - start;
+    printf("%d byte mirror per scan: %.3f us unchanged, %.3f us changed and sealed\n", RETAINED, same / 100000.0, change / 100000.0);
+    CHECK(ladder_retentive_record_valid(&header, mirror, 1, RETAINED));
+
+    return TEST_RESULT();
+}
@@ -37,9 +37,23 @@
 
 #include "cmd_ladderlib.h"
 #include "cmd_system.h"
+#include "ftpserver.h"
 #include "ladder.h"
+#include "ladder_adc.h"
+#include "ladder_aout.h"
+#include "ladder_boot.h"
+#include "ladder_cron.h"
+#include "ladder_datalogger.h"
+#include "ladder_hsc.h"
+#include "ladder_program_deploy.h"
+#include "ladder_program_store.h"
+#include "ladder_retentive.h"
+#include "ladder_warm.h"
 #include "ladderlib_esp32_gpio.h"
 #include "ladderlib_esp32_std.h"
+#include "modbus_master.h"
+#include "modbus_server.h"
+#include "mqtt_publisher.h"
 #include "webeditor.h"
 #include "wifi-provisioning.h"
 
@@ -55,19 +69,142 @@
 
 ladder_ctx_t ladder_ctx;
 TaskHandle_t laddertsk_handle;
+static modbus_server_config_t modbus_config;
 
 //////////////////////////////////////////////////////////
 
+// I/O configuration kept for a warm resume, applied as the files would
+static void io_config_apply(uint8_t kind, uint32_t index, const void *config, uint32_t len, void *arg) {
+    switch (kind) {
+        case LADDER_WARM_CONFIG_HSC:
+            if (len == sizeof(ladder_hsc_config_t))
+                ladder_hsc_add(config);
+            break;
+        case LADDER_WARM_CONFIG_ADC:
+            if (len == sizeof(ladder_adc_config_t))
+                ladder_adc_start(config);
+            break;
+        case LADDER_WARM_CONFIG_AOUT:
+            if (len == sizeof(ladder_aout_config_t))
+                ladder_aout_set(index, config);
+            break;
+        case LADDER_WARM_CONFIG_MODBUS_MASTER:
+            if (len == sizeof(modbus_master_config_t))
+                modbus_master_add((ladder_ctx_t *)arg, config);
+            break;
+    }
+}
+
 void app_main(void) {
-    nvs_flash_init();
+    ladder_boot_config_t boot_config = { 0 };
+    ladder_warm_stats_t warm;
+    int phase;
+
+    // initialize context
+    phase = ladder_boot_begin("ladder init");
+    if (!ladder_ctx_init(&ladder_ctx, 6, 7, 3, QTY_M, QTY_C, QTY_T, QTY_D, QTY_R, false)) {
+        printf("ERROR Initializing\n");
+    }
+
+    // assign port functions
+    if (!ladder_add_read_fn(&ladder_ctx, esp32_local_read, esp32_local_init_read)) {
+        printf("ERROR Adding io read function\n");
+        return;
+    }
+
+    if (!ladder_add_write_fn(&ladder_ctx, esp32_local_write, esp32_local_init_write)) {
+        printf("ERROR Adding io write function\n");
+        return;
+    }
+    // slow or remote I/O goes through ladder_io_module_add(): polled by its own task, never inside the scan
+
+    ladder_ctx.on.scan_end = esp32_on_scan_end;
+    ladder_ctx.on.instruction = esp32_on_instruction;
+    ladder_ctx.on.task_before = esp32_on_task_before;
+    ladder_ctx.on.task_after = esp32_on_task_after;
+    ladder_ctx.on.panic = esp32_on_panic;
+    ladder_ctx.on.end_task = esp32_on_end_task;
+    ladder_ctx.hw.time.millis = esp32_millis;
+    ladder_ctx.hw.time.delay = esp32_delay;
+    ladder_ctx.ladder.state = LADDER_ST_STOPPED;
+
+    if (!esp32_scan_sync_init()) {
+        printf("ERROR Initializing scan sync queue\n");
+        return;
+    }
+    ladder_boot_end(phase);
+
+    // warm start: a program running before a panic, watchdog or brownout reset resumes from no-init memory before
+    // the file system, Wi-Fi, console and httpd are brought up. The I/O layout it ran with (counters, analog I/O,
+    // remote modules) is rebuilt from no-init memory too, the files are only read in a cold start
+    phase = ladder_boot_begin("warm resume");
+    bool io_ready = ladder_warm_pending() && ladder_warm_config_replay(io_config_apply, &ladder_ctx);
+    if (io_ready && ladder_warm_resume(&ladder_ctx)) {
+        ladder_ctx.ladder.state = LADDER_ST_RUNNING;
+        if (xTaskCreatePinnedToCore(ladder_task, "ladder", 30000, (void *)&ladder_ctx, 10, &laddertsk_handle, 1) != pdPASS) {
+            printf("ERROR Starting warm ladder task\n");
+            ladder_ctx.ladder.state = LADDER_ST_STOPPED;
+        }
+    }
+    ladder_boot_end(phase);
+
+    phase = ladder_boot_begin("fs");
     fs_init();
+    ladder_boot_end(phase);
 
-    wifi_provision_care("HiperionPLC");
+    if (!io_ready) {
+        ladder_warm_config_clear();
+
+        // analog inputs listed in adc.json are sampled in background from boot, the scan only copies the last filtered values
+        phase = ladder_boot_begin("analog");
+        ladder_adc_config_t adc_config;
+        ladder_adc_default(&adc_config);
+        ladder_adc_load(LADDER_ADC_CONFIG, &adc_config);
+        ladder_adc_start(&adc_config);
+        // QW mapped to LEDC or the DAC take their ports over from Q when the ladder starts
+        ladder_aout_load(LADDER_AOUT_CONFIG);
+        ladder_boot_end(phase);
+
+        // high-speed counters extend the local module IW, sized when the ladder starts. Pins of the analog I/O are refused
+        phase = ladder_boot_begin("counters");
+        ladder_hsc_load(LADDER_HSC_CONFIG);
+        ladder_boot_end(phase);
+
+        // remote I/O modules change the program I/O layout, so they are added before any scan
+        phase = ladder_boot_begin("remote io");
+        modbus_master_load(&ladder_ctx, MODBUS_MASTER_CONFIG);
+        ladder_boot_end(phase);
+    }
+
+    phase = ladder_boot_begin("nvs");
+    nvs_flash_init();
+    ladder_boot_end(phase);
+
+    // retained M/C/T/D/R ranges: from RTC memory after a reset, else from flash. Before the boot program starts
+    phase = ladder_boot_begin("retentive");
+    if (ladder_retentive_load(&ladder_ctx, LADDER_RETENTIVE_CONFIG))
+        ladder_retentive_restore(&ladder_ctx);
+    ladder_boot_end(phase);
+
+    // program versions and the rollback image, used by the boot program and the deploy
+    phase = ladder_boot_begin("program store");
+    if (!ladder_program_store_init())
+        printf("ERROR Initializing program store\n");
+    ladder_boot_end(phase);
+
+    // boot program: the active stored version (boot.json program if none), loaded, checked and started by its own task
+    // while the rest comes up. Loaded but not started after a warm resume boot loop, the outputs stay off
+    ladder_boot_load(LADDER_BOOT_CONFIG, &boot_config);
+    ladder_warm_stats(&warm);
+    if (warm.boot_loop)
+        boot_config.autostart = false;
+    ladder_boot_start(&ladder_ctx, &boot_config);
 
     // ESP_LOGI(TAG, "Publish mDNS hostname %s.local.", TAG);
     // ESP_ERROR_CHECK(mdns_init());
     // ESP_ERROR_CHECK(mdns_hostname_set(TAG));
 
+    phase = ladder_boot_begin("console");
     esp_console_repl_t *repl = NULL;
     esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
 
@@ -90,38 +227,63 @@ void app_main(void) {
     register_ladder_stop();
     register_ftpserver();
     register_port_test();
+    register_datalogger();
+    register_program_store();
+    register_retentive();
+    register_boot_times();
+    register_io_modules();
+    register_modbus();
+    register_mqtt();
+    register_hsc();
+    register_adc();
+    register_aout();
 
     esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &repl));
     ESP_ERROR_CHECK(esp_console_start_repl(repl));
+    ladder_boot_end(phase);
 
     printf("--[ ladderlib version: %d.%d.%d ]--\n\n", LADDERLIB_VERSION_MAYOR, LADDERLIB_VERSION_MINOR, LADDERLIB_VERSION_PATCH);
 
-    // initialize context
-    if (!ladder_ctx_init(&ladder_ctx, 6, 7, 3, QTY_M, QTY_C, QTY_T, QTY_D, QTY_R, false)) {
-        printf("ERROR Initializing\n");
-    }
+    phase = ladder_boot_begin("services");
+    // programs uploaded by FTP to LADDER_DEPLOY_DIR are checked and applied
+    if (ladder_program_deploy_init(&ladder_ctx))
+        ftpserver_set_upload_cb(ladder_program_deploy_file);
+    else
+        printf("ERROR Initializing program deploy\n");
 
-    // assign port functions
-    if (!ladder_add_read_fn(&ladder_ctx, esp32_local_read, esp32_local_init_read)) {
-        printf("ERROR Adding io read function\n");
-        return;
-    }
+    // time of day M/D writes, applied at the scan boundary
+    if (ladder_cron_init(&ladder_ctx, 0))
+        ladder_cron_load(LADDER_CRON_CONFIG);
+    else
+        printf("ERROR Initializing cron\n");
 
-    if (!ladder_add_write_fn(&ladder_ctx, esp32_local_write, esp32_local_init_write)) {
-        printf("ERROR Adding io write function\n");
-        return;
-    }
+    // sampled at the end of each scan, logging starts only if there is a configuration
+    if (ladder_datalogger_init())
+        ladder_datalogger_load(&ladder_ctx, LADDER_DATALOGGER_CONFIG);
+    else
+        printf("ERROR Initializing data logger\n");
+    ladder_boot_end(phase);
 
-    ladder_ctx.on.scan_end = esp32_on_scan_end;
-    ladder_ctx.on.instruction = esp32_on_instruction;
-    ladder_ctx.on.task_before = esp32_on_task_before;
-    ladder_ctx.on.task_after = esp32_on_task_after;
-    ladder_ctx.on.panic = esp32_on_panic;
-    ladder_ctx.on.end_task = esp32_on_end_task;
-    ladder_ctx.hw.time.millis = esp32_millis;
-    ladder_ctx.hw.time.delay = esp32_delay;
-    ladder_ctx.ladder.state = LADDER_ST_STOPPED;
+    // waits for an address (or never returns while provisioning), so it goes last
+    phase = ladder_boot_begin("wifi");
+    wifi_provision_care("HiperionPLC");
+    ladder_boot_end(phase);
 
+    phase = ladder_boot_begin("httpd");
     start_websocket_server();
+    ladder_boot_end(phase);
+
+    // default map over the configured quantities, replaced by the file if present
+    phase = ladder_boot_begin("modbus");
+    modbus_server_default(&ladder_ctx, &modbus_config);
+    modbus_server_load(MODBUS_SERVER_CONFIG, &modbus_config);
+    if (!modbus_server_start(&ladder_ctx, &modbus_config))
+        printf("ERROR Starting modbus server\n");
+    ladder_boot_end(phase);
+
+    // telemetry, only if there is a configuration
+    phase = ladder_boot_begin("mqtt");
+    mqtt_publisher_load(&ladder_ctx, MQTT_PUBLISHER_CONFIG);
+    ladder_boot_end(phase);
 }